@@ -0,0 +1,92 @@
+/* Copyright (C) 2022, Nikolai Wuttke. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <audio/adlib_emulator.hpp>
+#include <base/warnings.hpp>
+
+RIGEL_DISABLE_WARNINGS
+#include <benchmark/benchmark.h>
+RIGEL_RESTORE_WARNINGS
+
+#include <cstdint>
+#include <vector>
+
+
+namespace
+{
+
+constexpr auto OUTPUT_SAMPLE_RATE = 44100;
+constexpr auto SAMPLES_PER_ITERATION = std::size_t{2048};
+
+
+void playChord(rigel::audio::AdlibEmulator& emulator)
+{
+  // A simple instrument on the first three channels, each playing a note
+  for (auto channel = 0; channel < 3; ++channel)
+  {
+    const auto op = std::uint8_t(channel);
+    emulator.writeRegister(0x20 + op, 0x01);
+    emulator.writeRegister(0x23 + op, 0x01);
+    emulator.writeRegister(0x40 + op, 0x10);
+    emulator.writeRegister(0x43 + op, 0x00);
+    emulator.writeRegister(0x60 + op, 0xF0);
+    emulator.writeRegister(0x63 + op, 0xF0);
+    emulator.writeRegister(0x80 + op, 0x77);
+    emulator.writeRegister(0x83 + op, 0x77);
+    emulator.writeRegister(0xA0 + op, std::uint8_t(0x98 + channel * 0x20));
+    emulator.writeRegister(0xB0 + op, 0x31);
+  }
+}
+
+
+void renderSamples(
+  benchmark::State& state,
+  const rigel::audio::AdlibEmulator::Type type)
+{
+  rigel::audio::AdlibEmulator emulator{OUTPUT_SAMPLE_RATE, type};
+  playChord(emulator);
+
+  std::vector<std::int16_t> buffer(SAMPLES_PER_ITERATION);
+
+  for (auto _ : state)
+  {
+    emulator.render(SAMPLES_PER_ITERATION, buffer.data());
+    benchmark::DoNotOptimize(buffer.data());
+    benchmark::ClobberMemory();
+  }
+
+  state.SetItemsProcessed(
+    static_cast<std::int64_t>(state.iterations() * SAMPLES_PER_ITERATION));
+}
+
+} // namespace
+
+
+static void BMRenderDbOpl(benchmark::State& state)
+{
+  renderSamples(state, rigel::audio::AdlibEmulator::Type::DBOPL);
+}
+
+BENCHMARK(BMRenderDbOpl);
+
+
+static void BMRenderNukedOpl3(benchmark::State& state)
+{
+  renderSamples(state, rigel::audio::AdlibEmulator::Type::NukedOpl3);
+}
+
+BENCHMARK(BMRenderNukedOpl3);
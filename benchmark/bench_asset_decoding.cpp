@@ -0,0 +1,368 @@
+/* Copyright (C) 2022, Nikolai Wuttke. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <assets/ega_image_decoder.hpp>
+#include <assets/file_utils.hpp>
+#include <assets/movie_loader.hpp>
+#include <assets/rle_compression.hpp>
+#include <assets/voc_decoder.hpp>
+#include <base/warnings.hpp>
+
+RIGEL_DISABLE_WARNINGS
+#include <benchmark/benchmark.h>
+RIGEL_RESTORE_WARNINGS
+
+#include <cstdint>
+#include <random>
+#include <string_view>
+
+
+/* Decoder throughput benchmarks
+ *
+ * All inputs are generated from a fixed seed, so no game data is needed.
+ * Throughput is reported in bytes of encoded input processed per second.
+ */
+
+using namespace rigel;
+using namespace assets;
+
+
+namespace
+{
+
+constexpr auto MOVIE_WIDTH = 320;
+constexpr auto MOVIE_HEIGHT = 200;
+constexpr auto NUM_MOVIE_FRAMES = 24;
+
+constexpr auto NUM_VOC_SAMPLES = 64 * 1024;
+
+
+ByteBuffer makeRandomBytes(const std::size_t count)
+{
+  auto rng = std::mt19937{1234};
+  auto distribution = std::uniform_int_distribution<int>{0, 255};
+
+  auto result = ByteBuffer(count);
+  for (auto& byte : result)
+  {
+    byte = std::uint8_t(distribution(rng));
+  }
+
+  return result;
+}
+
+
+data::Palette16 makePalette()
+{
+  data::Palette16 palette;
+  for (auto i = 0; i < 16; ++i)
+  {
+    palette[i] = data::Pixel{
+      std::uint8_t(i * 16), std::uint8_t(255 - i), std::uint8_t(i), 255};
+  }
+
+  return palette;
+}
+
+
+/** Alternates between runs of repeated bytes and literal copies */
+void writeRleWords(
+  LeStreamWriter& writer,
+  const int numWords,
+  std::mt19937& rng)
+{
+  auto distribution = std::uniform_int_distribution<int>{1, 127};
+
+  for (auto i = 0; i < numWords; ++i)
+  {
+    const auto count = distribution(rng);
+    if (i % 2 == 0)
+    {
+      writer.writeU8(std::uint8_t(count));
+      writer.writeU8(std::uint8_t(count));
+    }
+    else
+    {
+      writer.writeU8(std::uint8_t(-count));
+      for (auto j = 0; j < count; ++j)
+      {
+        writer.writeU8(std::uint8_t(distribution(rng)));
+      }
+    }
+  }
+}
+
+
+ByteBuffer makeVocFile(const std::uint8_t codec)
+{
+  constexpr auto SIGNATURE = std::string_view{"Creative Voice File"};
+  constexpr auto VERSION = std::uint16_t{0x010A};
+
+  LeStreamWriter writer;
+  for (const auto c : SIGNATURE)
+  {
+    writer.writeU8(std::uint8_t(c));
+  }
+  writer.writeU8(0x1A);
+  writer.writeU16(0x1A);
+  writer.writeU16(VERSION);
+  writer.writeU16(std::uint16_t(~VERSION + 0x1234));
+
+  // A single typed sound data chunk, followed by a terminator
+  const auto audioData = makeRandomBytes(NUM_VOC_SAMPLES);
+  const auto chunkSize = std::uint32_t(audioData.size() + 2);
+  writer.writeU8(1);
+  writer.writeU16(std::uint16_t(chunkSize & 0xFFFF));
+  writer.writeU8(std::uint8_t(chunkSize >> 16));
+  writer.writeU8(0x83); // 8 kHz
+  writer.writeU8(codec);
+  writer.writeBytes(audioData);
+  writer.writeU8(0);
+
+  return writer.buffer();
+}
+
+
+void writeChunkHeader(LeStreamWriter& writer, const std::uint16_t numSubChunks)
+{
+  writer.writeU32(0);
+  writer.writeU16(0xF1FA);
+  writer.writeU16(numSubChunks);
+  writer.writeBytes(ByteBuffer(8, 0));
+}
+
+
+ByteBuffer makeMovieFile()
+{
+  auto rng = std::mt19937{1234};
+
+  LeStreamWriter writer;
+  writer.writeU32(0); // file size, filled in below
+  writer.writeU16(0xAF11);
+  writer.writeU16(NUM_MOVIE_FRAMES);
+  writer.writeU16(MOVIE_WIDTH);
+  writer.writeU16(MOVIE_HEIGHT);
+  writer.writeBytes(ByteBuffer(4 + 4 + 108, 0));
+
+  writeChunkHeader(writer, 2);
+
+  writer.writeU32(778);
+  writer.writeU16(0xB);
+  writer.writeU32(1);
+  for (auto i = 0; i < 768; ++i)
+  {
+    writer.writeU8(std::uint8_t(i % 64));
+  }
+
+  // Main image: Each row consists of literal copies adding up to the width
+  writer.writeU32(0);
+  writer.writeU16(0xF);
+  for (auto row = 0; row < MOVIE_HEIGHT; ++row)
+  {
+    writer.writeU8(5);
+    for (auto word = 0; word < 5; ++word)
+    {
+      writer.writeU8(std::uint8_t(-(MOVIE_WIDTH / 5)));
+      writer.writeBytes(makeRandomBytes(MOVIE_WIDTH / 5));
+    }
+  }
+
+  // Animation frames: Each one replaces two spans in a band of rows
+  constexpr auto ROWS_PER_FRAME = 40;
+  for (auto frame = 0; frame < NUM_MOVIE_FRAMES; ++frame)
+  {
+    writeChunkHeader(writer, 1);
+    writer.writeU32(0);
+    writer.writeU16(0xC);
+
+    writer.writeU16(
+      std::uint16_t((frame * 8) % (MOVIE_HEIGHT - ROWS_PER_FRAME)));
+    writer.writeU16(ROWS_PER_FRAME);
+    for (auto row = 0; row < ROWS_PER_FRAME; ++row)
+    {
+      // The RLE markers are inverted in animation frames
+      writer.writeU8(2);
+      writer.writeU8(20);
+      writer.writeU8(60);
+      writer.writeBytes(makeRandomBytes(60));
+      writer.writeU8(40);
+      writer.writeU8(std::uint8_t(-50));
+      writer.writeU8(std::uint8_t(rng() & 0xFF));
+    }
+  }
+
+  auto result = writer.buffer();
+  const auto size = std::uint32_t(result.size());
+  for (auto i = 0; i < 4; ++i)
+  {
+    result[i] = std::uint8_t(size >> (i * 8));
+  }
+
+  return result;
+}
+
+
+void setThroughput(benchmark::State& state, const std::size_t inputSize)
+{
+  state.SetBytesProcessed(
+    static_cast<std::int64_t>(state.iterations() * inputSize));
+}
+
+} // namespace
+
+
+static void BMDecodeTiledEgaData(benchmark::State& state)
+{
+  const auto type = state.range(0) != 0 ? data::TileImageType::Masked
+                                        : data::TileImageType::Unmasked;
+  constexpr auto WIDTH_IN_TILES = 40;
+  const auto input = makeRandomBytes(
+    WIDTH_IN_TILES * 50 * data::GameTraits::bytesPerTile(type));
+  const auto palette = makePalette();
+
+  for (auto _ : state)
+  {
+    auto image = loadTiledImage(input, WIDTH_IN_TILES, palette, type);
+    benchmark::DoNotOptimize(image);
+  }
+
+  setThroughput(state, input.size());
+}
+
+BENCHMARK(BMDecodeTiledEgaData)->Arg(0)->Arg(1);
+
+
+static void BMDecodeSimplePlanarEgaBuffer(benchmark::State& state)
+{
+  // Same size as a full-screen image
+  const auto input = makeRandomBytes(320 * 200 / 2);
+  const auto palette = makePalette();
+
+  for (auto _ : state)
+  {
+    auto pixels =
+      decodeSimplePlanarEgaBuffer(input.begin(), input.end(), palette);
+    benchmark::DoNotOptimize(pixels);
+  }
+
+  setThroughput(state, input.size());
+}
+
+BENCHMARK(BMDecodeSimplePlanarEgaBuffer);
+
+
+static void BMDecodeVoc(benchmark::State& state)
+{
+  // The argument is the codec type: 0 is 8-bit PCM, 1 to 3 are the three
+  // ADPCM variants.
+  const auto input = makeVocFile(std::uint8_t(state.range(0)));
+
+  for (auto _ : state)
+  {
+    auto buffer = decodeVoc(input);
+    benchmark::DoNotOptimize(buffer);
+  }
+
+  setThroughput(state, input.size());
+}
+
+BENCHMARK(BMDecodeVoc)->Arg(0)->Arg(1)->Arg(2)->Arg(3);
+
+
+static void BMLoadMovie(benchmark::State& state)
+{
+  const auto input = makeMovieFile();
+
+  for (auto _ : state)
+  {
+    auto movie = loadMovie(input);
+    benchmark::DoNotOptimize(movie);
+  }
+
+  setThroughput(state, input.size());
+}
+
+BENCHMARK(BMLoadMovie);
+
+
+static void BMDecompressRle(benchmark::State& state)
+{
+  constexpr auto NUM_RLE_WORDS = 4096;
+
+  auto rng = std::mt19937{1234};
+  LeStreamWriter writer;
+  writeRleWords(writer, NUM_RLE_WORDS, rng);
+  const auto& input = writer.buffer();
+
+  auto output = ByteBuffer{};
+
+  for (auto _ : state)
+  {
+    output.clear();
+
+    LeStreamReader reader(input);
+    decompressRle(reader, NUM_RLE_WORDS, [&output](const std::uint8_t byte) {
+      output.push_back(byte);
+    });
+    benchmark::DoNotOptimize(output.data());
+  }
+
+  setThroughput(state, input.size());
+}
+
+BENCHMARK(BMDecompressRle);
+
+
+static void BMLeStreamReaderReadU16(benchmark::State& state)
+{
+  const auto input = makeRandomBytes(64 * 1024);
+
+  for (auto _ : state)
+  {
+    LeStreamReader reader(input);
+    auto sum = 0u;
+    while (reader.hasData())
+    {
+      sum += reader.readU16();
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+
+  setThroughput(state, input.size());
+}
+
+BENCHMARK(BMLeStreamReaderReadU16);
+
+
+static void BMLeStreamReaderReadU32(benchmark::State& state)
+{
+  const auto input = makeRandomBytes(64 * 1024);
+
+  for (auto _ : state)
+  {
+    LeStreamReader reader(input);
+    auto sum = 0u;
+    while (reader.hasData())
+    {
+      sum += reader.readU32();
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+
+  setThroughput(state, input.size());
+}
+
+BENCHMARK(BMLeStreamReaderReadU32);
@@ -0,0 +1,151 @@
+/* Copyright (C) 2022, Nikolai Wuttke. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <audio/adlib_emulator.hpp>
+#include <audio/resampling.hpp>
+#include <audio/software_imf_player.hpp>
+#include <base/warnings.hpp>
+#include <data/song.hpp>
+
+RIGEL_DISABLE_WARNINGS
+#include <benchmark/benchmark.h>
+RIGEL_RESTORE_WARNINGS
+
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+
+namespace
+{
+
+constexpr auto OUTPUT_SAMPLE_RATE = 44100;
+constexpr auto SAMPLES_PER_ITERATION = std::size_t{2048};
+
+
+/** A short looping tune, playing a new note every few ticks
+ *
+ * Keeps a few channels busy at any time, like real game music does.
+ */
+rigel::data::Song makeSong()
+{
+  auto song = rigel::data::Song{};
+
+  auto write = [&song](
+                 const int reg, const int value, const std::uint16_t delay) {
+    song.push_back(
+      rigel::data::ImfCommand{std::uint8_t(reg), std::uint8_t(value), delay});
+  };
+
+  for (auto channel = 0; channel < 6; ++channel)
+  {
+    const auto op = channel % 3 + (channel / 3) * 8;
+    write(0x20 + op, 0x01, 0);
+    write(0x23 + op, 0x01, 0);
+    write(0x40 + op, 0x10, 0);
+    write(0x43 + op, 0x00, 0);
+    write(0x60 + op, 0xF0, 0);
+    write(0x63 + op, 0xF0, 0);
+    write(0x80 + op, 0x77, 0);
+    write(0x83 + op, 0x77, 0);
+  }
+
+  for (auto note = 0; note < 64; ++note)
+  {
+    const auto channel = note % 6;
+    write(0xB0 + channel, 0x11, 0);
+    write(0xA0 + channel, 0x58 + (note * 37) % 0x60, 0);
+    write(0xB0 + channel, 0x31, 20);
+  }
+
+  return song;
+}
+
+
+void renderImfSong(
+  benchmark::State& state,
+  const rigel::audio::AdlibEmulator::Type type)
+{
+  rigel::audio::SoftwareImfPlayer player{OUTPUT_SAMPLE_RATE};
+  player.setType(type);
+  player.playSong(makeSong());
+
+  std::vector<std::int16_t> buffer(SAMPLES_PER_ITERATION);
+
+  for (auto _ : state)
+  {
+    player.render(buffer.data(), SAMPLES_PER_ITERATION);
+    benchmark::DoNotOptimize(buffer.data());
+    benchmark::ClobberMemory();
+  }
+
+  state.SetItemsProcessed(
+    static_cast<std::int64_t>(state.iterations() * SAMPLES_PER_ITERATION));
+}
+
+
+rigel::base::AudioBuffer makeSineWave(const int sampleRate)
+{
+  // One second of a 440 Hz tone
+  auto buffer = rigel::base::AudioBuffer{sampleRate, {}};
+  buffer.mSamples.reserve(sampleRate);
+  for (auto i = 0; i < sampleRate; ++i)
+  {
+    const auto phase = 2.0 * 3.14159265358979 * 440.0 * i / sampleRate;
+    buffer.mSamples.push_back(rigel::base::Sample(std::sin(phase) * 16000.0));
+  }
+
+  return buffer;
+}
+
+} // namespace
+
+
+static void BMSoftwareImfPlayerDbOpl(benchmark::State& state)
+{
+  renderImfSong(state, rigel::audio::AdlibEmulator::Type::DBOPL);
+}
+
+BENCHMARK(BMSoftwareImfPlayerDbOpl);
+
+
+static void BMSoftwareImfPlayerNukedOpl3(benchmark::State& state)
+{
+  renderImfSong(state, rigel::audio::AdlibEmulator::Type::NukedOpl3);
+}
+
+BENCHMARK(BMSoftwareImfPlayerNukedOpl3);
+
+
+/** Arguments: Input rate, output rate, and resampling profile */
+static void BMResampleAudio(benchmark::State& state)
+{
+  const auto input = makeSineWave(int(state.range(0)));
+  const auto outputRate = int(state.range(1));
+  const auto profile = rigel::audio::ResamplingProfile(state.range(2));
+
+  for (auto _ : state)
+  {
+    auto output = rigel::audio::resampleAudio(input, outputRate, profile);
+    benchmark::DoNotOptimize(output.mSamples.data());
+  }
+
+  state.SetItemsProcessed(
+    static_cast<std::int64_t>(state.iterations() * input.mSamples.size()));
+}
+
+BENCHMARK(BMResampleAudio)
+  ->ArgsProduct({{6000, 11025, 22050}, {44100, 48000}, {0, 1, 2}});
@@ -0,0 +1,414 @@
+/* Copyright (C) 2022, Nikolai Wuttke. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <base/image.hpp>
+#include <base/warnings.hpp>
+#include <data/game_traits.hpp>
+#include <data/map.hpp>
+#include <engine/collision_checker.hpp>
+#include <engine/entity_activation_system.hpp>
+#include <engine/movement.hpp>
+#include <engine/physical_components.hpp>
+#include <engine/physics_system.hpp>
+#include <engine/spatial_index.hpp>
+#include <engine/sprite_rendering_system.hpp>
+#include <engine/visual_components.hpp>
+#include <game_logic/damage_components.hpp>
+#include <game_logic/damage_infliction_system.hpp>
+#include <renderer/renderer.hpp>
+#include <renderer/texture_atlas.hpp>
+
+RIGEL_DISABLE_WARNINGS
+#include <benchmark/benchmark.h>
+#include <entityx/entityx.h>
+RIGEL_RESTORE_WARNINGS
+
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+
+namespace ex = entityx;
+
+using namespace rigel;
+using namespace engine::components;
+
+
+namespace
+{
+
+constexpr auto LEVEL_WIDTH = 256;
+constexpr auto LEVEL_HEIGHT = 128;
+constexpr auto NUM_SPRITE_IMAGES = 32;
+
+
+/** A randomly generated level, populated with a given number of entities
+ *
+ * Doesn't need any game data. The same seed always produces the same level,
+ * so results are comparable between runs.
+ */
+class SyntheticLevel
+{
+public:
+  explicit SyntheticLevel(const int numEntities)
+  {
+    // Tile index i has collision flags i, so that all combinations of solid
+    // edges occur
+    auto attributes = data::map::TileAttributeDict::AttributeArray{};
+    for (auto i = 0; i < 16; ++i)
+    {
+      attributes.push_back(std::uint16_t(i));
+    }
+
+    mMap = data::map::Map{
+      LEVEL_WIDTH, LEVEL_HEIGHT, data::map::TileAttributeDict{attributes}};
+
+    for (auto y = 0; y < LEVEL_HEIGHT; ++y)
+    {
+      for (auto x = 0; x < LEVEL_WIDTH; ++x)
+      {
+        const auto isBorder =
+          x == 0 || y == 0 || x == LEVEL_WIDTH - 1 || y == LEVEL_HEIGHT - 1;
+        if (isBorder)
+        {
+          mMap.setTileAt(0, x, y, data::map::TileIndex(0xF));
+        }
+        else if (randomInt(0, 9) == 0)
+        {
+          mMap.setTileAt(0, x, y, data::map::TileIndex(randomInt(1, 15)));
+        }
+      }
+    }
+
+    for (auto i = 0; i < numEntities; ++i)
+    {
+      auto entity = mEntityx.entities.create();
+      const auto position = randomPosition();
+      entity.assign<WorldPosition>(position);
+      entity.assign<BoundingBox>(
+        BoundingBox{{0, 0}, {randomInt(1, 4), randomInt(1, 4)}});
+      mEntities.push_back(entity);
+      mInitialPositions.push_back(position);
+    }
+  }
+
+  /** Give all entities a MovingBody with random velocity */
+  void addMovingBodies()
+  {
+    for (auto& entity : mEntities)
+    {
+      entity.assign<MovingBody>(MovingBody{
+        {float(randomInt(-2, 2)), float(randomInt(-2, 2))},
+        randomInt(0, 1) == 0});
+      entity.assign<Active>();
+    }
+  }
+
+  void resetPositions()
+  {
+    for (auto i = 0u; i < mEntities.size(); ++i)
+    {
+      *mEntities[i].component<WorldPosition>() = mInitialPositions[i];
+    }
+  }
+
+  int randomInt(const int min, const int max)
+  {
+    return std::uniform_int_distribution<int>{min, max}(mRng);
+  }
+
+  WorldPosition randomPosition()
+  {
+    return {randomInt(1, LEVEL_WIDTH - 6), randomInt(5, LEVEL_HEIGHT - 2)};
+  }
+
+  std::mt19937 mRng{1234};
+  ex::EntityX mEntityx;
+  data::map::Map mMap;
+  std::vector<ex::Entity> mEntities;
+  std::vector<WorldPosition> mInitialPositions;
+};
+
+
+std::vector<BoundingBox> makeQueryBoxes(SyntheticLevel& level)
+{
+  auto boxes = std::vector<BoundingBox>{};
+  for (auto i = 0; i < 1024; ++i)
+  {
+    boxes.push_back(BoundingBox{
+      level.randomPosition(),
+      {level.randomInt(1, 5), level.randomInt(1, 5)}});
+  }
+
+  return boxes;
+}
+
+
+void addSolidBodies(SyntheticLevel& level, const int count)
+{
+  for (auto i = 0; i < count && i < int(level.mEntities.size()); ++i)
+  {
+    level.mEntities[i].assign<SolidBody>();
+  }
+}
+
+} // namespace
+
+
+static void BMCollisionCheckerSpanTests(benchmark::State& state)
+{
+  SyntheticLevel level{int(state.range(0))};
+  addSolidBodies(level, int(state.range(0)));
+  engine::CollisionChecker checker{
+    &level.mMap, level.mEntityx.entities, level.mEntityx.events};
+  const auto boxes = makeQueryBoxes(level);
+
+  for (auto _ : state)
+  {
+    auto count = 0;
+    for (const auto& box : boxes)
+    {
+      count += checker.isOnSolidGround(box);
+      count += checker.isTouchingCeiling(box);
+      count += checker.isTouchingLeftWall(box);
+      count += checker.isTouchingRightWall(box);
+    }
+    benchmark::DoNotOptimize(count);
+  }
+
+  state.SetItemsProcessed(
+    static_cast<std::int64_t>(state.iterations() * boxes.size() * 4));
+}
+
+BENCHMARK(BMCollisionCheckerSpanTests)->Arg(0)->Arg(64);
+
+
+static void BMMove(benchmark::State& state)
+{
+  SyntheticLevel level{0};
+  engine::CollisionChecker checker{
+    &level.mMap, level.mEntityx.entities, level.mEntityx.events};
+  const auto boxes = makeQueryBoxes(level);
+  const auto amount = int(state.range(0));
+
+  for (auto _ : state)
+  {
+    for (const auto& box : boxes)
+    {
+      auto position = WorldPosition{box.topLeft.x, box.bottomRight().y};
+      const auto bbox = BoundingBox{{0, 0}, box.size};
+      engine::moveHorizontally(checker, position, bbox, amount);
+      engine::moveVertically(checker, position, bbox, amount);
+      benchmark::DoNotOptimize(position);
+    }
+  }
+
+  state.SetItemsProcessed(
+    static_cast<std::int64_t>(state.iterations() * boxes.size() * 2));
+}
+
+BENCHMARK(BMMove)->Arg(1)->Arg(8);
+
+
+static void BMPhysicsSystemUpdate(benchmark::State& state)
+{
+  SyntheticLevel level{int(state.range(0))};
+  level.addMovingBodies();
+  engine::CollisionChecker checker{
+    &level.mMap, level.mEntityx.entities, level.mEntityx.events};
+  engine::PhysicsSystem physicsSystem{
+    &checker, &level.mMap, &level.mEntityx.events};
+
+  for (auto _ : state)
+  {
+    state.PauseTiming();
+    level.resetPositions();
+    state.ResumeTiming();
+
+    physicsSystem.update(level.mEntityx.entities);
+  }
+
+  state.SetItemsProcessed(
+    static_cast<std::int64_t>(state.iterations() * state.range(0)));
+}
+
+BENCHMARK(BMPhysicsSystemUpdate)->Arg(256)->Arg(4096);
+
+
+static void BMSpriteRenderingSystemUpdate(benchmark::State& state)
+{
+  SyntheticLevel level{int(state.range(0))};
+
+  renderer::Renderer renderer{data::GameTraits::viewportSize};
+  const auto images = std::vector<data::Image>(NUM_SPRITE_IMAGES, {16, 16});
+  renderer::TextureAtlas atlas{&renderer, images};
+
+  auto drawDatas = std::vector<engine::SpriteDrawData>(NUM_SPRITE_IMAGES);
+  for (auto i = 0; i < NUM_SPRITE_IMAGES; ++i)
+  {
+    drawDatas[i].mFrames.emplace_back(i, base::Vec2{}, base::Size{2, 2});
+    drawDatas[i].mDrawOrder = level.randomInt(0, 4);
+  }
+
+  for (auto& entity : level.mEntities)
+  {
+    const auto& drawData = drawDatas[level.randomInt(0, NUM_SPRITE_IMAGES - 1)];
+    entity.assign<Sprite>(Sprite{&drawData, {0}});
+  }
+
+  // Most entities are off-screen, but a good amount of them are within the
+  // area around the camera
+  const auto cameraPosition = base::Vec2{LEVEL_WIDTH / 4, LEVEL_HEIGHT / 4};
+  const auto viewportSize = base::Size{LEVEL_WIDTH / 2, LEVEL_HEIGHT / 2};
+
+  engine::SpriteRenderingSystem spriteRenderingSystem{&renderer, &atlas};
+
+  for (auto _ : state)
+  {
+    spriteRenderingSystem.update(
+      level.mEntityx.entities, viewportSize, cameraPosition, 1.0f);
+  }
+
+  state.SetItemsProcessed(
+    static_cast<std::int64_t>(state.iterations() * state.range(0)));
+}
+
+BENCHMARK(BMSpriteRenderingSystemUpdate)->Arg(256)->Arg(4096);
+
+
+// Visible area scales with the window's aspect ratio in widescreen mode (see
+// renderer::determineWidescreenViewport), so a super-ultrawide display makes
+// sprite culling considerably less effective. The 2nd argument is the
+// display's width for a height of 9, i.e. 32 means 32:9.
+static void BMSpriteRenderingSystemUpdateWidescreen(benchmark::State& state)
+{
+  SyntheticLevel level{int(state.range(0))};
+  const auto aspectWidth = int(state.range(1));
+
+  renderer::Renderer renderer{data::GameTraits::viewportSize};
+  const auto images = std::vector<data::Image>(NUM_SPRITE_IMAGES, {16, 16});
+  renderer::TextureAtlas atlas{&renderer, images};
+
+  auto drawDatas = std::vector<engine::SpriteDrawData>(NUM_SPRITE_IMAGES);
+  for (auto i = 0; i < NUM_SPRITE_IMAGES; ++i)
+  {
+    drawDatas[i].mFrames.emplace_back(i, base::Vec2{}, base::Size{2, 2});
+    drawDatas[i].mDrawOrder = level.randomInt(0, 4);
+  }
+
+  for (auto& entity : level.mEntities)
+  {
+    const auto& drawData = drawDatas[level.randomInt(0, NUM_SPRITE_IMAGES - 1)];
+    entity.assign<Sprite>(Sprite{&drawData, {0}});
+  }
+
+  // 30 tiles of width per unit of aspect ratio, like the widescreen viewport
+  const auto viewportSize = base::Size{
+    30 * aspectWidth / 9, data::GameTraits::mapViewportSize.height};
+  const auto cameraPosition = base::Vec2{
+    (LEVEL_WIDTH - viewportSize.width) / 2,
+    (LEVEL_HEIGHT - viewportSize.height) / 2};
+
+  engine::SpriteRenderingSystem spriteRenderingSystem{&renderer, &atlas};
+
+  for (auto _ : state)
+  {
+    spriteRenderingSystem.update(
+      level.mEntityx.entities, viewportSize, cameraPosition, 1.0f);
+  }
+
+  const auto stats = spriteRenderingSystem.statistics();
+  state.counters["drawn"] = stats.mDrawnSprites;
+  state.counters["culled"] = stats.mCulledSprites;
+  state.SetLabel((std::to_string(aspectWidth) + ":9").c_str());
+  state.SetItemsProcessed(
+    static_cast<std::int64_t>(state.iterations() * state.range(0)));
+}
+
+BENCHMARK(BMSpriteRenderingSystemUpdateWidescreen)
+  ->ArgsProduct({{4096}, {12, 16, 21, 32}});
+
+
+static void BMMarkActiveEntities(benchmark::State& state)
+{
+  SyntheticLevel level{int(state.range(0))};
+  engine::ActiveEntityView activeEntities;
+
+  auto cameraX = 0;
+
+  for (auto _ : state)
+  {
+    // Scroll through the level, so that the set of active entities changes
+    cameraX = (cameraX + 1) % LEVEL_WIDTH;
+    engine::markActiveEntities(
+      level.mEntityx.entities,
+      {cameraX, LEVEL_HEIGHT / 2},
+      data::GameTraits::mapViewportSize,
+      &activeEntities);
+  }
+
+  state.SetItemsProcessed(
+    static_cast<std::int64_t>(state.iterations() * state.range(0)));
+}
+
+BENCHMARK(BMMarkActiveEntities)->Arg(256)->Arg(4096);
+
+
+static void BMDamageInflictionSystemUpdate(benchmark::State& state)
+{
+  using game_logic::components::CustomDamageApplication;
+  using game_logic::components::DamageInflicting;
+  using game_logic::components::Shootable;
+
+  SyntheticLevel level{int(state.range(0))};
+
+  // Every 4th entity inflicts damage, the others can be shot. Shootables use
+  // custom damage application and inflictors aren't destroyed on contact, so
+  // that the population stays the same from one iteration to the next.
+  for (auto i = 0u; i < level.mEntities.size(); ++i)
+  {
+    auto& entity = level.mEntities[i];
+    if (i % 4 == 0)
+    {
+      entity.assign<DamageInflicting>(1, false);
+    }
+    else
+    {
+      auto shootable = Shootable{1};
+      shootable.mEnableHitFeedback = false;
+      entity.assign<Shootable>(shootable);
+      entity.assign<CustomDamageApplication>();
+      entity.assign<Active>();
+    }
+  }
+
+  engine::SpatialIndex spatialIndex{LEVEL_WIDTH, LEVEL_HEIGHT};
+  spatialIndex.build(level.mEntityx.entities);
+
+  game_logic::DamageInflictionSystem damageInflictionSystem{
+    nullptr, nullptr, &spatialIndex, &level.mEntityx.events};
+
+  for (auto _ : state)
+  {
+    damageInflictionSystem.update(level.mEntityx.entities);
+  }
+
+  state.SetItemsProcessed(
+    static_cast<std::int64_t>(state.iterations() * state.range(0)));
+}
+
+BENCHMARK(BMDamageInflictionSystemUpdate)->Arg(256)->Arg(4096);
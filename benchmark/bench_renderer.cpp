@@ -0,0 +1,406 @@
+/* Copyright (C) 2022, Nikolai Wuttke. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <base/clock.hpp>
+#include <base/defer.hpp>
+#include <base/image.hpp>
+#include <base/warnings.hpp>
+#include <data/game_options.hpp>
+#include <data/game_traits.hpp>
+#include <data/unit_conversions.hpp>
+#include <engine/graphical_effects.hpp>
+#include <engine/tiled_texture.hpp>
+#include <platform.hpp>
+#include <renderer/opengl.hpp>
+#include <renderer/renderer.hpp>
+#include <renderer/texture_atlas.hpp>
+#include <renderer/upscaling.hpp>
+#include <sdl_utils/error.hpp>
+#include <sdl_utils/ptr.hpp>
+
+RIGEL_DISABLE_WARNINGS
+#include <SDL.h>
+#include <benchmark/benchmark.h>
+RIGEL_RESTORE_WARNINGS
+
+#include <chrono>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+
+/* Renderer benchmarks, running on a real OpenGL context
+ *
+ * Renders synthetic frames resembling typical in-game workloads into a
+ * hidden window, the same way the game does: Into the upscaling buffer,
+ * which is then presented to the window. Besides the total time per frame,
+ * each benchmark reports the CPU time spent on submitting the frame's draw
+ * calls (excluding the buffer swap) and the GPU time, if the OpenGL
+ * implementation supports timer queries.
+ *
+ * Vsync is disabled, so that the results aren't capped at the display's
+ * refresh rate. Running this on the target hardware requires a working
+ * OpenGL (ES) driver, but no game data.
+ */
+
+using namespace rigel;
+
+
+namespace
+{
+
+constexpr auto WINDOW_WIDTH = 1920;
+constexpr auto WINDOW_HEIGHT = 1080;
+
+constexpr auto TILE_SET_SIZE = base::Size{
+  data::GameTraits::CZone::tileSetImageWidth,
+  data::GameTraits::CZone::tileSetImageHeight};
+
+constexpr auto NUM_SPRITE_IMAGES = 64;
+constexpr auto NUM_SPRITES = 2000;
+constexpr auto NUM_HUD_GLYPHS = 600;
+constexpr auto NUM_CLOAKED_SPRITES = 32;
+
+
+enum class Workload
+{
+  Sprites,
+  Tiles,
+  Hud,
+  WaterAndCloak
+};
+
+
+data::Image makeImage(const int width, const int height, std::mt19937& rng)
+{
+  auto distribution = std::uniform_int_distribution<int>{0, 255};
+
+  auto pixels = data::PixelBuffer{};
+  pixels.reserve(width * height);
+  for (auto i = 0; i < width * height; ++i)
+  {
+    // Roughly a quarter of all pixels are transparent, like in typical
+    // sprite art
+    const auto alpha = distribution(rng) < 64 ? 0 : 255;
+    pixels.push_back(data::Pixel{
+      std::uint8_t(distribution(rng)),
+      std::uint8_t(distribution(rng)),
+      std::uint8_t(distribution(rng)),
+      std::uint8_t(alpha)});
+  }
+
+  return data::Image{std::move(pixels), size_t(width), size_t(height)};
+}
+
+
+/** Synthetic stand-ins for the game's graphics, and things to draw */
+class Scene
+{
+public:
+  explicit Scene(renderer::Renderer* pRenderer)
+    : mpRenderer(pRenderer)
+    , mTileSet(
+        renderer::Texture{
+          pRenderer,
+          makeImage(
+            data::tilesToPixels(TILE_SET_SIZE.width),
+            data::tilesToPixels(TILE_SET_SIZE.height),
+            mRng)},
+        pRenderer)
+    , mSpecialEffects(pRenderer, mOptions)
+  {
+    auto images = std::vector<data::Image>{};
+    for (auto i = 0; i < NUM_SPRITE_IMAGES; ++i)
+    {
+      images.push_back(makeImage(
+        data::GameTraits::tileSize * randomInt(1, 4),
+        data::GameTraits::tileSize * randomInt(1, 4),
+        mRng));
+    }
+    mpSpriteAtlas =
+      std::make_unique<renderer::TextureAtlas>(pRenderer, images);
+
+    const auto viewportSize = data::GameTraits::mapViewportSize;
+    for (auto i = 0; i < NUM_SPRITES; ++i)
+    {
+      const auto imageId = randomInt(0, NUM_SPRITE_IMAGES - 1);
+      const auto& image = images[imageId];
+      mSprites.push_back(
+        {imageId,
+         {{randomInt(-16, data::tilesToPixels(viewportSize.width)),
+           randomInt(-16, data::tilesToPixels(viewportSize.height))},
+          {int(image.width()), int(image.height())}}});
+    }
+
+    const auto numTiles = TILE_SET_SIZE.width * TILE_SET_SIZE.height;
+    for (auto layer = 0; layer < 2; ++layer)
+    {
+      for (auto y = 0; y < viewportSize.height; ++y)
+      {
+        for (auto x = 0; x < viewportSize.width; ++x)
+        {
+          mTiles.push_back({randomInt(0, numTiles - 1), {x, y}});
+        }
+      }
+    }
+
+    for (auto i = 0; i < NUM_HUD_GLYPHS; ++i)
+    {
+      mHudGlyphs.push_back({randomInt(0, numTiles - 1), {i % 40, i / 40}});
+    }
+
+    mWaterAreas.push_back({{{32, 96}, {160, 64}}, true});
+    mWaterAreas.push_back({{{200, 40}, {48, 120}}, false});
+  }
+
+  void draw(const Workload workload, const int frame)
+  {
+    switch (workload)
+    {
+      case Workload::Sprites:
+        drawSprites();
+        break;
+
+      case Workload::Tiles:
+        mTileSet.renderTiles(mTiles);
+        break;
+
+      case Workload::Hud:
+        drawHud(frame);
+        break;
+
+      case Workload::WaterAndCloak:
+        drawWaterAndCloak(frame);
+        break;
+    }
+  }
+
+  const data::GameOptions& options() const { return mOptions; }
+
+private:
+  struct SpriteInstance
+  {
+    int mImageId;
+    base::Rect<int> mDestRect;
+  };
+
+  int randomInt(const int min, const int max)
+  {
+    return std::uniform_int_distribution<int>{min, max}(mRng);
+  }
+
+  void drawSprites()
+  {
+    for (const auto& sprite : mSprites)
+    {
+      mpSpriteAtlas->draw(sprite.mImageId, sprite.mDestRect);
+    }
+  }
+
+  void drawHud(const int frame)
+  {
+    // Translucent panels, text, and a few animated bars, with frequent
+    // render state changes in between - similar to the HUD and menus.
+    for (auto i = 0; i < 8; ++i)
+    {
+      mpRenderer->drawRectangle(
+        {{8, 8 + i * 20}, {120, 16}}, base::Color{0, 0, 0, 160});
+      mpRenderer->drawRectangle(
+        {{10, 10 + i * 20}, {(frame * 3 + i * 13) % 116, 12}},
+        base::Color{255, 64, 64, 255});
+    }
+
+    {
+      auto saved = renderer::saveState(mpRenderer);
+      mpRenderer->setColorModulation(base::Color{255, 255, 0, 255});
+      mTileSet.renderTiles(mHudGlyphs);
+    }
+
+    for (auto i = 0; i < 16; ++i)
+    {
+      mpRenderer->drawLine(
+        0, 150 + i, 320, 150 + i, base::Color{0, 255, 0, 255});
+    }
+  }
+
+  void drawWaterAndCloak(const int frame)
+  {
+    {
+      auto saved = mSpecialEffects.bindBackgroundBuffer();
+      mTileSet.renderTiles(mTiles);
+
+      for (auto i = 0; i < NUM_CLOAKED_SPRITES; ++i)
+      {
+        const auto& tile = mHudGlyphs[i];
+        mSpecialEffects.drawCloakEffect(
+          mTileSet.textureId(),
+          mTileSet.tileTexCoords(tile.mIndex),
+          {data::tilesToPixels(tile.mPosition * 4), {32, 32}});
+      }
+    }
+
+    mSpecialEffects.drawBackgroundBuffer();
+    mSpecialEffects.drawEffects(mWaterAreas, frame % 4);
+  }
+
+  std::mt19937 mRng{1234};
+  data::GameOptions mOptions;
+  renderer::Renderer* mpRenderer;
+  engine::TiledTexture mTileSet;
+  engine::SpecialEffectsRenderer mSpecialEffects;
+  std::unique_ptr<renderer::TextureAtlas> mpSpriteAtlas;
+
+  std::vector<SpriteInstance> mSprites;
+  std::vector<engine::TilePlacement> mTiles;
+  std::vector<engine::TilePlacement> mHudGlyphs;
+  std::vector<engine::WaterEffectArea> mWaterAreas;
+};
+
+
+void renderFrames(
+  benchmark::State& state,
+  renderer::Renderer* pRenderer,
+  const Workload workload,
+  const data::UpscalingFilter filter)
+{
+  Scene scene{pRenderer};
+
+  auto options = scene.options();
+  options.mUpscalingFilter = filter;
+  renderer::UpscalingBuffer upscalingBuffer{pRenderer, options};
+
+  auto frame = 0;
+  auto submitTime = std::chrono::duration<double, std::milli>{};
+  auto gpuTimeMs = 0.0;
+  auto numGpuTimeSamples = 0;
+  auto drawCalls = 0;
+
+  for (auto _ : state)
+  {
+    const auto startTime = base::Clock::now();
+
+    {
+      auto saved = upscalingBuffer.bindAndClear(false);
+      scene.draw(workload, frame);
+    }
+    upscalingBuffer.present(false, false);
+    pRenderer->submitBatch();
+
+    submitTime += base::Clock::now() - startTime;
+
+    pRenderer->swapBuffers();
+
+    const auto& statistics = pRenderer->lastFrameStatistics();
+    if (statistics.mGpuTimeMs)
+    {
+      gpuTimeMs += *statistics.mGpuTimeMs;
+      ++numGpuTimeSamples;
+    }
+    drawCalls += statistics.mDrawCalls;
+
+    ++frame;
+  }
+
+  // Wait for outstanding work, so that it's not attributed to the next
+  // benchmark
+  glFinish();
+
+  state.counters["cpu_submit_ms"] = benchmark::Counter(
+    submitTime.count(), benchmark::Counter::kAvgIterations);
+  state.counters["draw_calls"] =
+    benchmark::Counter(drawCalls, benchmark::Counter::kAvgIterations);
+
+  if (numGpuTimeSamples > 0)
+  {
+    state.counters["gpu_ms"] = gpuTimeMs / numGpuTimeSamples;
+  }
+}
+
+
+void registerBenchmarks(renderer::Renderer* pRenderer)
+{
+  using UF = data::UpscalingFilter;
+
+  const std::pair<const char*, Workload> workloads[] = {
+    {"BMSprites", Workload::Sprites},
+    {"BMTiles", Workload::Tiles},
+    {"BMHud", Workload::Hud},
+    {"BMWaterAndCloak", Workload::WaterAndCloak},
+  };
+
+  for (const auto& [name, workload] : workloads)
+  {
+    benchmark::RegisterBenchmark(
+      name, renderFrames, pRenderer, workload, UF::None);
+  }
+
+  const std::pair<const char*, UF> filters[] = {
+    {"BMUpscalingNone", UF::None},
+    {"BMUpscalingSharpBilinear", UF::SharpBilinear},
+    {"BMUpscalingPixelPerfect", UF::PixelPerfect},
+    {"BMUpscalingBilinear", UF::Bilinear},
+  };
+
+  for (const auto& [name, filter] : filters)
+  {
+    benchmark::RegisterBenchmark(
+      name, renderFrames, pRenderer, Workload::Tiles, filter);
+  }
+}
+
+} // namespace
+
+
+int main(int argc, char** argv)
+{
+  benchmark::Initialize(&argc, argv);
+  if (benchmark::ReportUnrecognizedArguments(argc, argv))
+  {
+    return 1;
+  }
+
+  sdl_utils::check(SDL_Init(SDL_INIT_VIDEO));
+  auto sdlGuard = base::defer([]() { SDL_Quit(); });
+
+  sdl_utils::check(SDL_GL_LoadLibrary(nullptr));
+  platform::setGLAttributes();
+
+  auto pWindow = sdl_utils::wrap(sdl_utils::check(SDL_CreateWindow(
+    "Rigel Engine renderer benchmarks",
+    SDL_WINDOWPOS_UNDEFINED,
+    SDL_WINDOWPOS_UNDEFINED,
+    WINDOW_WIDTH,
+    WINDOW_HEIGHT,
+    SDL_WINDOW_OPENGL | SDL_WINDOW_HIDDEN)));
+
+  SDL_GLContext pGlContext =
+    sdl_utils::check(SDL_GL_CreateContext(pWindow.get()));
+  auto glGuard = base::defer([pGlContext]() {
+    SDL_GL_DeleteContext(pGlContext);
+  });
+
+  renderer::loadGlFunctions();
+  SDL_GL_SetSwapInterval(0);
+
+  {
+    renderer::Renderer renderer{pWindow.get()};
+    registerBenchmarks(&renderer);
+    benchmark::RunSpecifiedBenchmarks();
+  }
+
+  benchmark::Shutdown();
+  return 0;
+}
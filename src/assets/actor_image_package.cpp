@@ -38,6 +38,7 @@ ActorImagePackage::ActorImagePackage(
   ByteBuffer imageData,
   const ByteBuffer& actorInfoData)
   : mImageData(std::move(imageData))
+  , mImageDataMemory(base::MemoryCategory::AssetBuffers, mImageData.size())
 {
   LeStreamReader actorInfoReader(actorInfoData);
   const auto numEntries = actorInfoReader.peekU16();
@@ -100,6 +101,14 @@ const ActorHeader& ActorImagePackage::loadActorInfo(const ActorID id) const
 data::Image ActorImagePackage::loadImage(
   const ActorFrameHeader& frameHeader,
   const data::Palette16& palette) const
+{
+  return loadIndexedImage(frameHeader, palette).toImage();
+}
+
+
+data::IndexedImage ActorImagePackage::loadIndexedImage(
+  const ActorFrameHeader& frameHeader,
+  const data::Palette16& palette) const
 {
   using T = data::TileImageType;
 
@@ -113,7 +122,7 @@ data::Image ActorImagePackage::loadImage(
   }
 
   const auto dataStart = mImageData.begin() + frameHeader.mFileOffset;
-  return loadTiledImage(
+  return loadTiledIndexedImage(
     dataStart, dataStart + dataSize, width, palette, T::Masked);
 }
 
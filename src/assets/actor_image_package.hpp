@@ -18,6 +18,7 @@
 
 #include "assets/byte_buffer.hpp"
 #include "base/image.hpp"
+#include "base/memory_accounting.hpp"
 #include "base/spatial_types.hpp"
 #include "data/actor_ids.hpp"
 #include "data/game_traits.hpp"
@@ -59,6 +60,9 @@ public:
   data::Image loadImage(
     const ActorFrameHeader& frameHeader,
     const data::Palette16& palette) const;
+  data::IndexedImage loadIndexedImage(
+    const ActorFrameHeader& frameHeader,
+    const data::Palette16& palette) const;
 
   FontData loadFont() const;
 
@@ -74,6 +78,7 @@ public:
 
 private:
   const ByteBuffer mImageData;
+  base::TrackedMemory mImageDataMemory;
   std::map<data::ActorID, ActorHeader> mHeadersById;
   std::vector<int> mDrawIndexById;
 };
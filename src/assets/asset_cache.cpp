@@ -0,0 +1,202 @@
+/* Copyright (C) 2022, Nikolai Wuttke. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "asset_cache.hpp"
+
+#include "assets/file_utils.hpp"
+#include "base/warnings.hpp"
+
+RIGEL_DISABLE_WARNINGS
+#include <loguru.hpp>
+RIGEL_RESTORE_WARNINGS
+
+#include <cstring>
+#include <exception>
+#include <string>
+#include <system_error>
+#include <utility>
+
+
+namespace rigel::assets
+{
+
+namespace fs = std::filesystem;
+
+
+namespace
+{
+
+constexpr char MAGIC[] = {'R', 'G', 'A', 'C'};
+
+// Increment this whenever any of the cached formats change, or any of the
+// decoders whose output is cached change their results
+constexpr std::uint32_t FORMAT_VERSION = 2;
+
+constexpr auto HEADER_SIZE = sizeof(MAGIC) + 3 * sizeof(std::uint32_t);
+
+} // namespace
+
+
+AssetCache::Entry::Entry(
+  MemoryMappedFile file,
+  const base::ArrayView<std::uint8_t> payload)
+  : mFile(std::move(file))
+  , mPayload(payload)
+{
+}
+
+
+AssetCache::AssetCache(fs::path directory, const std::uint64_t contentKey)
+  : mDirectory(std::move(directory))
+  , mContentKey(contentKey)
+{
+}
+
+
+auto AssetCache::load(std::string_view name) const -> std::optional<Entry>
+{
+  const auto path = entryPath(name);
+
+  std::error_code ec;
+  if (!fs::exists(path, ec))
+  {
+    return std::nullopt;
+  }
+
+  try
+  {
+    auto file = MemoryMappedFile{path};
+    const auto data = file.data();
+
+    auto reader = LeStreamReader{data};
+    const auto magic = reader.peekBytes(sizeof(MAGIC));
+    reader.skipBytes(sizeof(MAGIC));
+
+    const auto version = reader.readU32();
+    const auto keyLow = reader.readU32();
+    const auto keyHigh = reader.readU32();
+    const auto key = std::uint64_t(keyHigh) << 32 | keyLow;
+
+    if (
+      std::memcmp(magic.data(), MAGIC, sizeof(MAGIC)) != 0 ||
+      version != FORMAT_VERSION || key != mContentKey)
+    {
+      LOG_F(
+        INFO,
+        "Discarding outdated asset cache entry '%s'",
+        path.u8string().c_str());
+      return std::nullopt;
+    }
+
+    // Moving the mapping doesn't change its address, so the payload view
+    // stays valid.
+    const auto payload = data.subView(HEADER_SIZE);
+    return Entry{std::move(file), payload};
+  }
+  catch (const std::exception& error)
+  {
+    LOG_F(
+      WARNING,
+      "Failed to read asset cache entry '%s': %s",
+      path.u8string().c_str(),
+      error.what());
+    return std::nullopt;
+  }
+}
+
+
+void AssetCache::store(std::string_view name, const ByteBuffer& payload) const
+{
+  const auto path = entryPath(name);
+
+  try
+  {
+    std::error_code ec;
+    fs::create_directories(mDirectory, ec);
+
+    LeStreamWriter writer;
+    writer.writeBytes(base::ArrayView<std::uint8_t>{
+      reinterpret_cast<const std::uint8_t*>(MAGIC), sizeof(MAGIC)});
+    writer.writeU32(FORMAT_VERSION);
+    writer.writeU32(std::uint32_t(mContentKey & 0xFFFFFFFF));
+    writer.writeU32(std::uint32_t(mContentKey >> 32));
+
+    // Write to a temporary file first, so that a crash or concurrently
+    // running instance can never leave a partially written entry behind.
+    auto tempPath = path;
+    tempPath += ".tmp";
+
+    auto data = writer.buffer();
+    data.insert(data.end(), payload.begin(), payload.end());
+    saveToFile(data, tempPath);
+
+    fs::rename(tempPath, path);
+  }
+  catch (const std::exception& error)
+  {
+    LOG_F(
+      WARNING,
+      "Failed to write asset cache entry '%s': %s",
+      path.u8string().c_str(),
+      error.what());
+  }
+}
+
+
+fs::path AssetCache::entryPath(std::string_view name) const
+{
+  auto fileName = std::string{name};
+  fileName += ".bin";
+  return mDirectory / fs::u8path(fileName);
+}
+
+
+CacheKeyHasher&
+  CacheKeyHasher::addBytes(const base::ArrayView<std::uint8_t> bytes)
+{
+  for (const auto byte : bytes)
+  {
+    mHash ^= byte;
+    mHash *= 1099511628211ull;
+  }
+
+  return *this;
+}
+
+
+CacheKeyHasher& CacheKeyHasher::add(std::string_view text)
+{
+  addBytes(base::ArrayView<std::uint8_t>{
+    reinterpret_cast<const std::uint8_t*>(text.data()),
+    static_cast<std::uint32_t>(text.size())});
+
+  // Terminate, so that consecutive strings can't be confused with each other
+  return add(std::uint64_t{0});
+}
+
+
+CacheKeyHasher& CacheKeyHasher::add(const std::uint64_t value)
+{
+  std::uint8_t bytes[sizeof(value)];
+  for (auto i = 0u; i < sizeof(value); ++i)
+  {
+    bytes[i] = std::uint8_t(value >> (i * 8));
+  }
+
+  return addBytes(base::ArrayView<std::uint8_t>{bytes});
+}
+
+} // namespace rigel::assets
@@ -0,0 +1,93 @@
+/* Copyright (C) 2022, Nikolai Wuttke. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "assets/byte_buffer.hpp"
+#include "assets/memory_mapped_file.hpp"
+#include "base/array_view.hpp"
+
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <string_view>
+
+
+namespace rigel::assets
+{
+
+/** Persistent on-disk cache for the results of expensive asset decoding
+ *
+ * Each entry is a single file in the cache directory, holding a binary
+ * payload whose format is defined by the code using the entry. Entries are
+ * tagged with a content key identifying the game data and mods in use (see
+ * ResourceLoader::contentKey()), plus a format version. Entries with a
+ * different key or version are treated as missing, and replaced on the next
+ * store().
+ *
+ * Anything which influences the payload besides the game data (e.g. the
+ * audio output format) must be made part of the entry name.
+ *
+ * The cache is purely an optimization, so errors while reading or writing
+ * entries are logged instead of being thrown.
+ */
+class AssetCache
+{
+public:
+  class Entry
+  {
+  public:
+    base::ArrayView<std::uint8_t> data() const { return mPayload; }
+
+  private:
+    friend class AssetCache;
+
+    Entry(MemoryMappedFile file, base::ArrayView<std::uint8_t> payload);
+
+    MemoryMappedFile mFile;
+    base::ArrayView<std::uint8_t> mPayload;
+  };
+
+  AssetCache(std::filesystem::path directory, std::uint64_t contentKey);
+
+  /** Memory-map the given entry, if it exists and is valid */
+  std::optional<Entry> load(std::string_view name) const;
+
+  void store(std::string_view name, const ByteBuffer& payload) const;
+
+private:
+  std::filesystem::path entryPath(std::string_view name) const;
+
+  std::filesystem::path mDirectory;
+  std::uint64_t mContentKey;
+};
+
+
+/** Incremental 64-bit FNV-1a hash, for building cache keys */
+class CacheKeyHasher
+{
+public:
+  CacheKeyHasher& addBytes(base::ArrayView<std::uint8_t> bytes);
+  CacheKeyHasher& add(std::string_view text);
+  CacheKeyHasher& add(std::uint64_t value);
+
+  std::uint64_t value() const { return mHash; }
+
+private:
+  std::uint64_t mHash = 14695981039346656037ull;
+};
+
+} // namespace rigel::assets
@@ -41,9 +41,9 @@ std::string normalizedFileName(std::string_view fileName)
 
 
 CMPFilePackage::CMPFilePackage(const std::filesystem::path& filePath)
-  : mFileData(loadFile(filePath))
+  : mFile(filePath)
 {
-  LeStreamReader dictReader(mFileData.begin(), mFileData.end());
+  LeStreamReader dictReader(mFile.data());
 
   while (dictReader.hasData())
   {
@@ -55,7 +55,7 @@ CMPFilePackage::CMPFilePackage(const std::filesystem::path& filePath)
     {
       break;
     }
-    if (fileOffset + fileSize > mFileData.size())
+    if (uint64_t(fileOffset) + fileSize > mFile.data().size())
     {
       throw invalid_argument("Malformed dictionary in CMP file");
     }
@@ -67,6 +67,13 @@ CMPFilePackage::CMPFilePackage(const std::filesystem::path& filePath)
 
 
 ByteBuffer CMPFilePackage::file(std::string_view name) const
+{
+  const auto view = fileView(name);
+  return ByteBuffer(view.begin(), view.end());
+}
+
+
+base::ArrayView<uint8_t> CMPFilePackage::fileView(std::string_view name) const
 {
   const auto it = findFileEntry(name);
   if (it == mFileDict.end())
@@ -76,8 +83,8 @@ ByteBuffer CMPFilePackage::file(std::string_view name) const
   }
 
   const auto& fileHeader = it->second;
-  const auto fileStart = mFileData.begin() + fileHeader.fileOffset;
-  return ByteBuffer(fileStart, fileStart + fileHeader.fileSize);
+  return base::ArrayView<uint8_t>{
+    mFile.data().data() + fileHeader.fileOffset, fileHeader.fileSize};
 }
 
 
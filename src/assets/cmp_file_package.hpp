@@ -17,6 +17,8 @@
 #pragma once
 
 #include "assets/byte_buffer.hpp"
+#include "assets/memory_mapped_file.hpp"
+#include "base/array_view.hpp"
 
 #include <cstddef>
 #include <filesystem>
@@ -29,13 +31,25 @@ namespace rigel::assets
 {
 
 
+/** Provides access to the files contained in a CMP archive
+ *
+ * The archive is memory-mapped instead of being loaded into memory, so only
+ * the parts which are actually used are paged in.
+ */
 class CMPFilePackage
 {
 public:
   explicit CMPFilePackage(const std::filesystem::path& filePath);
 
+  /** Returns a copy of the given file's contents */
   ByteBuffer file(std::string_view name) const;
 
+  /** Returns a view of the given file's contents, without copying
+   *
+   * The view remains valid for as long as the package exists.
+   */
+  base::ArrayView<std::uint8_t> fileView(std::string_view name) const;
+
   bool hasFile(std::string_view name) const;
 
 private:
@@ -54,7 +68,7 @@ private:
   FileDict::const_iterator findFileEntry(std::string_view name) const;
 
 private:
-  std::vector<std::uint8_t> mFileData;
+  MemoryMappedFile mFile;
   FileDict mFileDict;
 };
 
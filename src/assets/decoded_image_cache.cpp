@@ -0,0 +1,194 @@
+/* Copyright (C) 2022, Nikolai Wuttke. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "decoded_image_cache.hpp"
+
+#include "assets/png_image.hpp"
+
+#include <iterator>
+#include <system_error>
+
+
+namespace rigel::assets
+{
+
+namespace fs = std::filesystem;
+
+
+namespace
+{
+
+std::size_t imageSizeInBytes(const data::Image& image)
+{
+  return image.pixelData().size() * sizeof(data::Pixel);
+}
+
+
+std::optional<fs::file_time_type> modificationTime(const fs::path& path)
+{
+  std::error_code error;
+  const auto time = fs::last_write_time(path, error);
+  if (error)
+  {
+    return {};
+  }
+
+  return time;
+}
+
+} // namespace
+
+
+DecodedImageCache::DecodedImageCache(const std::size_t budgetInBytes)
+  : mBudgetInBytes(budgetInBytes)
+{
+}
+
+
+std::optional<data::Image> DecodedImageCache::load(const fs::path& path)
+{
+  const auto oTime = modificationTime(path);
+  if (!oTime)
+  {
+    return {};
+  }
+
+  auto key = path.u8string();
+  if (auto oImage = find(key, *oTime))
+  {
+    return oImage;
+  }
+
+  auto oImage = loadPng(path);
+  if (oImage)
+  {
+    insert(std::move(key), *oTime, *oImage);
+  }
+
+  return oImage;
+}
+
+
+std::vector<std::optional<data::Image>>
+  DecodedImageCache::load(const std::vector<fs::path>& paths)
+{
+  auto result = std::vector<std::optional<data::Image>>(paths.size());
+
+  std::vector<fs::path> pathsToDecode;
+  std::vector<std::size_t> indicesToDecode;
+  std::vector<fs::file_time_type> timesToDecode;
+
+  for (auto i = std::size_t{0}; i < paths.size(); ++i)
+  {
+    const auto oTime = modificationTime(paths[i]);
+    if (!oTime)
+    {
+      continue;
+    }
+
+    result[i] = find(paths[i].u8string(), *oTime);
+    if (!result[i])
+    {
+      pathsToDecode.push_back(paths[i]);
+      indicesToDecode.push_back(i);
+      timesToDecode.push_back(*oTime);
+    }
+  }
+
+  auto decoded = loadPngs(pathsToDecode);
+
+  for (auto i = std::size_t{0}; i < decoded.size(); ++i)
+  {
+    if (decoded[i])
+    {
+      insert(pathsToDecode[i].u8string(), timesToDecode[i], *decoded[i]);
+      result[indicesToDecode[i]] = std::move(decoded[i]);
+    }
+  }
+
+  return result;
+}
+
+
+std::size_t DecodedImageCache::sizeInBytes() const
+{
+  std::lock_guard lock{mMutex};
+  return mSizeInBytes;
+}
+
+
+std::optional<data::Image> DecodedImageCache::find(
+  const std::string& path,
+  const fs::file_time_type modificationTime)
+{
+  std::lock_guard lock{mMutex};
+
+  const auto iIndex = mIndex.find(path);
+  if (iIndex == mIndex.end())
+  {
+    return {};
+  }
+
+  const auto iEntry = iIndex->second;
+  if (iEntry->mModificationTime != modificationTime)
+  {
+    evict(iEntry);
+    return {};
+  }
+
+  mEntries.splice(mEntries.begin(), mEntries, iEntry);
+  return iEntry->mImage;
+}
+
+
+void DecodedImageCache::insert(
+  std::string path,
+  const fs::file_time_type modificationTime,
+  const data::Image& image)
+{
+  const auto size = imageSizeInBytes(image);
+  if (size > mBudgetInBytes)
+  {
+    return;
+  }
+
+  std::lock_guard lock{mMutex};
+
+  // Another thread might have decoded the same file in the meantime
+  if (const auto iIndex = mIndex.find(path); iIndex != mIndex.end())
+  {
+    evict(iIndex->second);
+  }
+
+  while (!mEntries.empty() && mSizeInBytes + size > mBudgetInBytes)
+  {
+    evict(std::prev(mEntries.end()));
+  }
+
+  mEntries.push_front(Entry{path, modificationTime, image});
+  mIndex.emplace(std::move(path), mEntries.begin());
+  mSizeInBytes += size;
+}
+
+
+void DecodedImageCache::evict(const EntryList::iterator iEntry)
+{
+  mSizeInBytes -= imageSizeInBytes(iEntry->mImage);
+  mIndex.erase(iEntry->mPath);
+  mEntries.erase(iEntry);
+}
+
+} // namespace rigel::assets
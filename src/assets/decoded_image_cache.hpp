@@ -0,0 +1,88 @@
+/* Copyright (C) 2022, Nikolai Wuttke. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "base/image.hpp"
+
+#include <cstddef>
+#include <filesystem>
+#include <list>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+
+namespace rigel::assets
+{
+
+/** In-memory LRU cache of decoded PNG files
+ *
+ * Entries are keyed by path and modification time, so a file that changes
+ * on disk is decoded again on the next load. Once the total size of the
+ * cached images exceeds the budget given on construction, the least recently
+ * used entries are dropped. Images larger than the whole budget are never
+ * cached.
+ *
+ * All member functions are thread-safe. Decoding happens without holding
+ * the lock, so that multiple threads can load images concurrently.
+ */
+class DecodedImageCache
+{
+public:
+  explicit DecodedImageCache(std::size_t budgetInBytes);
+
+  /** Return the decoded image for the given path, decoding it if needed
+   *
+   * Returns an empty optional if the file couldn't be loaded.
+   */
+  std::optional<data::Image> load(const std::filesystem::path& path);
+
+  /** Like load(), but decodes all images that aren't cached in parallel */
+  std::vector<std::optional<data::Image>>
+    load(const std::vector<std::filesystem::path>& paths);
+
+  std::size_t sizeInBytes() const;
+
+private:
+  struct Entry
+  {
+    std::string mPath;
+    std::filesystem::file_time_type mModificationTime;
+    data::Image mImage;
+  };
+
+  using EntryList = std::list<Entry>;
+
+  std::optional<data::Image> find(
+    const std::string& path,
+    std::filesystem::file_time_type modificationTime);
+  void insert(
+    std::string path,
+    std::filesystem::file_time_type modificationTime,
+    const data::Image& image);
+  void evict(EntryList::iterator iEntry);
+
+  mutable std::mutex mMutex;
+  EntryList mEntries;
+  std::unordered_map<std::string, EntryList::iterator> mIndex;
+  std::size_t mBudgetInBytes;
+  std::size_t mSizeInBytes = 0;
+};
+
+} // namespace rigel::assets
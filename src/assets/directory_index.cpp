@@ -0,0 +1,88 @@
+/* Copyright (C) 2022, Nikolai Wuttke. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "directory_index.hpp"
+
+#include "base/string_utils.hpp"
+
+
+namespace rigel::assets
+{
+
+namespace fs = std::filesystem;
+
+namespace
+{
+
+// Match the file system's behavior: On Windows and macOS, file names are
+// case-insensitive by default.
+std::string lookupKey(std::string_view fileName)
+{
+#if defined(_WIN32) || defined(__APPLE__)
+  return strings::toLowercase(fileName);
+#else
+  return std::string{fileName};
+#endif
+}
+
+} // namespace
+
+
+DirectoryIndex::DirectoryIndex(const fs::path& directory)
+{
+  std::error_code ec;
+  for (auto iEntry = fs::directory_iterator{directory, ec};
+       iEntry != fs::directory_iterator{};
+       iEntry.increment(ec))
+  {
+    if (iEntry->is_regular_file(ec))
+    {
+      mIndexByName.emplace(
+        lookupKey(iEntry->path().filename().u8string()), mFiles.size());
+      mFiles.push_back(iEntry->path());
+    }
+  }
+}
+
+
+std::optional<fs::path> DirectoryIndex::find(std::string_view fileName) const
+{
+  if (const auto iEntry = mIndexByName.find(lookupKey(fileName));
+      iEntry != mIndexByName.end())
+  {
+    return mFiles[iEntry->second];
+  }
+
+  return std::nullopt;
+}
+
+
+std::vector<fs::path> DirectoryIndex::findByStem(const fs::path& stem) const
+{
+  std::vector<fs::path> result;
+
+  for (const auto& file : mFiles)
+  {
+    if (file.stem() == stem)
+    {
+      result.push_back(file);
+    }
+  }
+
+  return result;
+}
+
+} // namespace rigel::assets
@@ -0,0 +1,60 @@
+/* Copyright (C) 2022, Nikolai Wuttke. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+
+namespace rigel::assets
+{
+
+/** Snapshot of the files in a directory
+ *
+ * Lists the directory once on construction, so that repeated lookups don't
+ * need to query the file system. This makes a big difference on slow
+ * storage like SD cards or network shares. Only regular files directly
+ * inside the directory are included, sub-directories are ignored.
+ *
+ * Changes made to the directory afterwards are not reflected.
+ */
+class DirectoryIndex
+{
+public:
+  DirectoryIndex() = default;
+  explicit DirectoryIndex(const std::filesystem::path& directory);
+
+  /** Returns full path of the given file, if present in the directory */
+  std::optional<std::filesystem::path> find(std::string_view fileName) const;
+
+  /** Returns all files whose name without extension equals the given stem */
+  std::vector<std::filesystem::path>
+    findByStem(const std::filesystem::path& stem) const;
+
+  /** All files in the directory, in unspecified order */
+  const std::vector<std::filesystem::path>& files() const { return mFiles; }
+
+private:
+  std::vector<std::filesystem::path> mFiles;
+  std::unordered_map<std::string, std::size_t> mIndexByName;
+};
+
+} // namespace rigel::assets
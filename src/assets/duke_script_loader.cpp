@@ -16,6 +16,7 @@
 
 #include "duke_script_loader.hpp"
 
+#include "assets/file_utils.hpp"
 #include "base/string_utils.hpp"
 #include "base/warnings.hpp"
 #include "data/game_traits.hpp"
@@ -26,6 +27,7 @@
 #include <optional>
 #include <sstream>
 #include <stdexcept>
+#include <type_traits>
 #include <unordered_set>
 
 
@@ -513,6 +515,366 @@ bool skipToHintsSection(istream& sourceTextStream)
   return false;
 }
 
+const char* INVALID_COMPILED_SCRIPTS = "Invalid compiled script data";
+
+
+template <typename ActionT, std::size_t Index = 0>
+constexpr std::uint8_t opcodeFor()
+{
+  using Candidate = std::variant_alternative_t<Index, Action>;
+
+  if constexpr (std::is_same_v<Candidate, ActionT>)
+  {
+    return std::uint8_t(Index);
+  }
+  else
+  {
+    return opcodeFor<ActionT, Index + 1>();
+  }
+}
+
+
+class ScriptCompiler
+{
+public:
+  ByteBuffer compile(const ScriptBundle& bundle)
+  {
+    mCode.writeU32(std::uint32_t(bundle.size()));
+    for (const auto& [name, script] : bundle)
+    {
+      writeString(name);
+      writeScript(script);
+    }
+
+    LeStreamWriter result;
+    result.writeU32(std::uint32_t(mStrings.size()));
+    for (const auto& str : mStrings)
+    {
+      result.writeU32(std::uint32_t(str.size()));
+      result.writeBytes(base::ArrayView<std::uint8_t>{
+        reinterpret_cast<const std::uint8_t*>(str.data()),
+        std::uint32_t(str.size())});
+    }
+
+    result.writeBytes(mCode.buffer());
+    return result.buffer();
+  }
+
+private:
+  void writeString(const string& str)
+  {
+    const auto [iEntry, inserted] =
+      mStringIndices.emplace(str, std::uint32_t(mStrings.size()));
+    if (inserted)
+    {
+      mStrings.push_back(str);
+    }
+
+    mCode.writeU32(iEntry->second);
+  }
+
+  void writeInt(const int value) { mCode.writeU32(std::uint32_t(value)); }
+
+  void writeScript(const Script& script)
+  {
+    mCode.writeU32(std::uint32_t(script.size()));
+    for (const auto& action : script)
+    {
+      mCode.writeU8(std::uint8_t(action.index()));
+      std::visit([this](const auto& value) { writeOperands(value); }, action);
+    }
+  }
+
+  void writeOperands(const std::shared_ptr<PagesDefinition>& pPages)
+  {
+    mCode.writeU32(std::uint32_t(pPages->pages.size()));
+    for (const auto& page : pPages->pages)
+    {
+      writeScript(page);
+    }
+  }
+
+  void writeOperands(const AnimateNewsReporter& action)
+  {
+    writeInt(action.talkDuration);
+  }
+
+  void writeOperands(const ConfigurePersistentMenuSelection& action)
+  {
+    writeInt(action.slot);
+  }
+
+  void writeOperands(const Delay& action) { writeInt(action.amount); }
+
+  void writeOperands(const DrawBigText& action)
+  {
+    writeInt(action.x);
+    writeInt(action.y);
+    writeInt(action.colorIndex);
+    writeString(action.text);
+  }
+
+  void writeOperands(const DrawMessageBoxText& action)
+  {
+    writeString(action.mText);
+  }
+
+  void writeOperands(const DrawSprite& action)
+  {
+    writeInt(action.x);
+    writeInt(action.y);
+    writeInt(action.spriteId);
+    writeInt(action.frameNumber);
+  }
+
+  void writeOperands(const DrawText& action)
+  {
+    writeInt(action.x);
+    writeInt(action.y);
+    writeString(action.text);
+  }
+
+  void writeOperands(const SetPalette& action)
+  {
+    writeString(action.paletteFile);
+  }
+
+  void writeOperands(const SetupCheckBoxes& action)
+  {
+    writeInt(action.xPos);
+    mCode.writeU32(std::uint32_t(action.boxDefinitions.size()));
+    for (const auto& definition : action.boxDefinitions)
+    {
+      writeInt(definition.yPos);
+      mCode.writeU8(std::uint8_t(definition.id));
+    }
+  }
+
+  void writeOperands(const ShowFullScreenImage& action)
+  {
+    writeString(action.image);
+  }
+
+  void writeOperands(const ShowMenuSelectionIndicator& action)
+  {
+    writeInt(action.yPos);
+  }
+
+  void writeOperands(const ShowMessageBox& action)
+  {
+    writeInt(action.y);
+    writeInt(action.width);
+    writeInt(action.height);
+  }
+
+  void writeOperands(const ShowSaveSlots& action)
+  {
+    writeInt(action.mSelectedSlot);
+  }
+
+  // Actions without operands
+  template <typename ActionT>
+  void writeOperands(const ActionT&)
+  {
+    static_assert(std::is_empty_v<ActionT>);
+  }
+
+  LeStreamWriter mCode;
+  vector<string> mStrings;
+  unordered_map<string, std::uint32_t> mStringIndices;
+};
+
+
+class CompiledScriptReader
+{
+public:
+  explicit CompiledScriptReader(const base::ArrayView<std::uint8_t> data)
+    : mReader(data)
+  {
+  }
+
+  ScriptBundle read()
+  {
+    const auto numStrings = mReader.readU32();
+    for (auto i = 0u; i < numStrings; ++i)
+    {
+      const auto length = mReader.readU32();
+      mStrings.push_back(readFixedSizeString(mReader, length));
+    }
+
+    ScriptBundle bundle;
+
+    const auto numScripts = mReader.readU32();
+    for (auto i = 0u; i < numScripts; ++i)
+    {
+      auto name = readString();
+      bundle.emplace(std::move(name), readScript());
+    }
+
+    if (mReader.hasData())
+    {
+      throw invalid_argument(INVALID_COMPILED_SCRIPTS);
+    }
+
+    return bundle;
+  }
+
+private:
+  const string& readString()
+  {
+    const auto index = mReader.readU32();
+    if (index >= mStrings.size())
+    {
+      throw invalid_argument(INVALID_COMPILED_SCRIPTS);
+    }
+
+    return mStrings[index];
+  }
+
+  int readInt() { return int(mReader.readS32()); }
+
+  Script readScript()
+  {
+    Script script;
+
+    const auto numActions = mReader.readU32();
+    for (auto i = 0u; i < numActions; ++i)
+    {
+      script.push_back(readAction());
+    }
+
+    return script;
+  }
+
+  Action readAction()
+  {
+    static_assert(
+      std::variant_size_v<Action> == 23,
+      "Update readAction() and ScriptCompiler when adding new actions");
+
+    const auto opcode = mReader.readU8();
+    switch (opcode)
+    {
+      case opcodeFor<AnimateNewsReporter>():
+        return AnimateNewsReporter{readInt()};
+
+      case opcodeFor<std::shared_ptr<PagesDefinition>>():
+        {
+          std::vector<Script> pages;
+          const auto numPages = mReader.readU32();
+          for (auto i = 0u; i < numPages; ++i)
+          {
+            pages.push_back(readScript());
+          }
+
+          return std::make_shared<PagesDefinition>(std::move(pages));
+        }
+
+      case opcodeFor<ConfigurePersistentMenuSelection>():
+        return ConfigurePersistentMenuSelection{readInt()};
+
+      case opcodeFor<Delay>():
+        return Delay{readInt()};
+
+      case opcodeFor<DisableMenuFunctionality>():
+        return DisableMenuFunctionality{};
+
+      case opcodeFor<DrawBigText>():
+        {
+          const auto x = readInt();
+          const auto y = readInt();
+          const auto colorIndex = readInt();
+          return DrawBigText{x, y, colorIndex, readString()};
+        }
+
+      case opcodeFor<DrawMessageBoxText>():
+        return DrawMessageBoxText{readString()};
+
+      case opcodeFor<DrawSprite>():
+        {
+          const auto x = readInt();
+          const auto y = readInt();
+          const auto spriteId = readInt();
+          const auto frameNumber = readInt();
+          return DrawSprite{x, y, spriteId, frameNumber};
+        }
+
+      case opcodeFor<DrawText>():
+        {
+          const auto x = readInt();
+          const auto y = readInt();
+          return DrawText{x, y, readString()};
+        }
+
+      case opcodeFor<EnableTextOffset>():
+        return EnableTextOffset{};
+
+      case opcodeFor<EnableTimeOutToDemo>():
+        return EnableTimeOutToDemo{};
+
+      case opcodeFor<FadeIn>():
+        return FadeIn{};
+
+      case opcodeFor<FadeOut>():
+        return FadeOut{};
+
+      case opcodeFor<ScheduleFadeInBeforeNextWaitState>():
+        return ScheduleFadeInBeforeNextWaitState{};
+
+      case opcodeFor<SetPalette>():
+        return SetPalette{readString()};
+
+      case opcodeFor<SetupCheckBoxes>():
+        {
+          const auto xPos = readInt();
+
+          std::vector<SetupCheckBoxes::CheckBoxDefinition> definitions;
+          const auto numDefinitions = mReader.readU32();
+          for (auto i = 0u; i < numDefinitions; ++i)
+          {
+            const auto yPos = readInt();
+            const auto id = SetupCheckBoxes::CheckBoxID(mReader.readU8());
+            definitions.push_back({yPos, id});
+          }
+
+          return SetupCheckBoxes{xPos, std::move(definitions)};
+        }
+
+      case opcodeFor<ShowFullScreenImage>():
+        return ShowFullScreenImage{readString()};
+
+      case opcodeFor<ShowKeyBindings>():
+        return ShowKeyBindings{};
+
+      case opcodeFor<ShowMenuSelectionIndicator>():
+        return ShowMenuSelectionIndicator{readInt()};
+
+      case opcodeFor<ShowMessageBox>():
+        {
+          const auto y = readInt();
+          const auto width = readInt();
+          const auto height = readInt();
+          return ShowMessageBox{y, width, height};
+        }
+
+      case opcodeFor<ShowSaveSlots>():
+        return ShowSaveSlots{readInt()};
+
+      case opcodeFor<StopNewsReporterAnimation>():
+        return StopNewsReporterAnimation{};
+
+      case opcodeFor<WaitForUserInput>():
+        return WaitForUserInput{};
+
+      default:
+        throw invalid_argument(INVALID_COMPILED_SCRIPTS);
+    }
+  }
+
+  LeStreamReader mReader;
+  vector<string> mStrings;
+};
+
 } // namespace
 
 
@@ -539,6 +901,18 @@ ScriptBundle loadScripts(const string& scriptSource)
 }
 
 
+ByteBuffer compileScripts(const ScriptBundle& bundle)
+{
+  return ScriptCompiler{}.compile(bundle);
+}
+
+
+ScriptBundle loadCompiledScripts(const base::ArrayView<std::uint8_t> data)
+{
+  return CompiledScriptReader{data}.read();
+}
+
+
 data::LevelHints loadHintMessages(const std::string& scriptSource)
 {
   istringstream sourceStream(scriptSource);
@@ -16,6 +16,8 @@
 
 #pragma once
 
+#include "assets/byte_buffer.hpp"
+#include "base/array_view.hpp"
 #include "data/duke_script.hpp"
 #include "data/level_hints.hpp"
 
@@ -32,6 +34,22 @@ using ScriptBundle = std::unordered_map<std::string, data::script::Script>;
 ScriptBundle loadScripts(const std::string& scriptSource);
 
 
+/** Convert script bundle into a compact binary form, e.g. for caching
+ *
+ * The result is a flat sequence of opcodes (the action's index in the
+ * data::script::Action variant) followed by their operands. All strings are
+ * interned into a table stored up front, so that frequently repeated
+ * strings like image and palette file names are stored only once.
+ */
+ByteBuffer compileScripts(const ScriptBundle& bundle);
+
+/** Load script bundle previously produced by compileScripts()
+ *
+ * Throws an exception if the data is invalid.
+ */
+ScriptBundle loadCompiledScripts(base::ArrayView<std::uint8_t> data);
+
+
 data::LevelHints loadHintMessages(const std::string& scriptSource);
 
 } // namespace rigel::assets
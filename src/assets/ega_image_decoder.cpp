@@ -22,10 +22,21 @@
 #include "base/math_utils.hpp"
 #include "data/unit_conversions.hpp"
 
+#include <algorithm>
 #include <array>
 #include <cassert>
+#include <cstring>
 #include <stdexcept>
 
+#if defined(__SSE2__) || defined(_M_X64) || \
+  (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+  #include <emmintrin.h>
+  #define RIGEL_EGA_DECODER_SSE2
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+  #include <arm_neon.h>
+  #define RIGEL_EGA_DECODER_NEON
+#endif
+
 
 namespace rigel::assets
 {
@@ -72,31 +83,159 @@ SourceIter readEgaMaskPlane(
   return source;
 }
 
-/** Decode EGA color data (4 planes)
+// For each byte value, holds 8 bytes which are each 0 or 1, corresponding to
+// the bits of the value in order from most to least significant. This turns
+// one byte of a bit plane into one bit for each of 8 pixels.
+constexpr auto BIT_SPREAD_TABLE = []() {
+  std::array<std::array<std::uint8_t, 8>, 256> table{};
+
+  for (auto value = 0u; value < table.size(); ++value)
+  {
+    for (auto bit = 0u; bit < 8u; ++bit)
+    {
+      table[value][bit] = std::uint8_t((value >> (7u - bit)) & 1u);
+    }
+  }
+
+  return table;
+}();
+
+
+std::uint64_t spreadBits(const std::uint8_t value)
+{
+  std::uint64_t result;
+  std::memcpy(&result, BIT_SPREAD_TABLE[value].data(), sizeof(result));
+  return result;
+}
+
+
+/** Decode a single row of 8 pixels from 4 plane bytes into palette indices
  *
- * Pre-conditions:
- *   target points to zero-initialized buffer of bytes.
- *   target can be advanced pixelCount times.
- *   source can be advanced pixelCount*4 times.
+ * Shifting the spread bits never carries over into the neighboring byte, so
+ * all 8 pixels can be combined at once, independently of byte order.
  */
-template <typename SourceIter, typename TargetIter>
-SourceIter readEgaColorData(
-  SourceIter source,
-  TargetIter target,
-  const size_t pixelCount)
+void decodeEgaRow(const std::uint8_t* pPlanes, std::uint8_t* pIndices)
+{
+  const auto indices = spreadBits(pPlanes[0]) | (spreadBits(pPlanes[1]) << 1) |
+    (spreadBits(pPlanes[2]) << 2) | (spreadBits(pPlanes[3]) << 3);
+  std::memcpy(pIndices, &indices, sizeof(indices));
+}
+
+
+#if defined(RIGEL_EGA_DECODER_SSE2) || defined(RIGEL_EGA_DECODER_NEON)
+
+constexpr auto SIMD_BYTES = 16u;
+
+/** Transpose 16 bytes into 8 bit masks
+ *
+ * Bit i of result[j] is bit (7 - j) of the i-th input byte, i.e. the j-th
+ * pixel's bit in that byte. With several rows of planar data in the input,
+ * this gathers the color index of each pixel into adjacent bits.
+ */
+std::array<std::uint32_t, 8> transposeBits(const std::uint8_t* pBytes)
+{
+  std::array<std::uint32_t, 8> result;
+
+  #if defined(RIGEL_EGA_DECODER_SSE2)
+  const auto bytes =
+    _mm_loadu_si128(reinterpret_cast<const __m128i*>(pBytes));
+
+  for (auto pixel = 0; pixel < 8; ++pixel)
+  {
+    // Shifting 16-bit lanes moves each byte's bit of interest into the byte's
+    // top bit, without mixing in any bits from the neighboring byte.
+    const auto shifted = _mm_sll_epi16(bytes, _mm_cvtsi32_si128(pixel));
+    result[pixel] = std::uint32_t(_mm_movemask_epi8(shifted));
+  }
+  #else
+  static const std::int8_t bitPositions[] = {
+    0, 1, 2, 3, 4, 5, 6, 7, 0, 1, 2, 3, 4, 5, 6, 7};
+
+  const auto bytes = vld1q_u8(pBytes);
+  const auto positions = vld1q_s8(bitPositions);
+
+  for (auto pixel = 0; pixel < 8; ++pixel)
+  {
+    // NEON has no movemask, so isolate the bit of interest in each byte,
+    // move it to the byte's index within its half, and sum up each half.
+    const auto shifted = vshlq_u8(bytes, vdupq_n_s8(std::int8_t(pixel)));
+    const auto topBits = vshrq_n_u8(shifted, 7);
+    const auto positioned = vshlq_u8(topBits, positions);
+    result[pixel] = std::uint32_t(vaddv_u8(vget_low_u8(positioned))) |
+      (std::uint32_t(vaddv_u8(vget_high_u8(positioned))) << 8);
+  }
+  #endif
+
+  return result;
+}
+
+#endif
+
+
+/** Decode rows of 8 planar EGA pixels into palette indices and mask flags
+ *
+ * Each row consists of an optional mask byte, followed by one byte for each
+ * of the 4 color planes. Writes 8 indices per row to pIndices, and for
+ * masked data, 8 mask flags per row to pMask.
+ */
+void decodeEgaRows(
+  const std::uint8_t* pSource,
+  const std::size_t numRows,
+  const bool isMasked,
+  std::uint8_t* pIndices,
+  std::uint8_t* pMask)
 {
-  for (auto plane = 0u; plane < GameTraits::egaPlanes; ++plane)
+  const auto bytesPerRow =
+    isMasked ? GameTraits::maskedEgaPlanes : GameTraits::egaPlanes;
+  const auto planeOffset = isMasked ? 1u : 0u;
+
+  auto row = std::size_t{0};
+
+#if defined(RIGEL_EGA_DECODER_SSE2) || defined(RIGEL_EGA_DECODER_NEON)
+  // Handle as many complete rows as fit into one vector at a time. The last
+  // few rows are left to the scalar code, so that we never read past the
+  // end of the source data.
+  const auto rowsPerVector = SIMD_BYTES / bytesPerRow;
+
+  for (; row * bytesPerRow + SIMD_BYTES <= numRows * bytesPerRow;
+       row += rowsPerVector)
   {
-    auto targetIterForPlane = target;
+    const auto pixelBits = transposeBits(pSource + row * bytesPerRow);
 
-    for (auto pixel = 0u; pixel < pixelCount; ++pixel)
+    for (auto rowInVector = 0u; rowInVector < rowsPerVector; ++rowInVector)
     {
-      const auto planeBit = *source++;
-      *targetIterForPlane++ |= planeBit << plane;
+      const auto firstBit = rowInVector * bytesPerRow;
+      const auto pTargetIndices = pIndices + (row + rowInVector) * 8;
+
+      for (auto pixel = 0u; pixel < 8u; ++pixel)
+      {
+        pTargetIndices[pixel] =
+          std::uint8_t((pixelBits[pixel] >> (firstBit + planeOffset)) & 0xF);
+      }
+
+      if (isMasked)
+      {
+        const auto pTargetMask = pMask + (row + rowInVector) * 8;
+        for (auto pixel = 0u; pixel < 8u; ++pixel)
+        {
+          pTargetMask[pixel] = std::uint8_t((pixelBits[pixel] >> firstBit) & 1);
+        }
+      }
     }
   }
+#endif
 
-  return source;
+  for (; row < numRows; ++row)
+  {
+    const auto pRowData = pSource + row * bytesPerRow;
+    decodeEgaRow(pRowData + planeOffset, pIndices + row * 8);
+
+    if (isMasked)
+    {
+      const auto mask = spreadBits(pRowData[0]);
+      std::memcpy(pMask + row * 8, &mask, sizeof(mask));
+    }
+  }
 }
 
 
@@ -192,9 +331,21 @@ data::PixelBuffer decodeSimplePlanarEgaBuffer(
   const auto numPixels = static_cast<size_t>(numBytes / GameTraits::egaPlanes) *
     GameTraits::pixelsPerEgaByte;
 
-  BitWiseIterator<ByteBufferCIter> bitsIter(begin);
-  PalettizedPixelBuffer indexedPixels(numPixels, 0);
-  readEgaColorData(bitsIter, indexedPixels.begin(), numPixels);
+  // Unlike tiled images, the planes are stored one after the other here,
+  // so gather one byte of each plane to decode a group of 8 pixels.
+  const auto bytesPerPlane = numPixels / GameTraits::pixelsPerEgaByte;
+  const auto pSource = &*begin;
+
+  PalettizedPixelBuffer indexedPixels(numPixels);
+  for (auto i = 0u; i < bytesPerPlane; ++i)
+  {
+    const std::uint8_t planes[] = {
+      pSource[i],
+      pSource[i + bytesPerPlane],
+      pSource[i + bytesPerPlane * 2],
+      pSource[i + bytesPerPlane * 3]};
+    decodeEgaRow(planes, indexedPixels.data() + i * 8);
+  }
 
   return utils::transformed(indexedPixels, [&palette](const auto colorIndex) {
     return palette[colorIndex];
@@ -202,7 +353,7 @@ data::PixelBuffer decodeSimplePlanarEgaBuffer(
 }
 
 
-data::Image loadTiledImage(
+data::IndexedImage loadTiledIndexedImage(
   const ByteBufferCIter begin,
   const ByteBufferCIter end,
   std::size_t widthInTiles,
@@ -212,41 +363,81 @@ data::Image loadTiledImage(
   const auto heightInTiles =
     inferHeight(begin, end, widthInTiles, GameTraits::bytesPerTile(type));
 
-  auto pixels = decodeTiledEgaData(
-    begin,
-    widthInTiles,
-    heightInTiles,
-    [&palette, type](auto sourceBitsIter, const auto targetPixelIter) {
-      const auto isMasked = type == data::TileImageType::Masked;
-      array<bool, GameTraits::tileSize> pixelMask;
-      if (isMasked)
-      {
-        sourceBitsIter = readEgaMaskPlane(
-          sourceBitsIter, pixelMask.begin(), GameTraits::tileSize);
-      }
-
-      array<uint8_t, GameTraits::tileSize> indexedPixels;
-      indexedPixels.fill(0);
-      sourceBitsIter = readEgaColorData(
-        sourceBitsIter, indexedPixels.begin(), GameTraits::tileSize);
+  const auto isMasked = type == data::TileImageType::Masked;
+  const auto bytesPerRow = GameTraits::numPlanes(type);
+
+  // First decode all rows in the order they are stored, then arrange them
+  // into tiles. If the last row of tiles is incomplete, the missing tiles
+  // are left black.
+  const auto numRows =
+    widthInTiles * heightInTiles * size_t(GameTraits::tileSize);
+  const auto availableRows = size_t(distance(begin, end)) / bytesPerRow;
+  const auto rowsToDecode = std::min(numRows, availableRows);
+
+  PalettizedPixelBuffer indexedPixels(numRows * GameTraits::tileSize, 0);
+  PalettizedPixelBuffer pixelMask(
+    isMasked ? indexedPixels.size() : size_t{0}, 0);
+  if (rowsToDecode > 0)
+  {
+    decodeEgaRows(
+      &*begin,
+      rowsToDecode,
+      isMasked,
+      indexedPixels.data(),
+      pixelMask.data());
+  }
 
-      for (auto i = 0; i < GameTraits::tileSize; ++i)
-      {
-        *(targetPixelIter + i) = palette[indexedPixels[i]];
-      }
+  const auto targetBufferStride = tilesToPixels(widthInTiles);
+  data::IndexedPixelBuffer pixels(
+    widthInTiles * heightInTiles * GameTraits::tileSizeSquared);
 
-      if (isMasked)
+  auto sourceIndex = size_t{0};
+  for (auto row = 0u; row < heightInTiles; ++row)
+  {
+    for (auto col = 0u; col < widthInTiles; ++col)
+    {
+      for (size_t rowInTile = 0u; rowInTile < GameTraits::tileSize; ++rowInTile)
       {
-        applyEgaMask(pixelMask.begin(), targetPixelIter, GameTraits::tileSize);
+        const auto insertStart = tilesToPixels(col) +
+          (tilesToPixels(row) + rowInTile) * targetBufferStride;
+        const auto pTarget = pixels.data() + insertStart;
+
+        std::memcpy(
+          pTarget, indexedPixels.data() + sourceIndex, GameTraits::tileSize);
+
+        if (isMasked)
+        {
+          for (auto i = 0; i < GameTraits::tileSize; ++i)
+          {
+            if (pixelMask[sourceIndex + i])
+            {
+              pTarget[i] |= data::IndexedImage::TRANSPARENT_FLAG;
+            }
+          }
+        }
+
+        sourceIndex += GameTraits::tileSize;
       }
+    }
+  }
 
-      return sourceBitsIter;
-    });
-
-  return data::Image(
+  return data::IndexedImage(
     std::move(pixels),
     tilesToPixels(widthInTiles),
-    tilesToPixels(heightInTiles));
+    tilesToPixels(heightInTiles),
+    palette);
+}
+
+
+data::Image loadTiledImage(
+  const ByteBufferCIter begin,
+  const ByteBufferCIter end,
+  std::size_t widthInTiles,
+  const data::Palette16& palette,
+  const data::TileImageType type)
+{
+  return loadTiledIndexedImage(begin, end, widthInTiles, palette, type)
+    .toImage();
 }
 
 
@@ -16,6 +16,7 @@
 
 #include "file_utils.hpp"
 
+#include <algorithm>
 #include <cassert>
 #include <fstream>
 #include <stdexcept>
@@ -32,8 +33,37 @@ namespace
 
 const char* OUT_OF_DATA_ERROR_MSG = "No more data in stream";
 
+
+// The decodeX() functions don't do any bounds checking, the caller needs to
+// ensure that enough data is available.
+
+uint16_t decodeU16(const uint8_t* pData)
+{
+  return static_cast<uint16_t>(pData[0] | (pData[1] << 8));
+}
+
+
+uint32_t decodeU24(const uint8_t* pData)
+{
+  return pData[0] | (pData[1] << 8) | (pData[2] << 16);
+}
+
+
+uint32_t decodeU32(const uint8_t* pData)
+{
+  return decodeU16(pData) | (uint32_t(decodeU16(pData + 2)) << 16);
+}
+
+
+int32_t signExtend24(const uint32_t rawValue)
+{
+  static_assert(static_cast<int8_t>(0xFFU) == -1, "Need two's complement");
+  const auto extension = (rawValue & 0x800000) ? 0xFFU : 0x00U;
+  return static_cast<int32_t>((extension << 24) | (rawValue & 0xFFFFFF));
 }
 
+} // namespace
+
 
 std::optional<ByteBuffer> tryLoadFile(const std::filesystem::path& path)
 {
@@ -87,52 +117,51 @@ std::string asText(const ByteBuffer& buffer)
 }
 
 
-LeStreamReader::LeStreamReader(const ByteBuffer& data)
-  : LeStreamReader(data.begin(), data.end())
+LeStreamReader::LeStreamReader(const base::ArrayView<std::uint8_t> data)
+  : mpCurrentByte(data.begin())
+  , mpDataEnd(data.end())
 {
 }
 
 
 LeStreamReader::LeStreamReader(ByteBufferCIter begin, ByteBufferCIter end)
-  : mCurrentByteIter(begin)
-  , mDataEnd(end)
+  : mpCurrentByte(begin == end ? nullptr : &*begin)
+  , mpDataEnd(mpCurrentByte + distance(begin, end))
 {
 }
 
 
 uint8_t LeStreamReader::readU8()
 {
-  if (mCurrentByteIter == mDataEnd)
+  if (mpCurrentByte == mpDataEnd)
   {
     throw runtime_error(OUT_OF_DATA_ERROR_MSG);
   }
-  return *mCurrentByteIter++;
+  return *mpCurrentByte++;
 }
 
 
 uint16_t LeStreamReader::readU16()
 {
-  const auto lsb = readU8();
-  const auto msb = readU8();
-  return lsb | uint16_t(msb << 8);
+  const auto value = peekU16();
+  mpCurrentByte += 2;
+  return value;
 }
 
 
 uint32_t LeStreamReader::readU24()
 {
-  const auto lsb = readU8();
-  const auto middle = readU8();
-  const auto msb = readU8();
-
-  return lsb | (middle << 8) | (msb << 16);
+  const auto value = peekU24();
+  mpCurrentByte += 3;
+  return value;
 }
 
 
 uint32_t LeStreamReader::readU32()
 {
-  const auto lowWord = readU16();
-  const auto highWord = readU16();
-  return lowWord | (highWord << 16);
+  const auto value = peekU32();
+  mpCurrentByte += 4;
+  return value;
 }
 
 
@@ -150,10 +179,7 @@ int16_t LeStreamReader::readS16()
 
 int32_t LeStreamReader::readS24()
 {
-  static_assert(static_cast<int8_t>(0xFFU) == -1, "Need two's complement");
-  const auto rawValue = readU24();
-  const auto extension = (rawValue & 0x800000) ? 0xFF : 0x00;
-  return static_cast<int32_t>((extension << 24) | (rawValue & 0xFFFFFF));
+  return signExtend24(readU24());
 }
 
 
@@ -163,103 +189,131 @@ int32_t LeStreamReader::readS32()
 }
 
 
-template <typename Callable>
-auto LeStreamReader::withPreservingCurrentIter(Callable func)
-{
-  const auto currentIter = mCurrentByteIter;
-  const auto result = func();
-  mCurrentByteIter = currentIter;
-  return result;
-}
-
-
 uint8_t LeStreamReader::peekU8()
 {
-  return withPreservingCurrentIter([this]() { return readU8(); });
+  ensureAvailable(1);
+  return *mpCurrentByte;
 }
 
 
 uint16_t LeStreamReader::peekU16()
 {
-  return withPreservingCurrentIter([this]() { return readU16(); });
+  ensureAvailable(2);
+  return decodeU16(mpCurrentByte);
 }
 
 
 uint32_t LeStreamReader::peekU24()
 {
-  return withPreservingCurrentIter([this]() { return readU24(); });
+  ensureAvailable(3);
+  return decodeU24(mpCurrentByte);
 }
 
 
 uint32_t LeStreamReader::peekU32()
 {
-  return withPreservingCurrentIter([this]() { return readU32(); });
+  ensureAvailable(4);
+  return decodeU32(mpCurrentByte);
 }
 
 
 int8_t LeStreamReader::peekS8()
 {
-  return withPreservingCurrentIter([this]() { return readS8(); });
+  return static_cast<int8_t>(peekU8());
 }
 
 
 int16_t LeStreamReader::peekS16()
 {
-  return withPreservingCurrentIter([this]() { return readS16(); });
+  return static_cast<int16_t>(peekU16());
 }
 
 
 int32_t LeStreamReader::peekS24()
 {
-  return withPreservingCurrentIter([this]() { return readS24(); });
+  return signExtend24(peekU24());
 }
 
 
 int32_t LeStreamReader::peekS32()
 {
-  return withPreservingCurrentIter([this]() { return readS32(); });
+  return static_cast<int32_t>(peekU32());
 }
 
 
-void LeStreamReader::skipBytes(const size_t count)
+vector<uint16_t> LeStreamReader::readU16Array(const size_t count)
 {
-  assert(distance(mCurrentByteIter, mDataEnd) >= 0);
-  const auto availableBytes =
-    static_cast<size_t>(distance(mCurrentByteIter, mDataEnd));
-  if (availableBytes < count)
+  if (count > availableBytes() / sizeof(uint16_t))
   {
     throw runtime_error(OUT_OF_DATA_ERROR_MSG);
   }
 
-  advance(mCurrentByteIter, count);
+  vector<uint16_t> result;
+  result.reserve(count);
+
+  for (size_t i = 0; i < count; ++i)
+  {
+    result.push_back(decodeU16(mpCurrentByte));
+    mpCurrentByte += 2;
+  }
+
+  return result;
+}
+
+
+void LeStreamReader::skipBytes(const size_t count)
+{
+  ensureAvailable(count);
+  mpCurrentByte += count;
 }
 
 
 bool LeStreamReader::hasData() const
 {
-  return mCurrentByteIter != mDataEnd;
+  return mpCurrentByte != mpDataEnd;
 }
 
 
-ByteBufferCIter LeStreamReader::currentIter() const
+base::ArrayView<uint8_t> LeStreamReader::peekBytes(const size_t count) const
 {
-  return mCurrentByteIter;
+  ensureAvailable(count);
+
+  return base::ArrayView<uint8_t>{
+    mpCurrentByte, static_cast<base::ArrayView<uint8_t>::size_type>(count)};
 }
 
 
-string readFixedSizeString(LeStreamReader& reader, const size_t len)
+base::ArrayView<uint8_t> LeStreamReader::readBytes(const size_t count)
 {
-  vector<char> characters;
-  for (size_t i = 0; i < len; ++i)
+  const auto bytes = peekBytes(count);
+  mpCurrentByte += count;
+  return bytes;
+}
+
+
+void LeStreamReader::ensureAvailable(const size_t count) const
+{
+  if (availableBytes() < count)
   {
-    characters.push_back(static_cast<char>(reader.readU8()));
+    throw runtime_error(OUT_OF_DATA_ERROR_MSG);
   }
+}
+
 
-  // Ensure string is zero-terminated
-  characters.push_back(0);
+size_t LeStreamReader::availableBytes() const
+{
+  assert(mpDataEnd >= mpCurrentByte);
+  return static_cast<size_t>(mpDataEnd - mpCurrentByte);
+}
+
+
+string readFixedSizeString(LeStreamReader& reader, const size_t len)
+{
+  const auto bytes = reader.readBytes(len);
 
-  // Let std::string's ctor handle the zero-terminator detection
-  return string(characters.data());
+  // The string ends at the first zero byte, if there is one
+  const auto iEnd = std::find(bytes.begin(), bytes.end(), uint8_t{0});
+  return string(bytes.begin(), iEnd);
 }
 
 } // namespace rigel::assets
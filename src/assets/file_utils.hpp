@@ -17,11 +17,13 @@
 #pragma once
 
 #include "assets/byte_buffer.hpp"
+#include "base/array_view.hpp"
 
 #include <cstdint>
 #include <filesystem>
 #include <optional>
 #include <string>
+#include <vector>
 
 
 namespace rigel::assets
@@ -50,11 +52,15 @@ std::string asText(const ByteBuffer& buffer);
 /** Offers checked reading of little-endian data from a byte buffer
  *
  * All readX() methods will throw if there is not enough data left.
+ * The reader doesn't own the data, it must outlive the reader.
+ *
+ * Bulk reads only check the available size once, so they should be preferred
+ * over reading values one by one in a loop where possible.
  */
 class LeStreamReader
 {
 public:
-  explicit LeStreamReader(const ByteBuffer& data);
+  explicit LeStreamReader(base::ArrayView<std::uint8_t> data);
   LeStreamReader(ByteBufferCIter begin, ByteBufferCIter end);
 
   std::uint8_t readU8();
@@ -79,20 +85,61 @@ public:
   std::int32_t peekS24();
   std::int32_t peekS32();
 
+  /** Read count 16bit little-endian words */
+  std::vector<std::uint16_t> readU16Array(std::size_t count);
+
   void skipBytes(std::size_t count);
   bool hasData() const;
-  ByteBufferCIter currentIter() const;
+
+  /** Returns the next count bytes without consuming them */
+  base::ArrayView<std::uint8_t> peekBytes(std::size_t count) const;
+
+  /** Returns the next count bytes and consumes them
+   *
+   * The returned view refers to the reader's underlying data.
+   */
+  base::ArrayView<std::uint8_t> readBytes(std::size_t count);
 
 private:
-  template <typename Callable>
-  auto withPreservingCurrentIter(Callable func);
+  void ensureAvailable(std::size_t count) const;
+  std::size_t availableBytes() const;
 
-  ByteBufferCIter mCurrentByteIter;
-  const ByteBufferCIter mDataEnd;
+  const std::uint8_t* mpCurrentByte;
+  const std::uint8_t* const mpDataEnd;
 };
 
 
 std::string readFixedSizeString(LeStreamReader& reader, std::size_t len);
 
 
+/** Counterpart to LeStreamReader, appends little-endian data to a buffer */
+class LeStreamWriter
+{
+public:
+  void writeU8(const std::uint8_t value) { mBuffer.push_back(value); }
+
+  void writeU16(const std::uint16_t value)
+  {
+    writeU8(std::uint8_t(value & 0xFF));
+    writeU8(std::uint8_t(value >> 8));
+  }
+
+  void writeU32(const std::uint32_t value)
+  {
+    writeU16(std::uint16_t(value & 0xFFFF));
+    writeU16(std::uint16_t(value >> 16));
+  }
+
+  void writeBytes(const base::ArrayView<std::uint8_t> bytes)
+  {
+    mBuffer.insert(mBuffer.end(), bytes.begin(), bytes.end());
+  }
+
+  const ByteBuffer& buffer() const { return mBuffer; }
+
+private:
+  ByteBuffer mBuffer;
+};
+
+
 } // namespace rigel::assets
@@ -20,8 +20,8 @@
 #include "assets/file_utils.hpp"
 #include "assets/resource_loader.hpp"
 #include "assets/rle_compression.hpp"
+#include "base/arena.hpp"
 #include "base/container_utils.hpp"
-#include "base/grid.hpp"
 #include "base/math_utils.hpp"
 #include "base/string_utils.hpp"
 #include "data/game_traits.hpp"
@@ -29,8 +29,11 @@
 
 #include <algorithm>
 #include <array>
+#include <numeric>
 #include <string>
+#include <tuple>
 #include <type_traits>
+#include <vector>
 
 
 /* Duke Nukem II level loader
@@ -61,6 +64,10 @@ namespace
 
 using ActorList = std::vector<LevelData::Actor>;
 
+// Intermediate data that only lives while loading a level is allocated from
+// an arena, see loadLevel().
+using TransientActorList = base::ArenaVector<LevelData::Actor>;
+
 
 constexpr char EPISODE_PREFIXES[] = {'L', 'M', 'N', 'O'};
 constexpr auto VALID_LEVEL_WIDTHS = std::array{32, 64, 128, 256, 512, 1024};
@@ -104,17 +111,18 @@ struct LevelHeader
 };
 
 
-ByteBuffer readExtraMaskedTileBits(const LeStreamReader& levelReader)
+base::ArenaVector<uint8_t> readExtraMaskedTileBits(
+  const LeStreamReader& levelReader,
+  base::Arena& arena)
 {
   LeStreamReader extraInfoReader(levelReader);
   extraInfoReader.skipBytes(GameTraits::mapDataWords * sizeof(uint16_t));
   const auto extraInfoSize = extraInfoReader.readU16();
 
-  LeStreamReader rleReader(
-    extraInfoReader.currentIter(),
-    extraInfoReader.currentIter() + extraInfoSize);
+  LeStreamReader rleReader(extraInfoReader.peekBytes(extraInfoSize));
 
-  ByteBuffer maskedTileOffsets;
+  base::ArenaVector<uint8_t> maskedTileOffsets{
+    base::ArenaAllocator<uint8_t>{&arena}};
   // The uncompressed masked tile extra bits contain 2 bits for each tile, so
   // we need one byte to represent 4 tiles.
   maskedTileOffsets.reserve(
@@ -137,72 +145,103 @@ std::string backdropNameFromNumber(const uint8_t backdropNumber)
 }
 
 
-/** Creates 2d grid of actor descriptions in a level
+/** Index of a level's actor descriptions by position
+ *
+ * Some meta actors have spatial relations to others, e.g. difficulty markers
+ * apply to the actor to their right. The index keeps actors sorted by
+ * position in row-major order, plus a column-major ordering on top, so that
+ * these relations can be resolved via binary search. Only positions which
+ * are actually occupied by an actor take up any memory.
  *
- * Takes a linear list of actor descriptions, and puts them into a 2d grid.
- * This is useful since some meta actors have spatial relations to others.
+ * If multiple actors share a position, only the last one in the list is
+ * kept.
  */
-auto makeActorGrid(const data::map::Map& map, const ActorList& actors)
-{
-  base::Grid<const LevelData::Actor*> actorGrid(map.width(), map.height());
-
-  for (const auto& actor : actors)
-  {
-    actorGrid.setValueAt(actor.mPosition.x, actor.mPosition.y, &actor);
-  }
-  return actorGrid;
-}
-
-
-class ActorGrid
+class ActorIndex
 {
 public:
-  ActorGrid(const data::map::Map& map, const ActorList& actors)
-    : mActorGrid(makeActorGrid(map, actors))
+  ActorIndex(const TransientActorList& actors, base::Arena& arena)
+    : mEntries(base::ArenaAllocator<Entry>{&arena})
+    , mColumnOrder(base::ArenaAllocator<std::size_t>{&arena})
   {
-  }
+    mEntries.reserve(actors.size());
+    for (const auto& actor : actors)
+    {
+      mEntries.push_back(Entry{actor.mPosition, &actor});
+    }
 
-  const LevelData::Actor& actorAt(const size_t col, const size_t row) const
-  {
-    return *mActorGrid.valueAt(col, row);
+    std::stable_sort(
+      mEntries.begin(),
+      mEntries.end(),
+      [](const Entry& lhs, const Entry& rhs) {
+        return isBeforeInRow(lhs.mPosition, rhs.mPosition);
+      });
+
+    // Sorting is stable, so among actors sharing a position, the last one
+    // in the list comes last. Deduplicating in reverse keeps that one.
+    const auto iFirstKept = std::unique(
+      mEntries.rbegin(), mEntries.rend(), [](const Entry& a, const Entry& b) {
+        return a.mPosition == b.mPosition;
+      });
+    mEntries.erase(mEntries.begin(), iFirstKept.base());
+
+    mColumnOrder.resize(mEntries.size());
+    std::iota(mColumnOrder.begin(), mColumnOrder.end(), std::size_t{0});
+    std::sort(
+      mColumnOrder.begin(),
+      mColumnOrder.end(),
+      [this](const std::size_t lhs, const std::size_t rhs) {
+        return isBeforeInColumn(
+          mEntries[lhs].mPosition, mEntries[rhs].mPosition);
+      });
   }
 
-  bool hasActorAt(const size_t col, const size_t row) const
+  /** Number of positions covered by the index, in row-major order */
+  std::size_t size() const { return mEntries.size(); }
+
+  /** Actor at the given index, or nullptr if it was removed */
+  const LevelData::Actor* actorAt(const std::size_t index) const
   {
-    return mActorGrid.valueAt(col, row) != nullptr;
+    return mEntries[index].mpActor;
   }
 
-  void removeActorAt(const size_t col, const size_t row)
+  void removeActorAt(const base::Vec2& position)
   {
-    mActorGrid.setValueAt(col, row, nullptr);
+    const auto iEntry = firstAtOrAfterInRow(position);
+    if (iEntry != mEntries.end() && iEntry->mPosition == position)
+    {
+      iEntry->mpActor = nullptr;
+    }
   }
 
   std::optional<base::Rect<int>>
     findTileSectionRect(const int startCol, const int startRow)
   {
-    for (auto x = startCol; x < int(mActorGrid.width()); ++x)
+    for (auto iTopRight = firstAtOrAfterInRow({startCol, startRow});
+         iTopRight != mEntries.end() && iTopRight->mPosition.y == startRow;
+         ++iTopRight)
     {
-      auto pTopRightMarkerCandidate = mActorGrid.valueAt(x, startRow);
-
       if (
-        pTopRightMarkerCandidate &&
-        pTopRightMarkerCandidate->mID ==
-          ActorID::META_Dynamic_geometry_marker_1)
+        iTopRight->mpActor &&
+        iTopRight->mpActor->mID == ActorID::META_Dynamic_geometry_marker_1)
       {
-        const auto rightCol = pTopRightMarkerCandidate->mPosition.x;
+        const auto rightCol = iTopRight->mPosition.x;
 
-        for (auto y = startRow + 1; y < int(mActorGrid.height()); ++y)
+        for (auto iBottomRight =
+               firstAtOrAfterInColumn({rightCol, startRow + 1});
+             iBottomRight != mColumnOrder.end() &&
+             mEntries[*iBottomRight].mPosition.x == rightCol;
+             ++iBottomRight)
         {
-          auto pBottomRightMarkerCandidate = mActorGrid.valueAt(rightCol, y);
+          auto& bottomRight = mEntries[*iBottomRight];
 
           if (
-            pBottomRightMarkerCandidate &&
-            pBottomRightMarkerCandidate->mID ==
+            bottomRight.mpActor &&
+            bottomRight.mpActor->mID ==
               ActorID::META_Dynamic_geometry_marker_2)
           {
-            const auto bottomRow = y;
-            removeActorAt(rightCol, startRow);
-            removeActorAt(rightCol, bottomRow);
+            const auto bottomRow = bottomRight.mPosition.y;
+            iTopRight->mpActor = nullptr;
+            bottomRight.mpActor = nullptr;
 
             return base::Rect<int>{
               {startCol, startRow},
@@ -216,7 +255,50 @@ public:
   }
 
 private:
-  base::Grid<const LevelData::Actor*> mActorGrid;
+  struct Entry
+  {
+    base::Vec2 mPosition;
+    const LevelData::Actor* mpActor;
+  };
+
+  static bool isBeforeInRow(const base::Vec2& lhs, const base::Vec2& rhs)
+  {
+    return std::tie(lhs.y, lhs.x) < std::tie(rhs.y, rhs.x);
+  }
+
+  static bool isBeforeInColumn(const base::Vec2& lhs, const base::Vec2& rhs)
+  {
+    return std::tie(lhs.x, lhs.y) < std::tie(rhs.x, rhs.y);
+  }
+
+  using EntryList = base::ArenaVector<Entry>;
+  using IndexList = base::ArenaVector<std::size_t>;
+
+  EntryList::iterator firstAtOrAfterInRow(const base::Vec2& position)
+  {
+    return std::lower_bound(
+      mEntries.begin(),
+      mEntries.end(),
+      position,
+      [](const Entry& entry, const base::Vec2& pos) {
+        return isBeforeInRow(entry.mPosition, pos);
+      });
+  }
+
+  IndexList::const_iterator
+    firstAtOrAfterInColumn(const base::Vec2& position) const
+  {
+    return std::lower_bound(
+      mColumnOrder.begin(),
+      mColumnOrder.end(),
+      position,
+      [this](const std::size_t index, const base::Vec2& pos) {
+        return isBeforeInColumn(mEntries[index].mPosition, pos);
+      });
+  }
+
+  EntryList mEntries;
+  IndexList mColumnOrder;
 };
 
 
@@ -417,80 +499,82 @@ bool isValidActorId(const uint16_t id)
  * the list (difficulty markers and section markers, player).
  */
 std::tuple<ActorList, base::Vec2, bool> preProcessActorDescriptions(
-  const data::map::Map& map,
-  const ActorList& originalActors,
-  const Difficulty chosenDifficulty)
+  const TransientActorList& originalActors,
+  const Difficulty chosenDifficulty,
+  base::Arena& arena)
 {
   ActorList actors;
   base::Vec2 playerSpawnPosition;
   bool playerFacingLeft = false;
 
-  ActorGrid grid(map, originalActors);
-  for (int row = 0; row < map.height(); ++row)
+  // Actors are visited in row-major order, so markers always come before
+  // the actors they refer to, and removing an actor from the index makes sure
+  // that it's skipped when we get to it.
+  ActorIndex index(originalActors, arena);
+  for (auto i = std::size_t{0}; i < index.size(); ++i)
   {
-    for (int col = 0; col < map.width(); ++col)
+    const auto pActor = index.actorAt(i);
+    if (!pActor)
     {
-      if (!grid.hasActorAt(col, row))
+      continue;
+    }
+
+    const auto& actor = *pActor;
+    const auto col = actor.mPosition.x;
+    const auto row = actor.mPosition.y;
+
+    auto applyDifficultyMarker = [&index, col, row, chosenDifficulty](
+                                   const Difficulty requiredDifficulty) {
+      const auto targetCol = col + 1;
+      if (chosenDifficulty < requiredDifficulty)
       {
-        continue;
+        index.removeActorAt({targetCol, row});
       }
+    };
 
-      auto applyDifficultyMarker = [&grid, col, row, chosenDifficulty](
-                                     const Difficulty requiredDifficulty) {
-        const auto targetCol = col + 1;
-        if (chosenDifficulty < requiredDifficulty)
+    switch (actor.mID)
+    {
+      case ActorID::META_Appear_only_in_med_hard_difficulty:
+        applyDifficultyMarker(Difficulty::Medium);
+        break;
+
+      case ActorID::META_Appear_only_in_hard_difficulty:
+        applyDifficultyMarker(Difficulty::Hard);
+        break;
+
+      case ActorID::META_Dynamic_geometry_marker_1:
+      case ActorID::META_Dynamic_geometry_marker_2:
+        // stray tile section marker, ignore
+        break;
+
+      case ActorID::Dynamic_geometry_1:
+      case ActorID::Dynamic_geometry_2:
+      case ActorID::Dynamic_geometry_3:
+      case ActorID::Dynamic_geometry_4:
+      case ActorID::Dynamic_geometry_5:
+      case ActorID::Dynamic_geometry_6:
+      case ActorID::Dynamic_geometry_7:
+      case ActorID::Dynamic_geometry_8:
         {
-          grid.removeActorAt(targetCol, row);
-        }
-      };
-
-      const auto& actor = grid.actorAt(col, row);
-      switch (actor.mID)
-      {
-        case ActorID::META_Appear_only_in_med_hard_difficulty:
-          applyDifficultyMarker(Difficulty::Medium);
-          break;
-
-        case ActorID::META_Appear_only_in_hard_difficulty:
-          applyDifficultyMarker(Difficulty::Hard);
-          break;
-
-        case ActorID::META_Dynamic_geometry_marker_1:
-        case ActorID::META_Dynamic_geometry_marker_2:
-          // stray tile section marker, ignore
-          break;
-
-        case ActorID::Dynamic_geometry_1:
-        case ActorID::Dynamic_geometry_2:
-        case ActorID::Dynamic_geometry_3:
-        case ActorID::Dynamic_geometry_4:
-        case ActorID::Dynamic_geometry_5:
-        case ActorID::Dynamic_geometry_6:
-        case ActorID::Dynamic_geometry_7:
-        case ActorID::Dynamic_geometry_8:
+          auto tileSection = index.findTileSectionRect(col, row);
+          if (tileSection)
           {
-            auto tileSection = grid.findTileSectionRect(col, row);
-            if (tileSection)
-            {
-              actors.emplace_back(
-                LevelData::Actor{actor.mPosition, actor.mID, tileSection});
-            }
+            actors.emplace_back(
+              LevelData::Actor{actor.mPosition, actor.mID, tileSection});
           }
-          break;
-
-        case ActorID::Duke_LEFT:
-        case ActorID::Duke_RIGHT:
-          playerSpawnPosition = actor.mPosition;
-          playerFacingLeft = actor.mID == ActorID::Duke_LEFT;
-          break;
-
-        default:
-          actors.emplace_back(
-            LevelData::Actor{actor.mPosition, actor.mID, std::nullopt});
-          break;
-      }
-
-      grid.removeActorAt(col, row);
+        }
+        break;
+
+      case ActorID::Duke_LEFT:
+      case ActorID::Duke_RIGHT:
+        playerSpawnPosition = actor.mPosition;
+        playerFacingLeft = actor.mID == ActorID::Duke_LEFT;
+        break;
+
+      default:
+        actors.emplace_back(
+          LevelData::Actor{actor.mPosition, actor.mID, std::nullopt});
+        break;
     }
   }
 
@@ -548,11 +632,16 @@ LevelData loadLevel(
   const ResourceLoader& resources,
   const Difficulty chosenDifficulty)
 {
-  const auto levelData = resources.file(mapName);
-  LeStreamReader levelReader(levelData);
+  const auto levelFile = resources.fileView(mapName);
+  LeStreamReader levelReader(levelFile.data());
+
+  // Backs all temporary containers used during loading. Its size covers
+  // typical levels without needing a second block.
+  base::Arena arena{256 * 1024};
 
   LevelHeader header(levelReader);
-  ActorList actors;
+  TransientActorList actors{base::ArenaAllocator<LevelData::Actor>{&arena}};
+  actors.reserve(header.numActorWords / 3u);
   for (size_t i = 0; i < header.numActorWords / 3u; ++i)
   {
     const auto type = levelReader.readU16();
@@ -564,6 +653,18 @@ LevelData loadLevel(
     }
   }
 
+  const auto hasAlternativeBackdrop =
+    header.flagBitSet(0x40) || header.flagBitSet(0x80);
+
+  auto backdropNames = std::vector<std::string>{header.backdrop};
+  if (hasAlternativeBackdrop)
+  {
+    backdropNames.push_back(
+      backdropNameFromNumber(header.alternativeBackdropNumber));
+  }
+
+  resources.prefetchLevelImages(header.CZone, backdropNames);
+
   auto tileSet = resources.loadCZone(header.CZone);
 
   const auto width = static_cast<int>(levelReader.readU16());
@@ -577,7 +678,7 @@ LevelData loadLevel(
   const auto height = static_cast<int>(GameTraits::mapHeightForWidth(width));
   data::map::Map map(width, height, std::move(tileSet.mAttributes));
 
-  const auto maskedTileOffsets = readExtraMaskedTileBits(levelReader);
+  const auto maskedTileOffsets = readExtraMaskedTileBits(levelReader, arena);
   auto lookupExtraMaskedTileBits =
     [&maskedTileOffsets, width, height](const int x, const int y) {
       const auto index = x / 4 + y * (width / 4);
@@ -591,13 +692,14 @@ LevelData loadLevel(
     };
 
   LeStreamReader tileDataReader(
-    levelReader.currentIter(),
-    levelReader.currentIter() + width * height * sizeof(uint16_t));
+    levelReader.peekBytes(width * height * sizeof(uint16_t)));
+  const auto tileSpecs = tileDataReader.readU16Array(width * height);
+  auto iTileSpec = tileSpecs.begin();
   for (int y = 0; y < height; ++y)
   {
     for (int x = 0; x < width; ++x)
     {
-      const auto tileSpec = tileDataReader.readU16();
+      const auto tileSpec = *iTileSpec++;
 
       if (tileSpec & 0x8000)
       {
@@ -653,16 +755,15 @@ LevelData loadLevel(
     }
   }
 
-  auto backdropImage = resources.loadBackdrop(header.backdrop);
+  auto backdropImage = resources.loadBackdrop(backdropNames[0]);
   std::optional<data::Image> alternativeBackdropImage;
-  if (header.flagBitSet(0x40) || header.flagBitSet(0x80))
+  if (hasAlternativeBackdrop)
   {
-    alternativeBackdropImage = resources.loadBackdrop(
-      backdropNameFromNumber(header.alternativeBackdropNumber));
+    alternativeBackdropImage = resources.loadBackdrop(backdropNames[1]);
   }
 
   auto [actorDescriptions, playerSpawnPosition, playerFacingLeft] =
-    preProcessActorDescriptions(map, actors, chosenDifficulty);
+    preProcessActorDescriptions(actors, chosenDifficulty, arena);
   sortByDrawIndex(actorDescriptions, resources);
 
   return LevelData{
@@ -0,0 +1,214 @@
+/* Copyright (C) 2022, Nikolai Wuttke. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "memory_mapped_file.hpp"
+
+#include "assets/file_utils.hpp"
+
+#include <limits>
+#include <optional>
+#include <stdexcept>
+#include <utility>
+
+#if defined(_WIN32)
+  #define RIGEL_MEMORY_MAPPING_WIN32 1
+
+  #define NOMINMAX
+  #define WIN32_LEAN_AND_MEAN
+  #include <windows.h>
+#elif defined(__unix__) || defined(__APPLE__)
+  #define RIGEL_MEMORY_MAPPING_POSIX 1
+
+  #include <fcntl.h>
+  #include <sys/mman.h>
+  #include <sys/stat.h>
+  #include <unistd.h>
+#endif
+
+
+namespace rigel::assets
+{
+
+namespace
+{
+
+struct Mapping
+{
+  void* mpAddress = nullptr;
+  std::size_t mSize = 0;
+};
+
+
+#if defined(RIGEL_MEMORY_MAPPING_WIN32)
+
+std::optional<Mapping> mapFile(const std::filesystem::path& path)
+{
+  const auto fileHandle = CreateFileW(
+    path.c_str(),
+    GENERIC_READ,
+    FILE_SHARE_READ,
+    nullptr,
+    OPEN_EXISTING,
+    FILE_ATTRIBUTE_NORMAL,
+    nullptr);
+  if (fileHandle == INVALID_HANDLE_VALUE)
+  {
+    return std::nullopt;
+  }
+
+  auto mapping = std::optional<Mapping>{};
+
+  LARGE_INTEGER fileSize;
+  if (GetFileSizeEx(fileHandle, &fileSize) && fileSize.QuadPart > 0)
+  {
+    const auto mappingHandle =
+      CreateFileMappingW(fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mappingHandle)
+    {
+      // The view keeps the file mapping alive, so both handles can be
+      // closed right away.
+      if (const auto pView =
+            MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0))
+      {
+        mapping = Mapping{pView, std::size_t(fileSize.QuadPart)};
+      }
+
+      CloseHandle(mappingHandle);
+    }
+  }
+
+  CloseHandle(fileHandle);
+  return mapping;
+}
+
+
+void unmapFile(const Mapping& mapping)
+{
+  UnmapViewOfFile(mapping.mpAddress);
+}
+
+#elif defined(RIGEL_MEMORY_MAPPING_POSIX)
+
+std::optional<Mapping> mapFile(const std::filesystem::path& path)
+{
+  const auto fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0)
+  {
+    return std::nullopt;
+  }
+
+  auto mapping = std::optional<Mapping>{};
+
+  struct stat fileInfo;
+  if (fstat(fd, &fileInfo) == 0 && fileInfo.st_size > 0)
+  {
+    const auto size = std::size_t(fileInfo.st_size);
+    const auto pAddress = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (pAddress != MAP_FAILED)
+    {
+      mapping = Mapping{pAddress, size};
+    }
+  }
+
+  // The mapping stays valid after closing the file descriptor
+  close(fd);
+  return mapping;
+}
+
+
+void unmapFile(const Mapping& mapping)
+{
+  munmap(mapping.mpAddress, mapping.mSize);
+}
+
+#else
+
+std::optional<Mapping> mapFile(const std::filesystem::path&)
+{
+  return std::nullopt;
+}
+
+
+void unmapFile(const Mapping&) {}
+
+#endif
+
+} // namespace
+
+
+MemoryMappedFile::MemoryMappedFile(const std::filesystem::path& path)
+{
+  if (const auto mapping = mapFile(path))
+  {
+    if (mapping->mSize > std::numeric_limits<std::uint32_t>::max())
+    {
+      unmapFile(*mapping);
+      throw std::runtime_error("File too large: " + path.u8string());
+    }
+
+    mpMapping = mapping->mpAddress;
+    mData = base::ArrayView<std::uint8_t>{
+      static_cast<const std::uint8_t*>(mapping->mpAddress),
+      static_cast<std::uint32_t>(mapping->mSize)};
+  }
+  else
+  {
+    // Memory mapping isn't supported, or the file is empty (which can't be
+    // mapped)
+    mFallbackBuffer = loadFile(path);
+    mData = mFallbackBuffer;
+  }
+}
+
+
+MemoryMappedFile::~MemoryMappedFile()
+{
+  unmap();
+}
+
+
+MemoryMappedFile::MemoryMappedFile(MemoryMappedFile&& other) noexcept
+  : mFallbackBuffer(std::move(other.mFallbackBuffer))
+  , mpMapping(std::exchange(other.mpMapping, nullptr))
+  , mData(std::exchange(other.mData, {}))
+{
+}
+
+
+MemoryMappedFile& MemoryMappedFile::operator=(MemoryMappedFile&& other) noexcept
+{
+  if (this != &other)
+  {
+    unmap();
+    mFallbackBuffer = std::move(other.mFallbackBuffer);
+    mpMapping = std::exchange(other.mpMapping, nullptr);
+    mData = std::exchange(other.mData, {});
+  }
+
+  return *this;
+}
+
+
+void MemoryMappedFile::unmap()
+{
+  if (mpMapping)
+  {
+    unmapFile(Mapping{mpMapping, mData.size()});
+    mpMapping = nullptr;
+  }
+}
+
+} // namespace rigel::assets
@@ -0,0 +1,61 @@
+/* Copyright (C) 2022, Nikolai Wuttke. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "assets/byte_buffer.hpp"
+#include "base/array_view.hpp"
+
+#include <cstdint>
+#include <filesystem>
+
+
+namespace rigel::assets
+{
+
+/** Read-only view of a file's entire contents
+ *
+ * Maps the file into memory where supported by the platform, so that its
+ * contents are only paged in when accessed, and are shared with the OS file
+ * cache instead of occupying heap memory. On other platforms, the file is
+ * loaded into a buffer owned by this object.
+ *
+ * Throws an exception if the file can't be opened.
+ */
+class MemoryMappedFile
+{
+public:
+  explicit MemoryMappedFile(const std::filesystem::path& path);
+  ~MemoryMappedFile();
+
+  MemoryMappedFile(MemoryMappedFile&& other) noexcept;
+  MemoryMappedFile& operator=(MemoryMappedFile&& other) noexcept;
+  MemoryMappedFile(const MemoryMappedFile&) = delete;
+  MemoryMappedFile& operator=(const MemoryMappedFile&) = delete;
+
+  base::ArrayView<std::uint8_t> data() const { return mData; }
+  bool isMapped() const { return mpMapping != nullptr; }
+
+private:
+  void unmap();
+
+  // Only used when memory mapping isn't possible
+  ByteBuffer mFallbackBuffer;
+  void* mpMapping = nullptr;
+  base::ArrayView<std::uint8_t> mData;
+};
+
+} // namespace rigel::assets
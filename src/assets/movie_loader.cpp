@@ -20,6 +20,7 @@
 #include "assets/palette.hpp"
 #include "assets/rle_compression.hpp"
 
+#include <algorithm>
 #include <stdexcept>
 
 
@@ -112,10 +113,7 @@ data::Palette256 readPalette(LeStreamReader& reader)
     throw invalid_argument(INVALID_MOVIE_FILE);
   }
   reader.skipBytes(4); // always 1
-  const auto palette =
-    load6bitPalette256(reader.currentIter(), reader.currentIter() + 768);
-  reader.skipBytes(768);
-  return palette;
+  return load6bitPalette256(reader.readBytes(768));
 }
 
 
@@ -185,9 +183,62 @@ data::PixelBuffer readAnimationFramePixels(
 }
 
 
+// Animation frames only replace some parts of the image, usually just a
+// small area. To save memory and upload bandwidth, we only keep the bounding
+// rectangle of the pixels which are actually written by each frame.
+data::MovieFrame makeCroppedFrame(
+  const data::PixelBuffer& framePixels,
+  const int width,
+  const int numRows,
+  const int yOffset)
+{
+  auto left = width;
+  auto right = -1;
+  auto top = numRows;
+  auto bottom = -1;
+
+  for (auto row = 0; row < numRows; ++row)
+  {
+    for (auto col = 0; col < width; ++col)
+    {
+      if (framePixels[col + row * width].a != 0)
+      {
+        left = std::min(left, col);
+        right = std::max(right, col);
+        top = std::min(top, row);
+        bottom = std::max(bottom, row);
+      }
+    }
+  }
+
+  if (right < 0)
+  {
+    return {data::Image(0, 0), {0, yOffset}};
+  }
+
+  const auto croppedWidth = right - left + 1;
+  const auto croppedHeight = bottom - top + 1;
+
+  data::PixelBuffer croppedPixels;
+  croppedPixels.reserve(croppedWidth * croppedHeight);
+
+  for (auto row = top; row <= bottom; ++row)
+  {
+    const auto iRowStart = framePixels.begin() + row * width;
+    croppedPixels.insert(
+      croppedPixels.end(), iRowStart + left, iRowStart + right + 1);
+  }
+
+  return {
+    data::Image(std::move(croppedPixels), croppedWidth, croppedHeight),
+    {left, yOffset + top}};
+}
+
+
 vector<data::MovieFrame> readAnimationFrames(
   LeStreamReader& reader,
   const uint16_t width,
+  const uint16_t height,
   const uint16_t numAnimFrames,
   const data::Palette256& palette)
 {
@@ -205,12 +256,16 @@ vector<data::MovieFrame> readAnimationFrames(
 
     const auto yOffset = reader.readU16();
     const auto numRows = reader.readU16();
-    frames.emplace_back(
-      data::Image(
-        readAnimationFramePixels(reader, width, numRows, palette),
-        width,
-        numRows),
-      yOffset);
+    if (yOffset + numRows > height)
+    {
+      throw invalid_argument(INVALID_MOVIE_FILE);
+    }
+
+    frames.push_back(makeCroppedFrame(
+      readAnimationFramePixels(reader, width, numRows, palette),
+      width,
+      numRows,
+      yOffset));
   }
 
   return frames;
@@ -219,7 +274,7 @@ vector<data::MovieFrame> readAnimationFrames(
 } // namespace
 
 
-data::Movie loadMovie(const ByteBuffer& file)
+data::Movie loadMovie(const base::ArrayView<std::uint8_t> file)
 {
   LeStreamReader reader(file);
 
@@ -243,7 +298,8 @@ data::Movie loadMovie(const ByteBuffer& file)
   const auto palette = readPalette(reader);
   auto mainImagePixels = readMainImagePixels(reader, width, height, palette);
 
-  auto frames = readAnimationFrames(reader, width, numAnimFrames, palette);
+  auto frames =
+    readAnimationFrames(reader, width, height, numAnimFrames, palette);
   return {
     data::Image(std::move(mainImagePixels), width, height), std::move(frames)};
 }
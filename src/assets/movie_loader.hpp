@@ -16,14 +16,16 @@
 
 #pragma once
 
-#include "assets/byte_buffer.hpp"
+#include "base/array_view.hpp"
 #include "data/movie.hpp"
 
+#include <cstdint>
+
 
 namespace rigel::assets
 {
 
-data::Movie loadMovie(const ByteBuffer& file);
+data::Movie loadMovie(base::ArrayView<std::uint8_t> file);
 
 
 }
@@ -32,9 +32,10 @@ data::ImfCommand readCommand(LeStreamReader& reader)
 
 } // namespace
 
-data::Song loadSong(const ByteBuffer& imfData)
+data::Song loadSong(const base::ArrayView<std::uint8_t> imfData)
 {
   data::Song song;
+  song.reserve(imfData.size() / 4);
 
   LeStreamReader reader(imfData);
   while (reader.hasData())
@@ -16,13 +16,15 @@
 
 #pragma once
 
-#include "assets/byte_buffer.hpp"
+#include "base/array_view.hpp"
 #include "data/song.hpp"
 
+#include <cstdint>
+
 
 namespace rigel::assets
 {
 
-data::Song loadSong(const ByteBuffer& imfData);
+data::Song loadSong(base::ArrayView<std::uint8_t> imfData);
 
 }
@@ -38,11 +38,10 @@ std::uint8_t extend6bitColorValue(const std::uint8_t value)
 
 template <typename PaletteType, typename PreProcessFunc>
 PaletteType load6bitPalette(
-  const ByteBufferCIter begin,
-  const ByteBufferCIter end,
+  const base::ArrayView<std::uint8_t> data,
   PreProcessFunc preProcess)
 {
-  LeStreamReader reader(begin, end);
+  LeStreamReader reader(data);
 
   PaletteType palette;
   for (auto& entry : palette)
@@ -58,10 +57,9 @@ PaletteType load6bitPalette(
 } // namespace
 
 
-data::Palette16
-  load6bitPalette16(ByteBufferCIter begin, const ByteBufferCIter end)
+data::Palette16 load6bitPalette16(const base::ArrayView<std::uint8_t> data)
 {
-  return load6bitPalette<data::Palette16>(begin, end, [](const auto entry) {
+  return load6bitPalette<data::Palette16>(data, [](const auto entry) {
     // Duke Nukem 2 uses a non-standard 6-bit palette format, where the
     // maximum number is 68 instead of 63. This maps Duke 2 palette values to
     // normal 6-bit VGA/EGA values.
@@ -81,10 +79,9 @@ data::Palette16
 }
 
 
-data::Palette256
-  load6bitPalette256(ByteBufferCIter begin, const ByteBufferCIter end)
+data::Palette256 load6bitPalette256(const base::ArrayView<std::uint8_t> data)
 {
-  return load6bitPalette<data::Palette256>(begin, end, [](const auto entry) {
+  return load6bitPalette<data::Palette256>(data, [](const auto entry) {
     // 256 color palettes use the standard VGA 6-bit format and need no
     // conversion.
     return entry;
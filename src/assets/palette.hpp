@@ -16,26 +16,16 @@
 
 #pragma once
 
-#include "assets/byte_buffer.hpp"
+#include "base/array_view.hpp"
 #include "data/palette.hpp"
 
-
-namespace rigel::assets
-{
-
-data::Palette16 load6bitPalette16(ByteBufferCIter begin, ByteBufferCIter end);
-data::Palette256 load6bitPalette256(ByteBufferCIter begin, ByteBufferCIter end);
+#include <cstdint>
 
 
-inline data::Palette16 load6bitPalette16(const ByteBuffer& buffer)
+namespace rigel::assets
 {
-  return load6bitPalette16(buffer.begin(), buffer.end());
-}
-
 
-inline data::Palette256 load6bitPalette256(const ByteBuffer& buffer)
-{
-  return load6bitPalette256(buffer.begin(), buffer.end());
-}
+data::Palette16 load6bitPalette16(base::ArrayView<std::uint8_t> data);
+data::Palette256 load6bitPalette256(base::ArrayView<std::uint8_t> data);
 
 } // namespace rigel::assets
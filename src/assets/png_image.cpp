@@ -17,6 +17,7 @@
 #include "png_image.hpp"
 
 #include "assets/file_utils.hpp"
+#include "base/parallel.hpp"
 #include "base/warnings.hpp"
 
 RIGEL_DISABLE_WARNINGS
@@ -86,6 +87,18 @@ std::optional<data::Image> loadPng(base::ArrayView<std::uint8_t> data)
 }
 
 
+std::vector<std::optional<data::Image>>
+  loadPngs(const std::vector<std::filesystem::path>& paths)
+{
+  auto result = std::vector<std::optional<data::Image>>(paths.size());
+  base::parallelFor(paths.size(), [&](const std::size_t i) {
+    result[i] = loadPng(paths[i]);
+  });
+
+  return result;
+}
+
+
 bool savePng(const std::filesystem::path& path, const data::Image& image)
 {
   std::ofstream file(path, std::ios::binary);
@@ -22,6 +22,7 @@
 #include <filesystem>
 #include <optional>
 #include <string>
+#include <vector>
 
 namespace rigel::assets
 {
@@ -29,6 +30,14 @@ namespace rigel::assets
 std::optional<data::Image> loadPng(const std::filesystem::path& path);
 std::optional<data::Image> loadPng(base::ArrayView<std::uint8_t> data);
 
+/** Load and decode multiple PNG files, using all available CPU cores
+ *
+ * The result has one entry per path, in the same order. Entries for files
+ * that couldn't be loaded are empty.
+ */
+std::vector<std::optional<data::Image>>
+  loadPngs(const std::vector<std::filesystem::path>& paths);
+
 bool savePng(const std::filesystem::path& path, const data::Image& image);
 
 } // namespace rigel::assets
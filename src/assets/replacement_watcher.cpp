@@ -0,0 +1,92 @@
+/* Copyright (C) 2022, Nikolai Wuttke. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "replacement_watcher.hpp"
+
+#include <utility>
+
+
+namespace rigel::assets
+{
+
+namespace fs = std::filesystem;
+
+
+ReplacementWatcher::ReplacementWatcher(std::vector<fs::path> directories)
+  : mDirectories(std::move(directories))
+  , mFiles(scan())
+{
+}
+
+
+auto ReplacementWatcher::poll() -> Changes
+{
+  auto currentFiles = scan();
+  auto changes = Changes{};
+
+  // If no file is new and the count is unchanged, no file was removed either
+  changes.mFileSetChanged = currentFiles.size() != mFiles.size();
+
+  for (const auto& [path, state] : currentFiles)
+  {
+    const auto iPrevious = mFiles.find(path);
+    if (iPrevious == mFiles.end())
+    {
+      changes.mFileSetChanged = true;
+    }
+    else if (!(iPrevious->second == state))
+    {
+      changes.mModifiedFiles.push_back(
+        fs::u8path(path).filename().u8string());
+    }
+  }
+
+  mFiles = std::move(currentFiles);
+  return changes;
+}
+
+
+auto ReplacementWatcher::scan() const -> FileStates
+{
+  auto result = FileStates{};
+
+  for (const auto& directory : mDirectories)
+  {
+    std::error_code ec;
+    for (auto iEntry = fs::directory_iterator{directory, ec};
+         iEntry != fs::directory_iterator{};
+         iEntry.increment(ec))
+    {
+      std::error_code entryEc;
+      if (!iEntry->is_regular_file(entryEc) || entryEc)
+      {
+        continue;
+      }
+
+      const auto writeTime = iEntry->last_write_time(entryEc);
+      const auto size = iEntry->file_size(entryEc);
+      if (!entryEc)
+      {
+        result.insert_or_assign(
+          iEntry->path().u8string(), FileState{writeTime, size});
+      }
+    }
+  }
+
+  return result;
+}
+
+} // namespace rigel::assets
@@ -0,0 +1,83 @@
+/* Copyright (C) 2022, Nikolai Wuttke. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+
+namespace rigel::assets
+{
+
+/** Detects changes to replacement files, for hot-reloading
+ *
+ * Records name, size and modification time of all regular files directly
+ * inside the given directories on construction. poll() compares the current
+ * state against that record, reports what changed, and then updates the
+ * record.
+ *
+ * This is based on polling instead of platform change notifications, so it
+ * works the same everywhere. Each poll needs to list all watched
+ * directories, it should therefore only be done every now and then, not
+ * every frame.
+ */
+class ReplacementWatcher
+{
+public:
+  struct Changes
+  {
+    /** Names of files whose contents have changed */
+    std::vector<std::string> mModifiedFiles;
+
+    /** Set if files appeared or disappeared
+     *
+     * ResourceLoader lists replacement directories only once, so it won't
+     * see these changes until it's recreated.
+     */
+    bool mFileSetChanged = false;
+
+    bool empty() const { return mModifiedFiles.empty() && !mFileSetChanged; }
+  };
+
+  explicit ReplacementWatcher(std::vector<std::filesystem::path> directories);
+
+  Changes poll();
+
+private:
+  struct FileState
+  {
+    std::filesystem::file_time_type mWriteTime;
+    std::uintmax_t mSize;
+
+    bool operator==(const FileState& other) const
+    {
+      return mWriteTime == other.mWriteTime && mSize == other.mSize;
+    }
+  };
+
+  using FileStates = std::unordered_map<std::string, FileState>;
+
+  FileStates scan() const;
+
+  std::vector<std::filesystem::path> mDirectories;
+  FileStates mFiles;
+};
+
+} // namespace rigel::assets
@@ -16,16 +16,22 @@
 
 #include "resource_loader.hpp"
 
+#include "assets/asset_cache.hpp"
 #include "assets/ega_image_decoder.hpp"
 #include "assets/file_utils.hpp"
+#include "assets/memory_mapped_file.hpp"
 #include "assets/movie_loader.hpp"
 #include "assets/music_loader.hpp"
 #include "assets/png_image.hpp"
 #include "assets/voc_decoder.hpp"
 #include "base/container_utils.hpp"
+#include "base/startup_timings.hpp"
+#include "base/string_utils.hpp"
+#include "base/tracing.hpp"
 #include "data/game_traits.hpp"
 #include "data/unit_conversions.hpp"
 
+#include <algorithm>
 #include <chrono>
 #include <cstdint>
 #include <iostream>
@@ -49,6 +55,9 @@ const auto FULL_SCREEN_IMAGE_DATA_SIZE =
   (GameTraits::viewportWidthPx * GameTraits::viewportHeightPx) /
   (GameTraits::pixelsPerEgaByte / GameTraits::egaPlanes);
 
+// Enough for a handful of 4x tilesets and backdrops
+constexpr auto DECODED_IMAGE_CACHE_BUDGET = std::size_t{64 * 1024 * 1024};
+
 
 // When loading assets, the game will first check if a file with an expected
 // name exists at the replacements path, and if it does, it will load this file
@@ -73,8 +82,27 @@ const auto FULL_SCREEN_IMAGE_DATA_SIZE =
 // tileset1.png, etc.
 //
 // The files can contain full 32-bit RGBA values, there are no limitations.
+//
+// Sprites, tilesets and backdrops can additionally be provided in multiple
+// resolutions, by adding files with an "@<scale>x" suffix, e.g.
+// "actor159_frame0@2x.png" next to "actor159_frame0.png". <scale> is the
+// variant's resolution as a multiple of the original asset's. When the
+// replacement resolution is limited (see ResourceLoader's constructor), the
+// smallest variant that still reaches the limit is loaded instead of the
+// main file. The main file should be the highest resolution available.
 const auto ASSET_REPLACEMENTS_PATH = "asset_replacements";
 
+// Highest scale considered when looking for resolution variants
+constexpr auto MAX_VARIANT_SCALE = 16;
+
+
+std::string variantName(std::string_view filename, const int scale)
+{
+  const auto extensionStart = std::min(filename.rfind('.'), filename.size());
+  return std::string{filename.substr(0, extensionStart)} + "@" +
+    std::to_string(scale) + "x" + std::string{filename.substr(extensionStart)};
+}
+
 
 std::string replacementSpriteImageName(const int id, const int frame)
 {
@@ -83,9 +111,26 @@ std::string replacementSpriteImageName(const int id, const int frame)
 }
 
 
-std::optional<data::Image> loadReplacementTilesetIfPresent(
-  const fs::path& resourcePath,
-  std::string_view name)
+std::optional<std::string> replacementBackdropName(std::string_view name)
+{
+  using namespace std::literals;
+
+  std::regex backdropNameRegex{"^DROP([0-9]+)\\.MNI$", std::regex::icase};
+  std::match_results<std::string_view::const_iterator> matches;
+
+  if (
+    !std::regex_match(name.begin(), name.end(), matches, backdropNameRegex) ||
+    matches.size() != 2)
+  {
+    return {};
+  }
+
+  const auto number = matches[1].str();
+  return "backdrop"s + number + ".png";
+}
+
+
+std::optional<std::string> replacementTilesetName(std::string_view name)
 {
   using namespace std::literals;
 
@@ -100,10 +145,23 @@ std::optional<data::Image> loadReplacementTilesetIfPresent(
   }
 
   const auto number = matches[1].str();
-  const auto replacementName = "tileset"s + number + ".png";
-  const auto replacementPath = resourcePath / replacementName;
+  return "tileset"s + number + ".png";
+}
+
 
-  return loadPng(replacementPath);
+// Later mods take precedence, so the result is in reverse order
+std::vector<DirectoryIndex>
+  indexModDirectories(const std::vector<fs::path>& modPaths)
+{
+  std::vector<DirectoryIndex> result;
+  result.reserve(modPaths.size());
+
+  for (auto iPath = modPaths.rbegin(); iPath != modPaths.rend(); ++iPath)
+  {
+    result.emplace_back(*iPath);
+  }
+
+  return result;
 }
 
 
@@ -138,17 +196,82 @@ std::string digitizedSoundFilenameForId(const data::SoundId soundId)
 } // namespace
 
 
+std::optional<data::ActorID>
+  actorForReplacementFile(std::string_view fileName)
+{
+  static const auto actorFrameRegex =
+    std::regex{
+      "^actor([0-9]{1,5})_frame[0-9]+(@[0-9]+x)?\\.png$", std::regex::icase};
+
+  std::match_results<std::string_view::const_iterator> matches;
+  if (!std::regex_match(
+        fileName.begin(), fileName.end(), matches, actorFrameRegex))
+  {
+    return {};
+  }
+
+  return static_cast<data::ActorID>(std::stoi(matches[1].str()));
+}
+
+
+std::optional<data::SoundId>
+  soundForReplacementFile(std::string_view fileName)
+{
+  static const auto soundRegex =
+    std::regex{"^sound([0-9]{1,5})\\.wav$", std::regex::icase};
+
+  std::match_results<std::string_view::const_iterator> matches;
+  if (!std::regex_match(fileName.begin(), fileName.end(), matches, soundRegex))
+  {
+    return {};
+  }
+
+  const auto index = std::stoi(matches[1].str()) - 1;
+  if (index < 0 || index >= data::NUM_SOUND_IDS)
+  {
+    return {};
+  }
+
+  return static_cast<data::SoundId>(index);
+}
+
+
+bool isLevelImageReplacementFile(std::string_view fileName)
+{
+  static const auto levelImageRegex = std::regex{
+    "^(tileset|backdrop)[0-9A-Z]+(@[0-9]+x)?\\.png$", std::regex::icase};
+
+  return std::regex_match(fileName.begin(), fileName.end(), levelImageRegex);
+}
+
+
 ResourceLoader::ResourceLoader(
   std::filesystem::path gamePath,
   bool enableTopLevelMods,
-  std::vector<fs::path> modPaths)
+  std::vector<fs::path> modPaths,
+  const int maxReplacementScale)
   : mGamePath(std::move(gamePath))
   , mModPaths(std::move(modPaths))
   , mEnableTopLevelMods(enableTopLevelMods)
-  , mFilePackage(mGamePath / "NUKEM2.CMP")
-  , mActorImagePackage(
-      file(ActorImagePackage::IMAGE_DATA_FILE),
-      file(ActorImagePackage::ACTOR_INFO_FILE))
+  , mMaxReplacementScale(maxReplacementScale)
+  , mModDirectories(indexModDirectories(mModPaths))
+  , mTopLevelDirectory(
+      mEnableTopLevelMods ? DirectoryIndex{mGamePath} : DirectoryIndex{})
+  , mTopLevelReplacementsDirectory(
+      mEnableTopLevelMods ? DirectoryIndex{mGamePath / ASSET_REPLACEMENTS_PATH}
+                          : DirectoryIndex{})
+  , mFilePackage(base::startup_timings::measure(
+      "CMP package",
+      [&]() { return CMPFilePackage(mGamePath / "NUKEM2.CMP"); }))
+  , mActorImagePackage(base::startup_timings::measure(
+      "Actor image package",
+      [&]() {
+        return ActorImagePackage(
+          file(ActorImagePackage::IMAGE_DATA_FILE),
+          file(ActorImagePackage::ACTOR_INFO_FILE));
+      }))
+  , mpDecodedImages(
+      std::make_unique<DecodedImageCache>(DECODED_IMAGE_CACHE_BUDGET))
 {
 }
 
@@ -156,9 +279,9 @@ ResourceLoader::ResourceLoader(
 template <typename TryLoadFunc, typename T>
 std::optional<T> ResourceLoader::tryLoadReplacement(TryLoadFunc&& tryLoad) const
 {
-  for (auto iPath = mModPaths.rbegin(); iPath != mModPaths.rend(); ++iPath)
+  for (const auto& directory : mModDirectories)
   {
-    if (auto oReplacement = tryLoad(*iPath))
+    if (auto oReplacement = tryLoad(directory))
     {
       return *oReplacement;
     }
@@ -166,7 +289,7 @@ std::optional<T> ResourceLoader::tryLoadReplacement(TryLoadFunc&& tryLoad) const
 
   if (mEnableTopLevelMods)
   {
-    if (auto oReplacement = tryLoad(mGamePath / ASSET_REPLACEMENTS_PATH))
+    if (auto oReplacement = tryLoad(mTopLevelReplacementsDirectory))
     {
       return *oReplacement;
     }
@@ -180,7 +303,75 @@ std::optional<data::Image>
   ResourceLoader::tryLoadPngReplacement(std::string_view filename) const
 {
   return tryLoadReplacement(
-    [filename](const fs::path& path) { return loadPng(path / filename); });
+    [this, filename](
+      const DirectoryIndex& directory) -> std::optional<data::Image> {
+      if (const auto path = directory.find(filename))
+      {
+        return mpDecodedImages->load(*path);
+      }
+
+      return {};
+    });
+}
+
+
+std::optional<fs::path>
+  ResourceLoader::replacementPath(std::string_view filename) const
+{
+  return tryLoadReplacement(
+    [filename](const DirectoryIndex& directory) -> std::optional<fs::path> {
+      return directory.find(filename);
+    });
+}
+
+
+std::optional<fs::path>
+  ResourceLoader::scaledReplacementPath(std::string_view filename) const
+{
+  return tryLoadReplacement(
+    [this, filename](const DirectoryIndex& directory) {
+      if (mMaxReplacementScale > 0)
+      {
+        for (auto scale = mMaxReplacementScale; scale <= MAX_VARIANT_SCALE;
+             ++scale)
+        {
+          if (auto oPath = directory.find(variantName(filename, scale)))
+          {
+            return oPath;
+          }
+        }
+      }
+
+      return directory.find(filename);
+    });
+}
+
+
+std::optional<data::Image> ResourceLoader::tryLoadPngReplacement(
+  std::string_view filename,
+  const base::Size& originalSize) const
+{
+  const auto oPath = scaledReplacementPath(filename);
+  auto oReplacement =
+    oPath ? mpDecodedImages->load(*oPath) : std::optional<data::Image>{};
+  if (!oReplacement || mMaxReplacementScale <= 0 || originalSize.width <= 0)
+  {
+    return oReplacement;
+  }
+
+  // Replacements are normally an integer multiple of the original size. If
+  // that's not the case, the smaller of the two axis' scale factors decides.
+  const auto scale = std::min(
+    int(oReplacement->width()) / originalSize.width,
+    int(oReplacement->height()) / std::max(originalSize.height, 1));
+  if (scale <= mMaxReplacementScale)
+  {
+    return oReplacement;
+  }
+
+  const auto factor =
+    (scale + mMaxReplacementScale - 1) / mMaxReplacementScale;
+  return oReplacement->downscaled(std::size_t(factor));
 }
 
 
@@ -240,9 +431,10 @@ data::Image ResourceLoader::loadTiledFullscreenImage(
 data::Image
   ResourceLoader::loadStandaloneFullscreenImage(std::string_view name) const
 {
+  RIGEL_TRACE_ZONE("ResourceLoader::loadStandaloneFullscreenImage");
   const auto& data = file(name);
-  const auto paletteStart = data.begin() + FULL_SCREEN_IMAGE_DATA_SIZE;
-  const auto palette = load6bitPalette16(paletteStart, data.end());
+  const auto palette = load6bitPalette16(
+    base::ArrayView<uint8_t>{data}.subView(FULL_SCREEN_IMAGE_DATA_SIZE));
 
   auto pixels = decodeSimplePlanarEgaBuffer(
     data.begin(), data.begin() + FULL_SCREEN_IMAGE_DATA_SIZE, palette);
@@ -264,7 +456,8 @@ data::Image ResourceLoader::loadAntiPiracyImage() const
   // See http://www.shikadi.net/moddingwiki/Duke_Nukem_II_Full-screen_Images
   const auto& data = file(ANTI_PIRACY_SCREEN_FILENAME);
   const auto iImageStart = begin(data) + 256 * 3;
-  const auto palette = load6bitPalette256(begin(data), iImageStart);
+  const auto palette =
+    load6bitPalette256(base::ArrayView<uint8_t>{data}.subView(0, 256 * 3));
 
   data::PixelBuffer pixels;
   pixels.reserve(GameTraits::viewportWidthPx * GameTraits::viewportHeightPx);
@@ -296,8 +489,8 @@ data::Palette16 ResourceLoader::loadPaletteFromFullScreenImage(
   std::string_view imageName) const
 {
   const auto& data = file(imageName);
-  const auto paletteStart = data.begin() + FULL_SCREEN_IMAGE_DATA_SIZE;
-  return load6bitPalette16(paletteStart, data.end());
+  return load6bitPalette16(
+    base::ArrayView<uint8_t>{data}.subView(FULL_SCREEN_IMAGE_DATA_SIZE));
 }
 
 
@@ -305,6 +498,7 @@ ActorData ResourceLoader::loadActor(
   data::ActorID id,
   const data::Palette16& palette) const
 {
+  RIGEL_TRACE_ZONE("ResourceLoader::loadActor");
   const auto& actorInfo = mActorImagePackage.loadActorInfo(id);
 
   auto images = utils::transformed(
@@ -313,7 +507,8 @@ ActorData ResourceLoader::loadActor(
         replacementSpriteImageName(static_cast<int>(id), frame);
       ++frame;
 
-      const auto oReplacement = tryLoadPngReplacement(imageName);
+      const auto oReplacement = tryLoadPngReplacement(
+        imageName, data::tilesToPixels(frameHeader.mSizeInTiles));
       return ActorData::Frame{
         frameHeader.mDrawOffset,
         frameHeader.mSizeInTiles,
@@ -325,21 +520,47 @@ ActorData ResourceLoader::loadActor(
 }
 
 
-data::Image ResourceLoader::loadBackdrop(std::string_view name) const
+std::vector<data::IndexedImage> ResourceLoader::loadIndexedActorFrames(
+  const data::ActorID id,
+  const data::Palette16& palette) const
 {
-  using namespace std::literals;
+  const auto& actorInfo = mActorImagePackage.loadActorInfo(id);
+  return utils::transformed(actorInfo.mFrames, [&](const auto& frameHeader) {
+    return mActorImagePackage.loadIndexedImage(frameHeader, palette);
+  });
+}
 
-  std::regex backdropNameRegex{"^DROP([0-9]+)\\.MNI$", std::regex::icase};
-  std::match_results<std::string_view::const_iterator> matches;
 
-  if (
-    std::regex_match(name.begin(), name.end(), matches, backdropNameRegex) &&
-    matches.size() == 2)
-  {
-    const auto number = matches[1].str();
-    const auto replacementName = "backdrop"s + number + ".png";
+bool ResourceLoader::hasSpriteReplacements() const
+{
+  auto isSpriteReplacement = [](const fs::path& path) {
+    return strings::startsWith(path.filename().u8string(), "actor") &&
+      strings::toLowercase(path.extension().u8string()) == ".png";
+  };
+
+  const auto found = tryLoadReplacement([&](const DirectoryIndex& directory) {
+    const auto& files = directory.files();
+    if (std::any_of(files.begin(), files.end(), isSpriteReplacement))
+    {
+      return std::optional<bool>{true};
+    }
+
+    return std::optional<bool>{};
+  });
 
-    if (const auto oReplacement = tryLoadPngReplacement(replacementName))
+  return found.has_value();
+}
+
+
+data::Image ResourceLoader::loadBackdrop(std::string_view name) const
+{
+  RIGEL_TRACE_ZONE("ResourceLoader::loadBackdrop");
+
+  if (const auto oReplacementName = replacementBackdropName(name))
+  {
+    if (const auto oReplacement = tryLoadPngReplacement(
+          *oReplacementName,
+          {GameTraits::viewportWidthPx, GameTraits::viewportHeightPx}))
     {
       return *oReplacement;
     }
@@ -349,8 +570,37 @@ data::Image ResourceLoader::loadBackdrop(std::string_view name) const
 }
 
 
+void ResourceLoader::prefetchLevelImages(
+  std::string_view tileSetName,
+  const std::vector<std::string>& backdropNames) const
+{
+  RIGEL_TRACE_ZONE("ResourceLoader::prefetchLevelImages");
+
+  auto replacementNames = utils::transformed(
+    backdropNames, [](const std::string& name) {
+      return replacementBackdropName(name);
+    });
+  replacementNames.push_back(replacementTilesetName(tileSetName));
+
+  std::vector<fs::path> paths;
+  for (const auto& oName : replacementNames)
+  {
+    if (oName)
+    {
+      if (auto oPath = scaledReplacementPath(*oName))
+      {
+        paths.push_back(std::move(*oPath));
+      }
+    }
+  }
+
+  mpDecodedImages->load(paths);
+}
+
+
 TileSet ResourceLoader::loadCZone(std::string_view name) const
 {
+  RIGEL_TRACE_ZONE("ResourceLoader::loadCZone");
   using namespace data;
   using namespace map;
   using T = data::TileImageType;
@@ -371,32 +621,39 @@ TileSet ResourceLoader::loadCZone(std::string_view name) const
     }
   }
 
-  const auto oReplacementImage =
-    tryLoadReplacement([name](const fs::path& path) {
-      return loadReplacementTilesetIfPresent(path, name);
-    });
+  const auto oReplacementName = replacementTilesetName(name);
+  const auto oReplacementImage = oReplacementName
+    ? tryLoadPngReplacement(
+        *oReplacementName,
+        data::tilesToPixels(base::Size{
+          GameTraits::CZone::tileSetImageWidth,
+          GameTraits::CZone::tileSetImageHeight}))
+    : std::nullopt;
 
   if (oReplacementImage)
   {
     return {
-      std::move(*oReplacementImage), TileAttributeDict{std::move(attributes)}};
+      std::move(*oReplacementImage), TileAttributeDict{attributes}};
   }
 
-  Image fullImage(
+  // Assemble the tile set while still indexed, and only expand the final
+  // image to RGBA.
+  IndexedImage fullImage(
     tilesToPixels(GameTraits::CZone::tileSetImageWidth),
-    tilesToPixels(GameTraits::CZone::tileSetImageHeight));
+    tilesToPixels(GameTraits::CZone::tileSetImageHeight),
+    data::GameTraits::INGAME_PALETTE);
 
   const auto tilesBegin = data.begin() + GameTraits::CZone::attributeBytesTotal;
   const auto maskedTilesBegin = tilesBegin +
     GameTraits::CZone::numSolidTiles * GameTraits::CZone::tileBytes;
 
-  const auto solidTilesImage = loadTiledImage(
+  const auto solidTilesImage = loadTiledIndexedImage(
     tilesBegin,
     maskedTilesBegin,
     GameTraits::CZone::tileSetImageWidth,
     data::GameTraits::INGAME_PALETTE,
     T::Unmasked);
-  const auto maskedTilesImage = loadTiledImage(
+  const auto maskedTilesImage = loadTiledIndexedImage(
     maskedTilesBegin,
     data.end(),
     GameTraits::CZone::tileSetImageWidth,
@@ -408,30 +665,32 @@ TileSet ResourceLoader::loadCZone(std::string_view name) const
     tilesToPixels(GameTraits::CZone::solidTilesImageHeight),
     maskedTilesImage);
 
-  return {std::move(fullImage), TileAttributeDict{std::move(attributes)}};
+  return {fullImage.toImage(), TileAttributeDict{attributes}};
 }
 
 
 data::Movie ResourceLoader::loadMovie(std::string_view name) const
 {
+  RIGEL_TRACE_ZONE("ResourceLoader::loadMovie");
   // We don't use tryLoadReplacement here, because we don't look for movies
   // in the top-level path.
-  for (auto iPath = mModPaths.rbegin(); iPath != mModPaths.rend(); ++iPath)
+  for (const auto& directory : mModDirectories)
   {
-    const auto moddedFile = *iPath / fs::u8path(name);
-    if (fs::exists(moddedFile))
+    if (const auto moddedFile = directory.find(name))
     {
-      return assets::loadMovie(loadFile(moddedFile));
+      return assets::loadMovie(MemoryMappedFile{*moddedFile}.data());
     }
   }
 
-  return assets::loadMovie(loadFile(mGamePath / fs::u8path(name)));
+  return assets::loadMovie(
+    MemoryMappedFile{mGamePath / fs::u8path(name)}.data());
 }
 
 
 data::Song ResourceLoader::loadMusic(std::string_view name) const
 {
-  return assets::loadSong(file(name));
+  RIGEL_TRACE_ZONE("ResourceLoader::loadMusic");
+  return assets::loadSong(fileView(name).data());
 }
 
 
@@ -463,45 +722,46 @@ std::vector<std::filesystem::path>
     "sound"s + std::to_string(static_cast<int>(id) + 1) + ".wav";
 
   auto result = std::vector<std::filesystem::path>{};
-  result.reserve(mModPaths.size());
-
-  std::transform(
-    mModPaths.rbegin(),
-    mModPaths.rend(),
-    std::back_inserter(result),
-    [&](const auto& path) { return path / expectedName; });
+  tryLoadReplacement([&](const DirectoryIndex& directory) {
+    if (auto path = directory.find(expectedName))
+    {
+      result.push_back(std::move(*path));
+    }
 
-  if (mEnableTopLevelMods)
-  {
-    result.push_back(mGamePath / ASSET_REPLACEMENTS_PATH / expectedName);
-  }
+    return std::optional<bool>{};
+  });
 
   return result;
 }
 
 
 std::vector<std::filesystem::path>
-  ResourceLoader::replacementMusicBasePaths() const
+  ResourceLoader::replacementMusicPaths(std::string_view songName) const
 {
-  auto result =
-    std::vector<std::filesystem::path>{mModPaths.rbegin(), mModPaths.rend()};
+  const auto stem =
+    fs::u8path(strings::toLowercase(songName)).replace_extension();
+
+  auto result = std::vector<std::filesystem::path>{};
+  tryLoadReplacement([&](const DirectoryIndex& directory) {
+    const auto candidates = directory.findByStem(stem);
+    result.insert(result.end(), candidates.begin(), candidates.end());
+    return std::optional<bool>{};
+  });
 
-  if (mEnableTopLevelMods)
-  {
-    result.push_back(mGamePath / ASSET_REPLACEMENTS_PATH);
-  }
   return result;
 }
 
 
 base::AudioBuffer ResourceLoader::loadSound(std::string_view name) const
 {
-  return assets::decodeVoc(file(name));
+  RIGEL_TRACE_ZONE("ResourceLoader::loadSound");
+  return assets::decodeVoc(fileView(name).data());
 }
 
 
 ScriptBundle ResourceLoader::loadScriptBundle(std::string_view fileName) const
 {
+  RIGEL_TRACE_ZONE("ResourceLoader::loadScriptBundle");
   return assets::loadScripts(fileAsText(fileName));
 }
 
@@ -514,26 +774,23 @@ data::LevelHints ResourceLoader::loadHintMessages() const
 
 ByteBuffer ResourceLoader::file(std::string_view name) const
 {
-  // TODO: Eliminate duplication with tryLoadReplacement?
-  for (auto iPath = mModPaths.rbegin(); iPath != mModPaths.rend(); ++iPath)
+  if (const auto path = unpackedFilePath(name))
   {
-    const auto unpackedFilePath = *iPath / fs::u8path(name);
-    if (fs::exists(unpackedFilePath))
-    {
-      return loadFile(unpackedFilePath);
-    }
+    return loadFile(*path);
   }
 
-  if (mEnableTopLevelMods)
+  return mFilePackage.file(name);
+}
+
+
+FileView ResourceLoader::fileView(std::string_view name) const
+{
+  if (const auto path = unpackedFilePath(name))
   {
-    const auto unpackedFilePath = mGamePath / fs::u8path(name);
-    if (fs::exists(unpackedFilePath))
-    {
-      return loadFile(unpackedFilePath);
-    }
+    return FileView{loadFile(*path)};
   }
 
-  return mFilePackage.file(name);
+  return FileView{mFilePackage.fileView(name)};
 }
 
 
@@ -545,26 +802,93 @@ std::string ResourceLoader::fileAsText(std::string_view name) const
 
 bool ResourceLoader::hasFile(std::string_view name) const
 {
-  // TODO: Eliminate duplication with tryLoadReplacement?
-  for (auto iPath = mModPaths.rbegin(); iPath != mModPaths.rend(); ++iPath)
+  return unpackedFilePath(name) || mFilePackage.hasFile(name);
+}
+
+
+std::uint64_t ResourceLoader::contentKey() const
+{
+  auto hasher = CacheKeyHasher{};
+
+  auto addFile = [&](const fs::path& path) {
+    std::error_code ec;
+    const auto size = fs::file_size(path, ec);
+    const auto modificationTime = fs::last_write_time(path, ec);
+
+    hasher.add(path.u8string())
+      .add(std::uint64_t(size))
+      .add(std::uint64_t(modificationTime.time_since_epoch().count()));
+  };
+
+  auto addDirectory = [&](const fs::path& path) {
+    std::error_code ec;
+    for (auto iEntry = fs::recursive_directory_iterator{path, ec};
+         iEntry != fs::recursive_directory_iterator{};
+         iEntry.increment(ec))
+    {
+      if (iEntry->is_regular_file(ec))
+      {
+        addFile(iEntry->path());
+      }
+    }
+  };
+
+  addFile(mGamePath / "NUKEM2.CMP");
+
+  if (mEnableTopLevelMods)
   {
-    const auto unpackedFilePath = *iPath / fs::u8path(name);
-    if (fs::exists(unpackedFilePath))
+    // Top-level replacements are looked up directly in the game directory,
+    // which can contain unrelated sub-directories, so don't recurse there.
+    std::error_code ec;
+    for (const auto& entry : fs::directory_iterator{mGamePath, ec})
     {
-      return true;
+      if (entry.is_regular_file(ec))
+      {
+        addFile(entry.path());
+      }
     }
+
+    addDirectory(mGamePath / ASSET_REPLACEMENTS_PATH);
+  }
+
+  for (const auto& modPath : mModPaths)
+  {
+    addDirectory(modPath);
   }
 
+  // Affects the decoded replacement images
+  hasher.add(std::uint64_t(mMaxReplacementScale));
+
+  return hasher.value();
+}
+
+
+std::vector<fs::path> ResourceLoader::replacementDirectories() const
+{
+  auto result = mModPaths;
+
   if (mEnableTopLevelMods)
   {
-    const auto unpackedFilePath = mGamePath / fs::u8path(name);
-    if (fs::exists(unpackedFilePath))
+    result.push_back(mGamePath);
+    result.push_back(mGamePath / ASSET_REPLACEMENTS_PATH);
+  }
+
+  return result;
+}
+
+
+std::optional<fs::path>
+  ResourceLoader::unpackedFilePath(std::string_view name) const
+{
+  for (const auto& directory : mModDirectories)
+  {
+    if (auto unpackedFilePath = directory.find(name))
     {
-      return true;
+      return unpackedFilePath;
     }
   }
 
-  return mFilePackage.hasFile(name);
+  return mTopLevelDirectory.find(name);
 }
 
 } // namespace rigel::assets
@@ -18,18 +18,24 @@
 
 #include "assets/actor_image_package.hpp"
 #include "assets/cmp_file_package.hpp"
+#include "assets/decoded_image_cache.hpp"
+#include "assets/directory_index.hpp"
 #include "assets/duke_script_loader.hpp"
 #include "assets/palette.hpp"
 #include "base/array_view.hpp"
 #include "base/audio_buffer.hpp"
 #include "base/image.hpp"
+#include "base/memory_accounting.hpp"
 #include "data/movie.hpp"
 #include "data/song.hpp"
 #include "data/sound_ids.hpp"
 #include "data/tile_attributes.hpp"
 
 #include <filesystem>
+#include <memory>
+#include <optional>
 #include <string>
+#include <string_view>
 #include <vector>
 
 
@@ -65,13 +71,79 @@ struct ActorData
 };
 
 
+/** Actor whose frame image is replaced by the given file, if any
+ *
+ * E.g. returns 159 for "actor159_frame3.png".
+ */
+std::optional<data::ActorID>
+  actorForReplacementFile(std::string_view fileName);
+
+/** Sound effect replaced by the given file, if any
+ *
+ * E.g. returns SoundId 11 for "sound12.wav".
+ */
+std::optional<data::SoundId>
+  soundForReplacementFile(std::string_view fileName);
+
+/** Returns true if the file replaces a tileset or backdrop image
+ *
+ * These are only read when loading a level.
+ */
+bool isLevelImageReplacementFile(std::string_view fileName);
+
+
+/** Read-only contents of a file provided by ResourceLoader
+ *
+ * Points directly into the memory-mapped CMP package if possible. Files
+ * replaced by mods are loaded into memory instead, and owned by the view.
+ */
+class FileView
+{
+public:
+  explicit FileView(base::ArrayView<std::uint8_t> data)
+    : mData(data)
+  {
+  }
+
+  explicit FileView(ByteBuffer ownedData)
+    : mOwnedData(std::move(ownedData))
+    , mData(mOwnedData)
+    , mMemory(base::MemoryCategory::AssetBuffers, mOwnedData.size())
+  {
+  }
+
+  // Moving a std::vector keeps its data pointer valid, so the defaulted
+  // move operations are fine. Copying is not.
+  FileView(FileView&&) = default;
+  FileView& operator=(FileView&&) = default;
+  FileView(const FileView&) = delete;
+  FileView& operator=(const FileView&) = delete;
+
+  base::ArrayView<std::uint8_t> data() const { return mData; }
+
+private:
+  ByteBuffer mOwnedData;
+  base::ArrayView<std::uint8_t> mData;
+  base::TrackedMemory mMemory;
+};
+
+
 class ResourceLoader
 {
 public:
+  /** Create a resource loader
+   *
+   * If maxReplacementScale is non-zero, replacement sprites, tilesets and
+   * backdrops with a higher resolution than maxReplacementScale times the
+   * original are scaled down on loading, to limit their memory use. If a
+   * lower resolution variant of a replacement exists, it's loaded instead
+   * (see resource_loader.cpp for details).
+   */
   ResourceLoader(
     std::filesystem::path gamePath,
     bool enableTopLevelMods,
-    std::vector<std::filesystem::path> modPaths);
+    std::vector<std::filesystem::path> modPaths,
+    int maxReplacementScale = 0);
 
   data::Image loadUiSpriteSheet() const;
   data::Image loadUiSpriteSheet(const data::Palette16& overridePalette) const;
@@ -84,6 +156,24 @@ public:
     data::ActorID id,
     const data::Palette16& palette = data::GameTraits::INGAME_PALETTE) const;
 
+  /** Decode the given actor's frames, keeping them palette-indexed
+   *
+   * Unlike loadActor(), this ignores any sprite replacements, so it should
+   * only be used if hasSpriteReplacements() returns false.
+   */
+  std::vector<data::IndexedImage> loadIndexedActorFrames(
+    data::ActorID id,
+    const data::Palette16& palette = data::GameTraits::INGAME_PALETTE) const;
+
+  /** Frame metadata for the given actor, without decoding any images */
+  const ActorHeader& loadActorInfo(data::ActorID id) const
+  {
+    return mActorImagePackage.loadActorInfo(id);
+  }
+
+  /** Returns true if any mod replaces actor sprite images */
+  bool hasSpriteReplacements() const;
+
   FontData loadFont() const { return mActorImagePackage.loadFont(); }
 
   int drawIndexFor(data::ActorID id) const
@@ -103,34 +193,74 @@ public:
 
   data::Image loadBackdrop(std::string_view name) const;
   TileSet loadCZone(std::string_view name) const;
+
+  /** Decode replacements for the given tileset and backdrops in parallel
+   *
+   * Following loadCZone() and loadBackdrop() calls for the same names are
+   * then served from the decoded image cache. Does nothing for images that
+   * have no replacement.
+   */
+  void prefetchLevelImages(
+    std::string_view tileSetName,
+    const std::vector<std::string>& backdropNames) const;
   data::Movie loadMovie(std::string_view name) const;
 
   data::Song loadMusic(std::string_view name) const;
   bool hasSoundBlasterSound(data::SoundId id) const;
   base::AudioBuffer loadSoundBlasterSound(data::SoundId id) const;
 
+  /** Existing replacement files for the given sound, by priority */
   std::vector<std::filesystem::path>
     replacementSoundPaths(data::SoundId id) const;
-  std::vector<std::filesystem::path> replacementMusicBasePaths() const;
+
+  /** Candidate replacement files for the given song, by priority
+   *
+   * Since SDL_mixer supports many different formats, any file with a name
+   * (minus extension) matching the song's name is a candidate.
+   */
+  std::vector<std::filesystem::path>
+    replacementMusicPaths(std::string_view songName) const;
 
   ScriptBundle loadScriptBundle(std::string_view fileName) const;
 
   data::LevelHints loadHintMessages() const;
 
   ByteBuffer file(std::string_view name) const;
+  FileView fileView(std::string_view name) const;
   std::string fileAsText(std::string_view name) const;
   bool hasFile(std::string_view name) const;
 
+  /** Identifies the game data and mods in use, for AssetCache
+   *
+   * Based on the names, sizes and modification times of the CMP file and all
+   * files in the game directory and mod directories, not on their contents.
+   */
+  std::uint64_t contentKey() const;
+
+  /** All directories which are searched for replacement files */
+  std::vector<std::filesystem::path> replacementDirectories() const;
+
 private:
+  std::optional<std::filesystem::path>
+    unpackedFilePath(std::string_view name) const;
+
   // The invoke_result of the TryLoadFunc is going to be a std::optional<T>,
   // hence we need to unpack the underlying T via the optional's value_type
   template <
     typename TryLoadFunc,
     typename T = typename std::
-      invoke_result_t<TryLoadFunc, const std::filesystem::path&>::value_type>
+      invoke_result_t<TryLoadFunc, const DirectoryIndex&>::value_type>
   std::optional<T> tryLoadReplacement(TryLoadFunc&& tryLoad) const;
   std::optional<data::Image>
     tryLoadPngReplacement(std::string_view filename) const;
+  std::optional<std::filesystem::path>
+    replacementPath(std::string_view filename) const;
+  /** Like replacementPath(), but considers resolution variants */
+  std::optional<std::filesystem::path>
+    scaledReplacementPath(std::string_view filename) const;
+  std::optional<data::Image> tryLoadPngReplacement(
+    std::string_view filename,
+    const base::Size& originalSize) const;
 
   data::Image loadEmbeddedImageAsset(
     const char* replacementName,
@@ -145,9 +275,23 @@ private:
   std::filesystem::path mGamePath;
   std::vector<std::filesystem::path> mModPaths;
   bool mEnableTopLevelMods;
+  int mMaxReplacementScale;
+
+  // Contents of all directories which can hold replacement files, listed
+  // once on construction. Mods are in reverse order, i.e. highest
+  // priority first. The top-level indices are empty unless top-level mods
+  // are enabled.
+  std::vector<DirectoryIndex> mModDirectories;
+  DirectoryIndex mTopLevelDirectory;
+  DirectoryIndex mTopLevelReplacementsDirectory;
 
   assets::CMPFilePackage mFilePackage;
   assets::ActorImagePackage mActorImagePackage;
+
+  // Replacement images are often loaded repeatedly, e.g. when multiple
+  // levels use the same backdrop. Kept behind a pointer so that the
+  // loader stays movable.
+  std::unique_ptr<DecodedImageCache> mpDecodedImages;
 };
 
 } // namespace rigel::assets
@@ -23,9 +23,17 @@
 #include <array>
 #include <cassert>
 #include <cstdint>
-#include <iterator>
 #include <optional>
 
+#if defined(__SSE2__) || defined(_M_X64) || \
+  (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+  #include <emmintrin.h>
+  #define RIGEL_VOC_DECODER_SSE2
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+  #include <arm_neon.h>
+  #define RIGEL_VOC_DECODER_NEON
+#endif
+
 
 /* Decoder for the Creative Voice File (VOC) format
  *
@@ -116,9 +124,11 @@ std::size_t calculateUncompressedSampleCount(
   switch (codec)
   {
     case CodecType::Unsigned8BitPcm:
-    case CodecType::Signed16BitPcm:
       return encodedSize;
 
+    case CodecType::Signed16BitPcm:
+      return encodedSize / sizeof(std::int16_t);
+
     // For the three ADPCM variants, each source byte decodes to N samples.
     // In addition, the first byte is a single Unsigned 8-bit sample.
     case CodecType::Adpcm4Bits:
@@ -291,82 +301,126 @@ private:
 };
 
 
-template <typename TargetIter>
 void decodeAdpcmAudio(
-  LeStreamReader& reader,
+  const base::ArrayView<std::uint8_t> encoded,
   const AdpcmType codec,
-  const std::size_t encodedSize,
-  TargetIter outputIter)
+  base::Sample* pOutput)
 {
-  const auto firstSample = reader.readU8();
-  *outputIter++ = expand8BitSample(firstSample);
+  const auto firstSample = encoded[0];
+  *pOutput++ = expand8BitSample(firstSample);
 
   AdpcmDecoderHelper decoder(firstSample);
-  for (auto i = 0u; i < encodedSize - 1; ++i)
+  for (auto i = std::size_t{1}; i < encoded.size(); ++i)
   {
-    const auto bitPack = reader.readU8();
+    const auto bitPack = encoded[i];
 
     switch (codec)
     {
       case AdpcmType::FourBits:
         // Each byte contains two 4-bit encoded samples
-        *outputIter++ = decoder.decodeBits4(bitPack >> 4);
-        *outputIter++ = decoder.decodeBits4(bitPack & 0b1111);
+        *pOutput++ = decoder.decodeBits4(bitPack >> 4);
+        *pOutput++ = decoder.decodeBits4(bitPack & 0b1111);
         break;
 
       case AdpcmType::TwoPointSixBits:
         // Each byte contains two 3-bit samples and one 2-bit sample
-        *outputIter++ = decoder.decodeBits2_6((bitPack >> 5) & 0b111);
-        *outputIter++ = decoder.decodeBits2_6((bitPack >> 2) & 0b111);
-        *outputIter++ =
+        *pOutput++ = decoder.decodeBits2_6((bitPack >> 5) & 0b111);
+        *pOutput++ = decoder.decodeBits2_6((bitPack >> 2) & 0b111);
+        *pOutput++ =
           decoder.decodeBits2_6((bitPack & 0b10) << 1 | (bitPack & 0b1));
         break;
 
       case AdpcmType::TwoBits:
         // Each byte contains four 2-bit encoded samples
-        *outputIter++ = decoder.decodeBits2((bitPack >> 6) & 0b11);
-        *outputIter++ = decoder.decodeBits2((bitPack >> 4) & 0b11);
-        *outputIter++ = decoder.decodeBits2((bitPack >> 2) & 0b11);
-        *outputIter++ = decoder.decodeBits2((bitPack >> 0) & 0b11);
+        *pOutput++ = decoder.decodeBits2((bitPack >> 6) & 0b11);
+        *pOutput++ = decoder.decodeBits2((bitPack >> 4) & 0b11);
+        *pOutput++ = decoder.decodeBits2((bitPack >> 2) & 0b11);
+        *pOutput++ = decoder.decodeBits2((bitPack >> 0) & 0b11);
         break;
     }
   }
 }
 
 
-template <typename TargetIter>
+void expand8BitSamples(
+  const base::ArrayView<std::uint8_t> encoded,
+  base::Sample* pOutput)
+{
+  auto i = std::size_t{0};
+
+#if defined(RIGEL_VOC_DECODER_SSE2)
+  // Flipping the top bit turns the unsigned samples into signed ones.
+  // Interleaving with zero bytes then yields the signed value times 256,
+  // and an arithmetic shift brings it down to times 128.
+  const auto signBits = _mm_set1_epi8(char(0x80));
+  const auto zero = _mm_setzero_si128();
+
+  for (; i + 16 <= encoded.size(); i += 16)
+  {
+    const auto bytes = _mm_xor_si128(
+      _mm_loadu_si128(reinterpret_cast<const __m128i*>(&encoded[i])),
+      signBits);
+    _mm_storeu_si128(
+      reinterpret_cast<__m128i*>(pOutput + i),
+      _mm_srai_epi16(_mm_unpacklo_epi8(zero, bytes), 1));
+    _mm_storeu_si128(
+      reinterpret_cast<__m128i*>(pOutput + i + 8),
+      _mm_srai_epi16(_mm_unpackhi_epi8(zero, bytes), 1));
+  }
+#elif defined(RIGEL_VOC_DECODER_NEON)
+  const auto signBits = vdupq_n_u8(0x80);
+
+  for (; i + 16 <= encoded.size(); i += 16)
+  {
+    const auto bytes =
+      vreinterpretq_s8_u8(veorq_u8(vld1q_u8(&encoded[i]), signBits));
+    vst1q_s16(pOutput + i, vshlq_n_s16(vmovl_s8(vget_low_s8(bytes)), 7));
+    vst1q_s16(pOutput + i + 8, vshlq_n_s16(vmovl_s8(vget_high_s8(bytes)), 7));
+  }
+#endif
+
+  for (; i < encoded.size(); ++i)
+  {
+    pOutput[i] = expand8BitSample(encoded[i]);
+  }
+}
+
+
+/** Decode encoded audio data into pOutput
+ *
+ * pOutput must have room for calculateUncompressedSampleCount() samples.
+ */
 void decodeAudio(
-  LeStreamReader& reader,
-  const std::size_t encodedSize,
+  const base::ArrayView<std::uint8_t> encoded,
   const CodecType codec,
-  TargetIter outputIter)
+  base::Sample* pOutput)
 {
   switch (codec)
   {
     case CodecType::Unsigned8BitPcm:
-      for (auto i = 0u; i < encodedSize; ++i)
-      {
-        *outputIter++ = expand8BitSample(reader.readU8());
-      }
+      expand8BitSamples(encoded, pOutput);
       break;
 
     case CodecType::Adpcm4Bits:
-      decodeAdpcmAudio(reader, AdpcmType::FourBits, encodedSize, outputIter);
+      decodeAdpcmAudio(encoded, AdpcmType::FourBits, pOutput);
       break;
 
     case CodecType::Adpcm2_6Bits:
-      decodeAdpcmAudio(
-        reader, AdpcmType::TwoPointSixBits, encodedSize, outputIter);
+      decodeAdpcmAudio(encoded, AdpcmType::TwoPointSixBits, pOutput);
       break;
 
     case CodecType::Adpcm2Bits:
-      decodeAdpcmAudio(reader, AdpcmType::TwoBits, encodedSize, outputIter);
+      decodeAdpcmAudio(encoded, AdpcmType::TwoBits, pOutput);
       break;
 
     case CodecType::Signed16BitPcm:
-      for (auto i = 0u; i < encodedSize; ++i)
       {
-        *outputIter++ = reader.readS16();
+        LeStreamReader reader(encoded);
+        const auto numSamples = encoded.size() / sizeof(std::int16_t);
+        for (auto i = std::size_t{0}; i < numSamples; ++i)
+        {
+          *pOutput++ = reader.readS16();
+        }
       }
       break;
   }
@@ -375,7 +429,7 @@ void decodeAudio(
 } // namespace
 
 
-base::AudioBuffer decodeVoc(const ByteBuffer& data)
+base::AudioBuffer decodeVoc(const base::ArrayView<std::uint8_t> data)
 {
   LeStreamReader reader(data);
   if (!readAndValidateVocHeader(reader))
@@ -397,8 +451,7 @@ base::AudioBuffer decodeVoc(const ByteBuffer& data)
     }
     const auto chunkSize = reader.readU24();
 
-    LeStreamReader chunkReader(
-      reader.currentIter(), reader.currentIter() + chunkSize);
+    LeStreamReader chunkReader(reader.peekBytes(chunkSize));
 
     switch (chunkType)
     {
@@ -416,15 +469,19 @@ base::AudioBuffer decodeVoc(const ByteBuffer& data)
           }
 
           const auto codecType = determineCodecType(chunkReader.readU8());
-          const auto encodedAudioSize = chunkSize - sizeof(std::uint8_t) * 2;
-          decodedSamples.reserve(
-            decodedSamples.size() +
-            calculateUncompressedSampleCount(codecType, encodedAudioSize));
-          decodeAudio(
-            chunkReader,
-            encodedAudioSize,
-            codecType,
-            std::back_inserter(decodedSamples));
+          const auto encodedAudio =
+            chunkReader.readBytes(chunkSize - sizeof(std::uint8_t) * 2);
+          if (encodedAudio.size() == 0)
+          {
+            break;
+          }
+
+          // Decode straight into the final buffer
+          const auto offset = decodedSamples.size();
+          decodedSamples.resize(
+            offset +
+            calculateUncompressedSampleCount(codecType, encodedAudio.size()));
+          decodeAudio(encodedAudio, codecType, decodedSamples.data() + offset);
         }
         break;
 
@@ -16,13 +16,15 @@
 
 #pragma once
 
-#include "assets/byte_buffer.hpp"
+#include "base/array_view.hpp"
 #include "base/audio_buffer.hpp"
 
+#include <cstdint>
+
 
 namespace rigel::assets
 {
 
-base::AudioBuffer decodeVoc(const ByteBuffer& data);
+base::AudioBuffer decodeVoc(base::ArrayView<std::uint8_t> data);
 
 }
@@ -23,9 +23,11 @@
 
 #include <algorithm>
 #include <array>
+#include <cmath>
 #include <cstdint>
 #include <memory>
 #include <variant>
+#include <vector>
 
 
 namespace rigel::audio
@@ -91,6 +93,19 @@ public:
   explicit NukedOpl3AdlibEmulator(int sampleRate)
   {
     OPL3_Reset(&mEmulator, sampleRate);
+
+    // Use the same (fixed-point) rate ratio as OPL3_GenerateResampled(), so
+    // that the output matches it.
+    mStep = 1024.0 / mEmulator.rateratio;
+
+    // Enough room for the native samples needed to produce one block of
+    // output, plus the two samples carried over between blocks.
+    mNativeSamples.resize(std::size_t(BLOCK_SIZE * mStep) + 3);
+
+    // Start out with two silent samples, for the same output timing as
+    // OPL3_GenerateResampled().
+    mNativeSamples[0] = 0.0f;
+    mNativeSamples[1] = 0.0f;
   }
 
   NukedOpl3AdlibEmulator(const NukedOpl3AdlibEmulator&) = delete;
@@ -106,19 +121,77 @@ public:
     std::size_t numSamples,
     OutputIt destination,
     const float volumeScale = 1.0f)
+  {
+    // Samples are generated at the chip's native rate and mixed down to mono
+    // first, then resampled to the output rate one block at a time. This
+    // keeps the per-sample work outside of the emulator down to a simple
+    // loop which the compiler can vectorize.
+    while (numSamples > 0)
+    {
+      const auto samplesForIteration = std::min(BLOCK_SIZE, numSamples);
+
+      const auto lastPosition =
+        mPosition + static_cast<double>(samplesForIteration - 1) * mStep;
+      generateNativeSamples(std::size_t(lastPosition) + 2);
+
+      for (auto i = 0u; i < samplesForIteration; ++i)
+      {
+        const auto position = mPosition + i * mStep;
+        const auto index = std::size_t(position);
+        const auto fraction = static_cast<float>(position - index);
+        const auto sample = mNativeSamples[index] +
+          (mNativeSamples[index + 1] - mNativeSamples[index]) * fraction;
+        mOutputBlock[i] = static_cast<std::int16_t>(std::clamp(
+          std::round(sample * volumeScale), -32768.0f, 32767.0f));
+      }
+
+      destination = std::copy(
+        mOutputBlock.begin(),
+        mOutputBlock.begin() + samplesForIteration,
+        destination);
+
+      // Drop the native samples which aren't needed for interpolation
+      // anymore.
+      mPosition += static_cast<double>(samplesForIteration) * mStep;
+      const auto samplesConsumed =
+        std::min(std::size_t(mPosition), mNumNativeSamples);
+      std::copy(
+        mNativeSamples.begin() + samplesConsumed,
+        mNativeSamples.begin() + mNumNativeSamples,
+        mNativeSamples.begin());
+      mNumNativeSamples -= samplesConsumed;
+      mPosition -= static_cast<double>(samplesConsumed);
+
+      numSamples -= samplesForIteration;
+    }
+  }
+
+private:
+  static constexpr auto BLOCK_SIZE = std::size_t{256};
+
+  void generateNativeSamples(const std::size_t count)
   {
     std::array<std::int16_t, 2> stereoPair;
 
-    for (auto i = 0u; i < numSamples; ++i)
+    for (; mNumNativeSamples < count; ++mNumNativeSamples)
     {
-      OPL3_GenerateResampled(&mEmulator, stereoPair.data());
-      const auto mixedSample = stereoPair[0] * 0.5f + stereoPair[1] * 0.5f;
-      *destination++ = base::roundTo<int16_t>(mixedSample * volumeScale);
+      OPL3_Generate(&mEmulator, stereoPair.data());
+      mNativeSamples[mNumNativeSamples] =
+        stereoPair[0] * 0.5f + stereoPair[1] * 0.5f;
     }
   }
 
-private:
   opl3_chip mEmulator;
+
+  // Native samples per output sample
+  double mStep = 1.0;
+
+  // Position of the next output sample, relative to the first entry in
+  // mNativeSamples
+  double mPosition = 0.0;
+  std::vector<float> mNativeSamples;
+  std::size_t mNumNativeSamples = 2;
+  std::array<std::int16_t, BLOCK_SIZE> mOutputBlock;
 };
 
 } // namespace detail
@@ -0,0 +1,112 @@
+/* Copyright (C) 2022, Nikolai Wuttke. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "audio_telemetry.hpp"
+
+
+namespace rigel::audio
+{
+
+namespace
+{
+
+// SDL double-buffers audio output, so a callback can start up to one buffer
+// duration late without the device running out of data.
+constexpr auto MAX_CALLBACK_INTERVAL_IN_BUFFERS = 2.0;
+
+
+void updateMaximum(std::atomic<double>& maximum, const double value)
+{
+  // Only the audio thread writes values other than 0, so there's no need for
+  // a compare-and-swap loop.
+  if (value > maximum.load(std::memory_order_relaxed))
+  {
+    maximum.store(value, std::memory_order_relaxed);
+  }
+}
+
+} // namespace
+
+
+AudioTelemetry::AudioTelemetry(const int sampleRate)
+  : mSampleRate(sampleRate)
+  , mBufferSize(0)
+  , mNumCallbacks(0)
+  , mNumUnderruns(0)
+  , mLastCallbackDuration(0.0)
+  , mWorstCallbackDuration(0.0)
+  , mWorstMusicRenderTime(0.0)
+  , mWorstMixerTime(0.0)
+{
+}
+
+
+void AudioTelemetry::recordMusicRenderTime(const Duration duration)
+{
+  mCurrentMusicRenderTime = duration.count();
+  updateMaximum(mWorstMusicRenderTime, mCurrentMusicRenderTime);
+}
+
+
+void AudioTelemetry::recordMixerTime(
+  const Duration duration,
+  const int bufferSize)
+{
+  const auto now = std::chrono::steady_clock::now();
+  const auto bufferDuration = double(bufferSize) / mSampleRate;
+
+  const auto callbackDuration = mCurrentMusicRenderTime + duration.count();
+  mCurrentMusicRenderTime = 0.0;
+
+  const auto isFirstCallback =
+    mNumCallbacks.load(std::memory_order_relaxed) == 0;
+  const auto interval = Duration(now - mLastCallbackEnd).count();
+  mLastCallbackEnd = now;
+
+  if (
+    callbackDuration > bufferDuration ||
+    (!isFirstCallback &&
+     interval > bufferDuration * MAX_CALLBACK_INTERVAL_IN_BUFFERS))
+  {
+    mNumUnderruns.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  mBufferSize.store(bufferSize, std::memory_order_relaxed);
+  mLastCallbackDuration.store(callbackDuration, std::memory_order_relaxed);
+  updateMaximum(mWorstCallbackDuration, callbackDuration);
+  updateMaximum(mWorstMixerTime, duration.count());
+  mNumCallbacks.fetch_add(1, std::memory_order_relaxed);
+}
+
+
+AudioStats AudioTelemetry::stats() const
+{
+  auto result = AudioStats{};
+  result.mSampleRate = mSampleRate;
+  result.mBufferSize = mBufferSize.load(std::memory_order_relaxed);
+  result.mNumCallbacks = mNumCallbacks.load(std::memory_order_relaxed);
+  result.mNumUnderruns = mNumUnderruns.load(std::memory_order_relaxed);
+  result.mLastCallbackDuration =
+    mLastCallbackDuration.load(std::memory_order_relaxed);
+  result.mWorstCallbackDuration =
+    mWorstCallbackDuration.load(std::memory_order_relaxed);
+  result.mWorstMusicRenderTime =
+    mWorstMusicRenderTime.load(std::memory_order_relaxed);
+  result.mWorstMixerTime = mWorstMixerTime.load(std::memory_order_relaxed);
+  return result;
+}
+
+} // namespace rigel::audio
@@ -0,0 +1,90 @@
+/* Copyright (C) 2022, Nikolai Wuttke. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+
+namespace rigel::audio
+{
+
+/** Snapshot of audio callback timings. All durations are in seconds. */
+struct AudioStats
+{
+  int mSampleRate = 0;
+
+  // Size of the most recent callback's buffer, in sample frames
+  int mBufferSize = 0;
+
+  std::uint64_t mNumCallbacks = 0;
+
+  // Callbacks which took longer than their buffer's playback duration, or
+  // started so late that the device must have run out of data
+  std::uint64_t mNumUnderruns = 0;
+
+  double mLastCallbackDuration = 0.0;
+  double mWorstCallbackDuration = 0.0;
+  double mWorstMusicRenderTime = 0.0;
+  double mWorstMixerTime = 0.0;
+};
+
+
+/** Collects timing measurements in the audio callback
+ *
+ * The callback consists of up to two stages: music rendering (only when
+ * playing IMF music), followed by sound effect mixing, which always runs
+ * last. The audio thread reports each stage's duration, and the game thread
+ * can read the results at any time. Values are updated individually without
+ * locking, so a snapshot might combine values from consecutive callbacks.
+ */
+class AudioTelemetry
+{
+public:
+  using Duration = std::chrono::duration<double>;
+
+  explicit AudioTelemetry(int sampleRate);
+  AudioTelemetry(const AudioTelemetry&) = delete;
+  AudioTelemetry& operator=(const AudioTelemetry&) = delete;
+
+  // Audio thread
+  void recordMusicRenderTime(Duration duration);
+
+  /** Report the sound effect mixer's duration, and complete the callback */
+  void recordMixerTime(Duration duration, int bufferSize);
+
+  // Game thread
+  AudioStats stats() const;
+
+private:
+  int mSampleRate;
+
+  // Only accessed by the audio thread
+  std::chrono::steady_clock::time_point mLastCallbackEnd;
+  double mCurrentMusicRenderTime = 0.0;
+
+  std::atomic<int> mBufferSize;
+  std::atomic<std::uint64_t> mNumCallbacks;
+  std::atomic<std::uint64_t> mNumUnderruns;
+  std::atomic<double> mLastCallbackDuration;
+  std::atomic<double> mWorstCallbackDuration;
+  std::atomic<double> mWorstMusicRenderTime;
+  std::atomic<double> mWorstMixerTime;
+};
+
+} // namespace rigel::audio
@@ -0,0 +1,154 @@
+/* Copyright (C) 2022, Nikolai Wuttke. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "resampling.hpp"
+
+#include "base/math_utils.hpp"
+
+#include <speex/speex_resampler.h>
+
+#include <memory>
+#include <thread>
+
+
+namespace rigel::audio
+{
+
+namespace
+{
+
+int speexQuality(const ResamplingProfile profile)
+{
+  switch (profile)
+  {
+    case ResamplingProfile::Fast:
+      return 2;
+
+    case ResamplingProfile::High:
+      return 8;
+
+    default:
+      return SPEEX_RESAMPLER_QUALITY_DESKTOP;
+  }
+}
+
+
+// Creating a Speex resampler allocates and computes its filter table, which
+// adds up when resampling many short sound effects. Since most sounds share
+// the same sample rates, the state can be kept around and reused.
+class CachedResampler
+{
+public:
+  SpeexResamplerState* get(
+    const int inputRate,
+    const int outputRate,
+    const int quality)
+  {
+    if (
+      !mpState || inputRate != mInputRate || outputRate != mOutputRate ||
+      quality != mQuality)
+    {
+      mpState.reset(
+        speex_resampler_init(1, inputRate, outputRate, quality, nullptr));
+      mInputRate = inputRate;
+      mOutputRate = outputRate;
+      mQuality = quality;
+    }
+    else
+    {
+      speex_resampler_reset_mem(mpState.get());
+    }
+
+    speex_resampler_skip_zeros(mpState.get());
+    return mpState.get();
+  }
+
+private:
+  struct StateDeleter
+  {
+    void operator()(SpeexResamplerState* pState) const
+    {
+      speex_resampler_destroy(pState);
+    }
+  };
+
+  std::unique_ptr<SpeexResamplerState, StateDeleter> mpState;
+  int mInputRate = 0;
+  int mOutputRate = 0;
+  int mQuality = 0;
+};
+
+} // namespace
+
+
+ResamplingProfile resamplingProfile()
+{
+  static const auto profile = []() {
+    const auto numCores = std::thread::hardware_concurrency();
+    if (numCores != 0 && numCores <= 2)
+    {
+      return ResamplingProfile::Fast;
+    }
+
+    return numCores >= 8 ? ResamplingProfile::High
+                         : ResamplingProfile::Balanced;
+  }();
+
+  return profile;
+}
+
+
+base::AudioBuffer
+  resampleAudio(const base::AudioBuffer& buffer, const int newSampleRate)
+{
+  return resampleAudio(buffer, newSampleRate, resamplingProfile());
+}
+
+
+base::AudioBuffer resampleAudio(
+  const base::AudioBuffer& buffer,
+  const int newSampleRate,
+  const ResamplingProfile profile)
+{
+  if (buffer.mSampleRate == newSampleRate)
+  {
+    return buffer;
+  }
+
+  // Sounds are resampled in batches spread across worker threads (see
+  // base::parallelFor), so each thread gets its own resampler.
+  thread_local auto resampler = CachedResampler{};
+  const auto pResampler =
+    resampler.get(buffer.mSampleRate, newSampleRate, speexQuality(profile));
+
+  auto inputLength = static_cast<spx_uint32_t>(buffer.mSamples.size());
+  auto outputLength = static_cast<spx_uint32_t>(
+    base::integerDivCeil<spx_uint32_t>(inputLength, buffer.mSampleRate) *
+    newSampleRate);
+
+  std::vector<base::Sample> resampled(outputLength);
+  speex_resampler_process_int(
+    pResampler,
+    0,
+    buffer.mSamples.data(),
+    &inputLength,
+    resampled.data(),
+    &outputLength);
+  resampled.resize(outputLength);
+  return {newSampleRate, resampled};
+}
+
+} // namespace rigel::audio
@@ -0,0 +1,54 @@
+/* Copyright (C) 2022, Nikolai Wuttke. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "base/audio_buffer.hpp"
+
+
+namespace rigel::audio
+{
+
+/** Trades resampling quality against CPU time */
+enum class ResamplingProfile
+{
+  Fast,
+  Balanced,
+  High
+};
+
+
+/** Profile to use on the current machine
+ *
+ * Picks a profile based on the number of CPU cores, as a rough stand-in for
+ * how powerful the machine is.
+ */
+ResamplingProfile resamplingProfile();
+
+
+/** Convert the given buffer to a different sample rate
+ *
+ * Uses the profile returned by resamplingProfile(), unless specified
+ * otherwise. Safe to call from multiple threads at once.
+ */
+base::AudioBuffer
+  resampleAudio(const base::AudioBuffer& buffer, int newSampleRate);
+base::AudioBuffer resampleAudio(
+  const base::AudioBuffer& buffer,
+  int newSampleRate,
+  ResamplingProfile profile);
+
+} // namespace rigel::audio
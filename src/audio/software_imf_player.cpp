@@ -19,6 +19,9 @@
 #include "base/math_utils.hpp"
 #include "data/game_traits.hpp"
 
+#include <cstring>
+#include <iterator>
+
 
 namespace rigel::audio
 {
@@ -36,30 +39,188 @@ int imfDelayToSamples(const int delay, const int sampleRate)
 } // namespace
 
 
+AdlibRegisters initialAdlibRegisters()
+{
+  // Matches the register write done by the AdlibEmulator constructor.
+  auto registers = AdlibRegisters{};
+  registers[1] = 32;
+  return registers;
+}
+
+
+ImfTimeline::ImfTimeline(data::Song song, const int sampleRate)
+  : mCommands(std::move(song))
+{
+  if (mCommands.empty())
+  {
+    return;
+  }
+
+  mCommandTimes.reserve(mCommands.size() + 1);
+  mKeyframes.reserve(mCommands.size() / KEYFRAME_INTERVAL + 1);
+
+  auto registers = initialAdlibRegisters();
+  auto time = std::size_t{0};
+
+  for (auto i = std::size_t{0}; i < mCommands.size(); ++i)
+  {
+    if (i % KEYFRAME_INTERVAL == 0)
+    {
+      mKeyframes.push_back(registers);
+    }
+
+    const auto& command = mCommands[i];
+    mCommandTimes.push_back(time);
+    registers[command.reg] = command.value;
+    time += static_cast<std::size_t>(
+      imfDelayToSamples(command.delay, sampleRate));
+  }
+
+  mCommandTimes.push_back(time);
+}
+
+
+ImfTimeline::Position ImfTimeline::seek(std::size_t samplePosition) const
+{
+  if (mCommands.empty())
+  {
+    return {initialAdlibRegisters(), 0, 0};
+  }
+
+  const auto length = lengthInSamples();
+  samplePosition = length > 0 ? samplePosition % length : 0;
+
+  // All commands up to and including the given position have been written,
+  // i.e. we are looking for the first command after it. Since the first
+  // command is always at position 0, there's at least one before that.
+  const auto iCommandTimesEnd = mCommandTimes.begin() + mCommands.size();
+  const auto nextCommand = static_cast<std::size_t>(std::distance(
+    mCommandTimes.begin(),
+    std::upper_bound(mCommandTimes.begin(), iCommandTimesEnd, samplePosition)));
+
+  const auto keyframe =
+    std::min(nextCommand / KEYFRAME_INTERVAL, mKeyframes.size() - 1);
+
+  auto result = Position{mKeyframes[keyframe]};
+  for (auto i = keyframe * KEYFRAME_INTERVAL; i < nextCommand; ++i)
+  {
+    result.mRegisters[mCommands[i].reg] = mCommands[i].value;
+  }
+
+  result.mNextCommand = nextCommand < mCommands.size() ? nextCommand : 0;
+  result.mSamplesUntilNextCommand =
+    mCommandTimes[nextCommand] - samplePosition;
+  return result;
+}
+
+
+RenderedSong renderImfSong(
+  const data::Song& song,
+  const int sampleRate,
+  const AdlibEmulator::Type type)
+{
+  auto totalSamples = std::size_t{0};
+  for (const auto& command : song)
+  {
+    totalSamples +=
+      static_cast<std::size_t>(imfDelayToSamples(command.delay, sampleRate));
+  }
+
+  // Commands are processed the same way as in SoftwareImfPlayer::render():
+  // Each command's register write happens before the delay following it.
+  auto emulator = AdlibEmulator{sampleRate, type};
+  auto result = RenderedSong(totalSamples);
+  auto pOutput = result.data();
+
+  for (const auto& command : song)
+  {
+    emulator.writeRegister(command.reg, command.value);
+
+    const auto numSamples = imfDelayToSamples(command.delay, sampleRate);
+    emulator.render(numSamples, pOutput, 1.0f);
+    pOutput += numSamples;
+  }
+
+  return result;
+}
+
+
 SoftwareImfPlayer::SoftwareImfPlayer(const int sampleRate)
   : mEmulator(sampleRate)
-  , miNextCommand(mSongData.end())
+  , mRegisters(initialAdlibRegisters())
+  , miNextCommand(mSong.mTimeline.commands().end())
   , mSampleRate(sampleRate)
-  , mSongSwitchPending(false)
-  , mTypeToUse(mEmulator.type())
+  , mRequestedType(mEmulator.type())
 {
   mVolume.store(1.0f);
+  mPlaybackPosition.store(0);
 }
 
 
 void SoftwareImfPlayer::setType(const AdlibEmulator::Type type)
 {
-  mTypeToUse = type;
+  if (type == mRequestedType)
+  {
+    return;
+  }
+
+  mRequestedType = type;
+  mEmulatorHandoff.submit(std::make_unique<AdlibEmulator>(mSampleRate, type));
 }
 
 
-void SoftwareImfPlayer::playSong(data::Song&& song)
+void SoftwareImfPlayer::playSong(
+  data::Song&& song,
+  const std::size_t startPosition)
 {
+  auto pSource = std::make_unique<SongSource>();
+  pSource->mTimeline = ImfTimeline{std::move(song), mSampleRate};
+
+  if (startPosition != 0)
   {
-    std::lock_guard<std::mutex> takeLock{mAudioLock};
-    mNextSongData = std::move(song);
+    pSource->moStartPosition = pSource->mTimeline.seek(startPosition);
+  }
+
+  mSongHandoff.submit(std::move(pSource));
+}
+
+
+void SoftwareImfPlayer::playRenderedSong(
+  std::shared_ptr<const RenderedSong> pSong,
+  const std::size_t startPosition)
+{
+  auto pSource = std::make_unique<SongSource>();
+  pSource->mStartSample =
+    pSong && !pSong->empty() ? startPosition % pSong->size() : 0;
+  pSource->mpRendered = std::move(pSong);
+
+  mSongHandoff.submit(std::move(pSource));
+}
+
+
+std::size_t SoftwareImfPlayer::playbackPosition() const
+{
+  return mPlaybackPosition.load(std::memory_order_relaxed);
+}
+
+
+void SoftwareImfPlayer::startSong()
+{
+  const auto& commands = mSong.mTimeline.commands();
+
+  miNextCommand = commands.begin();
+  mSamplesAvailable = 0;
+  miNextRenderedSample = mSong.mStartSample;
+
+  if (mSong.moStartPosition)
+  {
+    const auto& position = *mSong.moStartPosition;
+
+    mRegisters = position.mRegisters;
+    restoreRegisters(mEmulator);
+    miNextCommand = commands.begin() + position.mNextCommand;
+    mSamplesAvailable = position.mSamplesUntilNextCommand;
   }
-  mSongSwitchPending = true;
 }
 
 
@@ -69,36 +230,68 @@ void SoftwareImfPlayer::setVolume(const float volume)
 }
 
 
-void SoftwareImfPlayer::render(
-  std::int16_t* pBuffer,
-  std::size_t samplesRequired)
+void SoftwareImfPlayer::writeRegister(
+  const std::uint8_t reg,
+  const std::uint8_t value)
 {
-  const auto emulatorType = mTypeToUse.load();
-  if (emulatorType != mEmulator.type())
+  mRegisters[reg] = value;
+  mEmulator.writeRegister(reg, value);
+}
+
+
+void SoftwareImfPlayer::restoreRegisters(AdlibEmulator& emulator) const
+{
+  auto isKeyOnRegister = [](const std::size_t reg) {
+    return (reg >= 0xB0 && reg <= 0xB8) || reg == 0xBD;
+  };
+
+  // Set up all instrument and frequency state first, so that notes which are
+  // currently playing are triggered with the right sound.
+  for (auto reg = std::size_t{0}; reg < mRegisters.size(); ++reg)
   {
-    mEmulator = AdlibEmulator{mSampleRate, emulatorType};
+    if (!isKeyOnRegister(reg))
+    {
+      emulator.writeRegister(std::uint8_t(reg), mRegisters[reg]);
+    }
+  }
 
-    // Replay all previously played commands
-    for (auto iCommand = mSongData.begin(); iCommand != miNextCommand;
-         ++iCommand)
+  for (auto reg = std::size_t{0}; reg < mRegisters.size(); ++reg)
+  {
+    if (isKeyOnRegister(reg))
     {
-      mEmulator.writeRegister(iCommand->reg, iCommand->value);
+      emulator.writeRegister(std::uint8_t(reg), mRegisters[reg]);
     }
   }
+}
+
+
+void SoftwareImfPlayer::render(
+  std::int16_t* pBuffer,
+  std::size_t samplesRequired)
+{
+  mEmulatorHandoff.tryTake(mEmulator, [this](AdlibEmulator& newEmulator) {
+    restoreRegisters(newEmulator);
+  });
 
-  if (mSongSwitchPending && mAudioLock.try_lock())
+  if (mSongHandoff.tryTake(mSong, [](SongSource&) {}))
   {
-    mSongData = std::move(mNextSongData);
-    mSongSwitchPending = false;
-    mAudioLock.unlock();
+    startSong();
+  }
 
-    miNextCommand = mSongData.begin();
-    mSamplesAvailable = 0;
+  if (mSong.mpRendered && !mSong.mpRendered->empty())
+  {
+    renderFromRecording(pBuffer, samplesRequired);
+    mPlaybackPosition.store(miNextRenderedSample, std::memory_order_relaxed);
+    return;
   }
 
-  if (mSongData.empty())
+  const auto& timeline = mSong.mTimeline;
+  const auto& commands = timeline.commands();
+
+  if (commands.empty())
   {
     std::fill(pBuffer, pBuffer + samplesRequired, int16_t{0});
+    mPlaybackPosition.store(0, std::memory_order_relaxed);
     return;
   }
 
@@ -115,11 +308,11 @@ void SoftwareImfPlayer::render(
     {
       const auto& command = *miNextCommand;
       commandDelay = command.delay;
-      mEmulator.writeRegister(command.reg, command.value);
+      writeRegister(command.reg, command.value);
       ++miNextCommand;
-      if (miNextCommand == mSongData.end())
+      if (miNextCommand == commands.end())
       {
-        miNextCommand = mSongData.begin();
+        miNextCommand = commands.begin();
       }
     } while (commandDelay == 0);
 
@@ -128,6 +321,54 @@ void SoftwareImfPlayer::render(
 
   mEmulator.render(samplesRequired, pBuffer, volume);
   mSamplesAvailable -= samplesRequired;
+
+  // Once we have wrapped around, the next command is the first one, but
+  // we're still at the end of the song.
+  const auto nextCommand =
+    static_cast<std::size_t>(std::distance(commands.begin(), miNextCommand));
+  const auto nextCommandTime = nextCommand == 0
+    ? timeline.lengthInSamples()
+    : timeline.commandTime(nextCommand);
+  const auto length = std::max<std::size_t>(timeline.lengthInSamples(), 1);
+  mPlaybackPosition.store(
+    (nextCommandTime - mSamplesAvailable) % length,
+    std::memory_order_relaxed);
+}
+
+
+void SoftwareImfPlayer::renderFromRecording(
+  std::int16_t* pBuffer,
+  std::size_t samplesRequired)
+{
+  const auto& samples = *mSong.mpRendered;
+  const auto volume = mVolume.load();
+
+  while (samplesRequired > 0)
+  {
+    const auto count =
+      std::min(samplesRequired, samples.size() - miNextRenderedSample);
+    const auto pSource = samples.data() + miNextRenderedSample;
+
+    if (volume == 1.0f)
+    {
+      std::memcpy(pBuffer, pSource, count * sizeof(std::int16_t));
+    }
+    else
+    {
+      std::transform(pSource, pSource + count, pBuffer, [volume](auto sample) {
+        return static_cast<std::int16_t>(sample * volume);
+      });
+    }
+
+    pBuffer += count;
+    samplesRequired -= count;
+    miNextRenderedSample += count;
+
+    if (miNextRenderedSample == samples.size())
+    {
+      miNextRenderedSample = 0;
+    }
+  }
 }
 
 
@@ -19,13 +19,194 @@
 #include "audio/adlib_emulator.hpp"
 #include "data/song.hpp"
 
+#include <algorithm>
+#include <array>
 #include <atomic>
-#include <mutex>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <utility>
+#include <vector>
 
 
 namespace rigel::audio
 {
 
+namespace detail
+{
+
+/** Lock-free hand-over of objects from the main thread to the audio thread
+ *
+ * The main thread submits heap-allocated objects, and the audio thread swaps
+ * their contents with its own instance. The previous contents are then sent
+ * back to the main thread, where they are deleted on the next submit or on
+ * destruction. This way, the audio thread never allocates, frees or waits
+ * for a lock.
+ */
+template <typename T>
+class AudioThreadHandoff
+{
+public:
+  AudioThreadHandoff()
+    : mpPending(nullptr)
+  {
+    for (auto& slot : mRetired)
+    {
+      slot.store(nullptr);
+    }
+  }
+
+  AudioThreadHandoff(const AudioThreadHandoff&) = delete;
+  AudioThreadHandoff& operator=(const AudioThreadHandoff&) = delete;
+
+  ~AudioThreadHandoff()
+  {
+    reclaimRetired();
+    delete mpPending.exchange(nullptr);
+  }
+
+  /** Main thread: Make value available to the audio thread
+   *
+   * If the audio thread hasn't picked up a previously submitted value yet,
+   * that value is discarded.
+   */
+  void submit(std::unique_ptr<T> pValue)
+  {
+    reclaimRetired();
+    delete mpPending.exchange(pValue.release(), std::memory_order_acq_rel);
+  }
+
+  /** Audio thread: Swap current with the most recently submitted value
+   *
+   * prepare is invoked on the incoming value before swapping. Returns true
+   * if a swap took place.
+   */
+  template <typename PrepareFunc>
+  bool tryTake(T& current, PrepareFunc&& prepare)
+  {
+    // Only the audio thread ever fills the retired slots, so a slot which is
+    // empty now will still be empty when we fill it below. The main thread
+    // reclaims all slots before each submit, so a free one should always be
+    // available. Should that ever not be the case, we keep the current value
+    // and try again during the next callback.
+    auto iFreeSlot =
+      std::find_if(mRetired.begin(), mRetired.end(), [](const auto& slot) {
+        return slot.load(std::memory_order_relaxed) == nullptr;
+      });
+    if (iFreeSlot == mRetired.end())
+    {
+      return false;
+    }
+
+    auto pIncoming = mpPending.exchange(nullptr, std::memory_order_acq_rel);
+    if (!pIncoming)
+    {
+      return false;
+    }
+
+    prepare(*pIncoming);
+
+    // Afterwards, pIncoming holds the previous value, which goes back to the
+    // main thread for deletion.
+    std::swap(current, *pIncoming);
+    iFreeSlot->store(pIncoming, std::memory_order_release);
+    return true;
+  }
+
+private:
+  void reclaimRetired()
+  {
+    for (auto& slot : mRetired)
+    {
+      delete slot.exchange(nullptr, std::memory_order_acquire);
+    }
+  }
+
+  static constexpr auto RETIRED_SLOTS = std::size_t{4};
+
+  std::atomic<T*> mpPending;
+  std::array<std::atomic<T*>, RETIRED_SLOTS> mRetired;
+};
+
+} // namespace detail
+
+
+using RenderedSong = std::vector<std::int16_t>;
+using AdlibRegisters = std::array<std::uint8_t, 256>;
+
+
+/** Register state of a freshly created AdlibEmulator */
+AdlibRegisters initialAdlibRegisters();
+
+
+/** IMF song preprocessed for playback at a specific sample rate
+ *
+ * Stores the absolute position (in samples) of each command, plus snapshots
+ * of the complete register state every KEYFRAME_INTERVAL commands. This
+ * makes it possible to start playback at any point in the song without
+ * stepping through all commands from the beginning: seek() finds the right
+ * command via binary search, and then replays at most KEYFRAME_INTERVAL
+ * commands on top of the closest preceding snapshot.
+ */
+class ImfTimeline
+{
+public:
+  static constexpr auto KEYFRAME_INTERVAL = std::size_t{256};
+
+  struct Position
+  {
+    /** Register state once all commands before mNextCommand are applied */
+    AdlibRegisters mRegisters;
+    std::size_t mNextCommand = 0;
+    std::size_t mSamplesUntilNextCommand = 0;
+  };
+
+  ImfTimeline() = default;
+  ImfTimeline(data::Song song, int sampleRate);
+
+  const data::Song& commands() const { return mCommands; }
+
+  bool empty() const { return mCommands.empty(); }
+
+  /** Number of samples for one full pass through the song */
+  std::size_t lengthInSamples() const
+  {
+    return mCommandTimes.empty() ? 0 : mCommandTimes.back();
+  }
+
+  /** Sample position at which the given command is written
+   *
+   * Passing the number of commands gives the song's length.
+   */
+  std::size_t commandTime(const std::size_t index) const
+  {
+    return mCommandTimes[index];
+  }
+
+  /** Playback state at the given sample position
+   *
+   * Positions past the end wrap around, since songs play in a loop.
+   */
+  Position seek(std::size_t samplePosition) const;
+
+private:
+  data::Song mCommands;
+  std::vector<std::size_t> mCommandTimes;
+  std::vector<AdlibRegisters> mKeyframes;
+};
+
+
+/** Render one full pass through the given song into mono PCM samples
+ *
+ * Uses a freshly created emulator, at full volume. The result can be played
+ * back via SoftwareImfPlayer::playRenderedSong().
+ */
+RenderedSong renderImfSong(
+  const data::Song& song,
+  int sampleRate,
+  AdlibEmulator::Type type);
+
+
 class SoftwareImfPlayer
 {
 public:
@@ -35,24 +216,64 @@ public:
 
   void setType(AdlibEmulator::Type type);
 
-  void playSong(data::Song&& song);
+  /** Play the given song in a loop, starting at the given sample position
+   *
+   * Starting anywhere but the beginning restores the complete register
+   * state for that position first, so that notes which should be playing
+   * at that point are heard.
+   */
+  void playSong(data::Song&& song, std::size_t startPosition = 0);
+
+  /** Play a previously rendered song in a loop, without any emulation */
+  void playRenderedSong(
+    std::shared_ptr<const RenderedSong> pSong,
+    std::size_t startPosition = 0);
+
+  /** Position within the current song, in samples since its start
+   *
+   * Updated by render(), so a song submitted via playSong() only shows up
+   * here once the audio thread has picked it up.
+   */
+  std::size_t playbackPosition() const;
+
   void setVolume(const float volume);
 
   void render(std::int16_t* pBuffer, std::size_t samplesRequired);
 
 private:
+  // Either a song to emulate, or pre-rendered samples
+  struct SongSource
+  {
+    ImfTimeline mTimeline;
+    std::shared_ptr<const RenderedSong> mpRendered;
+    std::optional<ImfTimeline::Position> moStartPosition;
+    std::size_t mStartSample = 0;
+  };
+
+  void startSong();
+
+  void renderFromRecording(std::int16_t* pBuffer, std::size_t samplesRequired);
+  void writeRegister(std::uint8_t reg, std::uint8_t value);
+  void restoreRegisters(AdlibEmulator& emulator) const;
+
   AdlibEmulator mEmulator;
-  std::mutex mAudioLock;
-  data::Song mNextSongData;
 
-  data::Song mSongData;
+  // Shadow copy of the emulator's register file, used to bring a newly
+  // created emulator into the current state when switching emulator types.
+  AdlibRegisters mRegisters;
+
+  detail::AudioThreadHandoff<AdlibEmulator> mEmulatorHandoff;
+  detail::AudioThreadHandoff<SongSource> mSongHandoff;
+
+  SongSource mSong;
   data::Song::const_iterator miNextCommand;
   std::size_t mSamplesAvailable = 0;
+  std::size_t miNextRenderedSample = 0;
   int mSampleRate;
+  AdlibEmulator::Type mRequestedType;
 
   std::atomic<float> mVolume;
-  std::atomic<bool> mSongSwitchPending;
-  std::atomic<AdlibEmulator::Type> mTypeToUse;
+  std::atomic<std::size_t> mPlaybackPosition;
 };
 
 } // namespace rigel::audio
@@ -0,0 +1,264 @@
+/* Copyright (C) 2022, Nikolai Wuttke. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "sound_effect_mixer.hpp"
+
+#include <loguru.hpp>
+
+#include <algorithm>
+#include <cassert>
+
+#if defined(__SSE2__) || defined(_M_X64) || \
+  (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+  #include <emmintrin.h>
+  #define RIGEL_MIXER_SSE2
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+  #include <arm_neon.h>
+  #define RIGEL_MIXER_NEON
+#endif
+
+
+namespace rigel::audio
+{
+
+namespace
+{
+
+// Adds source samples scaled by volume (in 1.15 fixed point) to the
+// destination, saturating at the limits of the 16-bit range.
+void mixSamples(
+  std::int16_t* pDestination,
+  const std::int16_t* pSource,
+  const std::size_t count,
+  const std::int16_t volume)
+{
+  auto i = std::size_t{0};
+
+#if defined(RIGEL_MIXER_SSE2)
+  const auto volumes = _mm_set1_epi16(volume);
+  for (; i + 8 <= count; i += 8)
+  {
+    const auto source =
+      _mm_loadu_si128(reinterpret_cast<const __m128i*>(pSource + i));
+
+    // Assemble the full 32-bit products from their low and high halves
+    const auto productsLow = _mm_mullo_epi16(source, volumes);
+    const auto productsHigh = _mm_mulhi_epi16(source, volumes);
+    const auto scaled = _mm_packs_epi32(
+      _mm_srai_epi32(_mm_unpacklo_epi16(productsLow, productsHigh), 15),
+      _mm_srai_epi32(_mm_unpackhi_epi16(productsLow, productsHigh), 15));
+
+    const auto pTarget = reinterpret_cast<__m128i*>(pDestination + i);
+    _mm_storeu_si128(pTarget, _mm_adds_epi16(_mm_loadu_si128(pTarget), scaled));
+  }
+#elif defined(RIGEL_MIXER_NEON)
+  for (; i + 8 <= count; i += 8)
+  {
+    const auto scaled = vqdmulhq_n_s16(vld1q_s16(pSource + i), volume);
+    const auto pTarget = pDestination + i;
+    vst1q_s16(pTarget, vqaddq_s16(vld1q_s16(pTarget), scaled));
+  }
+#endif
+
+  for (; i < count; ++i)
+  {
+    const auto scaled = (std::int32_t{pSource[i]} * volume) >> 15;
+    pDestination[i] = static_cast<std::int16_t>(
+      std::clamp(pDestination[i] + scaled, -32768, 32767));
+  }
+}
+
+} // namespace
+
+
+SoundEffectMixer::SoundEffectMixer(
+  const std::size_t numVoices,
+  const std::size_t maxActiveVoices)
+  : mVoices(numVoices)
+  , mMaxActiveVoices(maxActiveVoices)
+  , mLastQueuedPlay(numVoices, 0)
+  , mCommandsWritten(0)
+  , mCommandsRead(0)
+  , mVolume(1.0f)
+{
+}
+
+
+void SoundEffectMixer::play(
+  const std::size_t voice,
+  const base::ArrayView<std::int16_t> samples,
+  const int priority)
+{
+  // Playing the same sound several times within one game frame is common,
+  // e.g. when multiple enemies are hit at once. Until the audio thread has
+  // picked up the first play command, any further ones would only restart
+  // the voice at the exact same position, so they can be skipped.
+  if (isVoiceQueuedForPlay(voice))
+  {
+    return;
+  }
+
+  const auto position = mCommandsWritten.load(std::memory_order_relaxed);
+  if (enqueue({voice, samples, priority}))
+  {
+    mLastQueuedPlay[voice] = position + 1;
+  }
+}
+
+
+void SoundEffectMixer::stop(const std::size_t voice)
+{
+  if (enqueue({voice, {}, 0}))
+  {
+    mLastQueuedPlay[voice] = 0;
+  }
+}
+
+
+void SoundEffectMixer::setVolume(const float volume)
+{
+  mVolume.store(std::clamp(volume, 0.0f, 1.0f));
+}
+
+
+void SoundEffectMixer::reset()
+{
+  mCommandsRead.store(mCommandsWritten.load());
+  std::fill(mVoices.begin(), mVoices.end(), Voice{});
+  std::fill(mLastQueuedPlay.begin(), mLastQueuedPlay.end(), 0);
+}
+
+
+bool SoundEffectMixer::isVoiceQueuedForPlay(const std::size_t voice) const
+{
+  const auto lastPlay = mLastQueuedPlay[voice];
+  return lastPlay != 0 &&
+    lastPlay > mCommandsRead.load(std::memory_order_acquire);
+}
+
+
+bool SoundEffectMixer::enqueue(const Command& command)
+{
+  assert(command.mVoice < mVoices.size());
+
+  const auto written = mCommandsWritten.load(std::memory_order_relaxed);
+  const auto read = mCommandsRead.load(std::memory_order_acquire);
+  if (written - read >= COMMAND_QUEUE_SIZE)
+  {
+    // The audio thread hasn't run for a long time, e.g. because the device
+    // is paused. Dropping the command is better than blocking the game.
+    LOG_F(WARNING, "Sound command queue full, dropping command");
+    return false;
+  }
+
+  mCommands[written % COMMAND_QUEUE_SIZE] = command;
+  mCommandsWritten.store(written + 1, std::memory_order_release);
+  return true;
+}
+
+
+void SoundEffectMixer::applyPendingCommands()
+{
+  const auto written = mCommandsWritten.load(std::memory_order_acquire);
+  auto read = mCommandsRead.load(std::memory_order_relaxed);
+
+  for (; read != written; ++read)
+  {
+    const auto& command = mCommands[read % COMMAND_QUEUE_SIZE];
+    if (command.mSamples.empty())
+    {
+      mVoices[command.mVoice] = Voice{};
+    }
+    else
+    {
+      startVoice(command);
+    }
+  }
+
+  mCommandsRead.store(read, std::memory_order_release);
+}
+
+
+void SoundEffectMixer::startVoice(const Command& command)
+{
+  auto& target = mVoices[command.mVoice];
+
+  // Restarting a voice that's already playing doesn't need an extra slot
+  if (target.mSamplesLeft == 0)
+  {
+    auto numActive = std::size_t{0};
+    Voice* pVictim = nullptr;
+
+    for (auto& voice : mVoices)
+    {
+      if (voice.mSamplesLeft == 0)
+      {
+        continue;
+      }
+
+      ++numActive;
+
+      if (
+        !pVictim || voice.mPriority < pVictim->mPriority ||
+        (voice.mPriority == pVictim->mPriority &&
+         voice.mStartIndex < pVictim->mStartIndex))
+      {
+        pVictim = &voice;
+      }
+    }
+
+    if (numActive >= mMaxActiveVoices)
+    {
+      if (!pVictim || pVictim->mPriority > command.mPriority)
+      {
+        return;
+      }
+
+      *pVictim = Voice{};
+    }
+  }
+
+  target = Voice{
+    command.mSamples.data(),
+    command.mSamples.size(),
+    mNextStartIndex++,
+    command.mPriority};
+}
+
+
+void SoundEffectMixer::mix(std::int16_t* pBuffer, const std::size_t numSamples)
+{
+  applyPendingCommands();
+
+  const auto volume =
+    static_cast<std::int16_t>(std::min(mVolume.load() * 32768.0f, 32767.0f));
+
+  for (auto& voice : mVoices)
+  {
+    if (voice.mSamplesLeft == 0)
+    {
+      continue;
+    }
+
+    const auto count = std::min(voice.mSamplesLeft, numSamples);
+    mixSamples(pBuffer, voice.mpNextSample, count, volume);
+
+    voice.mpNextSample += count;
+    voice.mSamplesLeft -= count;
+  }
+}
+
+} // namespace rigel::audio
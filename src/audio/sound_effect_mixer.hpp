@@ -0,0 +1,112 @@
+/* Copyright (C) 2022, Nikolai Wuttke. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "base/array_view.hpp"
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+
+namespace rigel::audio
+{
+
+/** Mixes sound effects into the audio output
+ *
+ * Sounds are played on a fixed set of voices. Starting or stopping a voice
+ * from the game thread only places a command into a lock-free queue, which
+ * the audio thread works through at the start of each mix() call. This way,
+ * triggering a sound never has to wait for the audio thread.
+ *
+ * Sample data must be in the output device's format (signed 16-bit,
+ * interleaved channels) and stay alive for as long as it might be playing.
+ * To replace sample data that might be in use, make sure that mix() can't
+ * run and call reset() first.
+ *
+ * At most maxActiveVoices voices are audible at the same time. When a sound
+ * is started while all of them are busy, the lowest priority voice is cut
+ * off to make room, picking the one that has been playing the longest among
+ * equals. If every active voice has a higher priority than the new sound,
+ * the new sound is dropped instead. Restarting a voice multiple times
+ * before the audio thread gets to see it results in a single restart.
+ */
+class SoundEffectMixer
+{
+public:
+  SoundEffectMixer(std::size_t numVoices, std::size_t maxActiveVoices);
+  SoundEffectMixer(const SoundEffectMixer&) = delete;
+  SoundEffectMixer& operator=(const SoundEffectMixer&) = delete;
+
+  // Game thread
+  void play(
+    std::size_t voice,
+    base::ArrayView<std::int16_t> samples,
+    int priority = 0);
+  void stop(std::size_t voice);
+  void setVolume(float volume);
+
+  /** Stop all voices and discard pending commands
+   *
+   * Must only be called while mix() can't run, e.g. after removing the
+   * audio callback.
+   */
+  void reset();
+
+  // Audio thread
+  void mix(std::int16_t* pBuffer, std::size_t numSamples);
+
+private:
+  struct Command
+  {
+    std::size_t mVoice;
+    base::ArrayView<std::int16_t> mSamples;
+    int mPriority;
+  };
+
+  struct Voice
+  {
+    const std::int16_t* mpNextSample = nullptr;
+    std::size_t mSamplesLeft = 0;
+    std::uint64_t mStartIndex = 0;
+    int mPriority = 0;
+  };
+
+  static constexpr auto COMMAND_QUEUE_SIZE = std::size_t{256};
+
+  bool enqueue(const Command& command);
+  void applyPendingCommands();
+  void startVoice(const Command& command);
+  bool isVoiceQueuedForPlay(std::size_t voice) const;
+
+  std::vector<Voice> mVoices;
+  std::size_t mMaxActiveVoices;
+  std::uint64_t mNextStartIndex = 1;
+
+  // Game thread only: position in the command queue of the most recent play
+  // command for each voice, plus one (0 means none was ever queued)
+  std::vector<std::size_t> mLastQueuedPlay;
+
+  std::array<Command, COMMAND_QUEUE_SIZE> mCommands;
+  std::atomic<std::size_t> mCommandsWritten;
+  std::atomic<std::size_t> mCommandsRead;
+  std::atomic<float> mVolume;
+};
+
+} // namespace rigel::audio
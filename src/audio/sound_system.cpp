@@ -16,22 +16,36 @@
 
 #include "sound_system.hpp"
 
+#include "assets/asset_cache.hpp"
 #include "assets/audio_package.hpp"
+#include "assets/file_utils.hpp"
 #include "assets/resource_loader.hpp"
 #include "audio/adlib_emulator.hpp"
+#include "audio/audio_telemetry.hpp"
+#include "audio/resampling.hpp"
 #include "audio/software_imf_player.hpp"
+#include "audio/sound_effect_mixer.hpp"
+#include "base/clock.hpp"
 #include "base/math_utils.hpp"
+#include "base/parallel.hpp"
+#include "base/startup_timings.hpp"
 #include "base/string_utils.hpp"
+#include "base/tracing.hpp"
 #include "sdl_utils/error.hpp"
 
 #include <loguru.hpp>
-#include <speex/speex_resampler.h>
 
 #include <algorithm>
+#include <array>
 #include <cassert>
+#include <chrono>
 #include <cstring>
+#include <filesystem>
 #include <iostream>
+#include <optional>
+#include <string>
 #include <utility>
+#include <vector>
 
 
 namespace rigel::sdl_mixer
@@ -67,33 +81,23 @@ const auto COMBINED_SOUNDS_ADLIB_PERCENTAGE = 0.30f;
 const auto DESIRED_SAMPLE_RATE = 44100;
 const auto BUFFER_SIZE = 2048;
 
-base::AudioBuffer
-  resampleAudio(const base::AudioBuffer& buffer, const int newSampleRate)
-{
-  using ResamplerPtr =
-    std::unique_ptr<SpeexResamplerState, decltype(&speex_resampler_destroy)>;
-  ResamplerPtr pResampler(
-    speex_resampler_init(1, buffer.mSampleRate, newSampleRate, 5, nullptr),
-    &speex_resampler_destroy);
-  speex_resampler_skip_zeros(pResampler.get());
+// In low latency mode, these are tried in order until the audio device
+// accepts one. If none works, we fall back to BUFFER_SIZE.
+const auto LOW_LATENCY_BUFFER_SIZES = std::array{256, 512, 1024};
 
-  auto inputLength = static_cast<spx_uint32_t>(buffer.mSamples.size());
-  auto outputLength = static_cast<spx_uint32_t>(
-    base::integerDivCeil<spx_uint32_t>(inputLength, buffer.mSampleRate) *
-    newSampleRate);
+// How many replacement song files to keep in memory after they were played.
+// Level music is often repeated (e.g. after a restart, or when going back
+// to the menu), so this avoids re-reading large files from disk.
+const auto MAX_RECENT_REPLACEMENT_SONGS = std::size_t{4};
 
-  std::vector<base::Sample> resampled(outputLength);
-  speex_resampler_process_int(
-    pResampler.get(),
-    0,
-    buffer.mSamples.data(),
-    &inputLength,
-    resampled.data(),
-    &outputLength);
-  resampled.resize(outputLength);
-  return {newSampleRate, resampled};
-}
+// How many pre-rendered IMF songs to keep in memory. A typical song takes
+// around 15 MB at 44.1 kHz, evicted songs can be reloaded from the asset cache.
+const auto MAX_PRERENDERED_SONGS = std::size_t{3};
 
+// Upper limit for simultaneously audible sound effects. Busy scenes (lots of
+// explosions, enemies being hit etc.) would otherwise turn into noise, and
+// the cost of mixing grows with each active voice.
+const auto MAX_ACTIVE_SOUND_EFFECTS = std::size_t{8};
 
 void appendRampToZero(base::AudioBuffer& buffer, const int sampleRate)
 {
@@ -112,7 +116,7 @@ void appendRampToZero(base::AudioBuffer& buffer, const int sampleRate)
 }
 
 
-// Prepares the given audio buffer to be loaded into a Mix_Chunk. This includes
+// Prepares the given audio buffer to be played back. This includes
 // resampling to the given sample rate and making sure the buffer ends in a
 // zero value to avoid clicks/pops.
 base::AudioBuffer
@@ -191,6 +195,59 @@ auto idToIndex(const data::SoundId id)
   return static_cast<int>(id);
 }
 
+
+// When more sound effects are playing than MAX_ACTIVE_SOUND_EFFECTS, lower
+// priority sounds are cut off first. Feedback about the player's state is
+// most important, followed by the player's own actions, while enemy and
+// ambient sounds are the most expendable.
+int soundPriority(const data::SoundId id)
+{
+  using data::SoundId;
+
+  switch (id)
+  {
+    case SoundId::DukeDeath:
+    case SoundId::MenuSelect:
+    case SoundId::MenuToggle:
+    case SoundId::IntroGunShot:
+    case SoundId::IntroGunShotLow:
+    case SoundId::IntroEmptyShellsFalling:
+    case SoundId::IntroTargetMovingCloser:
+    case SoundId::IntroTargetStopsMoving:
+    case SoundId::IntroDukeSpeaks1:
+    case SoundId::IntroDukeSpeaks2:
+      return 4;
+
+    case SoundId::DukePain:
+    case SoundId::ItemPickup:
+    case SoundId::WeaponPickup:
+    case SoundId::HealthPickup:
+    case SoundId::LettersCollectedCorrectly:
+    case SoundId::BlueKeyDoorOpened:
+    case SoundId::Teleport:
+    case SoundId::IngameMessageTyping:
+      return 3;
+
+    case SoundId::DukeNormalShot:
+    case SoundId::DukeLaserShot:
+    case SoundId::FlameThrowerShot:
+    case SoundId::DukeJumping:
+    case SoundId::DukeLanding:
+    case SoundId::DukeAttachClimbable:
+      return 2;
+
+    case SoundId::WaterDrop:
+    case SoundId::LavaFountain:
+    case SoundId::ForceFieldFizzle:
+    case SoundId::SlidingDoor:
+    case SoundId::FallingRock:
+      return 0;
+
+    default:
+      return 1;
+  }
+}
+
 base::AudioBuffer renderAdlibSound(
   const assets::AdlibSound& sound,
   const AdlibEmulator::Type emulatorType)
@@ -237,22 +294,203 @@ base::AudioBuffer renderAdlibSound(
 }
 
 
+// The AdLib versions of all sound effects, rendered via the emulator and
+// prepared for the output sample rate. Indexed by sound ID.
+using AdlibSoundSet = std::vector<base::AudioBuffer>;
+
+
+std::string adlibSoundsCacheEntryName(
+  const AdlibEmulator::Type emulatorType,
+  const int sampleRate)
+{
+  return "adlib_sounds_" + std::to_string(int(emulatorType)) + "_" +
+    std::to_string(sampleRate) + "_" +
+    std::to_string(int(resamplingProfile()));
+}
+
+
+assets::ByteBuffer serializeAdlibSounds(const AdlibSoundSet& sounds)
+{
+  assets::LeStreamWriter writer;
+
+  writer.writeU32(std::uint32_t(sounds.size()));
+  for (const auto& sound : sounds)
+  {
+    writer.writeU32(std::uint32_t(sound.mSampleRate));
+    writer.writeU32(std::uint32_t(sound.mSamples.size()));
+    for (const auto sample : sound.mSamples)
+    {
+      writer.writeU16(std::uint16_t(sample));
+    }
+  }
+
+  return writer.buffer();
+}
+
+
+std::optional<AdlibSoundSet> readCachedAdlibSounds(
+  const base::ArrayView<std::uint8_t> payload,
+  const std::size_t expectedCount)
+{
+  try
+  {
+    assets::LeStreamReader reader(payload);
+
+    if (reader.readU32() != expectedCount)
+    {
+      return std::nullopt;
+    }
+
+    auto result = AdlibSoundSet{};
+    result.reserve(expectedCount);
+
+    for (auto i = 0u; i < expectedCount; ++i)
+    {
+      const auto sampleRate = int(reader.readU32());
+      const auto numSamples = reader.readU32();
+
+      auto samples = std::vector<base::Sample>{};
+      samples.reserve(numSamples);
+      for (auto sample = 0u; sample < numSamples; ++sample)
+      {
+        samples.push_back(reader.readS16());
+      }
+
+      result.push_back({sampleRate, std::move(samples)});
+    }
+
+    return result;
+  }
+  catch (const std::exception& ex)
+  {
+    LOG_F(WARNING, "Ignoring invalid AdLib sound cache entry: %s", ex.what());
+    return std::nullopt;
+  }
+}
+
+
+std::string prerenderedSongCacheEntryName(
+  const std::string& songName,
+  const AdlibEmulator::Type emulatorType,
+  const int sampleRate)
+{
+  return "imf_song_" + songName + "_" + std::to_string(int(emulatorType)) +
+    "_" + std::to_string(sampleRate);
+}
+
+
+assets::ByteBuffer serializeRenderedSong(const RenderedSong& samples)
+{
+  assets::LeStreamWriter writer;
+
+  writer.writeU32(std::uint32_t(samples.size()));
+  for (const auto sample : samples)
+  {
+    writer.writeU16(std::uint16_t(sample));
+  }
+
+  return writer.buffer();
+}
+
+
+std::shared_ptr<const RenderedSong> loadCachedRenderedSong(
+  const assets::AssetCache* pAssetCache,
+  const std::string& cacheEntryName)
+{
+  if (!pAssetCache)
+  {
+    return nullptr;
+  }
+
+  const auto entry = pAssetCache->load(cacheEntryName);
+  if (!entry)
+  {
+    return nullptr;
+  }
+
+  try
+  {
+    assets::LeStreamReader reader(entry->data());
+
+    const auto numSamples = reader.readU32();
+    auto samples = RenderedSong{};
+    samples.reserve(numSamples);
+    for (auto i = 0u; i < numSamples; ++i)
+    {
+      samples.push_back(reader.readS16());
+    }
+
+    return std::make_shared<const RenderedSong>(std::move(samples));
+  }
+  catch (const std::exception& ex)
+  {
+    LOG_F(WARNING, "Ignoring invalid song cache entry: %s", ex.what());
+    return nullptr;
+  }
+}
+
+
+// Renders the AdLib versions of all sound effects, using all available CPU
+// cores. If an asset cache is given, previously rendered results are taken
+// from there.
+AdlibSoundSet renderAdlibSounds(
+  const assets::AudioPackage& soundPackage,
+  const AdlibEmulator::Type emulatorType,
+  const int sampleRate,
+  const assets::AssetCache* pAssetCache)
+{
+  const auto cacheEntryName =
+    adlibSoundsCacheEntryName(emulatorType, sampleRate);
+
+  if (pAssetCache)
+  {
+    if (const auto entry = pAssetCache->load(cacheEntryName))
+    {
+      if (auto cachedSounds =
+            readCachedAdlibSounds(entry->data(), soundPackage.size()))
+      {
+        return std::move(*cachedSounds);
+      }
+    }
+  }
+
+  // The emulator cores initialize some global lookup tables when the first
+  // instance is created, which isn't thread-safe. Make sure that has
+  // happened before going parallel.
+  {
+    AdlibEmulator emulator{OPL2_SAMPLE_RATE, emulatorType};
+  }
+
+  auto result = AdlibSoundSet(soundPackage.size());
+  base::parallelFor(soundPackage.size(), [&](const std::size_t i) {
+    result[i] = prepareBuffer(
+      renderAdlibSound(soundPackage[i], emulatorType), sampleRate);
+  });
+
+  if (pAssetCache)
+  {
+    pAssetCache->store(cacheEntryName, serializeAdlibSounds(result));
+  }
+
+  return result;
+}
+
+
 base::AudioBuffer loadSoundForStyle(
   const data::SoundId id,
   const data::SoundStyle soundStyle,
   const int sampleRate,
   const assets::ResourceLoader& resources,
-  const assets::AudioPackage& soundPackage,
-  const AdlibEmulator::Type emulatorType)
+  const AdlibSoundSet& adlibSounds)
 {
   auto loadAdlibSound = [&](const data::SoundId soundId) {
-    const auto idAsIndex = static_cast<int>(soundId);
-    if (idAsIndex < 0 || idAsIndex >= 34)
+    const auto idAsIndex = static_cast<std::size_t>(soundId);
+    if (idAsIndex >= adlibSounds.size())
     {
       throw std::invalid_argument("Invalid sound ID");
     }
 
-    return renderAdlibSound(soundPackage[idAsIndex], emulatorType);
+    return adlibSounds[idAsIndex];
   };
 
   auto loadPreferredSound = [&](const data::SoundId soundId) {
@@ -262,7 +500,7 @@ base::AudioBuffer loadSoundForStyle(
       return loadAdlibSound(soundId);
     }
 
-    return buffer;
+    return prepareBuffer(buffer, sampleRate);
   };
 
 
@@ -271,30 +509,28 @@ base::AudioBuffer loadSoundForStyle(
     // The intro sounds don't have AdLib versions, so always load
     // the 'preferred' version (SoundBlaster) regardless of chosen
     // sound style.
-    return prepareBuffer(loadPreferredSound(id), sampleRate);
+    return loadPreferredSound(id);
   }
 
   switch (soundStyle)
   {
     case data::SoundStyle::AdLib:
-      return prepareBuffer(loadAdlibSound(id), sampleRate);
+      return loadAdlibSound(id);
 
     case data::SoundStyle::Combined:
       {
-        auto buffer = prepareBuffer(loadPreferredSound(id), sampleRate);
+        auto buffer = loadPreferredSound(id);
         if (resources.hasSoundBlasterSound(id))
         {
           overlaySound(
-            buffer,
-            prepareBuffer(loadAdlibSound(id), sampleRate),
-            COMBINED_SOUNDS_ADLIB_PERCENTAGE);
+            buffer, loadAdlibSound(id), COMBINED_SOUNDS_ADLIB_PERCENTAGE);
         }
 
         return buffer;
       }
 
     default:
-      return prepareBuffer(loadPreferredSound(id), sampleRate);
+      return loadPreferredSound(id);
   }
 }
 
@@ -306,6 +542,169 @@ AdlibEmulator::Type toEmulationType(const data::AdlibPlaybackType type)
     : AdlibEmulator::Type::NukedOpl3;
 }
 
+
+std::string soundCacheEntryName(
+  const std::vector<data::SoundId>& ids,
+  const data::SoundStyle soundStyle,
+  const int sampleRate,
+  const std::uint16_t audioFormat,
+  const int numChannels,
+  const AdlibEmulator::Type emulatorType)
+{
+  // The set of sounds to decode differs between initial loading and
+  // reloading, so it's made part of the name to keep the entries from
+  // replacing each other.
+  auto idHasher = assets::CacheKeyHasher{};
+  for (const auto id : ids)
+  {
+    idHasher.add(std::uint64_t(id));
+  }
+
+  return "sounds_" + std::to_string(int(soundStyle)) + "_" +
+    std::to_string(int(emulatorType)) + "_" + std::to_string(sampleRate) +
+    "_" + std::to_string(audioFormat) + "_" + std::to_string(numChannels) +
+    "_" + std::to_string(int(resamplingProfile())) + "_" +
+    std::to_string(idHasher.value());
+}
+
+
+assets::ByteBuffer serializeSounds(
+  const std::vector<data::SoundId>& ids,
+  const std::vector<RawBuffer>& buffers)
+{
+  assets::LeStreamWriter writer;
+
+  writer.writeU32(std::uint32_t(ids.size()));
+  for (auto i = 0u; i < ids.size(); ++i)
+  {
+    writer.writeU16(std::uint16_t(ids[i]));
+    writer.writeU32(std::uint32_t(buffers[i].size()));
+    writer.writeBytes(buffers[i]);
+  }
+
+  return writer.buffer();
+}
+
+
+std::optional<std::vector<RawBuffer>> readCachedSounds(
+  const base::ArrayView<std::uint8_t> payload,
+  const std::vector<data::SoundId>& ids)
+{
+  try
+  {
+    assets::LeStreamReader reader(payload);
+
+    if (reader.readU32() != ids.size())
+    {
+      return std::nullopt;
+    }
+
+    auto result = std::vector<RawBuffer>{};
+    result.reserve(ids.size());
+
+    for (const auto id : ids)
+    {
+      if (reader.readU16() != std::uint16_t(id))
+      {
+        return std::nullopt;
+      }
+
+      const auto size = reader.readU32();
+      const auto bytes = reader.peekBytes(size);
+      reader.skipBytes(size);
+      result.emplace_back(bytes.begin(), bytes.end());
+    }
+
+    return result;
+  }
+  catch (const std::exception& ex)
+  {
+    LOG_F(WARNING, "Ignoring invalid sound cache entry: %s", ex.what());
+    return std::nullopt;
+  }
+}
+
+
+// Decodes the given sounds and converts them into the output format, using
+// all available CPU cores. If an asset cache is given, previously decoded
+// results are taken from there. getAdlibSounds is only invoked if decoding
+// is actually needed.
+template <typename AdlibSoundsGetter>
+std::vector<RawBuffer> decodeSounds(
+  const std::vector<data::SoundId>& ids,
+  const data::SoundStyle soundStyle,
+  const int sampleRate,
+  const std::uint16_t audioFormat,
+  const int numChannels,
+  const assets::ResourceLoader& resources,
+  AdlibSoundsGetter&& getAdlibSounds,
+  const AdlibEmulator::Type emulatorType,
+  const assets::AssetCache* pAssetCache)
+{
+  const auto cacheEntryName = soundCacheEntryName(
+    ids, soundStyle, sampleRate, audioFormat, numChannels, emulatorType);
+
+  if (pAssetCache)
+  {
+    if (const auto entry = pAssetCache->load(cacheEntryName))
+    {
+      if (auto cachedSounds = readCachedSounds(entry->data(), ids))
+      {
+        return std::move(*cachedSounds);
+      }
+    }
+  }
+
+  const auto& adlibSounds = getAdlibSounds();
+
+  auto result = std::vector<RawBuffer>(ids.size());
+  base::parallelFor(ids.size(), [&](const std::size_t i) {
+    const auto soundData =
+      loadSoundForStyle(ids[i], soundStyle, sampleRate, resources, adlibSounds);
+    result[i] = convertBuffer(soundData, audioFormat, numChannels);
+  });
+
+  if (pAssetCache)
+  {
+    pAssetCache->store(cacheEntryName, serializeSounds(ids, result));
+  }
+
+  return result;
+}
+
+
+void openAudioDevice(const bool lowLatencyMode)
+{
+  auto open = [](const int bufferSize) {
+    return Mix_OpenAudio(
+      DESIRED_SAMPLE_RATE,
+      AUDIO_S16LSB,
+      2, // stereo
+      bufferSize);
+  };
+
+  if (lowLatencyMode)
+  {
+    for (const auto bufferSize : LOW_LATENCY_BUFFER_SIZES)
+    {
+      if (open(bufferSize) == 0)
+      {
+        LOG_F(INFO, "Using low latency audio buffer size %d", bufferSize);
+        return;
+      }
+
+      LOG_F(
+        WARNING,
+        "Failed to open audio device with buffer size %d: %s",
+        bufferSize,
+        Mix_GetError());
+    }
+  }
+
+  sdl_mixer::check(open(BUFFER_SIZE));
+}
+
+
 } // namespace
 
 
@@ -314,8 +713,10 @@ struct SoundSystem::ImfPlayerWrapper
   ImfPlayerWrapper(
     const std::uint16_t audioFormat,
     const int sampleRate,
-    const int numChannels)
+    const int numChannels,
+    AudioTelemetry* pTelemetry)
     : mPlayer(sampleRate)
+    , mpTelemetry(pTelemetry)
     , mBytesPerSample((SDL_AUDIO_BITSIZE(audioFormat) / 8) * numChannels)
   {
     SDL_BuildAudioCVT(
@@ -337,6 +738,12 @@ struct SoundSystem::ImfPlayerWrapper
 
   void render(Uint8* pOutBuffer, int bytesRequired)
   {
+    // Invoked on SDL's audio thread
+    base::tracing::setCurrentThreadName("Audio");
+    RIGEL_TRACE_ZONE("ImfPlayerWrapper::render");
+
+    const auto startTime = base::Clock::now();
+
     auto pBuffer = mpBuffer.get();
     const auto samplesToRender = bytesRequired / mBytesPerSample;
     mPlayer.render(reinterpret_cast<std::int16_t*>(pBuffer), samplesToRender);
@@ -344,48 +751,121 @@ struct SoundSystem::ImfPlayerWrapper
     mConversionSpecs.len = samplesToRender * sizeof(std::int16_t);
     SDL_ConvertAudio(&mConversionSpecs);
     std::memcpy(pOutBuffer, pBuffer, mConversionSpecs.len_cvt);
+
+    mpTelemetry->recordMusicRenderTime(base::Clock::now() - startTime);
   }
 
-  void playSong(data::Song&& song) { mPlayer.playSong(std::move(song)); }
+  void playSong(data::Song&& song, const std::size_t startPosition)
+  {
+    mPlayer.playSong(std::move(song), startPosition);
+  }
+
+  void playRenderedSong(
+    std::shared_ptr<const RenderedSong> pSong,
+    const std::size_t startPosition)
+  {
+    mPlayer.playRenderedSong(std::move(pSong), startPosition);
+  }
+
+  std::size_t playbackPosition() const { return mPlayer.playbackPosition(); }
 
   void setVolume(const float volume) { mPlayer.setVolume(volume); }
 
   SDL_AudioCVT mConversionSpecs;
   std::unique_ptr<std::uint8_t[]> mpBuffer;
   SoftwareImfPlayer mPlayer;
+  AudioTelemetry* mpTelemetry;
   int mBytesPerSample;
 };
 
 
-SoundSystem::LoadedSound::LoadedSound(RawBuffer buffer)
-  : mData(std::move(buffer))
-  , mpMixChunk(sdl_utils::wrap(
-      Mix_QuickLoad_RAW(mData.data(), static_cast<Uint32>(mData.size()))))
+base::ArrayView<std::int16_t> SoundSystem::soundSamples(const int index) const
 {
+  using SampleView = base::ArrayView<std::int16_t>;
+
+  const auto& sound = mSounds[index];
+  return SampleView{
+    mSoundSamples.data() + sound.mOffset,
+    static_cast<SampleView::size_type>(sound.mSize)};
 }
 
 
-SoundSystem::LoadedSound::LoadedSound(sdl_utils::Ptr<Mix_Chunk> pMixChunk)
-  : mpMixChunk(std::move(pMixChunk))
+void SoundSystem::storeSoundData(const SoundDataViews& soundData)
 {
+  auto totalSize = std::size_t{0};
+  for (const auto& data : soundData)
+  {
+    totalSize += data.size() / sizeof(std::int16_t);
+  }
+
+  auto samples = std::vector<std::int16_t>(totalSize);
+  auto offset = std::size_t{0};
+
+  for (auto i = 0u; i < soundData.size(); ++i)
+  {
+    const auto& data = soundData[i];
+    const auto size = data.size() / sizeof(std::int16_t);
+
+    if (size > 0)
+    {
+      std::memcpy(
+        samples.data() + offset, data.data(), size * sizeof(std::int16_t));
+    }
+
+    mSounds[i].mOffset = offset;
+    mSounds[i].mSize = size;
+
+    offset += size;
+  }
+
+  mSoundSamples = std::move(samples);
+  updateMemoryUsage();
+}
+
+
+void SoundSystem::updateMemoryUsage()
+{
+  auto bytes = mSoundSamples.size() * sizeof(std::int16_t);
+
+  for (const auto& [type, sounds] : mRenderedAdlibSounds)
+  {
+    for (const auto& sound : sounds)
+    {
+      bytes += sound.mSamples.size() * sizeof(base::Sample);
+    }
+  }
+
+  for (const auto& song : mPrerenderedSongs)
+  {
+    if (song.mpSamples)
+    {
+      bytes += song.mpSamples->size() * sizeof(std::int16_t);
+    }
+  }
+
+  for (const auto& song : mRecentReplacementSongs)
+  {
+    bytes += song.mpData->size();
+  }
+
+  mMemory.set(bytes);
 }
 
 
 SoundSystem::SoundSystem(
   const assets::ResourceLoader* pResources,
   const data::SoundStyle soundStyle,
-  const data::AdlibPlaybackType adlibPlaybackType)
-  : mCloseMixerGuard(std::invoke([]() {
+  const data::AdlibPlaybackType adlibPlaybackType,
+  const bool lowLatencyMode,
+  const assets::AssetCache* pAssetCache)
+  : mCloseMixerGuard(std::invoke([lowLatencyMode]() {
     LOG_F(INFO, "Opening audio device");
-    sdl_mixer::check(Mix_OpenAudio(
-      DESIRED_SAMPLE_RATE,
-      AUDIO_S16LSB,
-      2, // stereo
-      BUFFER_SIZE));
+    openAudioDevice(lowLatencyMode);
 
     return &Mix_CloseAudio;
   }))
   , mpResources(pResources)
+  , mpAssetCache(pAssetCache)
   , mCurrentSoundStyle(soundStyle)
   , mCurrentAdlibPlaybackType(adlibPlaybackType)
 {
@@ -401,6 +881,13 @@ SoundSystem::SoundSystem(
     audioFormat,
     numChannels);
 
+  // Mix_OpenAudio() never changes the requested sample format, so this only
+  // fails on big-endian platforms.
+  if (audioFormat != AUDIO_S16SYS)
+  {
+    throw std::runtime_error{"Unsupported audio output format"};
+  }
+
   // Our music is in a format which SDL_mixer does not understand (IMF format
   // aka raw AdLib commands). Therefore, we cannot use any of the high-level
   // music playback functionality offered by the library. Instead, we register
@@ -411,23 +898,35 @@ SoundSystem::SoundSystem(
   // integer format (AUDIO_S16LSB), and in mono.  Converting from the player's
   // format into the output device format is handled by the ImfPlayerWrapper
   // class.
-  mpMusicPlayer =
-    std::make_unique<ImfPlayerWrapper>(audioFormat, sampleRate, numChannels);
+  mpTelemetry = std::make_unique<AudioTelemetry>(sampleRate);
+  mpMusicPlayer = std::make_unique<ImfPlayerWrapper>(
+    audioFormat, sampleRate, numChannels, mpTelemetry.get());
+  mBytesPerFrame = int(sizeof(std::int16_t)) * numChannels;
+  mSampleRate = sampleRate;
 
   // For sound playback, we want to be able to play as many sound effects in
   // parallel as possible. In the original game, the number of available sound
   // effects is hardcoded into the executable, with sounds being identified by
   // a numerical index (sound ID). This allows us to implement a very simple
-  // scheme: We allocate as many mixer channels as there are sound effects. We
-  // then create one playable audio buffer (aka Mix_Chunk) for each sound
-  // effect, and use its sound ID to determine which mixer channel it should be
+  // scheme: Our sound effect mixer has as many voices as there are sound
+  // effects, and we use a sound's ID to determine which voice it should be
   // played on. This way, all possible sound effects can play simultaneously,
   // but when the same sound effect is triggered multiple times in a row, it
   // results in the sound being cut off and played again from the beginning as
   // in the original game.
-  Mix_AllocateChannels(data::NUM_SOUND_IDS);
+  //
+  // The mixer runs as SDL_mixer's post-mix stage, on top of the music. We
+  // don't use SDL_mixer's own channels, since each operation on them takes
+  // the audio device lock.
+  Mix_AllocateChannels(0);
+  mpSoundEffectMixer = std::make_unique<SoundEffectMixer>(
+    std::size_t{data::NUM_SOUND_IDS}, MAX_ACTIVE_SOUND_EFFECTS);
 
-  loadAllSounds(sampleRate, audioFormat, numChannels, soundStyle);
+  {
+    const auto phase =
+      base::startup_timings::ScopedPhase{"Sound loading & resampling"};
+    loadAllSounds(sampleRate, audioFormat, numChannels, soundStyle);
+  }
 
   setMusicVolume(data::MUSIC_VOLUME_DEFAULT);
   setSoundVolume(data::SOUND_VOLUME_DEFAULT);
@@ -436,11 +935,14 @@ SoundSystem::SoundSystem(
   // We would otherwise end up with a hook that points to a destroyed
   // SoundSystem instance, and crash.
   hookMusic();
+  hookSoundEffectMixer();
 }
 
 
 SoundSystem::~SoundSystem()
 {
+  unhookSoundEffectMixer();
+
   if (mpCurrentReplacementSong)
   {
     mpCurrentReplacementSong.reset();
@@ -473,14 +975,29 @@ void SoundSystem::setAdlibPlaybackType(
   mCurrentAdlibPlaybackType = adlibPlaybackType;
   mpMusicPlayer->setType(toEmulationType(mCurrentAdlibPlaybackType));
   reloadAllSounds();
+
+  // Pre-rendered songs are specific to the emulator type. A song that's
+  // currently playing from a pre-rendered version can't switch over
+  // seamlessly like live emulation does, so it continues from the same
+  // position via live emulation until it has been rendered again.
+  mPrerenderedSongs.clear();
+  updateMemoryUsage();
+  if (!mPlayingPrerenderedSong.empty())
+  {
+    playSong(
+      std::string{mPlayingPrerenderedSong}, mpMusicPlayer->playbackPosition());
+  }
 }
 
 
-void SoundSystem::playSong(const std::string& name)
+void SoundSystem::playSong(
+  const std::string& name,
+  const std::size_t startPosition)
 {
-  if (auto pReplacementSong = loadReplacementSong(name))
+  if (auto replacementSong = loadReplacementSong(name))
   {
-    mpCurrentReplacementSong = std::move(pReplacementSong);
+    mpCurrentReplacementSong = std::move(replacementSong->mpMusic);
+    mpCurrentReplacementSongData = std::move(replacementSong->mpData);
     unhookMusic();
     Mix_PlayMusic(mpCurrentReplacementSong.get(), -1);
     return;
@@ -489,10 +1006,74 @@ void SoundSystem::playSong(const std::string& name)
   if (mpCurrentReplacementSong)
   {
     mpCurrentReplacementSong.reset();
+    mpCurrentReplacementSongData.reset();
     hookMusic();
   }
 
-  mpMusicPlayer->playSong(mpResources->loadMusic(name));
+  mPlayingPrerenderedSong.clear();
+
+  if (mPrerenderMusic)
+  {
+    if (auto pSamples = findPrerenderedSong(name))
+    {
+      mpMusicPlayer->playRenderedSong(std::move(pSamples), startPosition);
+      mPlayingPrerenderedSong = name;
+      return;
+    }
+
+    startPrerenderingSong(name);
+  }
+
+  mpMusicPlayer->playSong(mpResources->loadMusic(name), startPosition);
+}
+
+
+std::size_t SoundSystem::musicPosition() const
+{
+  if (mpCurrentReplacementSong)
+  {
+    return 0;
+  }
+
+  return mpMusicPlayer->playbackPosition();
+}
+
+
+void SoundSystem::prefetchSong(const std::string& name)
+{
+  if (
+    mPendingReplacementSongs.count(name) || findCachedReplacementSong(name))
+  {
+    return;
+  }
+
+  if (const auto iCacheEntry = mReplacementSongFileCache.find(name);
+      iCacheEntry != mReplacementSongFileCache.end() &&
+      iCacheEntry->second.empty())
+  {
+    return;
+  }
+
+  mPendingReplacementSongs.emplace(name, startLoadingReplacementSong(name));
+
+  if (mPrerenderMusic)
+  {
+    startPrerenderingSong(name);
+  }
+}
+
+
+void SoundSystem::setMusicPrerenderingEnabled(const bool enabled)
+{
+  mPrerenderMusic = enabled;
+
+  if (!enabled)
+  {
+    // A song that's currently playing keeps its samples alive until the
+    // next song starts.
+    mPrerenderedSongs.clear();
+    updateMemoryUsage();
+  }
 }
 
 
@@ -502,24 +1083,27 @@ void SoundSystem::stopMusic() const
   {
     Mix_HaltMusic();
     mpCurrentReplacementSong.reset();
+    mpCurrentReplacementSongData.reset();
     hookMusic();
   }
 
-  mpMusicPlayer->playSong({});
+  mPlayingPrerenderedSong.clear();
+  mpMusicPlayer->playSong({}, 0);
 }
 
 
 void SoundSystem::playSound(const data::SoundId id) const
 {
   const auto index = idToIndex(id);
-  Mix_PlayChannel(index, mSounds[index].mpMixChunk.get(), 0);
+  mpSoundEffectMixer->play(
+    std::size_t(index), soundSamples(index), soundPriority(id));
 }
 
 
 void SoundSystem::stopSound(const data::SoundId id) const
 {
   const auto index = idToIndex(id);
-  Mix_HaltChannel(index);
+  mpSoundEffectMixer->stop(std::size_t(index));
 }
 
 
@@ -539,10 +1123,15 @@ void SoundSystem::setMusicVolume(const float volume)
 }
 
 
+AudioStats SoundSystem::audioStats() const
+{
+  return mpTelemetry->stats();
+}
+
+
 void SoundSystem::setSoundVolume(const float volume)
 {
-  applySoundVolume(volume);
-  mCurrentSoundVolume = volume;
+  mpSoundEffectMixer->setVolume(volume);
 }
 
 
@@ -556,37 +1145,50 @@ void SoundSystem::loadAllSounds(
 
   LOG_F(INFO, "Loading sound effects");
 
-  const auto soundPackage = assets::loadAdlibSoundData(
-    mpResources->file(assets::AUDIO_DICT_FILE),
-    mpResources->file(assets::AUDIO_DATA_FILE));
+  // Replacement sound files are loaded right away. All other sounds are
+  // decoded in parallel afterwards.
+  auto soundData = SoundDataViews{};
+  std::vector<sdl_utils::Ptr<Mix_Chunk>> replacementChunks;
+  std::vector<data::SoundId> idsToDecode;
 
   data::forEachSoundId([&](const auto id) {
     for (const auto& replacementPath : mpResources->replacementSoundPaths(id))
     {
-      std::error_code ec;
-      if (std::filesystem::exists(replacementPath, ec))
+      const auto filename = replacementPath.u8string();
+
+      // Mix_LoadWAV converts to the output format, so we can take the
+      // samples from the chunk and then discard it.
+      if (auto pMixChunk = sdl_utils::wrap(Mix_LoadWAV(filename.c_str())))
       {
-        const auto filename = replacementPath.u8string();
-        if (auto pMixChunk = Mix_LoadWAV(filename.c_str()))
-        {
-          LOG_F(INFO, "Using replacement sound effect: %s", filename.c_str());
-          mSounds[idToIndex(id)] = LoadedSound{sdl_utils::wrap(pMixChunk)};
-          return;
-        }
+        LOG_F(INFO, "Using replacement sound effect: %s", filename.c_str());
+        soundData[idToIndex(id)] =
+          base::ArrayView<std::uint8_t>{pMixChunk->abuf, pMixChunk->alen};
+        mSounds[idToIndex(id)].mIsReplacement = true;
+        replacementChunks.push_back(std::move(pMixChunk));
+        return;
       }
     }
 
-    const auto soundData = loadSoundForStyle(
-      id,
-      soundStyle,
-      sampleRate,
-      *mpResources,
-      soundPackage,
-      toEmulationType(mCurrentAdlibPlaybackType));
-
-    mSounds[idToIndex(id)] =
-      LoadedSound{convertBuffer(soundData, audioFormat, numChannels)};
+    idsToDecode.push_back(id);
   });
+
+  auto decodedSounds = decodeSounds(
+    idsToDecode,
+    soundStyle,
+    sampleRate,
+    audioFormat,
+    numChannels,
+    *mpResources,
+    [&]() -> decltype(auto) { return renderedAdlibSounds(sampleRate); },
+    toEmulationType(mCurrentAdlibPlaybackType),
+    mpAssetCache);
+
+  for (auto i = 0u; i < idsToDecode.size(); ++i)
+  {
+    soundData[idToIndex(idsToDecode[i])] = decodedSounds[i];
+  }
+
+  storeSoundData(soundData);
 }
 
 
@@ -594,8 +1196,6 @@ void SoundSystem::reloadAllSounds()
 {
   LOG_SCOPE_FUNCTION(INFO);
 
-  stopAllSounds();
-
   int sampleRate = 0;
   std::uint16_t audioFormat = 0;
   int numChannels = 0;
@@ -603,46 +1203,123 @@ void SoundSystem::reloadAllSounds()
 
   LOG_F(INFO, "Reloading sound effects");
 
-  const auto soundPackage = assets::loadAdlibSoundData(
-    mpResources->file(assets::AUDIO_DICT_FILE),
-    mpResources->file(assets::AUDIO_DATA_FILE));
+  // Replacement sound files and intro sounds don't depend on the sound style
+  // or AdLib emulator, so they are kept as they are.
+  std::vector<data::SoundId> idsToDecode;
 
   data::forEachSoundId([&](const auto id) {
     const auto index = idToIndex(id);
-    if (
-      mSounds[index].mData.empty() || data::isIntroSound(id) ||
-      !mpResources->hasSoundBlasterSound(id))
+    if (mSounds[index].mIsReplacement || data::isIntroSound(id))
     {
       return;
     }
 
-    const auto soundData = loadSoundForStyle(
-      id,
-      mCurrentSoundStyle,
-      sampleRate,
-      *mpResources,
-      soundPackage,
-      toEmulationType(mCurrentAdlibPlaybackType));
-    mSounds[index] =
-      LoadedSound{convertBuffer(soundData, audioFormat, numChannels)};
+    idsToDecode.push_back(id);
   });
 
-  applySoundVolume(mCurrentSoundVolume);
+  auto decodedSounds = decodeSounds(
+    idsToDecode,
+    mCurrentSoundStyle,
+    sampleRate,
+    audioFormat,
+    numChannels,
+    *mpResources,
+    [&]() -> decltype(auto) { return renderedAdlibSounds(sampleRate); },
+    toEmulationType(mCurrentAdlibPlaybackType),
+    mpAssetCache);
+
+  // Sounds which are kept are copied over from the current sample storage.
+  auto soundData = SoundDataViews{};
+  for (auto i = 0u; i < soundData.size(); ++i)
+  {
+    const auto samples = soundSamples(int(i));
+    soundData[i] = base::ArrayView<std::uint8_t>{
+      reinterpret_cast<const std::uint8_t*>(samples.data()),
+      static_cast<base::ArrayView<std::uint8_t>::size_type>(
+        samples.size() * sizeof(std::int16_t))};
+  }
+
+  for (auto i = 0u; i < idsToDecode.size(); ++i)
+  {
+    soundData[idToIndex(idsToDecode[i])] = decodedSounds[i];
+  }
+
+  // The mixer might still be playing the old sounds, so it needs to be
+  // stopped before we can replace them.
+  unhookSoundEffectMixer();
+  mpSoundEffectMixer->reset();
+  storeSoundData(soundData);
+  hookSoundEffectMixer();
 }
 
 
-void SoundSystem::applySoundVolume(const float volume)
+void SoundSystem::reloadReplacementSounds(
+  const std::vector<data::SoundId>& ids)
 {
-  const auto sdlVolume =
-    static_cast<int>(std::clamp(volume, 0.0f, 1.0f) * MIX_MAX_VOLUME);
+  LOG_SCOPE_FUNCTION(INFO);
+
+  auto soundData = SoundDataViews{};
+  for (auto i = 0u; i < soundData.size(); ++i)
+  {
+    const auto samples = soundSamples(int(i));
+    soundData[i] = base::ArrayView<std::uint8_t>{
+      reinterpret_cast<const std::uint8_t*>(samples.data()),
+      static_cast<base::ArrayView<std::uint8_t>::size_type>(
+        samples.size() * sizeof(std::int16_t))};
+  }
 
-  for (auto& sound : mSounds)
+  // If a file can't be loaded (e.g. because it's still being written), the
+  // previous version of the sound is kept.
+  std::vector<sdl_utils::Ptr<Mix_Chunk>> replacementChunks;
+
+  for (const auto id : ids)
   {
-    if (sound.mpMixChunk)
+    for (const auto& replacementPath : mpResources->replacementSoundPaths(id))
     {
-      Mix_VolumeChunk(sound.mpMixChunk.get(), sdlVolume);
+      const auto filename = replacementPath.u8string();
+
+      if (auto pMixChunk = sdl_utils::wrap(Mix_LoadWAV(filename.c_str())))
+      {
+        LOG_F(INFO, "Reloaded replacement sound effect: %s", filename.c_str());
+        soundData[idToIndex(id)] =
+          base::ArrayView<std::uint8_t>{pMixChunk->abuf, pMixChunk->alen};
+        mSounds[idToIndex(id)].mIsReplacement = true;
+        replacementChunks.push_back(std::move(pMixChunk));
+        break;
+      }
     }
   }
+
+  unhookSoundEffectMixer();
+  mpSoundEffectMixer->reset();
+  storeSoundData(soundData);
+  hookSoundEffectMixer();
+}
+
+
+const std::vector<base::AudioBuffer>&
+  SoundSystem::renderedAdlibSounds(const int sampleRate)
+{
+  auto iSounds = mRenderedAdlibSounds.find(mCurrentAdlibPlaybackType);
+  if (iSounds == mRenderedAdlibSounds.end())
+  {
+    const auto soundPackage = assets::loadAdlibSoundData(
+      mpResources->file(assets::AUDIO_DICT_FILE),
+      mpResources->file(assets::AUDIO_DATA_FILE));
+
+    iSounds = mRenderedAdlibSounds
+                .emplace(
+                  mCurrentAdlibPlaybackType,
+                  renderAdlibSounds(
+                    soundPackage,
+                    toEmulationType(mCurrentAdlibPlaybackType),
+                    sampleRate,
+                    mpAssetCache))
+                .first;
+    updateMemoryUsage();
+  }
+
+  return iSounds->second;
 }
 
 
@@ -663,64 +1340,293 @@ void SoundSystem::unhookMusic() const
 }
 
 
-sdl_utils::Ptr<Mix_Music>
-  SoundSystem::loadReplacementSong(const std::string& name)
+void SoundSystem::hookSoundEffectMixer()
 {
-  namespace fs = std::filesystem;
+  Mix_SetPostMix(
+    [](void* pUserData, Uint8* pOutBuffer, int bytesRequired) {
+      auto pSelf = static_cast<const SoundSystem*>(pUserData);
+      pSelf->mixSoundEffects(pOutBuffer, bytesRequired);
+    },
+    this);
+}
 
-  if (const auto iCacheEntry = mReplacementSongFileCache.find(name);
-      iCacheEntry != mReplacementSongFileCache.end())
+
+void SoundSystem::mixSoundEffects(
+  std::uint8_t* pOutBuffer,
+  const int bytesRequired) const
+{
+  RIGEL_TRACE_ZONE("SoundSystem::mixSoundEffects");
+
+  const auto startTime = base::Clock::now();
+
+  mpSoundEffectMixer->mix(
+    reinterpret_cast<std::int16_t*>(pOutBuffer),
+    std::size_t(bytesRequired) / sizeof(std::int16_t));
+
+  mpTelemetry->recordMixerTime(
+    base::Clock::now() - startTime, bytesRequired / mBytesPerFrame);
+}
+
+
+// Once this returns, the mixer is guaranteed to not be running, since
+// SDL_mixer replaces the post-mix callback with the audio device locked.
+void SoundSystem::unhookSoundEffectMixer()
+{
+  Mix_SetPostMix(nullptr, nullptr);
+}
+
+
+auto SoundSystem::loadReplacementSong(const std::string& name)
+  -> std::optional<ReplacementSong>
+{
+  auto openSong = [](const std::shared_ptr<const RawBuffer>& pData) {
+    // The Mix_Music object keeps referring to the data while it's playing,
+    // so the caller needs to keep pData alive for as long as the song.
+    const auto pRWops = SDL_RWFromConstMem(pData->data(), int(pData->size()));
+    return sdl_utils::wrap(Mix_LoadMUS_RW(pRWops, 1));
+  };
+
+  if (auto pData = findCachedReplacementSong(name))
   {
-    if (iCacheEntry->second.empty())
+    if (auto pSong = openSong(pData))
     {
-      // An empty entry indicates that no replacement exists
-      return {};
+      return ReplacementSong{std::move(pData), std::move(pSong)};
     }
+  }
 
-    if (auto pSong = Mix_LoadMUS(iCacheEntry->second.c_str()))
-    {
-      return sdl_utils::wrap(pSong);
-    }
+  if (const auto iCacheEntry = mReplacementSongFileCache.find(name);
+      iCacheEntry != mReplacementSongFileCache.end() &&
+      iCacheEntry->second.empty())
+  {
+    // An empty entry indicates that no replacement exists
+    return {};
   }
 
-  // Because of the large variety of file formats supported by SDL_mixer, we
-  // don't try to explicitly look for specific file extensions. Instead, we
-  // look for any file with a base name (i.e. without extension) matching the
-  // requested music file's name. If we find a match and SDL_mixer can
-  // successfully load it, we add the file path to our cache.
-  const auto songName =
-    fs::u8path(strings::toLowercase(name)).replace_extension();
+  // If the song wasn't prefetched, we load it synchronously.
+  auto files = [&]() {
+    if (const auto iPending = mPendingReplacementSongs.find(name);
+        iPending != mPendingReplacementSongs.end())
+    {
+      auto result = iPending->second.get();
+      mPendingReplacementSongs.erase(iPending);
+      return result;
+    }
 
-  std::error_code ec;
+    return startLoadingReplacementSong(name).get();
+  }();
 
-  for (const auto& replacementBasePath :
-       mpResources->replacementMusicBasePaths())
+  for (auto& file : files)
   {
-    for (const fs::directory_entry& candidate :
-         fs::directory_iterator(replacementBasePath, ec))
+    if (auto pSong = openSong(file.mpData))
     {
-      if (!candidate.is_regular_file() || candidate.path().stem() != songName)
+      if (!mReplacementSongFileCache.count(name))
       {
-        continue;
+        LOG_F(INFO, "Using replacement music file: %s", file.mPath.c_str());
+        mReplacementSongFileCache.insert({name, file.mPath});
       }
 
-      const auto candidateFilePath = candidate.path().u8string();
-      if (auto pSong = Mix_LoadMUS(candidateFilePath.c_str()))
-      {
-        LOG_F(
-          INFO, "Using replacement music file: %s", candidateFilePath.c_str());
-        auto pReplacement = sdl_utils::wrap(pSong);
-        mReplacementSongFileCache.insert({name, candidateFilePath});
-        return pReplacement;
-      }
+      addCachedReplacementSong(name, file.mpData);
+      return ReplacementSong{std::move(file.mpData), std::move(pSong)};
     }
   }
 
   // We didn't find a suitable replacement. Insert an empty string into the
   // cache to avoid scanning the file system again next time.
-  mReplacementSongFileCache.insert({name, std::string{}});
+  mReplacementSongFileCache.insert_or_assign(name, std::string{});
 
   return {};
 }
 
+
+auto SoundSystem::startLoadingReplacementSong(const std::string& name) const
+  -> std::future<std::vector<ReplacementSongFile>>
+{
+  namespace fs = std::filesystem;
+
+  // Looking up the candidates is answered from ResourceLoader's directory
+  // index, so only reading the files needs to happen in the background.
+  auto candidates = std::vector<fs::path>{};
+  if (const auto iCacheEntry = mReplacementSongFileCache.find(name);
+      iCacheEntry != mReplacementSongFileCache.end())
+  {
+    candidates.push_back(fs::u8path(iCacheEntry->second));
+  }
+  else
+  {
+    candidates = mpResources->replacementMusicPaths(name);
+  }
+
+  return base::runAsync([candidates = std::move(candidates)]() {
+    auto result = std::vector<ReplacementSongFile>{};
+    for (const auto& candidate : candidates)
+    {
+      if (auto data = assets::tryLoadFile(candidate))
+      {
+        result.push_back(ReplacementSongFile{
+          candidate.u8string(),
+          std::make_shared<const RawBuffer>(std::move(*data))});
+      }
+    }
+
+    return result;
+  });
+}
+
+
+std::shared_ptr<const RawBuffer>
+  SoundSystem::findCachedReplacementSong(const std::string& name)
+{
+  const auto iEntry = std::find_if(
+    mRecentReplacementSongs.begin(),
+    mRecentReplacementSongs.end(),
+    [&](const CachedReplacementSong& entry) { return entry.mName == name; });
+
+  if (iEntry == mRecentReplacementSongs.end())
+  {
+    return {};
+  }
+
+  // Move to the front to mark it as most recently used
+  mRecentReplacementSongs.splice(
+    mRecentReplacementSongs.begin(), mRecentReplacementSongs, iEntry);
+  return iEntry->mpData;
+}
+
+
+void SoundSystem::addCachedReplacementSong(
+  const std::string& name,
+  std::shared_ptr<const RawBuffer> pData)
+{
+  mRecentReplacementSongs.remove_if(
+    [&](const CachedReplacementSong& entry) { return entry.mName == name; });
+  mRecentReplacementSongs.push_front(
+    CachedReplacementSong{name, std::move(pData)});
+
+  if (mRecentReplacementSongs.size() > MAX_RECENT_REPLACEMENT_SONGS)
+  {
+    mRecentReplacementSongs.pop_back();
+  }
+
+  updateMemoryUsage();
+}
+
+SoundSystem::PrerenderedSongPtr
+  SoundSystem::findPrerenderedSong(const std::string& name)
+{
+  collectPrerenderedSongs();
+
+  const auto iEntry = std::find_if(
+    mPrerenderedSongs.begin(),
+    mPrerenderedSongs.end(),
+    [&](const PrerenderedSong& entry) { return entry.mName == name; });
+
+  if (iEntry != mPrerenderedSongs.end())
+  {
+    mPrerenderedSongs.splice(
+      mPrerenderedSongs.begin(), mPrerenderedSongs, iEntry);
+    return iEntry->mpSamples;
+  }
+
+  // Reading a song from the cache is much quicker than rendering it, so it's
+  // fine to do it right away.
+  const auto cacheEntryName = prerenderedSongCacheEntryName(
+    name, toEmulationType(mCurrentAdlibPlaybackType), mSampleRate);
+  if (auto pSamples = loadCachedRenderedSong(mpAssetCache, cacheEntryName))
+  {
+    addPrerenderedSong(name, pSamples);
+    return pSamples;
+  }
+
+  return nullptr;
+}
+
+
+void SoundSystem::startPrerenderingSong(const std::string& name)
+{
+  collectPrerenderedSongs();
+
+  if (
+    mPendingSongRenders.count(name) ||
+    std::any_of(
+      mPrerenderedSongs.begin(),
+      mPrerenderedSongs.end(),
+      [&](const PrerenderedSong& entry) { return entry.mName == name; }))
+  {
+    return;
+  }
+
+  const auto emulatorType = toEmulationType(mCurrentAdlibPlaybackType);
+  auto render = [song = mpResources->loadMusic(name),
+                 cacheEntryName = prerenderedSongCacheEntryName(
+                   name, emulatorType, mSampleRate),
+                 emulatorType,
+                 sampleRate = mSampleRate,
+                 pAssetCache = mpAssetCache]() -> PrerenderedSongPtr {
+    if (auto pSamples = loadCachedRenderedSong(pAssetCache, cacheEntryName))
+    {
+      return pSamples;
+    }
+
+    auto pSamples = std::make_shared<const RenderedSong>(
+      renderImfSong(song, sampleRate, emulatorType));
+
+    if (pAssetCache)
+    {
+      pAssetCache->store(cacheEntryName, serializeRenderedSong(*pSamples));
+    }
+
+    return pSamples;
+  };
+
+  mPendingSongRenders.emplace(
+    name,
+    PendingSongRender{mCurrentAdlibPlaybackType, base::runAsync(render)});
+}
+
+
+void SoundSystem::collectPrerenderedSongs()
+{
+  for (auto iPending = mPendingSongRenders.begin();
+       iPending != mPendingSongRenders.end();)
+  {
+    auto& pending = iPending->second;
+
+    // Renders are started via base::runAsync(), which never defers them:
+    // They either run on a job worker, or (without thread support) have
+    // already completed inline by the time we get here.
+    if (
+      pending.mResult.wait_for(std::chrono::seconds(0)) !=
+      std::future_status::ready)
+    {
+      ++iPending;
+      continue;
+    }
+
+    auto pSamples = pending.mResult.get();
+    if (mPrerenderMusic && pending.mType == mCurrentAdlibPlaybackType)
+    {
+      addPrerenderedSong(iPending->first, std::move(pSamples));
+    }
+
+    iPending = mPendingSongRenders.erase(iPending);
+  }
+}
+
+
+void SoundSystem::addPrerenderedSong(
+  const std::string& name,
+  PrerenderedSongPtr pSamples)
+{
+  mPrerenderedSongs.remove_if(
+    [&](const PrerenderedSong& entry) { return entry.mName == name; });
+  mPrerenderedSongs.push_front(PrerenderedSong{name, std::move(pSamples)});
+
+  if (mPrerenderedSongs.size() > MAX_PRERENDERED_SONGS)
+  {
+    mPrerenderedSongs.pop_back();
+  }
+
+  updateMemoryUsage();
+}
+
 } // namespace rigel::audio
@@ -1,127 +1,252 @@
-/* Copyright (C) 2016, Nikolai Wuttke. All rights reserved.
- *
- *  This program is free software: you can redistribute it and/or modify
- *  it under the terms of the GNU General Public License as published by
- *  the Free Software Foundation, either version 2 of the License, or
- *  (at your option) any later version.
- *
- *  This program is distributed in the hope that it will be useful,
- *  but WITHOUT ANY WARRANTY; without even the implied warranty of
- *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
- *  GNU General Public License for more details.
- *
- *  You should have received a copy of the GNU General Public License
- *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
- */
-
-#pragma once
-
-#include "base/audio_buffer.hpp"
-#include "base/defer.hpp"
-#include "data/game_options.hpp"
-#include "data/song.hpp"
-#include "data/sound_ids.hpp"
-#include "sdl_utils/ptr.hpp"
-
-#include <array>
-#include <memory>
-#include <string>
-#include <unordered_map>
-
-
-namespace rigel::assets
-{
-class ResourceLoader;
-}
-
-
-namespace rigel::audio
-{
-
-
-using RawBuffer = std::vector<std::uint8_t>;
-
-
-/** Provides sound and music playback functionality
- *
- * This class implements sound and music playback. When constructed, it opens
- * an audio device and loads all sound effects from the game's data files. From
- * that point on, sound effects and music playback can be triggered at any time
- * using the class' interface. Sound and music volume can also be adjusted.
- */
-class SoundSystem
-{
-public:
-  explicit SoundSystem(
-    const assets::ResourceLoader* pResources,
-    data::SoundStyle soundStyle,
-    data::AdlibPlaybackType adlibPlaybackType);
-  ~SoundSystem();
-
-  void setSoundStyle(data::SoundStyle soundStyle);
-  void setAdlibPlaybackType(data::AdlibPlaybackType adlibPlaybackType);
-
-  /** Start playing given music data
-   *
-   * Starts playback of the song identified by the given name, and returns
-   * immediately. Music plays in parallel to any sound effects.
-   */
-  void playSong(const std::string& name);
-
-  /** Stop playing current song (if playing) */
-  void stopMusic() const;
-
-  /** Start playing specified sound effect
-   *
-   * Starts playback of the sound effect specified by the given sound ID, and
-   * returns immediately. The sound effect will play in parallel to any other
-   * currently playing sound effects, unless the same sound ID is already
-   * playing. In the latter case, the already playing sound effect will be cut
-   * off and playback will restart from the beginning.
-   */
-  void playSound(data::SoundId id) const;
-
-  /** Stop playing specified sound effect (if currently playing) */
-  void stopSound(data::SoundId id) const;
-  void stopAllSounds() const;
-
-  void setMusicVolume(float volume);
-  void setSoundVolume(float volume);
-
-private:
-  void loadAllSounds(
-    int sampleRate,
-    std::uint16_t audioFormat,
-    int numChannels,
-    data::SoundStyle soundStyle);
-  void reloadAllSounds();
-  void applySoundVolume(float volume);
-  void hookMusic() const;
-  void unhookMusic() const;
-  sdl_utils::Ptr<Mix_Music> loadReplacementSong(const std::string& name);
-
-  struct ImfPlayerWrapper;
-
-  struct LoadedSound
-  {
-    LoadedSound() = default;
-    explicit LoadedSound(RawBuffer buffer);
-    explicit LoadedSound(sdl_utils::Ptr<Mix_Chunk> pMixChunk);
-
-    RawBuffer mData;
-    sdl_utils::Ptr<Mix_Chunk> mpMixChunk;
-  };
-
-  base::ScopeGuard mCloseMixerGuard;
-  std::array<LoadedSound, data::NUM_SOUND_IDS> mSounds;
-  std::unique_ptr<ImfPlayerWrapper> mpMusicPlayer;
-  mutable sdl_utils::Ptr<Mix_Music> mpCurrentReplacementSong;
-  mutable std::unordered_map<std::string, std::string>
-    mReplacementSongFileCache;
-  const assets::ResourceLoader* mpResources;
-  float mCurrentSoundVolume;
-  data::SoundStyle mCurrentSoundStyle;
-  data::AdlibPlaybackType mCurrentAdlibPlaybackType;
-};
-
-} // namespace rigel::audio
+/* Copyright (C) 2016, Nikolai Wuttke. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "audio/audio_telemetry.hpp"
+#include "base/array_view.hpp"
+#include "base/audio_buffer.hpp"
+#include "base/defer.hpp"
+#include "base/memory_accounting.hpp"
+#include "data/game_options.hpp"
+#include "data/song.hpp"
+#include "data/sound_ids.hpp"
+#include "sdl_utils/ptr.hpp"
+
+#include <array>
+#include <future>
+#include <list>
+#include <memory>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+
+namespace rigel::assets
+{
+class AssetCache;
+class ResourceLoader;
+}
+
+
+namespace rigel::audio
+{
+
+class SoundEffectMixer;
+
+
+using RawBuffer = std::vector<std::uint8_t>;
+
+
+/** Provides sound and music playback functionality
+ *
+ * This class implements sound and music playback. When constructed, it opens
+ * an audio device and loads all sound effects from the game's data files. From
+ * that point on, sound effects and music playback can be triggered at any time
+ * using the class' interface. Sound and music volume can also be adjusted.
+ */
+class SoundSystem
+{
+public:
+  explicit SoundSystem(
+    const assets::ResourceLoader* pResources,
+    data::SoundStyle soundStyle,
+    data::AdlibPlaybackType adlibPlaybackType,
+    bool lowLatencyMode,
+    const assets::AssetCache* pAssetCache = nullptr);
+  ~SoundSystem();
+
+  void setSoundStyle(data::SoundStyle soundStyle);
+  void setAdlibPlaybackType(data::AdlibPlaybackType adlibPlaybackType);
+
+  /** Start playing given music data
+   *
+   * Starts playback of the song identified by the given name, and returns
+   * immediately. Music plays in parallel to any sound effects.
+   *
+   * A start position previously returned by musicPosition() continues the
+   * song from that point. Replacement songs always start from the
+   * beginning.
+   */
+  void playSong(const std::string& name, std::size_t startPosition = 0);
+
+  /** Position of the currently playing AdLib song, in output samples
+   *
+   * Returns 0 while a replacement song is playing.
+   */
+  std::size_t musicPosition() const;
+
+  /** Start loading a replacement file for the given song in the background
+   *
+   * Does nothing if there is no replacement for the song, or if its data is
+   * already in memory. A later playSong() for the same name then doesn't
+   * need to wait for any file I/O.
+   */
+  void prefetchSong(const std::string& name);
+
+  /** Play music from pre-rendered PCM data instead of emulating it live
+   *
+   * Meant for devices where real-time AdLib emulation is too expensive. Songs
+   * are rendered on a background thread when they are first played or
+   * prefetched, or taken from the asset cache if available there. Until a
+   * song's rendering has finished, it's played via live emulation.
+   */
+  void setMusicPrerenderingEnabled(bool enabled);
+
+  /** Stop playing current song (if playing) */
+  void stopMusic() const;
+
+  /** Start playing specified sound effect
+   *
+   * Starts playback of the sound effect specified by the given sound ID, and
+   * returns immediately. The sound effect will play in parallel to any other
+   * currently playing sound effects, unless the same sound ID is already
+   * playing. In the latter case, the already playing sound effect will be cut
+   * off and playback will restart from the beginning.
+   */
+  void playSound(data::SoundId id) const;
+
+  /** Stop playing specified sound effect (if currently playing) */
+  void stopSound(data::SoundId id) const;
+  void stopAllSounds() const;
+
+  void setMusicVolume(float volume);
+  void setSoundVolume(float volume);
+
+  /** Load the given sound effects' replacement files again
+   *
+   * For hot-reloading replacement files that were modified while the game
+   * is running. All other sound effects are kept as they are.
+   */
+  void reloadReplacementSounds(const std::vector<data::SoundId>& ids);
+
+  /** Timing measurements from the audio callback, for tuning latency */
+  AudioStats audioStats() const;
+
+private:
+  void loadAllSounds(
+    int sampleRate,
+    std::uint16_t audioFormat,
+    int numChannels,
+    data::SoundStyle soundStyle);
+  void reloadAllSounds();
+  const std::vector<base::AudioBuffer>& renderedAdlibSounds(int sampleRate);
+  void hookMusic() const;
+  void unhookMusic() const;
+  void hookSoundEffectMixer();
+  void unhookSoundEffectMixer();
+  void mixSoundEffects(std::uint8_t* pOutBuffer, int bytesRequired) const;
+
+  struct ReplacementSongFile
+  {
+    std::string mPath;
+    std::shared_ptr<const RawBuffer> mpData;
+  };
+
+  struct ReplacementSong
+  {
+    std::shared_ptr<const RawBuffer> mpData;
+    sdl_utils::Ptr<Mix_Music> mpMusic;
+  };
+
+  struct CachedReplacementSong
+  {
+    std::string mName;
+    std::shared_ptr<const RawBuffer> mpData;
+  };
+
+  std::optional<ReplacementSong> loadReplacementSong(const std::string& name);
+  std::future<std::vector<ReplacementSongFile>>
+    startLoadingReplacementSong(const std::string& name) const;
+  std::shared_ptr<const RawBuffer>
+    findCachedReplacementSong(const std::string& name);
+  void addCachedReplacementSong(
+    const std::string& name,
+    std::shared_ptr<const RawBuffer> pData);
+
+  using PrerenderedSongPtr = std::shared_ptr<const std::vector<std::int16_t>>;
+
+  struct PrerenderedSong
+  {
+    std::string mName;
+    PrerenderedSongPtr mpSamples;
+  };
+
+  struct PendingSongRender
+  {
+    data::AdlibPlaybackType mType;
+    std::future<PrerenderedSongPtr> mResult;
+  };
+
+  PrerenderedSongPtr findPrerenderedSong(const std::string& name);
+  void startPrerenderingSong(const std::string& name);
+  void collectPrerenderedSongs();
+  void addPrerenderedSong(const std::string& name, PrerenderedSongPtr pSamples);
+
+  struct ImfPlayerWrapper;
+
+  // Location of a sound's samples in mSoundSamples
+  struct LoadedSound
+  {
+    std::size_t mOffset = 0;
+    std::size_t mSize = 0;
+    bool mIsReplacement = false;
+  };
+
+  using SoundDataViews =
+    std::array<base::ArrayView<std::uint8_t>, data::NUM_SOUND_IDS>;
+
+  base::ArrayView<std::int16_t> soundSamples(int index) const;
+  void storeSoundData(const SoundDataViews& soundData);
+  void updateMemoryUsage();
+
+  base::ScopeGuard mCloseMixerGuard;
+  std::array<LoadedSound, data::NUM_SOUND_IDS> mSounds;
+
+  // Samples of all sound effects in the output device's format, stored back
+  // to back in a single allocation
+  std::vector<std::int16_t> mSoundSamples;
+
+  // AdLib sounds only depend on the emulator type, since the output sample
+  // rate doesn't change. Keeping them around makes switching sound styles
+  // and emulators in the options menu instant after the first time.
+  std::unordered_map<data::AdlibPlaybackType, std::vector<base::AudioBuffer>>
+    mRenderedAdlibSounds;
+  std::unique_ptr<AudioTelemetry> mpTelemetry;
+  std::unique_ptr<SoundEffectMixer> mpSoundEffectMixer;
+  std::unique_ptr<ImfPlayerWrapper> mpMusicPlayer;
+  mutable std::shared_ptr<const RawBuffer> mpCurrentReplacementSongData;
+  mutable sdl_utils::Ptr<Mix_Music> mpCurrentReplacementSong;
+  mutable std::unordered_map<std::string, std::string>
+    mReplacementSongFileCache;
+  std::unordered_map<std::string, std::future<std::vector<ReplacementSongFile>>>
+    mPendingReplacementSongs;
+  std::list<CachedReplacementSong> mRecentReplacementSongs;
+  std::unordered_map<std::string, PendingSongRender> mPendingSongRenders;
+  std::list<PrerenderedSong> mPrerenderedSongs;
+  mutable std::string mPlayingPrerenderedSong;
+  const assets::ResourceLoader* mpResources;
+  const assets::AssetCache* mpAssetCache;
+  int mBytesPerFrame = 0;
+  int mSampleRate = 0;
+  bool mPrerenderMusic = false;
+  data::SoundStyle mCurrentSoundStyle;
+  data::AdlibPlaybackType mCurrentAdlibPlaybackType;
+  base::TrackedMemory mMemory{base::MemoryCategory::SoundData};
+};
+
+} // namespace rigel::audio
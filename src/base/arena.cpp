@@ -0,0 +1,103 @@
+/* Copyright (C) 2022, Nikolai Wuttke. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "arena.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <numeric>
+
+
+namespace rigel::base
+{
+
+namespace
+{
+
+std::size_t alignedOffset(
+  const std::byte* pBlock,
+  const std::size_t offset,
+  const std::size_t alignment)
+{
+  const auto address = reinterpret_cast<std::uintptr_t>(pBlock) + offset;
+  const auto alignedAddress = (address + alignment - 1) & ~(alignment - 1);
+  return offset + (alignedAddress - address);
+}
+
+} // namespace
+
+
+Arena::Arena(const std::size_t blockSize)
+  : mBlockSize(blockSize)
+{
+  addBlock(mBlockSize);
+}
+
+
+void* Arena::allocate(const std::size_t size, const std::size_t alignment)
+{
+  assert(alignment != 0 && (alignment & (alignment - 1)) == 0);
+
+  auto offset = alignedOffset(
+    mBlocks.back().mpData.get(), mUsedInCurrentBlock, alignment);
+
+  if (offset + size > mBlocks.back().mSize)
+  {
+    // Blocks come from new[], which aligns them suitably for any
+    // fundamental type. Larger alignments need some extra room.
+    addBlock(std::max(mBlockSize, size + alignment));
+    offset = alignedOffset(mBlocks.back().mpData.get(), 0, alignment);
+  }
+
+  mUsedInCurrentBlock = offset + size;
+  return mBlocks.back().mpData.get() + offset;
+}
+
+
+void Arena::reset()
+{
+  if (mBlocks.size() > 1)
+  {
+    const auto totalSize = capacity();
+    mBlocks.clear();
+    addBlock(totalSize);
+  }
+
+  mUsedInCurrentBlock = 0;
+}
+
+
+std::size_t Arena::capacity() const
+{
+  return std::accumulate(
+    mBlocks.begin(),
+    mBlocks.end(),
+    std::size_t{0},
+    [](const std::size_t sum, const Block& block) {
+      return sum + block.mSize;
+    });
+}
+
+
+void Arena::addBlock(const std::size_t minimumSize)
+{
+  mBlocks.push_back(
+    Block{std::make_unique<std::byte[]>(minimumSize), minimumSize});
+  mUsedInCurrentBlock = 0;
+}
+
+} // namespace rigel::base
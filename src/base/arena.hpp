@@ -0,0 +1,129 @@
+/* Copyright (C) 2022, Nikolai Wuttke. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+
+namespace rigel::base
+{
+
+/** Monotonic allocator for short-lived allocations
+ *
+ * Hands out memory from large blocks by bumping a pointer, which makes
+ * allocating practically free. Individual allocations are never freed,
+ * instead all memory is released at once when the arena is reset or
+ * destroyed. This suits temporary data with a well-defined lifetime, like
+ * intermediate results while loading a level, and keeps such data from
+ * fragmenting the general heap.
+ *
+ * Only trivially destructible data should be placed in an arena directly.
+ * Containers using ArenaAllocator run their element destructors as usual.
+ */
+class Arena
+{
+public:
+  static constexpr std::size_t DEFAULT_BLOCK_SIZE = 64 * 1024;
+
+  explicit Arena(std::size_t blockSize = DEFAULT_BLOCK_SIZE);
+
+  Arena(const Arena&) = delete;
+  Arena& operator=(const Arena&) = delete;
+
+  void* allocate(std::size_t size, std::size_t alignment);
+
+  /** Make all of the arena's memory available again
+   *
+   * Invalidates all previous allocations. If more than one block was in use,
+   * they are replaced by a single block large enough to hold all of them,
+   * so that an arena which is reset regularly settles on a single block.
+   */
+  void reset();
+
+  /** Total size of all memory blocks owned by the arena */
+  std::size_t capacity() const;
+
+private:
+  struct Block
+  {
+    std::unique_ptr<std::byte[]> mpData;
+    std::size_t mSize;
+  };
+
+  void addBlock(std::size_t minimumSize);
+
+  std::vector<Block> mBlocks;
+  std::size_t mBlockSize;
+  std::size_t mUsedInCurrentBlock = 0;
+};
+
+
+/** Standard library allocator handing out memory from an Arena
+ *
+ * Deallocation does nothing, memory is only reclaimed when the arena is
+ * reset or destroyed. Containers using this allocator must therefore not
+ * outlive their arena.
+ */
+template <typename T>
+class ArenaAllocator
+{
+public:
+  using value_type = T;
+
+  explicit ArenaAllocator(Arena* pArena)
+    : mpArena(pArena)
+  {
+  }
+
+  template <typename U>
+  ArenaAllocator(const ArenaAllocator<U>& other) // NOLINT
+    : mpArena(other.arena())
+  {
+  }
+
+  T* allocate(const std::size_t count)
+  {
+    return static_cast<T*>(mpArena->allocate(sizeof(T) * count, alignof(T)));
+  }
+
+  void deallocate(T*, std::size_t) noexcept {}
+
+  Arena* arena() const { return mpArena; }
+
+  template <typename U>
+  bool operator==(const ArenaAllocator<U>& other) const
+  {
+    return mpArena == other.arena();
+  }
+
+  template <typename U>
+  bool operator!=(const ArenaAllocator<U>& other) const
+  {
+    return mpArena != other.arena();
+  }
+
+private:
+  Arena* mpArena;
+};
+
+
+template <typename T>
+using ArenaVector = std::vector<T, ArenaAllocator<T>>;
+
+} // namespace rigel::base
@@ -132,6 +132,32 @@ public:
 
   [[nodiscard]] constexpr const_pointer data() const noexcept { return mpData; }
 
+  /** View of count elements starting at offset
+   *
+   * Throws if the range exceeds this view.
+   */
+  [[nodiscard]] ArrayView
+    subView(const size_type offset, const size_type count) const
+  {
+    if (offset > mSize || count > mSize - offset)
+    {
+      detail::throwOutOfRange(offset + count);
+    }
+
+    return ArrayView{mpData + offset, count};
+  }
+
+  /** View of all elements starting at offset */
+  [[nodiscard]] ArrayView subView(const size_type offset) const
+  {
+    if (offset > mSize)
+    {
+      detail::throwOutOfRange(offset);
+    }
+
+    return ArrayView{mpData + offset, mSize - offset};
+  }
+
 private:
   const_pointer mpData = nullptr;
   size_type mSize = 0u;
@@ -0,0 +1,189 @@
+/* Copyright (C) 2022, Nikolai Wuttke. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "async_log_sink.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <utility>
+
+
+namespace rigel::base
+{
+
+#if defined(__EMSCRIPTEN__) && !defined(__EMSCRIPTEN_PTHREADS__)
+
+AsyncLogSink::AsyncLogSink(WriteFunction write)
+  : mWrite(std::move(write))
+{
+}
+
+
+AsyncLogSink::~AsyncLogSink() = default;
+
+
+bool AsyncLogSink::push(const std::string_view message)
+{
+  auto line = std::string{message.substr(0, MAX_MESSAGE_LENGTH)};
+  line += '\n';
+  mWrite(line);
+  return true;
+}
+
+
+void AsyncLogSink::flush() { }
+
+#else
+
+namespace
+{
+
+// How long the background thread waits before looking for new messages.
+// Producers don't wake it up, since that would require taking a lock.
+constexpr auto POLL_INTERVAL = std::chrono::milliseconds{10};
+
+} // namespace
+
+
+AsyncLogSink::AsyncLogSink(WriteFunction write)
+  : mWrite(std::move(write))
+{
+  // A slot is ready for writing position p when its sequence number equals
+  // p, and ready for reading once it's p + 1 (see push()).
+  for (auto i = std::size_t{0}; i < NUM_SLOTS; ++i)
+  {
+    mSlots[i].mSequence.store(i, std::memory_order_relaxed);
+  }
+
+  mThread = std::thread([this]() { run(); });
+}
+
+
+AsyncLogSink::~AsyncLogSink()
+{
+  {
+    std::lock_guard lock{mStopMutex};
+    mStopRequested = true;
+  }
+
+  mStopRequestedChanged.notify_all();
+  mThread.join();
+
+  drain();
+}
+
+
+bool AsyncLogSink::push(const std::string_view message)
+{
+  // Bounded multi-producer queue, as described by Dmitry Vyukov. Producers
+  // claim a position by advancing mWritePosition, but only if the slot at
+  // that position has already been read.
+  auto position = mWritePosition.load(std::memory_order_relaxed);
+  Slot* pSlot = nullptr;
+
+  for (;;)
+  {
+    pSlot = &mSlots[position % NUM_SLOTS];
+    const auto sequence = pSlot->mSequence.load(std::memory_order_acquire);
+    const auto difference =
+      static_cast<std::intptr_t>(sequence) -
+      static_cast<std::intptr_t>(position);
+
+    if (difference == 0)
+    {
+      if (mWritePosition.compare_exchange_weak(
+            position, position + 1, std::memory_order_relaxed))
+      {
+        break;
+      }
+    }
+    else if (difference < 0)
+    {
+      mNumDropped.fetch_add(1, std::memory_order_relaxed);
+      return false;
+    }
+    else
+    {
+      position = mWritePosition.load(std::memory_order_relaxed);
+    }
+  }
+
+  pSlot->mLength = std::min(message.size(), MAX_MESSAGE_LENGTH);
+  std::copy_n(message.data(), pSlot->mLength, pSlot->mText.data());
+  pSlot->mSequence.store(position + 1, std::memory_order_release);
+  return true;
+}
+
+
+void AsyncLogSink::flush()
+{
+  drain();
+}
+
+
+void AsyncLogSink::run()
+{
+  std::unique_lock lock{mStopMutex};
+
+  while (!mStopRequested)
+  {
+    lock.unlock();
+    drain();
+    lock.lock();
+
+    mStopRequestedChanged.wait_for(
+      lock, POLL_INTERVAL, [this]() { return mStopRequested; });
+  }
+}
+
+
+void AsyncLogSink::drain()
+{
+  std::lock_guard lock{mDrainMutex};
+
+  mBatch.clear();
+
+  for (;;)
+  {
+    auto& slot = mSlots[mReadPosition % NUM_SLOTS];
+    const auto sequence = slot.mSequence.load(std::memory_order_acquire);
+    if (sequence != mReadPosition + 1)
+    {
+      break;
+    }
+
+    mBatch.append(slot.mText.data(), slot.mLength);
+    mBatch += '\n';
+
+    slot.mSequence.store(mReadPosition + NUM_SLOTS, std::memory_order_release);
+    ++mReadPosition;
+  }
+
+  if (const auto numDropped = mNumDropped.exchange(0); numDropped != 0)
+  {
+    mBatch += "[" + std::to_string(numDropped) + " log messages dropped]\n";
+  }
+
+  if (!mBatch.empty())
+  {
+    mWrite(mBatch);
+  }
+}
+
+#endif
+
+} // namespace rigel::base
@@ -0,0 +1,113 @@
+/* Copyright (C) 2022, Nikolai Wuttke. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+
+
+namespace rigel::base
+{
+
+/** Writes log messages out on a background thread
+ *
+ * Meant to sit behind the logging library, so that logging from the
+ * main loop or the audio thread never has to wait for file I/O. Threads
+ * logging a message only copy it into a slot of a fixed-size ring buffer,
+ * without taking any locks. A background thread picks up messages every
+ * few milliseconds, and hands them to the write function in batches.
+ *
+ * Logging never blocks: If the buffer is full, the message is dropped, and
+ * a note about the number of dropped messages is written out later on.
+ * Messages longer than MAX_MESSAGE_LENGTH are truncated.
+ *
+ * On destruction, all messages queued so far are written out before the
+ * thread is joined. On platforms without thread support (Emscripten
+ * without pthreads), messages are written immediately.
+ */
+class AsyncLogSink
+{
+public:
+  using WriteFunction = std::function<void(std::string_view)>;
+
+  static constexpr auto NUM_SLOTS = std::size_t{1024};
+  static constexpr auto MAX_MESSAGE_LENGTH = std::size_t{500};
+
+  /** Create a sink writing via the given function
+   *
+   * The function receives one or more complete lines at a time. It's
+   * invoked from the background thread, or from the thread calling
+   * flush(), but never concurrently.
+   */
+  explicit AsyncLogSink(WriteFunction write);
+  ~AsyncLogSink();
+
+  AsyncLogSink(const AsyncLogSink&) = delete;
+  AsyncLogSink& operator=(const AsyncLogSink&) = delete;
+
+  /** Queue a message (without line break) for writing
+   *
+   * Safe to call from any thread. Returns false if the message had to be
+   * dropped because the buffer is full.
+   */
+  bool push(std::string_view message);
+
+  /** Write out all messages queued so far, from the calling thread
+   *
+   * Meant for situations where messages must not get lost, like shutdown
+   * or a crash.
+   */
+  void flush();
+
+private:
+  struct Slot
+  {
+    std::atomic<std::size_t> mSequence;
+    std::size_t mLength;
+    std::array<char, MAX_MESSAGE_LENGTH> mText;
+  };
+
+#if !defined(__EMSCRIPTEN__) || defined(__EMSCRIPTEN_PTHREADS__)
+  void run();
+  void drain();
+
+  std::array<Slot, NUM_SLOTS> mSlots;
+  std::atomic<std::size_t> mWritePosition{0};
+  std::atomic<std::size_t> mNumDropped{0};
+
+  // Consumer side, protected by mDrainMutex
+  std::mutex mDrainMutex;
+  std::size_t mReadPosition = 0;
+  std::string mBatch;
+
+  std::mutex mStopMutex;
+  std::condition_variable mStopRequestedChanged;
+  bool mStopRequested = false;
+  std::thread mThread;
+#endif
+
+  WriteFunction mWrite;
+};
+
+} // namespace rigel::base
@@ -0,0 +1,78 @@
+/* Copyright (C) 2022, Nikolai Wuttke. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "budget_controller.hpp"
+
+
+namespace rigel::base
+{
+
+BudgetController::BudgetController(const Config& config)
+  : mConfig(config)
+{
+}
+
+
+bool BudgetController::update(const float cost, const float budget)
+{
+  if (budget <= 0.0f)
+  {
+    return false;
+  }
+
+  mSmoothedCost = mSmoothedCost
+    ? *mSmoothedCost + (cost - *mSmoothedCost) * mConfig.mSmoothingFactor
+    : cost;
+
+  const auto load = *mSmoothedCost / budget;
+  mMeasurementsOverBudget =
+    load > mConfig.mReduceThreshold ? mMeasurementsOverBudget + 1 : 0;
+  mMeasurementsUnderBudget =
+    load < mConfig.mRestoreThreshold ? mMeasurementsUnderBudget + 1 : 0;
+
+  const auto previousLevel = mLevel;
+
+  if (
+    mMeasurementsOverBudget >= mConfig.mMeasurementsBeforeReduce &&
+    mLevel < mConfig.mMaxLevel)
+  {
+    ++mLevel;
+  }
+  else if (
+    mMeasurementsUnderBudget >= mConfig.mMeasurementsBeforeRestore &&
+    mLevel > 0)
+  {
+    --mLevel;
+  }
+
+  if (mLevel == previousLevel)
+  {
+    return false;
+  }
+
+  mSmoothedCost.reset();
+  mMeasurementsOverBudget = 0;
+  mMeasurementsUnderBudget = 0;
+  return true;
+}
+
+
+void BudgetController::reset()
+{
+  *this = BudgetController{mConfig};
+}
+
+} // namespace rigel::base
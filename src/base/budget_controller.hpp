@@ -0,0 +1,75 @@
+/* Copyright (C) 2022, Nikolai Wuttke. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <optional>
+
+
+namespace rigel::base
+{
+
+/** Picks a quality level which keeps a measured cost within a budget
+ *
+ * Level 0 means full quality, each level above that reduces it by a step.
+ * Measurements (e.g. frame times) are smoothed with an exponential moving
+ * average. Once the smoothed cost has stayed above a fraction of the budget
+ * for a number of consecutive measurements, the level goes up by one. It
+ * goes back down after the cost has stayed below a lower fraction of the
+ * budget for another, usually much higher, number of measurements. The gap
+ * between the two thresholds keeps the level from oscillating, and the
+ * required number of measurements keeps short spikes from having an effect.
+ *
+ * Measurements taken before a level change are discarded, since they don't
+ * say much about the cost at the new level.
+ */
+class BudgetController
+{
+public:
+  struct Config
+  {
+    // Weight of the most recent measurement in the smoothed cost
+    float mSmoothingFactor;
+
+    // Fractions of the budget above/below which the level is adjusted
+    float mReduceThreshold;
+    float mRestoreThreshold;
+
+    int mMeasurementsBeforeReduce;
+    int mMeasurementsBeforeRestore;
+
+    int mMaxLevel;
+  };
+
+  explicit BudgetController(const Config& config);
+
+  /** Returns true if the level has changed */
+  bool update(float cost, float budget);
+
+  /** Go back to level 0, and forget all previous measurements */
+  void reset();
+
+  int level() const { return mLevel; }
+
+private:
+  Config mConfig;
+  std::optional<float> mSmoothedCost;
+  int mMeasurementsOverBudget = 0;
+  int mMeasurementsUnderBudget = 0;
+  int mLevel = 0;
+};
+
+} // namespace rigel::base
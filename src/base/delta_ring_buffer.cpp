@@ -0,0 +1,292 @@
+/* Copyright (C) 2022, Nikolai Wuttke. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "delta_ring_buffer.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <stdexcept>
+
+
+namespace rigel::base
+{
+
+namespace
+{
+
+// A literal run in a delta is only ended by a matching run of at least this
+// many bytes, since each switch between runs costs a few bytes itself.
+constexpr auto MIN_MATCH_LENGTH = std::size_t{4};
+
+
+void writeVarInt(std::vector<std::uint8_t>& output, std::size_t value)
+{
+  while (value >= 0x80)
+  {
+    output.push_back(static_cast<std::uint8_t>(value | 0x80));
+    value >>= 7;
+  }
+
+  output.push_back(static_cast<std::uint8_t>(value));
+}
+
+
+std::size_t readVarInt(const std::vector<std::uint8_t>& input, std::size_t& pos)
+{
+  auto value = std::size_t{0};
+  auto shift = 0;
+
+  for (;;)
+  {
+    if (pos >= input.size())
+    {
+      throw std::runtime_error("Corrupt delta frame");
+    }
+
+    const auto byte = input[pos++];
+    value |= static_cast<std::size_t>(byte & 0x7F) << shift;
+
+    if ((byte & 0x80) == 0)
+    {
+      return value;
+    }
+
+    shift += 7;
+  }
+}
+
+
+std::size_t matchLength(
+  const std::vector<std::uint8_t>& current,
+  const std::vector<std::uint8_t>& previous,
+  const std::size_t start,
+  const std::size_t limit)
+{
+  const auto end = std::min({current.size(), previous.size(), start + limit});
+
+  auto pos = start;
+  while (pos < end && current[pos] == previous[pos])
+  {
+    ++pos;
+  }
+
+  return pos - start;
+}
+
+
+/** Encode current as a sequence of (unchanged, changed bytes) runs
+ *
+ * Format: Size of current, followed by pairs of unchanged byte count and
+ * changed byte count, each changed count followed by the new bytes.
+ */
+std::vector<std::uint8_t> encodeDelta(
+  const std::vector<std::uint8_t>& previous,
+  const std::vector<std::uint8_t>& current)
+{
+  std::vector<std::uint8_t> delta;
+  writeVarInt(delta, current.size());
+
+  auto pos = std::size_t{0};
+  while (pos < current.size())
+  {
+    const auto numUnchanged =
+      matchLength(current, previous, pos, current.size());
+    pos += numUnchanged;
+
+    const auto literalStart = pos;
+    while (pos < current.size())
+    {
+      const auto match = matchLength(current, previous, pos, MIN_MATCH_LENGTH);
+      if (match == MIN_MATCH_LENGTH || pos + match == current.size())
+      {
+        break;
+      }
+
+      ++pos;
+    }
+
+    writeVarInt(delta, numUnchanged);
+    writeVarInt(delta, pos - literalStart);
+    delta.insert(
+      delta.end(),
+      current.begin() + literalStart,
+      current.begin() + pos);
+  }
+
+  return delta;
+}
+
+
+std::vector<std::uint8_t> applyDelta(
+  const std::vector<std::uint8_t>& previous,
+  const std::vector<std::uint8_t>& delta)
+{
+  auto readPos = std::size_t{0};
+  const auto size = readVarInt(delta, readPos);
+
+  auto result = previous;
+  result.resize(size);
+
+  auto pos = std::size_t{0};
+  while (pos < size)
+  {
+    pos += readVarInt(delta, readPos);
+    const auto numChanged = readVarInt(delta, readPos);
+
+    if (pos + numChanged > size || readPos + numChanged > delta.size())
+    {
+      throw std::runtime_error("Corrupt delta frame");
+    }
+
+    std::copy_n(delta.begin() + readPos, numChanged, result.begin() + pos);
+    readPos += numChanged;
+    pos += numChanged;
+  }
+
+  return result;
+}
+
+} // namespace
+
+
+DeltaRingBuffer::DeltaRingBuffer(
+  const std::size_t memoryBudgetBytes,
+  const int keyFrameInterval)
+  : mMemoryBudget(memoryBudgetBytes)
+  , mKeyFrameInterval(std::max(keyFrameInterval, 1))
+{
+}
+
+
+void DeltaRingBuffer::push(const Frame& frame)
+{
+  const auto isKeyFrame =
+    mEntries.empty() || mFramesSinceKeyFrame + 1 >= mKeyFrameInterval;
+
+  auto entry = isKeyFrame ? Entry{frame, true}
+                          : Entry{encodeDelta(mNewestFrame, frame), false};
+  mFramesSinceKeyFrame = isKeyFrame ? 0 : mFramesSinceKeyFrame + 1;
+
+  mMemoryUsage += memoryUsageOf(entry);
+  mMemoryUsage -= mNewestFrame.size();
+  mMemoryUsage += frame.size();
+
+  mEntries.push_back(std::move(entry));
+  mNewestFrame = frame;
+
+  dropOldestKeyFrameGroups();
+}
+
+
+DeltaRingBuffer::Frame DeltaRingBuffer::frame(const std::size_t stepsBack) const
+{
+  assert(stepsBack < mEntries.size());
+
+  if (stepsBack == 0)
+  {
+    return mNewestFrame;
+  }
+
+  const auto index = mEntries.size() - 1 - stepsBack;
+
+  auto keyFrameIndex = index;
+  while (!mEntries[keyFrameIndex].mIsKeyFrame)
+  {
+    assert(keyFrameIndex > 0);
+    --keyFrameIndex;
+  }
+
+  auto result = mEntries[keyFrameIndex].mData;
+  for (auto i = keyFrameIndex + 1; i <= index; ++i)
+  {
+    result = applyDelta(result, mEntries[i].mData);
+  }
+
+  return result;
+}
+
+
+void DeltaRingBuffer::discardNewest(const std::size_t count)
+{
+  if (count >= mEntries.size())
+  {
+    clear();
+    return;
+  }
+
+  auto newestFrame = frame(count);
+
+  for (auto i = std::size_t{0}; i < count; ++i)
+  {
+    mMemoryUsage -= memoryUsageOf(mEntries.back());
+    mEntries.pop_back();
+  }
+
+  mMemoryUsage -= mNewestFrame.size();
+  mMemoryUsage += newestFrame.size();
+  mNewestFrame = std::move(newestFrame);
+
+  mFramesSinceKeyFrame = 0;
+  for (auto it = mEntries.rbegin(); !it->mIsKeyFrame; ++it)
+  {
+    ++mFramesSinceKeyFrame;
+  }
+}
+
+
+void DeltaRingBuffer::clear()
+{
+  mEntries.clear();
+  mNewestFrame.clear();
+  mMemoryUsage = 0;
+  mFramesSinceKeyFrame = 0;
+}
+
+
+std::size_t DeltaRingBuffer::memoryUsageOf(const Entry& entry)
+{
+  return entry.mData.size() + sizeof(Entry);
+}
+
+
+void DeltaRingBuffer::dropOldestKeyFrameGroups()
+{
+  auto nextKeyFrameAfterFront = [this]() {
+    return std::find_if(
+      std::next(mEntries.begin()), mEntries.end(), [](const Entry& entry) {
+        return entry.mIsKeyFrame;
+      });
+  };
+
+  while (mMemoryUsage > mMemoryBudget)
+  {
+    const auto groupEnd = nextKeyFrameAfterFront();
+    if (groupEnd == mEntries.end())
+    {
+      // Only the most recent group is left
+      break;
+    }
+
+    for (auto it = mEntries.begin(); it != groupEnd; ++it)
+    {
+      mMemoryUsage -= memoryUsageOf(*it);
+    }
+
+    mEntries.erase(mEntries.begin(), groupEnd);
+  }
+}
+
+} // namespace rigel::base
@@ -0,0 +1,95 @@
+/* Copyright (C) 2022, Nikolai Wuttke. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+
+namespace rigel::base
+{
+
+/** Ring buffer of binary state snapshots, stored as deltas
+ *
+ * Meant for keeping a history of per-frame game state, e.g. for rewinding.
+ * Every n-th pushed frame is stored as a key frame, i.e. in full. All other
+ * frames are stored as the difference to the previous frame, which is
+ * usually much smaller. Reconstructing a frame decodes forward from the
+ * nearest preceding key frame.
+ *
+ * The memory used for stored frames is kept under the given budget by
+ * dropping the oldest frames. Since deltas depend on their key frame, this
+ * always drops a key frame together with all of its deltas. The most recent
+ * frames are never dropped, even if they exceed the budget on their own.
+ */
+class DeltaRingBuffer
+{
+public:
+  using Frame = std::vector<std::uint8_t>;
+
+  explicit DeltaRingBuffer(
+    std::size_t memoryBudgetBytes,
+    int keyFrameInterval = 60);
+
+  void push(const Frame& frame);
+
+  /** Reconstruct a stored frame
+   *
+   * 0 is the most recently pushed frame, 1 the one before etc. Must be
+   * less than size().
+   */
+  Frame frame(std::size_t stepsBack) const;
+
+  /** Remove the given number of most recent frames
+   *
+   * After stepping backward, this makes the reconstructed frame the most
+   * recent one again, so that recording can continue from there.
+   */
+  void discardNewest(std::size_t count);
+
+  void clear();
+
+  std::size_t size() const { return mEntries.size(); }
+  bool empty() const { return mEntries.empty(); }
+
+  /** Memory currently used for storing frames, in bytes */
+  std::size_t memoryUsage() const { return mMemoryUsage; }
+
+  std::size_t memoryBudget() const { return mMemoryBudget; }
+
+private:
+  struct Entry
+  {
+    std::vector<std::uint8_t> mData;
+    bool mIsKeyFrame;
+  };
+
+  static std::size_t memoryUsageOf(const Entry& entry);
+
+  void dropOldestKeyFrameGroups();
+
+  std::deque<Entry> mEntries;
+  Frame mNewestFrame;
+  std::size_t mMemoryUsage = 0;
+  std::size_t mMemoryBudget;
+  int mKeyFrameInterval;
+  int mFramesSinceKeyFrame = 0;
+};
+
+} // namespace rigel::base
@@ -16,12 +16,24 @@
 
 #pragma once
 
+#include "base/array_view.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <utility>
 #include <vector>
 
 
 namespace rigel::base
 {
 
+/** Fixed-size 2D array, stored in row-major order
+ *
+ * Each row is contiguous in memory, so rows can be processed as a whole via
+ * row() and rowData(). Since different rows don't share any elements,
+ * processing different rows on different threads is safe.
+ */
 template <typename ValueT>
 class Grid
 {
@@ -39,9 +51,14 @@ public:
     return mStorage[x + y * mWidth];
   }
 
+  ValueT& valueAt(const std::size_t x, const std::size_t y)
+  {
+    return mStorage[x + y * mWidth];
+  }
+
   void setValueAt(const std::size_t x, const std::size_t y, ValueT value)
   {
-    mStorage[x + y * mWidth] = value;
+    mStorage[x + y * mWidth] = std::move(value);
   }
 
   const ValueT& valueAtWithDefault(
@@ -56,6 +73,91 @@ public:
     return valueAt(x, y);
   }
 
+  ArrayView<ValueT> row(const std::size_t y) const
+  {
+    assert(y < mHeight);
+    return ArrayView<ValueT>{
+      rowData(y), static_cast<typename ArrayView<ValueT>::size_type>(mWidth)};
+  }
+
+  const ValueT* rowData(const std::size_t y) const
+  {
+    return mStorage.data() + y * mWidth;
+  }
+
+  ValueT* rowData(const std::size_t y) { return mStorage.data() + y * mWidth; }
+
+  void fill(const ValueT& value)
+  {
+    std::fill(mStorage.begin(), mStorage.end(), value);
+  }
+
+  /** Set all cells in the given rectangle to value
+   *
+   * The rectangle must be within the grid.
+   */
+  void fillRect(
+    const std::size_t left,
+    const std::size_t top,
+    const std::size_t width,
+    const std::size_t height,
+    const ValueT& value)
+  {
+    assert(left + width <= mWidth && top + height <= mHeight);
+
+    for (auto y = top; y < top + height; ++y)
+    {
+      const auto pRowStart = rowData(y) + left;
+      std::fill(pRowStart, pRowStart + width, value);
+    }
+  }
+
+  /** Copy a rectangle of cells from source to the given destination
+   *
+   * Both rectangles must be within their respective grid. If source is this
+   * grid, the rectangles must not overlap.
+   */
+  void copyRect(
+    const Grid& source,
+    const std::size_t sourceLeft,
+    const std::size_t sourceTop,
+    const std::size_t width,
+    const std::size_t height,
+    const std::size_t destLeft,
+    const std::size_t destTop)
+  {
+    assert(
+      sourceLeft + width <= source.mWidth &&
+      sourceTop + height <= source.mHeight);
+    assert(destLeft + width <= mWidth && destTop + height <= mHeight);
+
+    for (auto i = std::size_t{0}; i < height; ++i)
+    {
+      const auto pSourceStart = source.rowData(sourceTop + i) + sourceLeft;
+      std::copy(
+        pSourceStart, pSourceStart + width, rowData(destTop + i) + destLeft);
+    }
+  }
+
+  /** Invoke func(x, y, value) for each cell that's not default-constructed */
+  template <typename Func>
+  void forEachNonDefault(Func&& func) const
+  {
+    const auto defaultValue = ValueT{};
+
+    auto iValue = mStorage.begin();
+    for (auto y = std::size_t{0}; y < mHeight; ++y)
+    {
+      for (auto x = std::size_t{0}; x < mWidth; ++x, ++iValue)
+      {
+        if (!(*iValue == defaultValue))
+        {
+          func(x, y, *iValue);
+        }
+      }
+    }
+  }
+
   std::size_t width() const { return mWidth; }
 
   std::size_t height() const { return mHeight; }
@@ -0,0 +1,101 @@
+/* Copyright (C) 2022, Nikolai Wuttke. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "base/spatial_types.hpp"
+
+#include <algorithm>
+#include <limits>
+#include <utility>
+
+
+namespace rigel::base
+{
+
+/** Division of a map into a uniform grid of square cells
+ *
+ * Describes only the layout, i.e. which cells a given area covers. Broad-
+ * phase indices built on top of this store their own per-cell contents,
+ * using cellIndex() to address them.
+ *
+ * Areas outside of the map are assigned to the closest cell on the grid's
+ * border, so the outermost cells also cover everything beyond the map.
+ */
+class GridLayout
+{
+public:
+  GridLayout(
+    const int widthInTiles,
+    const int heightInTiles,
+    const int cellSize)
+    : mWidth(std::max(1, (widthInTiles + cellSize - 1) / cellSize))
+    , mHeight(std::max(1, (heightInTiles + cellSize - 1) / cellSize))
+    , mCellSize(cellSize)
+  {
+  }
+
+  int width() const { return mWidth; }
+  int height() const { return mHeight; }
+  int numCells() const { return mWidth * mHeight; }
+
+  int cellIndex(const int x, const int y) const { return x + y * mWidth; }
+
+  /** Range of cells covering the given area, in cell coordinates */
+  Rect<int> cellsCovering(const Rect<int>& area) const
+  {
+    const auto left = clampToGrid(area.left(), mWidth);
+    const auto top = clampToGrid(area.top(), mHeight);
+    const auto right = clampToGrid(area.right(), mWidth);
+    const auto bottom = clampToGrid(area.bottom(), mHeight);
+
+    return {{left, top}, {right - left + 1, bottom - top + 1}};
+  }
+
+  /** Range of x coordinates assigned to the given column (inclusive) */
+  std::pair<int, int> coordinatesInColumn(const int x) const
+  {
+    return coordinatesInCell(x, mWidth);
+  }
+
+  /** Range of y coordinates assigned to the given row (inclusive) */
+  std::pair<int, int> coordinatesInRow(const int y) const
+  {
+    return coordinatesInCell(y, mHeight);
+  }
+
+private:
+  int clampToGrid(const int coordinate, const int numCells) const
+  {
+    return std::clamp(coordinate / mCellSize, 0, numCells - 1);
+  }
+
+  std::pair<int, int>
+    coordinatesInCell(const int cell, const int numCells) const
+  {
+    const auto first =
+      cell == 0 ? std::numeric_limits<int>::min() : cell * mCellSize;
+    const auto last = cell == numCells - 1 ? std::numeric_limits<int>::max()
+                                           : (cell + 1) * mCellSize - 1;
+    return {first, last};
+  }
+
+  int mWidth;
+  int mHeight;
+  int mCellSize;
+};
+
+} // namespace rigel::base
@@ -16,6 +16,7 @@
 
 #include "image.hpp"
 
+#include <algorithm>
 #include <stdexcept>
 
 
@@ -73,6 +74,70 @@ Image Image::flipped() const
 }
 
 
+void Image::flipVertically()
+{
+  for (std::size_t y = 0; y < height() / 2; ++y)
+  {
+    const auto iRow = mPixels.begin() + y * width();
+    const auto iMirroredRow = mPixels.begin() + (height() - y - 1) * width();
+    std::swap_ranges(iRow, iRow + width(), iMirroredRow);
+  }
+}
+
+
+Image Image::downscaled(const std::size_t factor) const
+{
+  if (factor == 0)
+  {
+    throw invalid_argument("Downscaling factor must not be 0");
+  }
+
+  const auto newWidth = width() / factor;
+  const auto newHeight = height() / factor;
+
+  PixelBuffer scaledPixels;
+  scaledPixels.reserve(newWidth * newHeight);
+
+  for (std::size_t y = 0; y < newHeight; ++y)
+  {
+    for (std::size_t x = 0; x < newWidth; ++x)
+    {
+      std::uint32_t r = 0;
+      std::uint32_t g = 0;
+      std::uint32_t b = 0;
+      std::uint32_t a = 0;
+
+      for (auto sourceY = y * factor; sourceY < (y + 1) * factor; ++sourceY)
+      {
+        for (auto sourceX = x * factor; sourceX < (x + 1) * factor; ++sourceX)
+        {
+          const auto& pixel = mPixels[sourceX + sourceY * mWidth];
+          r += pixel.r * pixel.a;
+          g += pixel.g * pixel.a;
+          b += pixel.b * pixel.a;
+          a += pixel.a;
+        }
+      }
+
+      if (a == 0)
+      {
+        scaledPixels.push_back(Pixel{});
+        continue;
+      }
+
+      const auto numPixels = std::uint32_t(factor * factor);
+      scaledPixels.push_back(Pixel{
+        std::uint8_t(r / a),
+        std::uint8_t(g / a),
+        std::uint8_t(b / a),
+        std::uint8_t(a / numPixels)});
+    }
+  }
+
+  return Image{std::move(scaledPixels), newWidth, newHeight};
+}
+
+
 void Image::insertImage(const size_t x, const size_t y, const Image& image)
 {
   insertImage(x, y, image.pixelData(), image.width());
@@ -103,4 +168,73 @@ void Image::insertImage(
 }
 
 
+IndexedImage::IndexedImage(
+  IndexedPixelBuffer&& indices,
+  const std::size_t width,
+  const std::size_t height,
+  const Palette16& palette)
+  : mIndices(std::move(indices))
+  , mPalette(palette)
+  , mWidth(width)
+  , mHeight(height)
+{
+}
+
+
+IndexedImage::IndexedImage(
+  const std::size_t width,
+  const std::size_t height,
+  const Palette16& palette)
+  : IndexedImage(
+      IndexedPixelBuffer(width * height, TRANSPARENT_FLAG),
+      width,
+      height,
+      palette)
+{
+}
+
+
+void IndexedImage::insertImage(
+  const size_t x,
+  const size_t y,
+  const IndexedImage& image)
+{
+  if (x + image.width() > mWidth || y + image.height() > mHeight)
+  {
+    throw invalid_argument("Source image doesn't fit");
+  }
+
+  if (image.palette() != mPalette)
+  {
+    throw invalid_argument("Source image uses a different palette");
+  }
+
+  auto sourceIter = image.indexData().begin();
+  for (size_t row = 0; row < image.height(); ++row)
+  {
+    const auto targetIter = mIndices.begin() + x + (y + row) * mWidth;
+    std::copy_n(sourceIter, image.width(), targetIter);
+    sourceIter += image.width();
+  }
+}
+
+
+Image IndexedImage::toImage() const
+{
+  auto pixels = PixelBuffer(mIndices.size());
+  std::transform(
+    mIndices.begin(), mIndices.end(), pixels.begin(), [this](const auto index) {
+      auto color = mPalette[index & INDEX_MASK];
+      if (index & TRANSPARENT_FLAG)
+      {
+        color.a = 0;
+      }
+
+      return color;
+    });
+
+  return Image{std::move(pixels), mWidth, mHeight};
+}
+
+
 } // namespace rigel::data
@@ -18,6 +18,7 @@
 
 #include "base/color.hpp"
 
+#include <array>
 #include <cstdint>
 #include <vector>
 
@@ -27,6 +28,8 @@ namespace rigel::data
 
 using Pixel = rigel::base::Color;
 using PixelBuffer = std::vector<Pixel>;
+using IndexedPixelBuffer = std::vector<std::uint8_t>;
+using Palette16 = std::array<Pixel, 16>;
 
 
 /** Simple technology-agnostic image data holder.
@@ -48,6 +51,18 @@ public:
 
   Image flipped() const;
 
+  /** Like flipped(), but modifies the image in place */
+  void flipVertically();
+
+  /** Return a copy reduced in size by the given integer factor
+   *
+   * Each output pixel is the average of a factor x factor block of input
+   * pixels, weighted by alpha so that fully transparent pixels don't darken
+   * the edges of opaque areas. Partial blocks at the right and bottom edges
+   * are dropped.
+   */
+  Image downscaled(std::size_t factor) const;
+
   void insertImage(std::size_t x, std::size_t y, const Image& image);
   void insertImage(
     std::size_t x,
@@ -62,4 +77,52 @@ private:
 };
 
 
+/** Image made up of indices into a 16-color palette
+ *
+ * All of the original game's artwork is 16-color indexed, so storing it in
+ * this form needs only a quarter of the memory of an RGBA Image. Pixels
+ * with TRANSPARENT_FLAG set are fully transparent, but still keep their
+ * color index, so that toImage() produces exactly the same pixels as
+ * applying the mask to an RGBA image. Use toImage() to get an RGBA version,
+ * e.g. for creating a texture.
+ */
+class IndexedImage
+{
+public:
+  static constexpr std::uint8_t TRANSPARENT_FLAG = 0x10;
+  static constexpr std::uint8_t INDEX_MASK = 0x0F;
+
+  IndexedImage(
+    IndexedPixelBuffer&& indices,
+    std::size_t width,
+    std::size_t height,
+    const Palette16& palette);
+
+  /** Create fully transparent image */
+  IndexedImage(std::size_t width, std::size_t height, const Palette16& palette);
+
+  const IndexedPixelBuffer& indexData() const { return mIndices; }
+
+  const Palette16& palette() const { return mPalette; }
+
+  std::size_t width() const { return mWidth; }
+
+  std::size_t height() const { return mHeight; }
+
+  /** Copy the given image's pixels into this one
+   *
+   * Both images must use the same palette.
+   */
+  void insertImage(std::size_t x, std::size_t y, const IndexedImage& image);
+
+  Image toImage() const;
+
+private:
+  IndexedPixelBuffer mIndices;
+  Palette16 mPalette;
+  std::size_t mWidth;
+  std::size_t mHeight;
+};
+
+
 } // namespace rigel::data
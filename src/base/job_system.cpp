@@ -0,0 +1,462 @@
+/* Copyright (C) 2022, Nikolai Wuttke. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "job_system.hpp"
+
+#include "base/tracing.hpp"
+
+#include <deque>
+#include <utility>
+
+
+namespace rigel::base
+{
+
+namespace detail
+{
+
+struct Job
+{
+  JobSystem::Task mTask;
+  std::exception_ptr mpException;
+
+  // Guards mDependents, and setting mIsDone
+  std::mutex mMutex;
+  std::vector<std::shared_ptr<Job>> mDependents;
+
+  // Starts at one for the submission itself, so that the job can't start
+  // while dependencies are still being registered.
+  std::atomic<int> mPendingDependencies{1};
+  std::atomic<bool> mIsDone{false};
+  bool mRunOnMainThread = false;
+};
+
+} // namespace detail
+
+
+struct JobSystem::Queue
+{
+  std::mutex mMutex;
+  std::deque<JobPtr> mJobs;
+};
+
+
+namespace
+{
+
+#if defined(__EMSCRIPTEN__) && !defined(__EMSCRIPTEN_PTHREADS__)
+constexpr auto HAS_THREADS = false;
+#else
+constexpr auto HAS_THREADS = true;
+#endif
+
+
+thread_local const JobSystem* tpCurrentJobSystem = nullptr;
+thread_local int tCurrentWorkerIndex = -1;
+
+
+int defaultWorkerCount()
+{
+  const auto numCores = static_cast<int>(std::thread::hardware_concurrency());
+  return std::max(numCores, 2) - 1;
+}
+
+} // namespace
+
+
+bool JobHandle::isDone() const
+{
+  return !mpJob || mpJob->mIsDone;
+}
+
+
+JobSystem::JobSystem(const int numWorkers)
+  : mpMainThreadQueue(std::make_unique<Queue>())
+  , mNumWorkers(HAS_THREADS ? std::max(numWorkers, 0) : 0)
+  , mMainThreadId(std::this_thread::get_id())
+{
+  for (auto i = 0; i <= mNumWorkers; ++i)
+  {
+    mQueues.push_back(std::make_unique<Queue>());
+  }
+}
+
+
+JobSystem::~JobSystem()
+{
+  {
+    std::lock_guard lock{mSleepMutex};
+    mStopRequested = true;
+  }
+
+  mWorkAvailable.notify_all();
+
+  for (auto& worker : mWorkers)
+  {
+    worker.join();
+  }
+}
+
+
+JobSystem& JobSystem::instance()
+{
+  static JobSystem instance{defaultWorkerCount()};
+  return instance;
+}
+
+
+bool JobSystem::isMainThread() const
+{
+  return std::this_thread::get_id() == mMainThreadId;
+}
+
+
+void JobSystem::setDeterministic(const bool deterministic)
+{
+  mIsDeterministic = deterministic;
+}
+
+
+bool JobSystem::isDeterministic() const
+{
+  return mIsDeterministic || mNumWorkers == 0;
+}
+
+
+template <typename Predicate>
+void JobSystem::runJobsUntil(Predicate isDone)
+{
+  const auto onMainThread = isMainThread();
+
+  while (!isDone())
+  {
+    if (runOneJob())
+    {
+      continue;
+    }
+
+    std::unique_lock lock{mSleepMutex};
+    mStateChanged.wait(lock, [&]() {
+      return isDone() || mNumQueuedJobs > 0 ||
+        (onMainThread && mNumMainThreadJobs > 0);
+    });
+  }
+}
+
+
+JobHandle
+  JobSystem::submit(Task task, const std::vector<JobHandle>& dependencies)
+{
+  return submitJob(std::move(task), dependencies, false);
+}
+
+
+JobHandle JobSystem::submitOnMainThread(
+  Task task,
+  const std::vector<JobHandle>& dependencies)
+{
+  return submitJob(std::move(task), dependencies, true);
+}
+
+
+void JobSystem::wait(const JobHandle& job)
+{
+  if (!job.mpJob)
+  {
+    return;
+  }
+
+  const auto& state = *job.mpJob;
+  runJobsUntil([&]() { return state.mIsDone.load(); });
+
+  if (state.mpException)
+  {
+    std::rethrow_exception(state.mpException);
+  }
+}
+
+
+void JobSystem::waitUntilIdle()
+{
+  runJobsUntil([this]() { return mNumUnfinishedJobs == 0; });
+}
+
+
+int JobSystem::runMainThreadTasks()
+{
+  auto numJobsRun = 0;
+
+  while (auto pJob = takeMainThreadJob())
+  {
+    execute(pJob);
+    ++numJobsRun;
+  }
+
+  return numJobsRun;
+}
+
+
+JobHandle JobSystem::submitJob(
+  Task task,
+  const std::vector<JobHandle>& dependencies,
+  const bool runOnMainThread)
+{
+  auto pJob = std::make_shared<detail::Job>();
+  pJob->mTask = std::move(task);
+  pJob->mRunOnMainThread = runOnMainThread;
+  ++mNumUnfinishedJobs;
+
+  for (const auto& dependency : dependencies)
+  {
+    if (!dependency.mpJob)
+    {
+      continue;
+    }
+
+    std::lock_guard lock{dependency.mpJob->mMutex};
+    if (!dependency.mpJob->mIsDone)
+    {
+      dependency.mpJob->mDependents.push_back(pJob);
+      ++pJob->mPendingDependencies;
+    }
+  }
+
+  auto handle = JobHandle{pJob};
+  if (--pJob->mPendingDependencies == 0)
+  {
+    enqueue(std::move(pJob));
+  }
+
+  return handle;
+}
+
+
+void JobSystem::enqueue(JobPtr pJob)
+{
+  if (pJob->mRunOnMainThread)
+  {
+    if (isDeterministic() && isMainThread())
+    {
+      execute(pJob);
+      return;
+    }
+
+    {
+      std::lock_guard lock{mpMainThreadQueue->mMutex};
+      mpMainThreadQueue->mJobs.push_back(std::move(pJob));
+    }
+
+    ++mNumMainThreadJobs;
+    notifyStateChanged();
+    return;
+  }
+
+  if (isDeterministic())
+  {
+    execute(pJob);
+    return;
+  }
+
+  startWorkers();
+
+  const auto queueIndex =
+    tpCurrentJobSystem == this ? tCurrentWorkerIndex : mNumWorkers;
+  {
+    auto& queue = *mQueues[queueIndex];
+    std::lock_guard lock{queue.mMutex};
+    queue.mJobs.push_back(std::move(pJob));
+  }
+
+  ++mNumQueuedJobs;
+  notifyStateChanged();
+  mWorkAvailable.notify_one();
+}
+
+
+void JobSystem::execute(const JobPtr& pJob)
+{
+  try
+  {
+    pJob->mTask();
+  }
+  catch (...)
+  {
+    pJob->mpException = std::current_exception();
+  }
+
+  // Release anything the task holds on to right away, handles to the job
+  // might be kept around for much longer.
+  pJob->mTask = nullptr;
+
+  std::vector<JobPtr> dependents;
+  {
+    std::lock_guard lock{pJob->mMutex};
+    pJob->mIsDone = true;
+    std::swap(dependents, pJob->mDependents);
+  }
+
+  for (auto& pDependent : dependents)
+  {
+    if (--pDependent->mPendingDependencies == 0)
+    {
+      enqueue(std::move(pDependent));
+    }
+  }
+
+  --mNumUnfinishedJobs;
+  notifyStateChanged();
+}
+
+
+JobSystem::JobPtr JobSystem::takeJob(const int workerIndex)
+{
+  if (mNumQueuedJobs == 0)
+  {
+    return nullptr;
+  }
+
+  // Own queue first, newest job first since its data is most likely still
+  // in the cache.
+  if (workerIndex >= 0)
+  {
+    auto& queue = *mQueues[workerIndex];
+    std::lock_guard lock{queue.mMutex};
+    if (!queue.mJobs.empty())
+    {
+      auto pJob = std::move(queue.mJobs.back());
+      queue.mJobs.pop_back();
+      --mNumQueuedJobs;
+      return pJob;
+    }
+  }
+
+  // Then steal the oldest job from someone else, starting with the queue
+  // after our own so that workers don't all go for the same one.
+  const auto numQueues = static_cast<int>(mQueues.size());
+  for (auto offset = 1; offset <= numQueues; ++offset)
+  {
+    const auto index = (std::max(workerIndex, 0) + offset) % numQueues;
+    if (index == workerIndex)
+    {
+      continue;
+    }
+
+    auto& queue = *mQueues[index];
+    std::lock_guard lock{queue.mMutex};
+    if (!queue.mJobs.empty())
+    {
+      auto pJob = std::move(queue.mJobs.front());
+      queue.mJobs.pop_front();
+      --mNumQueuedJobs;
+      return pJob;
+    }
+  }
+
+  return nullptr;
+}
+
+
+JobSystem::JobPtr JobSystem::takeMainThreadJob()
+{
+  if (mNumMainThreadJobs == 0)
+  {
+    return nullptr;
+  }
+
+  std::lock_guard lock{mpMainThreadQueue->mMutex};
+  if (mpMainThreadQueue->mJobs.empty())
+  {
+    return nullptr;
+  }
+
+  auto pJob = std::move(mpMainThreadQueue->mJobs.front());
+  mpMainThreadQueue->mJobs.pop_front();
+  --mNumMainThreadJobs;
+  return pJob;
+}
+
+
+bool JobSystem::runOneJob()
+{
+  auto pJob = isMainThread() ? takeMainThreadJob() : nullptr;
+  if (!pJob)
+  {
+    pJob = takeJob(tpCurrentJobSystem == this ? tCurrentWorkerIndex : -1);
+  }
+
+  if (!pJob)
+  {
+    return false;
+  }
+
+  execute(pJob);
+  return true;
+}
+
+
+void JobSystem::startWorkers()
+{
+  std::call_once(mWorkersStarted, [this]() {
+    for (auto i = 0; i < mNumWorkers; ++i)
+    {
+      mWorkers.emplace_back([this, i]() { runWorker(i); });
+    }
+  });
+}
+
+
+void JobSystem::runWorker(const int workerIndex)
+{
+  tpCurrentJobSystem = this;
+  tCurrentWorkerIndex = workerIndex;
+  tracing::setCurrentThreadName("Job worker");
+
+  for (;;)
+  {
+    if (auto pJob = takeJob(workerIndex))
+    {
+      execute(pJob);
+      continue;
+    }
+
+    std::unique_lock lock{mSleepMutex};
+    mWorkAvailable.wait(
+      lock, [this]() { return mNumQueuedJobs > 0 || mStopRequested; });
+
+    // Remaining jobs are still completed when stopping. Without a stop
+    // request, someone else might have taken the job which woke us up in the
+    // meantime, in which case we go back to waiting.
+    if (mStopRequested && mNumQueuedJobs == 0)
+    {
+      return;
+    }
+  }
+}
+
+
+void JobSystem::notifyStateChanged()
+{
+  // Taking the lock makes sure that a thread which just found nothing to do
+  // is either already waiting, or will see the new state when checking. This
+  // applies to workers waiting on mWorkAvailable as well.
+  {
+    std::lock_guard lock{mSleepMutex};
+  }
+
+  mStateChanged.notify_all();
+}
+
+} // namespace rigel::base
@@ -0,0 +1,261 @@
+/* Copyright (C) 2022, Nikolai Wuttke. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+namespace rigel::base
+{
+
+namespace detail
+{
+
+struct Job;
+
+}
+
+
+/** Refers to a job submitted to a JobSystem
+ *
+ * A default-constructed handle doesn't refer to any job, and counts as done.
+ */
+class JobHandle
+{
+public:
+  JobHandle() = default;
+
+  bool isDone() const;
+
+private:
+  friend class JobSystem;
+
+  explicit JobHandle(std::shared_ptr<detail::Job> pJob)
+    : mpJob(std::move(pJob))
+  {
+  }
+
+  std::shared_ptr<detail::Job> mpJob;
+};
+
+
+/** Thread pool shared by everything that wants to run work in parallel
+ *
+ * Each worker thread has its own queue of jobs. Jobs submitted from within a
+ * job go to the current worker's queue, and are taken from there in LIFO
+ * order. Idle workers steal the oldest jobs from other queues. Jobs
+ * submitted from other threads go to a separate queue, which all workers take
+ * from.
+ *
+ * Jobs can depend on other jobs, and only start once all of those have
+ * finished. This is enough to express task graphs: Submit jobs in
+ * topological order, passing the handles of their predecessors.
+ *
+ * Some work can only be done on the main thread, like uploading textures to
+ * the GPU. Jobs submitted via submitOnMainThread() are run by
+ * runMainThreadTasks(), which the game calls once per frame, or whenever the
+ * main thread waits for a job.
+ *
+ * Waiting for a job doesn't block the waiting thread: It runs other queued
+ * jobs until the one it's waiting for is done. Jobs may wait for other jobs,
+ * but not for main thread jobs, since those might never run then.
+ *
+ * In deterministic mode, jobs run right away on the thread submitting them
+ * (or the one finishing their last dependency), and parallelFor() runs in
+ * index order. The order of execution then doesn't depend on thread
+ * scheduling, which is what replays and tests need. The same happens on
+ * platforms without thread support (Emscripten without pthreads).
+ */
+class JobSystem
+{
+public:
+  using Task = std::function<void()>;
+
+  /** Creates a job system with given number of worker threads
+   *
+   * The calling thread becomes the main thread. Worker threads aren't
+   * started until the first job is submitted outside of deterministic mode.
+   */
+  explicit JobSystem(int numWorkers);
+  ~JobSystem();
+
+  JobSystem(const JobSystem&) = delete;
+  JobSystem& operator=(const JobSystem&) = delete;
+
+  /** The shared instance, with one worker for each CPU core but one
+   *
+   * The first thread to call this is taken to be the main thread.
+   */
+  static JobSystem& instance();
+
+  int workerCount() const { return mNumWorkers; }
+  bool isMainThread() const;
+
+  void setDeterministic(bool deterministic);
+  bool isDeterministic() const;
+
+  JobHandle submit(Task task, const std::vector<JobHandle>& dependencies = {});
+  JobHandle submitOnMainThread(
+    Task task,
+    const std::vector<JobHandle>& dependencies = {});
+
+  /** Block until the job is done, running other jobs meanwhile
+   *
+   * If the job's task threw an exception, it's rethrown here. Jobs depending
+   * on a failed job still run.
+   */
+  void wait(const JobHandle& job);
+
+  /** Block until all jobs submitted so far are done, running them meanwhile
+   *
+   * Like wait(), but for everything. Meant for shutting down, when jobs
+   * might still refer to objects that are about to be destroyed. Exceptions
+   * thrown by jobs aren't reported here.
+   */
+  void waitUntilIdle();
+
+  /** Run all main thread jobs which are ready, returns how many were run
+   *
+   * Must only be called on the main thread.
+   */
+  int runMainThreadTasks();
+
+  /** Invoke func(i) for each i in [0, count), spread across all workers
+   *
+   * The calling thread takes part in the work, and this function only returns
+   * once all invocations are done. If any of them throw, one of the exceptions
+   * is rethrown here. func must not touch any state that's shared between
+   * invocations without synchronization.
+   */
+  template <typename Func>
+  void parallelFor(std::size_t count, Func&& func);
+
+private:
+  struct Queue;
+  using JobPtr = std::shared_ptr<detail::Job>;
+
+  JobHandle submitJob(
+    Task task,
+    const std::vector<JobHandle>& dependencies,
+    bool runOnMainThread);
+  void enqueue(JobPtr pJob);
+  void execute(const JobPtr& pJob);
+  JobPtr takeJob(int workerIndex);
+  JobPtr takeMainThreadJob();
+  bool runOneJob();
+  template <typename Predicate>
+  void runJobsUntil(Predicate isDone);
+  void startWorkers();
+  void runWorker(int workerIndex);
+  void notifyStateChanged();
+
+  // One queue per worker, followed by the one for jobs submitted from
+  // outside of the job system.
+  std::vector<std::unique_ptr<Queue>> mQueues;
+  std::unique_ptr<Queue> mpMainThreadQueue;
+  std::vector<std::thread> mWorkers;
+  std::once_flag mWorkersStarted;
+
+  std::mutex mSleepMutex;
+  std::condition_variable mWorkAvailable;
+  std::condition_variable mStateChanged;
+  std::atomic<int> mNumUnfinishedJobs{0};
+  std::atomic<int> mNumQueuedJobs{0};
+  std::atomic<int> mNumMainThreadJobs{0};
+  std::atomic<bool> mIsDeterministic{false};
+  bool mStopRequested = false;
+
+  const int mNumWorkers;
+  const std::thread::id mMainThreadId;
+};
+
+
+template <typename Func>
+void JobSystem::parallelFor(const std::size_t count, Func&& func)
+{
+  const auto numThreads = isDeterministic()
+    ? std::size_t{1}
+    : std::min(count, static_cast<std::size_t>(mNumWorkers) + 1);
+
+  if (numThreads <= 1)
+  {
+    for (auto i = std::size_t{0}; i < count; ++i)
+    {
+      func(i);
+    }
+
+    return;
+  }
+
+  std::atomic<std::size_t> nextIndex{0};
+  auto processItems = [&]() {
+    for (auto i = nextIndex++; i < count; i = nextIndex++)
+    {
+      func(i);
+    }
+  };
+
+  std::vector<JobHandle> helpers;
+  helpers.reserve(numThreads - 1);
+  for (auto i = std::size_t{1}; i < numThreads; ++i)
+  {
+    helpers.push_back(submit(processItems));
+  }
+
+  // The helpers refer to state on our stack, so they need to be waited for
+  // even if something throws.
+  std::exception_ptr pError;
+  try
+  {
+    processItems();
+  }
+  catch (...)
+  {
+    pError = std::current_exception();
+  }
+
+  for (const auto& helper : helpers)
+  {
+    try
+    {
+      wait(helper);
+    }
+    catch (...)
+    {
+      if (!pError)
+      {
+        pError = std::current_exception();
+      }
+    }
+  }
+
+  if (pError)
+  {
+    std::rethrow_exception(pError);
+  }
+}
+
+} // namespace rigel::base
@@ -0,0 +1,218 @@
+/* Copyright (C) 2022, Nikolai Wuttke. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "memory_accounting.hpp"
+
+#include <array>
+#include <atomic>
+#include <iomanip>
+#include <ostream>
+#include <utility>
+
+
+namespace rigel::base
+{
+
+namespace
+{
+
+struct Counter
+{
+  std::atomic<std::size_t> mCurrent{0};
+  std::atomic<std::size_t> mPeak{0};
+};
+
+
+std::array<Counter, NUM_MEMORY_CATEGORIES> gCounters;
+
+
+Counter& counterFor(const MemoryCategory category)
+{
+  return gCounters[static_cast<std::size_t>(category)];
+}
+
+
+void adjust(
+  const MemoryCategory category,
+  const std::size_t oldBytes,
+  const std::size_t newBytes)
+{
+  auto& counter = counterFor(category);
+
+  if (newBytes < oldBytes)
+  {
+    counter.mCurrent.fetch_sub(oldBytes - newBytes, std::memory_order_relaxed);
+    return;
+  }
+
+  const auto delta = newBytes - oldBytes;
+  const auto current =
+    counter.mCurrent.fetch_add(delta, std::memory_order_relaxed) + delta;
+
+  auto peak = counter.mPeak.load(std::memory_order_relaxed);
+  while (current > peak &&
+         !counter.mPeak.compare_exchange_weak(
+           peak, current, std::memory_order_relaxed))
+  {
+  }
+}
+
+
+void printMegabytes(std::ostream& stream, const std::size_t bytes)
+{
+  stream << std::fixed << std::setprecision(1)
+         << double(bytes) / (1024.0 * 1024.0) << " MB";
+}
+
+} // namespace
+
+
+const char* memoryCategoryName(const MemoryCategory category)
+{
+  switch (category)
+  {
+    case MemoryCategory::AssetBuffers:
+      return "Asset buffers";
+
+    case MemoryCategory::SpriteData:
+      return "Sprite data";
+
+    case MemoryCategory::AtlasTextures:
+      return "Atlas textures (GPU)";
+
+    case MemoryCategory::MapBlocks:
+      return "Map blocks";
+
+    case MemoryCategory::SoundData:
+      return "Sound & music";
+
+    case MemoryCategory::WorldState:
+      return "World state";
+
+    case MemoryCategory::QuickSaves:
+      return "Quick saves";
+  }
+
+  return "Unknown";
+}
+
+
+std::size_t trackedBytes(const MemoryCategory category)
+{
+  return counterFor(category).mCurrent.load(std::memory_order_relaxed);
+}
+
+
+std::size_t peakTrackedBytes(const MemoryCategory category)
+{
+  return counterFor(category).mPeak.load(std::memory_order_relaxed);
+}
+
+
+void printMemoryUsage(std::ostream& stream)
+{
+  const auto previousFlags = stream.flags();
+  const auto previousPrecision = stream.precision();
+
+  auto total = std::size_t{0};
+
+  stream << "Memory (est.):\n";
+  for (auto i = 0; i < NUM_MEMORY_CATEGORIES; ++i)
+  {
+    const auto category = static_cast<MemoryCategory>(i);
+    const auto bytes = trackedBytes(category);
+    total += bytes;
+
+    stream << "  " << memoryCategoryName(category) << ": ";
+    printMegabytes(stream, bytes);
+    stream << " (peak ";
+    printMegabytes(stream, peakTrackedBytes(category));
+    stream << ")\n";
+  }
+
+  stream << "  Total: ";
+  printMegabytes(stream, total);
+  stream << '\n';
+
+  stream.flags(previousFlags);
+  stream.precision(previousPrecision);
+}
+
+
+TrackedMemory::TrackedMemory(
+  const MemoryCategory category,
+  const std::size_t bytes)
+  : mCategory(category)
+{
+  set(bytes);
+}
+
+
+TrackedMemory::~TrackedMemory()
+{
+  set(0);
+}
+
+
+TrackedMemory::TrackedMemory(const TrackedMemory& other)
+  : TrackedMemory(other.mCategory, other.mBytes)
+{
+}
+
+
+TrackedMemory& TrackedMemory::operator=(const TrackedMemory& other)
+{
+  if (this != &other)
+  {
+    set(0);
+    mCategory = other.mCategory;
+    set(other.mBytes);
+  }
+
+  return *this;
+}
+
+
+TrackedMemory::TrackedMemory(TrackedMemory&& other) noexcept
+  : mCategory(other.mCategory)
+  , mBytes(std::exchange(other.mBytes, 0))
+{
+}
+
+
+TrackedMemory& TrackedMemory::operator=(TrackedMemory&& other) noexcept
+{
+  if (this != &other)
+  {
+    set(0);
+    mCategory = other.mCategory;
+    mBytes = std::exchange(other.mBytes, 0);
+  }
+
+  return *this;
+}
+
+
+void TrackedMemory::set(const std::size_t bytes)
+{
+  if (bytes != mBytes)
+  {
+    adjust(mCategory, mBytes, bytes);
+    mBytes = bytes;
+  }
+}
+
+} // namespace rigel::base
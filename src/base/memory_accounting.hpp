@@ -0,0 +1,90 @@
+/* Copyright (C) 2022, Nikolai Wuttke. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <iosfwd>
+
+
+namespace rigel::base
+{
+
+/** Subsystems whose memory use is accounted for
+ *
+ * The numbers are estimates, meant for finding out where memory goes, not
+ * exact allocation statistics. Only the big buffers are counted. For
+ * textures and vertex buffers, the size is derived from their dimensions,
+ * actual GPU memory use depends on the driver.
+ */
+enum class MemoryCategory
+{
+  AssetBuffers,
+  SpriteData,
+  AtlasTextures,
+  MapBlocks,
+  SoundData,
+  WorldState,
+  QuickSaves
+};
+
+constexpr auto NUM_MEMORY_CATEGORIES = 7;
+
+
+const char* memoryCategoryName(MemoryCategory category);
+
+/** Bytes currently accounted to the given category
+ *
+ * Accounting is thread-safe, so this can be called at any time.
+ */
+std::size_t trackedBytes(MemoryCategory category);
+
+/** Highest value trackedBytes() had so far for the given category */
+std::size_t peakTrackedBytes(MemoryCategory category);
+
+/** Print current and peak usage of all categories, one per line */
+void printMemoryUsage(std::ostream& stream);
+
+
+/** Accounts a number of bytes to a category for as long as it lives
+ *
+ * Meant to be placed next to the buffer(s) it describes, as a member of the
+ * same object. Copies account the same amount again, moving transfers the
+ * bytes to the new object.
+ */
+class TrackedMemory
+{
+public:
+  TrackedMemory() = default;
+  explicit TrackedMemory(MemoryCategory category, std::size_t bytes = 0);
+  ~TrackedMemory();
+
+  TrackedMemory(const TrackedMemory& other);
+  TrackedMemory& operator=(const TrackedMemory& other);
+  TrackedMemory(TrackedMemory&& other) noexcept;
+  TrackedMemory& operator=(TrackedMemory&& other) noexcept;
+
+  /** Change the amount of bytes accounted by this object */
+  void set(std::size_t bytes);
+
+  std::size_t bytes() const { return mBytes; }
+
+private:
+  MemoryCategory mCategory = MemoryCategory::AssetBuffers;
+  std::size_t mBytes = 0;
+};
+
+} // namespace rigel::base
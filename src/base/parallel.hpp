@@ -0,0 +1,60 @@
+/* Copyright (C) 2022, Nikolai Wuttke. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "base/job_system.hpp"
+
+#include <cstddef>
+#include <future>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+
+namespace rigel::base
+{
+
+/** Run func on the shared job system, returns a future for its result
+ *
+ * In deterministic mode, and on platforms without thread support (Emscripten
+ * without pthreads), func is instead run right away on the calling thread.
+ */
+template <typename Func>
+auto runAsync(Func&& func)
+{
+  using Result = std::invoke_result_t<std::decay_t<Func>>;
+
+  // std::function needs a copyable target, packaged_task isn't
+  auto pTask =
+    std::make_shared<std::packaged_task<Result()>>(std::forward<Func>(func));
+  auto result = pTask->get_future();
+  JobSystem::instance().submit([pTask]() { (*pTask)(); });
+  return result;
+}
+
+
+/** Invoke func(i) for each i in [0, count), on the shared job system
+ *
+ * See JobSystem::parallelFor().
+ */
+template <typename Func>
+void parallelFor(const std::size_t count, Func&& func)
+{
+  JobSystem::instance().parallelFor(count, std::forward<Func>(func));
+}
+
+} // namespace rigel::base
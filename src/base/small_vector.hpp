@@ -0,0 +1,276 @@
+/* Copyright (C) 2022, Nikolai Wuttke. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <initializer_list>
+#include <new>
+#include <utility>
+#include <vector>
+
+
+namespace rigel::base
+{
+
+/** Vector which stores up to N elements without allocating
+ *
+ * Offers a subset of std::vector's interface. As long as it holds at most N
+ * elements, they are stored inline, within the object itself. When growing
+ * beyond that, all elements move to the heap, and stay there even if the
+ * vector shrinks again later.
+ *
+ * Meant for component members which usually only hold a handful of
+ * elements, so that creating and copying entities mostly avoids the heap.
+ */
+template <typename T, std::size_t N>
+class small_vector
+{
+public:
+  using value_type = T;
+  using size_type = std::size_t;
+  using reference = T&;
+  using const_reference = const T&;
+  using iterator = T*;
+  using const_iterator = const T*;
+
+  small_vector() = default;
+
+  small_vector(std::initializer_list<T> items)
+  {
+    reserve(items.size());
+    for (const auto& item : items)
+    {
+      push_back(item);
+    }
+  }
+
+  small_vector(const small_vector& other)
+  {
+    if (other.mUsesHeap)
+    {
+      mHeap = other.mHeap;
+      mUsesHeap = true;
+    }
+    else
+    {
+      for (const auto& item : other)
+      {
+        emplaceInline(item);
+      }
+    }
+  }
+
+  small_vector(small_vector&& other) noexcept { takeContentsOf(other); }
+
+  small_vector& operator=(const small_vector& other)
+  {
+    if (this != &other)
+    {
+      auto copy = other;
+      *this = std::move(copy);
+    }
+
+    return *this;
+  }
+
+  small_vector& operator=(small_vector&& other) noexcept
+  {
+    if (this != &other)
+    {
+      clear();
+      mHeap.shrink_to_fit();
+      mUsesHeap = false;
+      takeContentsOf(other);
+    }
+
+    return *this;
+  }
+
+  ~small_vector() { destroyInlineElements(); }
+
+  T* data() { return mUsesHeap ? mHeap.data() : inlineData(); }
+  const T* data() const { return mUsesHeap ? mHeap.data() : inlineData(); }
+
+  iterator begin() { return data(); }
+  iterator end() { return data() + size(); }
+  const_iterator begin() const { return data(); }
+  const_iterator end() const { return data() + size(); }
+
+  size_type size() const { return mUsesHeap ? mHeap.size() : mInlineSize; }
+  bool empty() const { return size() == 0; }
+
+  size_type capacity() const { return mUsesHeap ? mHeap.capacity() : N; }
+
+  /** True if the elements are currently stored inline */
+  bool isInline() const { return !mUsesHeap; }
+
+  T& operator[](const size_type index)
+  {
+    assert(index < size());
+    return data()[index];
+  }
+
+  const T& operator[](const size_type index) const
+  {
+    assert(index < size());
+    return data()[index];
+  }
+
+  T& front() { return (*this)[0]; }
+  const T& front() const { return (*this)[0]; }
+  T& back() { return (*this)[size() - 1]; }
+  const T& back() const { return (*this)[size() - 1]; }
+
+  void reserve(const size_type newCapacity)
+  {
+    if (mUsesHeap)
+    {
+      mHeap.reserve(newCapacity);
+    }
+    else if (newCapacity > N)
+    {
+      moveToHeap(newCapacity);
+    }
+  }
+
+  void push_back(const T& item) { emplace_back(item); }
+  void push_back(T&& item) { emplace_back(std::move(item)); }
+
+  template <typename... Args>
+  T& emplace_back(Args&&... args)
+  {
+    if (!mUsesHeap && mInlineSize < N)
+    {
+      return emplaceInline(std::forward<Args>(args)...);
+    }
+
+    if (!mUsesHeap)
+    {
+      // The arguments might refer to one of our own elements, so the new
+      // element has to be created before moving everything to the heap.
+      T newItem(std::forward<Args>(args)...);
+      moveToHeap(N * 2);
+      mHeap.push_back(std::move(newItem));
+      return mHeap.back();
+    }
+
+    return mHeap.emplace_back(std::forward<Args>(args)...);
+  }
+
+  void pop_back()
+  {
+    assert(!empty());
+
+    if (mUsesHeap)
+    {
+      mHeap.pop_back();
+    }
+    else
+    {
+      --mInlineSize;
+      inlineData()[mInlineSize].~T();
+    }
+  }
+
+  void clear()
+  {
+    destroyInlineElements();
+    mHeap.clear();
+  }
+
+  friend bool operator==(const small_vector& lhs, const small_vector& rhs)
+  {
+    return std::equal(lhs.begin(), lhs.end(), rhs.begin(), rhs.end());
+  }
+
+  friend bool operator!=(const small_vector& lhs, const small_vector& rhs)
+  {
+    return !(lhs == rhs);
+  }
+
+private:
+  T* inlineData()
+  {
+    return std::launder(reinterpret_cast<T*>(mInlineStorage));
+  }
+
+  const T* inlineData() const
+  {
+    return std::launder(reinterpret_cast<const T*>(mInlineStorage));
+  }
+
+  template <typename... Args>
+  T& emplaceInline(Args&&... args)
+  {
+    assert(!mUsesHeap && mInlineSize < N);
+
+    auto pItem =
+      new (inlineData() + mInlineSize) T(std::forward<Args>(args)...);
+    ++mInlineSize;
+    return *pItem;
+  }
+
+  void destroyInlineElements()
+  {
+    for (auto i = size_type{0}; i < mInlineSize; ++i)
+    {
+      inlineData()[i].~T();
+    }
+
+    mInlineSize = 0;
+  }
+
+  void moveToHeap(const size_type newCapacity)
+  {
+    mHeap.reserve(std::max(newCapacity, N));
+    for (auto i = size_type{0}; i < mInlineSize; ++i)
+    {
+      mHeap.push_back(std::move(inlineData()[i]));
+    }
+
+    destroyInlineElements();
+    mUsesHeap = true;
+  }
+
+  // Expects this to be empty and using inline storage
+  void takeContentsOf(small_vector& other)
+  {
+    if (other.mUsesHeap)
+    {
+      mHeap = std::move(other.mHeap);
+      mUsesHeap = true;
+    }
+    else
+    {
+      for (auto& item : other)
+      {
+        emplaceInline(std::move(item));
+      }
+
+      other.clear();
+    }
+  }
+
+  alignas(T) std::byte mInlineStorage[sizeof(T) * N];
+  size_type mInlineSize = 0;
+  std::vector<T> mHeap;
+  bool mUsesHeap = false;
+};
+
+} // namespace rigel::base
@@ -24,6 +24,7 @@ RIGEL_DISABLE_WARNINGS
 RIGEL_RESTORE_WARNINGS
 
 
+#include <algorithm>
 #include <cstdint>
 #include <tuple>
 
@@ -155,6 +156,22 @@ Rect<ValueT> makeRect(Vec2T<ValueT> topLeft, Vec2T<ValueT> bottomRight)
 }
 
 
+/** Smallest rectangle containing both lhs and rhs */
+template <typename ValueT>
+Rect<ValueT> unite(const Rect<ValueT>& lhs, const Rect<ValueT>& rhs)
+{
+  const auto left = std::min(lhs.left(), rhs.left());
+  const auto top = std::min(lhs.top(), rhs.top());
+  const auto right = std::max(lhs.right(), rhs.right());
+  const auto bottom = std::max(lhs.bottom(), rhs.bottom());
+
+  return Rect<ValueT>{
+    {left, top},
+    {static_cast<ValueT>(right - left + 1),
+     static_cast<ValueT>(bottom - top + 1)}};
+}
+
+
 template <typename ValueT>
 Vec2T<ValueT> operator+(const Vec2T<ValueT>& lhs, const Vec2T<ValueT>& rhs)
 {
@@ -0,0 +1,179 @@
+/* Copyright (C) 2022, Nikolai Wuttke. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "startup_timings.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <iomanip>
+#include <mutex>
+#include <ostream>
+#include <thread>
+
+
+namespace rigel::base::startup_timings
+{
+
+namespace
+{
+
+struct State
+{
+  std::mutex mMutex;
+  std::vector<PhaseTiming> mPhases;
+  Clock::time_point mStartTime;
+  std::thread::id mMainThreadId;
+};
+
+
+std::atomic<bool> gIsRecording = false;
+thread_local int tCurrentDepth = 0;
+
+
+State& state()
+{
+  static State instance;
+  return instance;
+}
+
+
+double millisecondsBetween(
+  const Clock::time_point start,
+  const Clock::time_point end)
+{
+  return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+} // namespace
+
+
+void begin()
+{
+  auto& s = state();
+  std::lock_guard lock{s.mMutex};
+
+  s.mPhases.clear();
+  s.mStartTime = Clock::now();
+  s.mMainThreadId = std::this_thread::get_id();
+  gIsRecording.store(true, std::memory_order_relaxed);
+}
+
+
+Report finish()
+{
+  auto& s = state();
+  std::lock_guard lock{s.mMutex};
+
+  gIsRecording.store(false, std::memory_order_relaxed);
+
+  auto report = Report{};
+  report.mPhases = std::move(s.mPhases);
+  report.mTotalMs = millisecondsBetween(s.mStartTime, Clock::now());
+  s.mPhases.clear();
+
+  // Enclosing phases end after the ones they contain, so they need to be
+  // moved in front of them.
+  std::stable_sort(
+    report.mPhases.begin(),
+    report.mPhases.end(),
+    [](const PhaseTiming& lhs, const PhaseTiming& rhs) {
+      return lhs.mStartMs < rhs.mStartMs ||
+        (lhs.mStartMs == rhs.mStartMs && lhs.mDepth < rhs.mDepth);
+    });
+
+  return report;
+}
+
+
+bool isRecording()
+{
+  return gIsRecording.load(std::memory_order_relaxed);
+}
+
+
+void printReport(std::ostream& stream, const Report& report)
+{
+  const auto previousFlags = stream.flags();
+  const auto previousPrecision = stream.precision();
+
+  constexpr auto NAME_COLUMN_WIDTH = 40;
+
+  stream << std::left << std::setw(NAME_COLUMN_WIDTH) << "Phase"
+         << std::right << std::setw(11) << "Start" << std::setw(11)
+         << "Duration" << '\n';
+  stream << std::fixed << std::setprecision(1);
+
+  for (const auto& phase : report.mPhases)
+  {
+    auto name = std::string(phase.mDepth * 2, ' ') + phase.mName;
+    if (phase.mOnWorkerThread)
+    {
+      name += " (async)";
+    }
+
+    stream << std::left << std::setw(NAME_COLUMN_WIDTH) << name << std::right
+           << std::setw(8) << phase.mStartMs << " ms" << std::setw(8)
+           << phase.mDurationMs << " ms\n";
+  }
+
+  stream << std::left << std::setw(NAME_COLUMN_WIDTH) << "Total"
+         << std::right << std::setw(19) << report.mTotalMs << " ms\n";
+
+  stream.flags(previousFlags);
+  stream.precision(previousPrecision);
+}
+
+
+ScopedPhase::ScopedPhase(const char* name)
+  : mTraceZone(name)
+  , mName(isRecording() ? name : nullptr)
+{
+  if (mName)
+  {
+    mStartTime = Clock::now();
+    ++tCurrentDepth;
+  }
+}
+
+
+ScopedPhase::~ScopedPhase()
+{
+  if (!mName)
+  {
+    return;
+  }
+
+  const auto endTime = Clock::now();
+  --tCurrentDepth;
+
+  auto& s = state();
+  std::lock_guard lock{s.mMutex};
+
+  // finish() might have been called while this phase was running
+  if (!isRecording())
+  {
+    return;
+  }
+
+  s.mPhases.push_back(PhaseTiming{
+    mName,
+    tCurrentDepth,
+    std::this_thread::get_id() != s.mMainThreadId,
+    millisecondsBetween(s.mStartTime, mStartTime),
+    millisecondsBetween(mStartTime, endTime)});
+}
+
+} // namespace rigel::base::startup_timings
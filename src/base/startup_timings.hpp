@@ -0,0 +1,108 @@
+/* Copyright (C) 2022, Nikolai Wuttke. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "base/clock.hpp"
+#include "base/tracing.hpp"
+
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+
+/* Measures how long the individual phases of startup take
+ *
+ * Recording starts with begin() at the top of main(), and ends with finish()
+ * once the first frame has been shown. Phases can be nested, and can also
+ * be recorded on worker threads, which is useful to see how much work
+ * happens concurrently. Outside of that window (e.g. when loading levels
+ * later on, or in tools and tests), phases cost a single branch.
+ *
+ * Phases are also recorded as trace zones when tracing is enabled.
+ */
+namespace rigel::base::startup_timings
+{
+
+struct PhaseTiming
+{
+  std::string mName;
+
+  /** Nesting level, 0 for phases not contained in another one */
+  int mDepth = 0;
+
+  bool mOnWorkerThread = false;
+
+  /** Relative to the call to begin() */
+  double mStartMs = 0.0;
+  double mDurationMs = 0.0;
+};
+
+
+struct Report
+{
+  std::vector<PhaseTiming> mPhases;
+
+  /** Time from begin() to finish() */
+  double mTotalMs = 0.0;
+};
+
+
+void begin();
+
+/** Stop recording and return all phases, sorted by start time */
+Report finish();
+
+bool isRecording();
+
+/** Print the report as a table, one phase per line */
+void printReport(std::ostream& stream, const Report& report);
+
+
+/** Records the enclosing scope as a startup phase
+ *
+ * The name must be a string literal.
+ */
+class ScopedPhase
+{
+public:
+  explicit ScopedPhase(const char* name);
+  ~ScopedPhase();
+
+  ScopedPhase(const ScopedPhase&) = delete;
+  ScopedPhase& operator=(const ScopedPhase&) = delete;
+
+private:
+  tracing::Zone mTraceZone;
+  const char* mName;
+  Clock::time_point mStartTime;
+};
+
+
+/** Invoke func and record the call as a startup phase
+ *
+ * Meant for measuring the construction of members in a constructor's
+ * initializer list. The result is returned without making any copies, so
+ * this also works for types which aren't movable.
+ */
+template <typename Func>
+auto measure(const char* name, Func&& func)
+{
+  const auto phase = ScopedPhase{name};
+  return func();
+}
+
+} // namespace rigel::base::startup_timings
@@ -0,0 +1,282 @@
+/* Copyright (C) 2022, Nikolai Wuttke. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "tick_profiler.hpp"
+
+#include "base/tracing.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <ostream>
+#include <stdexcept>
+
+
+namespace rigel::base
+{
+
+namespace
+{
+
+// While tracing is enabled, sections are also recorded as trace zones. They
+// can be nested, so their start times are kept on a stack.
+constexpr auto MAX_TRACED_SECTION_DEPTH = 16;
+
+struct TracedSection
+{
+  const char* mName;
+  Clock::time_point mStartTime;
+};
+
+std::array<TracedSection, MAX_TRACED_SECTION_DEPTH> gTracedSections;
+int gNumTracedSections = 0;
+
+
+float microsecondsBetween(
+  const Clock::time_point start,
+  const Clock::time_point end)
+{
+  return std::chrono::duration<float, std::micro>(end - start).count();
+}
+
+} // namespace
+
+
+TickProfiler& TickProfiler::instance()
+{
+  static TickProfiler profiler;
+  return profiler;
+}
+
+
+void TickProfiler::setEnabled(const bool enabled)
+{
+  if (enabled == mIsEnabled)
+  {
+    return;
+  }
+
+  mIsEnabled = enabled;
+
+  if (enabled)
+  {
+    mWritePosition = 0;
+    mNumRecordedTicks = 0;
+    resetCurrentTick();
+  }
+}
+
+
+int TickProfiler::beginSectionSlow(const char* name)
+{
+  const auto index = findOrAddSection(name);
+  if (index != INVALID_TOKEN)
+  {
+    mSectionStartTimes[index] = Clock::now();
+  }
+
+  return index;
+}
+
+
+void TickProfiler::endSectionSlow(const int token)
+{
+  const auto now = Clock::now();
+
+  auto& tick = currentTick();
+  auto& sample = tick.mSamples[token];
+
+  // A section can run more than once per tick, in which case the durations
+  // are added up and the start of the first run is kept.
+  if (!sample.mWasRecorded)
+  {
+    sample.mStartUs =
+      microsecondsBetween(tick.mStartTime, mSectionStartTimes[token]);
+    sample.mWasRecorded = true;
+  }
+
+  sample.mDurationUs += microsecondsBetween(mSectionStartTimes[token], now);
+}
+
+
+int TickProfiler::findOrAddSection(const char* name)
+{
+  for (auto i = 0; i < mNumSections; ++i)
+  {
+    if (
+      mSectionNames[i] == name || std::strcmp(mSectionNames[i], name) == 0)
+    {
+      return i;
+    }
+  }
+
+  if (mNumSections == MAX_SECTIONS)
+  {
+    return INVALID_TOKEN;
+  }
+
+  mSectionNames[mNumSections] = name;
+  return mNumSections++;
+}
+
+
+void TickProfiler::resetCurrentTick()
+{
+  auto& tick = currentTick();
+  tick.mStartTime = Clock::now();
+  tick.mSamples.fill({});
+}
+
+
+int TickProfiler::oldestTickIndex() const
+{
+  return (mWritePosition - mNumRecordedTicks + HISTORY_SIZE) % HISTORY_SIZE;
+}
+
+
+void TickProfiler::endTick()
+{
+  if (!mIsEnabled)
+  {
+    return;
+  }
+
+  mWritePosition = (mWritePosition + 1) % HISTORY_SIZE;
+  // One slot is always taken up by the tick that's currently being recorded
+  mNumRecordedTicks = std::min(mNumRecordedTicks + 1, HISTORY_SIZE - 1);
+  resetCurrentTick();
+}
+
+
+void TickProfiler::printSummary(std::ostream& stream) const
+{
+  stream << "Tick profile (" << mNumRecordedTicks << " ticks, avg/max ms):\n";
+
+  for (auto section = 0; section < mNumSections; ++section)
+  {
+    auto totalUs = 0.0f;
+    auto maxUs = 0.0f;
+
+    for (auto i = 0; i < mNumRecordedTicks; ++i)
+    {
+      const auto& tick = mHistory[(oldestTickIndex() + i) % HISTORY_SIZE];
+      const auto& sample = tick.mSamples[section];
+      totalUs += sample.mDurationUs;
+      maxUs = std::max(maxUs, sample.mDurationUs);
+    }
+
+    const auto averageUs =
+      mNumRecordedTicks > 0 ? totalUs / mNumRecordedTicks : 0.0f;
+
+    stream << "  " << mSectionNames[section] << ": " << std::fixed
+           << std::setprecision(3) << averageUs / 1000.0f << " / "
+           << maxUs / 1000.0f << '\n';
+  }
+}
+
+
+void TickProfiler::writeTrace(const std::filesystem::path& path) const
+{
+  std::ofstream file(path, std::ios::out | std::ios::trunc);
+  if (!file.is_open())
+  {
+    throw std::runtime_error("Cannot open trace file for writing");
+  }
+
+  if (mNumRecordedTicks == 0)
+  {
+    file << "[]\n";
+    return;
+  }
+
+  // All timestamps are relative to the oldest recorded tick
+  const auto firstIndex = oldestTickIndex();
+  const auto baseTime = mHistory[firstIndex].mStartTime;
+
+  file << "[\n";
+  file << std::fixed << std::setprecision(3);
+
+  auto isFirstEvent = true;
+  for (auto i = 0; i < mNumRecordedTicks; ++i)
+  {
+    const auto& tick = mHistory[(firstIndex + i) % HISTORY_SIZE];
+    const auto tickStartUs = microsecondsBetween(baseTime, tick.mStartTime);
+
+    for (auto section = 0; section < mNumSections; ++section)
+    {
+      const auto& sample = tick.mSamples[section];
+      if (!sample.mWasRecorded)
+      {
+        continue;
+      }
+
+      if (!isFirstEvent)
+      {
+        file << ",\n";
+      }
+      isFirstEvent = false;
+
+      file << R"({"name":")" << mSectionNames[section]
+           << R"(","ph":"X","pid":1,"tid":1,"ts":)"
+           << tickStartUs + sample.mStartUs << R"(,"dur":)"
+           << sample.mDurationUs << '}';
+    }
+  }
+
+  file << "\n]\n";
+
+  if (!file)
+  {
+    throw std::runtime_error("Failed to write trace file");
+  }
+}
+
+} // namespace rigel::base
+
+
+// The returned token combines the profiler's token with a flag telling
+// whether the section is being traced, in the lowest bit.
+int rigel_beginProfiledSection(const char* name)
+{
+  using namespace rigel::base;
+
+  auto isTraced = false;
+  if (
+    tracing::isEnabled() && gNumTracedSections < MAX_TRACED_SECTION_DEPTH)
+  {
+    gTracedSections[gNumTracedSections++] = {name, Clock::now()};
+    isTraced = true;
+  }
+
+  const auto profilerToken = TickProfiler::instance().beginSection(name);
+  return (profilerToken + 1) * 2 + (isTraced ? 1 : 0);
+}
+
+
+void rigel_endProfiledSection(const int token)
+{
+  using namespace rigel::base;
+
+  TickProfiler::instance().endSection(token / 2 - 1);
+
+  if (token & 1)
+  {
+    const auto& section = gTracedSections[--gNumTracedSections];
+    tracing::detail::recordZone(
+      section.mName, section.mStartTime, Clock::now());
+  }
+}
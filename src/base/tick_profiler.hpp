@@ -0,0 +1,180 @@
+/* Copyright (C) 2022, Nikolai Wuttke. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+/* Lightweight profiler for measuring how much time each part of the game
+ * logic takes per tick. Usable from both C and C++ code.
+ *
+ * Sections are identified by name (a string literal). Each tick's
+ * measurements are stored in a ring buffer, which can be summarized in the
+ * debug overlay or written to a trace file. When the profiler is disabled,
+ * beginning and ending a section costs a single branch. While tracing is
+ * enabled (see base/tracing.hpp), sections are also recorded as trace zones.
+ *
+ * The profiler must only be used from the main thread.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Start measuring the section with the given name
+ *
+ * Returns a token which must be passed to rigel_endProfiledSection().
+ */
+int rigel_beginProfiledSection(const char* name);
+
+void rigel_endProfiledSection(int token);
+
+#ifdef __cplusplus
+}
+#endif
+
+
+/** Measure the duration of the given statement as a profiler section
+ *
+ * The statement is passed as variadic argument, so that it may contain
+ * commas (e.g. in brace initializers).
+ */
+#define RIGEL_PROFILE_CALL(name, ...)                                          \
+  do                                                                           \
+  {                                                                            \
+    const int rigelProfileToken_ = rigel_beginProfiledSection(name);           \
+    __VA_ARGS__;                                                               \
+    rigel_endProfiledSection(rigelProfileToken_);                              \
+  } while (0)
+
+
+#ifdef __cplusplus
+
+  #include "base/clock.hpp"
+  #include "base/tracing.hpp"
+
+  #include <array>
+  #include <filesystem>
+  #include <iosfwd>
+
+
+namespace rigel::base
+{
+
+class TickProfiler
+{
+public:
+  static constexpr int MAX_SECTIONS = 32;
+  static constexpr int HISTORY_SIZE = 256;
+  static constexpr int INVALID_TOKEN = -1;
+
+  static TickProfiler& instance();
+
+  bool isEnabled() const { return mIsEnabled; }
+  void setEnabled(bool enabled);
+
+  int beginSection(const char* name)
+  {
+    if (!mIsEnabled)
+    {
+      return INVALID_TOKEN;
+    }
+
+    return beginSectionSlow(name);
+  }
+
+  void endSection(const int token)
+  {
+    if (token != INVALID_TOKEN)
+    {
+      endSectionSlow(token);
+    }
+  }
+
+  /** Conclude the current tick and start recording the next one */
+  void endTick();
+
+  /** Print average and maximum time per section over the recorded ticks */
+  void printSummary(std::ostream& stream) const;
+
+  /** Write recorded ticks in Chrome's trace event format
+   *
+   * The resulting file can be viewed in chrome://tracing or Perfetto.
+   * Throws std::runtime_error if the file can't be written.
+   */
+  void writeTrace(const std::filesystem::path& path) const;
+
+private:
+  struct SectionSample
+  {
+    float mStartUs = 0.0f;
+    float mDurationUs = 0.0f;
+    bool mWasRecorded = false;
+  };
+
+  struct TickRecord
+  {
+    Clock::time_point mStartTime;
+    std::array<SectionSample, MAX_SECTIONS> mSamples;
+  };
+
+  TickProfiler() = default;
+
+  int beginSectionSlow(const char* name);
+  void endSectionSlow(int token);
+  int findOrAddSection(const char* name);
+  void resetCurrentTick();
+  int oldestTickIndex() const;
+  TickRecord& currentTick() { return mHistory[mWritePosition]; }
+
+  std::array<const char*, MAX_SECTIONS> mSectionNames{};
+  std::array<Clock::time_point, MAX_SECTIONS> mSectionStartTimes;
+  std::array<TickRecord, HISTORY_SIZE> mHistory;
+  int mNumSections = 0;
+  int mWritePosition = 0;
+  int mNumRecordedTicks = 0;
+  bool mIsEnabled = false;
+};
+
+
+/** Measures the enclosing scope as a profiler section
+ *
+ * Also records a trace zone while tracing is enabled.
+ */
+class ProfileScope
+{
+public:
+  explicit ProfileScope(const char* name)
+    : mTraceZone(name)
+    , mToken(TickProfiler::instance().beginSection(name))
+  {
+  }
+
+  ~ProfileScope() { TickProfiler::instance().endSection(mToken); }
+
+  ProfileScope(const ProfileScope&) = delete;
+  ProfileScope& operator=(const ProfileScope&) = delete;
+
+private:
+  tracing::Zone mTraceZone;
+  int mToken;
+};
+
+} // namespace rigel::base
+
+
+  #define RIGEL_PROFILE_SCOPE(name)                                            \
+    const ::rigel::base::ProfileScope rigelProfileScope_(name)
+
+#endif
@@ -0,0 +1,269 @@
+/* Copyright (C) 2022, Nikolai Wuttke. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "tracing.hpp"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+
+
+namespace rigel::base::tracing
+{
+
+namespace detail
+{
+
+std::atomic<bool> gIsEnabled{false};
+
+}
+
+
+namespace
+{
+
+constexpr auto ZONES_PER_THREAD = std::size_t{1} << 15;
+
+
+struct RecordedZone
+{
+  const char* mName;
+  Clock::time_point mStartTime;
+  Clock::time_point mEndTime;
+};
+
+
+// Written only by the owning thread. The write count is published with
+// release semantics after each zone, so that a reader which acquires it sees
+// all zones up to that count - unless they have been overwritten in the
+// meantime, which the reader detects by checking the count again.
+struct ThreadBuffer
+{
+  explicit ThreadBuffer(const int threadId)
+    : mThreadId(threadId)
+  {
+  }
+
+  std::array<RecordedZone, ZONES_PER_THREAD> mZones;
+  std::atomic<std::uint64_t> mNumWritten{0};
+  std::atomic<const char*> mpName{nullptr};
+  int mThreadId;
+};
+
+
+struct Registry
+{
+  std::mutex mMutex;
+
+  // Buffers are never freed, since recorded zones need to stay available
+  // after a thread has exited.
+  std::vector<std::unique_ptr<ThreadBuffer>> mBuffers;
+
+  std::filesystem::path mOutputPath;
+  Clock::time_point mBaseTime = Clock::now();
+};
+
+
+Registry& registry()
+{
+  static Registry instance;
+  return instance;
+}
+
+
+ThreadBuffer& currentThreadBuffer()
+{
+  thread_local ThreadBuffer* tpBuffer = []() {
+    auto& reg = registry();
+    std::lock_guard lock{reg.mMutex};
+
+    const auto threadId = int(reg.mBuffers.size()) + 1;
+    reg.mBuffers.push_back(std::make_unique<ThreadBuffer>(threadId));
+    return reg.mBuffers.back().get();
+  }();
+
+  return *tpBuffer;
+}
+
+
+// Copy of the zones which were intact at the time of copying
+std::vector<RecordedZone> snapshotZones(const ThreadBuffer& buffer)
+{
+  const auto numWritten = buffer.mNumWritten.load(std::memory_order_acquire);
+  const auto first =
+    numWritten > ZONES_PER_THREAD ? numWritten - ZONES_PER_THREAD : 0;
+
+  auto zones = std::vector<RecordedZone>{};
+  zones.reserve(numWritten - first);
+  for (auto i = first; i < numWritten; ++i)
+  {
+    zones.push_back(buffer.mZones[i % ZONES_PER_THREAD]);
+  }
+
+  // The owning thread might have wrapped around while we were copying. Drop
+  // the zones whose slots could have been written to since.
+  std::atomic_thread_fence(std::memory_order_acquire);
+  const auto numWrittenAfter =
+    buffer.mNumWritten.load(std::memory_order_relaxed);
+  const auto firstIntact = numWrittenAfter > ZONES_PER_THREAD
+    ? numWrittenAfter - ZONES_PER_THREAD
+    : 0;
+  if (firstIntact > first)
+  {
+    const auto numOverwritten = std::min(firstIntact, numWritten) - first;
+    zones.erase(zones.begin(), zones.begin() + numOverwritten);
+  }
+
+  return zones;
+}
+
+
+double microsecondsSince(
+  const Clock::time_point baseTime,
+  const Clock::time_point time)
+{
+  return std::chrono::duration<double, std::micro>(time - baseTime).count();
+}
+
+
+void writeJsonString(std::ostream& stream, const char* text)
+{
+  stream << '"';
+  for (auto p = text; *p; ++p)
+  {
+    if (*p == '"' || *p == '\\')
+    {
+      stream << '\\';
+    }
+    stream << *p;
+  }
+  stream << '"';
+}
+
+} // namespace
+
+
+namespace detail
+{
+
+void recordZone(
+  const char* name,
+  const Clock::time_point startTime,
+  const Clock::time_point endTime)
+{
+  auto& buffer = currentThreadBuffer();
+  const auto index = buffer.mNumWritten.load(std::memory_order_relaxed);
+  buffer.mZones[index % ZONES_PER_THREAD] = {name, startTime, endTime};
+  buffer.mNumWritten.store(index + 1, std::memory_order_release);
+}
+
+} // namespace detail
+
+
+void enable(const std::filesystem::path& outputPath)
+{
+  {
+    auto& reg = registry();
+    std::lock_guard lock{reg.mMutex};
+    reg.mOutputPath = outputPath;
+  }
+
+  detail::gIsEnabled.store(true, std::memory_order_relaxed);
+}
+
+
+void disable()
+{
+  detail::gIsEnabled.store(false, std::memory_order_relaxed);
+}
+
+
+void setCurrentThreadName(const char* name)
+{
+  if (isEnabled())
+  {
+    currentThreadBuffer().mpName.store(name, std::memory_order_relaxed);
+  }
+}
+
+
+void writeTrace()
+{
+  auto& reg = registry();
+  std::lock_guard lock{reg.mMutex};
+
+  if (reg.mOutputPath.empty())
+  {
+    return;
+  }
+
+  std::ofstream file(reg.mOutputPath, std::ios::out | std::ios::trunc);
+  if (!file.is_open())
+  {
+    throw std::runtime_error("Cannot open trace file for writing");
+  }
+
+  file << "[\n";
+  file << std::fixed << std::setprecision(3);
+
+  auto isFirstEvent = true;
+  auto beginEvent = [&]() {
+    if (!isFirstEvent)
+    {
+      file << ",\n";
+    }
+    isFirstEvent = false;
+  };
+
+  for (const auto& pBuffer : reg.mBuffers)
+  {
+    if (const auto pName = pBuffer->mpName.load(std::memory_order_relaxed))
+    {
+      beginEvent();
+      file << R"({"name":"thread_name","ph":"M","pid":1,"tid":)"
+           << pBuffer->mThreadId << R"(,"args":{"name":)";
+      writeJsonString(file, pName);
+      file << "}}";
+    }
+
+    for (const auto& zone : snapshotZones(*pBuffer))
+    {
+      beginEvent();
+      file << R"({"name":)";
+      writeJsonString(file, zone.mName);
+      file << R"(,"ph":"X","pid":1,"tid":)" << pBuffer->mThreadId
+           << R"(,"ts":)" << microsecondsSince(reg.mBaseTime, zone.mStartTime)
+           << R"(,"dur":)"
+           << microsecondsSince(zone.mStartTime, zone.mEndTime) << '}';
+    }
+  }
+
+  file << "\n]\n";
+
+  if (!file)
+  {
+    throw std::runtime_error("Failed to write trace file");
+  }
+}
+
+} // namespace rigel::base::tracing
@@ -0,0 +1,120 @@
+/* Copyright (C) 2022, Nikolai Wuttke. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "base/clock.hpp"
+
+#include <atomic>
+#include <filesystem>
+
+
+/* Timeline tracing, for looking at where time goes within a frame
+ *
+ * Code marks interesting parts using scoped zones (see RIGEL_TRACE_ZONE()).
+ * While tracing is enabled, each zone is recorded into a buffer belonging to
+ * the thread it runs on. Recording doesn't take any locks, except the very
+ * first time a thread records a zone. Each thread's buffer holds the most
+ * recent zones only, older ones are overwritten.
+ *
+ * The recorded zones can be written out in Chrome's trace event format at
+ * any time, e.g. for viewing in Perfetto or chrome://tracing. Unlike the
+ * TickProfiler, this works on all threads, and keeps a timeline instead of
+ * aggregated numbers. When tracing is disabled, a zone costs a single
+ * branch.
+ */
+
+namespace rigel::base::tracing
+{
+
+namespace detail
+{
+
+extern std::atomic<bool> gIsEnabled;
+
+void recordZone(
+  const char* name,
+  Clock::time_point startTime,
+  Clock::time_point endTime);
+
+} // namespace detail
+
+
+/** Start recording, and set the file for writeTrace() */
+void enable(const std::filesystem::path& outputPath);
+
+void disable();
+
+inline bool isEnabled()
+{
+  return detail::gIsEnabled.load(std::memory_order_relaxed);
+}
+
+
+/** Name shown for the calling thread in the trace
+ *
+ * Does nothing if tracing isn't enabled.
+ */
+void setCurrentThreadName(const char* name);
+
+
+/** Write everything recorded so far to the file given to enable()
+ *
+ * Can be called while other threads keep recording. Zones which are
+ * overwritten during the write are left out. Does nothing if tracing was never
+ * enabled, throws std::runtime_error if the file can't be written.
+ */
+void writeTrace();
+
+
+/** Records the enclosing scope as a zone
+ *
+ * The name must be a string literal, or otherwise stay valid until the
+ * trace has been written.
+ */
+class Zone
+{
+public:
+  explicit Zone(const char* name)
+    : mName(isEnabled() ? name : nullptr)
+  {
+    if (mName)
+    {
+      mStartTime = Clock::now();
+    }
+  }
+
+  ~Zone()
+  {
+    if (mName)
+    {
+      detail::recordZone(mName, mStartTime, Clock::now());
+    }
+  }
+
+  Zone(const Zone&) = delete;
+  Zone& operator=(const Zone&) = delete;
+
+private:
+  const char* mName;
+  Clock::time_point mStartTime;
+};
+
+} // namespace rigel::base::tracing
+
+
+#define RIGEL_TRACE_ZONE(name)                                                 \
+  const ::rigel::base::tracing::Zone rigelTraceZone_(name)
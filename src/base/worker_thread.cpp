@@ -0,0 +1,108 @@
+/* Copyright (C) 2022, Nikolai Wuttke. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "worker_thread.hpp"
+
+#include <utility>
+
+
+namespace rigel::base
+{
+
+#if defined(__EMSCRIPTEN__) && !defined(__EMSCRIPTEN_PTHREADS__)
+
+WorkerThread::WorkerThread() = default;
+WorkerThread::~WorkerThread() = default;
+
+
+void WorkerThread::submit(Task task)
+{
+  task();
+}
+
+
+void WorkerThread::waitUntilIdle() { }
+
+#else
+
+WorkerThread::WorkerThread()
+  : mThread([this]() { run(); })
+{
+}
+
+
+WorkerThread::~WorkerThread()
+{
+  {
+    std::lock_guard lock{mMutex};
+    mStopRequested = true;
+  }
+
+  mTasksChanged.notify_all();
+  mThread.join();
+}
+
+
+void WorkerThread::submit(Task task)
+{
+  {
+    std::lock_guard lock{mMutex};
+    mTasks.push_back(std::move(task));
+  }
+
+  mTasksChanged.notify_all();
+}
+
+
+void WorkerThread::waitUntilIdle()
+{
+  std::unique_lock lock{mMutex};
+  mTasksChanged.wait(lock, [this]() { return mTasks.empty() && !mIsBusy; });
+}
+
+
+void WorkerThread::run()
+{
+  std::unique_lock lock{mMutex};
+
+  for (;;)
+  {
+    mTasksChanged.wait(
+      lock, [this]() { return !mTasks.empty() || mStopRequested; });
+
+    // Remaining tasks are still completed when stopping
+    if (mTasks.empty())
+    {
+      return;
+    }
+
+    auto task = std::move(mTasks.front());
+    mTasks.pop_front();
+    mIsBusy = true;
+
+    lock.unlock();
+    task();
+    lock.lock();
+
+    mIsBusy = false;
+    mTasksChanged.notify_all();
+  }
+}
+
+#endif
+
+} // namespace rigel::base
@@ -0,0 +1,71 @@
+/* Copyright (C) 2022, Nikolai Wuttke. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+
+namespace rigel::base
+{
+
+/** Runs tasks on a background thread, in submission order
+ *
+ * Meant for work that shouldn't block the main loop, like encoding and
+ * writing files. Tasks must not touch any state that is used by other
+ * threads without synchronization.
+ *
+ * On destruction, all tasks that have been submitted so far are completed
+ * before the thread is joined.
+ *
+ * On platforms without thread support (Emscripten without pthreads), tasks
+ * are executed immediately on the calling thread.
+ */
+class WorkerThread
+{
+public:
+  using Task = std::function<void()>;
+
+  WorkerThread();
+  ~WorkerThread();
+
+  WorkerThread(const WorkerThread&) = delete;
+  WorkerThread& operator=(const WorkerThread&) = delete;
+
+  void submit(Task task);
+
+  /** Block until all tasks submitted so far have completed */
+  void waitUntilIdle();
+
+private:
+#if !defined(__EMSCRIPTEN__) || defined(__EMSCRIPTEN_PTHREADS__)
+  void run();
+
+  std::deque<Task> mTasks;
+  std::mutex mMutex;
+  std::condition_variable mTasksChanged;
+  bool mIsBusy = false;
+  bool mStopRequested = false;
+  std::thread mThread;
+#endif
+};
+
+} // namespace rigel::base
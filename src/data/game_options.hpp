@@ -46,6 +46,10 @@ constexpr auto ENABLE_VSYNC_DEFAULT = true;
 constexpr auto MUSIC_VOLUME_DEFAULT = 1.0f;
 constexpr auto SOUND_VOLUME_DEFAULT = 1.0f;
 
+// Value for GameOptions::mMaxReplacementScale which limits replacement
+// images to the highest resolution that's visible on the current display
+constexpr auto MATCH_DISPLAY_REPLACEMENT_SCALE = -1;
+
 enum class WindowMode
 {
   Fullscreen,
@@ -128,9 +132,12 @@ struct GameOptions
   bool mEnableFpsLimit = true; // Only relevant when mEnableVsync == false
   int mMaxFps = 60; // Only relevant when mEnableFpsLimit == true
   bool mShowFpsCounter = false;
+  bool mIdlePowerSaving = true;
   bool mEnableScreenFlashes = true;
   UpscalingFilter mUpscalingFilter = UpscalingFilter::None;
   bool mAspectRatioCorrectionEnabled = true;
+  bool mDynamicResolutionEnabled = true;
+  bool mReduceEffectsUnderLoad = true;
 
   // Sound
   float mMusicVolume = MUSIC_VOLUME_DEFAULT;
@@ -139,6 +146,9 @@ struct GameOptions
   bool mSoundOn = true;
   SoundStyle mSoundStyle = SoundStyle::SoundBlaster;
   AdlibPlaybackType mAdlibPlaybackType = AdlibPlaybackType::DBOPL;
+  bool mLowLatencyAudio = false;
+  bool mPrerenderMusic = false;
+  bool mShowAudioStats = false;
 
   // Keyboard controls
   SDL_Keycode mUpKeybinding = SDLK_UP;
@@ -153,6 +163,12 @@ struct GameOptions
   // Modding
   bool mEnableTopLevelMods = true;
 
+  // Highest allowed resolution of replacement images, as a multiple of the
+  // original resolution. Larger replacements are scaled down when loading.
+  // 0 means no limit, MATCH_DISPLAY_REPLACEMENT_SCALE derives the limit from
+  // the display resolution.
+  int mMaxReplacementScale = 0;
+
   // Gameplay
   GameplayStyle mGameplayStyle = GameplayStyle::Enhanced;
 
@@ -19,7 +19,9 @@
 #include "data/game_traits.hpp"
 
 #include <algorithm>
+#include <atomic>
 #include <cassert>
+#include <cstring>
 #include <stdexcept>
 #include <utility>
 
@@ -30,19 +32,229 @@ namespace rigel::data::map
 using namespace std;
 
 
+namespace
+{
+
+constexpr auto BITS_PER_WORD = 64;
+
+
+uint32_t nextRevision()
+{
+  static atomic<uint32_t> lastRevision{0};
+  return ++lastRevision;
+}
+
+
+// The content hash is the XOR of this value for all tiles, so that changing
+// a tile only requires removing its old contribution and adding the new one.
+// Empty tiles don't contribute anything, which makes the hash of an empty
+// map 0.
+uint32_t tileHash(
+  const int layer,
+  const int x,
+  const int y,
+  const TileIndex index)
+{
+  if (index == 0)
+  {
+    return 0;
+  }
+
+  auto value = (uint64_t(index) << 32) | (uint64_t(layer) << 31) |
+    (uint64_t(uint16_t(y)) << 16) | uint64_t(uint16_t(x));
+
+  // 64-bit finalizer from MurmurHash3
+  value ^= value >> 33;
+  value *= 0xff51afd7ed558ccdull;
+  value ^= value >> 33;
+  value *= 0xc4ceb9fe1a85ec53ull;
+  value ^= value >> 33;
+  return uint32_t(value);
+}
+
+
+size_t wordsNeededFor(const size_t numBits)
+{
+  return (numBits + BITS_PER_WORD - 1) / BITS_PER_WORD;
+}
+
+
+// Solid edge bitmaps are indexed by the bit position of the corresponding
+// flag in a collision data bit pack, see SolidEdge.
+const array<SolidEdge, 4> SOLID_EDGES{
+  SolidEdge::top(),
+  SolidEdge::bottom(),
+  SolidEdge::right(),
+  SolidEdge::left()};
+
+
+CollisionData solidEdgeFlag(const int edgeIndex)
+{
+  return CollisionData{static_cast<uint8_t>(1u << edgeIndex)};
+}
+
+
+void setBit(vector<uint64_t>& words, const size_t index, const bool value)
+{
+  const auto mask = uint64_t{1} << (index % BITS_PER_WORD);
+  auto& word = words[index / BITS_PER_WORD];
+  word = value ? word | mask : word & ~mask;
+}
+
+
+bool anyBitSet(const uint64_t* pWords, const size_t first, const size_t last)
+{
+  const auto firstWord = first / BITS_PER_WORD;
+  const auto lastWord = last / BITS_PER_WORD;
+
+  for (auto i = firstWord; i <= lastWord; ++i)
+  {
+    auto word = pWords[i];
+    if (i == firstWord)
+    {
+      word &= ~uint64_t{0} << (first % BITS_PER_WORD);
+    }
+    if (i == lastWord)
+    {
+      word &= ~uint64_t{0} >> (BITS_PER_WORD - 1 - last % BITS_PER_WORD);
+    }
+
+    if (word != 0)
+    {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+
+int lowestSetBit(const uint64_t word)
+{
+  assert(word != 0);
+#if defined(__GNUC__) || defined(__clang__)
+  return __builtin_ctzll(word);
+#else
+  auto index = 0;
+  while (((word >> index) & 1) == 0)
+  {
+    ++index;
+  }
+  return index;
+#endif
+}
+
+
+int highestSetBit(const uint64_t word)
+{
+  assert(word != 0);
+#if defined(__GNUC__) || defined(__clang__)
+  return BITS_PER_WORD - 1 - __builtin_clzll(word);
+#else
+  auto index = BITS_PER_WORD - 1;
+  while (((word >> index) & 1) == 0)
+  {
+    --index;
+  }
+  return index;
+#endif
+}
+
+
+// Returns the index of the first bit in [from, to] (or [to, from], scanning
+// downwards) which is set in any of the words returned by wordAt().
+template <typename WordFunc>
+optional<int> findSetBit(WordFunc&& wordAt, const int from, const int to)
+{
+  const auto firstWord = from / BITS_PER_WORD;
+  const auto lastWord = to / BITS_PER_WORD;
+
+  if (from <= to)
+  {
+    for (auto i = firstWord; i <= lastWord; ++i)
+    {
+      auto word = wordAt(i);
+      if (i == firstWord)
+      {
+        word &= ~uint64_t{0} << (from % BITS_PER_WORD);
+      }
+      if (i == lastWord)
+      {
+        word &= ~uint64_t{0} >> (BITS_PER_WORD - 1 - to % BITS_PER_WORD);
+      }
+
+      if (word != 0)
+      {
+        return i * BITS_PER_WORD + lowestSetBit(word);
+      }
+    }
+  }
+  else
+  {
+    for (auto i = firstWord; i >= lastWord; --i)
+    {
+      auto word = wordAt(i);
+      if (i == firstWord)
+      {
+        word &= ~uint64_t{0} >> (BITS_PER_WORD - 1 - from % BITS_PER_WORD);
+      }
+      if (i == lastWord)
+      {
+        word &= ~uint64_t{0} << (to % BITS_PER_WORD);
+      }
+
+      if (word != 0)
+      {
+        return i * BITS_PER_WORD + highestSetBit(word);
+      }
+    }
+  }
+
+  return nullopt;
+}
+
+} // namespace
+
+
 Map::Map(
   const int widthInTiles,
   const int heightInTiles,
   TileAttributeDict attributes)
-  : mLayers(
-      {TileArray(widthInTiles * heightInTiles, 0),
-       TileArray(widthInTiles * heightInTiles, 0)})
+  : mTiles(widthInTiles * heightInTiles, TilePair{})
+  , mCollisionData(widthInTiles * heightInTiles)
+  , mWordsPerRow(wordsNeededFor(static_cast<size_t>(widthInTiles)))
+  , mWordsPerColumn(wordsNeededFor(static_cast<size_t>(heightInTiles)))
   , mWidthInTiles(static_cast<size_t>(widthInTiles))
   , mHeightInTiles(static_cast<size_t>(heightInTiles))
   , mAttributes(std::move(attributes))
 {
   assert(widthInTiles >= 0);
   assert(heightInTiles >= 0);
+
+  for (auto& rows : mSolidEdgeRows)
+  {
+    rows.resize(mWordsPerRow * mHeightInTiles);
+  }
+
+  for (auto& columns : mSolidEdgeColumns)
+  {
+    columns.resize(mWordsPerColumn * mWidthInTiles);
+  }
+
+  mConveyorBeltLeftRows.resize(mWordsPerRow * mHeightInTiles);
+  mConveyorBeltRightRows.resize(mWordsPerRow * mHeightInTiles);
+  mCompositeTileRows.resize(mWordsPerRow * mHeightInTiles);
+  mCompositeTileColumns.resize(mWordsPerColumn * mWidthInTiles);
+
+  for (auto y = 0; y < heightInTiles; ++y)
+  {
+    for (auto x = 0; x < widthInTiles; ++x)
+    {
+      updateCollisionData(x, y);
+    }
+  }
+
+  mRevision = nextRevision();
 }
 
 
@@ -58,7 +270,11 @@ void Map::setTileAt(const int layer, const int x, const int y, TileIndex index)
   {
     throw invalid_argument("Tile index too large for tile set");
   }
-  tileRefAt(layer, x, y) = index;
+  auto& tile = tileRefAt(layer, x, y);
+  mContentHash ^= tileHash(layer, x, y, tile) ^ tileHash(layer, x, y, index);
+  tile = index;
+  updateCollisionData(x, y);
+  mRevision = nextRevision();
 }
 
 
@@ -68,14 +284,65 @@ void Map::clearSection(
   const int width,
   const int height)
 {
+  const auto section = base::Rect<int>{{x, y}, {width, height}};
+  checkSection(section);
+
+  if (section.size.width <= 0 || section.size.height <= 0)
+  {
+    return;
+  }
+
+  toggleContentHash(section);
+
   for (auto row = y; row < y + height; ++row)
   {
-    for (auto col = x; col < x + width; ++col)
-    {
-      setTileAt(0, col, row, 0);
-      setTileAt(1, col, row, 0);
-    }
+    const auto iRowStart = mTiles.begin() + rowStart(x, row);
+    std::fill(iRowStart, iRowStart + width, TilePair{});
   }
+
+  updateCollisionData(section);
+  mRevision = nextRevision();
+}
+
+
+void Map::moveSection(
+  const base::Rect<int>& section,
+  const base::Vec2& destination)
+{
+  const auto destinationSection = base::Rect<int>{destination, section.size};
+  checkSection(section);
+  checkSection(destinationSection);
+
+  if (section.size.width <= 0 || section.size.height <= 0)
+  {
+    return;
+  }
+
+  // The content hash is a XOR of all tiles, so toggling before and after
+  // the move replaces the destination's previous contents with the new ones
+  toggleContentHash(destinationSection);
+
+  const auto width = section.size.width;
+  const auto height = section.size.height;
+  const auto rowBytes = sizeof(TilePair) * width;
+
+  // When moving down, rows need to be processed bottom-up in order to not
+  // overwrite source rows before they have been copied. Overlap within a
+  // row is handled by memmove.
+  const auto movingDown = destination.y > section.topLeft.y;
+
+  for (auto i = 0; i < height; ++i)
+  {
+    const auto row = movingDown ? height - i - 1 : i;
+    std::memmove(
+      &mTiles[rowStart(destination.x, destination.y + row)],
+      &mTiles[rowStart(section.topLeft.x, section.topLeft.y + row)],
+      rowBytes);
+  }
+
+  toggleContentHash(destinationSection);
+  updateCollisionData(destinationSection);
+  mRevision = nextRevision();
 }
 
 
@@ -95,19 +362,20 @@ TileAttributes Map::attributes(const int x, const int y) const
     return TileAttributes{};
   }
 
-  if (tileAt(0, x, y) != 0 && tileAt(1, x, y) != 0)
+  const auto& tiles = mTiles[rowStart(x, y)];
+  if (tiles[0] != 0 && tiles[1] != 0)
   {
     // "Composite" tiles (content on both layers) are ignored for attribute
     // checking
     return TileAttributes{};
   }
 
-  if (tileAt(1, x, y) != 0)
+  if (tiles[1] != 0)
   {
-    return TileAttributes{mAttributes.attributes(tileAt(1, x, y))};
+    return TileAttributes{mAttributes.attributes(tiles[1])};
   }
 
-  return TileAttributes{mAttributes.attributes(tileAt(0, x, y))};
+  return TileAttributes{mAttributes.attributes(tiles[0])};
 }
 
 
@@ -125,19 +393,299 @@ CollisionData Map::collisionData(const int x, const int y) const
     return CollisionData{};
   }
 
-  if (tileAt(0, x, y) != 0 && tileAt(1, x, y) != 0)
+  return mCollisionData[rowStart(x, y)];
+}
+
+
+bool Map::hasSolidEdgeInRow(
+  const int startX,
+  const int endX,
+  const int y,
+  const SolidEdge edge) const
+{
+  if (startX > endX)
+  {
+    return false;
+  }
+
+  if (startX < 0 || static_cast<size_t>(endX) >= mWidthInTiles)
+  {
+    // Left/right edge of the map are always solid
+    return true;
+  }
+
+  if (static_cast<size_t>(y) >= mHeightInTiles)
+  {
+    return false;
+  }
+
+  const auto rowStart = static_cast<size_t>(y) * mWordsPerRow;
+  for (auto i = 0; i < NUM_SOLID_EDGES; ++i)
+  {
+    if (
+      solidEdgeFlag(i).isSolidOn(edge) &&
+      anyBitSet(&mSolidEdgeRows[i][rowStart], startX, endX))
+    {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+
+bool Map::hasSolidEdgeInColumn(
+  const int startY,
+  const int endY,
+  const int x,
+  const SolidEdge edge) const
+{
+  if (startY > endY)
+  {
+    return false;
+  }
+
+  if (static_cast<size_t>(x) >= mWidthInTiles)
+  {
+    // Left/right edge of the map are always solid
+    return true;
+  }
+
+  // Bottom/top edge of the map are never solid, so we only need to look at
+  // the part of the span that's inside the map
+  const auto firstY = std::max(startY, 0);
+  const auto lastY = std::min(endY, static_cast<int>(mHeightInTiles) - 1);
+  if (firstY > lastY)
+  {
+    return false;
+  }
+
+  const auto columnStart = static_cast<size_t>(x) * mWordsPerColumn;
+  for (auto i = 0; i < NUM_SOLID_EDGES; ++i)
+  {
+    if (
+      solidEdgeFlag(i).isSolidOn(edge) &&
+      anyBitSet(&mSolidEdgeColumns[i][columnStart], firstY, lastY))
+    {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+
+int Map::conveyorBeltDirectionInRow(
+  const int startX,
+  const int endX,
+  const int y) const
+{
+  const auto firstX = std::max(startX, 0);
+  const auto lastX = std::min(endX, width() - 1);
+
+  if (firstX > lastX || static_cast<size_t>(y) >= mHeightInTiles)
+  {
+    return 0;
+  }
+
+  const auto rowStart = static_cast<size_t>(y) * mWordsPerRow;
+  if (anyBitSet(&mConveyorBeltLeftRows[rowStart], firstX, lastX))
+  {
+    return -1;
+  }
+
+  if (anyBitSet(&mConveyorBeltRightRows[rowStart], firstX, lastX))
+  {
+    return 1;
+  }
+
+  return 0;
+}
+
+
+bool Map::hasCompositeTileInRow(
+  const int startX,
+  const int endX,
+  const int y) const
+{
+  const auto firstX = std::max(startX, 0);
+  const auto lastX = std::min(endX, width() - 1);
+
+  if (firstX > lastX || static_cast<size_t>(y) >= mHeightInTiles)
+  {
+    return false;
+  }
+
+  const auto rowStart = static_cast<size_t>(y) * mWordsPerRow;
+  return anyBitSet(&mCompositeTileRows[rowStart], firstX, lastX);
+}
+
+
+bool Map::hasCompositeTileInColumn(
+  const int startY,
+  const int endY,
+  const int x) const
+{
+  const auto firstY = std::max(startY, 0);
+  const auto lastY = std::min(endY, height() - 1);
+
+  if (firstY > lastY || static_cast<size_t>(x) >= mWidthInTiles)
+  {
+    return false;
+  }
+
+  const auto columnStart = static_cast<size_t>(x) * mWordsPerColumn;
+  return anyBitSet(&mCompositeTileColumns[columnStart], firstY, lastY);
+}
+
+
+optional<int> Map::findSolidEdgeInRow(
+  const int fromX,
+  const int toX,
+  const int y,
+  const SolidEdge edge) const
+{
+  assert(fromX >= 0 && fromX < width() && toX >= 0 && toX < width());
+  assert(y >= 0 && y < height());
+
+  const auto rowStart = static_cast<size_t>(y) * mWordsPerRow;
+  return findSetBit(
+    [&](const int wordIndex) {
+      auto word = uint64_t{0};
+      for (auto i = 0; i < NUM_SOLID_EDGES; ++i)
+      {
+        if (solidEdgeFlag(i).isSolidOn(edge))
+        {
+          word |= mSolidEdgeRows[i][rowStart + wordIndex];
+        }
+      }
+      return word;
+    },
+    fromX,
+    toX);
+}
+
+
+optional<int> Map::findSolidEdgeInColumn(
+  const int fromY,
+  const int toY,
+  const int x,
+  const SolidEdge edge) const
+{
+  assert(fromY >= 0 && fromY < height() && toY >= 0 && toY < height());
+  assert(x >= 0 && x < width());
+
+  const auto columnStart = static_cast<size_t>(x) * mWordsPerColumn;
+  return findSetBit(
+    [&](const int wordIndex) {
+      auto word = uint64_t{0};
+      for (auto i = 0; i < NUM_SOLID_EDGES; ++i)
+      {
+        if (solidEdgeFlag(i).isSolidOn(edge))
+        {
+          word |= mSolidEdgeColumns[i][columnStart + wordIndex];
+        }
+      }
+      return word;
+    },
+    fromY,
+    toY);
+}
+
+
+CollisionData Map::computeCollisionData(const int x, const int y) const
+{
+  const auto& tiles = mTiles[rowStart(x, y)];
+  if (tiles[0] != 0 && tiles[1] != 0)
   {
     // "Composite" tiles (content on both layers) are ignored for collision
     // checking
     return CollisionData{};
   }
 
-  const auto data1 = mAttributes.collisionData(tileAt(0, x, y));
-  const auto data2 = mAttributes.collisionData(tileAt(1, x, y));
+  const auto data1 = mAttributes.collisionData(tiles[0]);
+  const auto data2 = mAttributes.collisionData(tiles[1]);
   return CollisionData{data1, data2};
 }
 
 
+void Map::updateCollisionData(const int x, const int y)
+{
+  const auto data = computeCollisionData(x, y);
+  mCollisionData[rowStart(x, y)] = data;
+
+  const auto rowIndex = y * mWordsPerRow * BITS_PER_WORD + x;
+  const auto columnIndex = x * mWordsPerColumn * BITS_PER_WORD + y;
+
+  for (auto i = 0; i < NUM_SOLID_EDGES; ++i)
+  {
+    const auto isSolid = data.isSolidOn(SOLID_EDGES[i]);
+    setBit(mSolidEdgeRows[i], rowIndex, isSolid);
+    setBit(mSolidEdgeColumns[i], columnIndex, isSolid);
+  }
+
+  const auto tileAttributes = attributes(x, y);
+  setBit(
+    mConveyorBeltLeftRows, rowIndex, tileAttributes.isConveyorBeltLeft());
+  setBit(
+    mConveyorBeltRightRows, rowIndex, tileAttributes.isConveyorBeltRight());
+
+  const auto& tiles = mTiles[rowStart(x, y)];
+  const auto isComposite = tiles[0] != 0 && tiles[1] != 0;
+  setBit(mCompositeTileRows, rowIndex, isComposite);
+  setBit(mCompositeTileColumns, columnIndex, isComposite);
+}
+
+
+void Map::updateCollisionData(const base::Rect<int>& section)
+{
+  for (auto y = section.top(); y <= section.bottom(); ++y)
+  {
+    for (auto x = section.left(); x <= section.right(); ++x)
+    {
+      updateCollisionData(x, y);
+    }
+  }
+}
+
+
+void Map::toggleContentHash(const base::Rect<int>& section)
+{
+  for (auto y = section.top(); y <= section.bottom(); ++y)
+  {
+    const auto pRow = &mTiles[rowStart(section.left(), y)];
+    for (auto i = 0; i < section.size.width; ++i)
+    {
+      const auto x = section.left() + i;
+      mContentHash ^=
+        tileHash(0, x, y, pRow[i][0]) ^ tileHash(1, x, y, pRow[i][1]);
+    }
+  }
+}
+
+
+void Map::checkSection(const base::Rect<int>& section) const
+{
+  if (section.size.width <= 0 || section.size.height <= 0)
+  {
+    return;
+  }
+
+  if (
+    section.left() < 0 || section.right() >= width() || section.top() < 0 ||
+    section.bottom() >= height())
+  {
+    throw invalid_argument("Section out of bounds");
+  }
+}
+
+
+size_t Map::rowStart(const int x, const int y) const
+{
+  return size_t(x) + size_t(y) * mWidthInTiles;
+}
+
+
 const map::TileIndex&
   Map::tileRefAt(const int layerS, const int xS, const int yS) const
 {
@@ -145,7 +693,7 @@ const map::TileIndex&
   const auto x = static_cast<size_t>(xS);
   const auto y = static_cast<size_t>(yS);
 
-  if (layer >= mLayers.size())
+  if (layer >= std::tuple_size_v<TilePair>)
   {
     throw invalid_argument("Layer index out of bounds");
   }
@@ -157,7 +705,7 @@ const map::TileIndex&
   {
     throw invalid_argument("Y coord out of bounds");
   }
-  return mLayers[layer][x + y * mWidthInTiles];
+  return mTiles[x + y * mWidthInTiles][layer];
 }
 
 
@@ -22,6 +22,7 @@
 
 #include <array>
 #include <cstddef>
+#include <cstdint>
 #include <optional>
 #include <string>
 #include <vector>
@@ -64,21 +65,139 @@ public:
 
   void clearSection(int x, int y, int width, int height);
 
+  /** Move a rectangular section of tiles, in both layers
+   *
+   * Copies the tiles in the given section to the section of the same size
+   * whose top-left corner is at destination. Source and destination may
+   * overlap. Tiles in the source section which aren't covered by the
+   * destination section are left as they are. Equivalent to a series of
+   * setTileAt() calls, but works a whole row at a time and updates the
+   * map's revision only once.
+   */
+  void
+    moveSection(const base::Rect<int>& section, const base::Vec2& destination);
+
+  /** Changes on every change to the map's tiles
+   *
+   * Revisions are unique across all map instances, except that copies of a
+   * map share its revision. Two maps with the same revision thus have
+   * identical contents.
+   */
+  std::uint32_t revision() const { return mRevision; }
+
+  /** Hash of all tiles in both layers
+   *
+   * Unlike revision(), this only depends on the map's contents, so it's
+   * identical across runs of the game. It's maintained incrementally by
+   * setTileAt().
+   */
+  std::uint32_t contentHash() const { return mContentHash; }
+
   const TileAttributeDict& attributeDict() const;
   TileAttributes attributes(int x, int y) const;
 
   CollisionData collisionData(int x, int y) const;
 
+  /** Test if any tile in the given row span is solid on the given edge
+   *
+   * Equivalent to testing collisionData(x, y).isSolidOn(edge) for each x
+   * in [startX, endX], but works on whole words of a precomputed bitmap
+   * instead of looking at individual tiles.
+   */
+  bool hasSolidEdgeInRow(int startX, int endX, int y, SolidEdge edge) const;
+
+  /** Test if any tile in the given column span is solid on the given edge
+   *
+   * Column equivalent of hasSolidEdgeInRow().
+   */
+  bool
+    hasSolidEdgeInColumn(int startY, int endY, int x, SolidEdge edge) const;
+
+  /** Direction of conveyor belts in the given row span
+   *
+   * Returns -1 if any tile in [startX, endX] in row y is a left-moving
+   * conveyor belt according to attributes(), otherwise 1 if any is a
+   * right-moving one, and 0 if there's none. Works on precomputed
+   * bitmaps, like hasSolidEdgeInRow(). Parts of the span outside of the
+   * map are ignored.
+   */
+  int conveyorBeltDirectionInRow(int startX, int endX, int y) const;
+
+  /** Test if any tile in the given row span is a "composite" tile
+   *
+   * Composite tiles have content on both layers. Works on precomputed
+   * bitmaps, like hasSolidEdgeInRow(). Parts of the span outside of the
+   * map are ignored.
+   */
+  bool hasCompositeTileInRow(int startX, int endX, int y) const;
+
+  /** Column equivalent of hasCompositeTileInRow() */
+  bool hasCompositeTileInColumn(int startY, int endY, int x) const;
+
+  /** Find the first tile in a row span that's solid on the given edge
+   *
+   * Looks at the tiles in row y from fromX to toX (inclusive), going left if
+   * toX is smaller than fromX, and returns the x coordinate of the first one
+   * whose collisionData() is solid on the edge. Unlike hasSolidEdgeInRow(),
+   * this doesn't handle coordinates outside of the map.
+   */
+  std::optional<int>
+    findSolidEdgeInRow(int fromX, int toX, int y, SolidEdge edge) const;
+
+  /** Column equivalent of findSolidEdgeInRow() */
+  std::optional<int>
+    findSolidEdgeInColumn(int fromY, int toY, int x, SolidEdge edge) const;
+
 private:
   const TileIndex& tileRefAt(int layer, int x, int y) const;
   TileIndex& tileRefAt(int layer, int x, int y);
 
-private:
-  using TileArray = std::vector<TileIndex>;
-  std::array<TileArray, 2> mLayers;
+  CollisionData computeCollisionData(int x, int y) const;
+  void updateCollisionData(int x, int y);
+  void updateCollisionData(const base::Rect<int>& section);
+  void toggleContentHash(const base::Rect<int>& section);
+  void checkSection(const base::Rect<int>& section) const;
+  std::size_t rowStart(int x, int y) const;
 
-  std::size_t mWidthInTiles;
-  std::size_t mHeightInTiles;
+private:
+  static constexpr auto NUM_SOLID_EDGES = 4;
+
+  // Both layers' tiles are stored interleaved, so that looking at both
+  // layers of a tile (which most queries do) only touches a single cache
+  // line.
+  using TilePair = std::array<TileIndex, 2>;
+  using BitArray = std::vector<std::uint64_t>;
+  std::vector<TilePair> mTiles;
+
+  // The combined collision data of both layers for each tile, i.e. the
+  // result of collisionData() for all positions inside the map. Kept up to
+  // date by all functions modifying tiles.
+  std::vector<CollisionData> mCollisionData;
+
+  // One bit per tile for each solid edge, telling whether that tile's
+  // collisionData() is solid on the edge. Stored both row by row and
+  // column by column, so that span tests along either axis can work on
+  // consecutive bits.
+  std::array<BitArray, NUM_SOLID_EDGES> mSolidEdgeRows;
+  std::array<BitArray, NUM_SOLID_EDGES> mSolidEdgeColumns;
+  std::size_t mWordsPerRow = 0;
+  std::size_t mWordsPerColumn = 0;
+
+  // One bit per tile telling whether it's a left/right-moving conveyor
+  // belt, row by row. Kept up to date along with the collision data, since
+  // tiles can change during gameplay.
+  BitArray mConveyorBeltLeftRows;
+  BitArray mConveyorBeltRightRows;
+
+  // One bit per tile telling whether it's a composite tile, row by row and
+  // column by column
+  BitArray mCompositeTileRows;
+  BitArray mCompositeTileColumns;
+
+  std::size_t mWidthInTiles = 0;
+  std::size_t mHeightInTiles = 0;
+  std::uint32_t mRevision = 0;
+  std::uint32_t mContentHash = 0;
 
   TileAttributeDict mAttributes;
 };
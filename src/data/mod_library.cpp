@@ -55,16 +55,47 @@ bool isNonEmptyDirectory(const std::filesystem::directory_entry& entry)
   return !err && begin(iContents) != end(iContents);
 }
 
+
+bool isUpToDate(
+  const ModDirectoryIndex& index,
+  const std::filesystem::path& modsPath)
+{
+  namespace fs = std::filesystem;
+
+  if (index.mModsPath != modsPath)
+  {
+    return false;
+  }
+
+  std::error_code err;
+  if (fs::last_write_time(modsPath, err) != index.mWriteTime || err)
+  {
+    return false;
+  }
+
+  return std::all_of(
+    index.mEntries.begin(),
+    index.mEntries.end(),
+    [&](const ModDirectoryIndex::Entry& entry) {
+      std::error_code entryErr;
+      const auto writeTime =
+        fs::last_write_time(modsPath / fs::u8path(entry.mDirName), entryErr);
+      return !entryErr && writeTime == entry.mWriteTime;
+    });
+}
+
 } // namespace
 
 
 ModLibrary::ModLibrary(
   std::filesystem::path gamePath,
   std::vector<std::string> availableMods,
-  std::vector<ModStatus> initialSelection)
+  std::vector<ModStatus> initialSelection,
+  std::optional<ModDirectoryIndex> directoryIndex)
   : mAvailableMods(std::move(availableMods))
   , mModSelection(std::move(initialSelection))
   , mGamePath(std::move(gamePath))
+  , moDirectoryIndex(std::move(directoryIndex))
 {
   assert(availableMods.size() == initialSelection.size());
 }
@@ -77,11 +108,26 @@ void ModLibrary::updateGamePath(std::filesystem::path gamePath)
 
   if (pathHasChanged)
   {
-    rescan();
+    rescanIfChanged();
   }
 }
 
 
+bool ModLibrary::rescanIfChanged()
+{
+  if (
+    moDirectoryIndex &&
+    isUpToDate(*moDirectoryIndex, mGamePath / MODS_PATH))
+  {
+    LOG_F(INFO, "Mods directory unchanged, skipping rescan");
+    return false;
+  }
+
+  rescan();
+  return true;
+}
+
+
 void ModLibrary::rescan()
 {
   namespace fs = std::filesystem;
@@ -93,20 +139,43 @@ void ModLibrary::rescan()
   LOG_F(INFO, "Listing mod directories");
   auto newAvailableMods = std::vector<std::string>{};
 
+  // The index records every sub-directory, including empty ones, since those
+  // become mods once files are added to them. The timestamp of the mods
+  // directory is taken before listing it, so that changes made while the scan
+  // is running are picked up by the next one.
+  const auto modsPath = mGamePath / MODS_PATH;
+  auto newIndex = ModDirectoryIndex{modsPath, {}, {}};
+
   std::error_code err;
+  newIndex.mWriteTime = fs::last_write_time(modsPath, err);
+  const auto indexIsValid = !err;
+
   auto iModsDir = fs::directory_iterator{
-    mGamePath / MODS_PATH, fs::directory_options::skip_permission_denied, err};
+    modsPath, fs::directory_options::skip_permission_denied, err};
   if (!err)
   {
     for (const auto& entry : iModsDir)
     {
+      auto dirName = entry.path().filename().u8string();
+
+      std::error_code entryErr;
+      if (entry.is_directory(entryErr) && !entryErr)
+      {
+        newIndex.mEntries.push_back(
+          {dirName, entry.last_write_time(entryErr)});
+      }
+
       if (isNonEmptyDirectory(entry))
       {
-        newAvailableMods.push_back(entry.path().filename().u8string());
+        newAvailableMods.push_back(std::move(dirName));
       }
     }
   }
 
+  moDirectoryIndex = indexIsValid && !err
+    ? std::optional<ModDirectoryIndex>{std::move(newIndex)}
+    : std::nullopt;
+
   LOG_F(INFO, "Found %d mods", int(newAvailableMods.size()));
 
   // No prior selection - create default selection and early out
@@ -249,6 +318,12 @@ std::vector<std::filesystem::path> ModLibrary::enabledModPaths() const
 }
 
 
+const std::optional<ModDirectoryIndex>& ModLibrary::directoryIndex() const
+{
+  return moDirectoryIndex;
+}
+
+
 const std::string& ModLibrary::modDirName(const int index) const
 {
   return mAvailableMods[index];
@@ -17,6 +17,7 @@
 #pragma once
 
 #include <filesystem>
+#include <optional>
 #include <string>
 #include <tuple>
 #include <vector>
@@ -47,6 +48,28 @@ struct ModStatus
 };
 
 
+/** Snapshot of the mods directory as seen by the last full scan
+ *
+ * Records the modification time of the mods directory itself and of each of
+ * its sub-directories. Adding, removing or renaming a mod changes the former,
+ * populating a previously empty directory (or emptying one) changes the
+ * latter, so comparing these timestamps is sufficient to tell whether a
+ * rescan would produce a different list of available mods.
+ */
+struct ModDirectoryIndex
+{
+  struct Entry
+  {
+    std::string mDirName;
+    std::filesystem::file_time_type mWriteTime;
+  };
+
+  std::filesystem::path mModsPath;
+  std::filesystem::file_time_type mWriteTime;
+  std::vector<Entry> mEntries;
+};
+
+
 class ModLibrary
 {
 public:
@@ -54,11 +77,20 @@ public:
   ModLibrary(
     std::filesystem::path gamePath,
     std::vector<std::string> availableMods,
-    std::vector<ModStatus> initialSelection);
+    std::vector<ModStatus> initialSelection,
+    std::optional<ModDirectoryIndex> directoryIndex = std::nullopt);
 
   void updateGamePath(std::filesystem::path gamePath);
   void rescan();
 
+  /** Rescan only if the mods directory has changed since the last scan
+   *
+   * Returns true if a rescan was performed.
+   */
+  bool rescanIfChanged();
+
+  [[nodiscard]] const std::optional<ModDirectoryIndex>& directoryIndex() const;
+
   [[nodiscard]] std::vector<std::filesystem::path> enabledModPaths() const;
   [[nodiscard]] const std::string& modDirName(int index) const;
 
@@ -73,6 +105,7 @@ private:
   std::vector<std::string> mAvailableMods;
   std::vector<ModStatus> mModSelection;
   std::filesystem::path mGamePath;
+  std::optional<ModDirectoryIndex> moDirectoryIndex;
   bool mHasChanged = false;
 };
 
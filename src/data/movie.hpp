@@ -24,16 +24,23 @@
 namespace rigel::data
 {
 
+/** A single animation frame, stored as a delta to the previous frame
+ *
+ * The replacement image covers only the area changed by the frame, and is
+ * to be drawn at mPosition. Transparent pixels within the replacement image
+ * keep the previous frame's content. An empty replacement image means that
+ * the frame doesn't change anything.
+ */
 struct MovieFrame
 {
-  MovieFrame(Image&& replacementImage, const int startRow)
+  MovieFrame(Image&& replacementImage, const base::Vec2& position)
     : mReplacementImage(std::move(replacementImage))
-    , mStartRow(startRow)
+    , mPosition(position)
   {
   }
 
   Image mReplacementImage;
-  int mStartRow;
+  base::Vec2 mPosition;
 };
 
 
@@ -24,7 +24,7 @@
 namespace rigel::data
 {
 
-using Palette16 = std::array<data::Pixel, 16>;
+// Palette16 is defined in base/image.hpp, since IndexedImage needs it.
 
 using Palette256 = std::array<data::Pixel, 256>;
 
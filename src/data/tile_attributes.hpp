@@ -19,6 +19,7 @@
 #include "base/image.hpp"
 
 #include <cstddef>
+#include <cstdint>
 #include <vector>
 
 
@@ -68,26 +69,58 @@ private:
 };
 
 
+enum class TileAnimationType : std::uint8_t
+{
+  None = 0,
+  Slow = 1,
+  Fast = 2
+};
+
+
+/** Decoded attributes of a single tile
+ *
+ * The attribute bit pack found in the game's tileset files is translated into
+ * a packed representation once on construction, so that each query is a
+ * single bit test. The collision flags occupy the lowest 4 bits in both
+ * representations.
+ */
 class TileAttributes
 {
 public:
-  TileAttributes() = default;
-  explicit TileAttributes(std::uint16_t attributesBitPack);
-
-  bool isAnimated() const;
-  bool isFastAnimation() const;
-  bool isForeGround() const;
-  bool isLadder() const;
-  bool isClimbable() const;
-  bool isConveyorBeltLeft() const;
-  bool isConveyorBeltRight() const;
-  bool isFlammable() const;
+  constexpr TileAttributes() = default;
+  constexpr explicit TileAttributes(std::uint16_t attributesBitPack);
+
+  constexpr bool isAnimated() const;
+  constexpr bool isFastAnimation() const;
+  constexpr TileAnimationType animationType() const;
+  constexpr bool isForeGround() const;
+  constexpr bool isLadder() const;
+  constexpr bool isClimbable() const;
+  constexpr bool isConveyorBeltLeft() const;
+  constexpr bool isConveyorBeltRight() const;
+  constexpr bool isFlammable() const;
+
+  CollisionData collisionData() const;
+
+  constexpr bool operator==(const TileAttributes& other) const
+  {
+    return mFlags == other.mFlags;
+  }
+
+  constexpr bool operator!=(const TileAttributes& other) const
+  {
+    return !(*this == other);
+  }
 
 private:
-  std::uint16_t mAttributesBitPack = 0;
+  std::uint16_t mFlags = 0;
 };
 
 
+/** Attributes for all tiles of a tileset
+ *
+ * Holds a precomputed TileAttributes table, indexed by tile index.
+ */
 class TileAttributeDict
 {
 public:
@@ -95,16 +128,24 @@ public:
 
   TileAttributeDict() = default;
   explicit TileAttributeDict(const AttributeArray& bitpacks);
-  explicit TileAttributeDict(AttributeArray&& bitpacks);
 
-  TileAttributes attributes(TileIndex tile) const;
+  const TileAttributes& attributes(TileIndex tile) const;
   CollisionData collisionData(TileIndex tile) const;
+  bool isForeGround(TileIndex tile) const;
+  TileAnimationType animationType(TileIndex tile) const;
 
-private:
-  std::uint16_t bitPackFor(TileIndex tile) const;
+  bool operator==(const TileAttributeDict& other) const
+  {
+    return mAttributes == other.mAttributes;
+  }
+
+  bool operator!=(const TileAttributeDict& other) const
+  {
+    return !(*this == other);
+  }
 
 private:
-  AttributeArray mAttributeBitPacks;
+  std::vector<TileAttributes> mAttributes;
 };
 
 } // namespace rigel::data::map
@@ -27,11 +27,69 @@ using namespace std;
 namespace detail
 {
 
-inline bool isBitSet(uint16_t bitPack, uint16_t bitMask)
+constexpr bool isBitSet(const uint16_t bitPack, const uint16_t bitMask)
 {
   return (bitPack & bitMask) != 0;
 }
 
+
+constexpr uint16_t flagIf(const bool condition, const uint16_t flag)
+{
+  return condition ? flag : uint16_t{0};
+}
+
+
+// Layout of the attribute bit pack as found in the game's data files
+namespace raw
+{
+
+constexpr uint16_t COLLISION_MASK = 0x000F;
+constexpr uint16_t ANIMATED = 0x0010;
+constexpr uint16_t FOREGROUND = 0x0020;
+constexpr uint16_t FLAMMABLE = 0x0040;
+constexpr uint16_t CLIMBABLE = 0x0080;
+constexpr uint16_t CONVEYOR_LEFT = 0x0100;
+constexpr uint16_t CONVEYOR_RIGHT = 0x0200;
+constexpr uint16_t SLOW_ANIMATION = 0x0400;
+constexpr uint16_t LADDER = 0x4000;
+
+} // namespace raw
+
+
+// Layout of TileAttributes::mFlags
+namespace packed
+{
+
+constexpr uint16_t COLLISION_MASK = 0x000F;
+constexpr uint16_t ANIMATED = 0x0010;
+constexpr uint16_t FAST_ANIMATION = 0x0020;
+constexpr uint16_t FOREGROUND = 0x0040;
+constexpr uint16_t LADDER = 0x0080;
+constexpr uint16_t CLIMBABLE = 0x0100;
+constexpr uint16_t CONVEYOR_LEFT = 0x0200;
+constexpr uint16_t CONVEYOR_RIGHT = 0x0400;
+constexpr uint16_t FLAMMABLE = 0x0800;
+
+} // namespace packed
+
+
+constexpr uint16_t packAttributes(const uint16_t bitPack)
+{
+  const auto isAnimated = isBitSet(bitPack, raw::ANIMATED);
+
+  return static_cast<uint16_t>(
+    (bitPack & raw::COLLISION_MASK) | flagIf(isAnimated, packed::ANIMATED) |
+    flagIf(
+      isAnimated && !isBitSet(bitPack, raw::SLOW_ANIMATION),
+      packed::FAST_ANIMATION) |
+    flagIf(isBitSet(bitPack, raw::FOREGROUND), packed::FOREGROUND) |
+    flagIf(isBitSet(bitPack, raw::LADDER), packed::LADDER) |
+    flagIf(isBitSet(bitPack, raw::CLIMBABLE), packed::CLIMBABLE) |
+    flagIf(isBitSet(bitPack, raw::CONVEYOR_LEFT), packed::CONVEYOR_LEFT) |
+    flagIf(isBitSet(bitPack, raw::CONVEYOR_RIGHT), packed::CONVEYOR_RIGHT) |
+    flagIf(isBitSet(bitPack, raw::FLAMMABLE), packed::FLAMMABLE));
+}
+
 } // namespace detail
 
 
@@ -87,89 +145,122 @@ inline CollisionData::CollisionData(const std::uint8_t flagsBitPack)
 }
 
 
-inline TileAttributes::TileAttributes(const std::uint16_t attributesBitPack)
-  : mAttributesBitPack(attributesBitPack)
+constexpr TileAttributes::TileAttributes(const std::uint16_t attributesBitPack)
+  : mFlags(detail::packAttributes(attributesBitPack))
 {
 }
 
 
-inline bool TileAttributes::isAnimated() const
+constexpr bool TileAttributes::isAnimated() const
 {
-  return detail::isBitSet(mAttributesBitPack, 0x10);
+  return detail::isBitSet(mFlags, detail::packed::ANIMATED);
 }
 
 
-inline bool TileAttributes::isFastAnimation() const
+constexpr bool TileAttributes::isFastAnimation() const
 {
-  return !detail::isBitSet(mAttributesBitPack, 0x400);
+  return detail::isBitSet(mFlags, detail::packed::FAST_ANIMATION);
 }
 
 
-inline bool TileAttributes::isForeGround() const
+constexpr TileAnimationType TileAttributes::animationType() const
 {
-  return detail::isBitSet(mAttributesBitPack, 0x20);
+  if (isFastAnimation())
+  {
+    return TileAnimationType::Fast;
+  }
+
+  return isAnimated() ? TileAnimationType::Slow : TileAnimationType::None;
 }
 
 
-inline bool TileAttributes::isLadder() const
+constexpr bool TileAttributes::isForeGround() const
 {
-  return detail::isBitSet(mAttributesBitPack, 0x4000);
+  return detail::isBitSet(mFlags, detail::packed::FOREGROUND);
 }
 
 
-inline bool TileAttributes::isClimbable() const
+constexpr bool TileAttributes::isLadder() const
 {
-  return detail::isBitSet(mAttributesBitPack, 0x80);
+  return detail::isBitSet(mFlags, detail::packed::LADDER);
 }
 
 
-inline bool TileAttributes::isConveyorBeltLeft() const
+constexpr bool TileAttributes::isClimbable() const
 {
-  return detail::isBitSet(mAttributesBitPack, 0x100);
+  return detail::isBitSet(mFlags, detail::packed::CLIMBABLE);
 }
 
 
-inline bool TileAttributes::isConveyorBeltRight() const
+constexpr bool TileAttributes::isConveyorBeltLeft() const
 {
-  return detail::isBitSet(mAttributesBitPack, 0x200);
+  return detail::isBitSet(mFlags, detail::packed::CONVEYOR_LEFT);
 }
 
 
-inline bool TileAttributes::isFlammable() const
+constexpr bool TileAttributes::isConveyorBeltRight() const
 {
-  return detail::isBitSet(mAttributesBitPack, 0x40);
+  return detail::isBitSet(mFlags, detail::packed::CONVEYOR_RIGHT);
 }
 
 
-inline TileAttributeDict::TileAttributeDict(const AttributeArray& bitpacks)
-  : mAttributeBitPacks(bitpacks)
+constexpr bool TileAttributes::isFlammable() const
 {
+  return detail::isBitSet(mFlags, detail::packed::FLAMMABLE);
 }
 
 
-inline TileAttributeDict::TileAttributeDict(AttributeArray&& bitpacks)
-  : mAttributeBitPacks(std::move(bitpacks))
+inline CollisionData TileAttributes::collisionData() const
 {
+  return CollisionData(
+    static_cast<uint8_t>(mFlags & detail::packed::COLLISION_MASK));
 }
 
 
-inline uint16_t TileAttributeDict::bitPackFor(const TileIndex tile) const
+static_assert(
+  TileAttributes{0x10}.animationType() == TileAnimationType::Fast &&
+  TileAttributes{0x410}.animationType() == TileAnimationType::Slow &&
+  TileAttributes{0x400}.animationType() == TileAnimationType::None);
+static_assert(
+  TileAttributes{0x4000}.isLadder() && TileAttributes{0x20}.isForeGround() &&
+  !TileAttributes{0x20}.isFlammable());
+
+
+inline TileAttributeDict::TileAttributeDict(const AttributeArray& bitpacks)
 {
-  assert(tile < mAttributeBitPacks.size());
-  return mAttributeBitPacks[tile];
+  mAttributes.reserve(bitpacks.size());
+  for (const auto bitPack : bitpacks)
+  {
+    mAttributes.emplace_back(bitPack);
+  }
 }
 
 
-inline TileAttributes TileAttributeDict::attributes(const TileIndex tile) const
+inline const TileAttributes&
+  TileAttributeDict::attributes(const TileIndex tile) const
 {
-  return TileAttributes(bitPackFor(tile));
+  assert(tile < mAttributes.size());
+  return mAttributes[tile];
 }
 
 
 inline CollisionData
   TileAttributeDict::collisionData(const TileIndex tile) const
 {
-  return CollisionData(static_cast<uint8_t>(bitPackFor(tile) & 0xF));
+  return attributes(tile).collisionData();
+}
+
+
+inline bool TileAttributeDict::isForeGround(const TileIndex tile) const
+{
+  return attributes(tile).isForeGround();
+}
+
+
+inline TileAnimationType
+  TileAttributeDict::animationType(const TileIndex tile) const
+{
+  return attributes(tile).animationType();
 }
 
 } // namespace rigel::data::map
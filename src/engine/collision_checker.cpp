@@ -17,6 +17,10 @@
 #include "collision_checker.hpp"
 
 #include <algorithm>
+#include <cstdlib>
+#include <optional>
+#include <tuple>
+#include <utility>
 
 
 namespace rigel::engine
@@ -29,14 +33,59 @@ using data::map::SolidEdge;
 using namespace engine::components;
 
 
+namespace
+{
+
+// Size of a spatial index grid cell, in tiles
+constexpr auto GRID_CELL_SIZE = 16;
+
+// Solid bodies are indexed with this much extra space around their
+// bounding box, in tiles. This covers movement and bounding box changes
+// happening in between two calls to updateSolidBodyIndex(), like a sliding
+// door opening or an elevator moving during the physics update.
+constexpr auto INDEX_MARGIN = 8;
+
+
+std::optional<BoundingBox> worldSpaceBboxOf(const ex::Entity& entity)
+{
+  // The grid can still refer to bodies which have been removed since the
+  // last updateSolidBodyIndex(), these are ignored here.
+  if (
+    entity.valid() && entity.has_component<SolidBody>() &&
+    entity.has_component<BoundingBox>() &&
+    entity.has_component<WorldPosition>())
+  {
+    return engine::toWorldSpace(
+      *entity.component<const BoundingBox>(),
+      *entity.component<const WorldPosition>());
+  }
+
+  return std::nullopt;
+}
+
+
+bool contains(const BoundingBox& outer, const BoundingBox& inner)
+{
+  return inner.left() >= outer.left() && inner.right() <= outer.right() &&
+    inner.top() >= outer.top() && inner.bottom() <= outer.bottom();
+}
+
+
+} // namespace
+
+
 CollisionChecker::CollisionChecker(
   const data::map::Map* pMap,
   ex::EntityManager& entities,
   ex::EventManager& eventManager)
-  : mpMap(pMap)
+  : mGrid(pMap->width(), pMap->height(), GRID_CELL_SIZE)
+  , mpMap(pMap)
 {
+  mSolidBodyGrid.resize(mGrid.numCells());
+
   entities.each<SolidBody>([this](ex::Entity entity, const SolidBody&) {
-    mSolidBodies.push_back(entity);
+    auto& body = mSolidBodies.emplace_back(IndexedSolidBody{entity, {}, {}});
+    addToIndex(body);
   });
 
   eventManager.subscribe<ex::ComponentAddedEvent<SolidBody>>(*this);
@@ -80,6 +129,38 @@ bool CollisionChecker::isTouchingRightWall(
 }
 
 
+int CollisionChecker::distanceToLeftWall(
+  const BoundingBox& bbox,
+  const int maxDistance) const
+{
+  return sweep(bbox, maxDistance, SweepDirection::Left);
+}
+
+
+int CollisionChecker::distanceToRightWall(
+  const BoundingBox& bbox,
+  const int maxDistance) const
+{
+  return sweep(bbox, maxDistance, SweepDirection::Right);
+}
+
+
+int CollisionChecker::distanceToCeiling(
+  const BoundingBox& bbox,
+  const int maxDistance) const
+{
+  return sweep(bbox, maxDistance, SweepDirection::Up);
+}
+
+
+int CollisionChecker::distanceToGround(
+  const BoundingBox& bbox,
+  const int maxDistance) const
+{
+  return sweep(bbox, maxDistance, SweepDirection::Down);
+}
+
+
 bool CollisionChecker::testHorizontalSpan(
   const int startX,
   const int endX,
@@ -95,15 +176,7 @@ bool CollisionChecker::testHorizontalSpan(
     }
   }
 
-  for (int x = startX; x <= endX; ++x)
-  {
-    if (mpMap->collisionData(x, y).isSolidOn(edge))
-    {
-      return true;
-    }
-  }
-
-  return false;
+  return mpMap->hasSolidEdgeInRow(startX, endX, y, edge);
 }
 
 
@@ -122,11 +195,37 @@ bool CollisionChecker::testVerticalSpan(
     }
   }
 
-  for (int y = startY; y <= endY; ++y)
+  return mpMap->hasSolidEdgeInColumn(startY, endY, x, edge);
+}
+
+
+bool CollisionChecker::hasSolidBodyIn(const BoundingBox& area) const
+{
+  return testSolidBodyCollision(area);
+}
+
+
+bool CollisionChecker::testSolidBodyCollision(
+  const BoundingBox& bboxToTest) const
+{
+  const auto cells = mGrid.cellsCovering(bboxToTest);
+
+  for (auto y = cells.top(); y <= cells.bottom(); ++y)
   {
-    if (mpMap->collisionData(x, y).isSolidOn(edge))
+    for (auto x = cells.left(); x <= cells.right(); ++x)
     {
-      return true;
+      const auto& cell = mSolidBodyGrid[mGrid.cellIndex(x, y)];
+
+      const auto hasCollision = any_of(
+        begin(cell), end(cell), [&bboxToTest](const ex::Entity& entity) {
+          const auto solidBodyBbox = worldSpaceBboxOf(entity);
+          return solidBodyBbox && solidBodyBbox->intersects(bboxToTest);
+        });
+
+      if (hasCollision)
+      {
+        return true;
+      }
     }
   }
 
@@ -134,25 +233,251 @@ bool CollisionChecker::testVerticalSpan(
 }
 
 
-bool CollisionChecker::testSolidBodyCollision(
-  const BoundingBox& bboxToTest) const
+int CollisionChecker::sweep(
+  const BoundingBox& bbox,
+  const int maxDistance,
+  const SweepDirection direction) const
+{
+  if (maxDistance <= 0)
+  {
+    return 0;
+  }
+
+  // Each step tests a line of tiles right next to the bounding box, like
+  // isTouchingLeftWall() etc. do. The line is located at start + i (or
+  // start - i when moving left/up) after i steps, and extends from spanStart
+  // to spanEnd along the other axis.
+  const auto [start, spanStart, spanEnd] = [&]() {
+    switch (direction)
+    {
+      case SweepDirection::Left:
+        return std::make_tuple(bbox.left() - 1, bbox.top(), bbox.bottom());
+
+      case SweepDirection::Right:
+        return std::make_tuple(bbox.right() + 1, bbox.top(), bbox.bottom());
+
+      case SweepDirection::Up:
+        return std::make_tuple(bbox.top() - 1, bbox.left(), bbox.right());
+
+      default:
+        return std::make_tuple(bbox.bottom() + 1, bbox.left(), bbox.right());
+    }
+  }();
+
+  // Empty spans never collide, see testHorizontalSpan()
+  if (spanStart > spanEnd)
+  {
+    return maxDistance;
+  }
+
+  const auto distance =
+    sweepMap(start, spanStart, spanEnd, maxDistance, direction);
+  return sweepSolidBodies(start, spanStart, spanEnd, distance, direction);
+}
+
+
+int CollisionChecker::sweepMap(
+  const int start,
+  const int spanStart,
+  const int spanEnd,
+  const int maxDistance,
+  const SweepDirection direction) const
+{
+  const auto sign = direction == SweepDirection::Left ||
+      direction == SweepDirection::Up
+    ? -1
+    : 1;
+  const auto mapWidth = mpMap->width();
+  const auto mapHeight = mpMap->height();
+
+  auto distance = maxDistance;
+  auto lastLine = [&]() { return start + sign * (distance - 1); };
+
+  if (
+    direction == SweepDirection::Left || direction == SweepDirection::Right)
+  {
+    // Columns outside of the map are always solid
+    if (start < 0 || start >= mapWidth)
+    {
+      return 0;
+    }
+
+    distance = std::min(distance, sign > 0 ? mapWidth - start : start + 1);
+
+    const auto edge = sign > 0 ? SolidEdge::left() : SolidEdge::right();
+    const auto firstRow = std::max(spanStart, 0);
+    const auto lastRow = std::min(spanEnd, mapHeight - 1);
+    for (auto y = firstRow; y <= lastRow && distance > 0; ++y)
+    {
+      if (const auto x = mpMap->findSolidEdgeInRow(start, lastLine(), y, edge))
+      {
+        distance = std::abs(*x - start);
+      }
+    }
+
+    return distance;
+  }
+
+  // Rows reaching outside of the map horizontally are always solid
+  if (spanStart < 0 || spanEnd >= mapWidth)
+  {
+    return 0;
+  }
+
+  // Rows above and below the map are never solid, so only the part of the
+  // swept area that's inside the map needs to be looked at
+  const auto edge = sign > 0 ? SolidEdge::top() : SolidEdge::bottom();
+  for (auto x = spanStart; x <= spanEnd && distance > 0; ++x)
+  {
+    const auto fromY =
+      sign > 0 ? std::max(start, 0) : std::min(start, mapHeight - 1);
+    const auto toY =
+      sign > 0 ? std::min(lastLine(), mapHeight - 1) : std::max(lastLine(), 0);
+    if ((toY - fromY) * sign < 0)
+    {
+      break;
+    }
+
+    if (const auto y = mpMap->findSolidEdgeInColumn(fromY, toY, x, edge))
+    {
+      distance = std::abs(*y - start);
+    }
+  }
+
+  return distance;
+}
+
+
+int CollisionChecker::sweepSolidBodies(
+  const int start,
+  const int spanStart,
+  const int spanEnd,
+  const int maxDistance,
+  const SweepDirection direction) const
 {
-  return any_of(
-    begin(mSolidBodies),
-    end(mSolidBodies),
-    [&bboxToTest](const ex::Entity& entity) {
-      if (
-        entity.has_component<BoundingBox>() &&
-        entity.has_component<WorldPosition>())
+  if (maxDistance <= 0)
+  {
+    return 0;
+  }
+
+  const auto isHorizontal =
+    direction == SweepDirection::Left || direction == SweepDirection::Right;
+  const auto sign = direction == SweepDirection::Left ||
+      direction == SweepDirection::Up
+    ? -1
+    : 1;
+
+  const auto end = start + sign * (maxDistance - 1);
+  const auto firstLine = std::min(start, end);
+  const auto lastLine = std::max(start, end);
+  const auto spanLength = spanEnd - spanStart + 1;
+  const auto sweptLength = lastLine - firstLine + 1;
+
+  const auto sweptArea = isHorizontal
+    ? BoundingBox{{firstLine, spanStart}, {sweptLength, spanLength}}
+    : BoundingBox{{spanStart, firstLine}, {spanLength, sweptLength}};
+  const auto cells = mGrid.cellsCovering(sweptArea);
+
+  auto distance = maxDistance;
+
+  for (auto y = cells.top(); y <= cells.bottom(); ++y)
+  {
+    for (auto x = cells.left(); x <= cells.right(); ++x)
+    {
+      // The individual line tests only look at the cells covering the line,
+      // so a body can only be hit at line positions belonging to this cell.
+      const auto [cellFirst, cellLast] = isHorizontal
+        ? mGrid.coordinatesInColumn(x)
+        : mGrid.coordinatesInRow(y);
+
+      for (const auto& entity : mSolidBodyGrid[mGrid.cellIndex(x, y)])
       {
-        const auto solidBodyBbox = engine::toWorldSpace(
-          *entity.component<const BoundingBox>(),
-          *entity.component<const WorldPosition>());
-        return solidBodyBbox.intersects(bboxToTest);
+        const auto bbox = worldSpaceBboxOf(entity);
+        if (!bbox || bbox->size.width <= 0 || bbox->size.height <= 0)
+        {
+          continue;
+        }
+
+        const auto [bodyFirst, bodyLast, bodySpanFirst, bodySpanLast] =
+          isHorizontal
+          ? std::make_tuple(
+              bbox->left(), bbox->right(), bbox->top(), bbox->bottom())
+          : std::make_tuple(
+              bbox->top(), bbox->bottom(), bbox->left(), bbox->right());
+
+        if (bodySpanLast < spanStart || bodySpanFirst > spanEnd)
+        {
+          continue;
+        }
+
+        const auto first = std::max({bodyFirst, cellFirst, firstLine});
+        const auto last = std::min({bodyLast, cellLast, lastLine});
+        if (first <= last)
+        {
+          const auto hit = sign > 0 ? first : last;
+          distance = std::min(distance, std::abs(hit - start));
+        }
       }
+    }
+  }
+
+  return distance;
+}
+
+
+void CollisionChecker::addToIndex(IndexedSolidBody& body)
+{
+  const auto bbox = worldSpaceBboxOf(body.mEntity);
+  if (!bbox)
+  {
+    body.mIndexedArea = {};
+    body.mCells = {};
+    return;
+  }
+
+  body.mIndexedArea = BoundingBox{
+    {bbox->left() - INDEX_MARGIN, bbox->top() - INDEX_MARGIN},
+    {bbox->size.width + INDEX_MARGIN * 2,
+     bbox->size.height + INDEX_MARGIN * 2}};
+  body.mCells = mGrid.cellsCovering(body.mIndexedArea);
 
-      return false;
-    });
+  for (auto y = body.mCells.top(); y <= body.mCells.bottom(); ++y)
+  {
+    for (auto x = body.mCells.left(); x <= body.mCells.right(); ++x)
+    {
+      mSolidBodyGrid[mGrid.cellIndex(x, y)].push_back(body.mEntity);
+    }
+  }
+}
+
+
+void CollisionChecker::removeFromIndex(const IndexedSolidBody& body)
+{
+  for (auto y = body.mCells.top(); y <= body.mCells.bottom(); ++y)
+  {
+    for (auto x = body.mCells.left(); x <= body.mCells.right(); ++x)
+    {
+      auto& cell = mSolidBodyGrid[mGrid.cellIndex(x, y)];
+      cell.erase(
+        std::remove(begin(cell), end(cell), body.mEntity), end(cell));
+    }
+  }
+}
+
+
+void CollisionChecker::updateSolidBodyIndex()
+{
+  applyPendingRemovals();
+
+  for (auto& body : mSolidBodies)
+  {
+    const auto bbox = worldSpaceBboxOf(body.mEntity);
+    if (bbox && !contains(body.mIndexedArea, *bbox))
+    {
+      removeFromIndex(body);
+      addToIndex(body);
+    }
+  }
 }
 
 
@@ -199,24 +524,60 @@ bool CollisionChecker::isTouchingRightWall(
 }
 
 
+void CollisionChecker::applyPendingRemovals()
+{
+  if (mRemovedSolidBodies.empty())
+  {
+    return;
+  }
+
+  std::sort(begin(mRemovedSolidBodies), end(mRemovedSolidBodies));
+
+  const auto wasRemoved = [this](const IndexedSolidBody& body) {
+    return std::binary_search(
+      begin(mRemovedSolidBodies), end(mRemovedSolidBodies), body.mEntity);
+  };
+
+  for (const auto& body : mSolidBodies)
+  {
+    if (wasRemoved(body))
+    {
+      removeFromIndex(body);
+    }
+  }
+
+  mSolidBodies.erase(
+    std::remove_if(begin(mSolidBodies), end(mSolidBodies), wasRemoved),
+    end(mSolidBodies));
+  mRemovedSolidBodies.clear();
+}
+
+
 void CollisionChecker::receive(const ex::ComponentAddedEvent<SolidBody>& event)
 {
-  mSolidBodies.push_back(event.entity);
+  // If the entity had its SolidBody removed and then re-added, the old entry
+  // needs to go first.
+  if (
+    std::find(
+      begin(mRemovedSolidBodies), end(mRemovedSolidBodies), event.entity) !=
+    end(mRemovedSolidBodies))
+  {
+    applyPendingRemovals();
+  }
+
+  auto& body =
+    mSolidBodies.emplace_back(IndexedSolidBody{event.entity, {}, {}});
+  addToIndex(body);
 }
 
 
 void CollisionChecker::receive(
   const ex::ComponentRemovedEvent<SolidBody>& event)
 {
-  const auto it = find_if(
-    begin(mSolidBodies), end(mSolidBodies), [&event](const auto& entity) {
-      return entity == event.entity;
-    });
-
-  if (it != end(mSolidBodies))
-  {
-    mSolidBodies.erase(it);
-  }
+  // Entities are often destroyed in bulk, e.g. when a shootable wall is
+  // blown up. Instead of searching and erasing each one right away, they are
+  // removed in one pass by the next updateSolidBodyIndex().
+  mRemovedSolidBodies.push_back(event.entity);
 }
 
 } // namespace rigel::engine
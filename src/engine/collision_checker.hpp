@@ -16,6 +16,7 @@
 
 #pragma once
 
+#include "base/grid_layout.hpp"
 #include "base/warnings.hpp"
 #include "data/map.hpp"
 #include "engine/base_components.hpp"
@@ -31,6 +32,18 @@ RIGEL_RESTORE_WARNINGS
 namespace rigel::engine
 {
 
+/** Answers collision queries against the map and SolidBody entities
+ *
+ * Solid bodies are kept in a uniform grid, so that a query only needs to
+ * look at bodies in the grid cells it overlaps. Bodies are entered into the
+ * grid with some extra margin around their bounding box, and tested against
+ * their current position and bounding box at query time. This means that a
+ * solid body can move or change its bounding box by up to that margin
+ * without being missed. To handle larger changes, the grid needs to be
+ * brought up to date via updateSolidBodyIndex(). PhysicsSystem does this
+ * at the start of each update. Removed solid bodies are ignored by queries
+ * right away, but only taken out of the grid by updateSolidBodyIndex().
+ */
 class CollisionChecker : public entityx::Receiver<CollisionChecker>
 {
 public:
@@ -60,22 +73,93 @@ public:
   bool isTouchingLeftWall(const engine::components::BoundingBox& bbox) const;
   bool isTouchingRightWall(const engine::components::BoundingBox& bbox) const;
 
+  /** Sweep queries: How far a bounding box can move in one go
+   *
+   * Returns how many single unit steps (up to maxDistance) the given world
+   * space bounding box can take in the respective direction. This matches
+   * moving one unit at a time for as long as the corresponding test above
+   * (e.g. isTouchingRightWall() for distanceToRightWall()) fails, but looks
+   * at the solid edge bitmaps and solid bodies only once for the whole
+   * distance.
+   */
+  int distanceToLeftWall(
+    const engine::components::BoundingBox& bbox,
+    int maxDistance) const;
+  int distanceToRightWall(
+    const engine::components::BoundingBox& bbox,
+    int maxDistance) const;
+  int distanceToCeiling(
+    const engine::components::BoundingBox& bbox,
+    int maxDistance) const;
+  int distanceToGround(
+    const engine::components::BoundingBox& bbox,
+    int maxDistance) const;
+
   bool
     testHorizontalSpan(int startX, int endX, int y, data::map::SolidEdge edge)
       const;
   bool testVerticalSpan(int startY, int endY, int x, data::map::SolidEdge edge)
     const;
 
+  /** Test if any solid body intersects the given world-space area */
+  bool hasSolidBodyIn(const engine::components::BoundingBox& area) const;
+
+  /** Re-enter moved or resized solid bodies into the spatial index
+   *
+   * Only bodies whose indexed area no longer covers their current bounding
+   * box are touched.
+   */
+  void updateSolidBodyIndex();
+
   void
     receive(const entityx::ComponentAddedEvent<components::SolidBody>& event);
   void
     receive(const entityx::ComponentRemovedEvent<components::SolidBody>& event);
 
 private:
+  struct IndexedSolidBody
+  {
+    entityx::Entity mEntity;
+    base::Rect<int> mIndexedArea;
+    base::Rect<int> mCells;
+  };
+
+  enum class SweepDirection
+  {
+    Left,
+    Right,
+    Up,
+    Down
+  };
+
   bool
     testSolidBodyCollision(const engine::components::BoundingBox& bbox) const;
 
-  std::vector<entityx::Entity> mSolidBodies;
+  int sweep(
+    const engine::components::BoundingBox& bbox,
+    int maxDistance,
+    SweepDirection direction) const;
+  int sweepMap(
+    int start,
+    int spanStart,
+    int spanEnd,
+    int maxDistance,
+    SweepDirection direction) const;
+  int sweepSolidBodies(
+    int start,
+    int spanStart,
+    int spanEnd,
+    int maxDistance,
+    SweepDirection direction) const;
+
+  void addToIndex(IndexedSolidBody& body);
+  void removeFromIndex(const IndexedSolidBody& body);
+  void applyPendingRemovals();
+
+  std::vector<IndexedSolidBody> mSolidBodies;
+  std::vector<entityx::Entity> mRemovedSolidBodies;
+  std::vector<std::vector<entityx::Entity>> mSolidBodyGrid;
+  base::GridLayout mGrid;
   const data::map::Map* mpMap;
 };
 
@@ -0,0 +1,153 @@
+/* Copyright (C) 2022, Nikolai Wuttke. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "collision_query_cache.hpp"
+
+#include "data/map.hpp"
+#include "engine/collision_checker.hpp"
+#include "engine/physical_components.hpp"
+
+#include <algorithm>
+
+
+namespace rigel::engine
+{
+
+using namespace engine::components;
+
+
+CollisionQueryCache::CollisionQueryCache(
+  const CollisionChecker* pCollisionChecker,
+  const data::map::Map* pMap)
+  : mpCollisionChecker(pCollisionChecker)
+  , mpMap(pMap)
+{
+}
+
+
+void CollisionQueryCache::setEnabled(const bool enabled)
+{
+  mIsEnabled = enabled;
+  invalidate();
+}
+
+
+void CollisionQueryCache::invalidate()
+{
+  mEntries.clear();
+}
+
+
+bool CollisionQueryCache::isOnSolidGround(
+  const WorldPosition& position,
+  const BoundingBox& bbox)
+{
+  return isOnSolidGround(toWorldSpace(bbox, position));
+}
+
+
+bool CollisionQueryCache::isTouchingCeiling(
+  const WorldPosition& position,
+  const BoundingBox& bbox)
+{
+  return isTouchingCeiling(toWorldSpace(bbox, position));
+}
+
+
+bool CollisionQueryCache::isTouchingLeftWall(
+  const WorldPosition& position,
+  const BoundingBox& bbox)
+{
+  return isTouchingLeftWall(toWorldSpace(bbox, position));
+}
+
+
+bool CollisionQueryCache::isTouchingRightWall(
+  const WorldPosition& position,
+  const BoundingBox& bbox)
+{
+  return isTouchingRightWall(toWorldSpace(bbox, position));
+}
+
+
+bool CollisionQueryCache::isOnSolidGround(const BoundingBox& bbox)
+{
+  return lookUp(Query::SolidGround, bbox, [&]() {
+    return mpCollisionChecker->isOnSolidGround(bbox);
+  });
+}
+
+
+bool CollisionQueryCache::isTouchingCeiling(const BoundingBox& bbox)
+{
+  return lookUp(Query::Ceiling, bbox, [&]() {
+    return mpCollisionChecker->isTouchingCeiling(bbox);
+  });
+}
+
+
+bool CollisionQueryCache::isTouchingLeftWall(const BoundingBox& bbox)
+{
+  return lookUp(Query::LeftWall, bbox, [&]() {
+    return mpCollisionChecker->isTouchingLeftWall(bbox);
+  });
+}
+
+
+bool CollisionQueryCache::isTouchingRightWall(const BoundingBox& bbox)
+{
+  return lookUp(Query::RightWall, bbox, [&]() {
+    return mpCollisionChecker->isTouchingRightWall(bbox);
+  });
+}
+
+
+template <typename QueryFunc>
+bool CollisionQueryCache::lookUp(
+  const Query query,
+  const BoundingBox& worldSpaceBbox,
+  QueryFunc&& runQuery)
+{
+  if (!mIsEnabled)
+  {
+    return runQuery();
+  }
+
+  if (mpMap->revision() != mMapRevision)
+  {
+    mEntries.clear();
+    mMapRevision = mpMap->revision();
+  }
+
+  const auto iEntry =
+    std::find_if(mEntries.begin(), mEntries.end(), [&](const Entry& entry) {
+      return entry.mQuery == query && entry.mBbox == worldSpaceBbox;
+    });
+  if (iEntry != mEntries.end())
+  {
+    return iEntry->mResult;
+  }
+
+  const auto result = runQuery();
+  if (mEntries.size() < MAX_ENTRIES)
+  {
+    mEntries.push_back(Entry{worldSpaceBbox, query, result});
+  }
+
+  return result;
+}
+
+} // namespace rigel::engine
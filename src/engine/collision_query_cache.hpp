@@ -0,0 +1,109 @@
+/* Copyright (C) 2022, Nikolai Wuttke. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "base/static_vector.hpp"
+#include "engine/base_components.hpp"
+
+#include <cstdint>
+
+
+namespace rigel::data::map
+{
+class Map;
+}
+
+
+namespace rigel::engine
+{
+
+class CollisionChecker;
+
+
+/** Memoizes CollisionChecker's touch tests while enabled
+ *
+ * Meant for code that runs the same tests on the same bounding box several
+ * times in a row, like the player's state machine during a single update.
+ * Results are discarded automatically when the map changes. Solid bodies
+ * moving can't be detected, though, so the cache should only be enabled
+ * while no solid bodies are moved, or invalidate() must be called after
+ * moving one. While disabled, all queries go straight to the collision
+ * checker.
+ */
+class CollisionQueryCache
+{
+public:
+  CollisionQueryCache(
+    const CollisionChecker* pCollisionChecker,
+    const data::map::Map* pMap);
+
+  /** Enable or disable memoization. Disabling discards all results. */
+  void setEnabled(bool enabled);
+  void invalidate();
+
+  bool isOnSolidGround(
+    const components::WorldPosition& position,
+    const components::BoundingBox& bbox);
+  bool isTouchingCeiling(
+    const components::WorldPosition& position,
+    const components::BoundingBox& bbox);
+  bool isTouchingLeftWall(
+    const components::WorldPosition& position,
+    const components::BoundingBox& bbox);
+  bool isTouchingRightWall(
+    const components::WorldPosition& position,
+    const components::BoundingBox& bbox);
+
+  bool isOnSolidGround(const components::BoundingBox& bbox);
+  bool isTouchingCeiling(const components::BoundingBox& bbox);
+  bool isTouchingLeftWall(const components::BoundingBox& bbox);
+  bool isTouchingRightWall(const components::BoundingBox& bbox);
+
+private:
+  enum class Query : std::uint8_t
+  {
+    SolidGround,
+    Ceiling,
+    LeftWall,
+    RightWall
+  };
+
+  struct Entry
+  {
+    components::BoundingBox mBbox;
+    Query mQuery;
+    bool mResult;
+  };
+
+  template <typename QueryFunc>
+  bool lookUp(
+    Query query,
+    const components::BoundingBox& worldSpaceBbox,
+    QueryFunc&& runQuery);
+
+  // A single update only probes a handful of distinct boxes, so a small
+  // array with linear search is enough.
+  static constexpr auto MAX_ENTRIES = 16;
+
+  base::static_vector<Entry, MAX_ENTRIES> mEntries;
+  const CollisionChecker* mpCollisionChecker;
+  const data::map::Map* mpMap;
+  std::uint32_t mMapRevision = 0;
+  bool mIsEnabled = false;
+};
+
+} // namespace rigel::engine
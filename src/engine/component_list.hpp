@@ -0,0 +1,101 @@
+/* Copyright (C) 2022, Nikolai Wuttke. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "base/warnings.hpp"
+
+RIGEL_DISABLE_WARNINGS
+#include <entityx/entityx.h>
+RIGEL_RESTORE_WARNINGS
+
+
+namespace rigel::engine
+{
+
+template <typename T>
+struct ComponentTag
+{
+  using Type = T;
+};
+
+
+/** Compile-time list of component types, with operations on all of them
+ *
+ * Meant for things which need to handle every component an entity might
+ * have, like copying entities between entity managers. Listing the types in
+ * one place means that such operations can't get out of sync with each
+ * other.
+ *
+ * Presence of components is determined via the entity's component mask,
+ * which is retrieved once per call instead of looking up each component type
+ * separately.
+ */
+template <typename... Components>
+struct ComponentList
+{
+  using Mask = entityx::EntityManager::ComponentMask;
+
+  /** Invoke func(ComponentTag<T>{}) for each type T in the list */
+  template <typename Func>
+  static void forEach(Func&& func)
+  {
+    (func(ComponentTag<Components>{}), ...);
+  }
+
+  /** Mask with the bits for all types in the list set */
+  static Mask mask()
+  {
+    static const auto result = []() {
+      auto mask = Mask{};
+      (mask.set(entityx::EntityManager::component_family<Components>()), ...);
+      return mask;
+    }();
+
+    return result;
+  }
+
+  /** True if entity has no components which are missing from the list */
+  static bool coversAllComponentsOf(entityx::Entity entity)
+  {
+    return (entity.component_mask() & ~mask()).none();
+  }
+
+  /** Assign a copy of each listed component of from to to
+   *
+   * to must not have any of the components already.
+   */
+  static void copyAll(entityx::Entity from, entityx::Entity to)
+  {
+    const auto presentComponents = from.component_mask();
+    (copyIfPresent<Components>(presentComponents, from, to), ...);
+  }
+
+private:
+  template <typename T>
+  static void copyIfPresent(
+    const Mask& presentComponents,
+    entityx::Entity from,
+    entityx::Entity to)
+  {
+    if (presentComponents.test(entityx::EntityManager::component_family<T>()))
+    {
+      to.assign_from_copy<T>(*from.component<const T>());
+    }
+  }
+};
+
+} // namespace rigel::engine
@@ -0,0 +1,87 @@
+/* Copyright (C) 2022, Nikolai Wuttke. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "base/warnings.hpp"
+
+RIGEL_DISABLE_WARNINGS
+#include <entityx/entityx.h>
+RIGEL_RESTORE_WARNINGS
+
+#include <tuple>
+#include <vector>
+
+
+namespace rigel::engine
+{
+
+/** Collects events of the given types, to be handled in batches later on
+ *
+ * Subscribes to each of the event types, and appends received events to a
+ * per-type array. flush() then passes each non-empty array on to the given
+ * handler's receive(const std::vector<Event>&), in the order in which the
+ * types are listed, and clears it.
+ *
+ * Since events are handled outside of the emitting system's update, a
+ * handler can't cause cascades of further events in the middle of it.
+ * This only works for events whose handlers don't depend on exact timing
+ * relative to other events, or on entities that might be gone by the time
+ * of flushing.
+ */
+template <typename... Events>
+class DeferredEventQueue
+  : public entityx::Receiver<DeferredEventQueue<Events...>>
+{
+public:
+  void subscribe(entityx::EventManager& events)
+  {
+    (events.subscribe<Events>(*this), ...);
+  }
+
+  void unsubscribe(entityx::EventManager& events)
+  {
+    (events.unsubscribe<Events>(*this), ...);
+  }
+
+  template <typename Event>
+  void receive(const Event& event)
+  {
+    std::get<std::vector<Event>>(mQueues).push_back(event);
+  }
+
+  template <typename Handler>
+  void flush(Handler& handler)
+  {
+    (flushQueue<Events>(handler), ...);
+  }
+
+private:
+  template <typename Event, typename Handler>
+  void flushQueue(Handler& handler)
+  {
+    auto& queue = std::get<std::vector<Event>>(mQueues);
+    if (!queue.empty())
+    {
+      handler.receive(queue);
+      queue.clear();
+    }
+  }
+
+  std::tuple<std::vector<Events>...> mQueues;
+};
+
+} // namespace rigel::engine
@@ -76,14 +76,39 @@ bool isOnScreen(
 }
 
 
+void ActiveEntityView::clear()
+{
+  mEntities.clear();
+  mWorldSpaceBboxes.clear();
+  mIsOnScreen.clear();
+}
+
+
+void ActiveEntityView::add(
+  entityx::Entity entity,
+  const BoundingBox& worldSpaceBbox,
+  const bool isOnScreen)
+{
+  mEntities.push_back(entity);
+  mWorldSpaceBboxes.push_back(worldSpaceBbox);
+  mIsOnScreen.push_back(isOnScreen ? 1 : 0);
+}
+
+
 void markActiveEntities(
   entityx::EntityManager& es,
   const base::Vec2& cameraPosition,
-  const base::Size& viewportSize)
+  const base::Size& viewportSize,
+  ActiveEntityView* pActiveEntities)
 {
   const BoundingBox activeRegionBox{cameraPosition, viewportSize};
 
-  es.each<WorldPosition, BoundingBox>([&activeRegionBox](
+  if (pActiveEntities)
+  {
+    pActiveEntities->clear();
+  }
+
+  es.each<WorldPosition, BoundingBox>([&](
                                         entityx::Entity entity,
                                         const WorldPosition& position,
                                         const BoundingBox& bbox) {
@@ -94,6 +119,11 @@ void markActiveEntities(
     if (active)
     {
       entity.component<Active>()->mIsOnScreen = inActiveRegion;
+
+      if (pActiveEntities)
+      {
+        pActiveEntities->add(entity, worldSpaceBbox, inActiveRegion);
+      }
     }
   });
 }
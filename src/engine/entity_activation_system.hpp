@@ -18,18 +18,69 @@
 
 #include "base/spatial_types.hpp"
 #include "base/warnings.hpp"
+#include "engine/base_components.hpp"
 
 RIGEL_DISABLE_WARNINGS
 #include <entityx/entityx.h>
 RIGEL_RESTORE_WARNINGS
 
+#include <cstdint>
+#include <vector>
+
 
 namespace rigel::engine
 {
 
+/** Packed list of the entities marked active by markActiveEntities()
+ *
+ * Holds the active entities in order of their index, together with their
+ * world-space bounding box and on-screen state, in contiguous arrays. Sweeps
+ * which only care about active entities can go through these instead of
+ * visiting every entity known to the entity manager.
+ *
+ * The contents are a snapshot taken at the time of marking. Entities can be
+ * destroyed, moved around or change their active state afterwards, so users
+ * must check validity and re-read any components they operate on.
+ */
+class ActiveEntityView
+{
+public:
+  void clear();
+  void add(
+    entityx::Entity entity,
+    const components::BoundingBox& worldSpaceBbox,
+    bool isOnScreen);
+
+  std::size_t size() const { return mEntities.size(); }
+
+  const std::vector<entityx::Entity>& entities() const { return mEntities; }
+
+  const std::vector<components::BoundingBox>& worldSpaceBboxes() const
+  {
+    return mWorldSpaceBboxes;
+  }
+
+  bool isOnScreen(const std::size_t index) const
+  {
+    return mIsOnScreen[index] != 0;
+  }
+
+private:
+  std::vector<entityx::Entity> mEntities;
+  std::vector<components::BoundingBox> mWorldSpaceBboxes;
+  std::vector<std::uint8_t> mIsOnScreen;
+};
+
+
+/** Assign or remove the Active tag on all entities with a bounding box
+ *
+ * If pActiveEntities is given, it's filled with all entities that end up
+ * active.
+ */
 void markActiveEntities(
   entityx::EntityManager& es,
   const base::Vec2& cameraPosition,
-  const base::Size& viewportSize);
+  const base::Size& viewportSize,
+  ActiveEntityView* pActiveEntities = nullptr);
 
-}
+} // namespace rigel::engine
@@ -18,6 +18,7 @@
 
 #include "data/game_options.hpp"
 #include "data/game_traits.hpp"
+#include "renderer/custom_quad_batch.hpp"
 #include "renderer/renderer.hpp"
 #include "renderer/shader_code.hpp"
 #include "renderer/upscaling.hpp"
@@ -58,6 +59,16 @@ constexpr auto WATER_ANIM_TEX_HEIGHT =
 constexpr auto WATER_MASK_INDEX_FILLED = 4;
 
 
+// The mask texture is sampled based on the position in local pixel
+// coordinates, which works because water areas are always tile-aligned.
+// This way, the texture coordinates remain free for the cloak effect's
+// sprite, and both kinds of quads can share a shader.
+static_assert(WATER_ANIM_TEX_WIDTH == 8 && WATER_ANIM_TEX_HEIGHT == 64);
+
+
+// The 3rd vertex attribute selects which effects to apply to a quad, see
+// encodeEffect().
+//
 // Applying the transform gives us a position in normalized device
 // coordinates (from -1.0 to 1.0). For sampling the render target texture,
 // we need texture coordinates in the range 0.0 to 1.0, however.
@@ -66,22 +77,31 @@ constexpr auto WATER_MASK_INDEX_FILLED = 4;
 //
 // We assume that the texture is as large as the screen, therefore sampling
 // with the resulting tex coords should be equivalent to reading the pixel
-// located at 'position'.
-const char* VERTEX_SOURCE_WATER_EFFECT = R"shd(
+// located at 'position'. When drawing into a temporary buffer instead of
+// the screen, backgroundTransform maps positions to where they are on
+// screen, otherwise it's the same as transform.
+const char* VERTEX_SOURCE_EFFECTS = R"shd(
 ATTRIBUTE vec2 position;
 ATTRIBUTE vec2 texCoord;
+ATTRIBUTE float effect;
 
-OUT vec2 texCoordFrag;
-OUT vec2 texCoordMaskFrag;
+OUT vec2 texCoordBackgroundFrag;
+OUT vec2 texCoordSpriteFrag;
+OUT HIGHP vec2 localPositionFrag;
+OUT float effectFrag;
 
 uniform mat4 transform;
+uniform mat4 backgroundTransform;
 
 void main() {
   SET_POINT_SIZE(1.0);
   vec4 transformedPos = transform * vec4(position, 0.0, 1.0);
+  vec4 transformedPosForUv = backgroundTransform * vec4(position, 0.0, 1.0);
 
-  texCoordFrag = (transformedPos.xy + vec2(1.0, 1.0)) / 2.0;
-  texCoordMaskFrag = vec2(texCoord.x, 1.0 - texCoord.y);
+  texCoordBackgroundFrag = (transformedPosForUv.xy + vec2(1.0, 1.0)) / 2.0;
+  texCoordSpriteFrag = vec2(texCoord.x, 1.0 - texCoord.y);
+  localPositionFrag = position;
+  effectFrag = effect;
 
   gl_Position = transformedPos;
 }
@@ -90,132 +110,120 @@ void main() {
 
 // The original game runs in a palette-based video mode, where the frame
 // buffer stores indices into a palette of 16 colors instead of directly
-// storing color values. The water effect is implemented as a modification
-// of these index values in the frame buffer.
-// To replicate it, we first have to transform our RGBA color values into
+// storing color values. The water and cloak effects are implemented as
+// modifications of these index values in the frame buffer.
+// To replicate them, we first have to transform our RGBA color values into
 // indices, which we do with the help of the rgb to palette index map.
-// With the index, we then look up the corresponding "under water" color.
-const char* FRAGMENT_SOURCE_WATER_EFFECT = R"shd(
+// For water, we then look up the corresponding "under water" color with
+// the index. For cloaking, we look up the blended color for a combination
+// of background and sprite index.
+const char* FRAGMENT_SOURCE_EFFECTS = R"shd(
 DEFAULT_PRECISION_DECLARATION
 OUTPUT_COLOR_DECLARATION
 
-IN vec2 texCoordFrag;
-IN vec2 texCoordMaskFrag;
+IN vec2 texCoordBackgroundFrag;
+IN vec2 texCoordSpriteFrag;
+IN HIGHP vec2 localPositionFrag;
+IN float effectFrag;
 
-uniform sampler2D textureData;
-uniform sampler2D maskData;
+uniform sampler2D backgroundTextureData;
+uniform sampler2D spriteTextureData;
 uniform sampler2D rgbToPaletteIndexData;
+uniform sampler2D blendMapData;
+uniform sampler2D maskData;
 uniform sampler2D targetPaletteData;
 
 
-void main() {
-  vec4 color = TEXTURE_LOOKUP(textureData, texCoordFrag);
-  vec4 mask = TEXTURE_LOOKUP(maskData, texCoordMaskFrag);
-  float maskValue = mask.r;
-
-  vec4 quantizedRgb = floor(color * 16.0);
-  float rgbIndex =
+HIGHP float colorToPaletteIndex(vec4 color) {
+  HIGHP vec4 quantizedRgb = floor(color * 16.0);
+  HIGHP float rgbIndex =
     quantizedRgb.r * 16.0 * 16.0 +
     quantizedRgb.g * 16.0 +
     quantizedRgb.b;
-  vec2 lookupCoords = vec2(mod(rgbIndex, 64.0), rgbIndex / 64.0) / 64.0;
-  float mapValue = TEXTURE_LOOKUP(rgbToPaletteIndexData, lookupCoords).r * 256.0;
-
-  vec4 adjustedColor = vec4(
-    TEXTURE_LOOKUP(targetPaletteData, vec2(mapValue / 16.0, 0.0)).rgb,
-    color.a);
-
-  OUTPUT_COLOR = mix(color, adjustedColor, maskValue);
+  HIGHP vec2 lookupCoords = vec2(mod(rgbIndex, 64.0), rgbIndex / 64.0) / 64.0;
+  return TEXTURE_LOOKUP(rgbToPaletteIndexData, lookupCoords).r * 256.0;
 }
-)shd";
 
 
-constexpr auto WATER_EFFECT_TEXTURE_UNIT_NAMES = std::array{
-  "textureData",
-  "maskData",
-  "rgbToPaletteIndexData",
-  "targetPaletteData"};
+void main() {
+  float effect = floor(effectFrag + 0.5);
+  float maskIndex = mod(effect, 8.0) - 1.0;
 
-const renderer::ShaderSpec WATER_EFFECT_SHADER{
-  renderer::VertexLayout::PositionAndTexCoords,
-  WATER_EFFECT_TEXTURE_UNIT_NAMES,
-  VERTEX_SOURCE_WATER_EFFECT,
-  FRAGMENT_SOURCE_WATER_EFFECT};
+  vec4 color = TEXTURE_LOOKUP(backgroundTextureData, texCoordBackgroundFrag);
 
+  if (effect >= 8.0) {
+    vec4 sprite = TEXTURE_LOOKUP(spriteTextureData, texCoordSpriteFrag);
 
-const char* VERTEX_SOURCE_CLOAK_EFFECT = R"shd(
-ATTRIBUTE vec2 position;
-ATTRIBUTE vec2 texCoord;
+    HIGHP float index1 = colorToPaletteIndex(color);
+    HIGHP float index2 = colorToPaletteIndex(sprite);
 
-OUT vec2 texCoordBackgroundFrag;
-OUT vec2 texCoordFrag;
+    vec3 blendedColor =
+      TEXTURE_LOOKUP(blendMapData, vec2(index1, index2) / 16.0).rgb;
+    float blendedAlpha = sprite.a + 1.0 - color.a;
 
-uniform mat4 transform;
-uniform mat4 backgroundTransform;
+    color = vec4(blendedColor, blendedAlpha);
+  }
 
-void main() {
-  SET_POINT_SIZE(1.0);
-  vec4 transformedPosForUv = backgroundTransform * vec4(position, 0.0, 1.0);
+  if (maskIndex >= 0.0) {
+    HIGHP vec2 maskPixel = vec2(
+      mod(localPositionFrag.x, 8.0),
+      maskIndex * 8.0 + mod(localPositionFrag.y, 8.0));
+    vec2 maskCoords = vec2(maskPixel.x / 8.0, 1.0 - maskPixel.y / 64.0);
+    float maskValue = TEXTURE_LOOKUP(maskData, maskCoords).r;
 
-  texCoordBackgroundFrag = (transformedPosForUv.xy + vec2(1.0, 1.0)) / 2.0;
-  texCoordFrag = vec2(texCoord.x, 1.0 - texCoord.y);
+    HIGHP float index = colorToPaletteIndex(color);
+    vec4 adjustedColor = vec4(
+      TEXTURE_LOOKUP(targetPaletteData, vec2(index / 16.0, 0.0)).rgb,
+      color.a);
+
+    color = mix(color, adjustedColor, maskValue);
+  }
 
-  gl_Position = transform * vec4(position, 0.0, 1.0);
+  OUTPUT_COLOR = color;
 }
 )shd";
 
-const char* FRAGMENT_SOURCE_CLOAK_EFFECT = R"shd(
-DEFAULT_PRECISION_DECLARATION
-OUTPUT_COLOR_DECLARATION
-
-IN vec2 texCoordBackgroundFrag;
-IN vec2 texCoordFrag;
-
-uniform sampler2D backgroundTextureData;
-uniform sampler2D foregroundTextureData;
-uniform sampler2D rgbToPaletteIndexData;
-uniform sampler2D blendMapData;
-
-
-HIGHP float colorToPaletteIndex(vec4 color) {
-  HIGHP vec4 quantizedRgb = floor(color * 16.0);
-  HIGHP float rgbIndex =
-    quantizedRgb.r * 16.0 * 16.0 +
-    quantizedRgb.g * 16.0 +
-    quantizedRgb.b;
-  HIGHP vec2 lookupCoords = vec2(mod(rgbIndex, 64.0), rgbIndex / 64.0) / 64.0;
-  return TEXTURE_LOOKUP(rgbToPaletteIndexData, lookupCoords).r * 256.0;
-}
 
+constexpr auto EFFECT_TEXTURE_UNIT_NAMES = std::array{
+  "backgroundTextureData",
+  "spriteTextureData",
+  "rgbToPaletteIndexData",
+  "blendMapData",
+  "maskData",
+  "targetPaletteData"};
 
-void main() {
-  vec4 background = TEXTURE_LOOKUP(backgroundTextureData, texCoordBackgroundFrag);
-  vec4 foreground = TEXTURE_LOOKUP(foregroundTextureData, texCoordFrag);
+const renderer::ShaderSpec EFFECT_SHADER{
+  renderer::VertexLayout::PositionTexCoordsAndEffect,
+  EFFECT_TEXTURE_UNIT_NAMES,
+  VERTEX_SOURCE_EFFECTS,
+  FRAGMENT_SOURCE_EFFECTS};
 
-  HIGHP float index1 = colorToPaletteIndex(background);
-  HIGHP float index2 = colorToPaletteIndex(foreground);
 
-  vec3 blendedColor =
-    TEXTURE_LOOKUP(blendMapData, vec2(index1, index2) / 16.0).rgb;
+constexpr auto NO_WATER = -1;
+constexpr auto EFFECT_CLOAK_FLAG = 8;
 
-  float blendedAlpha = foreground.a + 1.0 - background.a;
 
-  OUTPUT_COLOR = vec4(blendedColor, blendedAlpha);
+/** Effect selector for the effect shader's 3rd vertex attribute
+ *
+ * 0 means no water, 1 to 5 select water mask 0 to 4. The cloak flag
+ * additionally applies the cloak effect, before applying water.
+ */
+int encodeEffect(const int maskIndex, const bool applyCloak)
+{
+  return maskIndex + 1 + (applyCloak ? EFFECT_CLOAK_FLAG : 0);
 }
-)shd";
 
 
-constexpr auto CLOAK_EFFECT_TEXTURE_UNIT_NAMES = std::array{
-  "backgroundTextureData",
-  "foregroundTextureData",
-  "rgbToPaletteIndexData",
-  "blendMapData"};
-
-const renderer::ShaderSpec CLOAK_EFFECT_SHADER{
-  renderer::VertexLayout::PositionAndTexCoords,
-  CLOAK_EFFECT_TEXTURE_UNIT_NAMES,
-  VERTEX_SOURCE_CLOAK_EFFECT,
-  FRAGMENT_SOURCE_CLOAK_EFFECT};
+void addEffectQuad(
+  std::vector<float>& vertices,
+  const renderer::TexCoords& texCoords,
+  const base::Rect<int>& destRect,
+  const int effect)
+{
+  const auto quad =
+    renderer::createMultiTexturedQuadVertices(texCoords, destRect, effect);
+  vertices.insert(vertices.end(), std::begin(quad), std::end(quad));
+}
 
 
 data::Image createWaterSurfaceAnimImage()
@@ -370,9 +378,9 @@ SpecialEffectsRenderer::SpecialEffectsRenderer(
   renderer::Renderer* pRenderer,
   const data::GameOptions& options)
   : mpRenderer(pRenderer)
-  , mWaterEffectShader(WATER_EFFECT_SHADER)
-  , mCloakEffectShader(CLOAK_EFFECT_SHADER)
-  , mBatch(&mWaterEffectShader)
+  , mEffectShader(
+      pRenderer->isHeadless() ? renderer::Shader::createInert(EFFECT_SHADER)
+                              : renderer::Shader(EFFECT_SHADER))
   , mBackgroundBuffer(
       renderer::createFullscreenRenderTarget(mpRenderer, options))
   , mWaterSurfaceAnimTexture(pRenderer, createWaterSurfaceAnimImage())
@@ -388,11 +396,27 @@ SpecialEffectsRenderer::SpecialEffectsRenderer(
 }
 
 
-void SpecialEffectsRenderer::rebuildBackgroundBuffer(
+void SpecialEffectsRenderer::updateBackgroundBuffer(
   const data::GameOptions& options)
 {
-  mBackgroundBuffer =
-    renderer::createFullscreenRenderTarget(mpRenderer, options);
+  renderer::updateRenderTargetSize(
+    mBackgroundBuffer,
+    mpRenderer,
+    renderer::fullscreenRenderTargetSize(mpRenderer, options));
+}
+
+
+base::ScopeGuard SpecialEffectsRenderer::bindBackgroundBuffer()
+{
+  mBackgroundBufferBound = true;
+
+  mpRenderer->pushState();
+  mpRenderer->setRenderTarget(mBackgroundBuffer.data());
+  return base::defer([this]() {
+    flushCloakEffects();
+    mpRenderer->popState();
+    mBackgroundBufferBound = false;
+  });
 }
 
 
@@ -405,68 +429,56 @@ void SpecialEffectsRenderer::drawBackgroundBuffer()
 }
 
 
-void SpecialEffectsRenderer::drawWaterEffect(
+void SpecialEffectsRenderer::drawEffects(
   base::ArrayView<WaterEffectArea> areas,
   int surfaceAnimationStep)
 {
-  if (areas.empty())
-  {
-    return;
-  }
-
   assert(surfaceAnimationStep >= 0 && surfaceAnimationStep < 4);
 
-  mBatch.reset();
-  mBatch.preAllocateSpace(areas.size());
-
-  auto addArea = [&](
-                   const base::Rect<int>& destRect,
-                   const int maskIndex,
-                   const int areaWidth) {
-    const auto maskTexStartY = maskIndex * WATER_MASK_HEIGHT;
-    const auto animSourceRect =
-      base::Rect<int>{{0, maskTexStartY}, {areaWidth, WATER_MASK_HEIGHT}};
-
-    mBatch.addQuad(
-      renderer::toTexCoords(
-        animSourceRect, WATER_ANIM_TEX_WIDTH, WATER_ANIM_TEX_HEIGHT),
-      destRect);
-  };
+  mWaterRegions.clear();
 
   for (const auto& areaSpec : areas)
   {
     const auto& area = areaSpec.mArea;
 
-    const auto areaWidth = area.size.width;
     if (areaSpec.mIsAnimated)
     {
       const auto waterSurfaceArea =
-        base::Rect<int>{area.topLeft, {areaWidth, WATER_MASK_HEIGHT}};
-
-      addArea(waterSurfaceArea, surfaceAnimationStep, areaWidth);
+        base::Rect<int>{area.topLeft, {area.size.width, WATER_MASK_HEIGHT}};
 
       auto remainingArea = area;
       remainingArea.topLeft.y += WATER_MASK_HEIGHT;
       remainingArea.size.height -= WATER_MASK_HEIGHT;
 
-      addArea(remainingArea, WATER_MASK_INDEX_FILLED, areaWidth);
+      mWaterRegions.push_back({waterSurfaceArea, surfaceAnimationStep});
+      mWaterRegions.push_back({remainingArea, WATER_MASK_INDEX_FILLED});
     }
     else
     {
-      addArea(area, WATER_MASK_INDEX_FILLED, areaWidth);
+      mWaterRegions.push_back({area, WATER_MASK_INDEX_FILLED});
     }
   }
 
-  mBatch.addTexture(mBackgroundBuffer.data());
-  mBatch.addTexture(mWaterSurfaceAnimTexture.data());
-  mBatch.addTexture(mRgbToPaletteIndexMap.data());
-  mBatch.addTexture(mWaterEffectPaletteTexture.data());
+  if (mWaterRegions.empty())
+  {
+    return;
+  }
 
-  mWaterEffectShader.use();
-  mWaterEffectShader.setUniform(
-    "transform", renderer::computeTransformationMatrix(mpRenderer));
+  mVertices.clear();
 
-  mpRenderer->drawCustomQuadBatch(mBatch.data());
+  for (const auto& region : mWaterRegions)
+  {
+    addEffectQuad(
+      mVertices,
+      {},
+      region.mArea,
+      encodeEffect(region.mMaskIndex, false));
+  }
+
+  // The sprite texture isn't sampled by water quads, but we still need
+  // to bind something valid
+  const auto transform = renderer::computeTransformationMatrix(mpRenderer);
+  submitEffects(mBackgroundBuffer.data(), transform, transform);
 }
 
 
@@ -475,42 +487,133 @@ void SpecialEffectsRenderer::drawCloakEffect(
   const renderer::TexCoords& texCoords,
   const base::Rect<int>& destRect) const
 {
+  if (!mBackgroundBufferBound)
+  {
+    mVertices.clear();
+    addEffectQuad(
+      mVertices, texCoords, destRect, encodeEffect(NO_WATER, true));
+
+    const auto transform = renderer::computeTransformationMatrix(mpRenderer);
+    submitEffects(textureId, transform, transform);
+    return;
+  }
+
+  // A sprite overlapping an earlier one of the same run needs to see that
+  // one in the background, so it starts a new run.
+  const auto translation = mpRenderer->globalTranslation();
+  const auto overlapsPending = std::any_of(
+    mPendingCloakEffects.begin(),
+    mPendingCloakEffects.end(),
+    [&](const PendingCloakEffect& effect) {
+      return effect.mDestRect.intersects(destRect);
+    });
+
+  if (overlapsPending || translation != mPendingCloakTranslation)
+  {
+    flushCloakEffects();
+  }
+
+  mPendingCloakEffects.push_back({textureId, texCoords, destRect});
+  mPendingCloakTranslation = translation;
+}
+
+
+void SpecialEffectsRenderer::flushCloakEffects() const
+{
+  if (mPendingCloakEffects.empty())
+  {
+    return;
+  }
+
+  // Sampling the background buffer while rendering into it doesn't work.
+  // The run is therefore drawn into a temporary buffer first, which is
+  // then drawn into the background buffer.
+  auto bounds = mPendingCloakEffects.front().mDestRect;
+  for (const auto& effect : mPendingCloakEffects)
+  {
+    bounds = base::unite(bounds, effect.mDestRect);
+  }
+
   if (
-    mCloakEffectTempBuffer.width() < destRect.size.width ||
-    mCloakEffectTempBuffer.height() < destRect.size.height)
+    mCloakEffectTempBuffer.width() < bounds.size.width ||
+    mCloakEffectTempBuffer.height() < bounds.size.height)
   {
     mCloakEffectTempBuffer = renderer::RenderTargetTexture(
-      mpRenderer, destRect.size.width, destRect.size.height);
+      mpRenderer, bounds.size.width, bounds.size.height);
   }
 
   const auto backgroundTransform = renderer::computeTransformationMatrix(
     mpRenderer->globalTranslation() +
-      renderer::scaleVec(destRect.topLeft, mpRenderer->globalScale()),
+      renderer::scaleVec(bounds.topLeft, mpRenderer->globalScale()),
     mpRenderer->globalScale(),
     mpRenderer->currentRenderTargetSize());
 
+  // Only one sprite texture can be bound per draw, so we need to group
+  // the run by texture. Sprites within a run don't overlap, so their
+  // order doesn't matter. Usually, there's only a single group.
+  std::sort(
+    mPendingCloakEffects.begin(),
+    mPendingCloakEffects.end(),
+    [](const PendingCloakEffect& lhs, const PendingCloakEffect& rhs) {
+      return lhs.mTextureId < rhs.mTextureId;
+    });
+
   {
     auto guard = mCloakEffectTempBuffer.bindAndReset();
     mpRenderer->clear({});
 
-    const auto textureIds = std::array{
-      mBackgroundBuffer.data(),
-      textureId,
-      mRgbToPaletteIndexMap.data(),
-      mCloakBlendMapTexture.data()};
-    const auto vertices =
-      renderer::createTexturedQuadVertices(texCoords, {{}, destRect.size});
-
-    mCloakEffectShader.use();
-    mCloakEffectShader.setUniform("backgroundTransform", backgroundTransform);
-    mCloakEffectShader.setUniform(
-      "transform", renderer::computeTransformationMatrix(mpRenderer));
-
-    mpRenderer->drawCustomQuadBatch(
-      {textureIds, vertices, &mCloakEffectShader});
+    const auto transform = renderer::computeTransformationMatrix(mpRenderer);
+
+    auto iGroupStart = mPendingCloakEffects.begin();
+    while (iGroupStart != mPendingCloakEffects.end())
+    {
+      const auto textureId = iGroupStart->mTextureId;
+      const auto iGroupEnd = std::find_if(
+        iGroupStart,
+        mPendingCloakEffects.end(),
+        [&](const PendingCloakEffect& effect) {
+          return effect.mTextureId != textureId;
+        });
+
+      mVertices.clear();
+      for (auto it = iGroupStart; it != iGroupEnd; ++it)
+      {
+        addEffectQuad(
+          mVertices,
+          it->mTexCoords,
+          base::Rect<int>{
+            it->mDestRect.topLeft - bounds.topLeft, it->mDestRect.size},
+          encodeEffect(NO_WATER, true));
+      }
+
+      submitEffects(textureId, transform, backgroundTransform);
+      iGroupStart = iGroupEnd;
+    }
   }
 
-  mCloakEffectTempBuffer.render(destRect.topLeft);
+  mCloakEffectTempBuffer.render(bounds.topLeft);
+  mPendingCloakEffects.clear();
+}
+
+
+void SpecialEffectsRenderer::submitEffects(
+  const renderer::TextureId spriteTextureId,
+  const glm::mat4& transform,
+  const glm::mat4& backgroundTransform) const
+{
+  const auto textureIds = std::array{
+    mBackgroundBuffer.data(),
+    spriteTextureId,
+    mRgbToPaletteIndexMap.data(),
+    mCloakBlendMapTexture.data(),
+    mWaterSurfaceAnimTexture.data(),
+    mWaterEffectPaletteTexture.data()};
+
+  mEffectShader.use();
+  mEffectShader.setUniform("transform", transform);
+  mEffectShader.setUniform("backgroundTransform", backgroundTransform);
+
+  mpRenderer->drawCustomQuadBatch({textureIds, mVertices, &mEffectShader});
 }
 
 } // namespace rigel::engine
@@ -16,10 +16,13 @@
 
 #pragma once
 
-#include "renderer/custom_quad_batch.hpp"
+#include "base/defer.hpp"
+#include "renderer/renderer_support.hpp"
 #include "renderer/shader.hpp"
 #include "renderer/texture.hpp"
 
+#include <vector>
+
 
 namespace rigel::data
 {
@@ -48,11 +51,27 @@ public:
     renderer::Renderer* pRenderer,
     const data::GameOptions& options);
 
-  void rebuildBackgroundBuffer(const data::GameOptions& options);
-  [[nodiscard]] auto bindBackgroundBuffer() { return mBackgroundBuffer.bind(); }
+  /** Recreate the background buffer if its size no longer fits
+   *
+   * Cheap when nothing has changed, meant to be called every frame.
+   */
+  void updateBackgroundBuffer(const data::GameOptions& options);
+
+  /** Bind the background buffer as render target
+   *
+   * Cloak effects drawn while the buffer is bound are collected into runs
+   * of consecutive cloaked sprites, see flushCloakEffects(). Any pending
+   * run is drawn when the returned guard goes out of scope.
+   */
+  [[nodiscard]] base::ScopeGuard bindBackgroundBuffer();
   void drawBackgroundBuffer();
 
-  void drawWaterEffect(
+  /** Apply water areas in a single draw
+   *
+   * Samples the background buffer, so this should be called after
+   * drawBackgroundBuffer().
+   */
+  void drawEffects(
     base::ArrayView<WaterEffectArea> areas,
     int surfaceAnimationStep);
 
@@ -61,17 +80,48 @@ public:
     const renderer::TexCoords& texCoords,
     const base::Rect<int>& destRect) const;
 
+  /** Draw the current run of cloak effects
+   *
+   * While the background buffer is bound, consecutive cloak effects are
+   * batched, and drawn with a single round trip through a temporary
+   * buffer. Callers must flush before drawing anything that isn't a cloak
+   * effect, so that sprites keep their order.
+   */
+  void flushCloakEffects() const;
+
 private:
+  struct PendingCloakEffect
+  {
+    renderer::TextureId mTextureId;
+    renderer::TexCoords mTexCoords;
+    base::Rect<int> mDestRect;
+  };
+
+  struct WaterRegion
+  {
+    base::Rect<int> mArea;
+    int mMaskIndex;
+  };
+
+  void submitEffects(
+    renderer::TextureId spriteTextureId,
+    const glm::mat4& transform,
+    const glm::mat4& backgroundTransform) const;
+
   renderer::Renderer* mpRenderer;
-  renderer::Shader mWaterEffectShader;
-  renderer::Shader mCloakEffectShader;
-  renderer::CustomQuadBatch mBatch;
+  renderer::Shader mEffectShader;
   renderer::RenderTargetTexture mBackgroundBuffer;
   mutable renderer::RenderTargetTexture mCloakEffectTempBuffer;
   renderer::Texture mWaterSurfaceAnimTexture;
   renderer::Texture mWaterEffectPaletteTexture;
   renderer::Texture mCloakBlendMapTexture;
   renderer::MonoTexture mRgbToPaletteIndexMap;
+
+  mutable std::vector<PendingCloakEffect> mPendingCloakEffects;
+  mutable base::Vec2 mPendingCloakTranslation;
+  mutable std::vector<float> mVertices;
+  std::vector<WaterRegion> mWaterRegions;
+  bool mBackgroundBufferBound = false;
 };
 
 } // namespace rigel::engine
@@ -16,6 +16,7 @@
 
 #pragma once
 
+#include "base/array_view.hpp"
 #include "base/spatial_types.hpp"
 #include "data/actor_ids.hpp"
 #include "engine/visual_components.hpp"
@@ -32,6 +33,18 @@ struct ISpriteFactory
   virtual base::Rect<int> actorFrameRect(data::ActorID id, int frame) const = 0;
   virtual engine::SpriteFrame
     actorFrameData(data::ActorID id, int frame) const = 0;
+
+  /** Hint that the given actors are about to be used
+   *
+   * Called with the actor list of a level before it starts. Factories which
+   * load sprite images on demand can use this to load everything the level
+   * needs upfront, and to release sprites used by the previous level.
+   *
+   * Afterwards, createSprite() and actorFrameRect() must be safe to call
+   * concurrently for the given actors, since level entities are prepared on
+   * multiple threads (see EntityFactory::createEntitiesForLevel()).
+   */
+  virtual void prefetchActors(base::ArrayView<data::ActorID> ids) {}
 };
 
 } // namespace rigel::engine
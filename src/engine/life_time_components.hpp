@@ -18,6 +18,7 @@
 
 #include "engine/base_components.hpp"
 
+#include <cstdint>
 #include <initializer_list>
 
 
@@ -56,7 +57,13 @@ struct AutoDestroy
   }
 
   int mConditionFlags = 0;
+
+  /** For OnTimeoutElapsed: Number of updates the entity survives */
   int mFramesToLive = 0;
+
+  // Set by the LifeTimeSystem when it first sees the component. Kept in the
+  // component so that it's carried over when entities are copied.
+  std::uint32_t mExpiresOnUpdate = 0;
 };
 
 } // namespace rigel::engine::components
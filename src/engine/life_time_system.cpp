@@ -18,60 +18,218 @@
 
 #include "engine/physical_components.hpp"
 
+#include <algorithm>
+
 
 namespace rigel::engine
 {
 
+namespace c = components;
+using Condition = components::AutoDestroy::Condition;
+
+
+namespace
+{
+
+bool conditionIsSet(const c::AutoDestroy& properties, const Condition condition)
+{
+  return (properties.mConditionFlags & static_cast<int>(condition)) != 0;
+}
+
+
+bool hasNonTimeoutCondition(const c::AutoDestroy& properties)
+{
+  return conditionIsSet(properties, Condition::OnWorldCollision) ||
+    conditionIsSet(properties, Condition::OnLeavingActiveRegion);
+}
+
+
+bool isIndexLess(const entityx::Entity& lhs, const entityx::Entity& rhs)
+{
+  return lhs.id().index() < rhs.id().index();
+}
+
+} // namespace
+
+
+LifeTimeSystem::LifeTimeSystem(entityx::EventManager& events)
+{
+  events.subscribe<entityx::ComponentAddedEvent<c::AutoDestroy>>(*this);
+}
+
+
 void LifeTimeSystem::update(
   entityx::EntityManager& es,
   const base::Vec2& cameraPosition,
   const base::Size& viewportSize)
 {
-  namespace c = components;
-  using Condition = components::AutoDestroy::Condition;
-
-  es.each<c::AutoDestroy>(
-    [&](entityx::Entity entity, c::AutoDestroy& autoDestroyProperties) {
-      auto entityIsOnScreen = [&]() {
-        if (
-          entity.has_component<c::WorldPosition>() &&
-          entity.has_component<c::BoundingBox>())
-        {
-          const auto& position = *entity.component<c::WorldPosition>();
-          const auto& bbox = *entity.component<c::BoundingBox>();
-          return engine::isOnScreen(
-            engine::toWorldSpace(bbox, position), cameraPosition, viewportSize);
-        }
-
-        return entity.has_component<c::Active>() &&
-          entity.component<c::Active>()->mIsOnScreen;
-      };
-
-      const auto flags = autoDestroyProperties.mConditionFlags;
-
-      const auto conditionIsSet = [&flags](const Condition condition) {
-        const auto conditionValue = static_cast<int>(condition);
-        return (flags & conditionValue) != 0;
-      };
-
-      const auto hasTimeout = conditionIsSet(Condition::OnTimeoutElapsed);
-      if (hasTimeout)
-      {
-        --autoDestroyProperties.mFramesToLive;
-      }
-
-      const auto mustDestroy =
-        (conditionIsSet(Condition::OnWorldCollision) &&
-         entity.has_component<components::CollidedWithWorld>()) ||
-        (conditionIsSet(Condition::OnLeavingActiveRegion) &&
-         !entityIsOnScreen()) ||
-        (hasTimeout && autoDestroyProperties.mFramesToLive < 0);
-
-      if (mustDestroy)
-      {
-        entity.destroy();
-      }
-    });
+  ++mUpdateCount;
+
+  mEntitiesToDestroy.clear();
+  collectExpiredEntities();
+  collectEntitiesMeetingConditions(cameraPosition, viewportSize);
+
+  // An entity can be found more than once, e.g. if its AutoDestroy was
+  // replaced with an identical one.
+  std::sort(
+    mEntitiesToDestroy.begin(), mEntitiesToDestroy.end(), isIndexLess);
+  mEntitiesToDestroy.erase(
+    std::unique(mEntitiesToDestroy.begin(), mEntitiesToDestroy.end()),
+    mEntitiesToDestroy.end());
+
+  for (auto entity : mEntitiesToDestroy)
+  {
+    es.destroy(entity.id());
+  }
+}
+
+
+void LifeTimeSystem::synchronizeTo(const LifeTimeSystem& other)
+{
+  for (auto& slot : mWheel)
+  {
+    slot.clear();
+  }
+
+  mDistantEntities.clear();
+  mConditionalEntities.clear();
+  mUpdateCount = other.mUpdateCount;
+}
+
+
+void LifeTimeSystem::receive(
+  const entityx::ComponentAddedEvent<c::AutoDestroy>& event)
+{
+  auto component = event.component;
+  auto& properties = *component;
+
+  if (hasNonTimeoutCondition(properties))
+  {
+    mConditionalEntities.push_back(event.entity);
+  }
+
+  if (conditionIsSet(properties, Condition::OnTimeoutElapsed))
+  {
+    // The timeout is decremented on each update, and the entity destroyed
+    // once it goes below zero. Entities which were copied from another
+    // world state already know their expiry time.
+    if (properties.mExpiresOnUpdate == 0)
+    {
+      properties.mExpiresOnUpdate =
+        mUpdateCount + std::uint32_t(std::max(properties.mFramesToLive, 0)) +
+        1;
+    }
+
+    schedule({event.entity, properties.mExpiresOnUpdate});
+  }
+}
+
+
+void LifeTimeSystem::schedule(const ScheduledEntity& entry)
+{
+  // Shouldn't happen, but in case it does, expire on the next update
+  const auto expiresOnUpdate =
+    std::max(entry.mExpiresOnUpdate, mUpdateCount + 1);
+
+  if (expiresOnUpdate - mUpdateCount < WHEEL_SIZE)
+  {
+    mWheel[expiresOnUpdate % WHEEL_SIZE].push_back(
+      {entry.mEntity, expiresOnUpdate});
+  }
+  else
+  {
+    mDistantEntities.push_back({entry.mEntity, expiresOnUpdate});
+  }
+}
+
+
+void LifeTimeSystem::collectExpiredEntities()
+{
+  // Once per revolution, move everything that's due within the next
+  // revolution into the wheel.
+  if (mUpdateCount % WHEEL_SIZE == 0)
+  {
+    const auto iFirstDistant = std::partition(
+      mDistantEntities.begin(),
+      mDistantEntities.end(),
+      [this](const ScheduledEntity& entry) {
+        return entry.mExpiresOnUpdate - mUpdateCount < WHEEL_SIZE;
+      });
+
+    for (auto iEntry = mDistantEntities.begin(); iEntry != iFirstDistant;
+         ++iEntry)
+    {
+      mWheel[iEntry->mExpiresOnUpdate % WHEEL_SIZE].push_back(*iEntry);
+    }
+
+    mDistantEntities.erase(mDistantEntities.begin(), iFirstDistant);
+  }
+
+  auto& slot = mWheel[mUpdateCount % WHEEL_SIZE];
+  for (auto& entry : slot)
+  {
+    // The entity might have been destroyed in the meantime, or its
+    // AutoDestroy removed or replaced.
+    auto entity = entry.mEntity;
+    if (
+      entity.valid() && entity.has_component<c::AutoDestroy>() &&
+      entity.component<c::AutoDestroy>()->mExpiresOnUpdate ==
+        entry.mExpiresOnUpdate)
+    {
+      mEntitiesToDestroy.push_back(entity);
+    }
+  }
+
+  slot.clear();
+}
+
+
+void LifeTimeSystem::collectEntitiesMeetingConditions(
+  const base::Vec2& cameraPosition,
+  const base::Size& viewportSize)
+{
+  auto entityIsOnScreen = [&](entityx::Entity entity) {
+    if (
+      entity.has_component<c::WorldPosition>() &&
+      entity.has_component<c::BoundingBox>())
+    {
+      const auto& position = *entity.component<c::WorldPosition>();
+      const auto& bbox = *entity.component<c::BoundingBox>();
+      return engine::isOnScreen(
+        engine::toWorldSpace(bbox, position), cameraPosition, viewportSize);
+    }
+
+    return entity.has_component<c::Active>() &&
+      entity.component<c::Active>()->mIsOnScreen;
+  };
+
+  auto isStillConditional = [](entityx::Entity entity) {
+    return entity.valid() && entity.has_component<c::AutoDestroy>() &&
+      hasNonTimeoutCondition(*entity.component<c::AutoDestroy>());
+  };
+
+  mConditionalEntities.erase(
+    std::remove_if(
+      mConditionalEntities.begin(),
+      mConditionalEntities.end(),
+      [&](entityx::Entity entity) { return !isStillConditional(entity); }),
+    mConditionalEntities.end());
+
+  for (auto entity : mConditionalEntities)
+  {
+    const auto& properties = *entity.component<c::AutoDestroy>();
+
+    const auto mustDestroy =
+      (conditionIsSet(properties, Condition::OnWorldCollision) &&
+       entity.has_component<c::CollidedWithWorld>()) ||
+      (conditionIsSet(properties, Condition::OnLeavingActiveRegion) &&
+       !entityIsOnScreen(entity));
+
+    if (mustDestroy)
+    {
+      mEntitiesToDestroy.push_back(entity);
+    }
+  }
 }
 
 } // namespace rigel::engine
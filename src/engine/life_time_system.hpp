@@ -17,23 +17,77 @@
 #pragma once
 
 #include "base/spatial_types.hpp"
+#include "base/warnings.hpp"
 #include "engine/life_time_components.hpp"
 
 RIGEL_DISABLE_WARNINGS
 #include <entityx/entityx.h>
 RIGEL_RESTORE_WARNINGS
 
+#include <array>
+#include <cstdint>
+#include <vector>
+
 
 namespace rigel::engine
 {
 
-class LifeTimeSystem
+/** Destroys entities once the condition in their AutoDestroy is met
+ *
+ * Entities are picked up via component events when their AutoDestroy is
+ * assigned, so update() never needs to visit all entities. Timeouts are
+ * kept in a two-level timing wheel keyed by the update on which they expire,
+ * so each update only looks at the entities expiring right then. Entities
+ * with one of the other conditions are kept in a list that's checked on
+ * every update.
+ *
+ * Entities are destroyed in order of their index, same as a sweep over
+ * all entities would.
+ */
+class LifeTimeSystem : public entityx::Receiver<LifeTimeSystem>
 {
 public:
+  explicit LifeTimeSystem(entityx::EventManager& events);
+
   void update(
     entityx::EntityManager& es,
     const base::Vec2& cameraPosition,
     const base::Size& viewportSize);
+
+  /** Take over other's update count, and forget all known entities
+   *
+   * Meant to be called before replacing all entities with copies of those
+   * in other's entity manager. The copies are then picked up again via
+   * component events, with their original expiry times.
+   */
+  void synchronizeTo(const LifeTimeSystem& other);
+
+  void receive(
+    const entityx::ComponentAddedEvent<components::AutoDestroy>& event);
+
+private:
+  struct ScheduledEntity
+  {
+    entityx::Entity mEntity;
+    std::uint32_t mExpiresOnUpdate;
+  };
+
+  static constexpr auto WHEEL_SIZE = std::uint32_t{128};
+
+  void schedule(const ScheduledEntity& entry);
+  void collectExpiredEntities();
+  void collectEntitiesMeetingConditions(
+    const base::Vec2& cameraPosition,
+    const base::Size& viewportSize);
+
+  // Slot i holds entities expiring on an update u with u % WHEEL_SIZE == i,
+  // within the next WHEEL_SIZE updates. Anything further in the future is
+  // in mDistantEntities, and moved into the wheel once per revolution.
+  std::array<std::vector<ScheduledEntity>, WHEEL_SIZE> mWheel;
+  std::vector<ScheduledEntity> mDistantEntities;
+  std::vector<entityx::Entity> mConditionalEntities;
+  std::vector<entityx::Entity> mEntitiesToDestroy;
+  std::uint32_t mUpdateCount = 0;
 };
 
 } // namespace rigel::engine
@@ -16,15 +16,21 @@
 
 #include "map_renderer.hpp"
 
+#include "base/grid.hpp"
 #include "base/math_utils.hpp"
+#include "base/parallel.hpp"
 #include "base/static_vector.hpp"
 #include "data/game_traits.hpp"
 #include "data/unit_conversions.hpp"
+#include "renderer/custom_quad_batch.hpp"
 #include "renderer/vertex_buffer_utils.hpp"
 #include "renderer/viewport_utils.hpp"
 
+#include <algorithm>
 #include <cfenv>
+#include <cstdlib>
 #include <iostream>
+#include <optional>
 
 
 namespace rigel::engine
@@ -52,60 +58,167 @@ const auto AUTO_SCROLL_PX_PER_SECOND_HORIZONTAL = 30.0f;
 const auto AUTO_SCROLL_PX_PER_SECOND_VERTICAL = 60.0f;
 
 
+// Animated tiles are part of the static block vertex buffers, with frame
+// selection happening in the vertex shader. To make that possible, each
+// vertex carries an additional attribute encoding the animation type
+// (0 = not animated, 1 = slow, 2 = fast) and the tile's column in the tile
+// set as `type + column * 4`. The shader offsets the texture coordinates by
+// the current frame of the respective animation, moving on to the next row
+// of the tile set if an animation crosses the end of a row.
+const char* VERTEX_SOURCE_TILES = R"shd(
+ATTRIBUTE HIGHP vec2 position;
+ATTRIBUTE HIGHP vec2 texCoord;
+ATTRIBUTE HIGHP float animation;
+
+OUT HIGHP vec2 texCoordFrag;
+
+uniform mat4 transform;
+uniform vec2 animationOffsets;
+uniform vec2 tileSize;
+uniform float tilesPerRow;
+
+void main() {
+  HIGHP float type = mod(animation, 4.0);
+  HIGHP float column = floor(animation / 4.0);
+  HIGHP float offset =
+    type > 1.5 ? animationOffsets.y : (type > 0.5 ? animationOffsets.x : 0.0);
+  HIGHP float rowsToAdvance = floor((column + offset) / tilesPerRow);
+
+  HIGHP vec2 animatedTexCoord = texCoord +
+    vec2(offset - rowsToAdvance * tilesPerRow, rowsToAdvance) * tileSize;
+
+  gl_Position = transform * vec4(position, 0.0, 1.0);
+  texCoordFrag = vec2(animatedTexCoord.x, 1.0 - animatedTexCoord.y);
+}
+)shd";
+
+const char* FRAGMENT_SOURCE_TILES = R"shd(
+DEFAULT_PRECISION_DECLARATION
+OUTPUT_COLOR_DECLARATION
+
+IN HIGHP vec2 texCoordFrag;
+
+uniform sampler2D textureData;
+
+void main() {
+  OUTPUT_COLOR = TEXTURE_LOOKUP(textureData, texCoordFrag);
+}
+)shd";
+
+constexpr auto TILE_SHADER_TEXTURE_UNIT_NAMES = std::array{"textureData"};
+
+const renderer::ShaderSpec TILE_SHADER{
+  renderer::VertexLayout::CompactPositionTexCoordsAndAnimation,
+  TILE_SHADER_TEXTURE_UNIT_NAMES,
+  VERTEX_SOURCE_TILES,
+  FRAGMENT_SOURCE_TILES};
+
+
+// Block buffers make up most of the vertex data kept on the GPU, so they use
+// the compact vertex format.
+//
+// Unlike the sprite batch, they don't use instancing. Their vertices are
+// uploaded once per level and then only patched for tiles that change, so
+// there is no per-frame upload that a more compact instance record could
+// shrink. Tiles which are drawn individually instead, via
+// renderSingleTile(), go through Renderer::drawTexture() and thus already
+// use the instanced sprite batch where available.
+using TileVertices = renderer::CompactQuadVertices;
+
+constexpr auto VERTICES_PER_QUAD = std::tuple_size<TileVertices>::value;
+
+
+TileVertices createTileVertices(
+  const map::TileIndex tileIndex,
+  const int x,
+  const int y,
+  const data::map::Map& map,
+  const TiledTexture& tileSetTexture)
+{
+  const auto animationType =
+    static_cast<int>(map.attributeDict().animationType(tileIndex));
+  const auto column = int(tileIndex) % tileSetTexture.tilesPerRow();
+
+  return renderer::createCompactQuadVertices(
+    tileSetTexture.tileTexCoords(tileIndex),
+    {tilesToPixels(base::Vec2{x, y}), tilesToPixels(base::Size{1, 1})},
+    animationType + column * 4);
+}
+
+
 struct TileBlockData
 {
-  std::vector<float> mVertices;
-  std::vector<AnimatedTile> mAnimatedTiles;
+  std::vector<renderer::CompactVertex> mVertices;
+  std::vector<std::uint16_t> mQuadSlots;
 };
 
 
-std::array<TileBlockData, 2> createBlockData(
+std::size_t
+  quadSlotIndex(const int mapLayer, const int xInBlock, const int yInBlock)
+{
+  return mapLayer * BLOCK_SIZE * BLOCK_SIZE + yInBlock * BLOCK_SIZE + xInBlock;
+}
+
+
+std::size_t blockIndexFor(const base::Vec2& position, const int blocksPerRow)
+{
+  return position.x / BLOCK_SIZE + position.y / BLOCK_SIZE * blocksPerRow;
+}
+
+
+using BlockData = std::array<TileBlockData, 2>;
+
+
+BlockData createBlockData(
   const int blockX,
   const int blockY,
   const data::map::Map& map,
   const TiledTexture& tileSetTexture)
 {
-  auto blockData = std::array<TileBlockData, 2>{};
+  auto blockData = BlockData{};
 
   const auto blockStartX = blockX * BLOCK_SIZE;
   const auto blockEndX = (blockX + 1) * BLOCK_SIZE;
   const auto blockStartY = blockY * BLOCK_SIZE;
   const auto blockEndY = (blockY + 1) * BLOCK_SIZE;
 
+  for (auto& data : blockData)
+  {
+    data.mQuadSlots.resize(2 * BLOCK_SIZE * BLOCK_SIZE, NO_QUAD);
+  }
 
-  auto addToBlock =
-    [&](const map::TileIndex tileIndex, const int x, const int y) {
-      if (tileIndex == 0)
-      {
-        return;
-      }
 
-      const auto isForeground =
-        map.attributeDict().attributes(tileIndex).isForeGround();
-      const auto targetIndex = isForeground ? 1 : 0;
-      auto& targetBlockData = blockData[targetIndex];
+  auto addToBlock = [&](
+                      const map::TileIndex tileIndex,
+                      const int mapLayer,
+                      const int x,
+                      const int y) {
+    if (tileIndex == 0)
+    {
+      return;
+    }
 
-      const auto isAnimated =
-        map.attributeDict().attributes(tileIndex).isAnimated();
-      if (isAnimated)
-      {
-        targetBlockData.mAnimatedTiles.push_back({{x, y}, tileIndex});
-      }
-      else
-      {
-        const auto vertices = tileSetTexture.generateVertices(tileIndex, x, y);
-        targetBlockData.mVertices.insert(
-          targetBlockData.mVertices.end(), vertices.begin(), vertices.end());
-      }
-    };
+    const auto isForeground = map.attributeDict().isForeGround(tileIndex);
+    const auto targetIndex = isForeground ? 1 : 0;
+    auto& targetBlockData = blockData[targetIndex];
+
+    targetBlockData
+      .mQuadSlots[quadSlotIndex(mapLayer, x - blockStartX, y - blockStartY)] =
+      std::uint16_t(targetBlockData.mVertices.size() / VERTICES_PER_QUAD);
+
+    const auto vertices =
+      createTileVertices(tileIndex, x, y, map, tileSetTexture);
+    targetBlockData.mVertices.insert(
+      targetBlockData.mVertices.end(), vertices.begin(), vertices.end());
+  };
 
 
   for (auto y = blockStartY; y < blockEndY && y < map.height(); ++y)
   {
     for (auto x = blockStartX; x < blockEndX && x < map.width(); ++x)
     {
-      addToBlock(map.tileAt(0, x, y), x, y);
-      addToBlock(map.tileAt(1, x, y), x, y);
+      addToBlock(map.tileAt(0, x, y), 0, x, y);
+      addToBlock(map.tileAt(1, x, y), 1, x, y);
     }
   }
 
@@ -113,27 +226,69 @@ std::array<TileBlockData, 2> createBlockData(
 }
 
 
+void updateNonEmptyBlocks(TileRenderData& renderData, const size_t blockIndex)
+{
+  for (auto layer = 0; layer < 2; ++layer)
+  {
+    renderData.mNonEmptyBlocks[layer].set(
+      blockIndex,
+      renderData.mLayers[layer][blockIndex].mTilesBuffer !=
+        renderer::INVALID_VERTEX_BUFFER_ID);
+  }
+}
+
+
+TileBlock createTileBlock(TileBlockData&& data, renderer::Renderer* pRenderer)
+{
+  if (data.mVertices.empty())
+  {
+    return {renderer::INVALID_VERTEX_BUFFER_ID, {}, {}};
+  }
+
+  const auto bytes = data.mVertices.size() * sizeof(renderer::CompactVertex) +
+    data.mQuadSlots.size() * sizeof(std::uint16_t);
+
+  return {
+    pRenderer->createCompactVertexBuffer(data.mVertices),
+    std::move(data.mQuadSlots),
+    base::TrackedMemory{base::MemoryCategory::MapBlocks, bytes}};
+}
+
+
 void buildBlock(
-  const int blockX,
-  const int blockY,
+  BlockData&& blockData,
   TileRenderData& renderData,
-  const data::map::Map& map,
-  const TiledTexture& tileSetTexture,
   renderer::Renderer* pRenderer)
 {
-  const auto blockData = createBlockData(blockX, blockY, map, tileSetTexture);
+  for (auto layer = 0; layer < 2; ++layer)
+  {
+    renderData.mLayers[layer].push_back(
+      createTileBlock(std::move(blockData[layer]), pRenderer));
+  }
+
+  updateNonEmptyBlocks(renderData, renderData.mLayers[0].size() - 1);
+}
 
+
+void replaceBlock(
+  TileRenderData& renderData,
+  BlockData&& blockData,
+  renderer::Renderer* pRenderer,
+  const size_t blockIndex)
+{
   for (auto layer = 0; layer < 2; ++layer)
   {
-    auto& data = blockData[layer];
+    auto& block = renderData.mLayers[layer][blockIndex];
 
-    auto buffer = data.mVertices.empty()
-      ? renderer::INVALID_VERTEX_BUFFER_ID
-      : pRenderer->createVertexBuffer(data.mVertices);
+    if (block.mTilesBuffer != renderer::INVALID_VERTEX_BUFFER_ID)
+    {
+      renderData.mpRenderer->destroyVertexBuffer(block.mTilesBuffer);
+    }
 
-    renderData.mLayers[layer].push_back(
-      {buffer, std::move(data.mAnimatedTiles)});
+    block = createTileBlock(std::move(blockData[layer]), pRenderer);
   }
+
+  updateNonEmptyBlocks(renderData, blockIndex);
 }
 
 
@@ -147,25 +302,100 @@ void rebuildBlock(
   const auto blockX = int(blockIndex) % renderData.mSize.width;
   const auto blockY = int(blockIndex) / renderData.mSize.width;
 
-  const auto blockData = createBlockData(blockX, blockY, map, tileSetTexture);
+  replaceBlock(
+    renderData,
+    createBlockData(blockX, blockY, map, tileSetTexture),
+    pRenderer,
+    blockIndex);
+}
+
 
-  for (auto layer = 0; layer < 2; ++layer)
+/** Update a single tile's quads in place
+ *
+ * Only possible if the tile's quads already have a place in the block's
+ * vertex buffer. Quads of tiles which have been removed are replaced with
+ * degenerate ones, but keep their place in the buffer. This way, a tile
+ * can be changed any number of times without needing a rebuild.
+ *
+ * Returns false if the block needs to be rebuilt instead.
+ */
+bool updateTileInBlock(
+  TileRenderData& renderData,
+  const data::map::Map& map,
+  const TiledTexture& tileSetTexture,
+  renderer::Renderer* pRenderer,
+  const base::Vec2& position,
+  const size_t blockIndex)
+{
+  const auto xInBlock = position.x % BLOCK_SIZE;
+  const auto yInBlock = position.y % BLOCK_SIZE;
+
+  for (auto mapLayer = 0; mapLayer < 2; ++mapLayer)
   {
-    auto& data = blockData[layer];
+    const auto tileIndex = map.tileAt(mapLayer, position.x, position.y);
+    const auto targetLayer =
+      map.attributeDict().isForeGround(tileIndex) ? 1 : 0;
+    const auto slotIndex = quadSlotIndex(mapLayer, xInBlock, yInBlock);
 
-    auto buffer = data.mVertices.empty()
-      ? renderer::INVALID_VERTEX_BUFFER_ID
-      : pRenderer->createVertexBuffer(data.mVertices);
+    for (auto layer = 0; layer < 2; ++layer)
+    {
+      auto& block = renderData.mLayers[layer][blockIndex];
+      const auto needsQuad = tileIndex != 0 && layer == targetLayer;
+      const auto slot =
+        block.mQuadSlots.empty() ? NO_QUAD : block.mQuadSlots[slotIndex];
 
-    auto& block = renderData.mLayers[layer][blockIndex];
+      if (slot == NO_QUAD)
+      {
+        if (needsQuad)
+        {
+          return false;
+        }
+
+        continue;
+      }
+
+      const auto vertices = needsQuad
+        ? createTileVertices(
+            tileIndex, position.x, position.y, map, tileSetTexture)
+        : TileVertices{};
+      pRenderer->updateCompactVertexBuffer(
+        block.mTilesBuffer, slot * VERTICES_PER_QUAD, vertices);
+    }
+  }
+
+  return true;
+}
+
+
+void releaseBlock(TileRenderData& renderData, const size_t blockIndex)
+{
+  for (auto& layer : renderData.mLayers)
+  {
+    auto& block = layer[blockIndex];
 
     if (block.mTilesBuffer != renderer::INVALID_VERTEX_BUFFER_ID)
     {
       renderData.mpRenderer->destroyVertexBuffer(block.mTilesBuffer);
     }
 
-    block = {buffer, std::move(data.mAnimatedTiles)};
+    block = {renderer::INVALID_VERTEX_BUFFER_ID, {}, {}};
   }
+
+  updateNonEmptyBlocks(renderData, blockIndex);
+}
+
+
+TileRenderData
+  createEmptyRenderData(const base::Size& size, renderer::Renderer* pRenderer)
+{
+  TileRenderData result{size, pRenderer};
+
+  for (auto& layer : result.mLayers)
+  {
+    layer.resize(size.width * size.height);
+  }
+
+  return result;
 }
 
 
@@ -179,11 +409,24 @@ TileRenderData buildRenderData(
 
   TileRenderData result{{numBlocksX, numBlocksY}, pRenderer};
 
+  // Generating the vertices is done in parallel, one row of blocks per
+  // task. Only creating the vertex buffers needs to happen on this thread.
+  base::Grid<BlockData> blockData(numBlocksX, numBlocksY);
+  base::parallelFor(blockData.height(), [&](const std::size_t blockY) {
+    auto pRowData = blockData.rowData(blockY);
+    for (auto blockX = 0; blockX < numBlocksX; ++blockX)
+    {
+      pRowData[blockX] =
+        createBlockData(blockX, int(blockY), map, tileSetTexture);
+    }
+  });
+
   for (auto blockY = 0; blockY < numBlocksY; ++blockY)
   {
     for (auto blockX = 0; blockX < numBlocksX; ++blockX)
     {
-      buildBlock(blockX, blockY, result, map, tileSetTexture, pRenderer);
+      buildBlock(
+        std::move(blockData.valueAt(blockX, blockY)), result, pRenderer);
     }
   }
 
@@ -191,6 +434,115 @@ TileRenderData buildRenderData(
 }
 
 
+PackedTileData packedTileAt(const data::map::Map& map, const int x, const int y)
+{
+  return map.tileAt(0, x, y) | (map.tileAt(1, x, y) << 16);
+}
+
+} // namespace
+
+
+struct SharedMapGeometry
+{
+  SharedMapGeometry(
+    const data::map::Map& map,
+    const TiledTexture& tileSetTexture,
+    renderer::Renderer* pRenderer)
+    : mRenderData(buildRenderData(map, tileSetTexture, pRenderer))
+    , mTiles(copyMapData({{}, {map.width(), map.height()}}, map))
+    , mAttributes(map.attributeDict())
+    , mMapWidth(map.width())
+  {
+  }
+
+  bool matches(const data::map::Map& map, renderer::Renderer* pRenderer)
+    const
+  {
+    if (
+      pRenderer != mRenderData.mpRenderer || map.width() != mMapWidth ||
+      map.width() * map.height() != int(mTiles.size()) ||
+      map.attributeDict() != mAttributes)
+    {
+      return false;
+    }
+
+    return blockMatches(map, {0, 0}, {map.width(), map.height()});
+  }
+
+  bool blockMatches(const data::map::Map& map, const size_t blockIndex) const
+  {
+    const auto blockX = int(blockIndex) % mRenderData.mSize.width;
+    const auto blockY = int(blockIndex) / mRenderData.mSize.width;
+    const auto start = base::Vec2{blockX * BLOCK_SIZE, blockY * BLOCK_SIZE};
+
+    return blockMatches(
+      map,
+      start,
+      {std::min(start.x + BLOCK_SIZE, map.width()),
+       std::min(start.y + BLOCK_SIZE, map.height())});
+  }
+
+  bool blockMatches(
+    const data::map::Map& map,
+    const base::Vec2& start,
+    const base::Vec2& end) const
+  {
+    for (auto y = start.y; y < end.y; ++y)
+    {
+      for (auto x = start.x; x < end.x; ++x)
+      {
+        if (packedTileAt(map, x, y) != mTiles[x + y * mMapWidth])
+        {
+          return false;
+        }
+      }
+    }
+
+    return true;
+  }
+
+  TileRenderData mRenderData;
+  std::vector<PackedTileData> mTiles;
+  data::map::TileAttributeDict mAttributes;
+  int mMapWidth;
+};
+
+
+namespace
+{
+
+std::shared_ptr<const SharedMapGeometry> getOrCreateSharedGeometry(
+  const data::map::Map& map,
+  const TiledTexture& tileSetTexture,
+  renderer::Renderer* pRenderer)
+{
+  // Entries are only kept alive by MapRenderer instances, not by the cache
+  // itself.
+  static std::vector<std::weak_ptr<const SharedMapGeometry>> cache;
+
+  cache.erase(
+    std::remove_if(
+      cache.begin(),
+      cache.end(),
+      [](const auto& pEntry) { return pEntry.expired(); }),
+    cache.end());
+
+  for (const auto& pEntry : cache)
+  {
+    auto pGeometry = pEntry.lock();
+    if (pGeometry->matches(map, pRenderer))
+    {
+      return pGeometry;
+    }
+  }
+
+  auto pGeometry =
+    std::make_shared<const SharedMapGeometry>(map, tileSetTexture, pRenderer);
+  cache.push_back(pGeometry);
+  return pGeometry;
+}
+
+
 base::Vec2f backdropOffset(
   const base::Vec2f& cameraPosition,
   const BackdropScrollMode scrollMode,
@@ -288,18 +640,38 @@ MapRenderer::MapRenderer(
   : mpRenderer(pRenderer)
   , mpTileAttributes(pTileAttributes)
   , mTileSetTexture(
-      renderer::Texture(pRenderer, renderData.mTileSetImage),
+      renderer::Texture(pRenderer, std::move(renderData.mTileSetImage)),
       TILE_SET_IMAGE_LOGICAL_SIZE,
       pRenderer)
-  , mBackdropTexture(mpRenderer, renderData.mBackdropImage)
-  , mRenderData(buildRenderData(map, mTileSetTexture, pRenderer))
+  , mTileShader(
+      pRenderer->isHeadless() ? renderer::Shader::createInert(TILE_SHADER)
+                              : renderer::Shader(TILE_SHADER))
+  , mBackdropTexture(mpRenderer, std::move(renderData.mBackdropImage))
+  , mpSharedGeometry(
+      getOrCreateSharedGeometry(map, mTileSetTexture, pRenderer))
+  , mRenderData(
+      createEmptyRenderData(mpSharedGeometry->mRenderData.mSize, pRenderer))
   , mScrollMode(renderData.mBackdropScrollMode)
 {
+  // The secondary backdrop is only needed once switchBackdrops() is
+  // called, so there's no need to upload it all at once.
   if (renderData.mSecondaryBackdropImage)
   {
-    mAlternativeBackdropTexture =
-      renderer::Texture(mpRenderer, *renderData.mSecondaryBackdropImage);
+    mAlternativeBackdropTexture = renderer::Texture::createDeferred(
+      mpRenderer, std::move(*renderData.mSecondaryBackdropImage));
   }
+
+  updateAutoScrollParameters();
+
+  const auto tileTexCoords = mTileSetTexture.tileTexCoords(0);
+
+  const auto guard = renderer::useTemporarily(mTileShader);
+  mTileShader.setUniform(
+    "tileSize",
+    glm::vec2{
+      tileTexCoords.right - tileTexCoords.left,
+      tileTexCoords.bottom - tileTexCoords.top});
+  mTileShader.setUniform("tilesPerRow", float(mTileSetTexture.tilesPerRow()));
 }
 
 
@@ -322,47 +694,170 @@ bool MapRenderer::hasHighResReplacements() const
 
 void MapRenderer::switchBackdrops()
 {
+  mpRenderer->finishTextureUpload(mAlternativeBackdropTexture.data());
   std::swap(mBackdropTexture, mAlternativeBackdropTexture);
+  updateAutoScrollParameters();
 }
 
 
 void MapRenderer::markAsChanged(const base::Vec2& position)
 {
-  const auto blockIndex =
-    position.x / BLOCK_SIZE + position.y / BLOCK_SIZE * mRenderData.mSize.width;
+  mChangedTiles.push_back(position);
+}
+
+
+base::Rect<int> predictedViewRegion(
+  const base::Rect<int>& visibleRegion,
+  const base::Vec2& cameraMovement,
+  const int lookAheadUpdates)
+{
+  const auto offset = cameraMovement * lookAheadUpdates;
 
-  mOutOfDateBlocks.set(blockIndex);
+  auto result = visibleRegion;
+  result.size.width += std::abs(offset.x);
+  result.size.height += std::abs(offset.y);
+  result.topLeft.x += std::min(offset.x, 0);
+  result.topLeft.y += std::min(offset.y, 0);
+  return result;
 }
 
 
 void MapRenderer::rebuildChangedBlocks(const data::map::Map& map)
 {
+  rebuildChangedBlocks(
+    map,
+    {{0, 0},
+     {mRenderData.mSize.width * BLOCK_SIZE,
+      mRenderData.mSize.height * BLOCK_SIZE}});
+}
+
+
+void MapRenderer::rebuildChangedBlocks(
+  const data::map::Map& map,
+  const base::Rect<int>& priorityRegion)
+{
+  // Try updating tiles in place first, and fall back to rebuilding the
+  // entire block if that's not possible. Blocks still referring to the
+  // shared geometry always need to be rebuilt.
+  for (const auto& position : mChangedTiles)
+  {
+    const auto blockIndex = blockIndexFor(position, mRenderData.mSize.width);
+
+    if (
+      !mOutOfDateBlocks.test(blockIndex) &&
+      (!mPrivateBlocks.test(blockIndex) ||
+       !updateTileInBlock(
+         mRenderData, map, mTileSetTexture, mpRenderer, position, blockIndex)))
+    {
+      mOutOfDateBlocks.set(blockIndex);
+    }
+  }
+
+  mChangedTiles.clear();
+
   if (mOutOfDateBlocks.none())
   {
     return;
   }
 
+  // Blocks that stay out of date keep showing their previous state. That's
+  // fine since they aren't visible, and tiles changing in them again later
+  // are picked up when they are eventually rebuilt, since that reads the
+  // current map data.
+  auto remainingDeferredRebuilds = MAX_DEFERRED_BLOCK_REBUILDS;
+
   for (auto i = 0u; i < mOutOfDateBlocks.size(); ++i)
   {
-    if (mOutOfDateBlocks.test(i))
+    if (!mOutOfDateBlocks.test(i))
     {
-      rebuildBlock(mRenderData, map, mTileSetTexture, mpRenderer, i);
+      continue;
     }
-  }
 
-  mOutOfDateBlocks.reset();
+    const auto blockX = int(i) % mRenderData.mSize.width;
+    const auto blockY = int(i) / mRenderData.mSize.width;
+    const auto blockRect = base::Rect<int>{
+      {blockX * BLOCK_SIZE, blockY * BLOCK_SIZE}, {BLOCK_SIZE, BLOCK_SIZE}};
+
+    if (blockRect.intersects(priorityRegion))
+    {
+      makeBlockPrivate(map, i);
+      mOutOfDateBlocks.reset(i);
+    }
+    else if (remainingDeferredRebuilds > 0)
+    {
+      makeBlockPrivate(map, i);
+      mOutOfDateBlocks.reset(i);
+      --remainingDeferredRebuilds;
+    }
+  }
 }
 
 
 void MapRenderer::rebuildAllBlocks(const data::map::Map& map)
 {
+  mChangedTiles.clear();
+  mOutOfDateBlocks.reset();
+
+  // Comparing blocks against the shared geometry and generating vertices
+  // for the ones that differ is done in parallel, one row of blocks per task.
+  // Blocks that don't need private geometry are left empty.
+  const auto& blockCounts = mRenderData.mSize;
+  base::Grid<std::optional<BlockData>> newBlockData(
+    blockCounts.width, blockCounts.height);
+  base::parallelFor(newBlockData.height(), [&](const std::size_t blockY) {
+    auto pRowData = newBlockData.rowData(blockY);
+    for (auto blockX = 0; blockX < blockCounts.width; ++blockX)
+    {
+      const auto blockIndex = blockX + int(blockY) * blockCounts.width;
+      if (!mpSharedGeometry->blockMatches(map, blockIndex))
+      {
+        pRowData[blockX] =
+          createBlockData(blockX, int(blockY), map, mTileSetTexture);
+      }
+    }
+  });
+
   for (auto i = 0u; i < mRenderData.mLayers[0].size(); ++i)
   {
-    rebuildBlock(mRenderData, map, mTileSetTexture, mpRenderer, i);
+    auto& oBlockData =
+      newBlockData.valueAt(i % blockCounts.width, i / blockCounts.width);
+
+    if (oBlockData)
+    {
+      replaceBlock(mRenderData, std::move(*oBlockData), mpRenderer, i);
+      mPrivateBlocks.set(i);
+    }
+    else if (mPrivateBlocks.test(i))
+    {
+      // Blocks that are back in their initial state (e.g. after loading a
+      // quick save) can go back to using the shared geometry.
+      releaseBlock(mRenderData, i);
+      mPrivateBlocks.reset(i);
+    }
   }
 }
 
 
+const TileBlock&
+  MapRenderer::block(const std::size_t layer, const std::size_t blockIndex)
+    const
+{
+  const auto& renderData = mPrivateBlocks.test(blockIndex)
+    ? mRenderData
+    : mpSharedGeometry->mRenderData;
+  return renderData.mLayers[layer][blockIndex];
+}
+
+
+void MapRenderer::makeBlockPrivate(
+  const data::map::Map& map,
+  const std::size_t blockIndex)
+{
+  rebuildBlock(mRenderData, map, mTileSetTexture, mpRenderer, blockIndex);
+  mPrivateBlocks.set(blockIndex);
+}
+
+
 void MapRenderer::renderBackground(
   const base::Vec2& sectionStart,
   const base::Size& sectionSize) const
@@ -392,6 +887,35 @@ renderer::TexCoords MapRenderer::calculateBackdropTexCoords(
   // itself, which then causes the backdrop texture to wrap around and repeat
   // thanks to texture repeat being enabled when drawing the backdrop.
   //
+  // Only the offset changes from frame to frame, everything else is captured
+  // in the backdrop layout (see updateBackdropLayout()).
+  const auto textureSize =
+    base::Size{mBackdropTexture.width(), mBackdropTexture.height()};
+  if (
+    !mBackdropLayout ||
+    mBackdropLayout->mRenderTargetSize !=
+      mpRenderer->currentRenderTargetSize() ||
+    mBackdropLayout->mGlobalScale != mpRenderer->globalScale() ||
+    mBackdropLayout->mViewportSize != viewportSize ||
+    mBackdropLayout->mTextureSize != textureSize)
+  {
+    updateBackdropLayout(viewportSize);
+  }
+
+  const auto offset =
+    backdropOffset(cameraPosition, mScrollMode, mBackdropAutoScrollOffset);
+
+  const auto left = offset.x * mBackdropLayout->mOffsetToTexCoords.x;
+  const auto top = offset.y * mBackdropLayout->mOffsetToTexCoords.y;
+  const auto right = left + mBackdropLayout->mVisibleExtent.x;
+  const auto bottom = top + mBackdropLayout->mVisibleExtent.y;
+
+  return renderer::TexCoords{left, top, right, bottom};
+}
+
+
+void MapRenderer::updateBackdropLayout(const base::Size& viewportSize) const
+{
   // The logic is somewhat complicated, because it needs to work for any
   // background image resolution, and any background image aspect ratio - we
   // want to support things like wide backgrounds. For original artwork and
@@ -408,8 +932,10 @@ renderer::TexCoords MapRenderer::calculateBackdropTexCoords(
   // the current render target size, and then work out the width from there.
 
   // Let's start with determining the scale factors.
-  const auto windowWidth = float(mpRenderer->currentRenderTargetSize().width);
-  const auto windowHeight = float(mpRenderer->currentRenderTargetSize().height);
+  const auto renderTargetSize = mpRenderer->currentRenderTargetSize();
+  const auto globalScale = mpRenderer->globalScale();
+  const auto windowWidth = float(renderTargetSize.width);
+  const auto windowHeight = float(renderTargetSize.height);
   const auto scaleY = windowHeight / mBackdropTexture.height();
 
   // Now that we know the scaling factor, we can determine the ratio between
@@ -438,38 +964,32 @@ renderer::TexCoords MapRenderer::calculateBackdropTexCoords(
   // the view port. Basically, what percentage of the background size can we
   // use to match the dimensions of the destination rectangle used for
   // drawing, which is equal in size to the current view port.
-  const auto targetWidth = float(data::tilesToPixels(viewportSize.width)) *
-    mpRenderer->globalScale().x;
-  const auto targetHeight = float(data::tilesToPixels(viewportSize.height)) *
-    mpRenderer->globalScale().y;
+  const auto targetWidth =
+    float(data::tilesToPixels(viewportSize.width)) * globalScale.x;
+  const auto targetHeight =
+    float(data::tilesToPixels(viewportSize.height)) * globalScale.y;
   const auto visibleTargetPortionX = targetWidth / windowWidth;
   const auto visibleTargetPortionY = targetHeight / windowHeight;
 
-  // Finally, compute the offset, and map it into the coordinate system of
-  // the backdrop texture.
-  const auto offset =
-    backdropOffset(cameraPosition, mScrollMode, mBackdropAutoScrollOffset);
-
-  // With all that, we can now define our rectangle in texture coordinate
-  // space (i.e. from 0..1 on both axes).
+  // Finally, determine how to map the offset into the coordinate system of
+  // the backdrop texture, and then into texture coordinate space (i.e. from
+  // 0..1 on both axes).
   // In auto-scroll mode, the offset is already in the coordinate system of
   // the backdrop texture, so we don't need to remap.
   const auto isAutoScrolling =
     mScrollMode == BackdropScrollMode::AutoHorizontal ||
     mScrollMode == BackdropScrollMode::AutoVertical;
-  const auto offsetX = isAutoScrolling
-    ? offset.x
-    : offset.x * mpRenderer->globalScale().x / scaleX;
-  const auto offsetY = isAutoScrolling
-    ? offset.y
-    : offset.y * mpRenderer->globalScale().y / scaleY;
-
-  const auto left = offsetX / mBackdropTexture.width();
-  const auto top = offsetY / mBackdropTexture.height();
-  const auto right = left + visibleTargetPortionX * remappingFactor;
-  const auto bottom = top + visibleTargetPortionY;
-
-  return renderer::TexCoords{left, top, right, bottom};
+  const auto offsetScaleX = isAutoScrolling ? 1.0f : globalScale.x / scaleX;
+  const auto offsetScaleY = isAutoScrolling ? 1.0f : globalScale.y / scaleY;
+
+  mBackdropLayout = BackdropLayout{
+    renderTargetSize,
+    globalScale,
+    viewportSize,
+    {mBackdropTexture.width(), mBackdropTexture.height()},
+    {offsetScaleX / mBackdropTexture.width(),
+     offsetScaleY / mBackdropTexture.height()},
+    {visibleTargetPortionX * remappingFactor, visibleTargetPortionY}};
 }
 
 
@@ -500,48 +1020,57 @@ void MapRenderer::renderMapTiles(
   const auto numBlocksY = base::integerDivCeil(sectionSize.height, BLOCK_SIZE) +
     std::min(offsetInBlockY, 1);
 
-  auto forEachVisibleBlock = [&](auto&& func) {
-    const auto layerIndex = static_cast<size_t>(drawMode);
+  const auto layerIndex = static_cast<size_t>(drawMode);
 
-    for (auto y = blockY;
-         y < std::min(blockY + numBlocksY, mRenderData.mSize.height);
-         ++y)
+  auto visibleBlocks = std::bitset<MAX_NUM_BLOCKS>{};
+  for (auto y = blockY;
+       y < std::min(blockY + numBlocksY, mRenderData.mSize.height);
+       ++y)
+  {
+    for (auto x = blockX;
+         x < std::min(blockX + numBlocksX, mRenderData.mSize.width);
+         ++x)
     {
-      for (auto x = blockX;
-           x < std::min(blockX + numBlocksX, mRenderData.mSize.width);
-           ++x)
-      {
-        const auto blockIndex = x + y * mRenderData.mSize.width;
-        func(mRenderData.mLayers[layerIndex][blockIndex]);
-      }
+      visibleBlocks.set(x + y * mRenderData.mSize.width);
     }
-  };
+  }
 
+  const auto nonEmptyBlocks =
+    (mpSharedGeometry->mRenderData.mNonEmptyBlocks[layerIndex] &
+     ~mPrivateBlocks) |
+    (mRenderData.mNonEmptyBlocks[layerIndex] & mPrivateBlocks);
+  const auto blocksToDraw = visibleBlocks & nonEmptyBlocks;
+
+  mBlockStatistics[layerIndex] = {
+    int(blocksToDraw.count()),
+    int(visibleBlocks.count() - blocksToDraw.count())};
 
   base::static_vector<renderer::VertexBufferId, MAX_NUM_BLOCKS> blocksToRender;
 
-  forEachVisibleBlock([&](const TileBlock& block) {
-    if (block.mTilesBuffer != renderer::INVALID_VERTEX_BUFFER_ID)
+  for (auto i = 0u; i < blocksToDraw.size(); ++i)
+  {
+    if (blocksToDraw.test(i))
     {
-      blocksToRender.push_back(block.mTilesBuffer);
+      blocksToRender.push_back(block(layerIndex, i).mTilesBuffer);
     }
-  });
+  }
 
   const auto translation = data::tilesToPixels(sectionStart) * -1;
 
   const auto saved = renderer::saveState(mpRenderer);
   renderer::setLocalTranslation(mpRenderer, translation);
 
-  mpRenderer->submitVertexBuffers(blocksToRender, mTileSetTexture.textureId());
-
-  forEachVisibleBlock([&](const TileBlock& block) {
-    for (const auto& animated : block.mAnimatedTiles)
-    {
-      const auto tileIndexToDraw = animatedTileIndex(animated.mIndex);
-      mTileSetTexture.renderTile(
-        tileIndexToDraw, animated.mPosition.x, animated.mPosition.y);
-    }
-  });
+  mTileShader.use();
+  mTileShader.setUniform(
+    "transform", renderer::computeTransformationMatrix(mpRenderer));
+  mTileShader.setUniform(
+    "animationOffsets",
+    glm::vec2{
+      float((mElapsedFrames / SLOW_ANIM_FRAME_DELAY) % ANIM_STATES),
+      float((mElapsedFrames / FAST_ANIM_FRAME_DELAY) % ANIM_STATES)});
+
+  mpRenderer->submitVertexBuffers(
+    blocksToRender, mTileSetTexture.textureId(), mTileShader);
 }
 
 
@@ -551,9 +1080,25 @@ void MapRenderer::updateAnimatedMapTiles()
 }
 
 
+auto MapRenderer::blockStatistics() const -> BlockStatistics
+{
+  return {
+    mBlockStatistics[0].mDrawnBlocks + mBlockStatistics[1].mDrawnBlocks,
+    mBlockStatistics[0].mSkippedBlocks + mBlockStatistics[1].mSkippedBlocks};
+}
+
+
 void MapRenderer::updateBackdropAutoScrolling(const engine::TimeDelta dt)
 {
-  const auto scrollSpeed = std::invoke([&]() {
+  mBackdropAutoScrollOffset += float(dt * mAutoScrollSpeed);
+  mBackdropAutoScrollOffset =
+    std::fmod(mBackdropAutoScrollOffset, mAutoScrollWrapOffset);
+}
+
+
+void MapRenderer::updateAutoScrollParameters()
+{
+  mAutoScrollSpeed = std::invoke([&]() {
     const auto scale =
       float(mBackdropTexture.height()) / GameTraits::viewportHeightPx;
 
@@ -571,7 +1116,7 @@ void MapRenderer::updateBackdropAutoScrolling(const engine::TimeDelta dt)
     }
   });
 
-  const auto maxOffset = std::invoke([&]() {
+  mAutoScrollWrapOffset = std::invoke([&]() {
     if (mScrollMode == BackdropScrollMode::AutoHorizontal)
     {
       return float(mBackdropTexture.width());
@@ -585,9 +1130,6 @@ void MapRenderer::updateBackdropAutoScrolling(const engine::TimeDelta dt)
       return 1.0f;
     }
   });
-
-  mBackdropAutoScrollOffset += float(dt * scrollSpeed);
-  mBackdropAutoScrollOffset = std::fmod(mBackdropAutoScrollOffset, maxOffset);
 }
 
 
@@ -627,8 +1169,7 @@ void MapRenderer::renderDynamicSection(
         }
 
         const auto tileIndex = map.tileAt(layer, x, y);
-        const auto isForeground =
-          mpTileAttributes->attributes(tileIndex).isForeGround();
+        const auto isForeground = mpTileAttributes->isForeGround(tileIndex);
         const auto shouldRenderForeground = drawMode == DrawMode::Foreground;
         if (isForeground != shouldRenderForeground)
         {
@@ -651,8 +1192,7 @@ void MapRenderer::renderCachedSection(
   const DrawMode drawMode) const
 {
   auto drawTile = [&](const auto tileIndex, const base::Vec2& screenPos) {
-    const auto isForeground =
-      mpTileAttributes->attributes(tileIndex).isForeGround();
+    const auto isForeground = mpTileAttributes->isForeGround(tileIndex);
     const auto shouldRenderForeground = drawMode == DrawMode::Foreground;
     if (isForeground == shouldRenderForeground)
     {
@@ -684,20 +1224,18 @@ void MapRenderer::renderCachedSection(
 map::TileIndex
   MapRenderer::animatedTileIndex(const map::TileIndex tileIndex) const
 {
-  if (mpTileAttributes->attributes(tileIndex).isAnimated())
+  switch (mpTileAttributes->animationType(tileIndex))
   {
-    const auto fastAnimOffset =
-      (mElapsedFrames / FAST_ANIM_FRAME_DELAY) % ANIM_STATES;
-    const auto slowAnimOffset =
-      (mElapsedFrames / SLOW_ANIM_FRAME_DELAY) % ANIM_STATES;
-
-    const auto isFastAnim =
-      mpTileAttributes->attributes(tileIndex).isFastAnimation();
-    return tileIndex + (isFastAnim ? fastAnimOffset : slowAnimOffset);
-  }
-  else
-  {
-    return tileIndex;
+    case data::map::TileAnimationType::Fast:
+      return tileIndex +
+        (mElapsedFrames / FAST_ANIM_FRAME_DELAY) % ANIM_STATES;
+
+    case data::map::TileAnimationType::Slow:
+      return tileIndex +
+        (mElapsedFrames / SLOW_ANIM_FRAME_DELAY) % ANIM_STATES;
+
+    default:
+      return tileIndex;
   }
 }
 
@@ -17,13 +17,18 @@
 #pragma once
 
 #include "assets/level_loader.hpp"
+#include "base/memory_accounting.hpp"
 #include "base/spatial_types.hpp"
 #include "engine/tiled_texture.hpp"
 #include "engine/timing.hpp"
 #include "renderer/renderer.hpp"
+#include "renderer/shader.hpp"
 #include "renderer/texture.hpp"
 
 #include <array>
+#include <bitset>
+#include <memory>
+#include <optional>
 #include <vector>
 
 
@@ -35,19 +40,27 @@ using PackedTileData = std::uint32_t;
 
 constexpr auto BLOCK_SIZE = 32;
 constexpr auto MAX_NUM_BLOCKS = 32;
+constexpr auto NO_QUAD = std::uint16_t(0xFFFF);
 
-
-struct AnimatedTile
-{
-  base::Vec2 mPosition;
-  data::map::TileIndex mIndex;
-};
+// Number of out-of-date blocks outside the priority region that
+// rebuildChangedBlocks() rebuilds per call
+constexpr auto MAX_DEFERRED_BLOCK_REBUILDS = 1;
 
 
 struct TileBlock
 {
   renderer::VertexBufferId mTilesBuffer;
-  std::vector<AnimatedTile> mAnimatedTiles;
+
+  /** Index of each tile's quad within mTilesBuffer
+   *
+   * Indexed by map layer and position within the block, with unused entries
+   * set to NO_QUAD. This makes it possible to change individual tiles
+   * without rebuilding the entire buffer. Empty for blocks without a buffer.
+   */
+  std::vector<std::uint16_t> mQuadSlots;
+
+  /** Size of the vertex buffer and quad slots */
+  base::TrackedMemory mMemory;
 };
 
 
@@ -62,11 +75,26 @@ struct TileRenderData
   TileRenderData& operator=(const TileRenderData&) = delete;
 
   std::array<std::vector<TileBlock>, 2> mLayers;
+
+  /** Blocks that have a vertex buffer, per layer
+   *
+   * Lets rendering skip empty blocks without looking at them.
+   */
+  std::array<std::bitset<MAX_NUM_BLOCKS>, 2> mNonEmptyBlocks;
   base::Size mSize;
   renderer::Renderer* mpRenderer;
 };
 
 
+/** Block geometry for a map in its initial state
+ *
+ * MapRenderer instances showing identical map data with the same tile set
+ * share a single instance of this, instead of each creating their own
+ * vertex buffers. It's kept alive for as long as any of them exists.
+ */
+struct SharedMapGeometry;
+
+
 /** Grab a copy of map data for use with renderCachedSection
  *
  * It's the client's responsibility to separately keep track of the
@@ -76,6 +104,19 @@ std::vector<PackedTileData>
   copyMapData(const base::Rect<int>& section, const data::map::Map& map);
 
 
+/** Extend the visible region in the direction the camera is moving
+ *
+ * Assuming the camera keeps moving by cameraMovement tiles per update,
+ * the result covers everything that becomes visible within the next
+ * lookAheadUpdates updates. Meant for use as priority region with
+ * MapRenderer::rebuildChangedBlocks().
+ */
+base::Rect<int> predictedViewRegion(
+  const base::Rect<int>& visibleRegion,
+  const base::Vec2& cameraMovement,
+  int lookAheadUpdates);
+
+
 class MapRenderer
 {
 public:
@@ -87,6 +128,12 @@ public:
     Foreground = 1
   };
 
+  struct BlockStatistics
+  {
+    int mDrawnBlocks = 0;
+    int mSkippedBlocks = 0;
+  };
+
   struct MapRenderData
   {
     data::Image mTileSetImage;
@@ -109,6 +156,19 @@ public:
 
   void markAsChanged(const base::Vec2& position);
   void rebuildChangedBlocks(const data::map::Map& map);
+
+  /** Rebuild changed blocks, prioritizing the given region (in tiles)
+   *
+   * Out-of-date blocks overlapping the region are rebuilt right away.
+   * Rebuilding the others is spread out over subsequent calls, at most
+   * MAX_DEFERRED_BLOCK_REBUILDS per call. This avoids a spike when a lot of
+   * blocks change at once, e.g. when a big explosion destroys parts of the
+   * map in several blocks. The region must cover at least everything that
+   * is going to be rendered until the next call.
+   */
+  void rebuildChangedBlocks(
+    const data::map::Map& map,
+    const base::Rect<int>& priorityRegion);
   void rebuildAllBlocks(const data::map::Map& map);
 
   void renderBackdrop(
@@ -122,6 +182,12 @@ public:
     const base::Size& sectionSize) const;
 
   void updateAnimatedMapTiles();
+
+  /** Number of blocks drawn/skipped by the last renderBackground() and
+   * renderForeground() calls, combined. Skipped blocks are those that are
+   * within the visible region, but empty.
+   */
+  BlockStatistics blockStatistics() const;
   void updateBackdropAutoScrolling(engine::TimeDelta dt);
 
   void renderSingleTile(
@@ -139,9 +205,25 @@ public:
     const DrawMode drawMode) const;
 
 private:
+  // Mapping from backdrop offset to texture coordinates. Only depends on
+  // the render target, viewport and backdrop texture dimensions, so it's
+  // only recomputed when one of these changes.
+  struct BackdropLayout
+  {
+    base::Size mRenderTargetSize;
+    base::Vec2f mGlobalScale;
+    base::Size mViewportSize;
+    base::Size mTextureSize;
+
+    base::Vec2f mOffsetToTexCoords;
+    base::Vec2f mVisibleExtent;
+  };
+
   renderer::TexCoords calculateBackdropTexCoords(
     const base::Vec2f& cameraPosition,
     const base::Size& viewportSize) const;
+  void updateBackdropLayout(const base::Size& viewportSize) const;
+  void updateAutoScrollParameters();
 
   void renderMapTiles(
     const base::Vec2& sectionStart,
@@ -149,20 +231,33 @@ private:
     DrawMode drawMode) const;
   data::map::TileIndex animatedTileIndex(data::map::TileIndex) const;
 
+  const TileBlock& block(std::size_t layer, std::size_t blockIndex) const;
+  void makeBlockPrivate(const data::map::Map& map, std::size_t blockIndex);
+
 private:
   renderer::Renderer* mpRenderer;
   const data::map::TileAttributeDict* mpTileAttributes;
 
   TiledTexture mTileSetTexture;
+  renderer::Shader mTileShader;
   renderer::Texture mBackdropTexture;
   renderer::Texture mAlternativeBackdropTexture;
 
+  // Blocks start out referring to the shared geometry. Once a block is
+  // modified, it gets its own copy in mRenderData.
+  std::shared_ptr<const SharedMapGeometry> mpSharedGeometry;
   TileRenderData mRenderData;
+  std::bitset<MAX_NUM_BLOCKS> mPrivateBlocks;
+  std::vector<base::Vec2> mChangedTiles;
   std::bitset<MAX_NUM_BLOCKS> mOutOfDateBlocks;
+  mutable std::array<BlockStatistics, 2> mBlockStatistics;
 
   data::map::BackdropScrollMode mScrollMode;
+  mutable std::optional<BackdropLayout> mBackdropLayout;
 
   float mBackdropAutoScrollOffset = 0.0f;
+  float mAutoScrollSpeed = 0.0f;
+  float mAutoScrollWrapOffset = 1.0f;
   std::uint32_t mElapsedFrames = 0;
 };
 
@@ -16,9 +16,7 @@
 
 #include "movement.hpp"
 
-#include "base/defer.hpp"
 #include "base/math_utils.hpp"
-#include "base/static_vector.hpp"
 #include "data/map.hpp"
 #include "engine/collision_checker.hpp"
 
@@ -34,21 +32,14 @@ using namespace engine::components;
 namespace
 {
 
-enum class ConveyorBeltFlag
-{
-  None,
-  Left,
-  Right
-};
-
-
 constexpr auto WALK_OFF_LEDGE_LEEWAY = 2;
 
-constexpr auto MAX_WIDTH_FOR_CONVEYOR_CHECK = 16u;
-
 
-template <typename CallableT>
-MovementResult move(int* pPosition, const int amount, CallableT isColliding)
+// Moves by amount, or as far as possible towards it. sweep() determines how
+// far that is, given the absolute value of amount (see
+// CollisionChecker::distanceToLeftWall() etc.)
+template <typename SweepFunc>
+MovementResult move(int* pPosition, const int amount, SweepFunc sweep)
 {
   if (amount == 0)
   {
@@ -56,20 +47,9 @@ MovementResult move(int* pPosition, const int amount, CallableT isColliding)
   }
 
   const auto desiredDistance = std::abs(amount);
-  const auto movement = base::sgn(amount);
-
-  const auto previousPosition = *pPosition;
-  for (int i = 0; i < desiredDistance; ++i)
-  {
-    if (isColliding())
-    {
-      break;
-    }
-
-    *pPosition += movement;
-  }
+  const auto actualDistance = sweep(desiredDistance);
+  *pPosition += actualDistance * base::sgn(amount);
 
-  const auto actualDistance = std::abs(*pPosition - previousPosition);
   if (actualDistance == 0)
   {
     return MovementResult::Failed;
@@ -172,12 +152,25 @@ MovementResult moveHorizontally(
   ex::Entity entity,
   const int amount)
 {
-  auto& position = *entity.component<WorldPosition>();
-  auto& bbox = *entity.component<BoundingBox>();
+  return moveHorizontally(
+    collisionChecker,
+    *entity.component<WorldPosition>(),
+    *entity.component<BoundingBox>(),
+    amount);
+}
+
 
-  return move(&position.x, amount, [&]() {
-    return amount < 0 ? collisionChecker.isTouchingLeftWall(position, bbox)
-                      : collisionChecker.isTouchingRightWall(position, bbox);
+MovementResult moveHorizontally(
+  const CollisionChecker& collisionChecker,
+  WorldPosition& position,
+  const BoundingBox& bbox,
+  const int amount)
+{
+  return move(&position.x, amount, [&](const int distance) {
+    const auto worldSpaceBbox = toWorldSpace(bbox, position);
+    return amount < 0
+      ? collisionChecker.distanceToLeftWall(worldSpaceBbox, distance)
+      : collisionChecker.distanceToRightWall(worldSpaceBbox, distance);
   });
 }
 
@@ -187,12 +180,25 @@ MovementResult moveVertically(
   ex::Entity entity,
   const int amount)
 {
-  auto& position = *entity.component<WorldPosition>();
-  auto& bbox = *entity.component<BoundingBox>();
+  return moveVertically(
+    collisionChecker,
+    *entity.component<WorldPosition>(),
+    *entity.component<BoundingBox>(),
+    amount);
+}
 
-  return move(&position.y, amount, [&]() {
-    return amount < 0 ? collisionChecker.isTouchingCeiling(position, bbox)
-                      : collisionChecker.isOnSolidGround(position, bbox);
+
+MovementResult moveVertically(
+  const CollisionChecker& collisionChecker,
+  WorldPosition& position,
+  const BoundingBox& bbox,
+  const int amount)
+{
+  return move(&position.y, amount, [&](const int distance) {
+    const auto worldSpaceBbox = toWorldSpace(bbox, position);
+    return amount < 0
+      ? collisionChecker.distanceToCeiling(worldSpaceBbox, distance)
+      : collisionChecker.distanceToGround(worldSpaceBbox, distance);
   });
 }
 
@@ -252,30 +258,22 @@ MovementResult moveHorizontallyWithYAdjust(
   auto& position = *entity.component<WorldPosition>();
   const auto& bbox = *entity.component<BoundingBox>();
 
-  const auto isColliding = [&]() {
-    return step < 0
-      ? collisionChecker.isTouchingLeftWall(position + base::Vec2{1, 0}, bbox)
-      : collisionChecker.isTouchingRightWall(
-          position + base::Vec2{-1, 0}, bbox);
-  };
+  // Each step tests for a wall next to the bounding box at its position
+  // before the step, but one unit higher up.
+  const auto raisedBbox = toWorldSpace(bbox, position + base::Vec2{0, -1});
+  const auto distance = step < 0
+    ? collisionChecker.distanceToLeftWall(raisedBbox, desiredDistance)
+    : collisionChecker.distanceToRightWall(raisedBbox, desiredDistance);
 
-  MovementResult finalResult = MovementResult::Completed;
-  for (int i = 0; i < desiredDistance; ++i)
-  {
-    position.x += step;
-    --position.y;
-    const auto guard = base::defer([&]() { ++position.y; });
+  position.x += distance * step;
 
-    if (isColliding())
-    {
-      position.x -= step;
-      finalResult =
-        i > 0 ? MovementResult::MovedPartially : MovementResult::Failed;
-      break;
-    }
+  if (distance == desiredDistance)
+  {
+    return MovementResult::Completed;
   }
 
-  return finalResult;
+  return distance > 0 ? MovementResult::MovedPartially
+                      : MovementResult::Failed;
 }
 
 
@@ -284,65 +282,49 @@ int determineConveyorBeltMotionAmount(
   const data::map::Map& map,
   entityx::Entity entity)
 {
-  using std::any_of;
-  using std::begin;
-  using std::end;
-
-  auto getFlag = [&map](const int x, const int y) {
-    const auto attributes = map.attributes(x, y);
-    if (attributes.isConveyorBeltLeft())
-    {
-      return ConveyorBeltFlag::Left;
-    }
-    else if (attributes.isConveyorBeltRight())
-    {
-      return ConveyorBeltFlag::Right;
-    }
-    else
-    {
-      return ConveyorBeltFlag::None;
-    }
-  };
-
-  base::static_vector<ConveyorBeltFlag, MAX_WIDTH_FOR_CONVEYOR_CHECK> flags;
+  return determineConveyorBeltMotionAmount(
+    collisionChecker,
+    map,
+    *entity.component<WorldPosition>(),
+    *entity.component<BoundingBox>());
+}
 
-  {
-    const auto& position = *entity.component<WorldPosition>();
-    const auto& bbox = *entity.component<BoundingBox>();
-    const auto worldBbox = toWorldSpace(bbox, position);
-    for (auto x = 0; x < worldBbox.size.width; ++x)
-    {
-      flags.push_back(getFlag(worldBbox.left() + x, worldBbox.bottom() + 1));
-    }
-  }
 
-  auto anyFlagIs = [&flags](const ConveyorBeltFlag desiredFlag) {
-    return any_of(begin(flags), end(flags), [&](const ConveyorBeltFlag flag) {
-      return flag == desiredFlag;
-    });
-  };
+int determineConveyorBeltMotionAmount(
+  const CollisionChecker& collisionChecker,
+  const data::map::Map& map,
+  const WorldPosition& position,
+  const BoundingBox& bbox)
+{
+  // Left-moving belts take precedence if a body stands on both kinds
+  const auto worldBbox = toWorldSpace(bbox, position);
+  return map.conveyorBeltDirectionInRow(
+    worldBbox.left(), worldBbox.right(), worldBbox.bottom() + 1);
+}
 
-  if (anyFlagIs(ConveyorBeltFlag::Left))
-  {
-    return -1;
-  }
-  else if (anyFlagIs(ConveyorBeltFlag::Right))
-  {
-    return 1;
-  }
 
-  return 0;
+void applyConveyorBeltMotion(
+  const CollisionChecker& collisionChecker,
+  const data::map::Map& map,
+  entityx::Entity entity)
+{
+  applyConveyorBeltMotion(
+    collisionChecker,
+    map,
+    *entity.component<WorldPosition>(),
+    *entity.component<BoundingBox>());
 }
 
 
 void applyConveyorBeltMotion(
   const CollisionChecker& collisionChecker,
   const data::map::Map& map,
-  entityx::Entity entity)
+  WorldPosition& position,
+  const BoundingBox& bbox)
 {
   const auto amount =
-    determineConveyorBeltMotionAmount(collisionChecker, map, entity);
-  moveHorizontally(collisionChecker, entity, amount);
+    determineConveyorBeltMotionAmount(collisionChecker, map, position, bbox);
+  moveHorizontally(collisionChecker, position, bbox, amount);
 }
 
 } // namespace rigel::engine
@@ -74,6 +74,23 @@ MovementResult moveVertically(
   entityx::Entity entity,
   int amount);
 
+/** Variants of the above operating on a position and bounding box directly
+ *
+ * These don't access any entity, which makes them usable on copies of an
+ * entity's components.
+ */
+MovementResult moveHorizontally(
+  const CollisionChecker& collisionChecker,
+  components::WorldPosition& position,
+  const components::BoundingBox& bbox,
+  int amount);
+
+MovementResult moveVertically(
+  const CollisionChecker& collisionChecker,
+  components::WorldPosition& position,
+  const components::BoundingBox& bbox,
+  int amount);
+
 MovementResult moveHorizontallyWithStairStepping(
   const CollisionChecker& collisionChecker,
   entityx::Entity entity,
@@ -96,4 +113,16 @@ void applyConveyorBeltMotion(
   const data::map::Map& map,
   entityx::Entity entity);
 
+int determineConveyorBeltMotionAmount(
+  const CollisionChecker& collisionChecker,
+  const data::map::Map& map,
+  const components::WorldPosition& position,
+  const components::BoundingBox& bbox);
+
+void applyConveyorBeltMotion(
+  const CollisionChecker& collisionChecker,
+  const data::map::Map& map,
+  components::WorldPosition& position,
+  const components::BoundingBox& bbox);
+
 } // namespace rigel::engine
@@ -17,15 +17,15 @@
 #include "particle_system.hpp"
 
 #include "data/unit_conversions.hpp"
-#include "engine/motion_smoothing.hpp"
 #include "engine/random_number_generator.hpp"
+#include "renderer/custom_quad_batch.hpp"
 #include "renderer/renderer.hpp"
 
 #include <algorithm>
 #include <array>
 #include <cassert>
-#include <functional>
-#include <memory>
+#include <cstdint>
+#include <iterator>
 
 
 namespace rigel::engine
@@ -38,9 +38,15 @@ namespace
 
 constexpr auto PARTICLE_SYSTEM_LIFE_TIME = 28;
 
+constexpr auto PARTICLES_PER_GROUP = 64;
+
+// When exceeded, the oldest group is replaced by the new one
+constexpr auto MAX_PARTICLE_GROUPS = 128;
+
 constexpr auto INITIAL_INDEX_LIMIT = 15;
 
-constexpr std::array<std::int16_t, 44> VERTICAL_MOVEMENT_TABLE{
+// Size needs to match the verticalMovementTable uniform in the shader
+constexpr std::array<float, 44> VERTICAL_MOVEMENT_TABLE{
   0,   -8,  -16, -24, -32, -36, -40, -44, -46, -47, -47, -47, -46, -44, -40,
   -36, -32, -24, -16, -8,  0,   8,   16,  24,  32,  40,  48,  56,  64,  72,
   80,  88,  96,  104, 112, 120, 128, 136, 144, 152, 160, 168, 192, 193};
@@ -53,53 +59,101 @@ static_assert(
   VERTICAL_MOVEMENT_TABLE.size());
 
 
-auto yOffsetAtTime(
-  const std::int16_t initialOffsetIndex,
-  const int framesElapsed)
-{
-  assert(
-    initialOffsetIndex + framesElapsed <
-    static_cast<int>(VERTICAL_MOVEMENT_TABLE.size()));
+// Each particle is a point. Its position is the origin of its group, in
+// world space pixels. The parameters attribute holds the particle's
+// horizontal velocity, its initial index into the movement table, and the
+// frame at which the group was spawned. The offset is computed exactly like
+// it used to be on the CPU, including rounding after interpolating between
+// the previous and current frame's offsets.
+const char* VERTEX_SOURCE_PARTICLES = R"shd(
+ATTRIBUTE HIGHP vec2 position;
+ATTRIBUTE vec4 color;
+ATTRIBUTE HIGHP vec3 parameters;
+
+OUT vec4 colorFrag;
+
+uniform mat4 transform;
+uniform HIGHP vec2 cameraPosition;
+uniform HIGHP float currentFrame;
+uniform HIGHP float interpolation;
+uniform HIGHP float verticalMovementTable[44];
+
+HIGHP vec2 offsetAtTime(HIGHP float framesElapsed) {
+  int initialIndex = int(parameters.y);
+  HIGHP float yOffset =
+    verticalMovementTable[initialIndex + int(framesElapsed)] -
+    verticalMovementTable[initialIndex];
+  return vec2(parameters.x * framesElapsed, yOffset);
+}
 
-  const auto baseOffset =
-    VERTICAL_MOVEMENT_TABLE[initialOffsetIndex + framesElapsed];
+void main() {
+  SET_POINT_SIZE(1.0);
 
-  return baseOffset - VERTICAL_MOVEMENT_TABLE[initialOffsetIndex];
+  HIGHP float framesElapsed = currentFrame - parameters.z;
+  HIGHP vec2 currentOffset = offsetAtTime(framesElapsed);
+  HIGHP vec2 previousOffset = offsetAtTime(max(0.0, framesElapsed - 1.0));
+  HIGHP vec2 offset = mix(previousOffset, currentOffset, interpolation);
+
+  // Round half away from zero, like base::round()
+  HIGHP vec2 roundedOffset = sign(offset) * floor(abs(offset) + 0.5);
+
+  gl_Position = transform *
+    vec4(position - cameraPosition + roundedOffset, 0.0, 1.0);
+  colorFrag = color;
 }
+)shd";
 
+const char* FRAGMENT_SOURCE_PARTICLES = R"shd(
+DEFAULT_PRECISION_DECLARATION
+OUTPUT_COLOR_DECLARATION
 
-struct Particle
-{
-  base::Vec2 offsetAtTime(const int framesElapsed) const
-  {
-    return {
-      mVelocityX * framesElapsed,
-      yOffsetAtTime(mInitialOffsetIndexY, framesElapsed)};
-  }
+IN vec4 colorFrag;
 
-  std::int16_t mVelocityX;
-  std::int16_t mInitialOffsetIndexY;
-};
+void main() {
+  OUTPUT_COLOR = colorFrag;
+}
+)shd";
+
+const renderer::ShaderSpec PARTICLE_SHADER{
+  renderer::VertexLayout::PositionColorAndParameters,
+  {},
+  VERTEX_SOURCE_PARTICLES,
+  FRAGMENT_SOURCE_PARTICLES};
 
 
-using ParticlesList = std::array<Particle, 64>;
+constexpr auto FLOATS_PER_PARTICLE = 9;
+constexpr auto FLOATS_PER_GROUP = FLOATS_PER_PARTICLE * PARTICLES_PER_GROUP;
 
 
-std::unique_ptr<ParticlesList> createParticles(
+void generateParticles(
+  float* pVertices,
   RandomNumberGenerator& randomGenerator,
-  const int velocityScaleX)
+  const base::Vec2& origin,
+  const base::Color& color,
+  const int velocityScaleX,
+  const int spawnFrame)
 {
-  auto pParticles = std::make_unique<ParticlesList>();
-  for (auto& particle : *pParticles)
+  const auto originPx = data::tilesToPixels(origin);
+
+  for (auto i = 0; i < PARTICLES_PER_GROUP; ++i)
   {
     const auto randomVariation = randomGenerator.gen() % 20;
-    particle.mVelocityX = static_cast<std::int16_t>(
-      velocityScaleX == 0 ? 10 - randomVariation
-                          : velocityScaleX * (randomVariation + 1));
-    particle.mInitialOffsetIndexY =
+    const auto velocityX = velocityScaleX == 0
+      ? 10 - randomVariation
+      : velocityScaleX * (randomVariation + 1);
+    const auto initialOffsetIndexY =
       randomGenerator.gen() % (INITIAL_INDEX_LIMIT + 1);
+
+    // clang-format off
+    const float vertex[] = {
+      float(originPx.x), float(originPx.y),
+      color.r / 255.0f, color.g / 255.0f, color.b / 255.0f, color.a / 255.0f,
+      float(velocityX), float(initialOffsetIndexY), float(spawnFrame)};
+    // clang-format on
+    static_assert(std::size(vertex) == FLOATS_PER_PARTICLE);
+
+    pVertices = std::copy(std::begin(vertex), std::end(vertex), pVertices);
   }
-  return pParticles;
 }
 
 } // namespace
@@ -107,74 +161,22 @@ std::unique_ptr<ParticlesList> createParticles(
 
 struct ParticleGroup
 {
-  ParticleGroup(
-    const base::Vec2& origin,
-    const base::Color& color,
-    std::unique_ptr<ParticlesList> pParticles)
-    : mpParticles(std::move(pParticles))
-    , mOrigin(origin)
-    , mColor(color)
-  {
-  }
-
-  ParticleGroup(const ParticleGroup& other)
-    : mpParticles(std::make_unique<ParticlesList>(*other.mpParticles))
-    , mOrigin(other.mOrigin)
-    , mColor(other.mColor)
-  {
-  }
-
-  ParticleGroup& operator=(const ParticleGroup& other)
-  {
-    auto copy = other;
-    std::swap(mpParticles, copy.mpParticles);
-    mOrigin = copy.mOrigin;
-    mColor = copy.mColor;
-    mFramesElapsed = copy.mFramesElapsed;
-    return *this;
-  }
-
-  ParticleGroup(ParticleGroup&&) = default;
-  ParticleGroup& operator=(ParticleGroup&&) = default;
-
-  void update() { ++mFramesElapsed; }
-
-  void render(
-    Renderer& renderer,
-    const base::Vec2& cameraPosition,
-    const float interpolation)
-  {
-    const auto screenSpaceOrigin =
-      data::tilesToPixels(mOrigin - cameraPosition);
-    for (auto& particle : *mpParticles)
-    {
-      const auto currentParticlePosition =
-        particle.offsetAtTime(mFramesElapsed);
-      const auto previousParticlePosition =
-        particle.offsetAtTime(std::max(0, mFramesElapsed - 1));
-
-      const auto particlePosition = lerpRounded(
-        previousParticlePosition, currentParticlePosition, interpolation);
-      renderer.drawPoint(screenSpaceOrigin + particlePosition, mColor);
-    }
-  }
-
-
-  bool isExpired() const { return mFramesElapsed >= PARTICLE_SYSTEM_LIFE_TIME; }
-
-  std::unique_ptr<ParticlesList> mpParticles;
-  base::Vec2 mOrigin;
-  base::Color mColor;
-  int mFramesElapsed = 0;
+  int mSpawnFrame;
 };
 
 
 ParticleSystem::ParticleSystem(
   RandomNumberGenerator* pRandomGenerator,
   Renderer* pRenderer)
-  : mpRandomGenerator(pRandomGenerator)
+  : mShader(
+      !pRenderer || pRenderer->isHeadless()
+        ? renderer::Shader::createInert(PARTICLE_SHADER)
+        : renderer::Shader(PARTICLE_SHADER))
+  , mpRandomGenerator(pRandomGenerator)
   , mpRenderer(pRenderer)
 {
+  mParticleGroups.reserve(MAX_PARTICLE_GROUPS);
+  mVertices.resize(MAX_PARTICLE_GROUPS * FLOATS_PER_GROUP);
 }
 
 
@@ -183,7 +185,14 @@ ParticleSystem::~ParticleSystem() = default;
 
 void ParticleSystem::synchronizeTo(const ParticleSystem& other)
 {
+  // Neither of these reallocates, since both vectors have the same
+  // capacity. Only the vertices of live groups need to be copied.
   mParticleGroups = other.mParticleGroups;
+  std::copy_n(
+    other.mVertices.begin(),
+    other.mParticleGroups.size() * FLOATS_PER_GROUP,
+    mVertices.begin());
+  mFrameCounter = other.mFrameCounter;
 }
 
 
@@ -192,37 +201,103 @@ void ParticleSystem::spawnParticles(
   const base::Color& color,
   int velocityScaleX)
 {
-  auto pParticles = createParticles(*mpRandomGenerator, velocityScaleX);
-  mParticleGroups.emplace_back(
-    origin + SPAWN_OFFSET, color, std::move(pParticles));
+  auto groupIndex = mParticleGroups.size();
+  if (groupIndex < MAX_PARTICLE_GROUPS)
+  {
+    mParticleGroups.push_back({mFrameCounter});
+  }
+  else
+  {
+    const auto iOldest = std::min_element(
+      mParticleGroups.begin(),
+      mParticleGroups.end(),
+      [](const ParticleGroup& lhs, const ParticleGroup& rhs) {
+        return lhs.mSpawnFrame < rhs.mSpawnFrame;
+      });
+    groupIndex = std::size_t(std::distance(mParticleGroups.begin(), iOldest));
+    iOldest->mSpawnFrame = mFrameCounter;
+  }
+
+  generateParticles(
+    mVertices.data() + groupIndex * FLOATS_PER_GROUP,
+    *mpRandomGenerator,
+    origin + SPAWN_OFFSET,
+    color,
+    velocityScaleX,
+    mFrameCounter);
 }
 
 
 void ParticleSystem::update()
 {
-  using namespace std;
+  auto i = std::size_t{0};
+  while (i < mParticleGroups.size())
+  {
+    const auto framesElapsed = mFrameCounter - mParticleGroups[i].mSpawnFrame;
+    if (framesElapsed < PARTICLE_SYSTEM_LIFE_TIME)
+    {
+      ++i;
+      continue;
+    }
 
-  const auto it = remove_if(
-    begin(mParticleGroups),
-    end(mParticleGroups),
-    mem_fn(&ParticleGroup::isExpired));
-  mParticleGroups.erase(it, end(mParticleGroups));
+    const auto lastIndex = mParticleGroups.size() - 1;
+    if (i != lastIndex)
+    {
+      mParticleGroups[i] = mParticleGroups[lastIndex];
+      std::copy_n(
+        mVertices.begin() + lastIndex * FLOATS_PER_GROUP,
+        FLOATS_PER_GROUP,
+        mVertices.begin() + i * FLOATS_PER_GROUP);
+    }
+
+    mParticleGroups.pop_back();
+  }
 
-  for (auto& group : mParticleGroups)
+  // Only differences between frame numbers matter, so we can start over
+  // whenever there are no particles. This keeps the counter small enough to
+  // be represented exactly as a float in the shader.
+  if (mParticleGroups.empty())
   {
-    group.update();
+    mFrameCounter = 0;
   }
+
+  ++mFrameCounter;
 }
 
 
 void ParticleSystem::render(
   const base::Vec2& cameraPosition,
-  const float interpolation)
+  const float interpolation,
+  const int stride)
 {
-  for (auto& group : mParticleGroups)
+  if (mParticleGroups.empty())
   {
-    group.render(*mpRenderer, cameraPosition, interpolation);
+    return;
   }
+
+  const auto cameraPositionPx = data::tilesToPixels(cameraPosition);
+
+  mShader.use();
+  mShader.setUniform(
+    "transform", renderer::computeTransformationMatrix(mpRenderer));
+  mShader.setUniform(
+    "cameraPosition",
+    glm::vec2{float(cameraPositionPx.x), float(cameraPositionPx.y)});
+  mShader.setUniform("currentFrame", float(mFrameCounter));
+  mShader.setUniform("interpolation", interpolation);
+  mShader.setUniform("verticalMovementTable", VERTICAL_MOVEMENT_TABLE);
+
+  // New groups are appended at the end, so drawing only the last part of
+  // the buffer favors the most recently spawned ones.
+  const auto numGroups = stride > 1
+    ? (mParticleGroups.size() + std::size_t(stride) - 1) / std::size_t(stride)
+    : mParticleGroups.size();
+  const auto firstGroup = mParticleGroups.size() - numGroups;
+
+  mpRenderer->drawCustomPoints(
+    {mVertices.data() + firstGroup * FLOATS_PER_GROUP,
+     std::uint32_t(numGroups * FLOATS_PER_GROUP)},
+    mShader);
 }
 
 } // namespace rigel::engine
@@ -18,6 +18,7 @@
 
 #include "base/color.hpp"
 #include "base/spatial_types.hpp"
+#include "renderer/shader.hpp"
 
 #include <vector>
 
@@ -51,12 +52,34 @@ public:
     int velocityScaleX = 0);
 
   void update();
-  void render(const base::Vec2& cameraPosition, float interpolation);
+
+  /** Draw live particle groups
+   *
+   * With a stride above 1, only that fraction of the groups is drawn, to
+   * reduce the cost of effects while the game is under heavy load.
+   */
+  void render(
+    const base::Vec2& cameraPosition,
+    float interpolation,
+    int stride = 1);
+
+  bool hasParticles() const { return !mParticleGroups.empty(); }
 
 private:
+  // Particle motion is computed by a vertex shader, based on the frame at
+  // which a group was spawned. The vertex data thus only needs to be
+  // written once per group, when spawning it.
+  //
+  // Both vectors are allocated up front for the maximum number of groups
+  // and never grow. Live groups are kept densely packed at the start, with
+  // their vertices in the same order in mVertices. Expired groups are
+  // replaced by the last live one.
   std::vector<ParticleGroup> mParticleGroups;
+  std::vector<float> mVertices;
+  renderer::Shader mShader;
   RandomNumberGenerator* mpRandomGenerator;
   renderer::Renderer* mpRenderer;
+  int mFrameCounter = 0;
 };
 
 } // namespace rigel::engine
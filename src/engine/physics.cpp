@@ -59,47 +59,26 @@ base::Vec2f
   return {sequence.mEnableX ? newVelocity.x : velocity.x, newVelocity.y};
 }
 
-} // namespace
-
 
-// TODO: This is implemented here, but declared in physical_components.hpp.
-// It would be cleaner to have a matching .cpp file for that file.
-BoundingBox
-  toWorldSpace(const BoundingBox& bbox, const base::Vec2& entityPosition)
-{
-  return bbox +
-    base::Vec2(entityPosition.x, entityPosition.y - (bbox.size.height - 1));
-}
-
-
-std::optional<PhysicsCollisionInfo> applyPhysics(
+std::optional<PhysicsCollisionInfo> applyPhysicsImpl(
   const CollisionChecker& collisionChecker,
   const data::map::Map& map,
-  entityx::Entity entity,
-  components::MovingBody& body,
-  components::WorldPosition& position,
-  const components::BoundingBox& collisionRect)
+  MovingBody& body,
+  WorldPosition& position,
+  const BoundingBox& collisionRect,
+  const bool hasActiveSequence)
 {
-  auto hasActiveSequence = [&]() {
-    return entity.has_component<MovementSequence>();
-  };
-
-  if (hasActiveSequence())
-  {
-    body.mVelocity = updateMovementSequence(entity, body.mVelocity);
-  }
-
   const auto originalVelocity = body.mVelocity;
   const auto originalPosition = position;
 
   const auto movementX = static_cast<std::int16_t>(body.mVelocity.x);
-  moveHorizontally(collisionChecker, entity, movementX);
+  moveHorizontally(collisionChecker, position, collisionRect, movementX);
 
   // Cache new world space BBox after applying horizontal movement
   // for the next steps
   const auto bbox = toWorldSpace(collisionRect, position);
 
-  if (body.mGravityAffected && !hasActiveSequence())
+  if (body.mGravityAffected && !hasActiveSequence)
   {
     // Unstick objects from ground that ended up stuck inside on the previous
     // frame. This is needed for item's released from boxes in mid-air, which
@@ -118,11 +97,12 @@ std::optional<PhysicsCollisionInfo> applyPhysics(
 
     body.mVelocity.y = applyGravity(collisionChecker, bbox, body.mVelocity.y);
 
-    applyConveyorBeltMotion(collisionChecker, map, entity);
+    applyConveyorBeltMotion(collisionChecker, map, position, collisionRect);
   }
 
   const auto movementY = static_cast<std::int16_t>(body.mVelocity.y);
-  const auto result = moveVertically(collisionChecker, entity, movementY);
+  const auto result =
+    moveVertically(collisionChecker, position, collisionRect, movementY);
   if (result != MovementResult::Completed)
   {
     body.mVelocity.y = 0.0f;
@@ -151,6 +131,52 @@ std::optional<PhysicsCollisionInfo> applyPhysics(
   return {};
 }
 
+} // namespace
+
+
+// TODO: This is implemented here, but declared in physical_components.hpp.
+// It would be cleaner to have a matching .cpp file for that file.
+BoundingBox
+  toWorldSpace(const BoundingBox& bbox, const base::Vec2& entityPosition)
+{
+  return bbox +
+    base::Vec2(entityPosition.x, entityPosition.y - (bbox.size.height - 1));
+}
+
+
+std::optional<PhysicsCollisionInfo> applyPhysics(
+  const CollisionChecker& collisionChecker,
+  const data::map::Map& map,
+  entityx::Entity entity,
+  components::MovingBody& body,
+  components::WorldPosition& position,
+  const components::BoundingBox& collisionRect)
+{
+  auto hasActiveSequence = [&]() {
+    return entity.has_component<MovementSequence>();
+  };
+
+  if (hasActiveSequence())
+  {
+    body.mVelocity = updateMovementSequence(entity, body.mVelocity);
+  }
+
+  return applyPhysicsImpl(
+    collisionChecker, map, body, position, collisionRect, hasActiveSequence());
+}
+
+
+std::optional<PhysicsCollisionInfo> applyPhysics(
+  const CollisionChecker& collisionChecker,
+  const data::map::Map& map,
+  components::MovingBody& body,
+  components::WorldPosition& position,
+  const components::BoundingBox& collisionRect)
+{
+  return applyPhysicsImpl(
+    collisionChecker, map, body, position, collisionRect, false);
+}
+
 
 float applyGravity(
   const CollisionChecker& collisionChecker,
@@ -54,6 +54,20 @@ std::optional<PhysicsCollisionInfo> applyPhysics(
   components::WorldPosition& position,
   const components::BoundingBox& collisionRect);
 
+/** Variant of applyPhysics() for entities without a MovementSequence
+ *
+ * Operates only on the given components, without accessing the entity they
+ * belong to. This makes it possible to run it on copies of the components,
+ * and from multiple threads at once (as long as nothing modifies the map or
+ * any solid bodies at the same time).
+ */
+std::optional<PhysicsCollisionInfo> applyPhysics(
+  const CollisionChecker& collisionChecker,
+  const data::map::Map& map,
+  components::MovingBody& body,
+  components::WorldPosition& position,
+  const components::BoundingBox& collisionRect);
+
 float applyGravity(
   const CollisionChecker& collisionChecker,
   const components::BoundingBox& bbox,
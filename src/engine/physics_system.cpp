@@ -16,9 +16,15 @@
 
 #include "physics_system.hpp"
 
+#include "base/job_system.hpp"
+#include "engine/collision_checker.hpp"
+#include "engine/entity_activation_system.hpp"
 #include "engine/entity_tools.hpp"
 #include "engine/physics.hpp"
 
+#include <algorithm>
+#include <cmath>
+
 
 namespace ex = entityx;
 
@@ -31,13 +37,58 @@ using components::MovingBody;
 using components::WorldPosition;
 
 
+namespace
+{
+
+// Below this number of eligible bodies, the overhead of distributing the
+// work outweighs the gains.
+constexpr auto MIN_BODIES_FOR_PARALLEL_UPDATE = 64u;
+constexpr auto MAX_WORKER_THREADS = 3;
+
+
+bool isSameBodyState(const MovingBody& lhs, const MovingBody& rhs)
+{
+  return lhs.mVelocity == rhs.mVelocity &&
+    lhs.mGravityAffected == rhs.mGravityAffected &&
+    lhs.mIgnoreCollisions == rhs.mIgnoreCollisions &&
+    lhs.mIsActive == rhs.mIsActive;
+}
+
+
+/** Conservative estimate of the area looked at by applyPhysics()
+ *
+ * Covers horizontal movement, gravity, conveyor belt motion and vertical
+ * movement, plus the one unit wide border around the bounding box that
+ * collision tests check.
+ */
+BoundingBox affectedAreaFor(
+  const MovingBody& body,
+  const WorldPosition& position,
+  const BoundingBox& collisionRect)
+{
+  const auto bbox = toWorldSpace(collisionRect, position);
+  const auto marginX = static_cast<int>(std::abs(body.mVelocity.x)) + 3;
+  const auto marginY =
+    std::max(static_cast<int>(std::abs(body.mVelocity.y)), 2) + 3;
+
+  return BoundingBox{
+    {bbox.left() - marginX, bbox.top() - marginY},
+    {bbox.size.width + marginX * 2, bbox.size.height + marginY * 2}};
+}
+
+
+} // namespace
+
+
 PhysicsSystem::PhysicsSystem(
-  const engine::CollisionChecker* pCollisionChecker,
+  engine::CollisionChecker* pCollisionChecker,
   const data::map::Map* pMap,
-  entityx::EventManager* pEvents)
+  entityx::EventManager* pEvents,
+  const ActiveEntityView* pActiveEntities)
   : mpCollisionChecker(pCollisionChecker)
   , mpMap(pMap)
   , mpEvents(pEvents)
+  , mpActiveEntities(pActiveEntities)
 {
   mpEvents->subscribe<ex::ComponentAddedEvent<MovingBody>>(*this);
   mpEvents->subscribe<ex::ComponentRemovedEvent<MovingBody>>(*this);
@@ -46,15 +97,179 @@ PhysicsSystem::PhysicsSystem(
 
 void PhysicsSystem::update(ex::EntityManager& es)
 {
+  mpCollisionChecker->updateSolidBodyIndex();
+
+  if (mParallelUpdateEnabled)
+  {
+    simulateSpeculatively(es);
+  }
+
+  // Both this loop and simulateSpeculatively() visit entities in order of
+  // their index, so the results can be matched up in a single pass.
+  auto nextResult = mSpeculativeResults.begin();
+
   es.each<MovingBody, WorldPosition, BoundingBox, components::Active>(
-    [this](
+    [&, this](
       ex::Entity entity,
       MovingBody& body,
       WorldPosition& position,
       const BoundingBox& collisionRect,
       const components::Active&) {
-      applyPhysics(entity, body, position, collisionRect);
+      while (nextResult != mSpeculativeResults.end() &&
+             nextResult->mEntity.id().index() < entity.id().index())
+      {
+        ++nextResult;
+      }
+
+      if (
+        nextResult != mSpeculativeResults.end() &&
+        nextResult->mEntity == entity &&
+        canUseSpeculativeResult(*nextResult, body, position, collisionRect))
+      {
+        body = nextResult->mBodyAfter;
+        position = nextResult->mPositionAfter;
+        handlePhysicsResult(entity, nextResult->mCollisionInfo);
+      }
+      else
+      {
+        applyPhysics(entity, body, position, collisionRect);
+      }
     });
+
+  mSpeculativeResults.clear();
+}
+
+
+void PhysicsSystem::setParallelUpdateEnabled(const bool enabled)
+{
+  mParallelUpdateEnabled = enabled;
+}
+
+
+void PhysicsSystem::simulateSpeculatively(ex::EntityManager& es)
+{
+  mSpeculativeResults.clear();
+  mSpeculatedMapRevision = mpMap->revision();
+
+  // Entities which became active after marking are missing from the view,
+  // but that's fine - they are simply simulated serially.
+  if (mpActiveEntities)
+  {
+    for (auto entity : mpActiveEntities->entities())
+    {
+      const auto hasRequiredComponents = entity.valid() &&
+        entity.has_component<MovingBody>() &&
+        entity.has_component<WorldPosition>() &&
+        entity.has_component<BoundingBox>() &&
+        entity.has_component<components::Active>();
+
+      if (hasRequiredComponents)
+      {
+        addSpeculationCandidate(
+          entity,
+          *entity.component<MovingBody>(),
+          *entity.component<WorldPosition>(),
+          *entity.component<BoundingBox>());
+      }
+    }
+  }
+  else
+  {
+    es.each<MovingBody, WorldPosition, BoundingBox, components::Active>(
+      [this](
+        ex::Entity entity,
+        const MovingBody& body,
+        const WorldPosition& position,
+        const BoundingBox& collisionRect,
+        const components::Active&) {
+        addSpeculationCandidate(entity, body, position, collisionRect);
+      });
+  }
+
+  if (mSpeculativeResults.size() < MIN_BODIES_FOR_PARALLEL_UPDATE)
+  {
+    mSpeculativeResults.clear();
+    return;
+  }
+
+  auto simulateRange = [this](const auto first, const auto last) {
+    for (auto it = first; it != last; ++it)
+    {
+      it->mCollisionInfo = engine::applyPhysics(
+        *mpCollisionChecker,
+        *mpMap,
+        it->mBodyAfter,
+        it->mPositionAfter,
+        it->mBboxBefore);
+    }
+  };
+
+  // The main thread takes part as well, so there's one chunk more than
+  // there are workers.
+  auto& jobSystem = base::JobSystem::instance();
+  const auto numChunks = static_cast<std::size_t>(
+    std::clamp(jobSystem.workerCount(), 1, MAX_WORKER_THREADS) + 1);
+  const auto chunkSize =
+    (mSpeculativeResults.size() + numChunks - 1) / numChunks;
+
+  jobSystem.parallelFor(numChunks, [&](const std::size_t chunk) {
+    const auto first = std::min(chunk * chunkSize, mSpeculativeResults.size());
+    const auto last = std::min(first + chunkSize, mSpeculativeResults.size());
+    simulateRange(
+      mSpeculativeResults.begin() + first, mSpeculativeResults.begin() + last);
+  });
+}
+
+
+void PhysicsSystem::addSpeculationCandidate(
+  ex::Entity entity,
+  const MovingBody& body,
+  const WorldPosition& position,
+  const BoundingBox& collisionRect)
+{
+  // Only bodies that don't interact with any solid bodies are eligible, since
+  // solid bodies are moved around during the serial pass. Bodies with a
+  // movement sequence are excluded since they need to modify their entity.
+  if (
+    !body.mIsActive || entity.has_component<components::MovementSequence>() ||
+    entity.has_component<components::SolidBody>())
+  {
+    return;
+  }
+
+  const auto affectedArea = affectedAreaFor(body, position, collisionRect);
+  if (mpCollisionChecker->hasSolidBodyIn(affectedArea))
+  {
+    return;
+  }
+
+  mSpeculativeResults.push_back(SpeculativeResult{
+    entity,
+    body,
+    position,
+    collisionRect,
+    affectedArea,
+    body,
+    position,
+    std::nullopt});
+}
+
+
+bool PhysicsSystem::canUseSpeculativeResult(
+  const SpeculativeResult& result,
+  const MovingBody& body,
+  const WorldPosition& position,
+  const BoundingBox& collisionRect) const
+{
+  // Anything that happened earlier during the serial pass (moved solid bodies,
+  // event handlers modifying entities or the map) invalidates the result.
+  return mpMap->revision() == mSpeculatedMapRevision &&
+    isSameBodyState(body, result.mBodyBefore) &&
+    position == result.mPositionBefore &&
+    collisionRect == result.mBboxBefore &&
+    !result.mEntity.has_component<components::MovementSequence>() &&
+    !result.mEntity.has_component<components::SolidBody>() &&
+    !mpCollisionChecker->hasSolidBodyIn(result.mAffectedArea);
 }
 
 
@@ -67,9 +282,17 @@ void PhysicsSystem::updatePhase1(ex::EntityManager& es)
 
 void PhysicsSystem::updatePhase2(ex::EntityManager& es)
 {
+  mpCollisionChecker->updateSolidBodyIndex();
+
   for (auto entity : mPhysicsObjectsForPhase2)
   {
-    assert(entity.has_component<MovingBody>());
+    // Entities which were destroyed or lost their MovingBody after being
+    // collected are still in the list, see receive().
+    if (!entity.valid() || !entity.has_component<MovingBody>())
+    {
+      continue;
+    }
+
     const auto hasRequiredComponents = entity.has_component<WorldPosition>() &&
       entity.has_component<BoundingBox>() &&
       entity.has_component<components::Active>();
@@ -85,6 +308,7 @@ void PhysicsSystem::updatePhase2(ex::EntityManager& es)
   }
 
   mPhysicsObjectsForPhase2.clear();
+  mNumRemovedForPhase2 = 0;
   mShouldCollectForPhase2 = false;
 }
 
@@ -102,7 +326,14 @@ void PhysicsSystem::applyPhysics(
 
   const auto result = engine::applyPhysics(
     *mpCollisionChecker, *mpMap, entity, body, position, collisionRect);
+  handlePhysicsResult(entity, result);
+}
+
 
+void PhysicsSystem::handlePhysicsResult(
+  ex::Entity entity,
+  const std::optional<PhysicsCollisionInfo>& result)
+{
   setTag<components::CollidedWithWorld>(entity, result.has_value());
 
   if (result)
@@ -121,6 +352,20 @@ void PhysicsSystem::receive(
     return;
   }
 
+  // If the entity had its MovingBody removed and re-added, it's still in
+  // the list, and moves to the end like a newly spawned one.
+  if (mNumRemovedForPhase2 > 0)
+  {
+    const auto it = std::find(
+      mPhysicsObjectsForPhase2.begin(),
+      mPhysicsObjectsForPhase2.end(),
+      event.entity);
+    if (it != mPhysicsObjectsForPhase2.end())
+    {
+      mPhysicsObjectsForPhase2.erase(it);
+    }
+  }
+
   mPhysicsObjectsForPhase2.push_back(event.entity);
 }
 
@@ -128,21 +373,12 @@ void PhysicsSystem::receive(
 void PhysicsSystem::receive(
   const entityx::ComponentRemovedEvent<components::MovingBody>& event)
 {
-  using namespace std;
-
-  if (!mShouldCollectForPhase2)
-  {
-    return;
-  }
-
-  const auto it = find_if(
-    begin(mPhysicsObjectsForPhase2),
-    end(mPhysicsObjectsForPhase2),
-    [&event](const auto& entity) { return entity == event.entity; });
-
-  if (it != end(mPhysicsObjectsForPhase2))
+  // Searching and erasing each removed entity would add up when many
+  // entities are destroyed in one frame. They are skipped in updatePhase2()
+  // instead.
+  if (mShouldCollectForPhase2)
   {
-    mPhysicsObjectsForPhase2.erase(it);
+    ++mNumRemovedForPhase2;
   }
 }
 
@@ -20,13 +20,16 @@
 #include "base/warnings.hpp"
 #include "engine/base_components.hpp"
 #include "engine/physical_components.hpp"
+#include "engine/physics.hpp"
 
 RIGEL_DISABLE_WARNINGS
 #include <entityx/entityx.h>
 RIGEL_RESTORE_WARNINGS
 
 #include <cstdint>
+#include <optional>
 #include <tuple>
+#include <vector>
 
 
 namespace rigel::data::map
@@ -38,6 +41,7 @@ class Map;
 namespace rigel::engine
 {
 
+class ActiveEntityView;
 class CollisionChecker;
 
 /** Implements game physics/world interaction
@@ -58,14 +62,23 @@ class CollisionChecker;
  * already positioned so that they collide with the world.
  *
  * For directly moving entities, the functions in movement.hpp should be used.
+ *
+ * Before processing any entities, the collision checker's solid body index is
+ * brought up to date, so that solid bodies which were moved or resized since
+ * the last update are found by collision queries.
+ *
+ * Optionally, update() can simulate bodies speculatively on multiple threads,
+ * see setParallelUpdateEnabled(). If an ActiveEntityView is given, picking
+ * the bodies for that only goes through the entities listed in there.
  */
 class PhysicsSystem : public entityx::Receiver<PhysicsSystem>
 {
 public:
   PhysicsSystem(
-    const engine::CollisionChecker* pCollisionChecker,
+    engine::CollisionChecker* pCollisionChecker,
     const data::map::Map* pMap,
-    entityx::EventManager* pEvents);
+    entityx::EventManager* pEvents,
+    const ActiveEntityView* pActiveEntities = nullptr);
 
   /** Process currently existing entities
    *
@@ -90,23 +103,68 @@ public:
    */
   void updatePhase2(entityx::EntityManager& es);
 
+  /** Enable speculative parallel processing in update()/updatePhase1()
+   *
+   * When enabled, bodies which are not close to any solid body are first
+   * simulated on copies of their components, on the shared job system. The
+   * regular serial pass then takes over these results instead of simulating
+   * the body again, as long as nothing has changed the body, the map or the
+   * solid bodies around it in the meantime. Otherwise, the body is simulated
+   * serially as usual. The outcome is thus identical to a serial update.
+   *
+   * Disabled by default.
+   */
+  void setParallelUpdateEnabled(bool enabled);
+
   void
     receive(const entityx::ComponentAddedEvent<components::MovingBody>& event);
   void receive(
     const entityx::ComponentRemovedEvent<components::MovingBody>& event);
 
 private:
+  struct SpeculativeResult
+  {
+    entityx::Entity mEntity;
+    components::MovingBody mBodyBefore;
+    components::WorldPosition mPositionBefore;
+    components::BoundingBox mBboxBefore;
+    components::BoundingBox mAffectedArea;
+    components::MovingBody mBodyAfter;
+    components::WorldPosition mPositionAfter;
+    std::optional<PhysicsCollisionInfo> mCollisionInfo;
+  };
+
   void applyPhysics(
     entityx::Entity entity,
     components::MovingBody& body,
     components::WorldPosition& position,
     const components::BoundingBox& collisionRect);
+  void handlePhysicsResult(
+    entityx::Entity entity,
+    const std::optional<PhysicsCollisionInfo>& result);
+
+  void simulateSpeculatively(entityx::EntityManager& es);
+  void addSpeculationCandidate(
+    entityx::Entity entity,
+    const components::MovingBody& body,
+    const components::WorldPosition& position,
+    const components::BoundingBox& collisionRect);
+  bool canUseSpeculativeResult(
+    const SpeculativeResult& result,
+    const components::MovingBody& body,
+    const components::WorldPosition& position,
+    const components::BoundingBox& collisionRect) const;
 
   std::vector<entityx::Entity> mPhysicsObjectsForPhase2;
-  const CollisionChecker* mpCollisionChecker;
+  std::vector<SpeculativeResult> mSpeculativeResults;
+  CollisionChecker* mpCollisionChecker;
   const data::map::Map* mpMap;
   entityx::EventManager* mpEvents;
+  const ActiveEntityView* mpActiveEntities;
+  std::uint32_t mSpeculatedMapRevision = 0;
+  int mNumRemovedForPhase2 = 0;
   bool mShouldCollectForPhase2 = false;
+  bool mParallelUpdateEnabled = false;
 };
 
 } // namespace rigel::engine
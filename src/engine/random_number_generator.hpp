@@ -31,6 +31,8 @@ class RandomNumberGenerator
 public:
   int gen();
 
+  std::uint8_t nextNumberIndex() const { return mNextNumberIndex; }
+
 private:
   std::uint8_t mNextNumberIndex = 0;
 };
@@ -0,0 +1,219 @@
+/* Copyright (C) 2022, Nikolai Wuttke. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "spatial_index.hpp"
+
+#include "engine/physical_components.hpp"
+
+#include <algorithm>
+#include <limits>
+
+
+namespace rigel::engine
+{
+
+namespace ex = entityx;
+
+using components::BoundingBox;
+using components::WorldPosition;
+
+
+namespace
+{
+
+// Size of a grid cell, in tiles
+constexpr auto GRID_CELL_SIZE = 8;
+
+} // namespace
+
+
+SpatialIndex::SpatialIndex(
+  const int widthInTiles,
+  const int heightInTiles,
+  ex::EventManager& eventManager)
+  : mGrid(widthInTiles, heightInTiles, GRID_CELL_SIZE)
+{
+  eventManager.subscribe<ex::ComponentAddedEvent<WorldPosition>>(*this);
+  eventManager.subscribe<ex::ComponentAddedEvent<BoundingBox>>(*this);
+}
+
+
+void SpatialIndex::build(ex::EntityManager& es)
+{
+  mEntries.clear();
+  mLateEntities.clear();
+
+  es.each<WorldPosition, BoundingBox>(
+    [this](
+      ex::Entity entity,
+      const WorldPosition& position,
+      const BoundingBox& bbox) {
+      mEntries.push_back(Entry{entity, engine::toWorldSpace(bbox, position)});
+    });
+
+  // Counting sort of entries into cells: First count the entries per cell,
+  // then turn the counts into start offsets, then fill in the entries. Since
+  // entries are visited in order, each cell's contents end up sorted.
+  mCellStarts.assign(mGrid.numCells() + 1, 0);
+
+  auto forEachCoveredCell = [this](const Entry& entry, auto&& func) {
+    const auto cells = mGrid.cellsCovering(entry.mBbox);
+    for (auto y = cells.top(); y <= cells.bottom(); ++y)
+    {
+      for (auto x = cells.left(); x <= cells.right(); ++x)
+      {
+        func(mGrid.cellIndex(x, y));
+      }
+    }
+  };
+
+  for (const auto& entry : mEntries)
+  {
+    forEachCoveredCell(
+      entry, [this](const int cell) { ++mCellStarts[cell + 1]; });
+  }
+
+  for (auto i = std::size_t{1}; i < mCellStarts.size(); ++i)
+  {
+    mCellStarts[i] += mCellStarts[i - 1];
+  }
+
+  mCellContents.resize(mCellStarts.back());
+
+  auto fillPositions =
+    std::vector<std::uint32_t>(mCellStarts.begin(), mCellStarts.end() - 1);
+  for (auto i = std::uint32_t{0}; i < mEntries.size(); ++i)
+  {
+    forEachCoveredCell(mEntries[i], [&](const int cell) {
+      mCellContents[fillPositions[cell]++] = i;
+    });
+  }
+}
+
+
+void SpatialIndex::collectIntersecting(
+  const BoundingBox& area,
+  std::vector<ex::Entity>& result) const
+{
+  result.clear();
+  mCandidateBuffer.clear();
+
+  const auto cells = mGrid.cellsCovering(area);
+  for (auto y = cells.top(); y <= cells.bottom(); ++y)
+  {
+    for (auto x = cells.left(); x <= cells.right(); ++x)
+    {
+      const auto cell = mGrid.cellIndex(x, y);
+      mCandidateBuffer.insert(
+        mCandidateBuffer.end(),
+        mCellContents.begin() + mCellStarts[cell],
+        mCellContents.begin() + mCellStarts[cell + 1]);
+    }
+  }
+
+  // Entries covering multiple cells show up multiple times
+  if (cells.size.width > 1 || cells.size.height > 1)
+  {
+    std::sort(mCandidateBuffer.begin(), mCandidateBuffer.end());
+    mCandidateBuffer.erase(
+      std::unique(mCandidateBuffer.begin(), mCandidateBuffer.end()),
+      mCandidateBuffer.end());
+  }
+
+  // Entries are in entity order, and so are the late entities. Merging the
+  // two keeps the result in entity order as well.
+  auto iLateEntity = mLateEntities.begin();
+  auto addLateEntitiesBefore = [&](const std::uint32_t entityIndex) {
+    for (; iLateEntity != mLateEntities.end() &&
+         iLateEntity->id().index() < entityIndex;
+         ++iLateEntity)
+    {
+      auto entity = *iLateEntity;
+      if (
+        entity.valid() && entity.has_component<WorldPosition>() &&
+        entity.has_component<BoundingBox>() &&
+        engine::toWorldSpace(
+          *entity.component<BoundingBox>(), *entity.component<WorldPosition>())
+          .intersects(area))
+      {
+        result.push_back(entity);
+      }
+    }
+  };
+
+  for (const auto index : mCandidateBuffer)
+  {
+    const auto& entry = mEntries[index];
+    if (entry.mBbox.intersects(area))
+    {
+      addLateEntitiesBefore(entry.mEntity.id().index());
+      result.push_back(entry.mEntity);
+    }
+  }
+
+  addLateEntitiesBefore(std::numeric_limits<std::uint32_t>::max());
+}
+
+
+void SpatialIndex::receive(
+  const ex::ComponentAddedEvent<WorldPosition>& event)
+{
+  addLateEntity(event.entity);
+}
+
+
+void SpatialIndex::receive(const ex::ComponentAddedEvent<BoundingBox>& event)
+{
+  addLateEntity(event.entity);
+}
+
+
+void SpatialIndex::addLateEntity(const ex::Entity entity)
+{
+  // Spawning an entity usually assigns both components, so we see it twice.
+  // It might also have been indexed already, if it lost one of the
+  // components and got it back since the last build().
+  const auto iPosition = std::lower_bound(
+    mLateEntities.begin(),
+    mLateEntities.end(),
+    entity.id().index(),
+    [](const ex::Entity& lateEntity, const std::uint32_t index) {
+      return lateEntity.id().index() < index;
+    });
+  if (
+    (iPosition != mLateEntities.end() && *iPosition == entity) ||
+    isIndexed(entity))
+  {
+    return;
+  }
+
+  mLateEntities.insert(iPosition, entity);
+}
+
+
+bool SpatialIndex::isIndexed(const ex::Entity entity) const
+{
+  const auto iEntry = std::lower_bound(
+    mEntries.begin(),
+    mEntries.end(),
+    entity.id().index(),
+    [](const Entry& entry, const std::uint32_t index) {
+      return entry.mEntity.id().index() < index;
+    });
+  return iEntry != mEntries.end() && iEntry->mEntity == entity;
+}
+
+} // namespace rigel::engine
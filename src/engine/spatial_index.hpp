@@ -0,0 +1,150 @@
+/* Copyright (C) 2022, Nikolai Wuttke. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "base/grid_layout.hpp"
+#include "base/warnings.hpp"
+#include "engine/base_components.hpp"
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+RIGEL_DISABLE_WARNINGS
+#include <entityx/entityx.h>
+RIGEL_RESTORE_WARNINGS
+
+
+namespace rigel::engine
+{
+
+/** Broad-phase index of entity bounding boxes, rebuilt once per frame
+ *
+ * Indexes all entities which have a WorldPosition and a BoundingBox, using a
+ * uniform grid over the map area. Systems doing overlap tests against many
+ * entities can query the index instead of each sweeping over all entities.
+ *
+ * The index captures bounding boxes at the time of the last build() call,
+ * so it should be rebuilt after anything that moves entities around, e.g.
+ * the physics update. Entities which have been destroyed since, or which
+ * lost one of the queried components, are skipped. Entities which gain a
+ * WorldPosition or BoundingBox after that (usually because they have just
+ * been spawned) are kept in a separate list until the next build(), and are
+ * tested using their current bounding box.
+ *
+ * Query results are visited in entity order, i.e. in the same order as
+ * entityx::EntityManager::each() would visit them.
+ *
+ * Queries reuse internal buffers, so they must not be issued from multiple
+ * threads at the same time. Issuing a query from within a query's callback
+ * is fine, though.
+ */
+class SpatialIndex : public entityx::Receiver<SpatialIndex>
+{
+public:
+  SpatialIndex(
+    int widthInTiles,
+    int heightInTiles,
+    entityx::EventManager& eventManager);
+
+  void build(entityx::EntityManager& es);
+
+  /** Invoke callback for each entity intersecting the given area
+   *
+   * Only entities which have all of the given components are considered.
+   * The callback receives the entity and references to these components.
+   */
+  template <typename... ComponentTs, typename Callback>
+  void forEachIntersecting(
+    const components::BoundingBox& area,
+    Callback&& callback) const
+  {
+    // Moving the buffer out of the member keeps it intact in case the
+    // callback issues another query.
+    auto candidates = std::move(mIntersectingBuffer);
+    collectIntersecting(area, candidates);
+
+    for (auto entity : candidates)
+    {
+      if (entity.valid() && (entity.has_component<ComponentTs>() && ...))
+      {
+        callback(entity, *entity.component<ComponentTs>()...);
+      }
+    }
+
+    mIntersectingBuffer = std::move(candidates);
+  }
+
+  /** First entity (in entity order) intersecting the given area
+   *
+   * Only entities which have all of the given components are considered.
+   * Returns an invalid entity if there is none.
+   */
+  template <typename... ComponentTs>
+  entityx::Entity firstIntersecting(const components::BoundingBox& area) const
+  {
+    collectIntersecting(area, mIntersectingBuffer);
+
+    for (auto entity : mIntersectingBuffer)
+    {
+      if (entity.valid() && (entity.has_component<ComponentTs>() && ...))
+      {
+        return entity;
+      }
+    }
+
+    return {};
+  }
+
+  void receive(
+    const entityx::ComponentAddedEvent<components::WorldPosition>& event);
+  void receive(
+    const entityx::ComponentAddedEvent<components::BoundingBox>& event);
+
+private:
+  struct Entry
+  {
+    entityx::Entity mEntity;
+    components::BoundingBox mBbox;
+  };
+
+  /** Fill result with all entities intersecting area, in entity order */
+  void collectIntersecting(
+    const components::BoundingBox& area,
+    std::vector<entityx::Entity>& result) const;
+
+  void addLateEntity(entityx::Entity entity);
+  bool isIndexed(entityx::Entity entity) const;
+
+  std::vector<Entry> mEntries;
+
+  // Entities which gained a position or bounding box since the last build(),
+  // sorted by entity index
+  std::vector<entityx::Entity> mLateEntities;
+
+  // The grid is stored in compressed form: The entries overlapping cell i are
+  // mCellContents[mCellStarts[i]] up to (excluding)
+  // mCellContents[mCellStarts[i + 1]], sorted by entry index.
+  std::vector<std::uint32_t> mCellStarts;
+  std::vector<std::uint32_t> mCellContents;
+  base::GridLayout mGrid;
+
+  mutable std::vector<std::uint32_t> mCandidateBuffer;
+  mutable std::vector<entityx::Entity> mIntersectingBuffer;
+};
+
+} // namespace rigel::engine
@@ -16,11 +16,24 @@
 
 #include "sprite_factory.hpp"
 
+#include "assets/asset_cache.hpp"
+#include "assets/file_utils.hpp"
 #include "assets/resource_loader.hpp"
 #include "base/container_utils.hpp"
+#include "base/parallel.hpp"
+#include "base/startup_timings.hpp"
 #include "data/unit_conversions.hpp"
 
+#include <loguru.hpp>
+
+#include <algorithm>
 #include <array>
+#include <cassert>
+#include <cstring>
+#include <iterator>
+#include <numeric>
+#include <optional>
+#include <string>
 
 
 namespace rigel::engine
@@ -375,6 +388,25 @@ void applyTweaks(
 }
 
 
+std::optional<base::Rect<int>>
+  boundsForFrames(const std::vector<engine::SpriteFrame>& frames)
+{
+  auto result = std::optional<base::Rect<int>>{};
+
+  for (const auto& frame : frames)
+  {
+    // Positions refer to a sprite's bottom left tile, see
+    // collectVisibleSprites() in sprite_rendering_system.cpp
+    const auto frameBounds = base::Rect<int>{
+      frame.mDrawOffset - base::Vec2{0, frame.mDimensions.height - 1},
+      frame.mDimensions};
+    result = result ? base::unite(*result, frameBounds) : frameBounds;
+  }
+
+  return result;
+}
+
+
 std::optional<int> orientationOffsetForActor(const ActorID actorId)
 {
   switch (actorId)
@@ -799,6 +831,310 @@ int adjustedDrawOrder(const ActorID id, const int baseDrawOrder)
   }
 }
 
+
+// With lazy loading, these are always kept resident since they can appear
+// in any level, or are needed by the HUD.
+constexpr auto CORE_SPRITE_ACTOR_IDS = std::array{
+  data::ActorID::Duke_LEFT,
+  data::ActorID::Duke_RIGHT,
+  data::ActorID::Duke_death_particles,
+  data::ActorID::Duke_rocket_up,
+  data::ActorID::Duke_rocket_down,
+  data::ActorID::Duke_rocket_left,
+  data::ActorID::Duke_rocket_right,
+  data::ActorID::Duke_flame_shot_up,
+  data::ActorID::Duke_flame_shot_down,
+  data::ActorID::Duke_flame_shot_left,
+  data::ActorID::Duke_flame_shot_right,
+  data::ActorID::Duke_laser_shot_horizontal,
+  data::ActorID::Duke_laser_shot_vertical,
+  data::ActorID::Duke_regular_shot_horizontal,
+  data::ActorID::Duke_regular_shot_vertical,
+  data::ActorID::Muzzle_flash_up,
+  data::ActorID::Muzzle_flash_down,
+  data::ActorID::Muzzle_flash_left,
+  data::ActorID::Muzzle_flash_right,
+  data::ActorID::Explosion_FX_1,
+  data::ActorID::Explosion_FX_2,
+  data::ActorID::Shot_impact_FX,
+  data::ActorID::Smoke_puff_FX,
+  data::ActorID::Smoke_cloud_FX,
+  data::ActorID::White_circle_flash_FX,
+  data::ActorID::Nuclear_explosion,
+  data::ActorID::Yellow_fireball_FX,
+  data::ActorID::Green_fireball_FX,
+  data::ActorID::Blue_fireball_FX,
+  data::ActorID::Score_number_FX_100,
+  data::ActorID::Score_number_FX_500,
+  data::ActorID::Score_number_FX_2000,
+  data::ActorID::Score_number_FX_5000,
+  data::ActorID::Score_number_FX_10000,
+  data::ActorID::White_box_circuit_card,
+  data::ActorID::White_box_blue_key,
+  data::ActorID::Special_hint_globe_icon,
+  data::ActorID::HUD_frame_background,
+  data::ActorID::Rapid_fire_icon,
+  data::ActorID::Cloaking_device_icon,
+  data::ActorID::Letter_collection_indicator_N,
+  data::ActorID::Letter_collection_indicator_U,
+  data::ActorID::Letter_collection_indicator_K,
+  data::ActorID::Letter_collection_indicator_E,
+  data::ActorID::Letter_collection_indicator_M,
+};
+
+
+constexpr auto SPRITE_ATLAS_CACHE_ENTRY = "sprite_atlas";
+
+static_assert(
+  sizeof(data::Pixel) == 4,
+  "Atlas cache stores palette colors as raw RGBA bytes");
+
+
+assets::ByteBuffer
+  serializeAtlas(const renderer::TextureAtlas::PackedIndexedImages& atlas)
+{
+  assets::LeStreamWriter writer;
+
+  writer.writeU32(std::uint32_t(atlas.mLocations.size()));
+
+  for (const auto& location : atlas.mLocations)
+  {
+    writer.writeU32(std::uint32_t(location.mRect.topLeft.x));
+    writer.writeU32(std::uint32_t(location.mRect.topLeft.y));
+    writer.writeU32(std::uint32_t(location.mRect.size.width));
+    writer.writeU32(std::uint32_t(location.mRect.size.height));
+    writer.writeU32(std::uint32_t(location.mTextureIndex));
+  }
+
+  writer.writeU32(std::uint32_t(atlas.mTextureImages.size()));
+
+  for (const auto& image : atlas.mTextureImages)
+  {
+    writer.writeU32(std::uint32_t(image.width()));
+    writer.writeU32(std::uint32_t(image.height()));
+
+    const auto& palette = image.palette();
+    writer.writeBytes(base::ArrayView<std::uint8_t>(
+      reinterpret_cast<const std::uint8_t*>(palette.data()),
+      palette.size() * sizeof(data::Pixel)));
+    writer.writeBytes(image.indexData());
+  }
+
+  return writer.buffer();
+}
+
+
+// Moves the frame images out of the given actor parts, in order
+void collectFrameImages(
+  std::vector<assets::ActorData>& actorParts,
+  std::vector<data::Image>& images,
+  bool& hasHighResReplacements)
+{
+  for (auto& actorData : actorParts)
+  {
+    for (auto& frameData : actorData.mFrames)
+    {
+      auto& image = frameData.mFrameImage;
+      if (
+        data::tilesToPixels(frameData.mLogicalSize.width) <
+          int(image.width()) ||
+        data::tilesToPixels(frameData.mLogicalSize.height) <
+          int(image.height()))
+      {
+        hasHighResReplacements = true;
+      }
+
+      images.emplace_back(std::move(image));
+    }
+  }
+}
+
+
+bool readCachedAtlas(
+  const base::ArrayView<std::uint8_t> payload,
+  const int expectedNumImages,
+  SpriteFactory::DecodedSprites& result)
+{
+  try
+  {
+    assets::LeStreamReader reader(payload);
+
+    const auto numImages = int(reader.readU32());
+    if (numImages != expectedNumImages)
+    {
+      return false;
+    }
+
+    auto atlas = renderer::TextureAtlas::PackedIndexedImages{};
+    atlas.mLocations.reserve(numImages);
+
+    for (auto i = 0; i < numImages; ++i)
+    {
+      const auto x = int(reader.readU32());
+      const auto y = int(reader.readU32());
+      const auto width = int(reader.readU32());
+      const auto height = int(reader.readU32());
+      const auto textureIndex = int(reader.readU32());
+      atlas.mLocations.push_back(
+        {base::Rect<int>{{x, y}, {width, height}}, textureIndex});
+    }
+
+    const auto numTextures = reader.readU32();
+    for (auto i = 0u; i < numTextures; ++i)
+    {
+      const auto width = std::size_t(reader.readU32());
+      const auto height = std::size_t(reader.readU32());
+
+      auto palette = data::Palette16{};
+      const auto paletteBytes = reader.peekBytes(sizeof(palette));
+      reader.skipBytes(sizeof(palette));
+      std::memcpy(palette.data(), paletteBytes.data(), sizeof(palette));
+
+      const auto indices = reader.peekBytes(width * height);
+      reader.skipBytes(width * height);
+
+      atlas.mTextureImages.emplace_back(
+        data::IndexedPixelBuffer(indices.begin(), indices.end()),
+        width,
+        height,
+        palette);
+    }
+
+    result.mAtlas = std::move(atlas);
+    return true;
+  }
+  catch (const std::exception& ex)
+  {
+    LOG_F(WARNING, "Ignoring invalid sprite atlas cache entry: %s", ex.what());
+    return false;
+  }
+}
+
+
+void logAtlasLayout(const renderer::TextureAtlas::Layout& layout)
+{
+  LOG_F(
+    INFO,
+    "Sprite atlas: %d images on %d textures, %.1f%% occupied",
+    int(layout.mLocations.size()),
+    int(layout.mTextureSizes.size()),
+    layout.occupancy() * 100.0f);
+}
+
+
+assets::ByteBuffer
+  serializeAtlasLayout(const renderer::TextureAtlas::Layout& layout)
+{
+  assets::LeStreamWriter writer;
+
+  writer.writeU32(std::uint32_t(layout.mLocations.size()));
+  for (const auto& location : layout.mLocations)
+  {
+    writer.writeU32(std::uint32_t(location.mRect.topLeft.x));
+    writer.writeU32(std::uint32_t(location.mRect.topLeft.y));
+    writer.writeU32(std::uint32_t(location.mRect.size.width));
+    writer.writeU32(std::uint32_t(location.mRect.size.height));
+    writer.writeU32(std::uint32_t(location.mTextureIndex));
+  }
+
+  writer.writeU32(std::uint32_t(layout.mTextureSizes.size()));
+  for (const auto& size : layout.mTextureSizes)
+  {
+    writer.writeU32(std::uint32_t(size.width));
+    writer.writeU32(std::uint32_t(size.height));
+  }
+
+  return writer.buffer();
+}
+
+
+std::optional<renderer::TextureAtlas::Layout> readCachedAtlasLayout(
+  const base::ArrayView<std::uint8_t> payload,
+  const std::vector<base::Size>& imageSizes)
+{
+  try
+  {
+    assets::LeStreamReader reader(payload);
+
+    auto layout = renderer::TextureAtlas::Layout{};
+
+    const auto numImages = reader.readU32();
+    if (numImages != imageSizes.size())
+    {
+      return std::nullopt;
+    }
+
+    for (auto i = 0u; i < numImages; ++i)
+    {
+      const auto x = int(reader.readU32());
+      const auto y = int(reader.readU32());
+      const auto width = int(reader.readU32());
+      const auto height = int(reader.readU32());
+      const auto textureIndex = int(reader.readU32());
+
+      // Entries are named after a hash of the sizes, so verify that we
+      // don't have a collision.
+      if (base::Size{width, height} != imageSizes[i])
+      {
+        return std::nullopt;
+      }
+
+      layout.mLocations.push_back(
+        {base::Rect<int>{{x, y}, {width, height}}, textureIndex});
+    }
+
+    const auto numTextures = reader.readU32();
+    for (auto i = 0u; i < numTextures; ++i)
+    {
+      const auto width = int(reader.readU32());
+      const auto height = int(reader.readU32());
+      layout.mTextureSizes.push_back({width, height});
+    }
+
+    return layout;
+  }
+  catch (const std::exception& ex)
+  {
+    LOG_F(WARNING, "Ignoring invalid atlas layout cache entry: %s", ex.what());
+    return std::nullopt;
+  }
+}
+
+
+renderer::TextureAtlas::Layout loadOrComputeAtlasLayout(
+  const std::vector<base::Size>& imageSizes,
+  const assets::AssetCache* pAssetCache)
+{
+  auto hasher = assets::CacheKeyHasher{};
+  for (const auto& size : imageSizes)
+  {
+    hasher.add(std::uint64_t(size.width)).add(std::uint64_t(size.height));
+  }
+
+  const auto entryName = "atlas_layout_" + std::to_string(hasher.value());
+
+  if (pAssetCache)
+  {
+    if (const auto entry = pAssetCache->load(entryName))
+    {
+      if (auto layout = readCachedAtlasLayout(entry->data(), imageSizes))
+      {
+        return std::move(*layout);
+      }
+    }
+  }
+
+  auto layout = renderer::TextureAtlas::computeLayout(imageSizes);
+  logAtlasLayout(layout);
+
+  if (pAssetCache)
+  {
+    pAssetCache->store(entryName, serializeAtlasLayout(layout));
+  }
+
+  return layout;
+}
+
 } // namespace
 
 
@@ -861,30 +1197,95 @@ std::vector<int> buildImageIdTable(const assets::ResourceLoader& resources)
 SpriteFactory::SpriteFactory(
   renderer::Renderer* pRenderer,
   const assets::ResourceLoader* pResourceLoader)
-  : SpriteFactory(construct(pRenderer, pResourceLoader))
+  : SpriteFactory(pRenderer, decodeSprites(pResourceLoader))
 {
 }
 
 
-SpriteFactory::SpriteFactory(CtorArgs args)
-  : mSpriteDataMap(std::move(std::get<0>(args)))
-  , mSpritesTextureAtlas(std::move(std::get<1>(args)))
-  , mHasHighResReplacements(std::get<2>(args))
+SpriteFactory::SpriteFactory(
+  renderer::Renderer* pRenderer,
+  DecodedSprites decodedSprites)
+  : mSpritesTextureAtlas(base::startup_timings::measure(
+      "Sprite atlas upload",
+      [&]() {
+        return renderer::TextureAtlas(pRenderer, decodedSprites.mAtlas);
+      }))
+  , mHasHighResReplacements(decodedSprites.mHasHighResReplacements)
+  , mpResources(decodedSprites.mpLazyLoadingResources)
+  , mpAssetCache(decodedSprites.mpLazyLoadingAssetCache)
 {
+  auto& decodedData = decodedSprites.mSpriteDataMap;
+
+  // Sorted by ID, so that the layout doesn't depend on the map's iteration
+  // order
+  auto ids = std::vector<ActorID>{};
+  ids.reserve(decodedData.size());
+  for (const auto& entry : decodedData)
+  {
+    ids.push_back(entry.first);
+  }
+  std::sort(ids.begin(), ids.end());
+
+  mSpriteIndexByActor.fill(-1);
+  mSprites.reserve(ids.size());
+
+  for (const auto id : ids)
+  {
+    mSpriteIndexByActor[static_cast<size_t>(id)] = int(mSprites.size());
+    mSprites.push_back(std::move(decodedData.at(id)));
+  }
+
+  for (const auto id : ids)
+  {
+    auto& data = mSprites[mSpriteIndexByActor[static_cast<size_t>(id)]];
+    data.mPrototype = Sprite{&data.mDrawData, data.mInitialFramesToRender};
+    configureSprite(data.mPrototype, id);
+  }
+
+  buildFrameTables();
+
+  if (mpResources)
+  {
+    for (const auto id : ids)
+    {
+      const auto& data = spriteData(id);
+      const auto endImageId = data.mFirstImageId + data.mNumImages;
+      if (mImageOwners.size() < size_t(endImageId))
+      {
+        mImageOwners.resize(endImageId);
+      }
+
+      std::fill(
+        mImageOwners.begin() + data.mFirstImageId,
+        mImageOwners.begin() + endImageId,
+        id);
+    }
+  }
+
+  auto spriteDataBytes = mImageOwners.size() * sizeof(ActorID) +
+    sizeof(mSpriteIndexByActor) +
+    mFrameRects.size() * (sizeof(base::Rect<int>) + sizeof(int));
+  for (const auto& data : mSprites)
+  {
+    spriteDataBytes += sizeof(SpriteData) +
+      data.mDrawData.mFrames.size() * sizeof(SpriteFrame) +
+      data.mInitialFramesToRender.size() * sizeof(int);
+  }
+
+  mSpriteDataMemory.set(spriteDataBytes);
 }
 
 
-auto SpriteFactory::construct(
-  renderer::Renderer* pRenderer,
-  const assets::ResourceLoader* pResourceLoader) -> CtorArgs
+auto SpriteFactory::decodeSpriteMetadata(
+  const assets::ResourceLoader* pResourceLoader) -> DecodedSprites
 {
-  bool highResReplacementsFound = false;
-
-  std::unordered_map<data::ActorID, SpriteData> spriteDataMap;
+  auto result = DecodedSprites{};
+  result.mpLazyLoadingResources = pResourceLoader;
 
-  std::vector<data::Image> spriteImages;
-  spriteImages.reserve(INGAME_SPRITE_ACTOR_IDS.size());
+  auto numImages = 0;
 
+  // The metadata only needs the actor headers, which are cheap to load. The
+  // images are only decoded if they aren't available from the cache.
   for (const auto mainId : INGAME_SPRITE_ACTOR_IDS)
   {
     engine::SpriteDrawData drawData;
@@ -893,42 +1294,22 @@ auto SpriteFactory::construct(
     int lastFrameCount = 0;
     std::vector<int> framesToRender;
 
-    const auto actorPartIds = actorIDListForActor(mainId);
-
-    // non-const so we can move the Image objects into the vector
-    auto actorParts =
-      utils::transformed(actorPartIds, [&](const ActorID partId) {
-        return pResourceLoader->loadActor(partId);
-      });
+    const auto firstImageId = numImages;
 
-    // Similarly, non-const for move semantics
-    for (auto& actorData : actorParts)
+    for (const auto partId : actorIDListForActor(mainId))
     {
-      lastDrawOrder = actorData.mDrawIndex;
+      const auto& actorInfo = pResourceLoader->loadActorInfo(partId);
+      lastDrawOrder = actorInfo.mDrawIndex;
 
-      // Similarly, non-const for move semantics
-      for (auto& frameData : actorData.mFrames)
+      for (const auto& frameHeader : actorInfo.mFrames)
       {
-        auto& image = frameData.mFrameImage;
         drawData.mFrames.emplace_back(engine::SpriteFrame{
-          int(spriteImages.size()),
-          frameData.mDrawOffset,
-          frameData.mLogicalSize});
-
-        if (
-          data::tilesToPixels(frameData.mLogicalSize.width) <
-            int(image.width()) ||
-          data::tilesToPixels(frameData.mLogicalSize.height) <
-            int(image.height()))
-        {
-          highResReplacementsFound = true;
-        }
-
-        spriteImages.emplace_back(std::move(image));
+          numImages, frameHeader.mDrawOffset, frameHeader.mSizeInTiles});
+        ++numImages;
       }
 
       framesToRender.push_back(lastFrameCount);
-      lastFrameCount = int(actorData.mFrames.size());
+      lastFrameCount = int(actorInfo.mFrames.size());
     }
 
     drawData.mOrientationOffset = orientationOffsetForActor(mainId);
@@ -936,42 +1317,315 @@ auto SpriteFactory::construct(
     drawData.mDrawOrder = adjustedDrawOrder(mainId, lastDrawOrder);
 
     applyTweaks(drawData.mFrames, mainId);
+    drawData.mBounds = boundsForFrames(drawData.mFrames);
+
+    result.mSpriteDataMap.emplace(
+      mainId,
+      SpriteData{
+        std::move(drawData),
+        std::move(framesToRender),
+        {},
+        firstImageId,
+        numImages - firstImageId,
+        0,
+        0});
+  }
+
+  return result;
+}
+
 
-    spriteDataMap.emplace(
-      mainId, SpriteData{std::move(drawData), std::move(framesToRender)});
+auto SpriteFactory::decodeSprites(
+  const assets::ResourceLoader* pResourceLoader,
+  const assets::AssetCache* pAssetCache) -> DecodedSprites
+{
+  auto result = decodeSpriteMetadata(pResourceLoader);
+
+  // Replacement sprites can be very large, so only load those which are
+  // actually needed by the current level.
+  if (pResourceLoader->hasSpriteReplacements())
+  {
+    LOG_F(INFO, "Sprite replacements found, using lazy sprite loading");
+    result.mpLazyLoadingAssetCache = pAssetCache;
+    return result;
+  }
+
+  result.mpLazyLoadingResources = nullptr;
+
+  const auto numImages = std::accumulate(
+    result.mSpriteDataMap.begin(),
+    result.mSpriteDataMap.end(),
+    0,
+    [](const int sum, const auto& entry) {
+      return sum + entry.second.mNumImages;
+    });
+
+  if (pAssetCache)
+  {
+    if (const auto entry = pAssetCache->load(SPRITE_ATLAS_CACHE_ENTRY))
+    {
+      if (readCachedAtlas(entry->data(), numImages, result))
+      {
+        return result;
+      }
+    }
   }
 
-  return {
-    std::move(spriteDataMap),
-    renderer::TextureAtlas{pRenderer, spriteImages},
-    highResReplacementsFound};
+  // Decoding the actor images is the expensive part, so that's done in
+  // parallel. Without replacements, all images are 16-color, so we keep
+  // them indexed until the atlas textures are created. This keeps peak
+  // memory use during decoding at a quarter of what RGBA images need.
+  auto allActorFrames = std::vector<std::vector<data::IndexedImage>>(
+    INGAME_SPRITE_ACTOR_IDS.size());
+  base::parallelFor(INGAME_SPRITE_ACTOR_IDS.size(), [&](const std::size_t i) {
+    for (const auto partId : actorIDListForActor(INGAME_SPRITE_ACTOR_IDS[i]))
+    {
+      auto frames = pResourceLoader->loadIndexedActorFrames(partId);
+      std::move(
+        frames.begin(), frames.end(), std::back_inserter(allActorFrames[i]));
+    }
+  });
+
+  std::vector<data::IndexedImage> spriteImages;
+  spriteImages.reserve(numImages);
+
+  // Non-const for move semantics
+  for (auto& actorFrames : allActorFrames)
+  {
+    std::move(
+      actorFrames.begin(), actorFrames.end(), std::back_inserter(spriteImages));
+  }
+
+  const auto layout = renderer::TextureAtlas::computeLayout(
+    utils::transformed(spriteImages, [](const data::IndexedImage& image) {
+      return base::Size{int(image.width()), int(image.height())};
+    }));
+  logAtlasLayout(layout);
+
+  result.mAtlas = renderer::TextureAtlas::pack(spriteImages, layout);
+
+  if (pAssetCache)
+  {
+    pAssetCache->store(SPRITE_ATLAS_CACHE_ENTRY, serializeAtlas(result.mAtlas));
+  }
+
+  return result;
 }
 
 
 Sprite SpriteFactory::createSprite(const ActorID id)
 {
-  const auto& data = mSpriteDataMap.at(id);
-  auto sprite = Sprite{&data.mDrawData, data.mInitialFramesToRender};
-  configureSprite(sprite, id);
-  return sprite;
+  const auto& data = spriteData(id);
+
+  if (mpResources && !mResidentActors.count(id))
+  {
+    DLOG_F(INFO, "Loading sprite for actor %d on demand", int(id));
+    loadActorImages({id});
+  }
+
+  return data.mPrototype;
+}
+
+
+void SpriteFactory::prefetchActors(const base::ArrayView<data::ActorID> ids)
+{
+  if (!mpResources)
+  {
+    return;
+  }
+
+  auto actorsToLoad = std::unordered_set<ActorID>{
+    CORE_SPRITE_ACTOR_IDS.begin(), CORE_SPRITE_ACTOR_IDS.end()};
+  for (const auto id : ids)
+  {
+    if (hasSprite(id))
+    {
+      actorsToLoad.insert(id);
+    }
+  }
+
+  // Restarting the same level, everything is still there
+  if (actorsToLoad == mPrefetchedActors)
+  {
+    return;
+  }
+
+  // The textures are shared between actors, so individual actors can't be
+  // released. Instead, we start over with an empty atlas. Sprites which were
+  // created before this call keep working as long as their actor is part of
+  // the new set, since image IDs don't change.
+  mSpritesTextureAtlas.clear();
+  mResidentActors.clear();
+
+  loadActorImages(
+    std::vector<ActorID>{actorsToLoad.begin(), actorsToLoad.end()});
+  mPrefetchedActors = std::move(actorsToLoad);
+
+  LOG_F(INFO, "Loaded sprites for %d actors", int(mResidentActors.size()));
+}
+
+
+void SpriteFactory::requireImage(const int imageId)
+{
+  if (!mpResources || mSpritesTextureAtlas.contains(imageId))
+  {
+    return;
+  }
+
+  const auto id = mImageOwners[imageId];
+  if (!mResidentActors.count(id))
+  {
+    DLOG_F(INFO, "Loading sprite for actor %d on demand", int(id));
+    loadActorImages({id});
+  }
+}
+
+
+bool SpriteFactory::reloadActorImages(const std::vector<ActorID>& changedIds)
+{
+  if (!mpResources)
+  {
+    return false;
+  }
+
+  auto isAffected = [&](const ActorID id) {
+    const auto partIds = actorIDListForActor(id);
+    return std::any_of(partIds.begin(), partIds.end(), [&](const ActorID part) {
+      return std::find(changedIds.begin(), changedIds.end(), part) !=
+        changedIds.end();
+    });
+  };
+
+  auto actorsToReload = std::vector<ActorID>{};
+  std::copy_if(
+    mResidentActors.begin(),
+    mResidentActors.end(),
+    std::back_inserter(actorsToReload),
+    isAffected);
+
+  // The new images are added as additional textures, replacing the atlas
+  // entries for the reloaded actors. The previous textures stay around until
+  // the atlas is cleared on the next prefetch.
+  if (!actorsToReload.empty())
+  {
+    LOG_F(INFO, "Reloading sprites for %d actors", int(actorsToReload.size()));
+    loadActorImages(actorsToReload);
+  }
+
+  return true;
+}
+
+
+void SpriteFactory::loadActorImages(const std::vector<ActorID>& ids)
+{
+  auto allActorParts = std::vector<std::vector<assets::ActorData>>(ids.size());
+  base::parallelFor(ids.size(), [&](const std::size_t i) {
+    allActorParts[i] = utils::transformed(
+      actorIDListForActor(ids[i]),
+      [&](const ActorID partId) { return mpResources->loadActor(partId); });
+  });
+
+  std::vector<data::Image> images;
+  std::vector<int> imageIds;
+
+  for (auto i = 0u; i < ids.size(); ++i)
+  {
+    collectFrameImages(allActorParts[i], images, mHasHighResReplacements);
+
+    const auto& data = spriteData(ids[i]);
+    for (auto imageId = data.mFirstImageId;
+         imageId < data.mFirstImageId + data.mNumImages;
+         ++imageId)
+    {
+      imageIds.push_back(imageId);
+    }
+
+    mResidentActors.insert(ids[i]);
+  }
+
+  // With replacement sprites, this can be thousands of images. Since levels
+  // often use the same set of actors, the layout is usually in the cache
+  // already.
+  const auto layout = loadOrComputeAtlasLayout(
+    utils::transformed(
+      images,
+      [](const data::Image& image) {
+        return base::Size{int(image.width()), int(image.height())};
+      }),
+    mpAssetCache);
+
+  mSpritesTextureAtlas.addImages(
+    imageIds, renderer::TextureAtlas::pack(images, layout));
 }
 
 
 base::Rect<int>
   SpriteFactory::actorFrameRect(const data::ActorID id, const int frame) const
 {
-  const auto& frameData = actorFrameData(id, frame);
-  return {frameData.mDrawOffset, frameData.mDimensions};
+  return mFrameRects[frameEntry(id, frame)];
 }
 
 
 engine::SpriteFrame
   SpriteFactory::actorFrameData(data::ActorID id, int frame) const
 {
-  const auto& data = mSpriteDataMap.at(id);
-  const auto realFrame =
-    virtualToRealFrame(frame, data.mDrawData, std::nullopt);
-  return data.mDrawData.mFrames[realFrame];
+  const auto entry = frameEntry(id, frame);
+  const auto& rect = mFrameRects[entry];
+  return {mFrameImageIds[entry], rect.topLeft, rect.size};
+}
+
+
+bool SpriteFactory::hasSprite(const data::ActorID id) const
+{
+  const auto index = static_cast<size_t>(id);
+  return index < mSpriteIndexByActor.size() && mSpriteIndexByActor[index] >= 0;
+}
+
+
+auto SpriteFactory::spriteData(const data::ActorID id) const
+  -> const SpriteData&
+{
+  assert(hasSprite(id));
+  return mSprites[mSpriteIndexByActor[static_cast<size_t>(id)]];
+}
+
+
+int SpriteFactory::frameEntry(const data::ActorID id, const int frame) const
+{
+  const auto& data = spriteData(id);
+  assert(frame >= 0 && frame < data.mNumFrameEntries);
+  return data.mFirstFrameEntry + frame;
+}
+
+
+void SpriteFactory::buildFrameTables()
+{
+  for (auto& data : mSprites)
+  {
+    const auto& drawData = data.mDrawData;
+    const auto numVirtualFrames = drawData.mVirtualToRealFrameMap.empty()
+      ? int(drawData.mFrames.size())
+      : int(drawData.mVirtualToRealFrameMap.size());
+
+    data.mFirstFrameEntry = int(mFrameRects.size());
+    data.mNumFrameEntries = numVirtualFrames;
+
+    for (auto frame = 0; frame < numVirtualFrames; ++frame)
+    {
+      // Guard against frame maps referring to frames the actor doesn't have
+      const auto realFrame = virtualToRealFrame(frame, drawData, std::nullopt);
+      if (realFrame < 0 || realFrame >= int(drawData.mFrames.size()))
+      {
+        mFrameRects.push_back({});
+        mFrameImageIds.push_back(-1);
+        continue;
+      }
+
+      const auto& frameData = drawData.mFrames[realFrame];
+      mFrameRects.push_back({frameData.mDrawOffset, frameData.mDimensions});
+      mFrameImageIds.push_back(frameData.mImageId);
+    }
+  }
 }
 
 } // namespace rigel::engine
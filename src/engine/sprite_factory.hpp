@@ -16,16 +16,20 @@
 
 #pragma once
 
+#include "base/memory_accounting.hpp"
 #include "data/game_traits.hpp"
 #include "engine/isprite_factory.hpp"
 #include "renderer/texture_atlas.hpp"
 
+#include <array>
 #include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 
 namespace rigel::assets
 {
+class AssetCache;
 class ResourceLoader;
 }
 namespace rigel::renderer
@@ -53,16 +57,67 @@ std::vector<int> buildImageIdTable(const assets::ResourceLoader& resources);
 class SpriteFactory : public ISpriteFactory
 {
 public:
+  /** Sprite images and metadata, not yet uploaded to the GPU */
+  struct DecodedSprites;
+
+  /** Load and decode all sprites
+   *
+   * Doesn't need a renderer, so this can run on a worker thread while other
+   * initialization is going on. If an asset cache is given, the packed
+   * sprite atlas is read from it when available, and stored otherwise.
+   *
+   * If any sprite replacements are present, this only decodes metadata,
+   * like decodeSpriteMetadata().
+   */
+  static DecodedSprites decodeSprites(
+    const assets::ResourceLoader* pResourceLoader,
+    const assets::AssetCache* pAssetCache = nullptr);
+
+  /** Load sprite metadata only, for lazy loading
+   *
+   * A factory created from the result starts out without any sprite images.
+   * These are loaded per level in prefetchActors(), and on first use for
+   * any actors not covered by that. This keeps startup time and VRAM use
+   * low when using large replacement sprites.
+   */
+  static DecodedSprites
+    decodeSpriteMetadata(const assets::ResourceLoader* pResourceLoader);
+
   SpriteFactory(
     renderer::Renderer* pRenderer,
     const assets::ResourceLoader* pResourceLoader);
+  SpriteFactory(renderer::Renderer* pRenderer, DecodedSprites decodedSprites);
 
   engine::components::Sprite createSprite(data::ActorID id) override;
   base::Rect<int> actorFrameRect(data::ActorID id, int frame) const override;
   SpriteFrame actorFrameData(data::ActorID id, int frame) const override;
+  void prefetchActors(base::ArrayView<data::ActorID> ids) override;
+
+  /** Make sure the given sprite image can be drawn
+   *
+   * Only needed when drawing by image ID without having gone through
+   * createSprite() first. Does nothing unless lazy loading is in use.
+   */
+  void requireImage(int imageId);
+
+  /** Load images again for actors using any of the given actor IDs' frames
+   *
+   * For hot-reloading replacement sprites that were modified while the game
+   * is running. Only possible when lazy loading is in use, returns false
+   * otherwise. Actors which aren't currently loaded pick up the new images
+   * when they are next needed, so only resident ones are reloaded here.
+   */
+  bool reloadActorImages(const std::vector<data::ActorID>& changedIds);
 
   bool hasHighResReplacements() const { return mHasHighResReplacements; }
 
+  /** True if sprite images are loaded on first use
+   *
+   * createSprite() then creates textures for actors which haven't been
+   * prefetched, so it must only be called on the main thread.
+   */
+  bool loadsImagesOnDemand() const { return mpResources != nullptr; }
+
   const renderer::TextureAtlas& textureAtlas() const
   {
     return mSpritesTextureAtlas;
@@ -73,21 +128,61 @@ private:
   {
     engine::SpriteDrawData mDrawData;
     std::vector<int> mInitialFramesToRender;
+
+    // Fully configured sprite, prepared once on construction. Spawning
+    // entities just copies this.
+    engine::components::Sprite mPrototype;
+
+    // Range of atlas image IDs holding this actor's frames
+    int mFirstImageId;
+    int mNumImages;
+
+    // This actor's range of entries in mFrameRects and mFrameImageIds
+    int mFirstFrameEntry;
+    int mNumFrameEntries;
   };
 
-  using CtorArgs = std::tuple<
-    std::unordered_map<data::ActorID, SpriteData>,
-    renderer::TextureAtlas,
-    bool>;
+  bool hasSprite(data::ActorID id) const;
+  const SpriteData& spriteData(data::ActorID id) const;
+  int frameEntry(data::ActorID id, int frame) const;
+  void buildFrameTables();
+  void loadActorImages(const std::vector<data::ActorID>& ids);
 
-  SpriteFactory(CtorArgs args);
-  static CtorArgs construct(
-    renderer::Renderer* pRenderer,
-    const assets::ResourceLoader* pResourceLoader);
+  // Per-actor data, addressed via mSpriteIndexByActor (-1 for actors
+  // without a sprite). Sprites point into the entries, so the vector is
+  // never resized after construction.
+  std::vector<SpriteData> mSprites;
+  std::array<int, data::TOTAL_NUM_ACTOR_IDS> mSpriteIndexByActor;
+
+  // Frame metadata of all actors, one entry per virtual frame, with the
+  // virtual to real frame mapping already applied. Frame queries from
+  // collision and HUD code are a single lookup this way.
+  std::vector<base::Rect<int>> mFrameRects;
+  std::vector<int> mFrameImageIds;
 
-  std::unordered_map<data::ActorID, SpriteData> mSpriteDataMap;
   renderer::TextureAtlas mSpritesTextureAtlas;
   bool mHasHighResReplacements;
+
+  // Only used for lazy loading
+  const assets::ResourceLoader* mpResources;
+  const assets::AssetCache* mpAssetCache;
+  std::vector<data::ActorID> mImageOwners;
+  std::unordered_set<data::ActorID> mResidentActors;
+  std::unordered_set<data::ActorID> mPrefetchedActors;
+  base::TrackedMemory mSpriteDataMemory{base::MemoryCategory::SpriteData};
+};
+
+
+struct SpriteFactory::DecodedSprites
+{
+  std::unordered_map<data::ActorID, SpriteData> mSpriteDataMap;
+  renderer::TextureAtlas::PackedIndexedImages mAtlas;
+  bool mHasHighResReplacements = false;
+
+  // Set if only the metadata was decoded, images are then loaded on demand
+  // from here
+  const assets::ResourceLoader* mpLazyLoadingResources = nullptr;
+  const assets::AssetCache* mpLazyLoadingAssetCache = nullptr;
 };
 
 } // namespace rigel::engine
@@ -26,6 +26,7 @@
 
 #include <algorithm>
 #include <functional>
+#include <numeric>
 
 
 namespace ex = entityx;
@@ -45,6 +46,49 @@ using components::WorldPosition;
 namespace
 {
 
+// Sorting by draw order uses a counting sort if there are at most this many
+// distinct sort keys, and falls back to std::stable_sort otherwise.
+constexpr auto MAX_COUNTING_SORT_KEYS = 256;
+
+
+// Components which affect how a sprite is drawn, looked up once per entity
+struct SpriteRenderRecord
+{
+  base::Vec2 mPreviousPosition;
+  std::optional<Orientation> mOrientation;
+  int mDrawOrder;
+  bool mDrawTopMost;
+};
+
+
+SpriteRenderRecord makeRenderRecord(
+  ex::Entity entity,
+  const Sprite& sprite,
+  const WorldPosition& position)
+{
+  using components::DrawTopMost;
+  using components::OverrideDrawOrder;
+
+  const auto& previousPosition = entity.has_component<InterpolateMotion>()
+    ? entity.component<InterpolateMotion>()->mPreviousPosition
+    : position;
+
+  const auto orientation = entity.has_component<const Orientation>()
+    ? std::make_optional(*entity.component<const Orientation>())
+    : std::optional<Orientation>{};
+
+  const auto drawOrder = entity.has_component<OverrideDrawOrder>()
+    ? entity.component<const OverrideDrawOrder>()->mDrawOrder
+    : sprite.mpDrawData->mDrawOrder;
+
+  return {
+    previousPosition,
+    orientation,
+    drawOrder,
+    entity.has_component<DrawTopMost>()};
+}
+
+
 void advanceAnimation(Sprite& sprite, AnimationLoop& animated)
 {
   const auto numFrames = static_cast<int>(sprite.mpDrawData->mFrames.size());
@@ -68,17 +112,19 @@ void advanceAnimation(Sprite& sprite, AnimationLoop& animated)
 }
 
 
-void collectVisibleSprites(
+// Returns the number of sprites skipped because they are outside of the
+// view. Entities skipped as a whole count once, frames of partially visible
+// sprites count individually.
+int collectVisibleSprites(
   ex::EntityManager& es,
   const base::Vec2& cameraPosition,
   const base::Size& viewportSize,
-  std::vector<SortableDrawSpec>& output,
-  const float interpolationFactor)
+  std::vector<SortableDrawSpec>& output)
 {
+  auto numCulled = 0;
+
   using components::BoundingBox;
-  using components::DrawTopMost;
   using components::ExtendedFrameList;
-  using components::OverrideDrawOrder;
   using components::SpriteStrip;
 
   const auto screenBox = BoundingBox{{}, viewportSize};
@@ -106,21 +152,38 @@ void collectVisibleSprites(
     const auto frameBox = BoundingBox{topLeft, frame.mDimensions};
     if (!frameBox.intersects(screenBox))
     {
+      ++numCulled;
       return;
     }
 
     const auto previousTopLeft = drawPosition(frame, previousPosition);
+    const auto size = data::tilesToPixels(frame.mDimensions);
 
-    const auto destRect = base::Rect<int>{
-      engine::interpolatedPixelPosition(
-        previousTopLeft, topLeft, interpolationFactor),
-      data::tilesToPixels(frame.mDimensions)};
-    const auto drawSpec =
-      SpriteDrawSpec{destRect, frame.mImageId, flashingWhite, useCloakEffect};
+    const auto drawSpec = SpriteDrawSpec{
+      {data::tilesToPixels(topLeft), size},
+      {data::tilesToPixels(previousTopLeft), size},
+      frame.mImageId,
+      flashingWhite,
+      useCloakEffect};
 
     output.push_back({drawSpec, drawOrder, drawTopmost});
   };
 
+  // Only extended frame lists and sprite strips can draw outside of a
+  // sprite's bounds. Without those, sprites which are entirely outside of the
+  // view can be skipped before looking up any other components.
+  auto isOutsideView = [&](const Sprite& sprite, const WorldPosition& pos) {
+    const auto& oBounds = sprite.mpDrawData->mBounds;
+    if (!oBounds)
+    {
+      return false;
+    }
+
+    auto bounds = *oBounds;
+    bounds.topLeft += pos - cameraPosition;
+    return !bounds.intersects(screenBox);
+  };
+
 
   es.each<Sprite, WorldPosition>(
     [&](
@@ -130,14 +193,19 @@ void collectVisibleSprites(
         return;
       }
 
-      const auto& previousPosition = entity.has_component<InterpolateMotion>()
-        ? entity.component<InterpolateMotion>()->mPreviousPosition
-        : position;
+      if (
+        isOutsideView(sprite, position) &&
+        !entity.has_component<ExtendedFrameList>() &&
+        !entity.has_component<SpriteStrip>())
+      {
+        ++numCulled;
+        return;
+      }
 
-      const auto drawTopmost = entity.has_component<DrawTopMost>();
-      const auto drawOrder = entity.has_component<OverrideDrawOrder>()
-        ? entity.component<const OverrideDrawOrder>()->mDrawOrder
-        : sprite.mpDrawData->mDrawOrder;
+      const auto record = makeRenderRecord(entity, sprite, position);
+      const auto& previousPosition = record.mPreviousPosition;
+      const auto drawTopmost = record.mDrawTopMost;
+      const auto drawOrder = record.mDrawOrder;
 
       auto slotIndex = 0;
       for (const auto& baseFrameIndex : sprite.mFramesToRender)
@@ -149,8 +217,8 @@ void collectVisibleSprites(
           continue;
         }
 
-        const auto frameIndex =
-          virtualToRealFrame(baseFrameIndex, *sprite.mpDrawData, entity);
+        const auto frameIndex = virtualToRealFrame(
+          baseFrameIndex, *sprite.mpDrawData, record.mOrientation);
         submit(
           sprite.mpDrawData->mFrames[frameIndex],
           previousPosition,
@@ -168,8 +236,8 @@ void collectVisibleSprites(
           entity.component<ExtendedFrameList>()->mFrames;
         for (const auto& item : extendedList)
         {
-          const auto frameIndex =
-            virtualToRealFrame(item.mFrame, *sprite.mpDrawData, entity);
+          const auto frameIndex = virtualToRealFrame(
+            item.mFrame, *sprite.mpDrawData, record.mOrientation);
           submit(
             sprite.mpDrawData->mFrames[frameIndex],
             previousPosition + item.mOffset,
@@ -184,8 +252,8 @@ void collectVisibleSprites(
       if (entity.has_component<SpriteStrip>())
       {
         const auto& strip = *entity.component<SpriteStrip>();
-        const auto frameIndex =
-          virtualToRealFrame(strip.mFrame, *sprite.mpDrawData, entity);
+        const auto frameIndex = virtualToRealFrame(
+          strip.mFrame, *sprite.mpDrawData, record.mOrientation);
         const auto& frame = sprite.mpDrawData->mFrames[frameIndex];
 
         const auto topLeft = drawPosition(frame, strip.mStartPosition);
@@ -197,24 +265,48 @@ void collectVisibleSprites(
            std::max(strip.mHeight, strip.mPreviousHeight)}};
         if (!frameBox.intersects(screenBox))
         {
+          ++numCulled;
           return;
         }
 
+        const auto pixelTopLeft = data::tilesToPixels(topLeft);
         const auto width = data::tilesToPixels(frame.mDimensions.width);
-        const auto height = base::round(data::tilesToPixels(base::lerp(
-          float(strip.mPreviousHeight),
-          float(strip.mHeight),
-          interpolationFactor)));
-
-        const auto destRect =
-          base::Rect<int>{data::tilesToPixels(topLeft), {width, height}};
 
         const auto useCloakEffect = sprite.mUseCloakEffect;
-        const auto drawSpec =
-          SpriteDrawSpec{destRect, frame.mImageId, false, useCloakEffect};
+        const auto drawSpec = SpriteDrawSpec{
+          {pixelTopLeft, {width, data::tilesToPixels(strip.mHeight)}},
+          {pixelTopLeft, {width, data::tilesToPixels(strip.mPreviousHeight)}},
+          frame.mImageId,
+          false,
+          useCloakEffect};
         output.push_back({drawSpec, drawOrder, drawTopmost});
       }
     });
+
+  return numCulled;
+}
+
+
+base::Rect<int> interpolatedRect(
+  const base::Rect<int>& previous,
+  const base::Rect<int>& current,
+  const float interpolationFactor)
+{
+  const auto size = lerpRounded(
+    base::Vec2{previous.size.width, previous.size.height},
+    base::Vec2{current.size.width, current.size.height},
+    interpolationFactor);
+
+  return {
+    lerpRounded(previous.topLeft, current.topLeft, interpolationFactor),
+    {size.x, size.y}};
+}
+
+
+// Area potentially covered by a sprite for any interpolation factor
+base::Rect<int> coveredArea(const SpriteDrawSpec& spec)
+{
+  return base::unite(spec.mDestRect, spec.mPreviousDestRect);
 }
 
 } // namespace
@@ -322,79 +414,269 @@ void SpriteRenderingSystem::update(
   const base::Vec2& cameraPosition,
   const float interpolationFactor)
 {
-  using std::back_inserter;
+  collectSprites(es, viewportSize, cameraPosition);
+  recordCommands(interpolationFactor);
+}
+
+
+void SpriteRenderingSystem::updateInterpolation(
+  ex::EntityManager& es,
+  const base::Size& viewportSize,
+  const base::Vec2& cameraPosition,
+  const float interpolationFactor)
+{
+  if (
+    mNeedsCollection || viewportSize != mCollectedViewportSize ||
+    cameraPosition != mCollectedCameraPosition)
+  {
+    update(es, viewportSize, cameraPosition, interpolationFactor);
+    return;
+  }
+
+  recordCommands(interpolationFactor);
+}
+
+
+void SpriteRenderingSystem::collectSprites(
+  ex::EntityManager& es,
+  const base::Size& viewportSize,
+  const base::Vec2& cameraPosition)
+{
   using std::begin;
   using std::end;
 
+  mNeedsCollection = false;
+  mCollectedViewportSize = viewportSize;
+  mCollectedCameraPosition = cameraPosition;
+
   mSortBuffer.clear();
-  collectVisibleSprites(
-    es, cameraPosition, viewportSize, mSortBuffer, interpolationFactor);
-  std::stable_sort(begin(mSortBuffer), end(mSortBuffer));
-
-  mSprites.clear();
-  mSprites.reserve(mSortBuffer.size());
-  std::transform(
-    begin(mSortBuffer),
-    end(mSortBuffer),
-    back_inserter(mSprites),
-    [](const SortableDrawSpec& sortableSpec) { return sortableSpec.mSpec; });
-
-  const auto iFirstTopMostSprite = std::find_if(
-    begin(mSortBuffer),
-    end(mSortBuffer),
-    std::mem_fn(&SortableDrawSpec::mDrawTopMost));
-
-  miForegroundSprites = std::next(
-    begin(mSprites), std::distance(begin(mSortBuffer), iFirstTopMostSprite));
-
-  mCloakEffectSpritesVisible =
-    std::any_of(begin(mSprites), end(mSprites), [](const SpriteDrawSpec& spec) {
-      return spec.mUseCloakEffect;
+  const auto numCulled =
+    collectVisibleSprites(es, cameraPosition, viewportSize, mSortBuffer);
+  mStatistics = {int(mSortBuffer.size()), numCulled};
+  sortByDrawOrder();
+
+  // Within each range of sprites sharing the same draw order, group sprites
+  // by texture (see assignBatchGroups()), and then sort again to bring
+  // the groups together.
+  for (auto iBucket = begin(mSortBuffer); iBucket != end(mSortBuffer);)
+  {
+    const auto iBucketEnd =
+      std::find_if(iBucket, end(mSortBuffer), [&](const SortableDrawSpec& s) {
+        return s.mDrawOrder != iBucket->mDrawOrder ||
+          s.mDrawTopMost != iBucket->mDrawTopMost;
+      });
+
+    if (std::distance(iBucket, iBucketEnd) > 2)
+    {
+      assignBatchGroups(iBucket, iBucketEnd);
+      countingSort(
+        iBucket,
+        iBucketEnd,
+        int(mBatchGroupBuffer.size()),
+        [](const SortableDrawSpec& s) { return s.mBatchGroup; });
+    }
+
+    iBucket = iBucketEnd;
+  }
+}
+
+
+void SpriteRenderingSystem::recordCommands(const float interpolationFactor)
+{
+  // Drawing commands are recorded right away, so that rendering doesn't
+  // need to look up anything in the texture atlas anymore.
+  mRegularSpriteCommands.clear();
+  mForegroundSpriteCommands.clear();
+  mCloakEffectSpritesVisible = false;
+
+  for (const auto& sortableSpec : mSortBuffer)
+  {
+    const auto& spec = sortableSpec.mSpec;
+    recordSprite(
+      spec,
+      interpolatedRect(
+        spec.mPreviousDestRect, spec.mDestRect, interpolationFactor),
+      sortableSpec.mDrawTopMost ? mForegroundSpriteCommands
+                                : mRegularSpriteCommands);
+    mCloakEffectSpritesVisible |= spec.mUseCloakEffect;
+  }
+}
+
+
+void SpriteRenderingSystem::sortByDrawOrder()
+{
+  if (mSortBuffer.empty())
+  {
+    return;
+  }
+
+  // Draw orders only span a small range of values, so in practice, the
+  // counting sort is used. All batch groups are still 0 at this point, so the
+  // key doesn't need to include them.
+  const auto [iMin, iMax] = std::minmax_element(
+    mSortBuffer.begin(),
+    mSortBuffer.end(),
+    [](const SortableDrawSpec& lhs, const SortableDrawSpec& rhs) {
+      return lhs.mDrawOrder < rhs.mDrawOrder;
+    });
+  const auto minDrawOrder = iMin->mDrawOrder;
+  const auto numDrawOrders = iMax->mDrawOrder - minDrawOrder + 1;
+
+  if (numDrawOrders * 2 > MAX_COUNTING_SORT_KEYS)
+  {
+    std::stable_sort(mSortBuffer.begin(), mSortBuffer.end());
+    return;
+  }
+
+  countingSort(
+    mSortBuffer.begin(),
+    mSortBuffer.end(),
+    numDrawOrders * 2,
+    [&](const SortableDrawSpec& s) {
+      return (s.mDrawTopMost ? numDrawOrders : 0) + s.mDrawOrder -
+        minDrawOrder;
     });
 }
 
 
-void SpriteRenderingSystem::renderRegularSprites(
-  const SpecialEffectsRenderer& fx) const
+/** Stable sort of [first, last), key must map elements to [0, numKeys) */
+template <typename KeyFunc>
+void SpriteRenderingSystem::countingSort(
+  const std::vector<SortableDrawSpec>::iterator first,
+  const std::vector<SortableDrawSpec>::iterator last,
+  const int numKeys,
+  KeyFunc key)
 {
-  for (auto it = mSprites.begin(); it != miForegroundSprites; ++it)
+  mSortKeyOffsets.assign(numKeys + 1, 0);
+  for (auto it = first; it != last; ++it)
+  {
+    ++mSortKeyOffsets[key(*it) + 1];
+  }
+
+  std::partial_sum(
+    mSortKeyOffsets.begin(), mSortKeyOffsets.end(), mSortKeyOffsets.begin());
+
+  mSortScratchBuffer.resize(std::distance(first, last));
+  for (auto it = first; it != last; ++it)
   {
-    renderSprite(*it, fx);
+    mSortScratchBuffer[mSortKeyOffsets[key(*it)]++] = *it;
   }
+
+  std::copy(mSortScratchBuffer.begin(), mSortScratchBuffer.end(), first);
 }
 
 
-void SpriteRenderingSystem::renderForegroundSprites(
-  const SpecialEffectsRenderer& fx) const
+void SpriteRenderingSystem::assignBatchGroups(
+  const std::vector<SortableDrawSpec>::iterator first,
+  const std::vector<SortableDrawSpec>::iterator last)
 {
-  for (auto it = miForegroundSprites; it != mSprites.end(); ++it)
+  // Groups are formed greedily in draw order. A sprite can join an earlier
+  // group with matching texture & render state, but only if it doesn't
+  // overlap any group that comes after that one - otherwise, moving it
+  // forward in the draw order would change the visible result. Group bounds
+  // are tracked as a bounding rectangle of all members, which is
+  // conservative but cheap. Since the grouping is reused for any
+  // interpolation factor, sprites cover the area between their previous and
+  // current position.
+  mBatchGroupBuffer.clear();
+
+  for (auto it = first; it != last; ++it)
   {
-    renderSprite(*it, fx);
+    const auto& spec = it->mSpec;
+    const auto texture = mpTextureAtlas->textureId(spec.mImageId);
+
+    auto iGroup = mBatchGroupBuffer.rbegin();
+    for (; iGroup != mBatchGroupBuffer.rend(); ++iGroup)
+    {
+      if (
+        iGroup->mTexture == texture &&
+        iGroup->mIsFlashingWhite == spec.mIsFlashingWhite &&
+        iGroup->mUseCloakEffect == spec.mUseCloakEffect)
+      {
+        break;
+      }
+
+      if (iGroup->mBounds.intersects(coveredArea(spec)))
+      {
+        iGroup = mBatchGroupBuffer.rend();
+        break;
+      }
+    }
+
+    if (iGroup != mBatchGroupBuffer.rend())
+    {
+      iGroup->mBounds = base::unite(iGroup->mBounds, coveredArea(spec));
+      it->mBatchGroup =
+        int(std::distance(iGroup, mBatchGroupBuffer.rend())) - 1;
+    }
+    else
+    {
+      it->mBatchGroup = int(mBatchGroupBuffer.size());
+      mBatchGroupBuffer.push_back(BatchGroup{
+        coveredArea(spec),
+        texture,
+        spec.mIsFlashingWhite,
+        spec.mUseCloakEffect});
+    }
   }
 }
 
 
-void SpriteRenderingSystem::renderSprite(
-  const SpriteDrawSpec& spec,
+void SpriteRenderingSystem::renderRegularSprites(
   const SpecialEffectsRenderer& fx) const
 {
+  executeCommands(mRegularSpriteCommands, fx);
+}
+
+
+void SpriteRenderingSystem::renderForegroundSprites(
+  const SpecialEffectsRenderer& fx) const
+{
+  executeCommands(mForegroundSpriteCommands, fx);
+}
+
+
+void SpriteRenderingSystem::recordSprite(
+  const SpriteDrawSpec& spec,
+  const base::Rect<int>& destRect,
+  renderer::CommandList& commands) const
+{
+  if (!mpTextureAtlas->contains(spec.mImageId))
+  {
+    return;
+  }
+
+  const auto [textureId, texCoords] = mpTextureAtlas->drawData(spec.mImageId);
+
   // White flash takes priority over translucency
   if (spec.mIsFlashingWhite)
   {
-    const auto saved = renderer::saveState(mpRenderer);
-    mpRenderer->setOverlayColor(data::GameTraits::INGAME_PALETTE[15]);
-    mpTextureAtlas->draw(spec.mImageId, spec.mDestRect);
+    commands.setOverlayColor(data::GameTraits::INGAME_PALETTE[15]);
+    commands.drawTexture(textureId, texCoords, destRect);
+    commands.setOverlayColor({0, 0, 0, 0});
   }
   else if (spec.mUseCloakEffect)
   {
-    const auto [textureId, texCoords] = mpTextureAtlas->drawData(spec.mImageId);
-
-    fx.drawCloakEffect(textureId, texCoords, spec.mDestRect);
+    commands.drawCustom(
+      CLOAK_EFFECT_COMMAND, textureId, texCoords, destRect);
   }
   else
   {
-    mpTextureAtlas->draw(spec.mImageId, spec.mDestRect);
+    commands.drawTexture(textureId, texCoords, destRect);
   }
 }
 
+
+void SpriteRenderingSystem::executeCommands(
+  const renderer::CommandList& commands,
+  const SpecialEffectsRenderer& fx) const
+{
+  commands.execute(
+    *mpRenderer,
+    [&](const renderer::CommandList::Command& command) {
+      fx.drawCloakEffect(command.mTexture, command.mTexCoords, command.mRect);
+    },
+    [&]() { fx.flushCloakEffects(); });
+}
+
 } // namespace rigel::engine
@@ -19,6 +19,7 @@
 #include "base/spatial_types.hpp"
 #include "base/warnings.hpp"
 #include "engine/base_components.hpp"
+#include "renderer/command_list.hpp"
 #include "renderer/renderer.hpp"
 #include "renderer/texture.hpp"
 
@@ -26,6 +27,7 @@ RIGEL_DISABLE_WARNINGS
 #include <entityx/entityx.h>
 RIGEL_RESTORE_WARNINGS
 
+#include <cstdint>
 #include <utility>
 #include <vector>
 
@@ -53,7 +55,10 @@ void updateAnimatedSprites(entityx::EntityManager& es);
 
 struct SpriteDrawSpec
 {
+  // Destination rectangles as of the current and previous logic update,
+  // in pixels. The sprite is drawn at a position interpolated between these.
   base::Rect<int> mDestRect;
+  base::Rect<int> mPreviousDestRect;
   int mImageId;
   bool mIsFlashingWhite;
   bool mUseCloakEffect;
@@ -66,11 +71,18 @@ struct SortableDrawSpec
   int mDrawOrder;
   bool mDrawTopMost;
 
+  // Sprites with identical draw order can be drawn in any order as long as
+  // they don't overlap. We make use of that in order to group sprites
+  // that share the same texture (and render state), which allows the
+  // renderer to combine them into a single batch. See
+  // SpriteRenderingSystem::update().
+  int mBatchGroup = 0;
+
   friend bool
     operator<(const SortableDrawSpec& lhs, const SortableDrawSpec& rhs)
   {
-    return std::tie(lhs.mDrawTopMost, lhs.mDrawOrder) <
-      std::tie(rhs.mDrawTopMost, rhs.mDrawOrder);
+    return std::tie(lhs.mDrawTopMost, lhs.mDrawOrder, lhs.mBatchGroup) <
+      std::tie(rhs.mDrawTopMost, rhs.mDrawOrder, rhs.mBatchGroup);
   }
 };
 
@@ -78,37 +90,116 @@ struct SortableDrawSpec
 class SpriteRenderingSystem
 {
 public:
+  struct Statistics
+  {
+    int mDrawnSprites = 0;
+    int mCulledSprites = 0;
+  };
+
   SpriteRenderingSystem(
     renderer::Renderer* pRenderer,
     const renderer::TextureAtlas* pTextureAtlas);
 
+  /** Collect visible sprites and record drawing commands for them
+   *
+   * Must be called after every logic update.
+   */
   void update(
     entityx::EntityManager& es,
     const base::Size& viewportSize,
     const base::Vec2& cameraPosition,
     float interpolationFactor);
 
+  /** Re-record drawing commands for a new interpolation factor
+   *
+   * Meant to be used once per rendered frame when motion smoothing is
+   * enabled. As long as the view hasn't changed and invalidate() hasn't been
+   * called, this only interpolates the positions of the sprites gathered by
+   * the last update(). Otherwise, it does a full update().
+   */
+  void updateInterpolation(
+    entityx::EntityManager& es,
+    const base::Size& viewportSize,
+    const base::Vec2& cameraPosition,
+    float interpolationFactor);
+
+  /** Make the next updateInterpolation() collect sprites again
+   *
+   * Must be called after every logic update when using updateInterpolation().
+   */
+  void invalidate() { mNeedsCollection = true; }
+
   bool cloakEffectSpritesVisible() const { return mCloakEffectSpritesVisible; }
 
+  /** Number of sprites drawn/skipped as off-screen by the last collection
+   *
+   * Each frame of a sprite drawing multiple frames counts separately.
+   */
+  Statistics statistics() const { return mStatistics; }
+
   void renderRegularSprites(const SpecialEffectsRenderer& fx) const;
   void renderForegroundSprites(const SpecialEffectsRenderer& fx) const;
 
 private:
-  void renderSprite(
+  // Tag for custom commands in the command lists
+  static constexpr auto CLOAK_EFFECT_COMMAND = std::uint16_t{1};
+
+  void collectSprites(
+    entityx::EntityManager& es,
+    const base::Size& viewportSize,
+    const base::Vec2& cameraPosition);
+  void recordCommands(float interpolationFactor);
+  void recordSprite(
     const SpriteDrawSpec& spec,
+    const base::Rect<int>& destRect,
+    renderer::CommandList& commands) const;
+  void executeCommands(
+    const renderer::CommandList& commands,
     const SpecialEffectsRenderer& fx) const;
 
-  // Temporary storage used for sorting sprites by draw order during sprite
-  // collection. Scope-wise, this is only needed during update(), but in order
-  // to reduce the number of allocations happening each frame, we reuse the
-  // vector.
+  struct BatchGroup
+  {
+    base::Rect<int> mBounds;
+    renderer::TextureId mTexture;
+    bool mIsFlashingWhite;
+    bool mUseCloakEffect;
+  };
+
+  void sortByDrawOrder();
+  void assignBatchGroups(
+    std::vector<SortableDrawSpec>::iterator first,
+    std::vector<SortableDrawSpec>::iterator last);
+
+  template <typename KeyFunc>
+  void countingSort(
+    std::vector<SortableDrawSpec>::iterator first,
+    std::vector<SortableDrawSpec>::iterator last,
+    int numKeys,
+    KeyFunc key);
+
+  // Visible sprites in draw order, as determined by the last sprite
+  // collection. Kept until the next collection, so that drawing commands can
+  // be recorded again with a different interpolation factor.
   std::vector<SortableDrawSpec> mSortBuffer;
 
-  // Data needed to draw sprites that are currently visible. This is updated
-  // by each call to update().
-  std::vector<SpriteDrawSpec> mSprites;
-  std::vector<SpriteDrawSpec>::iterator miForegroundSprites;
+  // Temporary storage used during sprite collection. Scope-wise, this is only
+  // needed during update(), but in order to reduce the number of allocations
+  // happening each frame, we reuse the vectors.
+  std::vector<SortableDrawSpec> mSortScratchBuffer;
+  std::vector<int> mSortKeyOffsets;
+  std::vector<BatchGroup> mBatchGroupBuffer;
+
+  // Drawing commands for sprites that are currently visible. These are
+  // updated by each call to update() or updateInterpolation().
+  renderer::CommandList mRegularSpriteCommands;
+  renderer::CommandList mForegroundSpriteCommands;
+
+  // View used by the last sprite collection
+  base::Size mCollectedViewportSize;
+  base::Vec2 mCollectedCameraPosition;
+  bool mNeedsCollection = true;
   bool mCloakEffectSpritesVisible = false;
+  Statistics mStatistics;
 
   // Dependencies needed for drawing
   renderer::Renderer* mpRenderer;
@@ -33,6 +33,7 @@ TiledTexture::TiledTexture(Texture&& tileSet, Renderer* pRenderer)
   : mTileSetTexture(std::move(tileSet))
   , mpRenderer(pRenderer)
 {
+  computeTileTexCoords();
 }
 
 
@@ -45,6 +46,7 @@ TiledTexture::TiledTexture(
   , mScaleX(mTileSetTexture.width() / logicalSize.width)
   , mScaleY(mTileSetTexture.height() / logicalSize.height)
 {
+  computeTileTexCoords();
 }
 
 
@@ -58,7 +60,10 @@ void TiledTexture::renderTileStretched(
 
 void TiledTexture::renderTile(const int index, const int x, const int y) const
 {
-  renderTileGroup(index, x, y, 1, 1);
+  mpRenderer->drawTexture(
+    mTileSetTexture.data(),
+    mTileTexCoords[index],
+    {tilesToPixels(base::Vec2{x, y}), tilesToPixels(base::Size{1, 1})});
 }
 
 
@@ -68,14 +73,33 @@ renderer::QuadVertices TiledTexture::generateVertices(
   const int posY) const
 {
   return renderer::createTexturedQuadVertices(
-    renderer::toTexCoords(
-      sourceRect(index, 1, 1),
-      mTileSetTexture.width(),
-      mTileSetTexture.height()),
+    tileTexCoords(index),
     {tilesToPixels(base::Vec2{posX, posY}), tilesToPixels(base::Size{1, 1})});
 }
 
 
+void TiledTexture::renderTiles(
+  const base::ArrayView<TilePlacement> tiles) const
+{
+  const auto textureId = mTileSetTexture.data();
+  const auto tileSizePx = tilesToPixels(base::Size{1, 1});
+
+  for (const auto& tile : tiles)
+  {
+    mpRenderer->drawTexture(
+      textureId,
+      mTileTexCoords[tile.mIndex],
+      {tilesToPixels(tile.mPosition), tileSizePx});
+  }
+}
+
+
+renderer::TexCoords TiledTexture::tileTexCoords(const int index) const
+{
+  return mTileTexCoords[index];
+}
+
+
 void TiledTexture::renderTileSlice(
   const int baseIndex,
   const base::Vec2& tlPosition) const
@@ -138,6 +162,22 @@ void TiledTexture::renderTileGroup(
 }
 
 
+void TiledTexture::computeTileTexCoords()
+{
+  const auto numRows = data::pixelsToTiles(mTileSetTexture.height() / mScaleY);
+  const auto numTiles = tilesPerRow() * numRows;
+
+  mTileTexCoords.reserve(numTiles);
+  for (auto index = 0; index < numTiles; ++index)
+  {
+    mTileTexCoords.push_back(renderer::toTexCoords(
+      sourceRect(index, 1, 1),
+      mTileSetTexture.width(),
+      mTileSetTexture.height()));
+  }
+}
+
+
 base::Rect<int> TiledTexture::sourceRect(
   const int index,
   const int tileSpanX,
@@ -16,12 +16,25 @@
 
 #pragma once
 
+#include "base/array_view.hpp"
 #include "renderer/texture.hpp"
 
+#include <vector>
+
 
 namespace rigel::engine
 {
 
+/** A single tile to draw via TiledTexture::renderTiles() */
+struct TilePlacement
+{
+  int mIndex;
+
+  /** Top-left position, in tiles */
+  base::Vec2 mPosition;
+};
+
+
 class TiledTexture
 {
 public:
@@ -39,10 +52,19 @@ public:
     renderTile(index, tlPosition.x, tlPosition.y);
   }
 
+  /** Renders many individual tiles at once
+   *
+   * Equivalent to calling renderTile() for each element, but cheaper when
+   * drawing lots of tiles, e.g. for text.
+   */
+  void renderTiles(base::ArrayView<TilePlacement> tiles) const;
+
   renderer::TextureId textureId() const { return mTileSetTexture.data(); }
 
   renderer::QuadVertices generateVertices(int index, int posX, int posY) const;
 
+  renderer::TexCoords tileTexCoords(int index) const;
+
   /** Renders the given tile plus the one below it (vertical slice) */
   void renderTileSlice(int baseIndex, const base::Vec2& tlPosition) const;
 
@@ -69,11 +91,16 @@ private:
   base::Rect<int>
     sourceRect(int index, const int tileSpanX, const int tileSpanY) const;
 
+  void computeTileTexCoords();
+
 private:
   renderer::Texture mTileSetTexture;
   renderer::Renderer* mpRenderer;
   int mScaleX = 1;
   int mScaleY = 1;
+
+  // Texture coordinates of each individual tile, indexed by tile index
+  std::vector<renderer::TexCoords> mTileTexCoords;
 };
 
 } // namespace rigel::engine
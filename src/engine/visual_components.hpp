@@ -17,6 +17,7 @@
 #pragma once
 
 #include "base/array_view.hpp"
+#include "base/small_vector.hpp"
 #include "base/spatial_types.hpp"
 #include "base/warnings.hpp"
 #include "engine/base_components.hpp"
@@ -68,6 +69,13 @@ struct SpriteDrawData
   base::ArrayView<int> mVirtualToRealFrameMap;
   std::optional<int> mOrientationOffset;
   int mDrawOrder;
+
+  /** Rectangle enclosing all frames, in tiles, relative to the position
+   *
+   * Allows skipping sprites which are entirely outside of the view early.
+   * If not set, the sprite is never skipped based on its bounds.
+   */
+  std::optional<base::Rect<int>> mBounds;
 };
 
 
@@ -199,7 +207,9 @@ struct ExtendedFrameList
     base::Vec2 mOffset;
   };
 
-  std::vector<RenderSpec> mFrames;
+  // Covers the largest number of extra frames used by any actor (sliding
+  // doors) without allocating
+  base::small_vector<RenderSpec, 8> mFrames;
 };
 
 
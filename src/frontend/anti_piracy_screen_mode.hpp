@@ -37,6 +37,8 @@ public:
     engine::TimeDelta,
     const std::vector<SDL_Event>& events) override;
 
+  bool showsStaticContent() const override { return true; }
+
 private:
   Context mContext;
   renderer::Texture mTexture;
@@ -0,0 +1,341 @@
+/* Copyright (C) 2022, Nikolai Wuttke. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "binary_profile.hpp"
+
+#include "assets/file_utils.hpp"
+#include "data/player_model.hpp"
+
+#include <algorithm>
+#include <array>
+#include <stdexcept>
+#include <string>
+
+
+namespace rigel
+{
+
+namespace
+{
+
+constexpr auto MAGIC = std::array<std::uint8_t, 4>{'R', 'G', 'P', 'F'};
+constexpr auto FORMAT_VERSION = std::uint16_t{1};
+
+constexpr auto RECORD_HEADER_SIZE = 8u;
+
+enum class RecordType : std::uint16_t
+{
+  SaveSlot = 1,
+  HighScoreEntry = 2,
+  GamePath = 3
+};
+
+// Current version of each record type. When adding fields to a record, only
+// append them at the end and increase the version.
+constexpr auto SAVE_SLOT_VERSION = std::uint16_t{1};
+constexpr auto HIGH_SCORE_ENTRY_VERSION = std::uint16_t{1};
+constexpr auto GAME_PATH_VERSION = std::uint16_t{1};
+
+
+void writeString(assets::LeStreamWriter& writer, const std::string& text)
+{
+  const auto length = std::uint8_t(std::min(text.size(), std::size_t{255}));
+  writer.writeU8(length);
+  writer.writeBytes(
+    {reinterpret_cast<const std::uint8_t*>(text.data()), length});
+}
+
+
+std::string readString(assets::LeStreamReader& reader)
+{
+  const auto length = reader.readU8();
+  const auto bytes = reader.peekBytes(length);
+  reader.skipBytes(length);
+  return std::string(bytes.begin(), bytes.end());
+}
+
+
+void writeRecord(
+  assets::LeStreamWriter& writer,
+  const RecordType type,
+  const std::uint16_t version,
+  const assets::LeStreamWriter& payload)
+{
+  writer.writeU16(static_cast<std::uint16_t>(type));
+  writer.writeU16(version);
+  writer.writeU32(std::uint32_t(payload.buffer().size()));
+  writer.writeBytes(payload.buffer());
+}
+
+
+void writeSaveSlot(
+  assets::LeStreamWriter& writer,
+  const std::size_t slotIndex,
+  const data::SavedGame& savedGame)
+{
+  assets::LeStreamWriter payload;
+  payload.writeU8(std::uint8_t(slotIndex));
+  payload.writeU8(std::uint8_t(savedGame.mSessionId.mEpisode));
+  payload.writeU8(std::uint8_t(savedGame.mSessionId.mLevel));
+  payload.writeU8(std::uint8_t(savedGame.mSessionId.mDifficulty));
+  payload.writeU8(std::uint8_t(savedGame.mWeapon));
+  payload.writeU16(std::uint16_t(savedGame.mAmmo));
+  payload.writeU32(std::uint32_t(savedGame.mScore));
+
+  // One bit per tutorial message, prefixed by the number of messages
+  payload.writeU8(std::uint8_t(data::NUM_TUTORIAL_MESSAGES));
+  for (auto i = 0; i < data::NUM_TUTORIAL_MESSAGES; i += 8)
+  {
+    auto bits = std::uint8_t{0};
+    for (auto bit = 0; bit < 8 && i + bit < data::NUM_TUTORIAL_MESSAGES; ++bit)
+    {
+      const auto id = static_cast<data::TutorialMessageId>(i + bit);
+      if (savedGame.mTutorialMessagesAlreadySeen.hasBeenShown(id))
+      {
+        bits |= std::uint8_t(1 << bit);
+      }
+    }
+
+    payload.writeU8(bits);
+  }
+
+  writeString(payload, savedGame.mName);
+
+  writeRecord(writer, RecordType::SaveSlot, SAVE_SLOT_VERSION, payload);
+}
+
+
+void readSaveSlot(
+  assets::LeStreamReader& reader,
+  BinaryProfileContents& contents)
+{
+  using namespace data;
+
+  const auto slotIndex = reader.readU8();
+
+  auto savedGame = SavedGame{};
+  savedGame.mSessionId.mEpisode =
+    std::min(int(reader.readU8()), NUM_EPISODES - 1);
+  savedGame.mSessionId.mLevel =
+    std::min(int(reader.readU8()), NUM_LEVELS_PER_EPISODE - 1);
+  savedGame.mSessionId.mDifficulty =
+    static_cast<Difficulty>(std::min(int(reader.readU8()), 2));
+  savedGame.mWeapon =
+    static_cast<WeaponType>(std::min(int(reader.readU8()), 3));
+
+  const auto maxAmmo = savedGame.mWeapon == WeaponType::FlameThrower
+    ? MAX_AMMO_FLAME_THROWER
+    : MAX_AMMO;
+  savedGame.mAmmo = std::min(int(reader.readU16()), maxAmmo);
+  savedGame.mScore =
+    int(std::min(reader.readU32(), std::uint32_t(MAX_SCORE)));
+
+  const auto numMessages = int(reader.readU8());
+  for (auto i = 0; i < numMessages; i += 8)
+  {
+    const auto bits = reader.readU8();
+    for (auto bit = 0; bit < 8; ++bit)
+    {
+      if (i + bit < NUM_TUTORIAL_MESSAGES && (bits & (1 << bit)))
+      {
+        savedGame.mTutorialMessagesAlreadySeen.markAsShown(
+          static_cast<TutorialMessageId>(i + bit));
+      }
+    }
+  }
+
+  savedGame.mName = readString(reader);
+
+  if (slotIndex < contents.mSaveSlots.size())
+  {
+    contents.mSaveSlots[slotIndex] = std::move(savedGame);
+  }
+}
+
+
+void writeHighScoreEntry(
+  assets::LeStreamWriter& writer,
+  const std::size_t episode,
+  const std::size_t position,
+  const data::HighScoreEntry& entry)
+{
+  assets::LeStreamWriter payload;
+  payload.writeU8(std::uint8_t(episode));
+  payload.writeU8(std::uint8_t(position));
+  payload.writeU32(std::uint32_t(entry.mScore));
+  writeString(payload, entry.mName);
+
+  writeRecord(
+    writer, RecordType::HighScoreEntry, HIGH_SCORE_ENTRY_VERSION, payload);
+}
+
+
+void readHighScoreEntry(
+  assets::LeStreamReader& reader,
+  BinaryProfileContents& contents)
+{
+  const auto episode = reader.readU8();
+  const auto position = reader.readU8();
+
+  auto entry = data::HighScoreEntry{};
+  entry.mScore =
+    int(std::min(reader.readU32(), std::uint32_t(data::MAX_SCORE)));
+  entry.mName = readString(reader);
+
+  if (
+    episode < contents.mHighScoreLists.size() &&
+    position < data::NUM_HIGH_SCORE_ENTRIES)
+  {
+    contents.mHighScoreLists[episode][position] = std::move(entry);
+  }
+}
+
+
+void writeGamePath(
+  assets::LeStreamWriter& writer,
+  const std::filesystem::path& gamePath)
+{
+  const auto pathString = gamePath.u8string();
+  const auto length =
+    std::uint16_t(std::min(pathString.size(), std::size_t{65535}));
+
+  assets::LeStreamWriter payload;
+  payload.writeU16(length);
+  payload.writeBytes(
+    {reinterpret_cast<const std::uint8_t*>(pathString.data()), length});
+
+  writeRecord(writer, RecordType::GamePath, GAME_PATH_VERSION, payload);
+}
+
+
+void readGamePath(
+  assets::LeStreamReader& reader,
+  BinaryProfileContents& contents)
+{
+  const auto length = reader.readU16();
+  const auto bytes = reader.peekBytes(length);
+  contents.mGamePath =
+    std::filesystem::u8path(std::string(bytes.begin(), bytes.end()));
+}
+
+} // namespace
+
+
+assets::ByteBuffer encodeBinaryProfile(const BinaryProfileContents& contents)
+{
+  assets::LeStreamWriter writer;
+  writer.writeBytes(MAGIC);
+  writer.writeU16(FORMAT_VERSION);
+
+  for (auto i = 0u; i < contents.mSaveSlots.size(); ++i)
+  {
+    if (const auto& slot = contents.mSaveSlots[i])
+    {
+      writeSaveSlot(writer, i, *slot);
+    }
+  }
+
+  for (auto episode = 0u; episode < contents.mHighScoreLists.size();
+       ++episode)
+  {
+    const auto& list = contents.mHighScoreLists[episode];
+    for (auto position = 0u; position < list.size(); ++position)
+    {
+      if (list[position] != data::HighScoreEntry{})
+      {
+        writeHighScoreEntry(writer, episode, position, list[position]);
+      }
+    }
+  }
+
+  if (contents.mGamePath)
+  {
+    writeGamePath(writer, *contents.mGamePath);
+  }
+
+  writer.writeBytes(contents.mUnknownRecords);
+
+  return writer.buffer();
+}
+
+
+BinaryProfileContents decodeBinaryProfile(const assets::ByteBuffer& data)
+{
+  assets::LeStreamReader reader(data.begin(), data.end());
+
+  const auto magic = reader.peekBytes(MAGIC.size());
+  if (!std::equal(magic.begin(), magic.end(), MAGIC.begin()))
+  {
+    throw std::invalid_argument("Not a binary user profile");
+  }
+
+  reader.skipBytes(MAGIC.size());
+
+  const auto formatVersion = reader.readU16();
+  if (formatVersion > FORMAT_VERSION)
+  {
+    throw std::invalid_argument(
+      "Unsupported binary user profile version " +
+      std::to_string(formatVersion));
+  }
+
+  BinaryProfileContents result;
+
+  while (reader.hasData())
+  {
+    const auto header = reader.peekBytes(RECORD_HEADER_SIZE);
+    const auto type = static_cast<RecordType>(reader.readU16());
+    reader.readU16(); // Record version
+    const auto size = reader.readU32();
+
+    const auto payload = reader.peekBytes(size);
+    reader.skipBytes(size);
+
+    // Any fields added by later record versions are ignored, since the
+    // payload reader only covers the fields known to this version.
+    assets::LeStreamReader payloadReader(payload);
+    switch (type)
+    {
+      case RecordType::SaveSlot:
+        readSaveSlot(payloadReader, result);
+        break;
+
+      case RecordType::HighScoreEntry:
+        readHighScoreEntry(payloadReader, result);
+        break;
+
+      case RecordType::GamePath:
+        readGamePath(payloadReader, result);
+        break;
+
+      default:
+        result.mUnknownRecords.insert(
+          result.mUnknownRecords.end(), header.begin(), header.end());
+        result.mUnknownRecords.insert(
+          result.mUnknownRecords.end(), payload.begin(), payload.end());
+        break;
+    }
+  }
+
+  for (auto& list : result.mHighScoreLists)
+  {
+    std::sort(list.begin(), list.end());
+  }
+
+  return result;
+}
+
+} // namespace rigel
@@ -0,0 +1,65 @@
+/* Copyright (C) 2022, Nikolai Wuttke. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "assets/byte_buffer.hpp"
+#include "data/high_score_list.hpp"
+#include "data/saved_game.hpp"
+
+#include <filesystem>
+#include <optional>
+
+
+namespace rigel
+{
+
+/** Contents of a user profile file in the binary format
+ *
+ * The file starts with a magic number and a format version, followed by a
+ * sequence of records. Each record has a type, a version, and a payload size,
+ * followed by the payload itself. Payloads have a fixed layout per record
+ * version. Later versions of a record may only append fields, so that a
+ * reader can decode the part it knows about and skip the rest.
+ *
+ * Records of unknown types (written by a newer version of RigelEngine) are
+ * kept as raw bytes in mUnknownRecords, and written back out unchanged
+ * by encodeBinaryProfile(). This way, running an older version doesn't
+ * erase data stored by a newer one.
+ *
+ * Game options and the mod library are not part of the binary profile,
+ * they are stored in separate JSON files which users can edit by hand.
+ */
+struct BinaryProfileContents
+{
+  data::SaveSlotArray mSaveSlots;
+  data::HighScoreListArray mHighScoreLists;
+  std::optional<std::filesystem::path> mGamePath;
+  assets::ByteBuffer mUnknownRecords;
+};
+
+
+assets::ByteBuffer encodeBinaryProfile(const BinaryProfileContents& contents);
+
+/** Decode a binary profile
+ *
+ * Throws an exception if the data is not a binary profile, or if it is
+ * truncated. Out of range values are clamped, like when loading a JSON
+ * profile.
+ */
+BinaryProfileContents decodeBinaryProfile(const assets::ByteBuffer& data);
+
+} // namespace rigel
@@ -45,6 +45,17 @@ struct CommandLineOptions
   bool mDebugModeEnabled = false;
   bool mDisableAudio = false;
   bool mPlayDemo = false;
+  bool mBenchmarkDemo = false;
+  int mBenchmarkRenderInterval = 0;
+  std::optional<std::string> mInputRecordingDirectory;
+  std::optional<std::string> mTraceFile;
+  std::optional<std::string> mStartupTimingsFile;
+  std::optional<std::string> mProfileImportFile;
+  std::optional<std::string> mProfileExportFile;
+  bool mPipelinedGameLogic = false;
+  bool mLowLatencyInput = false;
+  bool mReduceVsyncLatency = false;
+  bool mWatchReplacementFiles = false;
   std::optional<base::Vec2> mPlayerPosition;
 };
 
@@ -0,0 +1,144 @@
+/* Copyright (C) 2022, Nikolai Wuttke. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "deferred_service_provider.hpp"
+
+#include <utility>
+
+
+namespace rigel
+{
+
+DeferredServiceProvider::DeferredServiceProvider(
+  IGameServiceProvider* pTarget)
+  : mpTarget(pTarget)
+{
+}
+
+
+void DeferredServiceProvider::beginDeferring()
+{
+  mIsDeferring = true;
+}
+
+
+void DeferredServiceProvider::endDeferring()
+{
+  mIsDeferring = false;
+
+  for (const auto& request : mQueuedRequests)
+  {
+    request(*mpTarget);
+  }
+
+  mQueuedRequests.clear();
+}
+
+
+void DeferredServiceProvider::fadeOutScreen()
+{
+  forwardOrQueue([](IGameServiceProvider& target) { target.fadeOutScreen(); });
+}
+
+
+void DeferredServiceProvider::fadeInScreen()
+{
+  forwardOrQueue([](IGameServiceProvider& target) { target.fadeInScreen(); });
+}
+
+
+void DeferredServiceProvider::playSound(const data::SoundId id)
+{
+  forwardOrQueue([id](IGameServiceProvider& target) { target.playSound(id); });
+}
+
+
+void DeferredServiceProvider::stopSound(const data::SoundId id)
+{
+  forwardOrQueue([id](IGameServiceProvider& target) { target.stopSound(id); });
+}
+
+
+void DeferredServiceProvider::stopAllSounds()
+{
+  forwardOrQueue([](IGameServiceProvider& target) { target.stopAllSounds(); });
+}
+
+
+void DeferredServiceProvider::playMusic(const std::string& name)
+{
+  forwardOrQueue(
+    [name](IGameServiceProvider& target) { target.playMusic(name); });
+}
+
+
+void DeferredServiceProvider::prefetchMusic(const std::string& name)
+{
+  forwardOrQueue(
+    [name](IGameServiceProvider& target) { target.prefetchMusic(name); });
+}
+
+
+void DeferredServiceProvider::stopMusic()
+{
+  forwardOrQueue([](IGameServiceProvider& target) { target.stopMusic(); });
+}
+
+
+void DeferredServiceProvider::scheduleGameQuit()
+{
+  forwardOrQueue(
+    [](IGameServiceProvider& target) { target.scheduleGameQuit(); });
+}
+
+
+void DeferredServiceProvider::switchGamePath(
+  const std::filesystem::path& newGamePath)
+{
+  forwardOrQueue([newGamePath](IGameServiceProvider& target) {
+    target.switchGamePath(newGamePath);
+  });
+}
+
+
+void DeferredServiceProvider::markCurrentFrameAsWidescreen()
+{
+  forwardOrQueue([](IGameServiceProvider& target) {
+    target.markCurrentFrameAsWidescreen();
+  });
+}
+
+
+void DeferredServiceProvider::reportGameLogicTime(const engine::TimeDelta time)
+{
+  forwardOrQueue(
+    [time](IGameServiceProvider& target) { target.reportGameLogicTime(time); });
+}
+
+
+void DeferredServiceProvider::forwardOrQueue(Request request)
+{
+  if (mIsDeferring)
+  {
+    mQueuedRequests.push_back(std::move(request));
+  }
+  else
+  {
+    request(*mpTarget);
+  }
+}
+
+} // namespace rigel
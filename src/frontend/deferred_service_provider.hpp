@@ -0,0 +1,91 @@
+/* Copyright (C) 2022, Nikolai Wuttke. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "frontend/game_service_provider.hpp"
+
+#include <functional>
+#include <vector>
+
+
+namespace rigel
+{
+
+/** Service provider which can hold back requests until a later point
+ *
+ * Forwards all calls to another service provider. While deferring is
+ * enabled, requests (playing sounds etc.) are queued up instead, and
+ * forwarded when deferring is turned off again. This allows game logic to
+ * run on a worker thread, while the service provider itself is only ever
+ * used from the main thread.
+ *
+ * Queries like commandLineOptions() are always forwarded directly, the
+ * wrapped provider needs to support calling those from any thread.
+ *
+ * Enabling and disabling deferring must be synchronized with the thread
+ * making the requests, e.g. by only doing so while that thread is idle.
+ */
+class DeferredServiceProvider : public IGameServiceProvider
+{
+public:
+  explicit DeferredServiceProvider(IGameServiceProvider* pTarget);
+
+  /** Start queueing requests */
+  void beginDeferring();
+
+  /** Forward all queued requests, then stop queueing */
+  void endDeferring();
+
+  void fadeOutScreen() override;
+  void fadeInScreen() override;
+  void playSound(data::SoundId id) override;
+  void stopSound(data::SoundId id) override;
+  void stopAllSounds() override;
+  void playMusic(const std::string& name) override;
+  void prefetchMusic(const std::string& name) override;
+  void stopMusic() override;
+  void scheduleGameQuit() override;
+  void switchGamePath(const std::filesystem::path& newGamePath) override;
+  void markCurrentFrameAsWidescreen() override;
+  void reportGameLogicTime(engine::TimeDelta time) override;
+
+  bool isSharewareVersion() const override
+  {
+    return mpTarget->isSharewareVersion();
+  }
+
+  const CommandLineOptions& commandLineOptions() const override
+  {
+    return mpTarget->commandLineOptions();
+  }
+
+  const GameControllerInfo& gameControllerInfo() const override
+  {
+    return mpTarget->gameControllerInfo();
+  }
+
+private:
+  using Request = std::function<void(IGameServiceProvider&)>;
+
+  void forwardOrQueue(Request request);
+
+  IGameServiceProvider* mpTarget;
+  std::vector<Request> mQueuedRequests;
+  bool mIsDeferring = false;
+};
+
+} // namespace rigel
@@ -21,6 +21,9 @@
 #include "game_logic/game_world.hpp"
 #include "game_logic_classic/game_world_classic.hpp"
 
+#include <iomanip>
+#include <ostream>
+
 
 namespace rigel::game_logic
 {
@@ -33,6 +36,20 @@ constexpr int DEMO_LEVELS[] = {0, 2, 4, 6};
 constexpr auto DEMO_DIFFICULTY = data::Difficulty::Hard;
 constexpr std::uint8_t END_OF_DEMO_MARKER = 0xFF;
 
+// When fast-forwarding without rendering, how many ticks to run before
+// returning control to the main loop
+constexpr auto TICKS_PER_UNRENDERED_UPDATE = 64;
+
+
+using Clock = std::chrono::steady_clock;
+
+
+engine::TimeDelta secondsSince(const Clock::time_point start)
+{
+  return std::chrono::duration<engine::TimeDelta>(Clock::now() - start)
+    .count();
+}
+
 
 PlayerInput
   parseInput(const std::uint8_t byte, const PlayerInput& previousInput)
@@ -90,10 +107,46 @@ data::GameSessionId demoSessionId(const std::size_t levelIndex)
 } // namespace
 
 
+void printBenchmarkStatistics(
+  std::ostream& stream,
+  const DemoBenchmarkStatistics& statistics)
+{
+  const auto& s = statistics;
+  const auto otherTime =
+    s.mTotalTime - s.mLogicTime - s.mRenderTime - s.mLevelLoadTime;
+
+  auto printTime = [&](const char* label, const engine::TimeDelta time) {
+    const auto percentage =
+      s.mTotalTime > 0 ? time / s.mTotalTime * 100.0 : 0.0;
+    stream << label << std::setw(9) << time * 1000.0 << " ms ("
+           << std::setw(5) << percentage << " %)\n";
+  };
+
+  const auto flags = stream.flags();
+  stream << std::fixed << std::setprecision(1);
+
+  stream << "Demo benchmark results\n";
+  stream << "Ticks:          " << s.mTicks << '\n';
+  stream << "Frames:         " << s.mFramesRendered << '\n';
+  stream << "Levels:         " << s.mLevelsLoaded << '\n';
+  stream << "Ticks/second:   "
+         << (s.mTotalTime > 0 ? s.mTicks / s.mTotalTime : 0.0) << '\n';
+  printTime("Game logic:   ", s.mLogicTime);
+  printTime("Rendering:    ", s.mRenderTime);
+  printTime("Level loading:", s.mLevelLoadTime);
+  printTime("Other:        ", otherTime);
+  printTime("Total:        ", s.mTotalTime);
+
+  stream.flags(flags);
+}
+
+
 DemoPlayer::DemoPlayer(GameMode::Context context)
   : mContext(context)
   , mFrames(loadDemo(*context.mpResources))
+  , mLevelPreloader(context.mpResources)
 {
+  mLevelPreloader.preload(demoSessionId(0));
 }
 
 
@@ -109,16 +162,7 @@ void DemoPlayer::updateAndRender(const engine::TimeDelta dt)
     return;
   }
 
-  if (!mpWorld)
-  {
-    mpWorld = std::make_unique<GameWorld_Classic>(
-      &mPersistentPlayerState,
-      demoSessionId(0),
-      mContext,
-      std::nullopt,
-      true,
-      mFrames[0].mInput);
-  }
+  createWorldIfNeeded();
 
   auto changeLevel = false;
 
@@ -126,10 +170,7 @@ void DemoPlayer::updateAndRender(const engine::TimeDelta dt)
 
   if (mElapsedTime >= GAME_LOGIC_UPDATE_DELAY)
   {
-    mpWorld->updateGameLogic(mFrames[mCurrentFrameIndex].mInput);
-    changeLevel = mFrames[mCurrentFrameIndex].mNextLevel;
-    ++mCurrentFrameIndex;
-
+    changeLevel = runTick();
     mElapsedTime -= GAME_LOGIC_UPDATE_DELAY;
   }
 
@@ -142,22 +183,124 @@ void DemoPlayer::updateAndRender(const engine::TimeDelta dt)
   {
     mContext.mpServiceProvider->fadeOutScreen();
 
-    ++mLevelIndex;
+    switchToNextLevel();
+    mpWorld->render();
+
+    mContext.mpServiceProvider->fadeInScreen();
+  }
+}
+
+
+void DemoPlayer::updateFastForward(const int renderInterval)
+{
+  if (isFinished())
+  {
+    return;
+  }
+
+  if (!mBenchmarkStartTime)
+  {
+    mBenchmarkStartTime = Clock::now();
+  }
+
+  auto& stats = mBenchmarkStatistics;
+
+  if (!mpWorld)
+  {
+    const auto loadStartTime = Clock::now();
+    createWorldIfNeeded();
+    stats.mLevelLoadTime += secondsSince(loadStartTime);
+    ++stats.mLevelsLoaded;
+  }
+
+  for (auto ticksThisUpdate = 1; !isFinished(); ++ticksThisUpdate)
+  {
+    const auto tickStartTime = Clock::now();
+    const auto changeLevel = runTick();
+    mpWorld->updateBackdropAutoScrolling(GAME_LOGIC_UPDATE_DELAY);
+    mpWorld->processEndOfFrameActions();
+    stats.mLogicTime += secondsSince(tickStartTime);
+    ++stats.mTicks;
+
+    if (changeLevel && mCurrentFrameIndex < mFrames.size())
+    {
+      const auto loadStartTime = Clock::now();
+      switchToNextLevel();
+      stats.mLevelLoadTime += secondsSince(loadStartTime);
+      ++stats.mLevelsLoaded;
+    }
+
+    if (renderInterval > 0 && stats.mTicks % renderInterval == 0)
+    {
+      const auto renderStartTime = Clock::now();
+      mpWorld->render();
+      stats.mRenderTime += secondsSince(renderStartTime);
+      ++stats.mFramesRendered;
+      break;
+    }
+
+    if (renderInterval <= 0 && ticksThisUpdate == TICKS_PER_UNRENDERED_UPDATE)
+    {
+      break;
+    }
+  }
+
+  stats.mTotalTime = secondsSince(*mBenchmarkStartTime);
+}
 
-    mPersistentPlayerState.resetForNewLevel();
 
+void DemoPlayer::createWorldIfNeeded()
+{
+  if (!mpWorld)
+  {
     mpWorld = std::make_unique<GameWorld_Classic>(
       &mPersistentPlayerState,
-      demoSessionId(mLevelIndex),
+      demoSessionId(0),
       mContext,
       std::nullopt,
-      false,
-      mFrames[mCurrentFrameIndex].mInput);
-    mpWorld->render();
+      true,
+      mFrames[0].mInput,
+      mLevelPreloader.take(demoSessionId(0)));
+    preloadNextLevel();
+  }
+}
 
-    mCurrentFrameIndex++;
 
-    mContext.mpServiceProvider->fadeInScreen();
+bool DemoPlayer::runTick()
+{
+  mpWorld->updateGameLogic(mFrames[mCurrentFrameIndex].mInput);
+  const auto changeLevel = mFrames[mCurrentFrameIndex].mNextLevel;
+  ++mCurrentFrameIndex;
+
+  return changeLevel;
+}
+
+
+void DemoPlayer::switchToNextLevel()
+{
+  ++mLevelIndex;
+
+  mPersistentPlayerState.resetForNewLevel();
+
+  mpWorld = std::make_unique<GameWorld_Classic>(
+    &mPersistentPlayerState,
+    demoSessionId(mLevelIndex),
+    mContext,
+    std::nullopt,
+    false,
+    mFrames[mCurrentFrameIndex].mInput,
+    mLevelPreloader.take(demoSessionId(mLevelIndex)));
+  preloadNextLevel();
+
+  mCurrentFrameIndex++;
+}
+
+
+void DemoPlayer::preloadNextLevel()
+{
+  if (mLevelIndex + 1 < std::size(DEMO_LEVELS))
+  {
+    mLevelPreloader.preload(demoSessionId(mLevelIndex + 1));
   }
 }
 
@@ -19,9 +19,13 @@
 #include "data/player_model.hpp"
 #include "engine/timing.hpp"
 #include "frontend/game_mode.hpp"
+#include "frontend/level_preloader.hpp"
 #include "game_logic_common/input.hpp"
 
+#include <chrono>
+#include <iosfwd>
 #include <memory>
+#include <optional>
 #include <vector>
 
 
@@ -38,6 +42,27 @@ struct DemoInput
 };
 
 
+/** Where the time went during fast-forwarded demo playback
+ *
+ * All times are in seconds.
+ */
+struct DemoBenchmarkStatistics
+{
+  int mTicks = 0;
+  int mFramesRendered = 0;
+  int mLevelsLoaded = 0;
+  engine::TimeDelta mLogicTime = 0;
+  engine::TimeDelta mRenderTime = 0;
+  engine::TimeDelta mLevelLoadTime = 0;
+  engine::TimeDelta mTotalTime = 0;
+};
+
+
+void printBenchmarkStatistics(
+  std::ostream& stream,
+  const DemoBenchmarkStatistics& statistics);
+
+
 class DemoPlayer
 {
 public:
@@ -49,9 +74,31 @@ public:
 
   void updateAndRender(engine::TimeDelta dt);
 
+  /** Run the demo as fast as possible instead of in real time
+   *
+   * Each call runs game logic updates until a frame needs to be shown,
+   * i.e. every renderInterval ticks. With a render interval of 0, nothing
+   * is rendered, and each call runs a fixed number of ticks so that the
+   * caller can still process events in between. Level transitions don't
+   * fade the screen.
+   *
+   * Timings are collected into benchmarkStatistics().
+   */
+  void updateFastForward(int renderInterval);
+
   bool isFinished() const;
 
+  const DemoBenchmarkStatistics& benchmarkStatistics() const
+  {
+    return mBenchmarkStatistics;
+  }
+
 private:
+  void createWorldIfNeeded();
+  bool runTick();
+  void switchToNextLevel();
+  void preloadNextLevel();
+
   GameMode::Context mContext;
   data::PersistentPlayerState mPersistentPlayerState;
 
@@ -61,6 +108,10 @@ private:
   engine::TimeDelta mElapsedTime = 0;
 
   std::unique_ptr<GameWorld_Classic> mpWorld;
+  LevelPreloader mLevelPreloader;
+
+  DemoBenchmarkStatistics mBenchmarkStatistics;
+  std::optional<std::chrono::steady_clock::time_point> mBenchmarkStartTime;
 };
 
 } // namespace rigel::game_logic
@@ -0,0 +1,135 @@
+/* Copyright (C) 2022, Nikolai Wuttke. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "frame_recorder.hpp"
+
+#include "assets/png_image.hpp"
+#include "base/warnings.hpp"
+#include "base/worker_thread.hpp"
+#include "renderer/renderer.hpp"
+#include "renderer/upscaling.hpp"
+
+RIGEL_DISABLE_WARNINGS
+#include <loguru.hpp>
+RIGEL_RESTORE_WARNINGS
+
+#include <array>
+#include <atomic>
+#include <cstdio>
+
+
+namespace rigel
+{
+
+namespace fs = std::filesystem;
+
+
+// Readback callbacks may still be pending in the renderer after recording
+// has been stopped, so everything they need is kept alive via shared
+// ownership.
+struct FrameRecorder::SharedState
+{
+  explicit SharedState(const fs::path& outputPath)
+    : mLowResPath(outputPath / "lowres")
+    , mUpscaledPath(outputPath / "upscaled")
+  {
+  }
+
+  void queueImage(data::Image image, const fs::path& path)
+  {
+    if (mNumQueuedImages >= MAX_QUEUED_IMAGES)
+    {
+      ++mNumDroppedImages;
+      return;
+    }
+
+    ++mNumQueuedImages;
+
+    mWorker.submit(
+      [image = std::move(image), path, pCount = &mNumQueuedImages]() {
+        if (!assets::savePng(path, image))
+        {
+          LOG_F(ERROR, "Failed to write %s", path.u8string().c_str());
+        }
+
+        --(*pCount);
+      });
+  }
+
+  fs::path mLowResPath;
+  fs::path mUpscaledPath;
+  std::atomic<int> mNumQueuedImages = 0;
+  std::atomic<int> mNumDroppedImages = 0;
+
+  // Must come last, so that all outstanding writes are finished before
+  // the counters are destroyed
+  base::WorkerThread mWorker;
+};
+
+
+namespace
+{
+
+fs::path makeFramePath(const fs::path& directory, const int frameNumber)
+{
+  std::array<char, 32> nameBuffer;
+  std::snprintf(
+    nameBuffer.data(), nameBuffer.size(), "frame_%06d.png", frameNumber);
+  return directory / nameBuffer.data();
+}
+
+} // namespace
+
+
+FrameRecorder::FrameRecorder(const fs::path& outputPath)
+  : mpState(std::make_shared<SharedState>(outputPath))
+{
+  std::error_code ec;
+  fs::create_directories(mpState->mLowResPath, ec);
+  fs::create_directories(mpState->mUpscaledPath, ec);
+
+  LOG_F(INFO, "Recording frames to %s", outputPath.u8string().c_str());
+}
+
+
+FrameRecorder::~FrameRecorder()
+{
+  LOG_F(
+    INFO,
+    "Stopped recording after %d frames, %d images dropped",
+    mFrameNumber,
+    int(mpState->mNumDroppedImages));
+}
+
+
+void FrameRecorder::captureFrame(
+  renderer::Renderer* pRenderer,
+  renderer::UpscalingBuffer* pUpscalingBuffer)
+{
+  ++mFrameNumber;
+
+  pUpscalingBuffer->grabContentsAsync(
+    [pState = mpState,
+     path = makeFramePath(mpState->mLowResPath, mFrameNumber)](
+      data::Image image) { pState->queueImage(std::move(image), path); });
+  pRenderer->grabCurrentFramebufferAsync(
+    [pState = mpState,
+     path = makeFramePath(mpState->mUpscaledPath, mFrameNumber)](
+      data::Image image) { pState->queueImage(std::move(image), path); });
+}
+
+} // namespace rigel
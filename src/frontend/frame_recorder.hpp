@@ -0,0 +1,75 @@
+/* Copyright (C) 2022, Nikolai Wuttke. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#pragma once
+
+#include "base/image.hpp"
+
+#include <filesystem>
+#include <memory>
+
+
+namespace rigel::renderer
+{
+class Renderer;
+class UpscalingBuffer;
+} // namespace rigel::renderer
+
+
+namespace rigel
+{
+
+/** Records the game's video output as a sequence of PNG images
+ *
+ * Each captured frame produces two images: The low-resolution buffer the
+ * game renders into, and the final upscaled output as seen in the window.
+ * They are written into separate sub-directories of the output path,
+ * numbered by frame.
+ *
+ * Capturing never blocks the calling thread. Framebuffer contents are read
+ * back asynchronously, and encoding/writing happens on a background thread.
+ * The number of frames waiting to be written is bounded. If the disk
+ * can't keep up, frames are dropped, leaving gaps in the numbering.
+ */
+class FrameRecorder
+{
+public:
+  static constexpr auto MAX_QUEUED_IMAGES = 16;
+
+  explicit FrameRecorder(const std::filesystem::path& outputPath);
+  ~FrameRecorder();
+
+  FrameRecorder(const FrameRecorder&) = delete;
+  FrameRecorder& operator=(const FrameRecorder&) = delete;
+
+  /** Capture the current frame
+   *
+   * Must be called after presenting the upscaling buffer, but before
+   * swapping buffers.
+   */
+  void captureFrame(
+    renderer::Renderer* pRenderer,
+    renderer::UpscalingBuffer* pUpscalingBuffer);
+
+private:
+  struct SharedState;
+
+  std::shared_ptr<SharedState> mpState;
+  int mFrameNumber = 0;
+};
+
+} // namespace rigel
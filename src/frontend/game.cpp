@@ -19,11 +19,16 @@
 #include "assets/duke_script_loader.hpp"
 #include "assets/png_image.hpp"
 #include "base/defer.hpp"
+#include "base/job_system.hpp"
 #include "base/math_utils.hpp"
+#include "base/parallel.hpp"
+#include "base/startup_timings.hpp"
+#include "base/tracing.hpp"
 #include "data/duke_script.hpp"
 #include "data/game_traits.hpp"
 #include "engine/timing.hpp"
 #include "renderer/upscaling.hpp"
+#include "ui/audio_stats_display.hpp"
 #include "ui/imgui_integration.hpp"
 
 #include "anti_piracy_screen_mode.hpp"
@@ -39,6 +44,8 @@ RIGEL_DISABLE_WARNINGS
 RIGEL_RESTORE_WARNINGS
 
 #include <ctime>
+#include <fstream>
+#include <iostream>
 
 
 namespace rigel
@@ -49,6 +56,39 @@ using namespace engine;
 namespace
 {
 
+constexpr auto FRAME_TIME_STATISTICS_FILE = "frame_times.json";
+
+// When the current mode shows static content and there was no user input
+// for this long, the frame rate is lowered to IDLE_FRAME_RATE.
+constexpr auto IDLE_TIMEOUT = std::chrono::seconds{30};
+constexpr auto IDLE_FRAME_RATE = 15;
+
+// Listing all replacement directories can take a while with large mods, so
+// it's not done every frame.
+constexpr auto REPLACEMENT_POLL_INTERVAL = std::chrono::seconds{1};
+
+
+bool isUserInputEvent(const SDL_Event& event)
+{
+  switch (event.type)
+  {
+    case SDL_KEYDOWN:
+    case SDL_KEYUP:
+    case SDL_TEXTINPUT:
+    case SDL_MOUSEMOTION:
+    case SDL_MOUSEBUTTONDOWN:
+    case SDL_MOUSEBUTTONUP:
+    case SDL_MOUSEWHEEL:
+    case SDL_CONTROLLERAXISMOTION:
+    case SDL_CONTROLLERBUTTONDOWN:
+    case SDL_CONTROLLERBUTTONUP:
+      return true;
+
+    default:
+      return false;
+  }
+}
+
 auto wrapWithInitialFadeIn(std::unique_ptr<GameMode> mode)
 {
   class InitialFadeInWrapper : public GameMode
@@ -73,16 +113,24 @@ auto wrapWithInitialFadeIn(std::unique_ptr<GameMode> mode)
 }
 
 
-auto loadScripts(const assets::ResourceLoader& resources)
+double screenFadeProgress(const base::Clock::time_point startTime)
 {
-  auto allScripts = resources.loadScriptBundle("TEXT.MNI");
-  const auto optionsScripts = resources.loadScriptBundle("OPTIONS.MNI");
-  const auto orderInfoScripts = resources.loadScriptBundle("ORDERTXT.MNI");
+  using namespace std::chrono;
+
+  const auto elapsedTime =
+    duration<double>(base::Clock::now() - startTime).count();
+  const auto fastTicksElapsed = engine::timeToFastTicks(elapsedTime);
+  return std::clamp((fastTicksElapsed / 4.0) / 16.0, 0.0, 1.0);
+}
 
-  allScripts.insert(std::begin(optionsScripts), std::end(optionsScripts));
-  allScripts.insert(std::begin(orderInfoScripts), std::end(orderInfoScripts));
 
-  return allScripts;
+std::uint8_t interpolateAlpha(
+  const std::uint8_t startAlpha,
+  const std::uint8_t targetAlpha,
+  const double progress)
+{
+  return base::roundTo<std::uint8_t>(
+    startAlpha + (targetAlpha - startAlpha) * progress);
 }
 
 
@@ -95,9 +143,10 @@ std::unique_ptr<GameMode> createInitialGameMode(
   class DemoTestMode : public GameMode
   {
   public:
-    explicit DemoTestMode(Context context)
+    DemoTestMode(Context context, std::optional<int> benchmarkRenderInterval)
       : mDemoPlayer(context)
       , mpServiceProvider(context.mpServiceProvider)
+      , mBenchmarkRenderInterval(benchmarkRenderInterval)
     {
     }
 
@@ -105,10 +154,28 @@ std::unique_ptr<GameMode> createInitialGameMode(
       engine::TimeDelta dt,
       const std::vector<SDL_Event>&) override
     {
-      mDemoPlayer.updateAndRender(dt);
+      if (mDemoPlayer.isFinished())
+      {
+        return nullptr;
+      }
+
+      if (mBenchmarkRenderInterval)
+      {
+        mDemoPlayer.updateFastForward(*mBenchmarkRenderInterval);
+      }
+      else
+      {
+        mDemoPlayer.updateAndRender(dt);
+      }
 
       if (mDemoPlayer.isFinished())
       {
+        if (mBenchmarkRenderInterval)
+        {
+          game_logic::printBenchmarkStatistics(
+            std::cout, mDemoPlayer.benchmarkStatistics());
+        }
+
         mpServiceProvider->scheduleGameQuit();
       }
 
@@ -118,6 +185,7 @@ std::unique_ptr<GameMode> createInitialGameMode(
   private:
     game_logic::DemoPlayer mDemoPlayer;
     IGameServiceProvider* mpServiceProvider;
+    std::optional<int> mBenchmarkRenderInterval;
   };
 
   if (commandLineOptions.mLevelToJumpTo)
@@ -131,9 +199,14 @@ std::unique_ptr<GameMode> createInitialGameMode(
   {
     return std::make_unique<MenuMode>(context);
   }
+  else if (commandLineOptions.mBenchmarkDemo)
+  {
+    return std::make_unique<DemoTestMode>(
+      context, commandLineOptions.mBenchmarkRenderInterval);
+  }
   else if (commandLineOptions.mPlayDemo)
   {
-    return std::make_unique<DemoTestMode>(context);
+    return std::make_unique<DemoTestMode>(context, std::nullopt);
   }
 
   if (!isSharewareVersion)
@@ -148,12 +221,24 @@ std::unique_ptr<GameMode> createInitialGameMode(
 }
 
 
+int displayRefreshRate(SDL_Window* pWindow)
+{
+  SDL_DisplayMode displayMode;
+  if (SDL_GetWindowDisplayMode(pWindow, &displayMode) != 0)
+  {
+    return 0;
+  }
+
+  return displayMode.refresh_rate;
+}
+
+
 std::optional<renderer::FpsLimiter>
-  createLimiter(const data::GameOptions& options)
+  createLimiter(const data::GameOptions& options, SDL_Window* pWindow)
 {
   if (options.mEnableFpsLimit && !options.mEnableVsync)
   {
-    return renderer::FpsLimiter{options.mMaxFps};
+    return renderer::FpsLimiter{options.mMaxFps, displayRefreshRate(pWindow)};
   }
   else
   {
@@ -162,7 +247,43 @@ std::optional<renderer::FpsLimiter>
 }
 
 
-std::string makeScreenshotFilename()
+// GPU time available per frame, used for dynamic resolution scaling
+float determineFrameBudgetMs(
+  const data::GameOptions& options,
+  SDL_Window* pWindow)
+{
+  // Without a known refresh rate, assume the most common one
+  constexpr auto FALLBACK_REFRESH_RATE = 60;
+
+  const auto refreshRate = displayRefreshRate(pWindow);
+  const auto targetFps = options.mEnableFpsLimit && !options.mEnableVsync
+    ? options.mMaxFps
+    : refreshRate;
+
+  return 1000.0f / float(targetFps > 0 ? targetFps : FALLBACK_REFRESH_RATE);
+}
+
+
+std::optional<renderer::FrameDelayScheduler> createFrameDelayScheduler(
+  const data::GameOptions& options,
+  const CommandLineOptions& commandLineOptions,
+  SDL_Window* pWindow)
+{
+  const auto refreshRate = displayRefreshRate(pWindow);
+  if (
+    commandLineOptions.mReduceVsyncLatency && options.mEnableVsync &&
+    refreshRate > 0)
+  {
+    return renderer::FrameDelayScheduler{refreshRate};
+  }
+  else
+  {
+    return std::nullopt;
+  }
+}
+
+
+std::string makeTimestampedName()
 {
   using namespace std::literals;
 
@@ -179,7 +300,84 @@ std::string makeScreenshotFilename()
     "%Y-%m-%d_%H%M%S",
     pLocalTime);
 
-  return "RigelEngine_"s + dateTimeBuffer.data() + ".png";
+  return "RigelEngine_"s + dateTimeBuffer.data();
+}
+
+
+std::string makeScreenshotFilename()
+{
+  return makeTimestampedName() + ".png";
+}
+
+
+std::optional<assets::AssetCache>
+  createAssetCache(const assets::ResourceLoader& resources)
+{
+  constexpr auto ASSET_CACHE_SUBDIR = "asset_cache";
+
+  if (const auto maybePrefsDir = createOrGetPreferencesPath())
+  {
+    return assets::AssetCache{
+      *maybePrefsDir / ASSET_CACHE_SUBDIR, resources.contentKey()};
+  }
+
+  return std::nullopt;
+}
+
+
+int effectiveMaxReplacementScale(
+  SDL_Window* pWindow,
+  const renderer::Renderer& renderer,
+  const data::GameOptions& options)
+{
+  if (options.mMaxReplacementScale != data::MATCH_DISPLAY_REPLACEMENT_SCALE)
+  {
+    return options.mMaxReplacementScale;
+  }
+
+  // Reloading all assets whenever the window is resized would be too
+  // disruptive, so we go by the largest size the window can have on the
+  // current display. The drawable size can exceed the display mode's size
+  // on high-DPI displays, hence we consider both.
+  auto outputSize = renderer.windowSize();
+
+  SDL_DisplayMode displayMode;
+  if (
+    SDL_GetDesktopDisplayMode(
+      SDL_GetWindowDisplayIndex(pWindow), &displayMode) == 0)
+  {
+    outputSize.width = std::max(outputSize.width, displayMode.w);
+    outputSize.height = std::max(outputSize.height, displayMode.h);
+  }
+
+  const auto scale = renderer::determineMaxVisibleScale(outputSize);
+  LOG_F(INFO, "Limiting replacement images to %dx resolution", scale);
+  return scale;
+}
+
+
+std::unique_ptr<audio::SoundSystem> createSoundSystem(
+  const assets::ResourceLoader* pResources,
+  const data::GameOptions& options,
+  const assets::AssetCache* pAssetCache)
+{
+  std::unique_ptr<audio::SoundSystem> pResult;
+  try
+  {
+    pResult = std::make_unique<audio::SoundSystem>(
+      pResources,
+      options.mSoundStyle,
+      options.mAdlibPlaybackType,
+      options.mLowLatencyAudio,
+      pAssetCache);
+    pResult->setMusicPrerenderingEnabled(options.mPrerenderMusic);
+  }
+  catch (const std::exception& ex)
+  {
+    LOG_F(WARNING, "Failed to initialize audio: %s", ex.what());
+  }
+
+  return pResult;
 }
 
 } // namespace
@@ -200,38 +398,59 @@ std::filesystem::path effectiveGamePath(
 }
 
 
+Game::StartupAssets::StartupAssets(
+  const assets::ResourceLoader* pResources,
+  const assets::AssetCache* pAssetCache)
+  : mSprites(base::runAsync([pResources, pAssetCache]() {
+    const auto phase = base::startup_timings::ScopedPhase{"Sprite decoding"};
+    return engine::SpriteFactory::decodeSprites(pResources, pAssetCache);
+  }))
+  , mUiSpriteSheet(base::runAsync([pResources]() {
+    const auto phase =
+      base::startup_timings::ScopedPhase{"UI sprite sheet decoding"};
+
+    // Explicitly specify the palette here to avoid loading any replacement
+    // status.png file (since that is meant only for in-game, for now)
+    return pResources->loadUiSpriteSheet(data::GameTraits::INGAME_PALETTE);
+  }))
+  , mFont(base::runAsync([pResources]() {
+    const auto phase = base::startup_timings::ScopedPhase{"Font decoding"};
+    return pResources->loadFont();
+  }))
+{
+}
+
+
 Game::Game(
   const CommandLineOptions& commandLineOptions,
   UserProfile* pUserProfile,
   SDL_Window* pWindow,
   const bool isFirstLaunch)
   : mpWindow(pWindow)
-  , mRenderer(pWindow)
-  , mResources(
-      effectiveGamePath(commandLineOptions, *pUserProfile),
-      pUserProfile->mOptions.mEnableTopLevelMods,
-      pUserProfile->mModLibrary.enabledModPaths())
-  , mpSoundSystem([&]() -> std::unique_ptr<audio::SoundSystem> {
-    if (commandLineOptions.mDisableAudio)
-    {
-      return nullptr;
-    }
-
-    std::unique_ptr<audio::SoundSystem> pResult;
-    try
-    {
-      pResult = std::make_unique<audio::SoundSystem>(
-        &mResources,
-        pUserProfile->mOptions.mSoundStyle,
-        pUserProfile->mOptions.mAdlibPlaybackType);
-    }
-    catch (const std::exception& ex)
-    {
-      LOG_F(WARNING, "Failed to initialize audio: %s", ex.what());
-    }
-
-    return pResult;
-  }())
+  , mRenderer(base::startup_timings::measure(
+      "Renderer", [&]() { return renderer::Renderer(pWindow); }))
+  , mResources(base::startup_timings::measure(
+      "ResourceLoader",
+      [&]() {
+        return assets::ResourceLoader(
+          effectiveGamePath(commandLineOptions, *pUserProfile),
+          pUserProfile->mOptions.mEnableTopLevelMods,
+          pUserProfile->mModLibrary.enabledModPaths(),
+          effectiveMaxReplacementScale(
+            pWindow, mRenderer, pUserProfile->mOptions));
+      }))
+  , mAssetCache(createAssetCache(mResources))
+  , mStartupAssets(&mResources, mAssetCache ? &*mAssetCache : nullptr)
+  , mpSoundSystem(base::startup_timings::measure(
+      "Sound system",
+      [&]() {
+        return commandLineOptions.mDisableAudio
+          ? nullptr
+          : createSoundSystem(
+              &mResources,
+              pUserProfile->mOptions,
+              mAssetCache ? &*mAssetCache : nullptr);
+      }))
   , mIsShareWareVersion([this]() {
     // The registered version has 24 additional level files, and a
     // "anti-piracy" image (LCR.MNI). But we don't check for the presence of
@@ -243,8 +462,13 @@ Game::Game(
       mResources.hasFile("LCR.MNI") && mResources.hasFile("O1.MNI");
     return !hasRegisteredVersionFiles;
   }())
-  , mFpsLimiter(createLimiter(pUserProfile->mOptions))
+  , mFpsLimiter(createLimiter(pUserProfile->mOptions, pWindow))
+  , mFrameDelayScheduler(createFrameDelayScheduler(
+      pUserProfile->mOptions,
+      commandLineOptions,
+      pWindow))
   , mUpscalingBuffer(&mRenderer, pUserProfile->mOptions)
+  , mFrameBudgetMs(determineFrameBudgetMs(pUserProfile->mOptions, pWindow))
   , mIsRunning(true)
   , mIsMinimized(false)
   , mCommandLineOptions(commandLineOptions)
@@ -253,18 +477,33 @@ Game::Game(
   , mWidescreenModeWasActive(
       pUserProfile->mOptions.widescreenModeActive() &&
       renderer::canUseWidescreenMode(&mRenderer))
-  , mScriptRunner(&mResources, &mRenderer, &mpUserProfile->mSaveSlots, this)
-  , mAllScripts(loadScripts(mResources))
-  , mUiSpriteSheet(
-      // Explicitly specify the palette here to avoid loading any replacement
-      // status.png file (since that is meant only for in-game, for now)
-      renderer::Texture{
-        &mRenderer,
-        mResources.loadUiSpriteSheet(data::GameTraits::INGAME_PALETTE)},
-      &mRenderer)
-  , mSpriteFactory(&mRenderer, &mResources)
-  , mTextRenderer(&mUiSpriteSheet, &mRenderer, mResources)
+  , mUiTextures(&mRenderer, &mResources)
+  , mScriptRunner(
+      &mResources,
+      &mRenderer,
+      &mUiTextures,
+      &mpUserProfile->mSaveSlots,
+      this)
+  , mScripts(&mResources, mAssetCache ? &*mAssetCache : nullptr)
+  , mUiSpriteSheet(base::startup_timings::measure(
+      "UI sprite sheet upload",
+      [&]() {
+        return engine::TiledTexture(
+          renderer::Texture{&mRenderer, mStartupAssets.mUiSpriteSheet.get()},
+          &mRenderer);
+      }))
+  , mSpriteFactory(base::startup_timings::measure(
+      "Sprite factory",
+      [&]() {
+        return engine::SpriteFactory(
+          &mRenderer, mStartupAssets.mSprites.get());
+      }))
+  , mTextRenderer(&mUiSpriteSheet, &mRenderer, mStartupAssets.mFont.get())
 {
+  // The intro and main menu need scripts soon after startup, so we start
+  // parsing while the remaining initialization happens.
+  mScripts.prefetch();
+
   LOG_F(INFO, "Successfully loaded all resources");
   LOG_F(
     INFO,
@@ -276,35 +515,70 @@ Game::Game(
 
   applyChangedOptions();
 
-  mpCurrentGameMode = wrapWithInitialFadeIn(createInitialGameMode(
-    makeModeContext(),
-    mCommandLineOptions,
-    mIsShareWareVersion,
-    isFirstLaunch));
+  if (mCommandLineOptions.mWatchReplacementFiles)
+  {
+    moReplacementWatcher.emplace(mResources.replacementDirectories());
+    mLastReplacementPollTime = base::Clock::now();
+  }
+
+  {
+    const auto phase = base::startup_timings::ScopedPhase{"Initial game mode"};
+    mpCurrentGameMode = wrapWithInitialFadeIn(createInitialGameMode(
+      makeModeContext(),
+      mCommandLineOptions,
+      mIsShareWareVersion,
+      isFirstLaunch));
+  }
 
   LOG_F(INFO, "Game started");
 
   mLastTime = base::Clock::now();
+  mLastInputTime = mLastTime;
+}
+
+
+Game::~Game()
+{
+  // Jobs started by game modes, the sound system etc. might still refer to
+  // our resources, so they need to be done before anything is destroyed.
+  base::JobSystem::instance().waitUntilIdle();
 }
 
 
 auto Game::runOneFrame() -> std::optional<StopReason>
 {
+  RIGEL_TRACE_ZONE("Game::runOneFrame");
+
   using namespace std::chrono;
   using base::defer;
 
+#ifdef __EMSCRIPTEN__
+  if (skipBrowserFrame())
+  {
+    return {};
+  }
+#else
+  if (isIdle())
+  {
+    waitForNextIdleFrame();
+  }
+#endif
+
   const auto startOfFrame = base::Clock::now();
   const auto elapsed =
     duration<entityx::TimeDelta>(startOfFrame - mLastTime).count();
   mLastTime = startOfFrame;
 
-  pumpEvents();
+  pumpEvents(mEventQueue);
   if (!mIsRunning)
   {
     stopMusic();
     return StopReason::GameEnded;
   }
 
+  // Work handed back by jobs, like uploading textures to the GPU
+  base::JobSystem::instance().runMainThreadTasks();
+
   {
     ui::imgui_integration::beginFrame(mpWindow);
     auto imGuiFrameGuard = defer([]() { ui::imgui_integration::endFrame(); });
@@ -312,6 +586,7 @@ auto Game::runOneFrame() -> std::optional<StopReason>
 
     updateAndRender(elapsed);
     mEventQueue.clear();
+    std::swap(mEventQueue, mEventsReceivedDuringFade);
   }
 
   if (mScreenshotRequested)
@@ -320,10 +595,42 @@ auto Game::runOneFrame() -> std::optional<StopReason>
     mScreenshotRequested = false;
   }
 
+  if (mFrameRecorder)
+  {
+    mFrameRecorder->captureFrame(&mRenderer, &mUpscalingBuffer);
+  }
+
+  if (mFrameDelayScheduler)
+  {
+    mFrameDelayScheduler->frameWorkDone();
+  }
+
   swapBuffers();
 
+  mFpsDisplay.addFrame(
+    {elapsed,
+     mCurrentFrameLogicTime,
+     std::max(0.0, mCurrentFrameUpdateTime - mCurrentFrameLogicTime),
+     mCurrentFramePresentTime});
+
+  // Delaying is done after recording the frame, so that the delay shows up
+  // as part of the next frame's total time
+  if (mFrameDelayScheduler)
+  {
+    mFrameDelayScheduler->waitForNextFrame();
+  }
+
+  mCurrentFrameLogicTime = 0;
+  mCurrentFrameUpdateTime = 0;
+  mCurrentFramePresentTime = 0;
+
   const auto changedOptionsRequireRestart = applyChangedOptions();
 
+  if (reloadChangedReplacementFiles())
+  {
+    return StopReason::RestartNeeded;
+  }
+
   if (!mGamePathToSwitchTo.empty())
   {
     mpUserProfile->mGamePath = mGamePathToSwitchTo;
@@ -342,36 +649,133 @@ auto Game::runOneFrame() -> std::optional<StopReason>
 }
 
 
-void Game::pumpEvents()
+void Game::pumpEvents(std::vector<SDL_Event>& eventQueue)
 {
   SDL_Event event;
+#ifndef __EMSCRIPTEN__
   while (mIsMinimized && SDL_WaitEvent(&event))
   {
-    if (!handleEvent(event))
-    {
-      mEventQueue.push_back(event);
-    }
+    queueEvent(event, eventQueue);
   }
+#endif
 
   while (SDL_PollEvent(&event))
   {
-    if (!handleEvent(event))
+    queueEvent(event, eventQueue);
+  }
+}
+
+
+void Game::queueEvent(
+  const SDL_Event& event,
+  std::vector<SDL_Event>& eventQueue)
+{
+  if (isUserInputEvent(event))
+  {
+    mLastInputTime = base::Clock::now();
+  }
+
+  if (!handleEvent(event))
+  {
+    eventQueue.push_back(event);
+  }
+}
+
+
+bool Game::isIdle() const
+{
+  return mIsRunning && mpUserProfile->mOptions.mIdlePowerSaving &&
+    mpCurrentGameMode->showsStaticContent() && !mActiveFadeIn &&
+    base::Clock::now() - mLastInputTime > IDLE_TIMEOUT;
+}
+
+
+void Game::waitForNextIdleFrame()
+{
+  using namespace std::chrono;
+
+  RIGEL_TRACE_ZONE("Game::waitForNextIdleFrame");
+
+  // Instead of rendering at full rate, sleep until the next frame is due.
+  // User input ends the idle state, and wakes us up right away.
+  const auto nextFrameTime = mLastTime +
+    duration_cast<base::Clock::duration>(
+      duration<double>(1.0 / IDLE_FRAME_RATE));
+
+  auto now = base::Clock::now();
+  while (now < nextFrameTime && isIdle())
+  {
+    const auto timeout = duration_cast<milliseconds>(nextFrameTime - now);
+
+    SDL_Event event;
+    if (SDL_WaitEventTimeout(&event, std::max(1, int(timeout.count()))))
     {
-      mEventQueue.push_back(event);
+      queueEvent(event, mEventQueue);
     }
+
+    now = base::Clock::now();
   }
 }
 
 
+bool Game::skipBrowserFrame()
+{
+  using namespace std::chrono;
+
+  // In the browser, we are called once per animation frame and can't block
+  // the main thread, so waiting like in waitForNextIdleFrame() isn't an
+  // option. Instead, we process input but leave out updating and rendering
+  // for as long as the page is hidden, or until the next idle frame is due.
+  // Audio keeps playing either way, since it's driven by its own callback.
+  SDL_Event event;
+  while (SDL_PollEvent(&event))
+  {
+    queueEvent(event, mEventQueue);
+  }
+
+  if (!mIsRunning)
+  {
+    return false;
+  }
+
+  if (mIsMinimized)
+  {
+    return true;
+  }
+
+  return isIdle() &&
+    base::Clock::now() - mLastTime <
+    duration_cast<base::Clock::duration>(
+      duration<double>(1.0 / IDLE_FRAME_RATE));
+}
+
+
 void Game::updateAndRender(const entityx::TimeDelta elapsed)
 {
+  using std::chrono::duration;
+
   mCurrentFrameIsWidescreen = false;
 
+  // Recorded frames are read back from the upscaling buffer as is, so
+  // they need to be rendered at full resolution.
+  if (mFrameRecorder)
+  {
+    mUpscalingBuffer.resetDynamicResolution();
+  }
+  else
+  {
+    mUpscalingBuffer.updateDynamicResolution(
+      mRenderer.lastFrameStatistics().mGpuTimeMs, mFrameBudgetMs);
+  }
+
+  const auto startOfUpdate = base::Clock::now();
   auto pMaybeNextMode = std::invoke([&]() {
     auto saved = mUpscalingBuffer.bindAndClear(
       mpUserProfile->mOptions.mPerElementUpscalingEnabled);
     return mpCurrentGameMode->updateAndRender(elapsed, mEventQueue);
   });
+  mCurrentFrameUpdateTime +=
+    duration<engine::TimeDelta>(base::Clock::now() - startOfUpdate).count();
 
   if (pMaybeNextMode)
   {
@@ -379,6 +783,7 @@ void Game::updateAndRender(const entityx::TimeDelta elapsed)
 
     setPerElementUpscalingEnabled(pMaybeNextMode->needsPerElementUpscaling());
     mpCurrentGameMode = std::move(pMaybeNextMode);
+    mLastInputTime = base::Clock::now();
 
     {
       auto saved = mUpscalingBuffer.bindAndClear(
@@ -389,13 +794,31 @@ void Game::updateAndRender(const entityx::TimeDelta elapsed)
     fadeInScreen();
   }
 
+  updateScreenFadeIn();
+
+  const auto startOfPresent = base::Clock::now();
   mUpscalingBuffer.present(
     mCurrentFrameIsWidescreen,
     mpUserProfile->mOptions.mPerElementUpscalingEnabled);
+  mCurrentFramePresentTime +=
+    duration<engine::TimeDelta>(base::Clock::now() - startOfPresent).count();
 
+  auto fpsDisplayHeight = 0.0f;
   if (mpUserProfile->mOptions.mShowFpsCounter)
   {
-    mFpsDisplay.updateAndRender(elapsed);
+    const auto pacingStats = mFpsLimiter
+      ? std::optional{mFpsLimiter->pacingStats()}
+      : std::nullopt;
+    const auto frameDelayStats = mFrameDelayScheduler
+      ? std::optional{mFrameDelayScheduler->stats()}
+      : std::nullopt;
+    fpsDisplayHeight =
+      mFpsDisplay.updateAndRender(elapsed, pacingStats, frameDelayStats);
+  }
+
+  if (mpUserProfile->mOptions.mShowAudioStats && mpSoundSystem)
+  {
+    ui::drawAudioStats(mpSoundSystem->audioStats(), fpsDisplayHeight);
   }
 }
 
@@ -407,9 +830,10 @@ GameMode::Context Game::makeModeContext()
     &mRenderer,
     this,
     &mScriptRunner,
-    &mAllScripts,
+    &mScripts,
     &mTextRenderer,
     &mUiSpriteSheet,
+    &mUiTextures,
     &mSpriteFactory,
     mpUserProfile};
 }
@@ -426,7 +850,13 @@ bool Game::handleEvent(const SDL_Event& event)
   switch (event.type)
   {
     case SDL_KEYUP:
-      if (event.key.keysym.sym == SDLK_F6)
+      if (
+        event.key.keysym.sym == SDLK_F6 &&
+        (event.key.keysym.mod & KMOD_SHIFT))
+      {
+        writeFrameTimeStatistics();
+      }
+      else if (event.key.keysym.sym == SDLK_F6)
       {
         options.mShowFpsCounter = !options.mShowFpsCounter;
       }
@@ -434,6 +864,10 @@ bool Game::handleEvent(const SDL_Event& event)
       {
         mScreenshotRequested = true;
       }
+      else if (event.key.keysym.sym == SDLK_F9)
+      {
+        toggleRecording();
+      }
       return false;
 
     case SDL_QUIT:
@@ -444,6 +878,10 @@ bool Game::handleEvent(const SDL_Event& event)
       switch (event.window.event)
       {
         case SDL_WINDOWEVENT_MINIMIZED:
+#ifdef __EMSCRIPTEN__
+        // Sent when the browser tab is in the background
+        case SDL_WINDOWEVENT_HIDDEN:
+#endif
           LOG_F(INFO, "Window minimized, pausing");
           mIsMinimized = true;
           break;
@@ -452,6 +890,9 @@ bool Game::handleEvent(const SDL_Event& event)
         case SDL_WINDOWEVENT_FOCUS_GAINED:
         case SDL_WINDOWEVENT_MAXIMIZED:
         case SDL_WINDOWEVENT_RESTORED:
+#ifdef __EMSCRIPTEN__
+        case SDL_WINDOWEVENT_SHOWN:
+#endif
           LOG_IF_F(INFO, mIsMinimized, "Window restored, unpausing");
           mIsMinimized = false;
           break;
@@ -487,57 +928,83 @@ bool Game::handleEvent(const SDL_Event& event)
 }
 
 
-void Game::performScreenFadeBlocking(const FadeType type)
+void Game::performScreenFadeOutBlocking()
 {
 #ifdef __EMSCRIPTEN__
-  // TODO: Implement screen fades for the Emscripten version.
+  // TODO: Implement screen fade-outs for the Emscripten version.
   // This is not so easy because we can't simply do a loop that renders
   // multiple frames when running in the browser, as it just blocks the
   // browser's main thread and the intermediate (faded) frames are not
   // shown until the current requestAnimationFrame() callback returns.
-  // So we'd need to either find a way to suspend and then resume C++ code
-  // execution during the fade, or rewrite all client code to be stateful
-  // instead of relying on a blocking fade() function.
-  mUpscalingBuffer.setAlphaMod(type == FadeType::In ? 255 : 0);
+  // Fade-ins don't have this problem, since they progress over the
+  // following frames (see updateScreenFadeIn()). But fade-outs are
+  // expected to be complete once fadeOutScreen() returns, so we'd need to
+  // either find a way to suspend and then resume C++ code execution during
+  // the fade, or rewrite all client code to be stateful.
+  mUpscalingBuffer.setAlphaMod(0);
 #else
-  using namespace std::chrono;
-
   auto saved = renderer::saveState(&mRenderer);
   mRenderer.resetState();
 
-  auto startTime = base::Clock::now();
+  const auto startTime = base::Clock::now();
+  const auto startAlpha = mUpscalingBuffer.alphaMod();
+
+  mUpscalingBuffer.holdFrame();
 
   while (mIsRunning)
   {
-    const auto now = base::Clock::now();
-    const auto elapsedTime = duration<double>(now - startTime).count();
-    const auto fastTicksElapsed = engine::timeToFastTicks(elapsedTime);
-    const auto fadeFactor =
-      std::clamp((fastTicksElapsed / 4.0) / 16.0, 0.0, 1.0);
-    const auto alpha = type == FadeType::In ? fadeFactor : 1.0 - fadeFactor;
-    const auto alphaMod = base::roundTo<std::uint8_t>(255.0 * alpha);
+    const auto progress = screenFadeProgress(startTime);
 
-    mUpscalingBuffer.setAlphaMod(alphaMod);
+    mUpscalingBuffer.setAlphaMod(interpolateAlpha(startAlpha, 0, progress));
     mUpscalingBuffer.present(
       mCurrentFrameIsWidescreen,
       mpUserProfile->mOptions.mPerElementUpscalingEnabled);
     swapBuffers();
 
-    if (fadeFactor >= 1.0)
+    // Keep the window responsive. We might currently be inside the game
+    // mode's updateAndRender(), which is iterating over mEventQueue, so
+    // other events need to be kept in a separate queue until the next frame.
+    pumpEvents(mEventsReceivedDuringFade);
+
+    if (progress >= 1.0)
     {
       break;
     }
   }
 
+  mUpscalingBuffer.restoreFrame();
+
   // Pretend that the fade didn't take any time
   mLastTime = base::Clock::now();
 #endif
 }
 
 
+void Game::updateScreenFadeIn()
+{
+  if (!mActiveFadeIn)
+  {
+    return;
+  }
+
+  const auto progress = screenFadeProgress(mActiveFadeIn->mStartTime);
+  mUpscalingBuffer.setAlphaMod(
+    interpolateAlpha(mActiveFadeIn->mStartAlpha, 255, progress));
+
+  if (progress >= 1.0)
+  {
+    mActiveFadeIn.reset();
+  }
+}
+
+
 void Game::swapBuffers()
 {
+  const auto startOfSwap = base::Clock::now();
   mRenderer.swapBuffers();
+  mCurrentFramePresentTime +=
+    std::chrono::duration<engine::TimeDelta>(base::Clock::now() - startOfSwap)
+      .count();
 
   if (mFpsLimiter)
   {
@@ -546,6 +1013,76 @@ void Game::swapBuffers()
 }
 
 
+/** Hot-reload replacement files modified since the last check
+ *
+ * Sprites and sound effects are reloaded in place. Tilesets and backdrops
+ * are read whenever a level is loaded, so they don't need any action.
+ * For all other changes, including added or removed files, this returns
+ * true to request a full restart.
+ */
+bool Game::reloadChangedReplacementFiles()
+{
+  const auto now = base::Clock::now();
+  if (
+    !moReplacementWatcher ||
+    now - mLastReplacementPollTime < REPLACEMENT_POLL_INTERVAL)
+  {
+    return false;
+  }
+
+  mLastReplacementPollTime = now;
+
+  const auto changes = moReplacementWatcher->poll();
+  if (changes.mFileSetChanged)
+  {
+    LOG_F(INFO, "Replacement files were added or removed, restarting");
+    return true;
+  }
+
+  std::vector<data::ActorID> changedActors;
+  std::vector<data::SoundId> changedSounds;
+
+  for (const auto& fileName : changes.mModifiedFiles)
+  {
+    if (const auto oActorId = assets::actorForReplacementFile(fileName))
+    {
+      changedActors.push_back(*oActorId);
+    }
+    else if (const auto oSoundId = assets::soundForReplacementFile(fileName))
+    {
+      changedSounds.push_back(*oSoundId);
+    }
+    else if (assets::isLevelImageReplacementFile(fileName))
+    {
+      LOG_F(
+        INFO,
+        "%s changed, will be used when loading the next level",
+        fileName.c_str());
+    }
+    else
+    {
+      LOG_F(INFO, "%s changed, restarting", fileName.c_str());
+      return true;
+    }
+  }
+
+  if (
+    !changedActors.empty() &&
+    !mSpriteFactory.reloadActorImages(changedActors))
+  {
+    LOG_F(INFO, "Sprites can't be reloaded in place, restarting");
+    return true;
+  }
+
+  if (!changedSounds.empty() && mpSoundSystem)
+  {
+    mpSoundSystem->reloadReplacementSounds(changedSounds);
+  }
+
+  return false;
+}
+
+
 bool Game::applyChangedOptions()
 {
   const auto& currentOptions = mpUserProfile->mOptions;
@@ -604,7 +1141,36 @@ bool Game::applyChangedOptions()
     currentOptions.mEnableFpsLimit != mPreviousOptions.mEnableFpsLimit ||
     currentOptions.mMaxFps != mPreviousOptions.mMaxFps)
   {
-    mFpsLimiter = createLimiter(currentOptions);
+    mFpsLimiter = createLimiter(currentOptions, mpWindow);
+    mFrameBudgetMs = determineFrameBudgetMs(currentOptions, mpWindow);
+  }
+
+  if (currentOptions.mEnableVsync != mPreviousOptions.mEnableVsync)
+  {
+    mFrameDelayScheduler =
+      createFrameDelayScheduler(currentOptions, mCommandLineOptions, mpWindow);
+  }
+
+  // Changing the buffer size requires reopening the audio device, so the
+  // whole sound system is recreated. The new instance starts out with
+  // default volumes and no music, so those are restored afterwards.
+  auto soundSystemRecreated = false;
+  if (
+    !mCommandLineOptions.mDisableAudio &&
+    currentOptions.mLowLatencyAudio != mPreviousOptions.mLowLatencyAudio)
+  {
+    const auto musicPosition =
+      mpSoundSystem ? mpSoundSystem->musicPosition() : std::size_t{0};
+
+    mpSoundSystem.reset();
+    mpSoundSystem = createSoundSystem(
+      &mResources, currentOptions, mAssetCache ? &*mAssetCache : nullptr);
+    soundSystemRecreated = true;
+
+    if (mpSoundSystem && !mCurrentSong.empty())
+    {
+      mpSoundSystem->playSong(mCurrentSong, musicPosition);
+    }
   }
 
   if (mpSoundSystem)
@@ -620,7 +1186,14 @@ bool Game::applyChangedOptions()
       mpSoundSystem->setAdlibPlaybackType(currentOptions.mAdlibPlaybackType);
     }
 
+    if (currentOptions.mPrerenderMusic != mPreviousOptions.mPrerenderMusic)
+    {
+      mpSoundSystem->setMusicPrerenderingEnabled(
+        currentOptions.mPrerenderMusic);
+    }
+
     if (
+      soundSystemRecreated ||
       currentOptions.mMusicVolume != mPreviousOptions.mMusicVolume ||
       currentOptions.mMusicOn != mPreviousOptions.mMusicOn)
     {
@@ -630,6 +1203,7 @@ bool Game::applyChangedOptions()
     }
 
     if (
+      soundSystemRecreated ||
       currentOptions.mSoundVolume != mPreviousOptions.mSoundVolume ||
       currentOptions.mSoundOn != mPreviousOptions.mSoundOn)
     {
@@ -639,24 +1213,37 @@ bool Game::applyChangedOptions()
     }
   }
 
+  // Window size changes are only acted upon once the user has finished
+  // resizing, to avoid reconfiguring the upscaling buffer on every frame
+  // while dragging the window border.
+  const auto windowSizeSettled = !mRenderer.isWindowResizing();
   const auto widescreenModeActive = currentOptions.widescreenModeActive() &&
     renderer::canUseWidescreenMode(&mRenderer);
   if (
     widescreenModeActive != mWidescreenModeWasActive ||
-    mPreviousWindowSize != mRenderer.windowSize() ||
+    (windowSizeSettled && mPreviousWindowSize != mRenderer.windowSize()) ||
     currentOptions.mUpscalingFilter != mPreviousOptions.mUpscalingFilter ||
     currentOptions.mAspectRatioCorrectionEnabled !=
-      mPreviousOptions.mAspectRatioCorrectionEnabled)
+      mPreviousOptions.mAspectRatioCorrectionEnabled ||
+    currentOptions.mDynamicResolutionEnabled !=
+      mPreviousOptions.mDynamicResolutionEnabled)
   {
     mUpscalingBuffer.updateConfiguration(currentOptions);
   }
 
   const auto restartNeeded =
-    currentOptions.mEnableTopLevelMods != mPreviousOptions.mEnableTopLevelMods;
+    currentOptions.mEnableTopLevelMods !=
+      mPreviousOptions.mEnableTopLevelMods ||
+    currentOptions.mMaxReplacementScale !=
+      mPreviousOptions.mMaxReplacementScale;
 
   mPreviousOptions = mpUserProfile->mOptions;
   mWidescreenModeWasActive = widescreenModeActive;
-  mPreviousWindowSize = mRenderer.windowSize();
+
+  if (windowSizeSettled)
+  {
+    mPreviousWindowSize = mRenderer.windowSize();
+  }
 
   return restartNeeded;
 }
@@ -712,16 +1299,42 @@ void Game::enumerateGameControllers()
 }
 
 
+void Game::writeFrameTimeStatistics()
+{
+  const auto path = std::filesystem::u8path(FRAME_TIME_STATISTICS_FILE);
+
+  auto file = std::ofstream{path};
+  mFpsDisplay.writeStatistics(file);
+
+  if (file)
+  {
+    LOG_F(INFO, "Saved frame time statistics: %s", path.u8string().c_str());
+  }
+  else
+  {
+    LOG_F(
+      ERROR,
+      "Failed to save frame time statistics: %s",
+      path.u8string().c_str());
+  }
+}
+
+
 void Game::takeScreenshot()
 {
   namespace fs = std::filesystem;
 
   constexpr auto SCREENSHOTS_SUBDIR = "screenshots";
 
-  const auto shot = mRenderer.grabCurrentFramebuffer();
+  // All paths are determined up front on the main thread, the actual PNG
+  // encoding and writing happens on the background worker once the
+  // framebuffer contents have arrived.
   const auto filename = makeScreenshotFilename();
+  const auto gameDirScreenshotPath =
+    effectiveGamePath(mCommandLineOptions, *mpUserProfile) / SCREENSHOTS_SUBDIR;
+  const auto maybePrefsDir = createOrGetPreferencesPath();
 
-  auto saveShot = [&](const fs::path& path) {
+  auto saveShot = [filename](const fs::path& path, const data::Image& shot) {
     std::error_code ec;
 
     if (!fs::exists(path, ec) && !ec)
@@ -732,20 +1345,69 @@ void Game::takeScreenshot()
     return assets::savePng(path / filename, shot);
   };
 
-  const auto gameDirScreenshotPath =
-    effectiveGamePath(mCommandLineOptions, *mpUserProfile) / SCREENSHOTS_SUBDIR;
+  mRenderer.grabCurrentFramebufferAsync(
+    [=, pWorker = &mFileWriteWorker](data::Image shot) {
+      pWorker->submit([=, shot = std::move(shot)]() {
+        // First, try the game dir.
+        if (saveShot(gameDirScreenshotPath, shot))
+        {
+          return;
+        }
+
+        // If the game dir is not writable, try the user profile dir.
+        if (maybePrefsDir)
+        {
+          saveShot(*maybePrefsDir / SCREENSHOTS_SUBDIR, shot);
+        }
+      });
+    });
+}
+
+
+void Game::toggleRecording()
+{
+  namespace fs = std::filesystem;
+
+  constexpr auto RECORDINGS_SUBDIR = "recordings";
+
+  if (mFrameRecorder)
+  {
+    mFrameRecorder.reset();
+    return;
+  }
+
+  const auto recordingName = makeTimestampedName();
+
+  auto canWriteTo = [](const fs::path& path) {
+    std::error_code ec;
+    fs::create_directories(path, ec);
+    return !ec;
+  };
+
+  // Same as for screenshots: Prefer the game dir, fall back to the user
+  // profile dir.
+  const auto gameDirRecordingPath =
+    effectiveGamePath(mCommandLineOptions, *mpUserProfile) / RECORDINGS_SUBDIR /
+    recordingName;
 
-  // First, try the game dir.
-  if (saveShot(gameDirScreenshotPath))
+  if (canWriteTo(gameDirRecordingPath))
   {
+    mFrameRecorder.emplace(gameDirRecordingPath);
     return;
   }
 
-  // If the game dir is not writable, try the user profile dir.
   if (const auto maybePrefsDir = createOrGetPreferencesPath(); maybePrefsDir)
   {
-    saveShot(*maybePrefsDir / SCREENSHOTS_SUBDIR);
+    const auto prefsDirRecordingPath =
+      *maybePrefsDir / RECORDINGS_SUBDIR / recordingName;
+    if (canWriteTo(prefsDirRecordingPath))
+    {
+      mFrameRecorder.emplace(prefsDirRecordingPath);
+      return;
+    }
   }
+
+  LOG_F(ERROR, "Couldn't create a directory for recording");
 }
 
 
@@ -760,13 +1422,15 @@ void Game::setPerElementUpscalingEnabled(bool enabled)
 
 void Game::fadeOutScreen()
 {
+  mActiveFadeIn.reset();
+
   if (mUpscalingBuffer.alphaMod() == 0)
   {
     // Already faded out
     return;
   }
 
-  performScreenFadeBlocking(FadeType::Out);
+  performScreenFadeOutBlocking();
 
   // Clear render canvas after a fade-out
   mUpscalingBuffer.clear();
@@ -777,13 +1441,13 @@ void Game::fadeOutScreen()
 
 void Game::fadeInScreen()
 {
-  if (mUpscalingBuffer.alphaMod() == 255)
+  if (mActiveFadeIn || mUpscalingBuffer.alphaMod() == 255)
   {
-    // Already faded in
+    // Already fading in or faded in
     return;
   }
 
-  performScreenFadeBlocking(FadeType::In);
+  mActiveFadeIn = ScreenFade{base::Clock::now(), mUpscalingBuffer.alphaMod()};
 }
 
 
@@ -816,6 +1480,8 @@ void Game::stopAllSounds()
 
 void Game::playMusic(const std::string& name)
 {
+  mCurrentSong = name;
+
   if (mpSoundSystem)
   {
     mpSoundSystem->playSong(name);
@@ -823,8 +1489,19 @@ void Game::playMusic(const std::string& name)
 }
 
 
+void Game::prefetchMusic(const std::string& name)
+{
+  if (mpSoundSystem)
+  {
+    mpSoundSystem->prefetchSong(name);
+  }
+}
+
+
 void Game::stopMusic()
 {
+  mCurrentSong.clear();
+
   if (mpSoundSystem)
   {
     mpSoundSystem->stopMusic();
@@ -16,18 +16,24 @@
 
 #pragma once
 
+#include "assets/asset_cache.hpp"
 #include "assets/duke_script_loader.hpp"
+#include "assets/replacement_watcher.hpp"
 #include "assets/resource_loader.hpp"
 #include "audio/sound_system.hpp"
 #include "base/clock.hpp"
 #include "base/spatial_types.hpp"
 #include "base/warnings.hpp"
+#include "base/worker_thread.hpp"
 #include "engine/sprite_factory.hpp"
 #include "engine/tiled_texture.hpp"
+#include "frontend/frame_recorder.hpp"
 #include "frontend/game_mode.hpp"
 #include "frontend/game_service_provider.hpp"
+#include "frontend/script_bundle_cache.hpp"
 #include "frontend/user_profile.hpp"
 #include "renderer/fps_limiter.hpp"
+#include "renderer/frame_delay_scheduler.hpp"
 #include "renderer/renderer.hpp"
 #include "renderer/texture.hpp"
 #include "renderer/upscaling.hpp"
@@ -35,9 +41,11 @@
 #include "ui/duke_script_runner.hpp"
 #include "ui/fps_display.hpp"
 #include "ui/menu_element_renderer.hpp"
+#include "ui/ui_texture_cache.hpp"
 
 #include <SDL_gamecontroller.h>
 
+#include <future>
 #include <memory>
 #include <optional>
 #include <string>
@@ -72,6 +80,7 @@ public:
     UserProfile* pUserProfile,
     SDL_Window* pWindow,
     bool isFirstLaunch);
+  ~Game();
   Game(const Game&) = delete;
   Game& operator=(const Game&) = delete;
 
@@ -90,25 +99,51 @@ public:
   std::optional<StopReason> runOneFrame();
 
 private:
-  enum class FadeType
+  struct ScreenFade
   {
-    In,
-    Out
+    base::Clock::time_point mStartTime;
+    std::uint8_t mStartAlpha;
   };
 
-  void pumpEvents();
+  /** Assets which are decoded on worker threads during startup
+   *
+   * Decoding starts right after the resource loader has been created, and
+   * runs concurrently with the remaining initialization. The results are
+   * consumed (and uploaded to the GPU on the main thread) by the members
+   * initialized later on.
+   */
+  struct StartupAssets
+  {
+    StartupAssets(
+      const assets::ResourceLoader* pResources,
+      const assets::AssetCache* pAssetCache);
+
+    std::future<engine::SpriteFactory::DecodedSprites> mSprites;
+    std::future<data::Image> mUiSpriteSheet;
+    std::future<assets::FontData> mFont;
+  };
+
+  void pumpEvents(std::vector<SDL_Event>& eventQueue);
+  void queueEvent(const SDL_Event& event, std::vector<SDL_Event>& eventQueue);
+  bool isIdle() const;
+  void waitForNextIdleFrame();
+  bool skipBrowserFrame();
   void updateAndRender(entityx::TimeDelta elapsed);
 
   GameMode::Context makeModeContext();
 
   bool handleEvent(const SDL_Event& event);
 
-  void performScreenFadeBlocking(FadeType type);
+  void performScreenFadeOutBlocking();
+  void updateScreenFadeIn();
 
   void swapBuffers();
   bool applyChangedOptions();
+  bool reloadChangedReplacementFiles();
   void enumerateGameControllers();
   void takeScreenshot();
+  void writeFrameTimeStatistics();
+  void toggleRecording();
   void setPerElementUpscalingEnabled(bool enabled);
 
   // IGameServiceProvider implementation
@@ -118,6 +153,7 @@ private:
   void stopSound(data::SoundId id) override;
   void stopAllSounds() override;
   void playMusic(const std::string& name) override;
+  void prefetchMusic(const std::string& name) override;
   void stopMusic() override;
 
   void scheduleGameQuit() override;
@@ -129,6 +165,11 @@ private:
     mCurrentFrameIsWidescreen = true;
   }
 
+  void reportGameLogicTime(const engine::TimeDelta time) override
+  {
+    mCurrentFrameLogicTime += time;
+  }
+
   bool isSharewareVersion() const override { return mIsShareWareVersion; }
 
   const CommandLineOptions& commandLineOptions() const override
@@ -145,19 +186,30 @@ private:
   SDL_Window* mpWindow;
   renderer::Renderer mRenderer;
   assets::ResourceLoader mResources;
+  std::optional<assets::AssetCache> mAssetCache;
+  StartupAssets mStartupAssets;
   std::unique_ptr<audio::SoundSystem> mpSoundSystem;
+  std::string mCurrentSong;
   bool mIsShareWareVersion;
 
   std::optional<renderer::FpsLimiter> mFpsLimiter;
+  std::optional<renderer::FrameDelayScheduler> mFrameDelayScheduler;
   renderer::UpscalingBuffer mUpscalingBuffer;
+  float mFrameBudgetMs;
   bool mCurrentFrameIsWidescreen = false;
 
+  // Time spent on parts of the current frame, for mFpsDisplay
+  engine::TimeDelta mCurrentFrameLogicTime = 0;
+  engine::TimeDelta mCurrentFrameUpdateTime = 0;
+  engine::TimeDelta mCurrentFramePresentTime = 0;
+
   std::unique_ptr<GameMode> mpCurrentGameMode;
 
   bool mIsRunning;
   bool mIsMinimized;
   bool mScreenshotRequested = false;
   base::Clock::time_point mLastTime;
+  base::Clock::time_point mLastInputTime;
 
   CommandLineOptions mCommandLineOptions;
   UserProfile* mpUserProfile;
@@ -166,15 +218,30 @@ private:
   bool mWidescreenModeWasActive;
   std::filesystem::path mGamePathToSwitchTo;
 
+  // Only used with --watch-replacements
+  std::optional<assets::ReplacementWatcher> moReplacementWatcher;
+  base::Clock::time_point mLastReplacementPollTime;
+
+  ui::UiTextureCache mUiTextures;
   ui::DukeScriptRunner mScriptRunner;
-  assets::ScriptBundle mAllScripts;
+  ScriptBundleCache mScripts;
   engine::TiledTexture mUiSpriteSheet;
   engine::SpriteFactory mSpriteFactory;
   ui::MenuElementRenderer mTextRenderer;
   ui::FpsDisplay mFpsDisplay;
   std::vector<SDL_Event> mEventQueue;
 
+  // Events received while a blocking fade-out is in progress, delivered
+  // with the next frame's events
+  std::vector<SDL_Event> mEventsReceivedDuringFade;
+  std::optional<ScreenFade> mActiveFadeIn;
+
   GameControllerInfo mGameControllerInfo;
+  std::optional<FrameRecorder> mFrameRecorder;
+
+  // Declared last so that outstanding file writes are completed before
+  // any other members are destroyed
+  base::WorkerThread mFileWriteWorker;
 };
 
 } // namespace rigel
@@ -16,6 +16,7 @@
 
 #include "game_mode.hpp"
 
+#include "frontend/script_bundle_cache.hpp"
 #include "ui/duke_script_runner.hpp"
 
 
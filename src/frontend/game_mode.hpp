@@ -33,6 +33,7 @@ namespace rigel
 {
 
 struct IGameServiceProvider;
+class ScriptBundleCache;
 class UserProfile;
 
 namespace engine
@@ -50,6 +51,7 @@ namespace ui
 {
 class MenuElementRenderer;
 class DukeScriptRunner;
+class UiTextureCache;
 } // namespace ui
 
 
@@ -62,9 +64,10 @@ struct GameMode
     renderer::Renderer* mpRenderer;
     IGameServiceProvider* mpServiceProvider;
     ui::DukeScriptRunner* mpScriptRunner;
-    assets::ScriptBundle* mpScripts;
+    ScriptBundleCache* mpScripts;
     ui::MenuElementRenderer* mpUiRenderer;
     engine::TiledTexture* mpUiSpriteSheet;
+    ui::UiTextureCache* mpUiTextures;
     engine::SpriteFactory* mpSpriteFactory;
     UserProfile* mpUserProfile;
   };
@@ -76,6 +79,15 @@ struct GameMode
     const std::vector<SDL_Event>& events) = 0;
 
   virtual bool needsPerElementUpscaling() const { return false; }
+
+  /** True if the mode currently shows mostly static content
+   *
+   * This is the case for menus, the high score list etc., which only have
+   * small animations, if any. When enabled in the options, Game lowers the
+   * frame rate while this returns true and there's no user input for a
+   * while.
+   */
+  virtual bool showsStaticContent() const { return false; }
 };
 
 
@@ -16,13 +16,27 @@
 
 #include "game_runner.hpp"
 
+#include "base/clock.hpp"
 #include "base/math_utils.hpp"
+#include "base/memory_accounting.hpp"
+#include "base/tick_profiler.hpp"
+#include "base/tracing.hpp"
+#include "engine/sprite_factory.hpp"
 #include "frontend/game_service_provider.hpp"
 #include "frontend/user_profile.hpp"
 #include "game_logic/game_world.hpp"
 #include "game_logic_classic/game_world_classic.hpp"
+#include "renderer/renderer.hpp"
 #include "ui/utils.hpp"
 
+RIGEL_DISABLE_WARNINGS
+#include <loguru.hpp>
+RIGEL_RESTORE_WARNINGS
+
+#include <cassert>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
 #include <sstream>
 
 
@@ -32,46 +46,185 @@ namespace rigel
 namespace
 {
 
-template <typename... Args>
-std::unique_ptr<game_logic::IGameWorld>
-  createGameWorld(const data::GameplayStyle gameplayStyle, Args&&... args)
+constexpr auto TICK_PROFILER_TRACE_FILE = "tick_profile.json";
+
+
+void printRendererStatistics(
+  std::ostream& stream,
+  const renderer::FrameStatistics& stats)
 {
-  if (gameplayStyle == data::GameplayStyle::Classic)
+  stream << "Draw calls: " << stats.mDrawCalls
+         << ", batches: " << stats.mBatches
+         << "\nState changes: " << stats.mStateChanges
+         << ", RT switches: " << stats.mRenderTargetSwitches
+         << "\nAvoided GL calls: " << stats.mAvoidedGlCalls
+         << "\nVertices: " << stats.mVertices
+         << ", texture binds: " << stats.mTextureBinds
+         << "\nVertex upload: " << stats.mUploadedVertexBytes / 1024 << " KiB"
+         << ", texture upload: " << stats.mUploadedTextureBytes / 1024
+         << " KiB"
+         << "\nGPU time: ";
+
+  if (stats.mGpuTimeMs)
   {
-    return std::make_unique<game_logic::GameWorld_Classic>(
-      std::forward<Args>(args)...);
+    stream << std::fixed << std::setprecision(2) << *stats.mGpuTimeMs
+           << " ms\n";
   }
   else
   {
-    return std::make_unique<game_logic::GameWorld>(std::forward<Args>(args)...);
+    stream << "n/a\n";
   }
 }
 
+std::filesystem::path nextInputRecordingPath(
+  const std::string& directory,
+  const data::GameSessionId& sessionId)
+{
+  static auto recordingNumber = 0;
+  ++recordingNumber;
+
+  const auto fileName = std::string{char('L' + sessionId.mEpisode)} +
+    std::to_string(sessionId.mLevel + 1) + "_" +
+    std::to_string(recordingNumber) + ".inputs";
+  return std::filesystem::u8path(directory) / fileName;
+}
+
+
+GameMode::Context withServiceProvider(
+  GameMode::Context context,
+  IGameServiceProvider* pServiceProvider)
+{
+  context.mpServiceProvider = pServiceProvider;
+  return context;
+}
+
 } // namespace
 
 
+std::unique_ptr<game_logic::IGameWorld> createGameWorld(
+  const data::GameplayStyle gameplayStyle,
+  data::PersistentPlayerState* pPersistentPlayerState,
+  const data::GameSessionId& sessionId,
+  GameMode::Context context,
+  const std::optional<base::Vec2> playerPositionOverride,
+  const bool showWelcomeMessage,
+  std::optional<data::map::LevelData> preloadedLevel)
+{
+  if (gameplayStyle == data::GameplayStyle::Classic)
+  {
+    return std::make_unique<game_logic::GameWorld_Classic>(
+      pPersistentPlayerState,
+      sessionId,
+      context,
+      playerPositionOverride,
+      showWelcomeMessage,
+      game_logic::PlayerInput{},
+      std::move(preloadedLevel));
+  }
+  else
+  {
+    return std::make_unique<game_logic::GameWorld>(
+      pPersistentPlayerState,
+      sessionId,
+      context,
+      playerPositionOverride,
+      showWelcomeMessage,
+      game_logic::PlayerInput{},
+      std::move(preloadedLevel));
+  }
+}
+
+
 GameRunner::GameRunner(
   data::PersistentPlayerState* pPersistentPlayerState,
   const data::GameSessionId& sessionId,
   GameMode::Context context,
   const std::optional<base::Vec2> playerPositionOverride,
-  const bool showWelcomeMessage)
-  : mContext(context)
+  const bool showWelcomeMessage,
+  std::optional<data::map::LevelData> preloadedLevel)
+  : mServiceProvider(context.mpServiceProvider)
+  , mContext(withServiceProvider(context, &mServiceProvider))
   , mpWorld(createGameWorld(
       context.mpUserProfile->mOptions.mGameplayStyle,
       pPersistentPlayerState,
       sessionId,
-      context,
+      mContext,
       playerPositionOverride,
-      showWelcomeMessage))
+      showWelcomeMessage,
+      std::move(preloadedLevel)))
   , mInputHandler(&context.mpUserProfile->mOptions)
-  , mMenu(context, pPersistentPlayerState, mpWorld.get(), sessionId)
+  , mMenu(mContext, pPersistentPlayerState, mpWorld.get(), sessionId)
 {
+  const auto& commandLineOptions =
+    context.mpServiceProvider->commandLineOptions();
+  if (commandLineOptions.mPipelinedGameLogic)
+  {
+    // Spawning actors which weren't prefetched for the level creates GPU
+    // textures when sprites are loaded on demand, which can't happen on
+    // the update thread.
+    if (context.mpSpriteFactory->loadsImagesOnDemand())
+    {
+      LOG_F(
+        INFO,
+        "Pipelined game logic not available with on-demand sprite loading");
+    }
+    else if (!mpWorld->supportsPipelinedUpdates())
+    {
+      LOG_F(INFO, "Pipelined game logic not available for this game world");
+    }
+    else
+    {
+      mUpdateWorker.emplace();
+    }
+  }
+
+  // Applying queued input needs access to SDL's event queue, which is only
+  // possible on the main thread
+  mApplyQueuedInput = commandLineOptions.mLowLatencyInput && !mUpdateWorker;
+
+  const auto& recordingDirectory = commandLineOptions.mInputRecordingDirectory;
+  if (recordingDirectory)
+  {
+    mInputRecordingPath =
+      nextInputRecordingPath(*recordingDirectory, sessionId);
+    mInputRecording = startInputRecording(
+      sessionId,
+      context.mpUserProfile->mOptions.mGameplayStyle,
+      *pPersistentPlayerState,
+      playerPositionOverride,
+      showWelcomeMessage);
+  }
+}
+
+
+GameRunner::~GameRunner()
+{
+  finishPendingUpdate();
+
+  if (!mInputRecording)
+  {
+    return;
+  }
+
+  try
+  {
+    saveInputRecording(*mInputRecording, mInputRecordingPath);
+    LOG_F(
+      INFO,
+      "Saved input recording: %s",
+      mInputRecordingPath.u8string().c_str());
+  }
+  catch (const std::exception& ex)
+  {
+    LOG_F(ERROR, "Failed to save input recording: %s", ex.what());
+  }
 }
 
 
 void GameRunner::handleEvent(const SDL_Event& event)
 {
+  finishPendingUpdate();
+
   if (gameQuit() || requestedGameToLoad())
   {
     return;
@@ -113,6 +266,11 @@ void GameRunner::handleEvent(const SDL_Event& event)
 
 void GameRunner::updateAndRender(engine::TimeDelta dt)
 {
+  finishPendingUpdate();
+
+  // All of this frame's events have been delivered at this point
+  mInputHandler.clearQueuedInputState();
+
   if (gameQuit() || levelFinished() || requestedGameToLoad())
   {
     // TODO: This is a workaround to make the fadeout on quitting work.
@@ -126,6 +284,23 @@ void GameRunner::updateAndRender(engine::TimeDelta dt)
     return;
   }
 
+  if (mUpdateWorker)
+  {
+    // Pipelined mode: Render the result of the previous frame's updates,
+    // then start the updates for the next frame.
+    mpWorld->render(interpolationFactor(dt));
+
+    renderDebugText();
+    mpWorld->processEndOfFrameActions();
+
+    if (!gameQuit() && !levelFinished() && !requestedGameToLoad())
+    {
+      startWorldUpdate(dt);
+    }
+
+    return;
+  }
+
   updateWorld(dt);
   mpWorld->render(interpolationFactor(dt));
 
@@ -136,7 +311,8 @@ void GameRunner::updateAndRender(engine::TimeDelta dt)
 
 bool GameRunner::needsPerElementUpscaling() const
 {
-  return mpWorld->needsPerElementUpscaling();
+  return isUpdatePending() ? mNeedsPerElementUpscaling
+                           : mpWorld->needsPerElementUpscaling();
 }
 
 
@@ -148,10 +324,65 @@ float GameRunner::interpolationFactor(const engine::TimeDelta dt) const
 }
 
 
+void GameRunner::startWorldUpdate(const engine::TimeDelta dt)
+{
+  // While the update is running, nothing else may touch the world. The
+  // queries which GameSessionMode makes right after updateAndRender() are
+  // answered from the state before the update: No update is started when
+  // any of levelFinished(), gameQuit() or requestedGameToLoad() would
+  // return true, and needsPerElementUpscaling() is cached here.
+  mNeedsPerElementUpscaling = mpWorld->needsPerElementUpscaling();
+  mHasPendingUpdate = true;
+
+  mServiceProvider.beginDeferring();
+  mUpdateWorker->submit([this, dt]() { updateWorld(dt); });
+}
+
+
+void GameRunner::finishPendingUpdate()
+{
+  if (!mHasPendingUpdate)
+  {
+    return;
+  }
+
+  RIGEL_TRACE_ZONE("GameRunner::finishPendingUpdate");
+
+  mUpdateWorker->waitUntilIdle();
+  mHasPendingUpdate = false;
+  mServiceProvider.endDeferring();
+}
+
+
 void GameRunner::updateWorld(const engine::TimeDelta dt)
 {
+  RIGEL_TRACE_ZONE("GameRunner::updateWorld");
+
   auto update = [this]() {
-    mpWorld->updateGameLogic(mInputHandler.fetchInput());
+    if (mApplyQueuedInput)
+    {
+      mInputHandler.applyQueuedInput(mpWorld->isPlayerInShip());
+    }
+
+    const auto input = mInputHandler.fetchInput();
+    if (mInputRecording)
+    {
+      mInputRecording->mInputs.push_back(input);
+    }
+
+    const auto startOfUpdate = base::Clock::now();
+    RIGEL_PROFILE_CALL("Game logic (total)", mpWorld->updateGameLogic(input));
+    base::TickProfiler::instance().endTick();
+    const auto updateTime = std::chrono::duration<engine::TimeDelta>(
+                              base::Clock::now() - startOfUpdate)
+                              .count();
+    mContext.mpServiceProvider->reportGameLogicTime(updateTime);
+    updateEffectsDetail(updateTime);
+
+    if (mInputRecording)
+    {
+      mInputRecording->mStateHashes.push_back(mpWorld->stateHash());
+    }
   };
 
 
@@ -169,16 +400,52 @@ void GameRunner::updateWorld(const engine::TimeDelta dt)
 
     // Unusually long delta time - most likely, the game was paused in the
     // debugger, or something else happened (computer put to sleep?)
-    // Ignore this delta time.
-    if (mAccumulatedTime > 0.25)
+    // Skip the missed time instead of trying to catch up.
+    if (mAccumulatedTime > mTickCatchUpPolicy.mMaxAccumulatedTime)
     {
+      LOG_F(
+        INFO,
+        "Skipping %.0f ms of game time after stall",
+        mAccumulatedTime * 1000.0);
       mAccumulatedTime = 0.0;
     }
 
-    if (mAccumulatedTime >= game_logic::GAME_LOGIC_UPDATE_DELAY)
+    auto updatesRun = 0;
+    while (mAccumulatedTime >= game_logic::GAME_LOGIC_UPDATE_DELAY &&
+           updatesRun < mTickCatchUpPolicy.mMaxUpdatesPerFrame)
     {
+      // Only the last update's output will be rendered
+      const auto isLastUpdate =
+        mAccumulatedTime - game_logic::GAME_LOGIC_UPDATE_DELAY <
+          game_logic::GAME_LOGIC_UPDATE_DELAY ||
+        updatesRun + 1 == mTickCatchUpPolicy.mMaxUpdatesPerFrame;
+      mpWorld->setDrawOutputWanted(isLastUpdate);
+
       update();
       mAccumulatedTime -= game_logic::GAME_LOGIC_UPDATE_DELAY;
+      ++updatesRun;
+    }
+
+    mpWorld->setDrawOutputWanted(true);
+
+    // Still behind after running the maximum number of updates. Drop the
+    // backlog so that it can't keep growing from frame to frame, keeping
+    // only the fraction of an update needed for interpolation.
+    const auto isFallingBehind =
+      mAccumulatedTime >= game_logic::GAME_LOGIC_UPDATE_DELAY;
+    if (isFallingBehind)
+    {
+      mAccumulatedTime =
+        std::fmod(mAccumulatedTime, game_logic::GAME_LOGIC_UPDATE_DELAY);
+    }
+
+    if (isFallingBehind != mIsFallingBehind)
+    {
+      LOG_F(
+        INFO,
+        isFallingBehind ? "Game logic can't keep up, slowing down game time"
+                        : "Game logic caught up, game time back to normal");
+      mIsFallingBehind = isFallingBehind;
     }
 
     mpWorld->updateBackdropAutoScrolling(dt);
@@ -186,6 +453,36 @@ void GameRunner::updateWorld(const engine::TimeDelta dt)
 }
 
 
+void GameRunner::updateEffectsDetail(const engine::TimeDelta updateTime)
+{
+  using game_logic::EffectsDetail;
+  using game_logic::TickBudgetController;
+
+  if (!mContext.mpUserProfile->mOptions.mReduceEffectsUnderLoad)
+  {
+    if (mTickBudget.detail() != EffectsDetail::Full)
+    {
+      mTickBudget.reset();
+      mpWorld->setEffectsDetail(EffectsDetail::Full);
+    }
+
+    return;
+  }
+
+  const auto detailChanged = mTickBudget.update(
+    static_cast<float>(updateTime * 1000.0),
+    TickBudgetController::DEFAULT_BUDGET_MS);
+  if (detailChanged)
+  {
+    LOG_F(
+      INFO,
+      "Game logic update time changed, effects detail now at level %d",
+      static_cast<int>(mTickBudget.detail()));
+    mpWorld->setEffectsDetail(mTickBudget.detail());
+  }
+}
+
+
 bool GameRunner::updateMenu(const engine::TimeDelta dt)
 {
   if (mMenu.isActive())
@@ -238,6 +535,21 @@ void GameRunner::handleDebugKeys(const SDL_Event& event)
       mpWorld->debugToggleGridDisplay();
       break;
 
+    case SDLK_m:
+      {
+        std::stringstream memoryUsage;
+        base::printMemoryUsage(memoryUsage);
+        LOG_F(INFO, "%s", memoryUsage.str().c_str());
+      }
+      break;
+
+    case SDLK_p:
+      {
+        auto& profiler = base::TickProfiler::instance();
+        profiler.setEnabled(!profiler.isEnabled());
+      }
+      break;
+
     case SDLK_s:
       mSingleStepping = !mSingleStepping;
       break;
@@ -256,6 +568,11 @@ void GameRunner::handleDebugKeys(const SDL_Event& event)
     case SDLK_F11:
       mLevelFinishedByDebugKey = true;
       break;
+
+    case SDLK_F12:
+      writeTickProfilerTrace();
+      writeTimelineTrace();
+      break;
   }
 }
 
@@ -272,14 +589,62 @@ void GameRunner::renderDebugText()
   if (mShowDebugText)
   {
     mpWorld->printDebugText(debugText);
+    printRendererStatistics(
+      debugText, mContext.mpRenderer->lastFrameStatistics());
+    base::printMemoryUsage(debugText);
+  }
+
+  if (base::TickProfiler::instance().isEnabled())
+  {
+    base::TickProfiler::instance().printSummary(debugText);
   }
 
   ui::drawText(debugText.str(), 0, 32, {255, 255, 255, 255});
 }
 
 
+void GameRunner::writeTickProfilerTrace()
+{
+  const auto path = std::filesystem::u8path(TICK_PROFILER_TRACE_FILE);
+
+  try
+  {
+    base::TickProfiler::instance().writeTrace(path);
+    LOG_F(INFO, "Saved tick profiler trace: %s", path.u8string().c_str());
+  }
+  catch (const std::exception& ex)
+  {
+    LOG_F(ERROR, "Failed to save tick profiler trace: %s", ex.what());
+  }
+}
+
+
+void GameRunner::writeTimelineTrace()
+{
+  if (!base::tracing::isEnabled())
+  {
+    return;
+  }
+
+  try
+  {
+    base::tracing::writeTrace();
+    LOG_F(INFO, "Saved timeline trace");
+  }
+  catch (const std::exception& ex)
+  {
+    LOG_F(ERROR, "Failed to save timeline trace: %s", ex.what());
+  }
+}
+
+
 bool GameRunner::levelFinished() const
 {
+  if (isUpdatePending())
+  {
+    return false;
+  }
+
   return mpWorld->levelFinished() || mLevelFinishedByDebugKey;
 }
 
@@ -298,6 +663,9 @@ std::optional<data::SavedGame> GameRunner::requestedGameToLoad() const
 
 std::set<data::Bonus> GameRunner::achievedBonuses() const
 {
+  // Only meaningful once the level is finished, and no updates are started
+  // after that
+  assert(!isUpdatePending());
   return mpWorld->achievedBonuses();
 }
 
@@ -18,10 +18,14 @@
 
 #include "base/spatial_types.hpp"
 #include "base/warnings.hpp"
+#include "base/worker_thread.hpp"
 #include "data/bonus.hpp"
+#include "data/map.hpp"
 #include "data/saved_game.hpp"
+#include "frontend/deferred_service_provider.hpp"
 #include "frontend/game_mode.hpp"
 #include "frontend/input_handler.hpp"
+#include "frontend/input_recording.hpp"
 #include "game_logic_common/igame_world.hpp"
 #include "game_logic_common/input.hpp"
 #include "ui/ingame_menu.hpp"
@@ -30,12 +34,62 @@ RIGEL_DISABLE_WARNINGS
 #include <SDL.h>
 RIGEL_RESTORE_WARNINGS
 
+#include <filesystem>
 #include <memory>
+#include <optional>
 
 
 namespace rigel
 {
 
+/** Create the game world implementation for the given gameplay style
+ *
+ * If preloadedLevel is given, it must hold the level data for sessionId. It
+ * is then used instead of loading the level from disk.
+ */
+std::unique_ptr<game_logic::IGameWorld> createGameWorld(
+  data::GameplayStyle gameplayStyle,
+  data::PersistentPlayerState* pPersistentPlayerState,
+  const data::GameSessionId& sessionId,
+  GameMode::Context context,
+  std::optional<base::Vec2> playerPositionOverride = std::nullopt,
+  bool showWelcomeMessage = false,
+  std::optional<data::map::LevelData> preloadedLevel = std::nullopt);
+
+
+/** Controls how GameRunner catches up after slow frames
+ *
+ * Game logic runs at a fixed rate, independent of the frame rate. When a
+ * frame takes longer than one logic update, the missed updates are made up
+ * for in the following frames, but at most mMaxUpdatesPerFrame at a time so
+ * that a single slow frame doesn't cause an even slower one. If the game
+ * still can't keep up, any remaining backlog is dropped, i.e. game time runs
+ * slower than real time until the frame rate recovers. After a stall
+ * exceeding mMaxAccumulatedTime (e.g. the game was paused in the debugger),
+ * all missed time is skipped instead of being caught up on.
+ */
+struct TickCatchUpPolicy
+{
+  int mMaxUpdatesPerFrame = 2;
+  engine::TimeDelta mMaxAccumulatedTime = 0.25;
+};
+
+
+/** Runs a level: game logic, rendering, in-game menu and debug features
+ *
+ * With the --pipelined-logic command line option, game logic updates run on
+ * a worker thread. After rendering the current state of the world, the logic
+ * updates for the next frame are started, and run in parallel to presenting
+ * the frame and processing the next frame's events. Before GameRunner
+ * touches the world again, it waits for the updates to complete. This adds
+ * one frame of latency. Requests made by the game logic during an update
+ * (sounds, music) are held back and forwarded on the main thread afterwards.
+ *
+ * With --low-latency-input, keyboard and controller events which arrived
+ * since the start of the frame are applied right before each logic update,
+ * instead of being picked up by the next frame (see
+ * InputHandler::applyQueuedInput()).
+ */
 class GameRunner
 {
 public:
@@ -44,7 +98,9 @@ public:
     const data::GameSessionId& sessionId,
     GameMode::Context context,
     std::optional<base::Vec2> playerPositionOverride = std::nullopt,
-    bool showWelcomeMessage = false);
+    bool showWelcomeMessage = false,
+    std::optional<data::map::LevelData> preloadedLevel = std::nullopt);
+  ~GameRunner();
 
   void handleEvent(const SDL_Event& event);
   void updateAndRender(engine::TimeDelta dt);
@@ -56,23 +112,51 @@ public:
 
   std::set<data::Bonus> achievedBonuses() const;
 
+  bool isMenuActive() const { return mMenu.isActive(); }
+
+  void setTickCatchUpPolicy(const TickCatchUpPolicy& policy)
+  {
+    mTickCatchUpPolicy = policy;
+  }
+
 private:
   float interpolationFactor(engine::TimeDelta dt) const;
+  bool isUpdatePending() const { return mHasPendingUpdate; }
+  void startWorldUpdate(engine::TimeDelta dt);
+  void finishPendingUpdate();
   void updateWorld(engine::TimeDelta dt);
+  void updateEffectsDetail(engine::TimeDelta updateTime);
   bool updateMenu(engine::TimeDelta dt);
   void handleDebugKeys(const SDL_Event& event);
   void renderDebugText();
+  void writeTickProfilerTrace();
+  void writeTimelineTrace();
 
+  DeferredServiceProvider mServiceProvider;
   GameMode::Context mContext;
 
   std::unique_ptr<game_logic::IGameWorld> mpWorld;
   InputHandler mInputHandler;
   engine::TimeDelta mAccumulatedTime = 0.0;
+  TickCatchUpPolicy mTickCatchUpPolicy;
+  bool mIsFallingBehind = false;
+  game_logic::TickBudgetController mTickBudget;
   ui::IngameMenu mMenu;
   bool mShowDebugText = false;
   bool mSingleStepping = false;
   bool mDoNextSingleStep = false;
   bool mLevelFinishedByDebugKey = false;
+  bool mApplyQueuedInput = false;
+
+  std::optional<InputRecording> mInputRecording;
+  std::filesystem::path mInputRecordingPath;
+
+  bool mHasPendingUpdate = false;
+  bool mNeedsPerElementUpscaling = false;
+
+  // Only set in pipelined mode. Declared last so that any pending update
+  // completes before the other members are destroyed.
+  std::optional<base::WorkerThread> mUpdateWorker;
 };
 
 } // namespace rigel
@@ -18,6 +18,7 @@
 
 #include "data/game_session_data.hpp"
 #include "data/sound_ids.hpp"
+#include "engine/timing.hpp"
 #include "frontend/command_line_options.hpp"
 #include "sdl_utils/ptr.hpp"
 
@@ -62,8 +63,10 @@ struct IGameServiceProvider
 {
   virtual ~IGameServiceProvider() = default;
 
-  // Blocking calls
+  // Blocking call
   virtual void fadeOutScreen() = 0;
+
+  // Starts a fade-in, which then progresses over the following frames
   virtual void fadeInScreen() = 0;
 
   // Non-blocking calls
@@ -71,13 +74,55 @@ struct IGameServiceProvider
   virtual void stopSound(data::SoundId id) = 0;
   virtual void stopAllSounds() = 0;
   virtual void playMusic(const std::string& name) = 0;
+  virtual void prefetchMusic(const std::string& name) = 0;
   virtual void stopMusic() = 0;
   virtual void scheduleGameQuit() = 0;
   virtual void switchGamePath(const std::filesystem::path& newGamePath) = 0;
   virtual void markCurrentFrameAsWidescreen() = 0;
+
+  // Adds to the time spent on game logic during the current frame, for the
+  // frame time statistics shown by the FPS display
+  virtual void reportGameLogicTime(engine::TimeDelta time) = 0;
+
   virtual bool isSharewareVersion() const = 0;
   virtual const CommandLineOptions& commandLineOptions() const = 0;
   virtual const GameControllerInfo& gameControllerInfo() const = 0;
 };
 
+
+/** Service provider which ignores all requests
+ *
+ * For running game logic without any audio or windowing, e.g. in headless
+ * simulations.
+ */
+struct NullGameServiceProvider : public IGameServiceProvider
+{
+  void fadeOutScreen() override { }
+  void fadeInScreen() override { }
+  void playSound(data::SoundId) override { }
+  void stopSound(data::SoundId) override { }
+  void stopAllSounds() override { }
+  void playMusic(const std::string&) override { }
+  void prefetchMusic(const std::string&) override { }
+  void stopMusic() override { }
+  void scheduleGameQuit() override { }
+  void switchGamePath(const std::filesystem::path&) override { }
+  void markCurrentFrameAsWidescreen() override { }
+  void reportGameLogicTime(engine::TimeDelta) override { }
+  bool isSharewareVersion() const override { return false; }
+
+  const CommandLineOptions& commandLineOptions() const override
+  {
+    return mCommandLineOptions;
+  }
+
+  const GameControllerInfo& gameControllerInfo() const override
+  {
+    return mGameControllerInfo;
+  }
+
+  CommandLineOptions mCommandLineOptions;
+  GameControllerInfo mGameControllerInfo;
+};
+
 } // namespace rigel
@@ -19,13 +19,18 @@
 // TODO: Remove this cyclic include
 #include "menu_mode.hpp"
 
+#include "assets/level_loader.hpp"
+#include "assets/resource_loader.hpp"
 #include "base/match.hpp"
+#include "base/parallel.hpp"
 #include "data/saved_game.hpp"
 #include "frontend/game_service_provider.hpp"
 #include "frontend/user_profile.hpp"
 #include "ui/high_score_list.hpp"
 #include "ui/menu_navigation.hpp"
 
+#include <chrono>
+
 
 namespace rigel
 {
@@ -33,13 +38,15 @@ namespace rigel
 GameSessionMode::GameSessionMode(
   const data::GameSessionId& sessionId,
   Context context,
-  std::optional<base::Vec2> playerPositionOverride)
+  std::optional<base::Vec2> playerPositionOverride,
+  std::optional<data::map::LevelData> preloadedLevel)
   : mCurrentStage(std::make_unique<GameRunner>(
       &mPersistentPlayerState,
       sessionId,
       context,
       playerPositionOverride,
-      true /* show welcome message */))
+      true /* show welcome message */,
+      std::move(preloadedLevel)))
   , mEpisode(sessionId.mEpisode)
   , mCurrentLevelNr(sessionId.mLevel)
   , mDifficulty(sessionId.mDifficulty)
@@ -67,14 +74,16 @@ GameSessionMode::GameSessionMode(const data::SavedGame& save, Context context)
 GameSessionMode::GameSessionMode(
   const data::GameSessionId& sessionId,
   data::PersistentPlayerState persistentPlayerState,
-  Context context)
+  Context context,
+  std::optional<data::map::LevelData> preloadedLevel)
   : mPersistentPlayerState(std::move(persistentPlayerState))
   , mCurrentStage(std::make_unique<GameRunner>(
       &mPersistentPlayerState,
       sessionId,
       context,
       std::nullopt,
-      false /* don't show welcome message */))
+      false /* don't show welcome message */,
+      std::move(preloadedLevel)))
   , mEpisode(sessionId.mEpisode)
   , mCurrentLevelNr(sessionId.mLevel)
   , mDifficulty(sessionId.mDifficulty)
@@ -168,6 +177,8 @@ std::unique_ptr<GameMode> GameSessionMode::updateAndRender(
         }
         else
         {
+          startPreloadingNextLevel();
+
           mContext.mpServiceProvider->playMusic("OPNGATEA.IMF");
 
           auto bonusScreen =
@@ -182,6 +193,14 @@ std::unique_ptr<GameMode> GameSessionMode::updateAndRender(
     },
 
     [this, &dt](ui::BonusScreen& bonusScreen) -> GameModePtr {
+      if (
+        mNextLevelData.valid() &&
+        mNextLevelData.wait_for(std::chrono::seconds{0}) ==
+          std::future_status::ready)
+      {
+        takePreloadedLevel();
+      }
+
       bonusScreen.updateAndRender(dt);
 
       if (bonusScreen.finished())
@@ -201,10 +220,16 @@ std::unique_ptr<GameMode> GameSessionMode::updateAndRender(
         // else that wouldn't be massively more complicated.
         //
         // We can't use make_unique here, because the constructor is private.
+        if (mNextLevelData.valid())
+        {
+          takePreloadedLevel();
+        }
+
         return std::unique_ptr<GameSessionMode>{new GameSessionMode{
           data::GameSessionId{mEpisode, ++mCurrentLevelNr, mDifficulty},
           mPersistentPlayerState,
-          mContext}};
+          mContext,
+          std::move(mPreloadedLevel)}};
       }
 
       return nullptr;
@@ -254,6 +279,20 @@ bool GameSessionMode::needsPerElementUpscaling() const
 }
 
 
+bool GameSessionMode::showsStaticContent() const
+{
+  return base::match(
+    mCurrentStage,
+    [](const std::unique_ptr<GameRunner>& pIngameMode) {
+      return pIngameMode->isMenuActive();
+    },
+
+    [](const HighScoreNameEntry&) { return true; },
+    [](const HighScoreListDisplay&) { return true; },
+    [](auto&&) { return false; });
+}
+
+
 template <typename StageT>
 void GameSessionMode::fadeToNewStage(StageT& stage)
 {
@@ -263,6 +302,32 @@ void GameSessionMode::fadeToNewStage(StageT& stage)
 }
 
 
+void GameSessionMode::startPreloadingNextLevel()
+{
+  // Parsing the level file and decoding its tileset and backdrop images takes
+  // a noticeable amount of time. We do it on a worker thread while the bonus
+  // screen is shown, so that entering the next level doesn't stall after the
+  // fade-out. Only the pure data loading happens here, everything touching
+  // the renderer is still done on the main thread when the level starts.
+  mNextLevelData = base::runAsync(
+    [pResources = mContext.mpResources,
+     fileName = assets::levelFileName(mEpisode, mCurrentLevelNr + 1),
+     difficulty = mDifficulty]() {
+      return assets::loadLevel(fileName, *pResources, difficulty);
+    });
+}
+
+
+void GameSessionMode::takePreloadedLevel()
+{
+  mPreloadedLevel = mNextLevelData.get();
+
+  // Now that we know which song the level uses, we can also start loading
+  // its replacement music file (if any) in the background.
+  mContext.mpServiceProvider->prefetchMusic(mPreloadedLevel->mMusicFile);
+}
+
+
 void GameSessionMode::finishGameSession()
 {
   mContext.mpServiceProvider->stopMusic();
@@ -16,6 +16,7 @@
 
 #pragma once
 
+#include "data/map.hpp"
 #include "data/player_model.hpp"
 #include "frontend/game_mode.hpp"
 #include "ui/bonus_screen.hpp"
@@ -23,6 +24,7 @@
 
 #include "game_runner.hpp"
 
+#include <future>
 #include <variant>
 
 namespace rigel::data
@@ -40,7 +42,8 @@ public:
   GameSessionMode(
     const data::GameSessionId& sessionId,
     Context context,
-    std::optional<base::Vec2> playerPositionOverride = std::nullopt);
+    std::optional<base::Vec2> playerPositionOverride = std::nullopt,
+    std::optional<data::map::LevelData> preloadedLevel = std::nullopt);
 
   GameSessionMode(const data::SavedGame& save, Context context);
 
@@ -49,16 +52,20 @@ public:
     const std::vector<SDL_Event>& events) override;
 
   bool needsPerElementUpscaling() const override;
+  bool showsStaticContent() const override;
 
 private:
   GameSessionMode(
     const data::GameSessionId& sessionId,
     data::PersistentPlayerState persistentPlayerState,
-    Context context);
+    Context context,
+    std::optional<data::map::LevelData> preloadedLevel);
 
   void handleEvent(const SDL_Event& event);
   template <typename StageT>
   void fadeToNewStage(StageT& stage);
+  void startPreloadingNextLevel();
+  void takePreloadedLevel();
   void finishGameSession();
   void enterHighScore(std::string_view name);
 
@@ -81,6 +88,8 @@ private:
 
   data::PersistentPlayerState mPersistentPlayerState;
   SessionStage mCurrentStage;
+  std::future<data::map::LevelData> mNextLevelData;
+  std::optional<data::map::LevelData> mPreloadedLevel;
   const int mEpisode;
   int mCurrentLevelNr;
   const data::Difficulty mDifficulty;
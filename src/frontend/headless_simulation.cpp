@@ -0,0 +1,95 @@
+/* Copyright (C) 2022, Nikolai Wuttke. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "headless_simulation.hpp"
+
+#include "data/game_traits.hpp"
+#include "frontend/game_mode.hpp"
+#include "frontend/game_runner.hpp"
+#include "game_logic_common/igame_world.hpp"
+
+
+namespace rigel
+{
+
+HeadlessSimulation::HeadlessSimulation(
+  const assets::ResourceLoader* pResources,
+  renderer::Renderer* pRenderer)
+  : mHeadlessRenderer(data::GameTraits::viewportSize)
+  , mpRenderer(pRenderer ? pRenderer : &mHeadlessRenderer)
+  , mpResources(pResources)
+  , mSpriteFactory(mpRenderer, pResources)
+{
+}
+
+
+HeadlessSimulation::HeadlessSimulation(
+  const assets::ResourceLoader* pResources,
+  const data::GameSessionId& sessionId,
+  const data::PersistentPlayerState& playerState,
+  const data::GameplayStyle gameplayStyle)
+  : HeadlessSimulation(pResources, nullptr)
+{
+  mPlayerState = playerState;
+  mUserProfile.mOptions.mGameplayStyle = gameplayStyle;
+  mpWorld = createGameWorld(gameplayStyle, &mPlayerState, sessionId, context());
+  mpWorld->setDrawOutputWanted(false);
+}
+
+
+HeadlessSimulation::HeadlessSimulation(
+  const assets::ResourceLoader* pResources,
+  const InputRecording& recording)
+  : HeadlessSimulation(pResources, recording, nullptr)
+{
+}
+
+
+HeadlessSimulation::HeadlessSimulation(
+  const assets::ResourceLoader* pResources,
+  const InputRecording& recording,
+  renderer::Renderer* pRenderer)
+  : HeadlessSimulation(pResources, pRenderer)
+{
+  mUserProfile.mOptions.mGameplayStyle = recording.mGameplayStyle;
+  mpWorld = createGameWorldForReplay(recording, &mPlayerState, context());
+  mpWorld->setDrawOutputWanted(pRenderer != nullptr);
+}
+
+
+HeadlessSimulation::~HeadlessSimulation() = default;
+
+
+void HeadlessSimulation::update(const game_logic::PlayerInput& input)
+{
+  mpWorld->updateGameLogic(input);
+  mpWorld->processEndOfFrameActions();
+  ++mUpdatesRun;
+}
+
+
+GameMode::Context HeadlessSimulation::context()
+{
+  auto context = GameMode::Context{};
+  context.mpResources = mpResources;
+  context.mpRenderer = mpRenderer;
+  context.mpServiceProvider = &mServiceProvider;
+  context.mpSpriteFactory = &mSpriteFactory;
+  context.mpUserProfile = &mUserProfile;
+  return context;
+}
+
+} // namespace rigel
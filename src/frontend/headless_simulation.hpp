@@ -0,0 +1,110 @@
+/* Copyright (C) 2022, Nikolai Wuttke. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "data/game_options.hpp"
+#include "data/game_session_data.hpp"
+#include "data/player_model.hpp"
+#include "engine/sprite_factory.hpp"
+#include "frontend/game_service_provider.hpp"
+#include "frontend/input_recording.hpp"
+#include "frontend/user_profile.hpp"
+#include "game_logic_common/input.hpp"
+#include "renderer/renderer.hpp"
+
+#include <memory>
+
+
+namespace rigel::assets
+{
+class ResourceLoader;
+}
+
+namespace rigel::game_logic
+{
+struct IGameWorld;
+}
+
+
+namespace rigel
+{
+
+/** Runs a game world without a window, GL context or audio
+ *
+ * Uses a headless Renderer and a NullGameServiceProvider, so that levels
+ * can be simulated as fast as the game logic allows, driven by synthetic
+ * or recorded input. Nothing is rendered, unless a renderer is given on
+ * construction. Meant for regression testing and batch simulations.
+ */
+class HeadlessSimulation
+{
+public:
+  HeadlessSimulation(
+    const assets::ResourceLoader* pResources,
+    const data::GameSessionId& sessionId,
+    const data::PersistentPlayerState& playerState = {},
+    data::GameplayStyle gameplayStyle = data::GameplayStyle::Enhanced);
+
+  /** Set up the world for replaying the given recording
+   *
+   * Use replayInputs() with world() to run it.
+   */
+  HeadlessSimulation(
+    const assets::ResourceLoader* pResources,
+    const InputRecording& recording);
+
+  /** Like above, but with rendering enabled
+   *
+   * world().render() draws into the given renderer, which must have been
+   * created for a window (e.g. platform::OffscreenGlContext).
+   */
+  HeadlessSimulation(
+    const assets::ResourceLoader* pResources,
+    const InputRecording& recording,
+    renderer::Renderer* pRenderer);
+  ~HeadlessSimulation();
+
+  /** Advance the simulation by a single game logic update */
+  void update(const game_logic::PlayerInput& input);
+
+  game_logic::IGameWorld& world() { return *mpWorld; }
+  const data::PersistentPlayerState& playerState() const
+  {
+    return mPlayerState;
+  }
+
+  int updatesRun() const { return mUpdatesRun; }
+
+private:
+  HeadlessSimulation(
+    const assets::ResourceLoader* pResources,
+    renderer::Renderer* pRenderer);
+
+  GameMode::Context context();
+
+  renderer::Renderer mHeadlessRenderer;
+  renderer::Renderer* mpRenderer;
+  const assets::ResourceLoader* mpResources;
+  NullGameServiceProvider mServiceProvider;
+  UserProfile mUserProfile;
+  engine::SpriteFactory mSpriteFactory;
+  data::PersistentPlayerState mPlayerState;
+  std::unique_ptr<game_logic::IGameWorld> mpWorld;
+  int mUpdatesRun = 0;
+};
+
+} // namespace rigel
@@ -19,6 +19,8 @@
 #include "data/game_options.hpp"
 #include "sdl_utils/key_code.hpp"
 
+#include <cstring>
+
 
 namespace rigel
 {
@@ -59,6 +61,82 @@ InputHandler::InputHandler(const data::GameOptions* pOptions)
 
 auto InputHandler::handleEvent(const SDL_Event& event, const bool playerInShip)
   -> MenuCommand
+{
+  if (wasAppliedAhead(event))
+  {
+    return MenuCommand::None;
+  }
+
+  return processEvent(event, playerInShip);
+}
+
+
+void InputHandler::reset()
+{
+  mPlayerInput = {};
+  clearQueuedInputState();
+}
+
+
+void InputHandler::applyQueuedInput(const bool playerInShip)
+{
+  SDL_PumpEvents();
+
+  std::array<SDL_Event, MAX_QUEUED_EVENTS> events;
+  const auto numEvents = SDL_PeepEvents(
+    events.data(),
+    MAX_QUEUED_EVENTS,
+    SDL_PEEKEVENT,
+    SDL_KEYDOWN,
+    SDL_CONTROLLERBUTTONUP);
+
+  // Pumping only appends to the queue, so the events seen by previous calls
+  // during this frame are still at the front.
+  for (auto i = mNumQueuedEvents; i < numEvents; ++i)
+  {
+    // Events which trigger a menu command don't change the input state, and
+    // are handled regularly once delivered.
+    const auto applied =
+      processEvent(events[i], playerInShip) == MenuCommand::None;
+    mQueuedEvents[mNumQueuedEvents++] = {events[i], applied};
+  }
+}
+
+
+void InputHandler::clearQueuedInputState()
+{
+  mNumQueuedEvents = 0;
+  miNextQueuedEvent = 0;
+}
+
+
+bool InputHandler::wasAppliedAhead(const SDL_Event& event)
+{
+  // Events arrive in queue order, so anything older than the given event
+  // was consumed elsewhere (e.g. by the in-game menu) and won't arrive.
+  while (
+    miNextQueuedEvent < mNumQueuedEvents &&
+    mQueuedEvents[miNextQueuedEvent].mEvent.common.timestamp <
+      event.common.timestamp)
+  {
+    ++miNextQueuedEvent;
+  }
+
+  if (
+    miNextQueuedEvent < mNumQueuedEvents &&
+    std::memcmp(
+      &mQueuedEvents[miNextQueuedEvent].mEvent, &event, sizeof(SDL_Event)) ==
+      0)
+  {
+    return mQueuedEvents[miNextQueuedEvent++].mApplied;
+  }
+
+  return false;
+}
+
+
+auto InputHandler::processEvent(const SDL_Event& event, const bool playerInShip)
+  -> MenuCommand
 {
   const auto isKeyEvent = event.type == SDL_KEYDOWN || event.type == SDL_KEYUP;
 
@@ -73,12 +151,6 @@ auto InputHandler::handleEvent(const SDL_Event& event, const bool playerInShip)
 }
 
 
-void InputHandler::reset()
-{
-  mPlayerInput = {};
-}
-
-
 game_logic::PlayerInput InputHandler::fetchInput()
 {
   const auto input = combinedInput(mPlayerInput, mAnalogStickVector);
@@ -24,6 +24,7 @@ RIGEL_DISABLE_WARNINGS
 #include <SDL.h>
 RIGEL_RESTORE_WARNINGS
 
+#include <array>
 #include <vector>
 
 
@@ -51,9 +52,33 @@ public:
   MenuCommand handleEvent(const SDL_Event& event, bool playerInShip);
   void reset();
 
+  /** Apply input events which are waiting in SDL's event queue
+   *
+   * Pumps SDL's event queue and applies the keyboard and controller events
+   * found there, without removing them from the queue. This makes input
+   * which arrived after the start of the current frame visible to the next
+   * game logic update, instead of only to the next frame's updates. Once
+   * these events arrive via handleEvent(), they are skipped.
+   *
+   * Must be called on the main thread. clearQueuedInputState() needs to be
+   * called once per frame, after the frame's events have been delivered.
+   */
+  void applyQueuedInput(bool playerInShip);
+  void clearQueuedInputState();
+
   game_logic::PlayerInput fetchInput();
 
 private:
+  struct QueuedEvent
+  {
+    SDL_Event mEvent;
+    bool mApplied;
+  };
+
+  static constexpr auto MAX_QUEUED_EVENTS = 64;
+
+  MenuCommand processEvent(const SDL_Event& event, bool playerInShip);
+  bool wasAppliedAhead(const SDL_Event& event);
   MenuCommand handleKeyboardInput(const SDL_Event& event);
   MenuCommand handleControllerInput(const SDL_Event& event, bool playerInShip);
 
@@ -61,6 +86,11 @@ private:
   base::Vec2 mAnalogStickVector;
   const data::GameOptions* mpOptions;
   bool mQuickSaveModifierHeld = false;
+
+  // Events seen in SDL's queue by applyQueuedInput(), in queue order
+  std::array<QueuedEvent, MAX_QUEUED_EVENTS> mQueuedEvents;
+  int mNumQueuedEvents = 0;
+  int miNextQueuedEvent = 0;
 };
 
 } // namespace rigel
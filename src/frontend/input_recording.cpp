@@ -0,0 +1,353 @@
+/* Copyright (C) 2022, Nikolai Wuttke. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "input_recording.hpp"
+
+#include "assets/file_utils.hpp"
+#include "base/clock.hpp"
+#include "frontend/game_runner.hpp"
+#include "game_logic_common/igame_world.hpp"
+
+#include <cassert>
+#include <stdexcept>
+
+
+namespace rigel
+{
+
+namespace
+{
+
+// "RGIR" - Rigel input recording
+constexpr std::uint32_t RECORDING_MAGIC = 0x52494752;
+constexpr std::uint8_t RECORDING_VERSION = 1;
+
+constexpr std::uint8_t FLAG_SHOW_WELCOME_MESSAGE = 0b1;
+constexpr std::uint8_t FLAG_HAS_POSITION_OVERRIDE = 0b10;
+constexpr std::uint8_t FLAG_IS_DEMO = 0b100;
+constexpr std::uint8_t FLAG_HAS_STATE_HASHES = 0b1000;
+
+constexpr auto MAX_RUN_LENGTH = 0xFFFF;
+
+
+std::uint16_t packInput(const game_logic::PlayerInput& input)
+{
+  auto bit = [](const bool value, const int index) {
+    return std::uint16_t((value ? 1 : 0) << index);
+  };
+
+  // clang-format off
+  return
+    bit(input.mLeft, 0) |
+    bit(input.mRight, 1) |
+    bit(input.mUp, 2) |
+    bit(input.mDown, 3) |
+    bit(input.mInteract.mIsPressed, 4) |
+    bit(input.mInteract.mWasTriggered, 5) |
+    bit(input.mJump.mIsPressed, 6) |
+    bit(input.mJump.mWasTriggered, 7) |
+    bit(input.mFire.mIsPressed, 8) |
+    bit(input.mFire.mWasTriggered, 9);
+  // clang-format on
+}
+
+
+game_logic::PlayerInput unpackInput(const std::uint16_t bits)
+{
+  auto bit = [&](const int index) { return (bits & (1 << index)) != 0; };
+
+  game_logic::PlayerInput input;
+  input.mLeft = bit(0);
+  input.mRight = bit(1);
+  input.mUp = bit(2);
+  input.mDown = bit(3);
+  input.mInteract.mIsPressed = bit(4);
+  input.mInteract.mWasTriggered = bit(5);
+  input.mJump.mIsPressed = bit(6);
+  input.mJump.mWasTriggered = bit(7);
+  input.mFire.mIsPressed = bit(8);
+  input.mFire.mWasTriggered = bit(9);
+  return input;
+}
+
+} // namespace
+
+
+InputRecording startInputRecording(
+  const data::GameSessionId& sessionId,
+  const data::GameplayStyle gameplayStyle,
+  const data::PersistentPlayerState& playerState,
+  const std::optional<base::Vec2> playerPositionOverride,
+  const bool showWelcomeMessage)
+{
+  auto recording = InputRecording{};
+  recording.mSessionId = sessionId;
+  recording.mGameplayStyle = gameplayStyle;
+  recording.mPlayerState = data::SavedGame{
+    sessionId,
+    playerState.tutorialMessages(),
+    {},
+    playerState.weapon(),
+    playerState.ammo(),
+    playerState.score()};
+  recording.mPlayerPositionOverride = playerPositionOverride;
+  recording.mShowWelcomeMessage = showWelcomeMessage;
+  return recording;
+}
+
+
+void saveInputRecording(
+  const InputRecording& recording,
+  const std::filesystem::path& path)
+{
+  assets::LeStreamWriter writer;
+
+  writer.writeU32(RECORDING_MAGIC);
+  writer.writeU8(RECORDING_VERSION);
+
+  const auto& sessionId = recording.mSessionId;
+  writer.writeU8(std::uint8_t(sessionId.mEpisode));
+  writer.writeU8(std::uint8_t(sessionId.mLevel));
+  writer.writeU8(std::uint8_t(sessionId.mDifficulty));
+  writer.writeU8(std::uint8_t(recording.mGameplayStyle));
+
+  auto flags = std::uint8_t{0};
+  if (recording.mShowWelcomeMessage)
+  {
+    flags |= FLAG_SHOW_WELCOME_MESSAGE;
+  }
+  if (recording.mPlayerPositionOverride)
+  {
+    flags |= FLAG_HAS_POSITION_OVERRIDE;
+  }
+  if (sessionId.mIsDemo)
+  {
+    flags |= FLAG_IS_DEMO;
+  }
+  if (!recording.mStateHashes.empty())
+  {
+    assert(recording.mStateHashes.size() == recording.mInputs.size());
+    flags |= FLAG_HAS_STATE_HASHES;
+  }
+  writer.writeU8(flags);
+
+  if (const auto& position = recording.mPlayerPositionOverride)
+  {
+    writer.writeU16(std::uint16_t(position->x));
+    writer.writeU16(std::uint16_t(position->y));
+  }
+
+  const auto& playerState = recording.mPlayerState;
+  writer.writeU8(std::uint8_t(playerState.mWeapon));
+  writer.writeU16(std::uint16_t(playerState.mAmmo));
+  writer.writeU32(std::uint32_t(playerState.mScore));
+  for (auto i = 0; i < data::NUM_TUTORIAL_MESSAGES; ++i)
+  {
+    const auto id = static_cast<data::TutorialMessageId>(i);
+    writer.writeU8(
+      playerState.mTutorialMessagesAlreadySeen.hasBeenShown(id) ? 1 : 0);
+  }
+
+  // Inputs are stored as a sequence of (packed input, repeat count) pairs
+  std::vector<std::pair<std::uint16_t, std::uint16_t>> runs;
+  for (const auto& input : recording.mInputs)
+  {
+    const auto packed = packInput(input);
+    if (
+      !runs.empty() && runs.back().first == packed &&
+      runs.back().second < MAX_RUN_LENGTH)
+    {
+      ++runs.back().second;
+    }
+    else
+    {
+      runs.emplace_back(packed, std::uint16_t{1});
+    }
+  }
+
+  writer.writeU32(std::uint32_t(runs.size()));
+  for (const auto& [packed, count] : runs)
+  {
+    writer.writeU16(packed);
+    writer.writeU16(count);
+  }
+
+  for (const auto& hash : recording.mStateHashes)
+  {
+    writer.writeU32(hash.mPlayer);
+    writer.writeU32(hash.mActors);
+    writer.writeU32(hash.mMap);
+    writer.writeU32(hash.mGlobals);
+  }
+
+  assets::saveToFile(writer.buffer(), path);
+}
+
+
+InputRecording loadInputRecording(const std::filesystem::path& path)
+{
+  const auto data = assets::loadFile(path);
+  assets::LeStreamReader reader(data);
+
+  if (reader.readU32() != RECORDING_MAGIC)
+  {
+    throw std::runtime_error("Not an input recording file");
+  }
+
+  if (reader.readU8() != RECORDING_VERSION)
+  {
+    throw std::runtime_error("Unsupported input recording version");
+  }
+
+  auto recording = InputRecording{};
+
+  auto& sessionId = recording.mSessionId;
+  sessionId.mEpisode = reader.readU8();
+  sessionId.mLevel = reader.readU8();
+  sessionId.mDifficulty = static_cast<data::Difficulty>(reader.readU8());
+  recording.mGameplayStyle =
+    static_cast<data::GameplayStyle>(reader.readU8());
+
+  const auto flags = reader.readU8();
+  sessionId.mIsDemo = (flags & FLAG_IS_DEMO) != 0;
+  recording.mShowWelcomeMessage = (flags & FLAG_SHOW_WELCOME_MESSAGE) != 0;
+
+  if (flags & FLAG_HAS_POSITION_OVERRIDE)
+  {
+    const auto x = reader.readU16();
+    const auto y = reader.readU16();
+    recording.mPlayerPositionOverride = base::Vec2{x, y};
+  }
+
+  auto& playerState = recording.mPlayerState;
+  playerState.mSessionId = sessionId;
+  playerState.mWeapon = static_cast<data::WeaponType>(reader.readU8());
+  playerState.mAmmo = reader.readU16();
+  playerState.mScore = int(reader.readU32());
+  for (auto i = 0; i < data::NUM_TUTORIAL_MESSAGES; ++i)
+  {
+    if (reader.readU8() != 0)
+    {
+      playerState.mTutorialMessagesAlreadySeen.markAsShown(
+        static_cast<data::TutorialMessageId>(i));
+    }
+  }
+
+  const auto numRuns = reader.readU32();
+  for (auto i = 0u; i < numRuns; ++i)
+  {
+    const auto input = unpackInput(reader.readU16());
+    const auto count = reader.readU16();
+    recording.mInputs.insert(recording.mInputs.end(), count, input);
+  }
+
+  if (flags & FLAG_HAS_STATE_HASHES)
+  {
+    recording.mStateHashes.reserve(recording.mInputs.size());
+    for (auto i = 0u; i < recording.mInputs.size(); ++i)
+    {
+      auto hash = game_logic::StateHash{};
+      hash.mPlayer = reader.readU32();
+      hash.mActors = reader.readU32();
+      hash.mMap = reader.readU32();
+      hash.mGlobals = reader.readU32();
+      recording.mStateHashes.push_back(hash);
+    }
+  }
+
+  return recording;
+}
+
+
+std::unique_ptr<game_logic::IGameWorld> createGameWorldForReplay(
+  const InputRecording& recording,
+  data::PersistentPlayerState* pPlayerState,
+  GameMode::Context context)
+{
+  *pPlayerState = data::PersistentPlayerState{recording.mPlayerState};
+
+  return createGameWorld(
+    recording.mGameplayStyle,
+    pPlayerState,
+    recording.mSessionId,
+    context,
+    recording.mPlayerPositionOverride,
+    recording.mShowWelcomeMessage);
+}
+
+
+ReplayResult replayInputs(
+  const InputRecording& recording,
+  game_logic::IGameWorld& world,
+  const bool measureUpdateTimes,
+  const std::function<void(int)>& afterUpdate)
+{
+  using namespace std::chrono;
+
+  auto result = ReplayResult{};
+  const auto verifyState = !recording.mStateHashes.empty();
+
+  if (measureUpdateTimes)
+  {
+    result.mUpdateTimesMs.reserve(recording.mInputs.size());
+  }
+
+  for (const auto& input : recording.mInputs)
+  {
+    if (world.levelFinished())
+    {
+      break;
+    }
+
+    const auto startTime = base::Clock::now();
+    world.updateGameLogic(input);
+
+    if (measureUpdateTimes)
+    {
+      result.mUpdateTimesMs.push_back(
+        duration<double, std::milli>(base::Clock::now() - startTime).count());
+    }
+
+    const auto updateIndex = result.mUpdatesRun++;
+
+    // Hashes are recorded right after updating, see GameRunner
+    if (verifyState)
+    {
+      const auto& expected = recording.mStateHashes[updateIndex];
+      const auto actual = world.stateHash();
+
+      if (actual != expected)
+      {
+        result.mFirstMismatchingUpdate = updateIndex;
+        result.mMismatchReport = "State diverged in update " +
+          std::to_string(updateIndex) + ":\n" +
+          game_logic::describeStateHashDifferences(expected, actual);
+        break;
+      }
+    }
+
+    if (afterUpdate)
+    {
+      afterUpdate(updateIndex);
+    }
+
+    world.processEndOfFrameActions();
+  }
+
+  return result;
+}
+
+} // namespace rigel
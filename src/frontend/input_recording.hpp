@@ -0,0 +1,141 @@
+/* Copyright (C) 2022, Nikolai Wuttke. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "base/spatial_types.hpp"
+#include "data/game_options.hpp"
+#include "data/game_session_data.hpp"
+#include "data/saved_game.hpp"
+#include "frontend/game_mode.hpp"
+#include "game_logic_common/input.hpp"
+#include "game_logic_common/state_hash.hpp"
+
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+
+namespace rigel::game_logic
+{
+struct IGameWorld;
+}
+
+
+namespace rigel
+{
+
+/** Everything needed to deterministically replay a single level
+ *
+ * Both game world implementations only use table-based random number
+ * generators that always start from the same state, so no RNG seed needs
+ * to be stored. Replaying is only accurate if the player didn't use
+ * quick save/load, saved games or cheats while recording.
+ */
+struct InputRecording
+{
+  data::GameSessionId mSessionId;
+  data::GameplayStyle mGameplayStyle = data::GameplayStyle::Enhanced;
+
+  /** Player state at level start. The name is not stored */
+  data::SavedGame mPlayerState;
+  std::optional<base::Vec2> mPlayerPositionOverride;
+  bool mShowWelcomeMessage = false;
+
+  /** Input for each game logic update, in order */
+  std::vector<game_logic::PlayerInput> mInputs;
+
+  /** State after each game logic update
+   *
+   * Either empty, or one entry per input. Used for detecting divergence
+   * during replay.
+   */
+  std::vector<game_logic::StateHash> mStateHashes;
+};
+
+
+struct ReplayResult
+{
+  int mUpdatesRun = 0;
+
+  /** Index of the first update whose resulting state differed from the
+   * recorded state hash, if any. The replay stops there.
+   */
+  std::optional<int> mFirstMismatchingUpdate;
+  std::string mMismatchReport;
+
+  /** Duration of each update in milliseconds, if requested
+   *
+   * Only covers running the game logic, not verifying the state.
+   */
+  std::vector<double> mUpdateTimesMs;
+};
+
+
+InputRecording startInputRecording(
+  const data::GameSessionId& sessionId,
+  data::GameplayStyle gameplayStyle,
+  const data::PersistentPlayerState& playerState,
+  std::optional<base::Vec2> playerPositionOverride,
+  bool showWelcomeMessage);
+
+
+/** Write recording to disk
+ *
+ * Identical consecutive inputs are run-length encoded, so typical
+ * recordings only need a few bytes per second of gameplay.
+ */
+void saveInputRecording(
+  const InputRecording& recording,
+  const std::filesystem::path& path);
+
+/** Load recording from disk
+ *
+ * Throws an exception if the file can't be read or is invalid.
+ */
+InputRecording loadInputRecording(const std::filesystem::path& path);
+
+
+/** Create a game world in the same state as when the recording started
+ *
+ * pPlayerState is initialized from the recording.
+ */
+std::unique_ptr<game_logic::IGameWorld> createGameWorldForReplay(
+  const InputRecording& recording,
+  data::PersistentPlayerState* pPlayerState,
+  GameMode::Context context);
+
+/** Feed all recorded inputs into the given world
+ *
+ * Stops early if the level is finished. If the recording contains state
+ * hashes, the world's state is verified after each update, and the replay
+ * stops at the first mismatch. With measureUpdateTimes set, the duration of
+ * each update is stored in the result.
+ *
+ * If given, afterUpdate is invoked with the update's index after each
+ * update, at the point where the game would render a frame, i.e. before
+ * processing end-of-frame actions.
+ */
+ReplayResult replayInputs(
+  const InputRecording& recording,
+  game_logic::IGameWorld& world,
+  bool measureUpdateTimes = false,
+  const std::function<void(int)>& afterUpdate = {});
+
+} // namespace rigel
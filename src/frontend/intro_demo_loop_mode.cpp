@@ -21,6 +21,7 @@
 #include "assets/resource_loader.hpp"
 #include "base/match.hpp"
 #include "frontend/game_service_provider.hpp"
+#include "frontend/script_bundle_cache.hpp"
 #include "ui/duke_script_runner.hpp"
 #include "ui/menu_navigation.hpp"
 
@@ -184,7 +185,6 @@ void IntroDemoLoopMode::startCurrentStep()
     },
 
     [&](game_logic::DemoPlayer& state) {
-      state = game_logic::DemoPlayer{mContext};
       mContext.mpServiceProvider->fadeOutScreen();
       state.updateAndRender(0.0);
       mContext.mpServiceProvider->fadeInScreen();
@@ -232,6 +232,16 @@ bool IntroDemoLoopMode::isCurrentStepFinished() const
 
 void IntroDemoLoopMode::advanceToNextStep()
 {
+  // Replace a finished demo right away instead of when it's shown again, so
+  // that the new demo player can preload its first level while the other
+  // steps are running.
+  if (
+    auto pDemoPlayer =
+      std::get_if<game_logic::DemoPlayer>(&mSteps[mCurrentStep]))
+  {
+    *pDemoPlayer = game_logic::DemoPlayer{mContext};
+  }
+
   const auto isOneTimeStep =
     std::holds_alternative<Story>(mSteps[mCurrentStep]) ||
     std::holds_alternative<HypeScreen>(mSteps[mCurrentStep]);
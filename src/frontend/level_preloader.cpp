@@ -0,0 +1,105 @@
+/* Copyright (C) 2022, Nikolai Wuttke. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "level_preloader.hpp"
+
+#include "assets/level_loader.hpp"
+#include "assets/resource_loader.hpp"
+#include "base/parallel.hpp"
+
+#include <loguru.hpp>
+
+#include <algorithm>
+#include <stdexcept>
+
+
+namespace rigel
+{
+
+namespace
+{
+
+bool isSameLevel(const data::GameSessionId& a, const data::GameSessionId& b)
+{
+  return a.mEpisode == b.mEpisode && a.mLevel == b.mLevel &&
+    a.mDifficulty == b.mDifficulty;
+}
+
+} // namespace
+
+
+LevelPreloader::LevelPreloader(const assets::ResourceLoader* pResources)
+  : mpResources(pResources)
+{
+}
+
+
+void LevelPreloader::preload(const data::GameSessionId& sessionId)
+{
+  const auto alreadyPending = std::any_of(
+    mPendingLevels.begin(),
+    mPendingLevels.end(),
+    [&](const PendingLevel& level) {
+      return isSameLevel(level.mSessionId, sessionId);
+    });
+
+  if (alreadyPending)
+  {
+    return;
+  }
+
+  mPendingLevels.push_back(
+    {sessionId,
+     base::runAsync(
+       [pResources = mpResources,
+        fileName =
+          assets::levelFileName(sessionId.mEpisode, sessionId.mLevel),
+        difficulty = sessionId.mDifficulty]() {
+         return assets::loadLevel(fileName, *pResources, difficulty);
+       })});
+}
+
+
+std::optional<data::map::LevelData>
+  LevelPreloader::take(const data::GameSessionId& sessionId)
+{
+  const auto iLevel = std::find_if(
+    mPendingLevels.begin(),
+    mPendingLevels.end(),
+    [&](const PendingLevel& level) {
+      return isSameLevel(level.mSessionId, sessionId);
+    });
+
+  if (iLevel == mPendingLevels.end())
+  {
+    return std::nullopt;
+  }
+
+  auto levelData = std::move(iLevel->mLevelData);
+  mPendingLevels.erase(iLevel);
+
+  try
+  {
+    return levelData.get();
+  }
+  catch (const std::exception& ex)
+  {
+    LOG_F(WARNING, "Preloading level failed: %s", ex.what());
+    return std::nullopt;
+  }
+}
+
+} // namespace rigel
@@ -0,0 +1,77 @@
+/* Copyright (C) 2022, Nikolai Wuttke. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "data/game_session_data.hpp"
+#include "data/map.hpp"
+
+#include <future>
+#include <optional>
+#include <vector>
+
+
+namespace rigel::assets
+{
+class ResourceLoader;
+}
+
+
+namespace rigel
+{
+
+/** Loads level data in the background, ahead of time
+ *
+ * Parsing a level file and decoding its tileset and backdrop images takes
+ * a noticeable amount of time. Modes which know that a certain level is
+ * likely to be started soon ask for it to be preloaded, and then pass the
+ * result on to the GameWorld they create. Only the pure data loading
+ * happens in the background, everything touching the renderer still
+ * happens when the level starts.
+ *
+ * Multiple levels can be preloading at the same time. Levels which are
+ * never taken are discarded when the preloader is destroyed, which waits
+ * for any loading still in progress.
+ */
+class LevelPreloader
+{
+public:
+  explicit LevelPreloader(const assets::ResourceLoader* pResources);
+
+  /** Start loading the given level, unless it's already being loaded */
+  void preload(const data::GameSessionId& sessionId);
+
+  /** Returns the given level's data, if it has been preloaded
+   *
+   * Waits for loading to finish if needed. Returns nothing when the level
+   * wasn't requested via preload(), or if loading failed - the caller then
+   * loads the level the regular way.
+   */
+  std::optional<data::map::LevelData>
+    take(const data::GameSessionId& sessionId);
+
+private:
+  struct PendingLevel
+  {
+    data::GameSessionId mSessionId;
+    std::future<data::map::LevelData> mLevelData;
+  };
+
+  const assets::ResourceLoader* mpResources;
+  std::vector<PendingLevel> mPendingLevels;
+};
+
+} // namespace rigel
@@ -22,6 +22,7 @@
 #include "assets/resource_loader.hpp"
 #include "data/game_session_data.hpp"
 #include "frontend/game_service_provider.hpp"
+#include "frontend/script_bundle_cache.hpp"
 #include "frontend/user_profile.hpp"
 #include "ui/high_score_list.hpp"
 #include "ui/menu_navigation.hpp"
@@ -56,6 +57,7 @@ bool abortedByUser(const DukeScriptRunner::ExecutionResult& result)
 
 MenuMode::MenuMode(Context context)
   : mContext(context)
+  , mLevelPreloader(context.mpResources)
 {
   mContext.mpServiceProvider->playMusic("DUKEIIA.IMF");
   runScript(mContext, "Main_Menu");
@@ -250,6 +252,14 @@ std::unique_ptr<GameMode> MenuMode::navigateToNextMenu(
         {
           mChosenEpisode = chosenEpisode;
 
+          // The first level's data differs per difficulty, so we preload all
+          // variants while the player is choosing one.
+          for (const auto difficulty : DIFFICULTY_MAPPING)
+          {
+            mLevelPreloader.preload(
+              data::GameSessionId{mChosenEpisode, 0, difficulty});
+          }
+
           runScript(mContext, "Skill_Select");
           mMenuState = MenuState::SelectNewGameSkill;
         }
@@ -271,10 +281,13 @@ std::unique_ptr<GameMode> MenuMode::navigateToNextMenu(
           throw std::invalid_argument("Invalid skill index");
         }
 
+        const auto sessionId = data::GameSessionId{
+          mChosenEpisode, 0, DIFFICULTY_MAPPING[chosenSkill]};
         return std::make_unique<GameSessionMode>(
-          data::GameSessionId{
-            mChosenEpisode, 0, DIFFICULTY_MAPPING[chosenSkill]},
-          mContext);
+          sessionId,
+          mContext,
+          std::nullopt,
+          mLevelPreloader.take(sessionId));
       }
       break;
 
@@ -19,6 +19,7 @@
 #include "assets/duke_script_loader.hpp"
 #include "data/duke_script.hpp"
 #include "frontend/game_mode.hpp"
+#include "frontend/level_preloader.hpp"
 #include "ui/duke_script_runner.hpp"
 #include "ui/options_menu.hpp"
 
@@ -37,6 +38,8 @@ public:
     engine::TimeDelta dt,
     const std::vector<SDL_Event>& events) override;
 
+  bool showsStaticContent() const override { return true; }
+
 private:
   enum class MenuState
   {
@@ -65,6 +68,7 @@ private:
 private:
   Context mContext;
   std::optional<ui::OptionsMenu> mOptionsMenu;
+  LevelPreloader mLevelPreloader;
   MenuState mMenuState = MenuState::MainMenu;
   int mChosenEpisode = 0;
 };
@@ -0,0 +1,138 @@
+/* Copyright (C) 2022, Nikolai Wuttke. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "script_bundle_cache.hpp"
+
+#include "assets/asset_cache.hpp"
+#include "assets/resource_loader.hpp"
+#include "base/parallel.hpp"
+#include "base/startup_timings.hpp"
+#include "base/warnings.hpp"
+
+RIGEL_DISABLE_WARNINGS
+#include <loguru.hpp>
+RIGEL_RESTORE_WARNINGS
+
+#include <stdexcept>
+
+
+namespace rigel
+{
+
+namespace
+{
+
+assets::ScriptBundle loadBundle(
+  const assets::ResourceLoader* pResources,
+  const assets::AssetCache* pAssetCache,
+  const char* fileName)
+{
+  const auto phase = base::startup_timings::ScopedPhase{"Script loading"};
+
+  const auto cacheEntryName = std::string{"duke_scripts_"} + fileName;
+
+  if (pAssetCache)
+  {
+    if (const auto entry = pAssetCache->load(cacheEntryName))
+    {
+      try
+      {
+        return assets::loadCompiledScripts(entry->data());
+      }
+      catch (const std::exception& ex)
+      {
+        LOG_F(WARNING, "Ignoring invalid script cache entry: %s", ex.what());
+      }
+    }
+  }
+
+  auto scripts = pResources->loadScriptBundle(fileName);
+
+  if (pAssetCache)
+  {
+    pAssetCache->store(cacheEntryName, assets::compileScripts(scripts));
+  }
+
+  return scripts;
+}
+
+} // namespace
+
+
+ScriptBundleCache::ScriptBundleCache(
+  const assets::ResourceLoader* pResources,
+  const assets::AssetCache* pAssetCache)
+  : mpResources(pResources)
+  , mpAssetCache(pAssetCache)
+  // In order of precedence, in case a script name appears in multiple files
+  , mBundles{
+      {Bundle{"TEXT.MNI"}, Bundle{"OPTIONS.MNI"}, Bundle{"ORDERTXT.MNI"}}}
+{
+}
+
+
+void ScriptBundleCache::prefetch()
+{
+  for (auto& bundle : mBundles)
+  {
+    if (!bundle.mScripts && !bundle.mPendingScripts.valid())
+    {
+      bundle.mPendingScripts = base::runAsync(
+        [pResources = mpResources,
+         pAssetCache = mpAssetCache,
+         fileName = bundle.mFileName]() {
+          return loadBundle(pResources, pAssetCache, fileName);
+        });
+    }
+  }
+}
+
+
+const data::script::Script& ScriptBundleCache::at(const std::string& name)
+{
+  for (auto& bundle : mBundles)
+  {
+    const auto& bundleScripts = scripts(bundle);
+
+    if (const auto iScript = bundleScripts.find(name);
+        iScript != bundleScripts.end())
+    {
+      return iScript->second;
+    }
+  }
+
+  throw std::out_of_range("No such script: " + name);
+}
+
+
+const assets::ScriptBundle& ScriptBundleCache::scripts(Bundle& bundle)
+{
+  if (!bundle.mScripts)
+  {
+    if (bundle.mPendingScripts.valid())
+    {
+      bundle.mScripts = bundle.mPendingScripts.get();
+    }
+    else
+    {
+      bundle.mScripts = loadBundle(mpResources, mpAssetCache, bundle.mFileName);
+    }
+  }
+
+  return *bundle.mScripts;
+}
+
+} // namespace rigel
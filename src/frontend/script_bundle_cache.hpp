@@ -0,0 +1,83 @@
+/* Copyright (C) 2022, Nikolai Wuttke. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "assets/duke_script_loader.hpp"
+
+#include <array>
+#include <future>
+#include <optional>
+#include <string>
+
+
+namespace rigel::assets
+{
+class AssetCache;
+class ResourceLoader;
+} // namespace rigel::assets
+
+
+namespace rigel
+{
+
+/** Provides access to the game's Duke Script files, loading them on demand
+ *
+ * The scripts are spread over multiple files. Looking up a script searches
+ * these files in order of precedence, and each file is only loaded once a
+ * lookup reaches it. prefetch() starts loading all files in the background,
+ * so that later lookups don't need to wait for parsing.
+ *
+ * Loaded files are kept in the asset cache in compiled form (see
+ * assets::compileScripts()), to avoid parsing them again on the next launch.
+ */
+class ScriptBundleCache
+{
+public:
+  ScriptBundleCache(
+    const assets::ResourceLoader* pResources,
+    const assets::AssetCache* pAssetCache);
+
+  /** Start loading all files which aren't loaded yet in the background */
+  void prefetch();
+
+  /** Find script with the given name
+   *
+   * Throws std::out_of_range if there's no script with that name.
+   */
+  const data::script::Script& at(const std::string& name);
+
+private:
+  struct Bundle
+  {
+    explicit Bundle(const char* fileName)
+      : mFileName(fileName)
+    {
+    }
+
+    const char* mFileName;
+    std::optional<assets::ScriptBundle> mScripts;
+    std::future<assets::ScriptBundle> mPendingScripts;
+  };
+
+  const assets::ScriptBundle& scripts(Bundle& bundle);
+
+  const assets::ResourceLoader* mpResources;
+  const assets::AssetCache* mpAssetCache;
+  std::array<Bundle, 3> mBundles;
+};
+
+} // namespace rigel
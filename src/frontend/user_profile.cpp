@@ -19,7 +19,8 @@
 #include "assets/file_utils.hpp"
 #include "assets/user_profile_import.hpp"
 #include "base/warnings.hpp"
-#include "frontend/json_utils.hpp"
+#include "base/worker_thread.hpp"
+#include "frontend/binary_profile.hpp"
 
 RIGEL_DISABLE_WARNINGS
 #include <SDL_filesystem.h>
@@ -31,7 +32,11 @@ RIGEL_RESTORE_WARNINGS
 #include <array>
 #include <fstream>
 #include <iomanip>
+#include <memory>
+#include <mutex>
 #include <optional>
+#include <sstream>
+#include <string_view>
 #include <unordered_set>
 
 
@@ -151,6 +156,7 @@ namespace
 constexpr auto PREF_PATH_ORG_NAME = "lethal-guitar";
 constexpr auto PREF_PATH_APP_NAME = "Rigel Engine";
 constexpr auto USER_PROFILE_FILENAME_V1 = "UserProfile.rigel";
+constexpr auto USER_PROFILE_FILENAME_V2 = "UserProfile_v2.rigel";
 constexpr auto OPTIONS_FILENAME = "Options.json";
 constexpr auto MOD_LIBRARY_FILENAME = "ModLibrary.json";
 
@@ -377,18 +383,54 @@ nlohmann::json serialize(const data::HighScoreListArray& highScoreLists)
 }
 
 
+nlohmann::json serialize(const std::filesystem::file_time_type& time)
+{
+  return std::int64_t(time.time_since_epoch().count());
+}
+
+
+nlohmann::json serialize(const data::ModDirectoryIndex& index)
+{
+  using json = nlohmann::json;
+
+  auto serializedEntries = json::array();
+
+  for (const auto& entry : index.mEntries)
+  {
+    json serializedEntry;
+    serializedEntry["dirName"] = entry.mDirName;
+    serializedEntry["writeTime"] = serialize(entry.mWriteTime);
+    serializedEntries.push_back(serializedEntry);
+  }
+
+  json serialized;
+  serialized["modsPath"] = index.mModsPath.u8string();
+  serialized["writeTime"] = serialize(index.mWriteTime);
+  serialized["entries"] = serializedEntries;
+  return serialized;
+}
+
+
 nlohmann::json serialize(const data::ModLibrary& modLibrary)
 {
   using json = nlohmann::json;
 
-  auto serialized = json::array();
+  auto serializedMods = json::array();
 
   for (const auto& mod : modLibrary.currentSelection())
   {
     json serializedMod;
     serializedMod["dirName"] = modLibrary.modDirName(mod.mIndex);
     serializedMod["isEnabled"] = mod.mIsEnabled;
-    serialized.push_back(serializedMod);
+    serializedMods.push_back(serializedMod);
+  }
+
+  json serialized;
+  serialized["mods"] = serializedMods;
+
+  if (const auto& oIndex = modLibrary.directoryIndex())
+  {
+    serialized["directoryIndex"] = serialize(*oIndex);
   }
 
   return serialized;
@@ -414,12 +456,18 @@ nlohmann::ordered_json serialize(const data::GameOptions& options)
   serialized["enableFpsLimit"] = options.mEnableFpsLimit;
   serialized["maxFps"] = options.mMaxFps;
   serialized["showFpsCounter"] = options.mShowFpsCounter;
+  serialized["idlePowerSaving"] = options.mIdlePowerSaving;
   serialized["enableScreenFlashes"] = options.mEnableScreenFlashes;
   serialized["upscalingFilter"] = options.mUpscalingFilter;
   serialized["aspectRatioCorrectionEnabled"] =
     options.mAspectRatioCorrectionEnabled;
+  serialized["dynamicResolutionEnabled"] = options.mDynamicResolutionEnabled;
+  serialized["reduceEffectsUnderLoad"] = options.mReduceEffectsUnderLoad;
   serialized["soundStyle"] = options.mSoundStyle;
   serialized["adlibPlaybackType"] = options.mAdlibPlaybackType;
+  serialized["lowLatencyAudio"] = options.mLowLatencyAudio;
+  serialized["prerenderMusic"] = options.mPrerenderMusic;
+  serialized["showAudioStats"] = options.mShowAudioStats;
   serialized["musicVolume"] = options.mMusicVolume;
   serialized["soundVolume"] = options.mSoundVolume;
   serialized["musicOn"] = options.mMusicOn;
@@ -436,6 +484,7 @@ nlohmann::ordered_json serialize(const data::GameOptions& options)
   serialized["quickLoadKeybinding"] =
     SDL_GetKeyName(options.mQuickLoadKeybinding);
   serialized["topLevelModsEnabled"] = options.mEnableTopLevelMods;
+  serialized["maxReplacementScale"] = options.mMaxReplacementScale;
 
   serialized["gameplayStyle"] = options.mGameplayStyle;
 
@@ -560,14 +609,49 @@ data::HighScoreListArray
 }
 
 
+template <>
+std::filesystem::file_time_type
+  deserialize<std::filesystem::file_time_type>(const nlohmann::json& json)
+{
+  using Time = std::filesystem::file_time_type;
+  return Time{Time::duration{json.get<std::int64_t>()}};
+}
+
+
+template <>
+data::ModDirectoryIndex
+  deserialize<data::ModDirectoryIndex>(const nlohmann::json& json)
+{
+  namespace fs = std::filesystem;
+
+  auto index = data::ModDirectoryIndex{};
+  index.mModsPath = fs::u8path(json.at("modsPath").get<std::string>());
+  index.mWriteTime = deserialize<fs::file_time_type>(json.at("writeTime"));
+
+  for (const auto& serializedEntry : json.at("entries"))
+  {
+    index.mEntries.push_back(
+      {serializedEntry.at("dirName").get<std::string>(),
+       deserialize<fs::file_time_type>(serializedEntry.at("writeTime"))});
+  }
+
+  return index;
+}
+
+
 template <>
 data::ModLibrary deserialize<data::ModLibrary>(const nlohmann::json& json)
 {
   std::vector<std::string> modDirNames;
   std::vector<data::ModStatus> modSelection;
+  std::optional<data::ModDirectoryIndex> oDirectoryIndex;
+
+  // Older versions stored the list of mods as a top-level array, without
+  // a directory index.
+  const auto& serializedMods = json.is_array() ? json : json.at("mods");
 
   auto index = 0;
-  for (const auto& serializedEntry : json)
+  for (const auto& serializedEntry : serializedMods)
   {
     modDirNames.push_back(serializedEntry["dirName"].get<std::string>());
     modSelection.push_back({index, serializedEntry["isEnabled"].get<bool>()});
@@ -575,7 +659,17 @@ data::ModLibrary deserialize<data::ModLibrary>(const nlohmann::json& json)
     ++index;
   }
 
-  return data::ModLibrary{{}, std::move(modDirNames), std::move(modSelection)};
+  if (json.is_object() && json.contains("directoryIndex"))
+  {
+    oDirectoryIndex =
+      deserialize<data::ModDirectoryIndex>(json.at("directoryIndex"));
+  }
+
+  return data::ModLibrary{
+    {},
+    std::move(modDirNames),
+    std::move(modSelection),
+    std::move(oDirectoryIndex)};
 }
 
 
@@ -635,13 +729,21 @@ data::GameOptions deserialize<data::GameOptions>(const nlohmann::json& json)
   extractValueIfExists("enableFpsLimit", result.mEnableFpsLimit, json);
   extractValueIfExists("maxFps", result.mMaxFps, json);
   extractValueIfExists("showFpsCounter", result.mShowFpsCounter, json);
+  extractValueIfExists("idlePowerSaving", result.mIdlePowerSaving, json);
   extractValueIfExists(
     "enableScreenFlashes", result.mEnableScreenFlashes, json);
   extractValueIfExists("upscalingFilter", result.mUpscalingFilter, json);
   extractValueIfExists(
     "aspectRatioCorrectionEnabled", result.mAspectRatioCorrectionEnabled, json);
+  extractValueIfExists(
+    "dynamicResolutionEnabled", result.mDynamicResolutionEnabled, json);
+  extractValueIfExists(
+    "reduceEffectsUnderLoad", result.mReduceEffectsUnderLoad, json);
   extractValueIfExists("soundStyle", result.mSoundStyle, json);
   extractValueIfExists("adlibPlaybackType", result.mAdlibPlaybackType, json);
+  extractValueIfExists("lowLatencyAudio", result.mLowLatencyAudio, json);
+  extractValueIfExists("prerenderMusic", result.mPrerenderMusic, json);
+  extractValueIfExists("showAudioStats", result.mShowAudioStats, json);
   extractValueIfExists("musicVolume", result.mMusicVolume, json);
   extractValueIfExists("soundVolume", result.mSoundVolume, json);
   extractValueIfExists("musicOn", result.mMusicOn, json);
@@ -657,6 +759,8 @@ data::GameOptions deserialize<data::GameOptions>(const nlohmann::json& json)
   extractKeyBindingIfExists(
     "quickLoadKeybinding", result.mQuickLoadKeybinding, json);
   extractValueIfExists("topLevelModsEnabled", result.mEnableTopLevelMods, json);
+  extractValueIfExists(
+    "maxReplacementScale", result.mMaxReplacementScale, json);
   extractValueIfExists("gameplayStyle", result.mGameplayStyle, json);
   extractValueIfExists("widescreenModeOn", result.mWidescreenModeOn, json);
   extractValueIfExists("widescreenHudStyle", result.mWidescreenHudStyle, json);
@@ -701,62 +805,78 @@ void deserializeJsonFile(
 }
 
 
-UserProfile loadProfile(
-  const std::filesystem::path& fileOnDisk,
-  const std::filesystem::path& pathForSaving)
+void deserializeProgressData(
+  UserProfile& profile,
+  const nlohmann::json& serializedProfile)
 {
   namespace fs = std::filesystem;
 
-  try
+  profile.mSaveSlots =
+    deserialize<data::SaveSlotArray>(serializedProfile.at("saveSlots"));
+  profile.mHighScoreLists = deserialize<data::HighScoreListArray>(
+    serializedProfile.at("highScoreLists"));
+
+  // Older versions of RigelEngine stored options in the user profile
+  // file. When running a newer version for the first time, we want to
+  // import any settings from an earlier version.
+  if (serializedProfile.contains("options"))
   {
-    auto buffer = assets::loadFile(fileOnDisk);
-    const auto serializedProfile = nlohmann::json::from_msgpack(buffer);
+    profile.mOptions =
+      deserialize<data::GameOptions>(serializedProfile.at("options"));
+  }
 
-    UserProfile profile{pathForSaving, std::move(buffer)};
+  if (serializedProfile.contains("gamePath"))
+  {
+    const auto gamePathStr =
+      serializedProfile.at("gamePath").get<std::string>();
+    profile.mGamePath = fs::u8path(gamePathStr);
+  }
+}
 
-    profile.mSaveSlots =
-      deserialize<data::SaveSlotArray>(serializedProfile.at("saveSlots"));
-    profile.mHighScoreLists = deserialize<data::HighScoreListArray>(
-      serializedProfile.at("highScoreLists"));
 
-    // Older versions of RigelEngine stored options in the user profile
-    // file. When running a newer version for the first time, we want to
-    // import any settings from an earlier version.
-    if (serializedProfile.contains("options"))
-    {
-      profile.mOptions =
-        deserialize<data::GameOptions>(serializedProfile.at("options"));
-    }
+void loadOptionsFiles(
+  UserProfile& profile,
+  const std::filesystem::path& profileFile)
+{
+  namespace fs = std::filesystem;
+
+  auto optionsFile = profileFile;
+  optionsFile.replace_filename(OPTIONS_FILENAME);
+  deserializeJsonFile(optionsFile, [&](const nlohmann::json& serializedObject) {
+    profile.mOptions = deserialize<data::GameOptions>(serializedObject);
 
-    if (serializedProfile.contains("gamePath"))
+    if (serializedObject.contains("gamePath"))
     {
       const auto gamePathStr =
-        serializedProfile.at("gamePath").get<std::string>();
+        serializedObject.at("gamePath").get<std::string>();
       profile.mGamePath = fs::u8path(gamePathStr);
     }
+  });
 
-    {
-      auto optionsFile = fileOnDisk;
-      optionsFile.replace_filename(OPTIONS_FILENAME);
-      deserializeJsonFile(
-        optionsFile, [&](const nlohmann::json& serializedObject) {
-          profile.mOptions = deserialize<data::GameOptions>(serializedObject);
-
-          if (serializedObject.contains("gamePath"))
-          {
-            const auto gamePathStr =
-              serializedObject.at("gamePath").get<std::string>();
-            profile.mGamePath = fs::u8path(gamePathStr);
-          }
-        });
-
-      optionsFile.replace_filename(MOD_LIBRARY_FILENAME);
-      deserializeJsonFile(
-        optionsFile, [&](const nlohmann::json& serializedObject) {
-          profile.mModLibrary = deserialize<data::ModLibrary>(serializedObject);
-        });
-    }
+  optionsFile.replace_filename(MOD_LIBRARY_FILENAME);
+  deserializeJsonFile(optionsFile, [&](const nlohmann::json& serializedObject) {
+    profile.mModLibrary = deserialize<data::ModLibrary>(serializedObject);
+  });
+}
+
+
+/** Load a profile stored in the JSON based format used before version 3
+ *
+ * Such profiles are converted to the binary format the next time the
+ * profile is saved, which happens at pathForSaving.
+ */
+UserProfile loadJsonProfile(
+  const std::filesystem::path& fileOnDisk,
+  const std::filesystem::path& pathForSaving)
+{
+  try
+  {
+    const auto serializedProfile =
+      nlohmann::json::from_msgpack(assets::loadFile(fileOnDisk));
 
+    UserProfile profile{pathForSaving};
+    deserializeProgressData(profile, serializedProfile);
+    loadOptionsFiles(profile, fileOnDisk);
     return profile;
   }
   catch (const std::exception& ex)
@@ -768,89 +888,115 @@ UserProfile loadProfile(
 }
 
 
-UserProfile loadProfile(const std::filesystem::path& profileFile)
+UserProfile loadBinaryProfile(const std::filesystem::path& profileFile)
 {
-  return loadProfile(profileFile, profileFile);
-}
+  try
+  {
+    auto contents = decodeBinaryProfile(assets::loadFile(profileFile));
 
-} // namespace
+    UserProfile profile{profileFile, std::move(contents.mUnknownRecords)};
+    profile.mSaveSlots = std::move(contents.mSaveSlots);
+    profile.mHighScoreLists = std::move(contents.mHighScoreLists);
+    profile.mGamePath = std::move(contents.mGamePath);
+    loadOptionsFiles(profile, profileFile);
+    return profile;
+  }
+  catch (const std::exception& ex)
+  {
+    LOG_F(ERROR, "Failed to load user profile: %s", ex.what());
+  }
 
+  return UserProfile{profileFile};
+}
 
-UserProfile::UserProfile(
-  const std::filesystem::path& profilePath,
-  assets::ByteBuffer originalJson)
-  : mProfilePath(profilePath)
-  , mOriginalJson(std::move(originalJson))
+
+/** The parts of a user profile which are written to disk */
+struct ProfileSnapshot
 {
-}
+  std::filesystem::path mProfilePath;
+  data::SaveSlotArray mSaveSlots;
+  data::HighScoreListArray mHighScoreLists;
+  data::GameOptions mOptions;
+  data::ModLibrary mModLibrary;
+  std::optional<std::filesystem::path> mGamePath;
+};
 
 
-void UserProfile::saveToDisk()
+/** Replaces the file at the given path with the given data
+ *
+ * The data is first written to a temporary file next to the destination,
+ * which is then renamed. This way, the destination file is never left in
+ * a partially written state, even if the game crashes or the system loses
+ * power while saving.
+ */
+void saveToFileAtomically(
+  const std::string_view data,
+  const std::filesystem::path& filePath)
 {
-  if (!mProfilePath)
+  auto tempPath = filePath;
+  tempPath += ".tmp";
+
   {
-    LOG_F(WARNING, "Not saving user profile since no file path was set");
-    return;
+    auto file = std::ofstream(tempPath, std::ios::binary);
+    if (!file.is_open())
+    {
+      throw std::runtime_error(
+        "File can't be opened: " + tempPath.u8string());
+    }
+
+    file.exceptions(std::ios::failbit | std::ios::badbit);
+    file.write(data.data(), data.size());
   }
 
-  using json = nlohmann::json;
+  std::filesystem::rename(tempPath, filePath);
+}
 
-  json serializedProfile;
-  serializedProfile["saveSlots"] = serialize(mSaveSlots);
-  serializedProfile["highScoreLists"] = serialize(mHighScoreLists);
 
-  // Starting with RigelEngine v.0.7.0, the options are stored in a separate
-  // text file. For compatibility with older versions, the options are also
-  // redundantly stored in the user profile, as before. But this is deprecated,
-  // and will be removed in a later release at some point.
-  const auto options = serialize(mOptions);
-  serializedProfile["options"] = options;
+void saveToFileAtomically(
+  const std::vector<std::uint8_t>& buffer,
+  const std::filesystem::path& filePath)
+{
+  saveToFileAtomically(
+    std::string_view{
+      reinterpret_cast<const char*>(buffer.data()), buffer.size()},
+    filePath);
+}
+
 
-  if (mGamePath)
+template <typename Json>
+void saveJsonFile(
+  const char* description,
+  const Json& json,
+  const std::filesystem::path& filePath)
+{
+  LOG_F(INFO, "Saving %s", description);
+
+  try
   {
-    serializedProfile["gamePath"] = mGamePath->u8string();
+    auto stream = std::stringstream{};
+    stream << std::setw(4) << json;
+    saveToFileAtomically(stream.str(), filePath);
   }
-
-  // This step merges the newly serialized profile into the 'old' profile
-  // previously read from disk. The reason this is necessary is compatibility
-  // between different versions of RigelEngine. An older version of RigelEngine
-  // doesn't know about properties that are added in later versions. If we
-  // would write serializedProfile to disk directly, we would therefore lose
-  // any properties written by a newer version. Imagine a user has two versions
-  // of RigelEngine installed, version A and B. Version B features some
-  // additional options that are not present in A. Let's say the user configures
-  // these options to their liking while running version B. The settings are
-  // written to disk. Now the user launches version A. That version is not
-  // aware of the additional settings, so it overwrites the profile on disk
-  // and erases the user's settings. When the user launches version B again,
-  // all these configuration settings will be reset to their defaults.
-  //
-  // This would be quite annoying, so we take some measures to prevent it from
-  // happening. When reading the profile from disk, we keep the original JSON
-  // data in addition to the deserialized C++ objects. When writing back to
-  // disk, we merge our serializedProfile into the previously read JSON data.
-  // This ensures that any settings present in the profile file are kept,
-  // even if they are not part of the serializedProfile we are currently
-  // writing.
-  if (mOriginalJson.size() > 0)
+  catch (const std::exception& ex)
   {
-    try
-    {
-      const auto previousProfile = json::from_msgpack(mOriginalJson);
-      serializedProfile = merge(previousProfile, serializedProfile);
-    }
-    catch (const std::exception& ex)
-    {
-      LOG_F(WARNING, "Failed to merge in previous profile data: %s", ex.what());
-    }
+    LOG_F(ERROR, "Failed to store %s: %s", description, ex.what());
   }
+}
+
 
-  // Save user profile
+void writeProfile(
+  const ProfileSnapshot& snapshot,
+  const assets::ByteBuffer& unknownRecords)
+{
   LOG_F(INFO, "Saving user profile");
-  const auto buffer = json::to_msgpack(serializedProfile);
   try
   {
-    assets::saveToFile(buffer, *mProfilePath);
+    const auto buffer = encodeBinaryProfile(
+      {snapshot.mSaveSlots,
+       snapshot.mHighScoreLists,
+       snapshot.mGamePath,
+       unknownRecords});
+    saveToFileAtomically(buffer, snapshot.mProfilePath);
   }
   catch (const std::exception& ex)
   {
@@ -858,45 +1004,120 @@ void UserProfile::saveToDisk()
   }
 
   // Save options file and mod library file
+  auto optionsPlusGamePath = serialize(snapshot.mOptions);
+
+  if (snapshot.mGamePath)
   {
-    auto path = *mProfilePath;
+    optionsPlusGamePath["gamePath"] = snapshot.mGamePath->u8string();
+  }
 
-    {
-      LOG_F(INFO, "Saving options file");
+  auto path = snapshot.mProfilePath;
+  saveJsonFile(
+    "options file",
+    optionsPlusGamePath,
+    path.replace_filename(OPTIONS_FILENAME));
+  saveJsonFile(
+    "mod library",
+    serialize(snapshot.mModLibrary),
+    path.replace_filename(MOD_LIBRARY_FILENAME));
+}
 
-      path.replace_filename(OPTIONS_FILENAME);
-      auto optionsFile = std::ofstream(path);
-      LOG_IF_F(
-        ERROR,
-        !optionsFile.is_open(),
-        "Failed to open %s for writing",
-        path.u8string().c_str());
+} // namespace
 
 
-      auto optionsPlusGamePath = options;
+/** Writes user profile snapshots to disk on a background thread
+ *
+ * Saving happens asynchronously, so that slow storage doesn't stall the
+ * main loop. If several saves are requested while a write is still in
+ * progress, only the most recent snapshot is written afterwards.
+ *
+ * The destructor blocks until all outstanding writes have completed.
+ */
+class ProfileWriter
+{
+public:
+  explicit ProfileWriter(assets::ByteBuffer unknownRecords)
+    : mUnknownRecords(std::move(unknownRecords))
+  {
+  }
 
-      if (mGamePath)
-      {
-        optionsPlusGamePath["gamePath"] = mGamePath->u8string();
-      }
+  void save(ProfileSnapshot snapshot)
+  {
+    auto writeIsAlreadyQueued = false;
 
-      optionsFile << std::setw(4) << optionsPlusGamePath;
+    {
+      auto lock = std::lock_guard{mMutex};
+      writeIsAlreadyQueued = mPendingSnapshot.has_value();
+      mPendingSnapshot = std::move(snapshot);
     }
 
+    if (!writeIsAlreadyQueued)
     {
-      LOG_F(INFO, "Saving mod library");
+      mWorker.submit([this]() { writePendingSnapshot(); });
+    }
+  }
 
-      path.replace_filename(MOD_LIBRARY_FILENAME);
-      auto modLibraryFile = std::ofstream(path);
-      LOG_IF_F(
-        ERROR,
-        !modLibraryFile.is_open(),
-        "Failed to open %s for writing",
-        path.u8string().c_str());
+  void waitUntilIdle() { mWorker.waitUntilIdle(); }
 
-      modLibraryFile << std::setw(4) << serialize(mModLibrary);
+private:
+  void writePendingSnapshot()
+  {
+    auto snapshot = std::optional<ProfileSnapshot>{};
+
+    {
+      auto lock = std::lock_guard{mMutex};
+      std::swap(snapshot, mPendingSnapshot);
+    }
+
+    if (snapshot)
+    {
+      writeProfile(*snapshot, mUnknownRecords);
     }
   }
+
+  const assets::ByteBuffer mUnknownRecords;
+  std::mutex mMutex;
+  std::optional<ProfileSnapshot> mPendingSnapshot;
+
+  // Declared last so that the thread is joined before the other members
+  // are destroyed
+  base::WorkerThread mWorker;
+};
+
+
+UserProfile::UserProfile(
+  const std::filesystem::path& profilePath,
+  assets::ByteBuffer unknownBinaryRecords)
+  : mProfilePath(profilePath)
+  , mpWriter(std::make_shared<ProfileWriter>(std::move(unknownBinaryRecords)))
+{
+}
+
+
+void UserProfile::saveToDisk()
+{
+  if (!mProfilePath)
+  {
+    LOG_F(WARNING, "Not saving user profile since no file path was set");
+    return;
+  }
+
+  mpWriter->save(
+    {*mProfilePath,
+     mSaveSlots,
+     mHighScoreLists,
+     mOptions,
+     mModLibrary,
+     mGamePath});
+}
+
+
+void UserProfile::waitForPendingSaves()
+{
+  if (mpWriter)
+  {
+    mpWriter->waitUntilIdle();
+  }
 }
 
 
@@ -1020,16 +1241,23 @@ std::optional<UserProfile> loadUserProfile()
   const auto profileFilePath = *preferencesPath /
     (std::string{USER_PROFILE_BASE_NAME} + USER_PROFILE_FILE_EXTENSION);
   if (fs::exists(profileFilePath))
+  {
+    LOG_F(INFO, "Found user profile version 3, loading");
+    return loadBinaryProfile(profileFilePath);
+  }
+
+  const auto profileFilePath_v2 = *preferencesPath / USER_PROFILE_FILENAME_V2;
+  if (fs::exists(profileFilePath_v2))
   {
     LOG_F(INFO, "Found user profile version 2, loading");
-    return loadProfile(profileFilePath);
+    return loadJsonProfile(profileFilePath_v2, profileFilePath);
   }
 
   const auto profileFilePath_v1 = *preferencesPath / USER_PROFILE_FILENAME_V1;
   if (fs::exists(profileFilePath_v1))
   {
     LOG_F(INFO, "Found user profile version 1, loading");
-    return loadProfile(profileFilePath_v1, profileFilePath);
+    return loadJsonProfile(profileFilePath_v1, profileFilePath);
   }
 
   LOG_F(INFO, "No user profile found");
@@ -1053,6 +1281,36 @@ void importOriginalGameProfileData(
 }
 
 
+void exportUserProfileAsJson(
+  const UserProfile& profile,
+  const std::filesystem::path& file)
+{
+  nlohmann::json serializedProfile;
+  serializedProfile["saveSlots"] = serialize(profile.mSaveSlots);
+  serializedProfile["highScoreLists"] = serialize(profile.mHighScoreLists);
+  serializedProfile["options"] = serialize(profile.mOptions);
+
+  if (profile.mGamePath)
+  {
+    serializedProfile["gamePath"] = profile.mGamePath->u8string();
+  }
+
+  auto stream = std::stringstream{};
+  stream << std::setw(4) << serializedProfile;
+  saveToFileAtomically(stream.str(), file);
+}
+
+
+void importUserProfileFromJson(
+  UserProfile& profile,
+  const std::filesystem::path& file)
+{
+  const auto serializedProfile =
+    nlohmann::json::parse(assets::asText(assets::loadFile(file)));
+  deserializeProgressData(profile, serializedProfile);
+}
+
+
 UserProfile loadOrCreateUserProfile()
 {
   LOG_SCOPE_FUNCTION(INFO);
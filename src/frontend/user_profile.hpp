@@ -23,6 +23,7 @@
 #include "data/saved_game.hpp"
 
 #include <filesystem>
+#include <memory>
 #include <optional>
 #include <string>
 
@@ -30,9 +31,11 @@
 namespace rigel
 {
 
-constexpr auto USER_PROFILE_BASE_NAME = "UserProfile_v2";
+constexpr auto USER_PROFILE_BASE_NAME = "UserProfile_v3";
 constexpr auto USER_PROFILE_FILE_EXTENSION = ".rigel";
 
+class ProfileWriter;
+
 /** Store for user specific data
  *
  * The user profile stores data like saved games, high score lists, and game
@@ -44,7 +47,9 @@ constexpr auto USER_PROFILE_FILE_EXTENSION = ".rigel";
  * in the user profile file. Loading the profile using the aforementioned
  * function will fill these members with data accordingly. You can call
  * saveToDisk() at any time, and it will serialize the state of these members
- * into the file.
+ * into the file. Saving happens on a background thread, working on a copy of
+ * the data, so it's fine to modify the profile right after calling
+ * saveToDisk(). Copies of a profile share the same background writer.
  *
  * When changing any of the types used for the public members, or any of the
  * types used within one of those types, you need to adapt the serialization
@@ -56,10 +61,13 @@ public:
   UserProfile() = default;
   UserProfile(
     const std::filesystem::path& profilePath,
-    assets::ByteBuffer originalJson = {});
+    assets::ByteBuffer unknownBinaryRecords = {});
 
   void saveToDisk();
 
+  /** Block until all previously requested saves have been written */
+  void waitForPendingSaves();
+
   /** Returns true if the profile contains saved games and/or high scores */
   bool hasProgressData() const;
 
@@ -72,7 +80,7 @@ public:
 
 private:
   std::optional<std::filesystem::path> mProfilePath;
-  assets::ByteBuffer mOriginalJson;
+  std::shared_ptr<ProfileWriter> mpWriter;
 };
 
 
@@ -102,6 +110,25 @@ void importOriginalGameProfileData(
   UserProfile& profile,
   const std::string& gamePath);
 
+/** Write saved games, high scores, options and game path to a JSON file
+ *
+ * The result is human-readable, and can be loaded again using
+ * importUserProfileFromJson(). Throws an exception if the file can't be
+ * written.
+ */
+void exportUserProfileAsJson(
+  const UserProfile& profile,
+  const std::filesystem::path& file);
+
+/** Replace profile contents with data from a JSON file
+ *
+ * Reads a file written by exportUserProfileAsJson(). Throws an exception if
+ * the file can't be read or is invalid.
+ */
+void importUserProfileFromJson(
+  UserProfile& profile,
+  const std::filesystem::path& file);
+
 /** Loads existing profile if found, creates a new one otherwise. */
 UserProfile loadOrCreateUserProfile();
 
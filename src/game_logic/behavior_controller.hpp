@@ -17,14 +17,19 @@
 #pragma once
 
 #include "base/warnings.hpp"
+#include "engine/base_components.hpp"
+#include "engine/physical_components.hpp"
+#include "engine/visual_components.hpp"
 #include "game_logic/global_dependencies.hpp"
 
 RIGEL_DISABLE_WARNINGS
 #include <entityx/entityx.h>
 RIGEL_RESTORE_WARNINGS
 
+#include <cstdint>
 #include <memory>
 #include <type_traits>
+#include <utility>
 
 namespace rigel::engine::events
 {
@@ -35,9 +40,49 @@ struct CollidedWithWorld;
 namespace rigel::game_logic::components
 {
 
+/** Components most behavior controllers work with, resolved up front
+ *
+ * Controllers can receive these by taking a `const CommonComponents&` as
+ * additional last argument of their update() function. The lookup then
+ * happens once before the update instead of repeatedly inside of it.
+ *
+ * A pointer is null if the entity didn't have the corresponding component
+ * when the update started. Pointers are not refreshed during the update, so
+ * a controller which assigns or removes one of these components itself
+ * needs to look that component up via the entity instead.
+ */
+struct CommonComponents
+{
+  engine::components::WorldPosition* mpPosition = nullptr;
+  engine::components::BoundingBox* mpBoundingBox = nullptr;
+  engine::components::MovingBody* mpMovingBody = nullptr;
+  engine::components::Sprite* mpSprite = nullptr;
+};
+
+
 namespace detail
 {
 
+template <typename C>
+C* componentPointer(entityx::Entity entity)
+{
+  auto handle = entity.component<C>();
+  return handle ? handle.get() : nullptr;
+}
+
+
+inline CommonComponents resolveCommonComponents(entityx::Entity entity)
+{
+  using namespace engine::components;
+
+  return CommonComponents{
+    componentPointer<WorldPosition>(entity),
+    componentPointer<BoundingBox>(entity),
+    componentPointer<MovingBody>(entity),
+    componentPointer<Sprite>(entity)};
+}
+
+
 template <typename...>
 using void_t = void;
 
@@ -72,21 +117,71 @@ template <typename T>
 struct hasOnCollision<T, void_t<decltype(&T::onCollision)>> : std::true_type
 {
 };
+
+
+template <typename T, typename = void>
+struct hasOffScreenUpdateInterval : std::false_type
+{
+};
+
+template <typename T>
+struct hasOffScreenUpdateInterval<
+  T,
+  void_t<decltype(&T::offScreenUpdateInterval)>> : std::true_type
+{
+};
+
+
+template <typename T, typename = void>
+struct takesCommonComponents : std::false_type
+{
+};
+
+template <typename T>
+struct takesCommonComponents<
+  T,
+  void_t<decltype(std::declval<T&>().update(
+    std::declval<GlobalDependencies&>(),
+    std::declval<GlobalState&>(),
+    std::declval<bool>(),
+    std::declval<entityx::Entity>(),
+    std::declval<const CommonComponents&>()))>> : std::true_type
+{
+};
 } // namespace detail
 
 
 template <typename T>
-void updateBehaviorController(
-  T& self,
-  GlobalDependencies& dependencies,
-  GlobalState& state,
-  const bool isOnScreen,
-  entityx::Entity entity)
+std::enable_if_t<!detail::takesCommonComponents<T>::value>
+  updateBehaviorController(
+    T& self,
+    GlobalDependencies& dependencies,
+    GlobalState& state,
+    const bool isOnScreen,
+    entityx::Entity entity)
 {
   self.update(dependencies, state, isOnScreen, entity);
 }
 
 
+template <typename T>
+std::enable_if_t<detail::takesCommonComponents<T>::value>
+  updateBehaviorController(
+    T& self,
+    GlobalDependencies& dependencies,
+    GlobalState& state,
+    const bool isOnScreen,
+    entityx::Entity entity)
+{
+  self.update(
+    dependencies,
+    state,
+    isOnScreen,
+    entity,
+    detail::resolveCommonComponents(entity));
+}
+
+
 template <typename T>
 std::enable_if_t<detail::hasOnHit<T>::value> behaviorControllerOnHit(
   T& self,
@@ -158,17 +253,52 @@ std::enable_if_t<!detail::hasOnCollision<T>::value>
 }
 
 
+template <typename T>
+std::enable_if_t<detail::hasOffScreenUpdateInterval<T>::value, int>
+  behaviorControllerOffScreenUpdateInterval(const T& self)
+{
+  return self.offScreenUpdateInterval();
+}
+
+
+template <typename T>
+std::enable_if_t<!detail::hasOffScreenUpdateInterval<T>::value, int>
+  behaviorControllerOffScreenUpdateInterval(const T&)
+{
+  return 1;
+}
+
+
+/** Type-erased behavior controller
+ *
+ * Which of the optional hooks (onHit, onKilled, onCollision) the wrapped
+ * type implements is determined at compile time and recorded on
+ * construction. Invoking a hook that the controller doesn't have is then
+ * a cheap no-op, without going through a virtual call.
+ *
+ * Controllers for always-active entities can opt into less frequent updates
+ * while their entity is off screen by implementing
+ * `int offScreenUpdateInterval() const`. The returned value is the number
+ * of frames between two updates while off screen, 1 means every frame.
+ * Controllers without this function are always updated every frame.
+ *
+ * Controllers whose update() takes an additional `const CommonComponents&`
+ * receive their entity's commonly used components already looked up, see
+ * CommonComponents.
+ */
 class BehaviorController
 {
 public:
   template <typename T>
   explicit BehaviorController(T controller)
     : mpSelf(std::make_unique<Model<T>>(std::move(controller)))
+    , mHooks(hooksFor<T>())
   {
   }
 
   BehaviorController(const BehaviorController& other)
     : mpSelf(other.mpSelf->clone())
+    , mHooks(other.mHooks)
   {
   }
 
@@ -176,6 +306,7 @@ public:
   {
     auto copy = other;
     std::swap(mpSelf, copy.mpSelf);
+    std::swap(mHooks, copy.mHooks);
     return *this;
   }
 
@@ -197,7 +328,10 @@ public:
     entityx::Entity inflictorEntity,
     entityx::Entity entity)
   {
-    mpSelf->onHit(dependencies, state, inflictorEntity, entity);
+    if (hasOnHit())
+    {
+      mpSelf->onHit(dependencies, state, inflictorEntity, entity);
+    }
   }
 
   void onKilled(
@@ -206,7 +340,10 @@ public:
     const base::Vec2f& inflictorVelocity,
     entityx::Entity entity)
   {
-    mpSelf->onKilled(dependencies, state, inflictorVelocity, entity);
+    if (hasOnKilled())
+    {
+      mpSelf->onKilled(dependencies, state, inflictorVelocity, entity);
+    }
   }
 
   void onCollision(
@@ -215,7 +352,24 @@ public:
     const engine::events::CollidedWithWorld& event,
     entityx::Entity entity)
   {
-    mpSelf->onCollision(dependencies, state, event, entity);
+    if (hasOnCollision())
+    {
+      mpSelf->onCollision(dependencies, state, event, entity);
+    }
+  }
+
+  bool hasOnHit() const { return (mHooks & HOOK_ON_HIT) != 0; }
+  bool hasOnKilled() const { return (mHooks & HOOK_ON_KILLED) != 0; }
+  bool hasOnCollision() const { return (mHooks & HOOK_ON_COLLISION) != 0; }
+
+  int offScreenUpdateInterval() const
+  {
+    if ((mHooks & HOOK_OFF_SCREEN_UPDATE_INTERVAL) == 0)
+    {
+      return 1;
+    }
+
+    return mpSelf->offScreenUpdateInterval();
   }
 
   template <typename T>
@@ -226,6 +380,22 @@ public:
   }
 
 private:
+  static constexpr std::uint8_t HOOK_ON_HIT = 1 << 0;
+  static constexpr std::uint8_t HOOK_ON_KILLED = 1 << 1;
+  static constexpr std::uint8_t HOOK_ON_COLLISION = 1 << 2;
+  static constexpr std::uint8_t HOOK_OFF_SCREEN_UPDATE_INTERVAL = 1 << 3;
+
+  template <typename T>
+  static constexpr std::uint8_t hooksFor()
+  {
+    return (detail::hasOnHit<T>::value ? HOOK_ON_HIT : 0) |
+      (detail::hasOnKilled<T>::value ? HOOK_ON_KILLED : 0) |
+      (detail::hasOnCollision<T>::value ? HOOK_ON_COLLISION : 0) |
+      (detail::hasOffScreenUpdateInterval<T>::value
+         ? HOOK_OFF_SCREEN_UPDATE_INTERVAL
+         : 0);
+  }
+
   struct Concept
   {
     virtual ~Concept() = default;
@@ -255,6 +425,8 @@ private:
       GlobalState& state,
       const engine::events::CollidedWithWorld& event,
       entityx::Entity entity) = 0;
+
+    virtual int offScreenUpdateInterval() const = 0;
   };
 
   template <typename T>
@@ -308,10 +480,16 @@ private:
       behaviorControllerOnCollision(mData, dependencies, state, event, entity);
     }
 
+    int offScreenUpdateInterval() const override
+    {
+      return behaviorControllerOffScreenUpdateInterval(mData);
+    }
+
     T mData;
   };
 
   std::unique_ptr<Concept> mpSelf;
+  std::uint8_t mHooks;
 };
 
 } // namespace rigel::game_logic::components
@@ -47,13 +47,40 @@ void BehaviorControllerSystem::update(
   using game_logic::components::BehaviorController;
 
   mPerFrameState = s;
+  mGlobalState.mPlayerProximity = PlayerProximity{*mGlobalState.mpPlayer};
 
   es.each<BehaviorController, Active>([this](
                                         entityx::Entity entity,
                                         BehaviorController& controller,
                                         const Active& active) {
-    controller.update(mDependencies, mGlobalState, active.mIsOnScreen, entity);
+    if (needsUpdate(entity, active.mIsOnScreen))
+    {
+      controller.update(
+        mDependencies, mGlobalState, active.mIsOnScreen, entity);
+    }
   });
+
+  ++mFrameCounter;
+}
+
+
+bool BehaviorControllerSystem::needsUpdate(
+  entityx::Entity entity,
+  const bool isOnScreen) const
+{
+  using game_logic::components::BehaviorController;
+
+  if (isOnScreen)
+  {
+    return true;
+  }
+
+  // Spread the updates of entities sharing the same interval across
+  // frames by offsetting with the entity index.
+  const auto interval =
+    entity.component<BehaviorController>()->offScreenUpdateInterval();
+  return interval <= 1 ||
+    (mFrameCounter + entity.id().index()) % std::uint32_t(interval) == 0;
 }
 
 
@@ -20,6 +20,8 @@
 #include "game_logic/global_dependencies.hpp"
 #include "game_logic_common/input.hpp"
 
+#include <cstdint>
+
 namespace rigel::engine::events
 {
 struct CollidedWithWorld;
@@ -46,9 +48,12 @@ public:
   void receive(const engine::events::CollidedWithWorld& event);
 
 private:
+  bool needsUpdate(entityx::Entity entity, bool isOnScreen) const;
+
   GlobalDependencies mDependencies;
   PerFrameState mPerFrameState;
   GlobalState mGlobalState;
+  std::uint32_t mFrameCounter = 0;
 };
 
 } // namespace rigel::game_logic
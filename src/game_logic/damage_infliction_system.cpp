@@ -19,6 +19,7 @@
 #include "data/player_model.hpp"
 #include "engine/base_components.hpp"
 #include "engine/physical_components.hpp"
+#include "engine/spatial_index.hpp"
 #include "engine/visual_components.hpp"
 #include "frontend/game_service_provider.hpp"
 
@@ -55,9 +56,11 @@ auto extractVelocity(entityx::Entity entity)
 DamageInflictionSystem::DamageInflictionSystem(
   data::PersistentPlayerState* pPersistentPlayerState,
   IGameServiceProvider* pServiceProvider,
+  const engine::SpatialIndex* pSpatialIndex,
   entityx::EventManager* pEvents)
   : mpPersistentPlayerState(pPersistentPlayerState)
   , mpServiceProvider(pServiceProvider)
+  , mpSpatialIndex(pSpatialIndex)
   , mpEvents(pEvents)
 {
 }
@@ -66,37 +69,33 @@ DamageInflictionSystem::DamageInflictionSystem(
 void DamageInflictionSystem::update(ex::EntityManager& es)
 {
   es.each<Shootable, WorldPosition, BoundingBox>(
-    [this, &es](
+    [this](
       ex::Entity shootableEntity,
       Shootable& shootable,
       const WorldPosition& shootablePos,
       const BoundingBox& shootableBboxLocal) {
+      const auto shootableOnScreen =
+        shootableEntity.has_component<Active>() &&
+        shootableEntity.component<Active>()->mIsOnScreen;
+
+      if (shootable.mInvincible || !shootableOnScreen)
+      {
+        return;
+      }
+
       const auto shootableBbox =
         engine::toWorldSpace(shootableBboxLocal, shootablePos);
-
-      ex::ComponentHandle<DamageInflicting> damage;
-      ex::ComponentHandle<WorldPosition> inflictorPosition;
-      ex::ComponentHandle<BoundingBox> inflictorBboxLocal;
-      for (auto inflictorEntity : es.entities_with_components(
-             damage, inflictorPosition, inflictorBboxLocal))
+      // When multiple inflictors overlap the shootable, the first one in
+      // entity order is used.
+      auto inflictorEntity =
+        mpSpatialIndex->firstIntersecting<DamageInflicting>(shootableBbox);
+      if (inflictorEntity)
       {
-        const auto inflictorBbox =
-          engine::toWorldSpace(*inflictorBboxLocal, *inflictorPosition);
-
-        const auto shootableOnScreen =
-          shootableEntity.has_component<Active>() &&
-          shootableEntity.component<Active>()->mIsOnScreen;
-
-        // clang-format off
-        if (
-          shootableBbox.intersects(inflictorBbox) &&
-          !shootable.mInvincible &&
-          shootableOnScreen)
-        // clang-format on
-        {
-          inflictDamage(inflictorEntity, *damage, shootableEntity, shootable);
-          break;
-        }
+        inflictDamage(
+          inflictorEntity,
+          *inflictorEntity.component<DamageInflicting>(),
+          shootableEntity,
+          shootable);
       }
     });
 }
@@ -34,6 +34,11 @@ namespace rigel::data
 class PersistentPlayerState;
 }
 
+namespace rigel::engine
+{
+class SpatialIndex;
+}
+
 
 namespace rigel::game_logic
 {
@@ -44,6 +49,7 @@ public:
   DamageInflictionSystem(
     data::PersistentPlayerState* pPersistentPlayerState,
     IGameServiceProvider* pServiceProvider,
+    const engine::SpatialIndex* pSpatialIndex,
     entityx::EventManager* pEvents);
 
   void update(entityx::EntityManager& es);
@@ -57,6 +63,7 @@ private:
 
   data::PersistentPlayerState* mpPersistentPlayerState;
   IGameServiceProvider* mpServiceProvider;
+  const engine::SpatialIndex* mpSpatialIndex;
   entityx::EventManager* mpEvents;
 };
 
@@ -44,6 +44,12 @@ public:
     const base::Size& viewportSize,
     float interpolationFactor);
 
+  /** True if update() currently draws anything */
+  bool hasVisibleOverlays() const
+  {
+    return mShowBoundingBoxes || mShowWorldCollisionData || mShowGrid;
+  }
+
 private:
   renderer::Renderer* mpRenderer;
   data::map::Map* mpMap;
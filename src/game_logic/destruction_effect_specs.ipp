@@ -20,7 +20,7 @@
 using EffectMovement = effects::EffectSprite::Movement;
 
 
-const effects::EffectSpec HOVER_BOT_KILL_EFFECT_SPEC[] = {
+constexpr auto HOVER_BOT_KILL_EFFECT_SPEC = effects::sortedByDelay({
   {effects::SpriteCascade{rigel::data::ActorID::Shot_impact_FX}, 0},
   {effects::EffectSprite{
      {0, -2},
@@ -33,50 +33,51 @@ const effects::EffectSpec HOVER_BOT_KILL_EFFECT_SPEC[] = {
      EffectMovement::FlyDown},
    0},
   {effects::Particles{{1, 0}, rigel::data::GameTraits::INGAME_PALETTE[3]}, 0},
-  {effects::RandomExplosionSound{}, 0}};
+  {effects::RandomExplosionSound{}, 0}});
 
 
-const effects::EffectSpec SIMPLE_TECH_KILL_EFFECT_SPEC[] = {
+constexpr auto SIMPLE_TECH_KILL_EFFECT_SPEC = effects::sortedByDelay({
   {effects::SpriteCascade{rigel::data::ActorID::Shot_impact_FX}, 0},
   {effects::Particles{{1, 0}}, 0},
-  {effects::RandomExplosionSound{}, 0}};
+  {effects::RandomExplosionSound{}, 0}});
 
 
-const effects::EffectSpec NAPALM_BOMB_KILL_EFFECT_SPEC[] = {
+constexpr auto NAPALM_BOMB_KILL_EFFECT_SPEC = effects::sortedByDelay({
   {effects::RandomExplosionSound{}, 0},
-  {effects::Particles{{1, 0}, rigel::data::GameTraits::INGAME_PALETTE[15]}, 0}};
+  {effects::Particles{{1, 0}, rigel::data::GameTraits::INGAME_PALETTE[15]}, 0},
+});
 
 
-const effects::EffectSpec SPIDER_KILL_EFFECT_SPEC[] = {
+constexpr auto SPIDER_KILL_EFFECT_SPEC = effects::sortedByDelay({
   {effects::EffectSprite{
      {-1, 1},
      rigel::data::ActorID::Explosion_FX_1,
      EffectMovement::None},
-   0}};
+   0}});
 
 
-const effects::EffectSpec RED_BIRD_KILL_EFFECT_SPEC[] = {
+constexpr auto RED_BIRD_KILL_EFFECT_SPEC = effects::sortedByDelay({
   {effects::Particles{{}, rigel::data::GameTraits::INGAME_PALETTE[5]}, 0},
   {effects::EffectSprite{
      {},
      rigel::data::ActorID::Explosion_FX_1,
      EffectMovement::None},
-   0}};
+   0}});
 
 
-const effects::EffectSpec SKELETON_KILL_EFFECT_SPEC[] = {
+constexpr auto SKELETON_KILL_EFFECT_SPEC = effects::sortedByDelay({
   {effects::SpriteCascade{rigel::data::ActorID::Shot_impact_FX}, 0},
   {effects::RandomExplosionSound{}, 0},
-  {effects::Particles{{1, 0}}, 0}};
+  {effects::Particles{{1, 0}}, 0}});
 
 
-const effects::EffectSpec RIGELATIN_KILL_EFFECT_SPEC[] = {
+constexpr auto RIGELATIN_KILL_EFFECT_SPEC = effects::sortedByDelay({
   {effects::SpriteCascade{rigel::data::ActorID::Explosion_FX_1}, 0},
   {effects::Particles{{1, 0}}, 0},
-};
+});
 
 
-const effects::EffectSpec SODA_CAN_ROCKET_KILL_EFFECT_SPEC[] = {
+constexpr auto SODA_CAN_ROCKET_KILL_EFFECT_SPEC = effects::sortedByDelay({
   {effects::RandomExplosionSound{}, 0},
   {effects::EffectSprite{
      {0, -1},
@@ -88,10 +89,10 @@ const effects::EffectSpec SODA_CAN_ROCKET_KILL_EFFECT_SPEC[] = {
      rigel::data::ActorID::Coke_can_debris_2,
      EffectMovement::FlyRight},
    0},
-};
+});
 
 
-const effects::EffectSpec SODA_SIX_PACK_KILL_EFFECT_SPEC[] = {
+constexpr auto SODA_SIX_PACK_KILL_EFFECT_SPEC = effects::sortedByDelay({
   {effects::RandomExplosionSound{}, 0},
   {effects::EffectSprite{
      {0, 0},
@@ -153,10 +154,10 @@ const effects::EffectSpec SODA_SIX_PACK_KILL_EFFECT_SPEC[] = {
      rigel::data::ActorID::Coke_can_debris_2,
      EffectMovement::FlyDown},
    0},
-  {effects::ScoreNumber{{}, ScoreNumberType::S10000}, 0}};
+  {effects::ScoreNumber{{}, ScoreNumberType::S10000}, 0}});
 
 
-const effects::EffectSpec EYE_BALL_THROWER_KILL_EFFECT_SPEC[] = {
+constexpr auto EYE_BALL_THROWER_KILL_EFFECT_SPEC = effects::sortedByDelay({
   {effects::Sound{data::SoundId::BiologicalEnemyDestroyed}, 0},
   {effects::EffectSprite{
      {0, -6},
@@ -183,22 +184,22 @@ const effects::EffectSpec EYE_BALL_THROWER_KILL_EFFECT_SPEC[] = {
      rigel::data::ActorID::Eyeball_projectile,
      EffectMovement::FlyUp},
    0},
-  {effects::Particles{{}, rigel::data::GameTraits::INGAME_PALETTE[13]}, 0}};
+  {effects::Particles{{}, rigel::data::GameTraits::INGAME_PALETTE[13]}, 0}});
 
 
-const effects::EffectSpec LIVING_TURKEY_KILL_EFFECT_SPEC[] = {
+constexpr auto LIVING_TURKEY_KILL_EFFECT_SPEC = effects::sortedByDelay({
   {effects::Sound{data::SoundId::BiologicalEnemyDestroyed}, 0},
   {effects::EffectSprite{
      {},
      rigel::data::ActorID::Smoke_cloud_FX,
      EffectMovement::None},
-   0}};
+   0}});
 
 
-const effects::EffectSpec BOSS4_PROJECTILE_KILL_EFFECT_SPEC[] = {
+constexpr auto BOSS4_PROJECTILE_KILL_EFFECT_SPEC = effects::sortedByDelay({
   {effects::SpriteCascade{rigel::data::ActorID::Shot_impact_FX}, 0},
   {effects::Particles{{1, 0}, rigel::data::GameTraits::INGAME_PALETTE[3]}, 0},
-  {effects::RandomExplosionSound{}, 0}};
+  {effects::RandomExplosionSound{}, 0}});
 
 
 #define M_TECH_KILL_EFFECT_SPEC_DEFINITION                                     \
@@ -217,40 +218,40 @@ const effects::EffectSpec BOSS4_PROJECTILE_KILL_EFFECT_SPEC[] = {
   }
 
 
-const effects::EffectSpec TECH_KILL_EFFECT_SPEC[] = {
-  M_TECH_KILL_EFFECT_SPEC_DEFINITION};
+constexpr auto TECH_KILL_EFFECT_SPEC = effects::sortedByDelay({
+  M_TECH_KILL_EFFECT_SPEC_DEFINITION});
 
 
-const effects::EffectSpec RADAR_DISH_KILL_EFFECT_SPEC[] = {
+constexpr auto RADAR_DISH_KILL_EFFECT_SPEC = effects::sortedByDelay({
   M_TECH_KILL_EFFECT_SPEC_DEFINITION,
-  {effects::ScoreNumber{{}, ScoreNumberType::S2000}, 0}};
+  {effects::ScoreNumber{{}, ScoreNumberType::S2000}, 0}});
 
 
-const effects::EffectSpec EXIT_SIGN_KILL_EFFECT_SPEC[] = {
+constexpr auto EXIT_SIGN_KILL_EFFECT_SPEC = effects::sortedByDelay({
   M_TECH_KILL_EFFECT_SPEC_DEFINITION,
-  {effects::ScoreNumber{{}, ScoreNumberType::S10000}, 0}};
+  {effects::ScoreNumber{{}, ScoreNumberType::S10000}, 0}});
 
 
-const effects::EffectSpec FLOATING_ARROW_KILL_EFFECT_SPEC[] = {
+constexpr auto FLOATING_ARROW_KILL_EFFECT_SPEC = effects::sortedByDelay({
   M_TECH_KILL_EFFECT_SPEC_DEFINITION,
-  {effects::ScoreNumber{{}, ScoreNumberType::S500}, 0}};
+  {effects::ScoreNumber{{}, ScoreNumberType::S500}, 0}});
 
 
 #undef M_TECH_KILL_EFFECT_SPEC_DEFINITION
 
 
-const effects::EffectSpec SPIKE_BALL_KILL_EFFECT_SPEC[] = {
+constexpr auto SPIKE_BALL_KILL_EFFECT_SPEC = effects::sortedByDelay({
   {effects::Particles{{1, 0}, rigel::data::GameTraits::INGAME_PALETTE[15]}, 0},
   {effects::EffectSprite{
      {-1, 1},
      rigel::data::ActorID::Explosion_FX_1,
      EffectMovement::None},
-   0}};
+   0}});
 
 
 // The bonus globes have one additional destruction effect, which is handled
 // separately - see configureBonusGlobe() in entity_configuration.ipp
-const effects::EffectSpec BONUS_GLOBE_KILL_EFFECT_SPEC[] = {
+constexpr auto BONUS_GLOBE_KILL_EFFECT_SPEC = effects::sortedByDelay({
   {effects::EffectSprite{
      {},
      rigel::data::ActorID::Bonus_globe_debris_1,
@@ -263,46 +264,11 @@ const effects::EffectSpec BONUS_GLOBE_KILL_EFFECT_SPEC[] = {
    0},
   {effects::ScoreNumber{{}, ScoreNumberType::S100}, 0},
   {effects::Sound{data::SoundId::GlassBreaking}, 0},
-  {effects::Particles{{1, 0}, rigel::data::GameTraits::INGAME_PALETTE[15]}, 0}};
-
-
-const effects::EffectSpec BIOLOGICAL_ENEMY_KILL_EFFECT_SPEC[] = {
-  {effects::SpriteCascade{rigel::data::ActorID::Shot_impact_FX}, 0},
-  {effects::Particles{{1, 0}}, 0},
-  {effects::Sound{data::SoundId::BiologicalEnemyDestroyed}, 0},
-  {effects::EffectSprite{
-     {1, 2},
-     rigel::data::ActorID::Biological_enemy_debris,
-     EffectMovement::FlyUp},
-   0},
-  {effects::EffectSprite{
-     {},
-     rigel::data::ActorID::Biological_enemy_debris,
-     EffectMovement::FlyUpperRight},
-   1},
-  {effects::EffectSprite{
-     {-1, 1},
-     rigel::data::ActorID::Biological_enemy_debris,
-     EffectMovement::FlyUpperLeft},
-   2},
-  {effects::EffectSprite{
-     {1, -1},
-     rigel::data::ActorID::Biological_enemy_debris,
-     EffectMovement::FlyDown},
-   3},
-  {effects::EffectSprite{
-     {-1, 2},
-     rigel::data::ActorID::Biological_enemy_debris,
-     EffectMovement::FlyUpperRight},
-   4},
-  {effects::EffectSprite{
-     {1, 2},
-     rigel::data::ActorID::Biological_enemy_debris,
-     EffectMovement::FlyUpperLeft},
-   5}};
+  {effects::Particles{{1, 0}, rigel::data::GameTraits::INGAME_PALETTE[15]}, 0},
+});
 
 
-const effects::EffectSpec EXTENDED_BIOLOGICAL_ENEMY_KILL_EFFECT_SPEC[] = {
+constexpr auto BIOLOGICAL_ENEMY_KILL_EFFECT_SPEC = effects::sortedByDelay({
   {effects::SpriteCascade{rigel::data::ActorID::Shot_impact_FX}, 0},
   {effects::Particles{{1, 0}}, 0},
   {effects::Sound{data::SoundId::BiologicalEnemyDestroyed}, 0},
@@ -335,82 +301,119 @@ const effects::EffectSpec EXTENDED_BIOLOGICAL_ENEMY_KILL_EFFECT_SPEC[] = {
      {1, 2},
      rigel::data::ActorID::Biological_enemy_debris,
      EffectMovement::FlyUpperLeft},
-   5},
-
-  {effects::EffectSprite{
-     {-1, 0},
-     rigel::data::ActorID::Biological_enemy_debris,
-     EffectMovement::FlyUp},
-   0},
-  {effects::EffectSprite{
-     {-2, -2},
-     rigel::data::ActorID::Biological_enemy_debris,
-     EffectMovement::FlyUpperRight},
-   1},
-  {effects::EffectSprite{
-     {-3, -1},
-     rigel::data::ActorID::Biological_enemy_debris,
-     EffectMovement::FlyUpperLeft},
-   2},
-  {effects::EffectSprite{
-     {-1, -3},
-     rigel::data::ActorID::Biological_enemy_debris,
-     EffectMovement::FlyDown},
-   3},
-  {effects::EffectSprite{
-     {-3, 0},
-     rigel::data::ActorID::Biological_enemy_debris,
-     EffectMovement::FlyUpperRight},
-   4},
-  {effects::EffectSprite{
-     {-1, 0},
-     rigel::data::ActorID::Biological_enemy_debris,
-     EffectMovement::FlyUpperLeft},
-   5},
-  {effects::EffectSprite{
-     {3, -2},
-     rigel::data::ActorID::Biological_enemy_debris,
-     EffectMovement::FlyUp},
-   0},
-  {effects::EffectSprite{
-     {2, -4},
-     rigel::data::ActorID::Biological_enemy_debris,
-     EffectMovement::FlyUpperRight},
-   1},
-  {effects::EffectSprite{
-     {1, -3},
-     rigel::data::ActorID::Biological_enemy_debris,
-     EffectMovement::FlyUpperLeft},
-   2},
-  {effects::EffectSprite{
-     {3, -5},
-     rigel::data::ActorID::Biological_enemy_debris,
-     EffectMovement::FlyDown},
-   3},
-  {effects::EffectSprite{
-     {1, -2},
-     rigel::data::ActorID::Biological_enemy_debris,
-     EffectMovement::FlyUpperRight},
-   4},
-  {effects::EffectSprite{
-     {3, -2},
-     rigel::data::ActorID::Biological_enemy_debris,
-     EffectMovement::FlyUpperLeft},
-   5}};
-
-
-const effects::EffectSpec CAMERA_KILL_EFFECT_SPEC[] = {
+   5}});
+
+
+constexpr auto EXTENDED_BIOLOGICAL_ENEMY_KILL_EFFECT_SPEC =
+  effects::sortedByDelay({
+    {effects::SpriteCascade{rigel::data::ActorID::Shot_impact_FX}, 0},
+    {effects::Particles{{1, 0}}, 0},
+    {effects::Sound{data::SoundId::BiologicalEnemyDestroyed}, 0},
+    {effects::EffectSprite{
+       {1, 2},
+       rigel::data::ActorID::Biological_enemy_debris,
+       EffectMovement::FlyUp},
+     0},
+    {effects::EffectSprite{
+       {},
+       rigel::data::ActorID::Biological_enemy_debris,
+       EffectMovement::FlyUpperRight},
+     1},
+    {effects::EffectSprite{
+       {-1, 1},
+       rigel::data::ActorID::Biological_enemy_debris,
+       EffectMovement::FlyUpperLeft},
+     2},
+    {effects::EffectSprite{
+       {1, -1},
+       rigel::data::ActorID::Biological_enemy_debris,
+       EffectMovement::FlyDown},
+     3},
+    {effects::EffectSprite{
+       {-1, 2},
+       rigel::data::ActorID::Biological_enemy_debris,
+       EffectMovement::FlyUpperRight},
+     4},
+    {effects::EffectSprite{
+       {1, 2},
+       rigel::data::ActorID::Biological_enemy_debris,
+       EffectMovement::FlyUpperLeft},
+     5},
+
+    {effects::EffectSprite{
+       {-1, 0},
+       rigel::data::ActorID::Biological_enemy_debris,
+       EffectMovement::FlyUp},
+     0},
+    {effects::EffectSprite{
+       {-2, -2},
+       rigel::data::ActorID::Biological_enemy_debris,
+       EffectMovement::FlyUpperRight},
+     1},
+    {effects::EffectSprite{
+       {-3, -1},
+       rigel::data::ActorID::Biological_enemy_debris,
+       EffectMovement::FlyUpperLeft},
+     2},
+    {effects::EffectSprite{
+       {-1, -3},
+       rigel::data::ActorID::Biological_enemy_debris,
+       EffectMovement::FlyDown},
+     3},
+    {effects::EffectSprite{
+       {-3, 0},
+       rigel::data::ActorID::Biological_enemy_debris,
+       EffectMovement::FlyUpperRight},
+     4},
+    {effects::EffectSprite{
+       {-1, 0},
+       rigel::data::ActorID::Biological_enemy_debris,
+       EffectMovement::FlyUpperLeft},
+     5},
+    {effects::EffectSprite{
+       {3, -2},
+       rigel::data::ActorID::Biological_enemy_debris,
+       EffectMovement::FlyUp},
+     0},
+    {effects::EffectSprite{
+       {2, -4},
+       rigel::data::ActorID::Biological_enemy_debris,
+       EffectMovement::FlyUpperRight},
+     1},
+    {effects::EffectSprite{
+       {1, -3},
+       rigel::data::ActorID::Biological_enemy_debris,
+       EffectMovement::FlyUpperLeft},
+     2},
+    {effects::EffectSprite{
+       {3, -5},
+       rigel::data::ActorID::Biological_enemy_debris,
+       EffectMovement::FlyDown},
+     3},
+    {effects::EffectSprite{
+       {1, -2},
+       rigel::data::ActorID::Biological_enemy_debris,
+       EffectMovement::FlyUpperRight},
+     4},
+    {effects::EffectSprite{
+       {3, -2},
+       rigel::data::ActorID::Biological_enemy_debris,
+       EffectMovement::FlyUpperLeft},
+     5}});
+
+
+constexpr auto CAMERA_KILL_EFFECT_SPEC = effects::sortedByDelay({
   {effects::Particles{{}}, 0},
   {effects::ScoreNumber{{}, ScoreNumberType::S100}, 0},
-  {effects::RandomExplosionSound{}, 0}};
+  {effects::RandomExplosionSound{}, 0}});
 
 
-const effects::EffectSpec SMALL_FLYING_SHIP_KILL_EFFECT_SPEC[] = {
+constexpr auto SMALL_FLYING_SHIP_KILL_EFFECT_SPEC = effects::sortedByDelay({
   {effects::Particles{{}}, 0},
-  {effects::RandomExplosionSound{}, 0}};
+  {effects::RandomExplosionSound{}, 0}});
 
 
-const effects::EffectSpec GRABBER_CLAW_KILL_EFFECT_SPEC[] = {
+constexpr auto GRABBER_CLAW_KILL_EFFECT_SPEC = effects::sortedByDelay({
   {effects::EffectSprite{
      {},
      rigel::data::ActorID::Metal_grabber_claw_debris_1,
@@ -422,16 +425,16 @@ const effects::EffectSpec GRABBER_CLAW_KILL_EFFECT_SPEC[] = {
      EffectMovement::FlyUpperRight},
    0},
   {effects::RandomExplosionSound{}, 0},
-  {effects::SpriteCascade{rigel::data::ActorID::Shot_impact_FX}, 0}};
+  {effects::SpriteCascade{rigel::data::ActorID::Shot_impact_FX}, 0}});
 
 
-const effects::EffectSpec BLUE_GUARD_KILL_EFFECT_SPEC[] = {
+constexpr auto BLUE_GUARD_KILL_EFFECT_SPEC = effects::sortedByDelay({
   {effects::Particles{{1, 0}, rigel::data::GameTraits::INGAME_PALETTE[11]}, 0},
   {effects::RandomExplosionSound{}, 0},
-  {effects::SpriteCascade{rigel::data::ActorID::Shot_impact_FX}, 0}};
+  {effects::SpriteCascade{rigel::data::ActorID::Shot_impact_FX}, 0}});
 
 
-const effects::EffectSpec NUCLEAR_WASTE_BARREL_KILL_EFFECT_SPEC[] = {
+constexpr auto NUCLEAR_WASTE_BARREL_KILL_EFFECT_SPEC = effects::sortedByDelay({
   {effects::RandomExplosionSound{}, 0},
   {effects::Particles{{1, 0}, rigel::data::GameTraits::INGAME_PALETTE[4]}, 0},
   {effects::Particles{{1, 0}, rigel::data::GameTraits::INGAME_PALETTE[15]}, 0},
@@ -460,10 +463,10 @@ const effects::EffectSpec NUCLEAR_WASTE_BARREL_KILL_EFFECT_SPEC[] = {
      {},
      rigel::data::ActorID::Smoke_cloud_FX,
      EffectMovement::None},
-   2}};
+   2}});
 
 
-const effects::EffectSpec CONTAINER_BOX_KILL_EFFECT_SPEC[] = {
+constexpr auto CONTAINER_BOX_KILL_EFFECT_SPEC = effects::sortedByDelay({
   {effects::RandomExplosionSound{}, 0},
   {effects::Particles{{1, 0}, rigel::data::GameTraits::INGAME_PALETTE[4]}, 0},
   {effects::Particles{{1, 0}, rigel::data::GameTraits::INGAME_PALETTE[15]}, 0},
@@ -489,15 +492,16 @@ const effects::EffectSpec CONTAINER_BOX_KILL_EFFECT_SPEC[] = {
      rigel::data::ActorID::Green_fireball_FX,
      EffectMovement::FlyDown},
    1},
-};
+});
 
 
-const effects::EffectSpec SLIME_CONTAINER_KILL_EFFECT_SPEC[] = {
+constexpr auto SLIME_CONTAINER_KILL_EFFECT_SPEC = effects::sortedByDelay({
   {effects::Sound{data::SoundId::GlassBreaking}, 0},
-  {effects::Particles{{1, 0}, rigel::data::GameTraits::INGAME_PALETTE[15]}, 0}};
+  {effects::Particles{{1, 0}, rigel::data::GameTraits::INGAME_PALETTE[15]}, 0},
+});
 
 
-const effects::EffectSpec REACTOR_KILL_EFFECT_SPEC[] = {
+constexpr auto REACTOR_KILL_EFFECT_SPEC = effects::sortedByDelay({
   {effects::SpriteCascade{rigel::data::ActorID::White_circle_flash_FX}, 0},
   {effects::EffectSprite{
      {},
@@ -603,10 +607,10 @@ const effects::EffectSpec REACTOR_KILL_EFFECT_SPEC[] = {
    16},
 
   {effects::RandomExplosionSound{}, 0},
-};
+});
 
 
-const effects::EffectSpec MISSILE_DETONATE_EFFECT_SPEC[] = {
+constexpr auto MISSILE_DETONATE_EFFECT_SPEC = effects::sortedByDelay({
   {effects::RandomExplosionSound{}, 0},
   {effects::EffectSprite{
      {0, -8},
@@ -647,10 +651,10 @@ const effects::EffectSpec MISSILE_DETONATE_EFFECT_SPEC[] = {
      {6, -8},
      rigel::data::ActorID::Missile_debris,
      EffectMovement::FlyRight},
-   3}};
+   3}});
 
 
-const effects::EffectSpec BROKEN_MISSILE_DETONATE_EFFECT_SPEC[] = {
+constexpr auto BROKEN_MISSILE_DETONATE_EFFECT_SPEC = effects::sortedByDelay({
   {effects::RandomExplosionSound{}, 0},
   {effects::EffectSprite{
      {0, 0},
@@ -672,10 +676,10 @@ const effects::EffectSpec BROKEN_MISSILE_DETONATE_EFFECT_SPEC[] = {
      rigel::data::ActorID::Missile_debris,
      EffectMovement::FlyUpperLeft},
    3},
-};
+});
 
 
-const effects::EffectSpec BIG_BOMB_DETONATE_EFFECT_SPEC[] = {
+constexpr auto BIG_BOMB_DETONATE_EFFECT_SPEC = effects::sortedByDelay({
   {effects::EffectSprite{
      {0, 0},
      rigel::data::ActorID::Nuclear_explosion,
@@ -721,19 +725,19 @@ const effects::EffectSpec BIG_BOMB_DETONATE_EFFECT_SPEC[] = {
      rigel::data::ActorID::Nuclear_explosion,
      EffectMovement::None},
    8},
-};
+});
 
 
-const effects::EffectSpec SMALL_BOMB_DETONATE_EFFECT_SPEC[] = {
+constexpr auto SMALL_BOMB_DETONATE_EFFECT_SPEC = effects::sortedByDelay({
   {effects::EffectSprite{
      {0, 0},
      rigel::data::ActorID::Nuclear_explosion,
      EffectMovement::None},
    0},
-};
+});
 
 
-const effects::EffectSpec EXPLOSION_EFFECT_EFFECT_SPEC[] = {
+constexpr auto EXPLOSION_EFFECT_EFFECT_SPEC = effects::sortedByDelay({
   {effects::EffectSprite{
      {0, 0},
      rigel::data::ActorID::Explosion_FX_1,
@@ -749,4 +753,4 @@ const effects::EffectSpec EXPLOSION_EFFECT_EFFECT_SPEC[] = {
      rigel::data::ActorID::Explosion_FX_1,
      EffectMovement::None},
    2},
-};
+});
@@ -34,6 +34,8 @@
 #include "game_logic/ientity_factory.hpp"
 #include "renderer/viewport_utils.hpp"
 
+#include <algorithm>
+
 
 namespace rigel::game_logic
 {
@@ -45,6 +47,8 @@ namespace
 
 constexpr auto GEOMETRY_FALL_SPEED = 2;
 
+constexpr auto WALL_GRID_CELL_SIZE = 16;
+
 const base::Vec2f TILE_DEBRIS_MOVEMENT_SEQUENCE[] = {
   {0.0f, -3.0f},
   {0.0f, -3.0f},
@@ -150,27 +154,9 @@ void explodeMapSection(
 
 void moveTileRows(const base::Rect<int>& mapSection, data::map::Map& map)
 {
-  const auto startX = mapSection.left();
-  const auto startY = mapSection.top();
-  const auto width = mapSection.size.width;
-  const auto height = mapSection.size.height;
-
-  for (int layer = 0; layer < 2; ++layer)
-  {
-    for (int row = 0; row < height; ++row)
-    {
-      for (int col = 0; col < width; ++col)
-      {
-        const auto x = startX + col;
-        const auto sourceY = startY + (height - row - 1);
-        const auto targetY = sourceY + 1;
-
-        map.setTileAt(layer, x, targetY, map.tileAt(layer, x, sourceY));
-      }
-    }
-  }
-
-  map.clearSection(startX, startY, width, 1);
+  map.moveSection(mapSection, mapSection.topLeft + base::Vec2{0, 1});
+  map.clearSection(
+    mapSection.left(), mapSection.top(), mapSection.size.width, 1);
 }
 
 
@@ -377,10 +363,18 @@ DynamicGeometrySystem::DynamicGeometrySystem(
   , mpEvents(pEvents)
   , mpMapRenderer(pMapRenderer)
   , mSimpleDynamicSections(std::move(simpleDynamicSections))
+  , mWallGrid(pMap->width(), pMap->height(), WALL_GRID_CELL_SIZE)
 {
+  mShootableWallGrid.resize(mWallGrid.numCells());
+
   pEvents->subscribe<rigel::events::DoorOpened>(*this);
   pEvents->subscribe<rigel::events::MissileDetonated>(*this);
   pEvents->subscribe<rigel::events::TileBurnedAway>(*this);
+  pEvents->subscribe<entityx::ComponentAddedEvent<components::ShootableWall>>(
+    *this);
+  pEvents
+    ->subscribe<entityx::ComponentRemovedEvent<components::ShootableWall>>(
+      *this);
 }
 
 
@@ -409,43 +403,110 @@ void DynamicGeometrySystem::updateShootableWalls()
           {entity, engine::toWorldSpace(bbox, futurePosition)});
       });
 
+  if (mCollectedProjectiles.empty())
+  {
+    return;
+  }
+
+  if (mShootableWallIndexOutOfDate)
+  {
+    rebuildShootableWallIndex();
+  }
+
+  // Only walls in grid cells overlapping a projectile can be hit. These are
+  // tested in the same order in which going through all walls would visit
+  // them, so that the outcome is the same when a projectile overlaps
+  // multiple walls.
+  mCandidateWalls.clear();
+
+  for (const auto& [projectile, projectileBbox] : mCollectedProjectiles)
+  {
+    const auto cells = mWallGrid.cellsCovering(projectileBbox);
+
+    for (auto y = cells.top(); y <= cells.bottom(); ++y)
+    {
+      for (auto x = cells.left(); x <= cells.right(); ++x)
+      {
+        const auto& cell = mShootableWallGrid[mWallGrid.cellIndex(x, y)];
+        mCandidateWalls.insert(mCandidateWalls.end(), cell.begin(), cell.end());
+      }
+    }
+  }
+
+  const auto byIndex = [](const entityx::Entity a, const entityx::Entity b) {
+    return a.id().index() < b.id().index();
+  };
+  std::sort(mCandidateWalls.begin(), mCandidateWalls.end(), byIndex);
+  mCandidateWalls.erase(
+    std::unique(mCandidateWalls.begin(), mCandidateWalls.end()),
+    mCandidateWalls.end());
+
+  for (auto wall : mCandidateWalls)
+  {
+    const auto bbox = engine::toWorldSpace(
+      *wall.component<BoundingBox>(), *wall.component<WorldPosition>());
+
+    for (auto& [projectile, projectileBbox] : mCollectedProjectiles)
+    {
+      if (projectile && bbox.intersects(projectileBbox))
+      {
+        const auto mapSection =
+          wall.component<DynamicGeometrySection>()->mLinkedGeometrySection;
+        explodeMapSection(
+          mapSection, *mpMap, *mpEntityManager, *mpEvents, *mpRandomGenerator);
+        updateExtraSectionsIntersecting(mapSection);
+        mpServiceProvider->playSound(data::SoundId::BigExplosion);
+        mpEvents->emit(rigel::events::ScreenFlash{});
+
+        projectile.destroy();
+        wall.destroy();
+        break;
+      }
+    }
+  }
+}
+
+
+void DynamicGeometrySystem::rebuildShootableWallIndex()
+{
+  using engine::components::BoundingBox;
+  using engine::components::WorldPosition;
+  using game_logic::components::ShootableWall;
+
+  for (auto& cell : mShootableWallGrid)
+  {
+    cell.clear();
+  }
+
   mpEntityManager
     ->each<ShootableWall, DynamicGeometrySection, WorldPosition, BoundingBox>(
       [&](
         entityx::Entity entity,
         const ShootableWall&,
-        const DynamicGeometrySection& geometrySection,
+        const DynamicGeometrySection&,
         const WorldPosition& position,
         const BoundingBox& localBbox) {
-        const auto bbox = engine::toWorldSpace(localBbox, position);
+        const auto cells =
+          mWallGrid.cellsCovering(engine::toWorldSpace(localBbox, position));
 
-        for (auto& [projectile, projectileBbox] : mCollectedProjectiles)
+        for (auto y = cells.top(); y <= cells.bottom(); ++y)
         {
-          if (projectile && bbox.intersects(projectileBbox))
+          for (auto x = cells.left(); x <= cells.right(); ++x)
           {
-            const auto& mapSection = geometrySection.mLinkedGeometrySection;
-            explodeMapSection(
-              mapSection,
-              *mpMap,
-              *mpEntityManager,
-              *mpEvents,
-              *mpRandomGenerator);
-            updateExtraSectionsIntersecting(mapSection);
-            mpServiceProvider->playSound(data::SoundId::BigExplosion);
-            mpEvents->emit(rigel::events::ScreenFlash{});
-
-            projectile.destroy();
-            entity.destroy();
-            break;
+            mShootableWallGrid[mWallGrid.cellIndex(x, y)].push_back(entity);
           }
         }
       });
+
+  mShootableWallIndexOutOfDate = false;
 }
 
 
 void DynamicGeometrySystem::initializeDynamicGeometryEntities(
   const std::vector<FallingSectionInfo>& fallingSections)
 {
+  rebuildShootableWallIndex();
+
   auto iFallingSectionInfo = fallingSections.begin();
 
   // Entities for the level have already been created, so we now have one
@@ -533,6 +594,22 @@ void DynamicGeometrySystem::receive(const rigel::events::TileBurnedAway& event)
 }
 
 
+void DynamicGeometrySystem::receive(
+  const entityx::ComponentAddedEvent<components::ShootableWall>&)
+{
+  // The wall's bounding box might not have been assigned yet, so the index
+  // is rebuilt on next use instead of adding the wall right away.
+  mShootableWallIndexOutOfDate = true;
+}
+
+
+void DynamicGeometrySystem::receive(
+  const entityx::ComponentRemovedEvent<components::ShootableWall>&)
+{
+  mShootableWallIndexOutOfDate = true;
+}
+
+
 void DynamicGeometrySystem::renderDynamicBackgroundSections(
   const base::Vec2& sectionStart,
   const base::Size& sectionSize,
@@ -569,14 +646,20 @@ void DynamicGeometrySystem::renderDynamicSections(
 
   const auto screenRect = base::Rect<int>{sectionStart, sectionSize};
 
+  auto& stats = mSectionStatistics[static_cast<int>(drawMode)];
+  stats = {};
+
   // Simple dynamic sections (burning tiles or destroyed by missile)
   for (const auto& section : mSimpleDynamicSections)
   {
     if (!screenRect.intersects(section))
     {
+      ++stats.mCulledSections;
       continue;
     }
 
+    ++stats.mDrawnSections;
+
     const auto pixelPos = data::tilesToPixels(section.topLeft - sectionStart);
 
     mpMapRenderer->renderDynamicSection(*mpMap, section, pixelPos, drawMode);
@@ -600,6 +683,8 @@ void DynamicGeometrySystem::renderDynamicSections(
         (dynamic.mPreviousHeight > 0 &&
          dynamic.mLinkedGeometrySection.size.height == 0))
       {
+        ++stats.mDrawnSections;
+
         const auto heightDecrease =
           dynamic.mPreviousHeight - dynamic.mLinkedGeometrySection.size.height;
         const auto interpolatedHeightDecrease =
@@ -643,6 +728,10 @@ void DynamicGeometrySystem::renderDynamicSections(
             drawMode);
         }
       }
+      else
+      {
+        ++stats.mCulledSections;
+      }
 
       // If there are non-zero tiles below the falling piece of geometry, we
       // also need to render them separately since these tiles disappear as the
@@ -690,6 +779,15 @@ void DynamicGeometrySystem::renderDynamicSections(
 }
 
 
+auto DynamicGeometrySystem::sectionStatistics() const -> SectionStatistics
+{
+  return {
+    mSectionStatistics[0].mDrawnSections + mSectionStatistics[1].mDrawnSections,
+    mSectionStatistics[0].mCulledSections +
+      mSectionStatistics[1].mCulledSections};
+}
+
+
 void DynamicGeometrySystem::updateExtraSectionsIntersecting(
   const base::Rect<int>& section)
 {
@@ -16,6 +16,7 @@
 
 #pragma once
 
+#include "base/grid_layout.hpp"
 #include "base/spatial_types.hpp"
 #include "base/warnings.hpp"
 #include "data/map.hpp"
@@ -26,6 +27,7 @@ RIGEL_DISABLE_WARNINGS
 #include <entityx/entityx.h>
 RIGEL_RESTORE_WARNINGS
 
+#include <array>
 #include <vector>
 
 
@@ -48,6 +50,10 @@ namespace game_logic::events
 {
 struct ShootableKilled;
 }
+namespace game_logic::components
+{
+struct ShootableWall;
+}
 } // namespace rigel
 
 
@@ -96,6 +102,16 @@ public:
   void receive(const rigel::events::DoorOpened& event);
   void receive(const rigel::events::MissileDetonated& event);
   void receive(const rigel::events::TileBurnedAway& event);
+  void receive(
+    const entityx::ComponentAddedEvent<components::ShootableWall>& event);
+  void receive(
+    const entityx::ComponentRemovedEvent<components::ShootableWall>& event);
+
+  struct SectionStatistics
+  {
+    int mDrawnSections = 0;
+    int mCulledSections = 0;
+  };
 
   void renderDynamicBackgroundSections(
     const base::Vec2& sectionStart,
@@ -106,6 +122,11 @@ public:
     const base::Size& sectionSize,
     float interpolationFactor);
 
+  /** Number of dynamic sections drawn/skipped as off-screen by the last
+   * background and foreground render calls, combined.
+   */
+  SectionStatistics sectionStatistics() const;
+
 private:
   void renderDynamicSections(
     const base::Vec2& sectionStart,
@@ -113,6 +134,7 @@ private:
     float interpolationFactor,
     engine::MapRenderer::DrawMode drawMode);
   void updateExtraSectionsIntersecting(const base::Rect<int>& section);
+  void rebuildShootableWallIndex();
 
   renderer::Renderer* mpRenderer;
   IGameServiceProvider* mpServiceProvider;
@@ -124,6 +146,15 @@ private:
   std::vector<base::Rect<int>> mSimpleDynamicSections;
   std::vector<std::tuple<entityx::Entity, engine::components::BoundingBox>>
     mCollectedProjectiles;
+
+  // Shootable walls never move, so they are kept in a uniform grid which is
+  // only rebuilt when walls are added or removed. Each wall is entered into
+  // all cells its bounding box overlaps.
+  base::GridLayout mWallGrid;
+  std::vector<std::vector<entityx::Entity>> mShootableWallGrid;
+  std::vector<entityx::Entity> mCandidateWalls;
+  bool mShootableWallIndexOutOfDate = true;
+  std::array<SectionStatistics, 2> mSectionStatistics;
 };
 
 } // namespace rigel::game_logic
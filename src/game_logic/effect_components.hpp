@@ -28,8 +28,13 @@ RIGEL_DISABLE_WARNINGS
 #include <entityx/entityx.h>
 RIGEL_RESTORE_WARNINGS
 
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cstddef>
 #include <cstdint>
 #include <optional>
+#include <utility>
 #include <variant>
 
 
@@ -60,7 +65,7 @@ struct RandomExplosionSound
 
 struct Particles
 {
-  Particles(
+  constexpr Particles(
     const base::Vec2& offset,
     const base::Color& color,
     const int velocityScaleX = 0)
@@ -70,7 +75,9 @@ struct Particles
   {
   }
 
-  explicit Particles(const base::Vec2& offset, const int velocityScaleX = 0)
+  constexpr explicit Particles(
+    const base::Vec2& offset,
+    const int velocityScaleX = 0)
     : mOffset(offset)
     , mVelocityScaleX(velocityScaleX)
   {
@@ -131,6 +138,52 @@ struct EffectSpec
   int mDelay;
 };
 
+
+namespace detail
+{
+
+template <std::size_t N, std::size_t... Indices>
+constexpr std::array<EffectSpec, N> sortedByDelay(
+  const EffectSpec (&specs)[N],
+  std::index_sequence<Indices...>)
+{
+  // Stable counting of each spec's sorted position. std::variant can't be
+  // assigned in a constant expression, so we determine the order first and
+  // then copy-construct the result in one go.
+  std::array<std::size_t, N> order{};
+  for (auto i = std::size_t{0}; i < N; ++i)
+  {
+    auto position = std::size_t{0};
+    for (auto j = std::size_t{0}; j < N; ++j)
+    {
+      if (
+        specs[j].mDelay < specs[i].mDelay ||
+        (specs[j].mDelay == specs[i].mDelay && j < i))
+      {
+        ++position;
+      }
+    }
+
+    order[position] = i;
+  }
+
+  return {{specs[order[Indices]]...}};
+}
+
+} // namespace detail
+
+
+/** Create a list of effect specs, sorted by delay at compile time
+ *
+ * Specs with the same delay keep their relative order. EffectsSystem relies
+ * on the sorting to only look at the specs which are due in each frame.
+ */
+template <std::size_t N>
+constexpr std::array<EffectSpec, N> sortedByDelay(const EffectSpec (&specs)[N])
+{
+  return detail::sortedByDelay(specs, std::make_index_sequence<N>{});
+}
+
 } // namespace effects
 
 namespace components
@@ -156,12 +209,20 @@ struct DestructionEffects
     , mTriggerCondition(condition)
     , mCascadePlacementBox(cascadePlacementBox)
   {
+    assert(std::is_sorted(
+      mEffectSpecs.begin(),
+      mEffectSpecs.end(),
+      [](const effects::EffectSpec& a, const effects::EffectSpec& b) {
+        return a.mDelay < b.mDelay;
+      }));
   }
 
+  /** Must be sorted by delay, see effects::sortedByDelay() */
   EffectSpecList mEffectSpecs;
   TriggerCondition mTriggerCondition;
   std::optional<engine::components::BoundingBox> mCascadePlacementBox;
   int mFramesElapsed = 0;
+  int mNextSpecIndex = 0;
   bool mActivated = false;
 };
 
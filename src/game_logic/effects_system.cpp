@@ -69,11 +69,8 @@ void spawnEffects(
   effectSpawner.assign<WorldPosition>(position);
   effectSpawner.component<DestructionEffects>()->mActivated = true;
 
-  const auto iHighestDelaySpec = std::max_element(
-    std::begin(effects.mEffectSpecs),
-    std::end(effects.mEffectSpecs),
-    [](const auto& a, const auto& b) { return a.mDelay < b.mDelay; });
-  const auto timeToLive = iHighestDelaySpec->mDelay;
+  // Specs are sorted by delay, so the last one is the last to be spawned
+  const auto timeToLive = effects.mEffectSpecs.back().mDelay;
   effectSpawner.assign<AutoDestroy>(AutoDestroy::afterTimeout(timeToLive));
 }
 
@@ -170,9 +167,17 @@ void EffectsSystem::processEffectsAndAdvance(
   using namespace engine::components;
   using namespace engine::components::parameter_aliases;
 
-  for (auto& spec : effects.mEffectSpecs)
+  const auto& specs = effects.mEffectSpecs;
+
+  for (; effects.mNextSpecIndex < int(specs.size()); ++effects.mNextSpecIndex)
   {
-    if (effects.mFramesElapsed != spec.mDelay)
+    const auto& spec = specs[effects.mNextSpecIndex];
+    if (spec.mDelay > effects.mFramesElapsed)
+    {
+      break;
+    }
+
+    if (spec.mDelay < effects.mFramesElapsed)
     {
       continue;
     }
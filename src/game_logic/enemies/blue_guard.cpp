@@ -21,6 +21,7 @@
 #include "engine/random_number_generator.hpp"
 #include "engine/sprite_tools.hpp"
 #include "engine/visual_components.hpp"
+#include "game_logic/behavior_controller.hpp"
 #include "frontend/game_service_provider.hpp"
 #include "game_logic/global_dependencies.hpp"
 #include "game_logic/ientity_factory.hpp"
@@ -99,10 +100,11 @@ void BlueGuard::update(
   GlobalDependencies& d,
   GlobalState& s,
   bool,
-  entityx::Entity entity)
+  entityx::Entity entity,
+  const components::CommonComponents& common)
 {
-  const auto& position = *entity.component<WorldPosition>();
-  auto& sprite = *entity.component<Sprite>();
+  const auto& position = *common.mpPosition;
+  auto& sprite = *common.mpSprite;
 
   auto walkOneStep = [&]() {
     return engine::walk(*d.mpCollisionChecker, entity, mOrientation);
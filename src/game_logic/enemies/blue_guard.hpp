@@ -30,6 +30,11 @@ struct GlobalDependencies;
 struct GlobalState;
 } // namespace rigel::game_logic
 
+namespace rigel::game_logic::components
+{
+struct CommonComponents;
+}
+
 
 namespace rigel::game_logic::behaviors
 {
@@ -54,7 +59,8 @@ struct BlueGuard
     GlobalDependencies& dependencies,
     GlobalState& state,
     bool isOnScreen,
-    entityx::Entity entity);
+    entityx::Entity entity,
+    const components::CommonComponents& common);
 
   void onHit(
     GlobalDependencies& dependencies,
@@ -39,7 +39,7 @@ namespace
 
 using EffectMovement = effects::EffectSprite::Movement;
 
-const effects::EffectSpec BIG_BOMB_DETONATE_IN_AIR_EFFECT_SPEC[] = {
+constexpr auto BIG_BOMB_DETONATE_IN_AIR_EFFECT_SPEC = effects::sortedByDelay({
   {effects::RandomExplosionSound{}, 0},
   {effects::EffectSprite{
      {0, 0},
@@ -86,7 +86,7 @@ const effects::EffectSpec BIG_BOMB_DETONATE_IN_AIR_EFFECT_SPEC[] = {
      data::ActorID::Nuclear_explosion,
      EffectMovement::FlyDown},
    8},
-};
+});
 
 
 constexpr auto FLY_AWAY_SPEED_VECTOR = base::Vec2{2, 1};
@@ -59,13 +59,14 @@ void SlimeContainer::update(
   GlobalDependencies& d,
   GlobalState& s,
   bool,
-  entityx::Entity entity)
+  entityx::Entity entity,
+  const components::CommonComponents& common)
 {
   using namespace engine::components;
   using game_logic::components::BehaviorController;
   using game_logic::components::Shootable;
 
-  auto& sprite = *entity.component<Sprite>();
+  auto& sprite = *common.mpSprite;
 
   const auto stillIntact = entity.has_component<Shootable>();
   if (stillIntact)
@@ -81,7 +82,7 @@ void SlimeContainer::update(
 
     if (mBreakAnimationStep >= NUM_BREAK_ANIMATION_STEPS)
     {
-      const auto& position = *entity.component<WorldPosition>();
+      const auto& position = *common.mpPosition;
       d.mpEntityFactory->spawnActor(
         data::ActorID::Green_slime_blob, position + SLIME_BLOB_SPAWN_OFFSET);
 
@@ -111,7 +112,8 @@ void SlimeBlob::update(
   GlobalDependencies& d,
   GlobalState& s,
   bool,
-  entityx::Entity entity)
+  entityx::Entity entity,
+  const components::CommonComponents& common)
 {
   using namespace engine::components;
   using namespace engine::orientation;
@@ -122,9 +124,9 @@ void SlimeBlob::update(
 
 
   const auto& playerPosition = s.mpPlayer->orientedPosition();
-  const auto& bbox = *entity.component<BoundingBox>();
-  auto& position = *entity.component<WorldPosition>();
-  auto& sprite = *entity.component<engine::components::Sprite>();
+  const auto& bbox = *common.mpBoundingBox;
+  auto& position = *common.mpPosition;
+  auto& sprite = *common.mpSprite;
 
   base::match(
     mState,
@@ -32,6 +32,11 @@ struct GlobalDependencies;
 struct GlobalState;
 } // namespace rigel::game_logic
 
+namespace rigel::game_logic::components
+{
+struct CommonComponents;
+}
+
 
 namespace rigel::game_logic::behaviors
 {
@@ -42,7 +47,8 @@ struct SlimeContainer
     GlobalDependencies& dependencies,
     GlobalState& state,
     bool isOnScreen,
-    entityx::Entity entity);
+    entityx::Entity entity,
+    const components::CommonComponents& common);
 
   void onKilled(
     GlobalDependencies& dependencies,
@@ -60,7 +66,8 @@ struct SlimeBlob
     GlobalDependencies& dependencies,
     GlobalState& state,
     bool isOnScreen,
-    entityx::Entity entity);
+    entityx::Entity entity,
+    const components::CommonComponents& common);
 
   struct OnGround
   {
@@ -23,6 +23,7 @@
 #include "engine/physics.hpp"
 #include "engine/random_number_generator.hpp"
 #include "engine/visual_components.hpp"
+#include "game_logic/behavior_controller.hpp"
 #include "game_logic/damage_components.hpp"
 #include "game_logic/ientity_factory.hpp"
 
@@ -114,11 +115,12 @@ void Spider::update(
   GlobalDependencies& d,
   GlobalState& s,
   bool isOnScreen,
-  entityx::Entity entity)
+  entityx::Entity entity,
+  const components::CommonComponents& common)
 {
-  auto& position = *entity.component<WorldPosition>();
-  const auto& bbox = *entity.component<BoundingBox>();
-  auto& sprite = *entity.component<Sprite>();
+  auto& position = *common.mpPosition;
+  const auto& bbox = *common.mpBoundingBox;
+  auto& sprite = *common.mpSprite;
   const auto& playerPosition = s.mpPlayer->orientedPosition();
   const auto playerOrientation = s.mpPlayer->orientation();
 
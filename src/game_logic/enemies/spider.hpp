@@ -34,6 +34,11 @@ struct GlobalDependencies;
 struct GlobalState;
 } // namespace rigel::game_logic
 
+namespace rigel::game_logic::components
+{
+struct CommonComponents;
+}
+
 
 namespace rigel::game_logic::behaviors
 {
@@ -44,7 +49,8 @@ struct Spider
     GlobalDependencies& dependencies,
     GlobalState& state,
     bool isOnScreen,
-    entityx::Entity entity);
+    entityx::Entity entity,
+    const components::CommonComponents& common);
 
   void walkOnFloor(entityx::Entity entity);
 
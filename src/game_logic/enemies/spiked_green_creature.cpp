@@ -40,7 +40,7 @@ namespace
 
 using EffectMovement = effects::EffectSprite::Movement;
 
-const effects::EffectSpec SHELL_BURST_FX_LEFT[] = {
+constexpr auto SHELL_BURST_FX_LEFT = effects::sortedByDelay({
   {effects::EffectSprite{
      {0, -2},
      data::ActorID::Spiked_green_creature_stone_debris_1_LEFT,
@@ -61,10 +61,10 @@ const effects::EffectSpec SHELL_BURST_FX_LEFT[] = {
      data::ActorID::Spiked_green_creature_stone_debris_4_LEFT,
      EffectMovement::FlyUpperRight},
    0},
-};
+});
 
 
-const effects::EffectSpec SHELL_BURST_FX_RIGHT[] = {
+constexpr auto SHELL_BURST_FX_RIGHT = effects::sortedByDelay({
   {effects::EffectSprite{
      {0, -2},
      data::ActorID::Spiked_green_creature_stone_debris_1_RIGHT,
@@ -85,7 +85,7 @@ const effects::EffectSpec SHELL_BURST_FX_RIGHT[] = {
      data::ActorID::Spiked_green_creature_stone_debris_4_RIGHT,
      EffectMovement::FlyRight},
    0},
-};
+});
 
 
 const int POUNCE_ANIM_SEQ[] = {3, 3, 4, 4, 4, 5};
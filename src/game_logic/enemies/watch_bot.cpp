@@ -41,10 +41,10 @@ namespace
 constexpr auto CONTAINER_OFFSET = base::Vec2{0, -2};
 
 
-const effects::EffectSpec CARRIER_SELF_DESTRUCT_EFFECT_SPEC[] = {
+constexpr auto CARRIER_SELF_DESTRUCT_EFFECT_SPEC = effects::sortedByDelay({
   {effects::RandomExplosionSound{}, 0},
   {effects::SpriteCascade{data::ActorID::Shot_impact_FX}, 0},
-};
+});
 
 
 // clang-format off
@@ -77,17 +77,18 @@ void WatchBot::update(
   GlobalDependencies& d,
   GlobalState& s,
   const bool isOnScreen,
-  entityx::Entity entity)
+  entityx::Entity entity,
+  const components::CommonComponents& common)
 {
   using namespace engine;
   using namespace engine::components;
 
-  auto& position = *entity.component<WorldPosition>();
-  const auto& bbox = *entity.component<BoundingBox>();
+  auto& position = *common.mpPosition;
+  const auto& bbox = *common.mpBoundingBox;
   const auto& playerPos = s.mpPlayer->orientedPosition();
 
-  auto& animationFrame = entity.component<Sprite>()->mFramesToRender[0];
-  auto& movingBody = *entity.component<MovingBody>();
+  auto& animationFrame = common.mpSprite->mFramesToRender[0];
+  auto& movingBody = *common.mpMovingBody;
 
 
   base::match(
@@ -184,14 +185,16 @@ void WatchBotCarrier::update(
   GlobalDependencies& d,
   GlobalState& s,
   const bool isOnScreen,
-  entityx::Entity entity)
+  entityx::Entity entity,
+  const components::CommonComponents& common)
 {
   using namespace engine::components;
 
-  const auto& position = *entity.component<WorldPosition>();
+  const auto& position = *common.mpPosition;
   const auto& playerPos = s.mpPlayer->position();
 
-  auto& animationFrame = entity.component<Sprite>()->mFramesToRender[0];
+  auto& sprite = *common.mpSprite;
+  auto& animationFrame = sprite.mFramesToRender[0];
 
   auto playerInRange = [&]() {
     return std::abs(playerPos.x - position.x) <= 5;
@@ -209,7 +212,7 @@ void WatchBotCarrier::update(
   auto releasePayload = [&, this]() {
     d.mpEntityFactory->spawnActor(
       data::ActorID::Watchbot_container, position + CONTAINER_OFFSET);
-    entity.component<Sprite>()->mFramesToRender[1] = engine::IGNORE_RENDER_SLOT;
+    sprite.mFramesToRender[1] = engine::IGNORE_RENDER_SLOT;
   };
 
   auto explode = [&]() {
@@ -280,12 +283,13 @@ void WatchBotContainer::update(
   GlobalDependencies& d,
   GlobalState& s,
   const bool isOnScreen,
-  entityx::Entity entity)
+  entityx::Entity entity,
+  const components::CommonComponents& common)
 {
   using namespace engine::components;
 
-  const auto& position = *entity.component<WorldPosition>();
-  auto& sprite = *entity.component<Sprite>();
+  const auto& position = *common.mpPosition;
+  auto& sprite = *common.mpSprite;
 
 
   if (mFramesElapsed < 10)
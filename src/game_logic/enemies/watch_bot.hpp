@@ -26,6 +26,11 @@ namespace rigel::engine::events
 struct CollidedWithWorld;
 }
 
+namespace rigel::game_logic::components
+{
+struct CommonComponents;
+}
+
 
 namespace rigel::game_logic::behaviors
 {
@@ -73,7 +78,8 @@ struct WatchBot
     GlobalDependencies& dependencies,
     GlobalState& state,
     bool isOnScreen,
-    entityx::Entity entity);
+    entityx::Entity entity,
+    const components::CommonComponents& common);
 
   State mState = Jumping{};
 };
@@ -91,7 +97,8 @@ struct WatchBotCarrier
     GlobalDependencies& dependencies,
     GlobalState& state,
     bool isOnScreen,
-    entityx::Entity entity);
+    entityx::Entity entity,
+    const components::CommonComponents& common);
 
   State mState = State::ApproachingPlayer;
   int mFramesElapsed = 0;
@@ -104,7 +111,8 @@ struct WatchBotContainer
     GlobalDependencies& dependencies,
     GlobalState& state,
     bool isOnScreen,
-    entityx::Entity entity);
+    entityx::Entity entity,
+    const components::CommonComponents& common);
 
   int mFramesElapsed = 0;
 };
@@ -17,6 +17,7 @@
 #include "entity_factory.hpp"
 
 #include "base/container_utils.hpp"
+#include "base/parallel.hpp"
 #include "data/game_options.hpp"
 #include "data/game_traits.hpp"
 #include "data/unit_conversions.hpp"
@@ -83,6 +84,7 @@
 #include "game_logic/player/level_exit_trigger.hpp"
 #include "game_logic/player/ship.hpp"
 
+#include <optional>
 #include <tuple>
 #include <utility>
 
@@ -105,6 +107,16 @@ using namespace game_logic::components;
 namespace
 {
 
+// Everything needed for creating a level actor's entity that doesn't depend
+// on the entity manager, see createEntitiesForLevel()
+struct PreparedActor
+{
+  WorldPosition mPosition;
+  BoundingBox mBoundingBox;
+  std::optional<Sprite> moSprite;
+};
+
+
 // Assign gravity affected moving body component
 template <typename EntityLike>
 void addDefaultMovingBody(EntityLike& entity, const BoundingBox& boundingBox)
@@ -384,8 +396,19 @@ entityx::Entity
 void EntityFactory::createEntitiesForLevel(
   const data::map::ActorDescriptionList& actors)
 {
-  for (const auto& actor : actors)
-  {
+  const auto actorIds = utils::transformed(
+    actors, [](const data::map::LevelData::Actor& actor) { return actor.mID; });
+  mpSpriteFactory->prefetchActors(actorIds);
+
+  // Creating entities and assigning components has to happen serially, and
+  // in the same order as the actor list, since the resulting entity IDs
+  // are part of the game state. Resolving sprites and bounding boxes
+  // doesn't touch the entity manager, so that part runs in parallel first.
+  auto preparedActors = std::vector<PreparedActor>(actors.size());
+  base::parallelFor(actors.size(), [&](const std::size_t i) {
+    const auto& actor = actors[i];
+    auto& prepared = preparedActors[i];
+
     // Difficulty/section markers should never appear in the actor descriptions
     // coming from the loader, as they are handled during pre-processing.
     assert(
@@ -394,37 +417,44 @@ void EntityFactory::createEntitiesForLevel(
       actor.mID != ActorID::META_Dynamic_geometry_marker_1 &&
       actor.mID != ActorID::META_Dynamic_geometry_marker_2);
 
-    auto entity = mpEntityManager->create();
-
-    auto position = actor.mPosition;
+    prepared.mPosition = actor.mPosition;
     if (actor.mAssignedArea)
     {
       // For dynamic geometry, the original position refers to the top-left
       // corner of the assigned area, but it refers to the bottom-left corner
       // for all other entities. Adjust the position here so that it's also
       // bottom-left.
-      position.y += actor.mAssignedArea->size.height - 1;
+      prepared.mPosition.y += actor.mAssignedArea->size.height - 1;
+
+      prepared.mBoundingBox = *actor.mAssignedArea;
+      prepared.mBoundingBox.topLeft = {0, 0};
     }
-    entity.assign<WorldPosition>(position);
+    else if (engine::hasAssociatedSprite(actor.mID))
+    {
+      prepared.moSprite = createSpriteForId(actor.mID);
+      prepared.mBoundingBox = mpSpriteFactory->actorFrameRect(actor.mID, 0);
+    }
+  });
+
+  for (auto i = std::size_t{0}; i < actors.size(); ++i)
+  {
+    const auto& actor = actors[i];
+    const auto& prepared = preparedActors[i];
+
+    auto entity = mpEntityManager->create();
+    entity.assign<WorldPosition>(prepared.mPosition);
 
-    BoundingBox boundingBox;
     if (actor.mAssignedArea)
     {
-      const auto mapSectionRect = *actor.mAssignedArea;
-      entity.assign<DynamicGeometrySection>(mapSectionRect);
+      entity.assign<DynamicGeometrySection>(*actor.mAssignedArea);
       engine::enableInterpolation(entity);
-
-      boundingBox = mapSectionRect;
-      boundingBox.topLeft = {0, 0};
     }
-    else if (engine::hasAssociatedSprite(actor.mID))
+    else if (prepared.moSprite)
     {
-      const auto sprite = createSpriteForId(actor.mID);
-      boundingBox = mpSpriteFactory->actorFrameRect(actor.mID, 0);
-      entity.assign<Sprite>(sprite);
+      entity.assign<Sprite>(*prepared.moSprite);
     }
 
-    configureEntity(entity, actor.mID, boundingBox);
+    configureEntity(entity, actor.mID, prepared.mBoundingBox);
   }
 }
 
@@ -16,9 +16,12 @@
 
 #include "game_world.hpp"
 
+#include "assets/level_loader.hpp"
 #include "assets/resource_loader.hpp"
 #include "base/match.hpp"
 #include "base/spatial_types_printing.hpp"
+#include "base/tick_profiler.hpp"
+#include "base/tracing.hpp"
 #include "data/game_options.hpp"
 #include "data/game_traits.hpp"
 #include "data/map.hpp"
@@ -35,6 +38,7 @@
 #include "game_logic/actor_tag.hpp"
 #include "game_logic/behavior_controller.hpp"
 #include "game_logic/collectable_components.hpp"
+#include "game_logic/damage_components.hpp"
 #include "game_logic/dynamic_geometry_components.hpp"
 #include "game_logic/enemies/dying_boss.hpp"
 #include "game_logic/world_state.hpp"
@@ -124,33 +128,6 @@ auto viewportSizeWideScreen(
 }
 
 
-std::vector<base::Vec2> collectRadarDots(
-  entityx::EntityManager& entities,
-  const base::Vec2& playerPosition)
-{
-  using engine::components::Active;
-  using engine::components::WorldPosition;
-  using game_logic::components::AppearsOnRadar;
-
-  std::vector<base::Vec2> radarDots;
-
-  entities.each<WorldPosition, AppearsOnRadar, Active>(
-    [&](
-      entityx::Entity,
-      const WorldPosition& position,
-      const AppearsOnRadar&,
-      const Active&) {
-      const auto positionRelativeToPlayer = position - playerPosition;
-      if (ui::isVisibleOnRadar(positionRelativeToPlayer))
-      {
-        radarDots.push_back(positionRelativeToPlayer);
-      }
-    });
-
-  return radarDots;
-}
-
-
 std::vector<engine::WaterEffectArea> collectWaterEffectAreas(
   entityx::EntityManager& es,
   const base::Vec2& cameraPosition,
@@ -203,6 +180,36 @@ base::Size clampedSectionSize(
     std::min(sectionSize.height, map.height() - sectionStart.y)};
 }
 
+
+// entityx keeps a slot for every entity in each component pool, regardless
+// of whether the entity has that component. This is a rough average over
+// the components used by the game.
+constexpr auto ESTIMATED_BYTES_PER_ENTITY = std::size_t{512};
+
+
+std::size_t estimateMemoryUsage(const WorldState& state)
+{
+  const auto numTiles =
+    std::size_t(state.mMap.width()) * std::size_t(state.mMap.height());
+
+  return sizeof(WorldState) + numTiles * 2 * sizeof(data::map::TileIndex) +
+    state.mEntities.capacity() * ESTIMATED_BYTES_PER_ENTITY;
+}
+
+
+std::size_t estimateMemoryUsage(const data::map::LevelData& level)
+{
+  const auto numTiles =
+    std::size_t(level.mMap.width()) * std::size_t(level.mMap.height());
+  const auto numPixels =
+    level.mTileSetImage.width() * level.mTileSetImage.height();
+
+  return sizeof(data::map::LevelData) +
+    numTiles * 2 * sizeof(data::map::TileIndex) +
+    numPixels * sizeof(data::Pixel) +
+    level.mActors.size() * sizeof(data::map::LevelData::Actor);
+}
+
 } // namespace
 
 
@@ -212,7 +219,8 @@ GameWorld::GameWorld(
   GameMode::Context context,
   std::optional<base::Vec2> playerPositionOverride,
   bool showWelcomeMessage,
-  const PlayerInput& initialInput)
+  const PlayerInput& initialInput,
+  std::optional<data::map::LevelData> preloadedLevel)
   : mpRenderer(context.mpRenderer)
   , mpServiceProvider(context.mpServiceProvider)
   , mUiSpriteSheet(
@@ -247,12 +255,11 @@ GameWorld::GameWorld(
   , mPreviousWindowSize(mpRenderer->windowSize())
   , mPreviousHudStyle(mpOptions->mWidescreenHudStyle)
   , mWidescreenModeWasOn(widescreenModeOn())
-  , mPerElementUpscalingWasEnabled(mpOptions->mPerElementUpscalingEnabled)
   , mMotionSmoothingWasEnabled(mpOptions->mMotionSmoothing)
 {
   LOG_SCOPE_FUNCTION(INFO);
 
-  loadLevel(initialInput);
+  loadLevel(initialInput, std::move(preloadedLevel));
 
   if (playerPositionOverride)
   {
@@ -380,13 +387,14 @@ void GameWorld::receive(const rigel::events::HintMachineMessage& event)
 }
 
 
-void GameWorld::receive(const rigel::events::PlayerDied& event)
+void GameWorld::receive(const std::vector<rigel::events::PlayerDied>& events)
 {
   mpState->mPlayerDied = true;
 }
 
 
-void GameWorld::receive(const rigel::events::PlayerTookDamage& event)
+void GameWorld::receive(
+  const std::vector<rigel::events::PlayerTookDamage>& events)
 {
   mpState->mBonusInfo.mPlayerTookDamage = true;
 }
@@ -398,9 +406,10 @@ void GameWorld::receive(const rigel::events::PlayerMessage& event)
 }
 
 
-void GameWorld::receive(const rigel::events::PlayerTeleported& event)
+void GameWorld::receive(
+  const std::vector<rigel::events::PlayerTeleported>& events)
 {
-  mpState->mTeleportTargetPosition = event.mNewPosition;
+  mpState->mTeleportTargetPosition = events.back().mNewPosition;
 }
 
 
@@ -410,9 +419,9 @@ void GameWorld::receive(const rigel::events::ScreenFlash& event)
 }
 
 
-void GameWorld::receive(const rigel::events::ScreenShake& event)
+void GameWorld::receive(const std::vector<rigel::events::ScreenShake>& events)
 {
-  mpState->mScreenShakeOffsetX = event.mAmount;
+  mpState->mScreenShakeOffsetX = events.back().mAmount;
 }
 
 
@@ -481,10 +490,17 @@ void GameWorld::receive(const rigel::events::CloakExpired&)
 }
 
 
-void GameWorld::loadLevel(const PlayerInput& initialInput)
+void GameWorld::loadLevel(
+  const PlayerInput& initialInput,
+  std::optional<data::map::LevelData> preloadedLevel)
 {
-  createNewState();
+  createNewStates(std::move(preloadedLevel));
+  startLevel(initialInput);
+}
+
 
+void GameWorld::startLevel(const PlayerInput& initialInput)
+{
   mpState->mCamera.centerViewOnPlayer();
   updateGameLogic(initialInput);
   mpState->mPreviousCameraPosition = mpState->mCamera.position();
@@ -500,23 +516,55 @@ void GameWorld::loadLevel(const PlayerInput& initialInput)
 }
 
 
-void GameWorld::createNewState()
+void GameWorld::createNewStates(
+  std::optional<data::map::LevelData> preloadedLevel)
 {
-  if (mpState)
-  {
-    unsubscribe(mpState->mEventManager);
-  }
+  auto level = preloadedLevel
+    ? std::move(*preloadedLevel)
+    : assets::loadLevel(
+        assets::levelFileName(mSessionId.mEpisode, mSessionId.mLevel),
+        *mpResources,
+        mSessionId.mDifficulty);
+
+  // Most levels are finished without ever restarting them, so the level
+  // start state is only created on the first restart. Until then, we keep
+  // the level data needed to create it. The level start state is never
+  // rendered, so it gets placeholders instead of copies of the backdrop
+  // images. The tile set is still needed, since the map geometry is shared
+  // between both states.
+  mpLevelStartState.reset();
+  mLevelStartData = data::map::LevelData{
+    level.mTileSetImage,
+    data::Image{1, 1},
+    std::nullopt,
+    level.mMap,
+    level.mActors,
+    level.mPlayerSpawnPosition,
+    level.mPlayerFacingLeft,
+    level.mBackdropScrollMode,
+    level.mBackdropSwitchCondition,
+    level.mEarthquake,
+    level.mMusicFile};
+  mLevelStartStateMemory.set(estimateMemoryUsage(*mLevelStartData));
+
+  mpState = createState(std::move(level));
+
+  subscribe(mpState->mEventManager);
+}
 
-  mpState = std::make_unique<WorldState>(
+
+std::unique_ptr<WorldState>
+  GameWorld::createState(data::map::LevelData&& level) const
+{
+  return std::make_unique<WorldState>(
     mpServiceProvider,
     mpRenderer,
     mpResources,
     mpPersistentPlayerState,
     mpOptions,
     mpSpriteFactory,
-    mSessionId);
-
-  subscribe(mpState->mEventManager);
+    mSessionId,
+    std::move(level));
 }
 
 
@@ -525,18 +573,15 @@ void GameWorld::subscribe(entityx::EventManager& eventManager)
   eventManager.subscribe<rigel::events::CheckPointActivated>(*this);
   eventManager.subscribe<rigel::events::ExitReached>(*this);
   eventManager.subscribe<rigel::events::HintMachineMessage>(*this);
-  eventManager.subscribe<rigel::events::PlayerDied>(*this);
-  eventManager.subscribe<rigel::events::PlayerTookDamage>(*this);
   eventManager.subscribe<rigel::events::PlayerMessage>(*this);
-  eventManager.subscribe<rigel::events::PlayerTeleported>(*this);
   eventManager.subscribe<rigel::events::ScreenFlash>(*this);
-  eventManager.subscribe<rigel::events::ScreenShake>(*this);
   eventManager.subscribe<rigel::events::TutorialMessage>(*this);
   eventManager.subscribe<rigel::game_logic::events::ShootableKilled>(*this);
   eventManager.subscribe<rigel::events::BossActivated>(*this);
   eventManager.subscribe<rigel::events::BossDestroyed>(*this);
   eventManager.subscribe<rigel::events::CloakPickedUp>(*this);
   eventManager.subscribe<rigel::events::CloakExpired>(*this);
+  mDeferredEvents.subscribe(eventManager);
 }
 
 
@@ -545,18 +590,15 @@ void GameWorld::unsubscribe(entityx::EventManager& eventManager)
   eventManager.unsubscribe<rigel::events::CheckPointActivated>(*this);
   eventManager.unsubscribe<rigel::events::ExitReached>(*this);
   eventManager.unsubscribe<rigel::events::HintMachineMessage>(*this);
-  eventManager.unsubscribe<rigel::events::PlayerDied>(*this);
-  eventManager.unsubscribe<rigel::events::PlayerTookDamage>(*this);
   eventManager.unsubscribe<rigel::events::PlayerMessage>(*this);
-  eventManager.unsubscribe<rigel::events::PlayerTeleported>(*this);
   eventManager.unsubscribe<rigel::events::ScreenFlash>(*this);
-  eventManager.unsubscribe<rigel::events::ScreenShake>(*this);
   eventManager.unsubscribe<rigel::events::TutorialMessage>(*this);
   eventManager.unsubscribe<rigel::game_logic::events::ShootableKilled>(*this);
   eventManager.unsubscribe<rigel::events::BossActivated>(*this);
   eventManager.unsubscribe<rigel::events::BossDestroyed>(*this);
   eventManager.unsubscribe<rigel::events::CloakPickedUp>(*this);
   eventManager.unsubscribe<rigel::events::CloakExpired>(*this);
+  mDeferredEvents.unsubscribe(eventManager);
 }
 
 
@@ -612,62 +654,91 @@ void GameWorld::updateGameLogic(const PlayerInput& input)
 
   mpState->mPlayerInteractionSystem.updatePlayerInteraction(
     input, mpState->mEntities);
-  mpState->mPlayer.update(input);
+  RIGEL_PROFILE_CALL("Player", mpState->mPlayer.update(input));
   mpState->mPreviousCameraPosition = mpState->mCamera.position();
   mpState->mCamera.update(input, viewportSize);
 
   mpState->mDynamicGeometrySystem.updateShootableWalls();
 
   engine::markActiveEntities(
-    mpState->mEntities, mpState->mCamera.position(), viewportSize);
-  mpState->mBehaviorControllerSystem.update(
     mpState->mEntities,
-    PerFrameState{
-      input,
-      viewportSize,
-      mpState->mRadarDishCounter.numRadarDishes(),
-      mpState->mIsOddFrame,
-      mpState->mEarthQuakeEffect && mpState->mEarthQuakeEffect->isQuaking()});
+    mpState->mCamera.position(),
+    viewportSize,
+    &mpState->mActiveEntities);
+  RIGEL_PROFILE_CALL(
+    "Behavior controllers",
+    mpState->mBehaviorControllerSystem.update(
+      mpState->mEntities,
+      PerFrameState{
+        input,
+        viewportSize,
+        mpState->mRadarDishCounter.numRadarDishes(),
+        mpState->mIsOddFrame,
+        mpState->mEarthQuakeEffect &&
+          mpState->mEarthQuakeEffect->isQuaking()}));
 
-  mpState->mPhysicsSystem.updatePhase1(mpState->mEntities);
+  RIGEL_PROFILE_CALL(
+    "Physics", mpState->mPhysicsSystem.updatePhase1(mpState->mEntities));
 
   // Collect items after physics, so that any collectible
   // items are in their final positions for this frame.
   mpState->mItemContainerSystem.updateItemBounce(mpState->mEntities);
-  mpState->mPlayerInteractionSystem.updateItemCollection(mpState->mEntities);
-  mpState->mPlayerDamageSystem.update(mpState->mEntities);
-  mpState->mDamageInflictionSystem.update(mpState->mEntities);
-  mpState->mItemContainerSystem.update(mpState->mEntities);
-  mpState->mPlayerProjectileSystem.update(mpState->mEntities);
 
-  mpState->mEffectsSystem.update(mpState->mEntities);
-  mpState->mLifeTimeSystem.update(
-    mpState->mEntities, mpState->mCamera.position(), viewportSize);
+  // Item collection and damage checks all query the spatial index, so it
+  // needs to be rebuilt once everything is in its final position.
+  RIGEL_PROFILE_CALL(
+    "Spatial index", mpState->mSpatialIndex.build(mpState->mEntities));
+  {
+    RIGEL_PROFILE_SCOPE("Interaction & damage");
+    mpState->mPlayerInteractionSystem.updateItemCollection(
+      mpState->mEntities);
+    mpState->mPlayerDamageSystem.update(mpState->mEntities);
+    mpState->mDamageInflictionSystem.update(mpState->mEntities);
+    mpState->mItemContainerSystem.update(mpState->mEntities);
+    mpState->mPlayerProjectileSystem.update(mpState->mEntities);
+  }
+
+  {
+    RIGEL_PROFILE_SCOPE("Effects");
+    mpState->mEffectsSystem.update(mpState->mEntities);
+    mpState->mLifeTimeSystem.update(
+      mpState->mEntities, mpState->mCamera.position(), viewportSize);
+  }
 
   // Now process any MovingBody objects that have been spawned after phase 1
-  mpState->mPhysicsSystem.updatePhase2(mpState->mEntities);
+  RIGEL_PROFILE_CALL(
+    "Physics", mpState->mPhysicsSystem.updatePhase2(mpState->mEntities));
 
-  mpState->mParticles.update();
+  RIGEL_PROFILE_CALL("Particles", mpState->mParticles.update());
 
   if (!mpOptions->mMotionSmoothing)
   {
-    mpState->mSpriteRenderingSystem.update(
-      mpState->mEntities, viewportSize, mpState->mCamera.position(), 1.0f);
+    RIGEL_PROFILE_CALL(
+      "Sprite rendering",
+      mpState->mSpriteRenderingSystem.update(
+        mpState->mEntities, viewportSize, mpState->mCamera.position(), 1.0f));
+  }
+  else
+  {
+    mpState->mSpriteRenderingSystem.invalidate();
   }
 
+  mpState->mRadarDots.invalidate();
   mpState->mIsOddFrame = !mpState->mIsOddFrame;
+
+  mDeferredEvents.flush(*this);
+
+  mWorldStateMemory.set(estimateMemoryUsage(*mpState));
 }
 
 
 void GameWorld::render(const float interpolationFactor)
 {
-  if (
-    widescreenModeOn() != mWidescreenModeWasOn ||
-    mpOptions->mPerElementUpscalingEnabled != mPerElementUpscalingWasEnabled ||
-    mPreviousWindowSize != mpRenderer->windowSize())
-  {
-    mSpecialEffects.rebuildBackgroundBuffer(*mpOptions);
-  }
+  RIGEL_TRACE_ZONE("GameWorld::render");
+
+  applyPendingBackdropSwitch();
+
+  mSpecialEffects.updateBackgroundBuffer(*mpOptions);
 
   if (
     widescreenModeOn() != mWidescreenModeWasOn ||
@@ -703,7 +774,9 @@ void GameWorld::render(const float interpolationFactor)
     [&](const ViewportParams& viewportParams) {
       renderer::setLocalTranslation(mpRenderer, viewportParams.mCameraOffset);
       mpState->mParticles.render(
-        viewportParams.mRenderStartPosition, interpolationFactor);
+        viewportParams.mRenderStartPosition,
+        interpolationFactor,
+        effectsDetailStride(mEffectsDetail));
       mpState->mDebuggingSystem.update(
         mpState->mEntities,
         viewportParams.mRenderStartPosition,
@@ -725,10 +798,24 @@ void GameWorld::render(const float interpolationFactor)
       return;
     }
 
-    if (mpOptions->mPerElementUpscalingEnabled)
+    // Particles and debug overlays need to stay pixelated when using
+    // per-element upscaling, so they go into a low-res layer that's upscaled
+    // as a whole. Most of the time, there is nothing to draw into it, though,
+    // and then the extra render pass is skipped.
+    const auto needsLowResLayer = mpOptions->mPerElementUpscalingEnabled &&
+      (mpState->mParticles.hasParticles() ||
+       mpState->mDebuggingSystem.hasVisibleOverlays());
+
+    if (needsLowResLayer)
     {
       drawMapAndSprites(viewportParams, interpolationFactor);
 
+      renderer::updateRenderTargetSize(
+        mLowResLayer,
+        mpRenderer,
+        {renderer::determineWidescreenViewport(mpRenderer).mWidthPx,
+         data::GameTraits::viewportHeightPx});
+
       {
         const auto saved = mLowResLayer.bindAndReset();
         mpRenderer->clear({0, 0, 0, 0});
@@ -761,14 +848,14 @@ void GameWorld::render(const float interpolationFactor)
   };
 
   auto drawHud = [&, this]() {
-    const auto radarDots =
-      collectRadarDots(mpState->mEntities, mpState->mPlayer.orientedPosition());
+    const auto& radarDots =
+      mpState->mRadarDots.dots(mpState->mPlayer.orientedPosition());
     mHudRenderer.renderClassicHud(*mpPersistentPlayerState, radarDots);
   };
 
   auto drawWidescreenHud = [&](const int viewportWidth) {
-    const auto radarDots =
-      collectRadarDots(mpState->mEntities, mpState->mPlayer.orientedPosition());
+    const auto& radarDots =
+      mpState->mRadarDots.dots(mpState->mPlayer.orientedPosition());
     mHudRenderer.renderWidescreenHud(
       viewportWidth,
       mpOptions->mWidescreenHudStyle,
@@ -842,7 +929,6 @@ void GameWorld::render(const float interpolationFactor)
 
   mPreviousHudStyle = mpOptions->mWidescreenHudStyle;
   mWidescreenModeWasOn = widescreenModeOn();
-  mPerElementUpscalingWasEnabled = mpOptions->mPerElementUpscalingEnabled;
   mPreviousWindowSize = mpRenderer->windowSize();
 }
 
@@ -943,9 +1029,18 @@ void GameWorld::drawMapAndSprites(
   };
 
   auto renderTileDebris = [&]() {
+    // Thinning out by entity index keeps the same pieces visible from
+    // frame to frame
+    const auto stride = std::uint32_t(effectsDetailStride(mEffectsDetail));
+
     state.mEntities.each<TileDebris, WorldPosition>(
       [&](
         entityx::Entity e, const TileDebris& debris, const WorldPosition& pos) {
+        if (e.id().index() % stride != 0)
+        {
+          return;
+        }
+
         const auto pixelPosition =
           engine::interpolatedPixelPosition(e, interpolationFactor);
         state.mMapRenderer.renderSingleTile(
@@ -976,7 +1071,9 @@ void GameWorld::drawMapAndSprites(
 
   if (mpOptions->mMotionSmoothing)
   {
-    mpState->mSpriteRenderingSystem.update(
+    // Sprites are only collected again after a logic update, rendered frames
+    // in between just interpolate the sprite positions.
+    mpState->mSpriteRenderingSystem.updateInterpolation(
       mpState->mEntities,
       params.mViewportSize,
       params.mRenderStartPosition,
@@ -1009,7 +1106,7 @@ void GameWorld::drawMapAndSprites(
 
     renderer::setLocalTranslation(mpRenderer, params.mCameraOffset);
 
-    mSpecialEffects.drawWaterEffect(waterEffectAreas, state.mWaterAnimStep);
+    mSpecialEffects.drawEffects(waterEffectAreas, state.mWaterAnimStep);
     renderForegroundLayers();
   }
 }
@@ -1024,6 +1121,7 @@ bool GameWorld::widescreenModeOn() const
 
 void GameWorld::processEndOfFrameActions()
 {
+  applyPendingBackdropSwitch();
   handlePlayerDeath();
   handleTeleporter();
 
@@ -1144,19 +1242,29 @@ void GameWorld::quickSave()
 
   LOG_F(INFO, "Creating quick save");
 
-  auto pStateCopy = std::make_unique<WorldState>(
-    mpServiceProvider,
-    mpRenderer,
-    mpResources,
-    mpPersistentPlayerState,
-    mpOptions,
-    mpSpriteFactory,
-    mSessionId);
-  pStateCopy->synchronizeTo(
-    *mpState, mpServiceProvider, mpPersistentPlayerState, mSessionId);
+  applyPendingBackdropSwitch();
 
-  mpQuickSave = std::make_unique<QuickSaveData>(
-    QuickSaveData{*mpPersistentPlayerState, std::move(pStateCopy)});
+  // The world state for the quick save is only created once, and then
+  // reused for subsequent saves. This avoids re-creating all its systems and
+  // renderers each time.
+  if (!mpQuickSave)
+  {
+    auto pStateCopy = std::make_unique<WorldState>(
+      mpServiceProvider,
+      mpRenderer,
+      mpResources,
+      mpPersistentPlayerState,
+      mpOptions,
+      mpSpriteFactory,
+      mSessionId);
+    mpQuickSave = std::make_unique<QuickSaveData>(
+      QuickSaveData{*mpPersistentPlayerState, std::move(pStateCopy)});
+  }
+
+  mpQuickSave->mPersistentPlayerState = *mpPersistentPlayerState;
+  mpQuickSave->mpState->synchronizeTo(
+    *mpState, mpServiceProvider, mpPersistentPlayerState, mSessionId);
+  mQuickSaveMemory.set(estimateMemoryUsage(*mpQuickSave->mpState));
 
   mMessageDisplay.setMessage(
     data::Messages::QuickSaved, ui::MessagePriority::Menu);
@@ -1174,6 +1282,8 @@ void GameWorld::quickLoad()
 
   LOG_F(INFO, "Loading quick save");
 
+  applyPendingBackdropSwitch();
+
   *mpPersistentPlayerState = mpQuickSave->mPersistentPlayerState;
   mpState->synchronizeTo(
     *mpQuickSave->mpState,
@@ -1220,13 +1330,23 @@ void GameWorld::onReactorDestroyed(const base::Vec2& position)
     data::map::BackdropSwitchCondition::OnReactorDestruction;
   if (!mpState->mReactorDestructionFramesElapsed && shouldDoSpecialEvent)
   {
-    mpState->mMapRenderer.switchBackdrops();
+    mBackdropSwitchPending = true;
     mpState->mBackdropSwitched = true;
     mpState->mReactorDestructionFramesElapsed = 0;
   }
 }
 
 
+void GameWorld::applyPendingBackdropSwitch()
+{
+  if (mBackdropSwitchPending)
+  {
+    mpState->mMapRenderer.switchBackdrops();
+    mBackdropSwitchPending = false;
+  }
+}
+
+
 void GameWorld::updateReactorDestructionEvent()
 {
   auto& framesElapsed = *mpState->mReactorDestructionFramesElapsed;
@@ -1277,7 +1397,22 @@ void GameWorld::restartLevel()
   mpServiceProvider->fadeOutScreen();
 
   *mpPersistentPlayerState = mPlayerModelAtLevelStart;
-  loadLevel({});
+
+  // Created with the player state restored, so that it's set up the same
+  // way as it would have been when loading the level.
+  if (!mpLevelStartState)
+  {
+    mpLevelStartState = createState(std::move(*mLevelStartData));
+    mLevelStartData.reset();
+    mLevelStartStateMemory.set(estimateMemoryUsage(*mpLevelStartState));
+  }
+
+  mpState->synchronizeTo(
+    *mpLevelStartState,
+    mpServiceProvider,
+    mpPersistentPlayerState,
+    mSessionId);
+  startLevel({});
 
   if (mpState->mRadarDishCounter.radarDishesPresent())
   {
@@ -1372,10 +1507,69 @@ void GameWorld::printDebugText(std::ostream& stream) const
 
   stream << "\nEntities: " << mpState->mEntities.size() << '\n';
 
+  const auto blockStats = mpState->mMapRenderer.blockStatistics();
+  stream << "Map blocks: " << blockStats.mDrawnBlocks << " drawn, "
+         << blockStats.mSkippedBlocks << " skipped\n";
+
+  const auto sectionStats =
+    mpState->mDynamicGeometrySystem.sectionStatistics();
+  stream << "Dynamic sections: " << sectionStats.mDrawnSections << " drawn, "
+         << sectionStats.mCulledSections << " culled\n";
+
+  const auto spriteStats = mpState->mSpriteRenderingSystem.statistics();
+  stream << "Sprites: " << spriteStats.mDrawnSprites << " drawn, "
+         << spriteStats.mCulledSprites << " culled\n";
+
+  const auto viewportSize = widescreenModeOn()
+    ? viewportSizeWideScreen(mpRenderer, *mpOptions)
+    : data::GameTraits::mapViewportSize;
+  stream << "Viewport: " << viewportSize.width << "x" << viewportSize.height
+         << " tiles\n";
+
   if (mpOptions->mPerElementUpscalingEnabled)
   {
     stream << "Hi-res mode ON\n";
   }
 }
 
+
+StateHash GameWorld::stateHash() const
+{
+  const auto& player = mpState->mPlayer;
+
+  StateHasher playerHasher;
+  playerHasher.add(player.position().x)
+    .add(player.position().y)
+    .add(player.animationFrame())
+    .add(player.orientation())
+    .add(mpPersistentPlayerState->health())
+    .add(mpPersistentPlayerState->score())
+    .add(mpPersistentPlayerState->ammo())
+    .add(mpPersistentPlayerState->weapon());
+
+  StateHasher actorHasher;
+  mpState->mEntities.each<WorldPosition>(
+    [&](entityx::Entity entity, const WorldPosition& position) {
+      actorHasher.add(entity.id().index()).add(position.x).add(position.y);
+
+      if (entity.has_component<game_logic::components::Shootable>())
+      {
+        actorHasher.add(
+          entity.component<game_logic::components::Shootable>()->mHealth);
+      }
+    });
+
+  StateHasher globalsHasher;
+  globalsHasher.add(mpState->mRandomGenerator.nextNumberIndex())
+    .add(mpState->mCamera.position().x)
+    .add(mpState->mCamera.position().y)
+    .add(mpState->mLevelFinished);
+
+  return StateHash{
+    playerHasher.value(),
+    actorHasher.value(),
+    mpState->mMap.contentHash(),
+    globalsHasher.value()};
+}
+
 } // namespace rigel::game_logic
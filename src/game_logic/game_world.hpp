@@ -17,12 +17,15 @@
 #pragma once
 
 #include "base/color.hpp"
+#include "base/memory_accounting.hpp"
 #include "base/spatial_types.hpp"
 #include "base/warnings.hpp"
 #include "data/bonus.hpp"
 #include "data/game_session_data.hpp"
+#include "data/map.hpp"
 #include "data/player_model.hpp"
 #include "data/tutorial_messages.hpp"
+#include "engine/deferred_event_queue.hpp"
 #include "engine/graphical_effects.hpp"
 #include "engine/sprite_factory.hpp"
 #include "frontend/game_mode.hpp"
@@ -71,7 +74,8 @@ public:
     GameMode::Context context,
     std::optional<base::Vec2> playerPositionOverride = std::nullopt,
     bool showWelcomeMessage = false,
-    const PlayerInput& initialInput = PlayerInput{});
+    const PlayerInput& initialInput = PlayerInput{},
+    std::optional<data::map::LevelData> preloadedLevel = std::nullopt);
   ~GameWorld() override;
 
   bool levelFinished() const override;
@@ -80,12 +84,12 @@ public:
   void receive(const rigel::events::CheckPointActivated& event);
   void receive(const rigel::events::ExitReached& event);
   void receive(const rigel::events::HintMachineMessage& event);
-  void receive(const rigel::events::PlayerDied& event);
-  void receive(const rigel::events::PlayerTookDamage& event);
+  void receive(const std::vector<rigel::events::PlayerDied>& events);
+  void receive(const std::vector<rigel::events::PlayerTookDamage>& events);
   void receive(const rigel::events::PlayerMessage& event);
-  void receive(const rigel::events::PlayerTeleported& event);
+  void receive(const std::vector<rigel::events::PlayerTeleported>& events);
   void receive(const rigel::events::ScreenFlash& event);
-  void receive(const rigel::events::ScreenShake& event);
+  void receive(const std::vector<rigel::events::ScreenShake>& events);
   void receive(const rigel::events::TutorialMessage& event);
   void receive(const events::ShootableKilled& event);
   void receive(const rigel::events::BossActivated& event);
@@ -95,6 +99,12 @@ public:
 
   bool needsPerElementUpscaling() const override;
   void updateGameLogic(const PlayerInput& input) override;
+  bool supportsPipelinedUpdates() const override { return true; }
+  void setDrawOutputWanted(bool) override { }
+  void setEffectsDetail(const EffectsDetail detail) override
+  {
+    mEffectsDetail = detail;
+  }
   void render(float interpolationFactor = 0.0f) override;
   void processEndOfFrameActions() override;
   void updateBackdropAutoScrolling(engine::TimeDelta dt) override;
@@ -115,6 +125,7 @@ public:
   void debugToggleWorldCollisionDataDisplay() override;
   void debugToggleGridDisplay() override;
   void printDebugText(std::ostream& stream) const override;
+  StateHash stateHash() const override;
 
 private:
   struct ViewportParams
@@ -126,13 +137,18 @@ private:
     base::Size mViewportSize;
   };
 
-  void loadLevel(const PlayerInput& initialInput);
-  void createNewState();
+  void loadLevel(
+    const PlayerInput& initialInput,
+    std::optional<data::map::LevelData> preloadedLevel);
+  void createNewStates(std::optional<data::map::LevelData> preloadedLevel);
+  std::unique_ptr<WorldState> createState(data::map::LevelData&& level) const;
+  void startLevel(const PlayerInput& initialInput);
   void subscribe(entityx::EventManager& eventManager);
   void unsubscribe(entityx::EventManager& eventManager);
 
   void onReactorDestroyed(const base::Vec2& position);
   void updateReactorDestructionEvent();
+  void applyPendingBackdropSwitch();
 
   void handleLevelExit();
   void handlePlayerDeath();
@@ -176,11 +192,35 @@ private:
   base::Size mPreviousWindowSize;
   data::WidescreenHudStyle mPreviousHudStyle;
   bool mWidescreenModeWasOn;
-  bool mPerElementUpscalingWasEnabled;
   bool mMotionSmoothingWasEnabled;
+  EffectsDetail mEffectsDetail = EffectsDetail::Full;
+
+  // Switching backdrops finishes a texture upload, so it can't be done by
+  // updateGameLogic() when that runs on GameRunner's update thread. It's
+  // applied on the next main thread entry point instead.
+  bool mBackdropSwitchPending = false;
+
+  // Events whose handlers only record state for the end of the frame are
+  // batched, and handled at the end of updateGameLogic().
+  engine::DeferredEventQueue<
+    rigel::events::PlayerDied,
+    rigel::events::PlayerTookDamage,
+    rigel::events::PlayerTeleported,
+    rigel::events::ScreenShake>
+    mDeferredEvents;
 
   std::unique_ptr<WorldState> mpState;
+
+  // The level's state right after loading. Restarting the level restores
+  // this instead of loading the level again. It's created from
+  // mLevelStartData on the first restart.
+  std::unique_ptr<WorldState> mpLevelStartState;
+  std::optional<data::map::LevelData> mLevelStartData;
+
   std::unique_ptr<QuickSaveData> mpQuickSave;
+  base::TrackedMemory mWorldStateMemory{base::MemoryCategory::WorldState};
+  base::TrackedMemory mLevelStartStateMemory{base::MemoryCategory::WorldState};
+  base::TrackedMemory mQuickSaveMemory{base::MemoryCategory::QuickSaves};
 };
 
 } // namespace rigel::game_logic
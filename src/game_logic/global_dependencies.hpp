@@ -21,6 +21,7 @@
 #include "base/warnings.hpp"
 #include "data/tutorial_messages.hpp"
 #include "engine/base_components.hpp"
+#include "game_logic/player_proximity.hpp"
 #include "game_logic_common/input.hpp"
 
 RIGEL_DISABLE_WARNINGS
@@ -97,6 +98,9 @@ struct GlobalState
   const base::Vec2* mpCameraPosition;
   data::map::Map* mpMap;
   const PerFrameState* mpPerFrameState;
+
+  /** Player position at the start of the behavior controller updates */
+  PlayerProximity mPlayerProximity;
 };
 
 
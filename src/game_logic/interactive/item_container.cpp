@@ -68,7 +68,7 @@ void ItemContainerSystem::update(entityx::EntityManager& es)
   auto releaseItem =
     [this](
       entityx::Entity entity,
-      const std::vector<ComponentHolder>& containedComponents) {
+      const auto& containedComponents) {
       auto contents = mpEntityManager->create();
       for (auto& component : containedComponents)
       {
@@ -16,6 +16,7 @@
 
 #pragma once
 
+#include "base/small_vector.hpp"
 #include "base/spatial_types.hpp"
 #include "base/warnings.hpp"
 
@@ -138,7 +139,7 @@ struct ItemContainer
     NuclearWasteBarrel
   };
 
-  std::vector<ComponentHolder> mContainedComponents;
+  base::small_vector<ComponentHolder, 4> mContainedComponents;
   ReleaseStyle mStyle = ReleaseStyle::Default;
   std::int8_t mFramesElapsed = 0;
   bool mHasBeenShot = false;
@@ -34,6 +34,7 @@ namespace
 
 constexpr auto ACTIVATION_COUNTDOWN = 14;
 constexpr auto PERFORM_CHECKPOINT_TIME = 9;
+constexpr auto IDLE_OFF_SCREEN_UPDATE_INTERVAL = 8;
 
 void turnIntoPassiveCheckpoint(entityx::Entity entity)
 {
@@ -124,4 +125,14 @@ void RespawnCheckpoint::update(
   }
 }
 
+
+int RespawnCheckpoint::offScreenUpdateInterval() const
+{
+  // While waiting for the player, an update does nothing unless the player
+  // touches the checkpoint, which requires it to be on screen. The initial
+  // update and the activation sequence must run every frame, though.
+  const auto isIdle = mInitialized && !mActivationCountdown;
+  return isIdle ? IDLE_OFF_SCREEN_UPDATE_INTERVAL : 1;
+}
+
 } // namespace rigel::game_logic::interaction
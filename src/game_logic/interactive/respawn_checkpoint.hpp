@@ -32,6 +32,8 @@ struct RespawnCheckpoint
     bool isOnScreen,
     entityx::Entity entity);
 
+  int offScreenUpdateInterval() const;
+
   bool mInitialized = false;
   std::optional<int> mActivationCountdown;
 };
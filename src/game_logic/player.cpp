@@ -16,6 +16,7 @@
 
 #include "player.hpp"
 
+#include "base/defer.hpp"
 #include "base/match.hpp"
 #include "base/math_utils.hpp"
 #include "data/game_options.hpp"
@@ -60,7 +61,7 @@ namespace
 
 using EffectMovement = effects::EffectSprite::Movement;
 
-const effects::EffectSpec PLAYER_DEATH_EFFECT_SPEC[] = {
+constexpr auto PLAYER_DEATH_EFFECT_SPEC = effects::sortedByDelay({
   {effects::EffectSprite{
      {},
      data::ActorID::Duke_death_particles,
@@ -72,7 +73,7 @@ const effects::EffectSpec PLAYER_DEATH_EFFECT_SPEC[] = {
   {effects::RandomExplosionSound{}, 3},
   {effects::Particles{{2, 0}, data::GameTraits::INGAME_PALETTE[10], -1}, 4},
   {effects::RandomExplosionSound{}, 5},
-};
+});
 
 
 constexpr auto LADDER_CLIMB_ANIMATION = AnimationConfig{35, 36};
@@ -329,6 +330,7 @@ Player::Player(
   , mpServiceProvider(pServiceProvider)
   , mpCollisionChecker(pCollisionChecker)
   , mpMap(pMap)
+  , mCollisionQueries(pCollisionChecker, pMap)
   , mpEntityFactory(pEntityFactory)
   , mpEvents(pEvents)
   , mpRandomGenerator(pRandomGenerator)
@@ -585,6 +587,13 @@ void Player::update(const PlayerInput& unfilteredInput)
 {
   using namespace engine;
 
+  // The state machine below runs the same touch tests on the same position
+  // multiple times, so memoize them for the duration of the update.
+  mCollisionQueries.setEnabled(true);
+  const auto guard = base::defer([this]() {
+    mCollisionQueries.setEnabled(false);
+  });
+
   updateTemporaryItemExpiration();
 
   if (auto pState = std::get_if<GettingSuckedIntoSpace>(&mState))
@@ -973,13 +982,13 @@ void Player::updateMovement(
 
       if (
         mJumpRequested &&
-        !mpCollisionChecker->isTouchingCeiling(position, collisionBox()))
+        !mCollisionQueries.isTouchingCeiling(position, collisionBox()))
       {
         jump();
       }
       else
       {
-        if (!mpCollisionChecker->isOnSolidGround(position, collisionBox()))
+        if (!mCollisionQueries.isOnSolidGround(position, collisionBox()))
         {
           startFalling();
         }
@@ -1047,7 +1056,7 @@ void Player::updateMovement(
     [&, this](ClimbingLadder& state) {
       if (
         mJumpRequested &&
-        !mpCollisionChecker->isTouchingCeiling(position, collisionBox()))
+        !mCollisionQueries.isTouchingCeiling(position, collisionBox()))
       {
         jumpFromLadder(movementVector);
         return;
@@ -1091,7 +1100,7 @@ void Player::updateMovement(
       if (
         movementVector.y <= 0 &&
         mJumpRequested &&
-        !mpCollisionChecker->isTouchingCeiling(position, collisionBox()))
+        !mCollisionQueries.isTouchingCeiling(position, collisionBox()))
       // clang-format on
       {
         position.y -= 1;
@@ -1188,11 +1197,11 @@ void Player::updateMovement(
           const auto worldBBox = worldSpaceCollisionBox();
           if (result != MovementResult::Completed)
           {
-            if (mpCollisionChecker->isOnSolidGround(worldBBox))
+            if (mCollisionQueries.isOnSolidGround(worldBBox))
             {
               moveVertically(*mpCollisionChecker, mEntity, -1);
             }
-            else if (mpCollisionChecker->isTouchingCeiling(worldBBox))
+            else if (mCollisionQueries.isTouchingCeiling(worldBBox))
             {
               moveVertically(*mpCollisionChecker, mEntity, 1);
             }
@@ -1229,7 +1238,7 @@ void Player::updateMovement(
       {
         exitShip();
 
-        if (!mpCollisionChecker->isTouchingCeiling(position, collisionBox()))
+        if (!mCollisionQueries.isTouchingCeiling(position, collisionBox()))
         {
           jump();
         }
@@ -1344,6 +1353,9 @@ bool Player::updateElevatorMovement(const int movementDirection)
     playerPosition.y += movementDirection;
   }
 
+  // The elevator is a solid body, so earlier results might be stale now
+  mCollisionQueries.invalidate();
+
   return playerPosition.y != previousY;
 }
 
@@ -1895,7 +1907,7 @@ void Player::jumpFromLadder(const base::Vec2& movementVector)
 
 void Player::startFalling()
 {
-  if (mpCollisionChecker->isOnSolidGround(worldSpaceCollisionBox()))
+  if (mCollisionQueries.isOnSolidGround(worldSpaceCollisionBox()))
   {
     mState = OnGround{};
     setVisualState(VisualState::Standing);
@@ -1939,8 +1951,8 @@ void Player::switchOrientation()
 
   const auto offset = base::Vec2{1, 0};
   const auto stuckInWall = orientation == c::Orientation::Left
-    ? mpCollisionChecker->isTouchingLeftWall(position + offset, collisionBox())
-    : mpCollisionChecker->isTouchingRightWall(
+    ? mCollisionQueries.isTouchingLeftWall(position + offset, collisionBox())
+    : mCollisionQueries.isTouchingRightWall(
         position - offset, collisionBox());
   if (stuckInWall)
   {
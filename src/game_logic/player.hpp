@@ -19,6 +19,7 @@
 #include "base/warnings.hpp"
 #include "data/game_session_data.hpp"
 #include "engine/base_components.hpp"
+#include "engine/collision_query_cache.hpp"
 #include "engine/movement.hpp"
 #include "game_logic/global_dependencies.hpp"
 #include "game_logic/player/components.hpp"
@@ -393,6 +394,7 @@ private:
   IGameServiceProvider* mpServiceProvider;
   const engine::CollisionChecker* mpCollisionChecker;
   const data::map::Map* mpMap;
+  engine::CollisionQueryCache mCollisionQueries;
   IEntityFactory* mpEntityFactory;
   entityx::EventManager* mpEvents;
   engine::RandomNumberGenerator* mpRandomGenerator;
@@ -19,6 +19,7 @@
 #include "data/player_model.hpp"
 #include "engine/base_components.hpp"
 #include "engine/physical_components.hpp"
+#include "engine/spatial_index.hpp"
 #include "engine/visual_components.hpp"
 #include "game_logic/damage_components.hpp"
 #include "game_logic/global_dependencies.hpp"
@@ -28,14 +29,14 @@
 namespace rigel::game_logic::player
 {
 
-using engine::toWorldSpace;
-using engine::components::BoundingBox;
-using engine::components::WorldPosition;
 using game_logic::components::PlayerDamaging;
 
 
-DamageSystem::DamageSystem(Player* pPlayer)
+DamageSystem::DamageSystem(
+  Player* pPlayer,
+  const engine::SpatialIndex* pSpatialIndex)
   : mpPlayer(pPlayer)
+  , mpSpatialIndex(pSpatialIndex)
 {
 }
 
@@ -47,31 +48,21 @@ void DamageSystem::update(entityx::EntityManager& es)
     return;
   }
 
-  const auto playerBBox = mpPlayer->worldSpaceHitBox();
-  es.each<PlayerDamaging, BoundingBox, WorldPosition>(
-    [this, &playerBBox](
-      entityx::Entity entity,
-      const PlayerDamaging& damage,
-      const BoundingBox& boundingBox,
-      const WorldPosition& position) {
-      const auto bbox = toWorldSpace(boundingBox, position);
-      const auto hasCollision = bbox.intersects(playerBBox);
-
-      if (hasCollision)
+  mpSpatialIndex->forEachIntersecting<PlayerDamaging>(
+    mpPlayer->worldSpaceHitBox(),
+    [this](entityx::Entity entity, const PlayerDamaging& damage) {
+      if (damage.mIsFatal)
+      {
+        mpPlayer->takeFatalDamage();
+      }
+      else
       {
-        if (damage.mIsFatal)
-        {
-          mpPlayer->takeFatalDamage();
-        }
-        else
-        {
-          mpPlayer->takeDamage(damage.mAmount);
-        }
+        mpPlayer->takeDamage(damage.mAmount);
+      }
 
-        if (damage.mDestroyOnContact)
-        {
-          entity.destroy();
-        }
+      if (damage.mDestroyOnContact)
+      {
+        entity.destroy();
       }
     });
 }
@@ -23,6 +23,11 @@ RIGEL_DISABLE_WARNINGS
 RIGEL_RESTORE_WARNINGS
 
 
+namespace rigel::engine
+{
+class SpatialIndex;
+}
+
 namespace rigel::game_logic
 {
 class Player;
@@ -35,12 +40,13 @@ namespace rigel::game_logic::player
 class DamageSystem
 {
 public:
-  explicit DamageSystem(Player* pPlayer);
+  DamageSystem(Player* pPlayer, const engine::SpatialIndex* pSpatialIndex);
 
   void update(entityx::EntityManager& es);
 
 private:
   Player* mpPlayer;
+  const engine::SpatialIndex* mpSpatialIndex;
 };
 
 } // namespace rigel::game_logic::player
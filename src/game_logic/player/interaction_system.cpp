@@ -19,6 +19,7 @@
 #include "assets/resource_loader.hpp"
 #include "data/strings.hpp"
 #include "engine/physics_system.hpp"
+#include "engine/spatial_index.hpp"
 #include "engine/visual_components.hpp"
 #include "frontend/game_service_provider.hpp"
 #include "game_logic/actor_tag.hpp"
@@ -152,7 +153,7 @@ std::optional<base::Vec2> findTeleporterTargetPosition(
 
 
 ex::Entity currentlyTouchedInteractable(
-  entityx::EntityManager& es,
+  const engine::SpatialIndex& spatialIndex,
   const Player* pPlayer)
 {
   const auto worldSpacePlayerBounds = pPlayer->worldSpaceHitBox();
@@ -189,19 +190,26 @@ ex::Entity currentlyTouchedInteractable(
   };
 
 
-  ex::ComponentHandle<Interactable> interactable;
-  ex::ComponentHandle<WorldPosition> pos;
-  ex::ComponentHandle<BoundingBox> bbox;
-  for (auto entity : es.entities_with_components(interactable, pos, bbox))
-  {
-    const auto objectBounds = engine::toWorldSpace(*bbox, *pos);
-    if (isInRange(objectBounds, *pos, interactable->mType))
-    {
-      return entity;
-    }
-  }
+  // Interactables don't move, so the index still being from the previous
+  // frame doesn't matter. Since each candidate is checked against its
+  // current bounding box, this finds the same entity as testing all of them.
+  ex::Entity result;
+  spatialIndex.forEachIntersecting<Interactable, WorldPosition, BoundingBox>(
+    worldSpacePlayerBounds,
+    [&](
+      ex::Entity entity,
+      const Interactable& interactable,
+      const WorldPosition& pos,
+      const BoundingBox& bbox) {
+      if (
+        !result &&
+        isInRange(engine::toWorldSpace(bbox, pos), pos, interactable.mType))
+      {
+        result = entity;
+      }
+    });
 
-  return {};
+  return result;
 }
 
 } // namespace
@@ -214,12 +222,14 @@ PlayerInteractionSystem::PlayerInteractionSystem(
   IGameServiceProvider* pServices,
   IEntityFactory* pEntityFactory,
   entityx::EventManager* pEvents,
+  const engine::SpatialIndex* pSpatialIndex,
   const assets::ResourceLoader& resources)
   : mpPlayer(pPlayer)
   , mpPersistentPlayerState(pPersistentPlayerState)
   , mpServiceProvider(pServices)
   , mpEntityFactory(pEntityFactory)
   , mpEvents(pEvents)
+  , mpSpatialIndex(pSpatialIndex)
   , mLevelHints(resources.loadHintMessages())
   , mSessionId(sessionId)
 {
@@ -235,7 +245,7 @@ void PlayerInteractionSystem::updatePlayerInteraction(
     return;
   }
 
-  if (auto entity = currentlyTouchedInteractable(es, mpPlayer))
+  if (auto entity = currentlyTouchedInteractable(*mpSpatialIndex, mpPlayer))
   {
     const auto type = entity.component<Interactable>()->mType;
     const auto isHintMachine = type == InteractableType::HintMachine;
@@ -259,27 +269,22 @@ void PlayerInteractionSystem::updateItemCollection(entityx::EntityManager& es)
     return;
   }
 
-  es.each<CollectableItem, WorldPosition, BoundingBox>(
+  es.each<CollectableItem>([](ex::Entity, CollectableItem& collectable) {
+    if (collectable.mDelayUntilPickupAllowed > 0)
+    {
+      collectable.mDelayUntilPickupAllowed--;
+    }
+  });
+
+  mpSpatialIndex->forEachIntersecting<CollectableItem, WorldPosition>(
+    mpPlayer->worldSpaceHitBox(),
     [this, &es](
       ex::Entity entity,
       CollectableItem& collectable,
-      const WorldPosition& pos,
-      const BoundingBox& collisionRect) {
+      const WorldPosition& pos) {
       using namespace data;
 
-      auto worldSpaceBbox = collisionRect;
-      worldSpaceBbox.topLeft +=
-        base::Vec2{pos.x, pos.y - (worldSpaceBbox.size.height - 1)};
-
-      if (collectable.mDelayUntilPickupAllowed > 0)
-      {
-        collectable.mDelayUntilPickupAllowed--;
-      }
-
-      auto playerBBox = mpPlayer->worldSpaceHitBox();
-      if (
-        collectable.mDelayUntilPickupAllowed == 0 &&
-        worldSpaceBbox.intersects(playerBBox))
+      if (collectable.mDelayUntilPickupAllowed == 0)
       {
         std::optional<data::SoundId> soundToPlay;
 
@@ -54,6 +54,11 @@ namespace assets
 {
 class ResourceLoader;
 }
+
+namespace engine
+{
+class SpatialIndex;
+}
 } // namespace rigel
 
 
@@ -72,6 +77,7 @@ public:
     IGameServiceProvider* pServices,
     IEntityFactory* pEntityFactory,
     entityx::EventManager* pEvents,
+    const engine::SpatialIndex* pSpatialIndex,
     const assets::ResourceLoader& resources);
 
   void updatePlayerInteraction(
@@ -108,6 +114,7 @@ private:
   IGameServiceProvider* mpServiceProvider;
   IEntityFactory* mpEntityFactory;
   entityx::EventManager* mpEvents;
+  const engine::SpatialIndex* mpSpatialIndex;
   data::LevelHints mLevelHints;
   data::GameSessionId mSessionId;
 };
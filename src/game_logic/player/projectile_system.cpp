@@ -295,51 +295,23 @@ bool ProjectileSystem::isCollidingWithWorld(const base::Rect<int>& bbox)
   // to fly through walls in very specific circumstances (multiple composite
   // tiles followed by a 1 unit wide solid wall). It seems like a bug, but to
   // replicate the original game's behavior, we do the same here.
-  auto hasCompositeTileAt = [this](const int x, const int y) {
-    if (x < 0 || x >= mpMap->width() || y < 0 || y >= mpMap->height())
-    {
-      return false;
-    }
-
-    return mpMap->tileAt(0, x, y) != 0 && mpMap->tileAt(1, x, y) != 0;
-  };
-
-  auto hasCompositeTilesBottomRow = [&]() {
-    for (int x = bbox.left(); x <= bbox.right(); ++x)
-    {
-      if (hasCompositeTileAt(x, bbox.bottom()))
-      {
-        return true;
-      }
-    }
-
-    return false;
-  };
-
-  auto hasCompositeTilesLeftColumn = [&]() {
-    for (int y = bbox.top(); y <= bbox.bottom(); ++y)
-    {
-      if (hasCompositeTileAt(bbox.left(), y))
-      {
-        return true;
-      }
-    }
-
-    return false;
-  };
-
-
+  //
+  // All of these tests work on the map's precomputed bitmaps, so the cost
+  // doesn't depend on the projectile's size. Since the player's weapons can
+  // produce many shots per second, this runs quite often.
   if (bbox.top() < 0 || bbox.bottom() == 0)
   {
     return false;
   }
 
-  const auto hasCollisionOnBottomRow = mpCollisionChecker->testHorizontalSpan(
-    bbox.left(), bbox.right(), bbox.bottom(), data::map::SolidEdge::any());
-  const auto hasCollisionOnLeftColumn = mpCollisionChecker->testVerticalSpan(
-    bbox.top(), bbox.bottom(), bbox.left(), data::map::SolidEdge::any());
-  return (hasCollisionOnBottomRow || hasCollisionOnLeftColumn) &&
-    !hasCompositeTilesBottomRow() && !hasCompositeTilesLeftColumn();
+  const auto hasCollision =
+    mpCollisionChecker->testHorizontalSpan(
+      bbox.left(), bbox.right(), bbox.bottom(), data::map::SolidEdge::any()) ||
+    mpCollisionChecker->testVerticalSpan(
+      bbox.top(), bbox.bottom(), bbox.left(), data::map::SolidEdge::any());
+  return hasCollision &&
+    !mpMap->hasCompositeTileInRow(bbox.left(), bbox.right(), bbox.bottom()) &&
+    !mpMap->hasCompositeTileInColumn(bbox.top(), bbox.bottom(), bbox.left());
 }
 
 } // namespace rigel::game_logic::player
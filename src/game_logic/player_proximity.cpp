@@ -0,0 +1,97 @@
+/* Copyright (C) 2022, Nikolai Wuttke. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "player_proximity.hpp"
+
+#include "game_logic/player.hpp"
+
+#include <algorithm>
+
+
+namespace rigel::game_logic
+{
+
+namespace
+{
+
+int gapBetween(
+  const int startA,
+  const int endA,
+  const int startB,
+  const int endB)
+{
+  return std::max({0, startB - endA, startA - endB});
+}
+
+} // namespace
+
+
+PlayerProximity::PlayerProximity(
+  const base::Vec2& position,
+  const engine::components::BoundingBox& worldSpaceHitBox)
+  : mPosition(position)
+  , mWorldSpaceHitBox(worldSpaceHitBox)
+{
+}
+
+
+PlayerProximity::PlayerProximity(const Player& player)
+  : PlayerProximity(player.position(), player.worldSpaceHitBox())
+{
+}
+
+
+int PlayerProximity::distanceTo(
+  const engine::components::BoundingBox& worldSpaceBox) const
+{
+  // The gap is the number of tiles in between, so boxes directly next to
+  // each other have a distance of 0.
+  const auto horizontalGap = gapBetween(
+    mWorldSpaceHitBox.left(),
+    mWorldSpaceHitBox.right() + 1,
+    worldSpaceBox.left(),
+    worldSpaceBox.right() + 1);
+  const auto verticalGap = gapBetween(
+    mWorldSpaceHitBox.top(),
+    mWorldSpaceHitBox.bottom() + 1,
+    worldSpaceBox.top(),
+    worldSpaceBox.bottom() + 1);
+  return std::max(horizontalGap, verticalGap);
+}
+
+
+ProximityBand PlayerProximity::bandFor(
+  const engine::components::BoundingBox& worldSpaceBox) const
+{
+  if (mWorldSpaceHitBox.intersects(worldSpaceBox))
+  {
+    return ProximityBand::Touching;
+  }
+
+  const auto distance = distanceTo(worldSpaceBox);
+  if (distance <= NEAR_DISTANCE)
+  {
+    return ProximityBand::Near;
+  }
+  else if (distance <= MEDIUM_DISTANCE)
+  {
+    return ProximityBand::Medium;
+  }
+
+  return ProximityBand::Far;
+}
+
+} // namespace rigel::game_logic
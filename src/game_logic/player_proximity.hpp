@@ -0,0 +1,87 @@
+/* Copyright (C) 2022, Nikolai Wuttke. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "base/spatial_types.hpp"
+#include "engine/base_components.hpp"
+
+#include <cstdint>
+
+
+namespace rigel::game_logic
+{
+
+class Player;
+
+
+/** Coarse classification of an actor's distance to the player
+ *
+ * The distance is the larger of the horizontal and vertical gap between the
+ * actor's and the player's bounding boxes, i.e. the number of tiles in
+ * between.
+ */
+enum class ProximityBand : std::uint8_t
+{
+  Touching, // boxes intersect
+  Near, // up to NEAR_DISTANCE tiles
+  Medium, // up to MEDIUM_DISTANCE tiles
+  Far
+};
+
+
+/** Snapshot of the player's position, taken once per frame
+ *
+ * The behavior controller system captures this after the player has been
+ * updated and before any behavior controller runs, and makes it available
+ * as GlobalState::mPlayerProximity. Controllers can move the player during
+ * their update (e.g. elevators), so the snapshot is only suitable for
+ * coarse decisions. Anything that needs to match the player's current state
+ * exactly must keep querying the Player.
+ */
+class PlayerProximity
+{
+public:
+  static constexpr int NEAR_DISTANCE = 8;
+  static constexpr int MEDIUM_DISTANCE = 32;
+
+  PlayerProximity() = default;
+  PlayerProximity(
+    const base::Vec2& position,
+    const engine::components::BoundingBox& worldSpaceHitBox);
+
+  explicit PlayerProximity(const Player& player);
+
+  /** Player position, see Player::position() */
+  const base::Vec2& position() const { return mPosition; }
+
+  /** Player hit box in world space, see Player::worldSpaceHitBox() */
+  const engine::components::BoundingBox& worldSpaceHitBox() const
+  {
+    return mWorldSpaceHitBox;
+  }
+
+  int distanceTo(const engine::components::BoundingBox& worldSpaceBox) const;
+
+  ProximityBand bandFor(
+    const engine::components::BoundingBox& worldSpaceBox) const;
+
+private:
+  base::Vec2 mPosition;
+  engine::components::BoundingBox mWorldSpaceHitBox;
+};
+
+} // namespace rigel::game_logic
@@ -0,0 +1,104 @@
+/* Copyright (C) 2022, Nikolai Wuttke. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "radar_dot_list.hpp"
+
+#include "engine/base_components.hpp"
+#include "ui/hud_renderer.hpp"
+
+#include <algorithm>
+
+
+namespace rigel::game_logic
+{
+
+using components::AppearsOnRadar;
+
+
+RadarDotList::RadarDotList(entityx::EventManager& events)
+{
+  events.subscribe<entityx::ComponentAddedEvent<AppearsOnRadar>>(*this);
+  events.subscribe<entityx::ComponentRemovedEvent<AppearsOnRadar>>(*this);
+}
+
+
+const std::vector<base::Vec2>&
+  RadarDotList::dots(const base::Vec2& playerPosition)
+{
+  using engine::components::Active;
+  using engine::components::WorldPosition;
+
+  if (!mDotsOutOfDate && playerPosition == mDotsPlayerPosition)
+  {
+    return mDots;
+  }
+
+  mDots.clear();
+
+  for (auto entity : mEntities)
+  {
+    if (
+      !entity.has_component<Active>() ||
+      !entity.has_component<WorldPosition>())
+    {
+      continue;
+    }
+
+    const auto& position = *entity.component<WorldPosition>();
+    const auto positionRelativeToPlayer = position - playerPosition;
+    if (ui::isVisibleOnRadar(positionRelativeToPlayer))
+    {
+      mDots.push_back(positionRelativeToPlayer);
+    }
+  }
+
+  mDotsPlayerPosition = playerPosition;
+  mDotsOutOfDate = false;
+  return mDots;
+}
+
+
+void RadarDotList::invalidate()
+{
+  mDotsOutOfDate = true;
+}
+
+
+void RadarDotList::receive(
+  const entityx::ComponentAddedEvent<AppearsOnRadar>& event)
+{
+  mEntities.push_back(event.entity);
+  mDotsOutOfDate = true;
+}
+
+
+void RadarDotList::receive(
+  const entityx::ComponentRemovedEvent<AppearsOnRadar>& event)
+{
+  const auto it =
+    std::find(mEntities.begin(), mEntities.end(), event.entity);
+  if (it != mEntities.end())
+  {
+    // The order of radar dots doesn't matter, so we can do a constant time
+    // removal by swapping with the last element.
+    *it = mEntities.back();
+    mEntities.pop_back();
+  }
+
+  mDotsOutOfDate = true;
+}
+
+} // namespace rigel::game_logic
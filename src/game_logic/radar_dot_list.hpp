@@ -0,0 +1,66 @@
+/* Copyright (C) 2022, Nikolai Wuttke. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "base/spatial_types.hpp"
+#include "base/warnings.hpp"
+#include "game_logic/actor_tag.hpp"
+
+RIGEL_DISABLE_WARNINGS
+#include <entityx/entityx.h>
+RIGEL_RESTORE_WARNINGS
+
+#include <vector>
+
+
+namespace rigel::game_logic
+{
+
+/** Incrementally maintained list of entities shown on the radar
+ *
+ * Follows the assignment and removal of AppearsOnRadar components via
+ * events, so that collecting radar dots only needs to look at the entities
+ * which can actually appear on the radar. The resulting dot positions are
+ * cached until the next call to invalidate(), which should happen whenever
+ * entities might have moved, i.e. once per game logic update.
+ */
+class RadarDotList : public entityx::Receiver<RadarDotList>
+{
+public:
+  explicit RadarDotList(entityx::EventManager& events);
+
+  /** Positions of all active radar entities within range of the radar
+   *
+   * Positions are relative to the given player position.
+   */
+  const std::vector<base::Vec2>& dots(const base::Vec2& playerPosition);
+
+  void invalidate();
+
+  void receive(
+    const entityx::ComponentAddedEvent<components::AppearsOnRadar>& event);
+  void receive(
+    const entityx::ComponentRemovedEvent<components::AppearsOnRadar>& event);
+
+private:
+  std::vector<entityx::Entity> mEntities;
+  std::vector<base::Vec2> mDots;
+  base::Vec2 mDotsPlayerPosition;
+  bool mDotsOutOfDate = true;
+};
+
+} // namespace rigel::game_logic
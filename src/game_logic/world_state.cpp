@@ -18,6 +18,7 @@
 
 #include "assets/resource_loader.hpp"
 #include "engine/base_components.hpp"
+#include "engine/component_list.hpp"
 #include "engine/life_time_components.hpp"
 #include "engine/physical_components.hpp"
 #include "engine/sprite_factory.hpp"
@@ -32,6 +33,8 @@
 #include "game_logic/interactive/item_container.hpp"
 #include "renderer/renderer.hpp"
 
+#include <thread>
+
 
 namespace rigel::game_logic
 {
@@ -39,61 +42,50 @@ namespace rigel::game_logic
 namespace
 {
 
-template <typename T>
-void copyComponentIfPresent(entityx::Entity from, entityx::Entity to)
-{
-  if (from.has_component<T>())
-  {
-    to.assign<T>(*from.component<const T>());
-  }
-}
-
-
-void copyAllComponents(entityx::Entity from, entityx::Entity to)
-{
-  using namespace engine::components;
-  using namespace game_logic::components;
-
-  copyComponentIfPresent<ActivationSettings>(from, to);
-  copyComponentIfPresent<Active>(from, to);
-  copyComponentIfPresent<ActorTag>(from, to);
-  copyComponentIfPresent<AnimationLoop>(from, to);
-  copyComponentIfPresent<AnimationSequence>(from, to);
-  copyComponentIfPresent<AppearsOnRadar>(from, to);
-  copyComponentIfPresent<AutoDestroy>(from, to);
-  copyComponentIfPresent<BehaviorController>(from, to);
-  copyComponentIfPresent<BoundingBox>(from, to);
-  copyComponentIfPresent<CollectableItem>(from, to);
-  copyComponentIfPresent<CollectableItemForCheat>(from, to);
-  copyComponentIfPresent<CollidedWithWorld>(from, to);
-  copyComponentIfPresent<CustomDamageApplication>(from, to);
-  copyComponentIfPresent<DamageInflicting>(from, to);
-  copyComponentIfPresent<DestructionEffects>(from, to);
-  copyComponentIfPresent<DrawTopMost>(from, to);
-  copyComponentIfPresent<DynamicGeometrySection>(from, to);
-  copyComponentIfPresent<ExtendedFrameList>(from, to);
-  copyComponentIfPresent<Interactable>(from, to);
-  copyComponentIfPresent<InterpolateMotion>(from, to);
-  copyComponentIfPresent<ItemBounceEffect>(from, to);
-  copyComponentIfPresent<ItemContainer>(from, to);
-  copyComponentIfPresent<MovementSequence>(from, to);
-  copyComponentIfPresent<MovingBody>(from, to);
-  copyComponentIfPresent<Orientation>(from, to);
-  copyComponentIfPresent<OverrideDrawOrder>(from, to);
-  copyComponentIfPresent<PlayerDamaging>(from, to);
-  copyComponentIfPresent<PlayerProjectile>(from, to);
-  copyComponentIfPresent<RadarDish>(from, to);
-  copyComponentIfPresent<Shootable>(from, to);
-  copyComponentIfPresent<SolidBody>(from, to);
-  copyComponentIfPresent<Sprite>(from, to);
-  copyComponentIfPresent<SpriteCascadeSpawner>(from, to);
-  copyComponentIfPresent<SpriteStrip>(from, to);
-  copyComponentIfPresent<ShootableWall>(from, to);
-  copyComponentIfPresent<TileDebris>(from, to);
-  copyComponentIfPresent<WorldPosition>(from, to);
-
-  assert(from.component_mask() == to.component_mask());
-}
+using namespace engine::components;
+using namespace game_logic::components;
+
+// All components which make up the state of a level. When adding new
+// components, they need to be listed here, otherwise synchronizeTo() won't
+// carry them over.
+using WorldStateComponents = engine::ComponentList<
+  ActivationSettings,
+  Active,
+  ActorTag,
+  AnimationLoop,
+  AnimationSequence,
+  AppearsOnRadar,
+  AutoDestroy,
+  BehaviorController,
+  BoundingBox,
+  CollectableItem,
+  CollectableItemForCheat,
+  CollidedWithWorld,
+  CustomDamageApplication,
+  DamageInflicting,
+  DestructionEffects,
+  DrawTopMost,
+  DynamicGeometrySection,
+  ExtendedFrameList,
+  Interactable,
+  InterpolateMotion,
+  ItemBounceEffect,
+  ItemContainer,
+  MovementSequence,
+  MovingBody,
+  Orientation,
+  OverrideDrawOrder,
+  PlayerDamaging,
+  PlayerProjectile,
+  RadarDish,
+  Shootable,
+  SolidBody,
+  Sprite,
+  SpriteCascadeSpawner,
+  SpriteStrip,
+  ShootableWall,
+  TileDebris,
+  WorldPosition>;
 
 } // namespace
 
@@ -193,6 +185,8 @@ WorldState::WorldState(
       sessionId.mDifficulty)
   , mRadarDishCounter(mEntities, mEventManager)
   , mCollisionChecker(&mMap, mEntities, mEventManager)
+  , mSpatialIndex(mMap.width(), mMap.height(), mEventManager)
+  , mRadarDots(mEventManager)
   , mpOptions(pOptions)
   , mPlayer(
       [&]() {
@@ -228,7 +222,12 @@ WorldState::WorldState(
         std::move(loadedLevel.mBackdropImage),
         std::move(loadedLevel.mSecondaryBackdropImage),
         loadedLevel.mBackdropScrollMode})
-  , mPhysicsSystem(&mCollisionChecker, &mMap, &mEventManager)
+  , mPhysicsSystem(
+      &mCollisionChecker,
+      &mMap,
+      &mEventManager,
+      &mActiveEntities)
+  , mLifeTimeSystem(mEventManager)
   , mDebuggingSystem(pRenderer, &mMap)
   , mPlayerInteractionSystem(
       sessionId,
@@ -237,8 +236,9 @@ WorldState::WorldState(
       pServiceProvider,
       &mEntityFactory,
       &mEventManager,
+      &mSpatialIndex,
       *pResources)
-  , mPlayerDamageSystem(&mPlayer)
+  , mPlayerDamageSystem(&mPlayer, &mSpatialIndex)
   , mPlayerProjectileSystem(
       &mEntityFactory,
       pServiceProvider,
@@ -247,6 +247,7 @@ WorldState::WorldState(
   , mDamageInflictionSystem(
       pPersistentPlayerState,
       pServiceProvider,
+      &mSpatialIndex,
       &mEventManager)
   , mDynamicGeometrySystem(
       pRenderer,
@@ -280,6 +281,10 @@ WorldState::WorldState(
   , mLevelMusicFile(loadedLevel.mMusicFile)
   , mBackdropSwitchCondition(loadedLevel.mBackdropSwitchCondition)
 {
+  // Speculative parallel physics only pays off with some spare cores
+  mPhysicsSystem.setParallelUpdateEnabled(
+    std::thread::hardware_concurrency() > 2);
+
   mEntityFactory.createEntitiesForLevel(loadedLevel.mActors);
   mDynamicGeometrySystem.initializeDynamicGeometryEntities(
     dynamicMapSections.mFallingSections);
@@ -296,6 +301,10 @@ WorldState::WorldState(
     mEarthQuakeEffect =
       EarthQuakeEffect{pServiceProvider, &mRandomGenerator, &mEventManager};
   }
+
+  // Player interaction queries the index before it's rebuilt for the
+  // current frame, so it needs to be valid from the start.
+  mSpatialIndex.build(mEntities);
 }
 
 
@@ -326,11 +335,18 @@ void WorldState::synchronizeTo(
   mPlayerDied = other.mPlayerDied;
   mIsOddFrame = other.mIsOddFrame;
 
-  mMap = other.mMap;
+  // Map revisions are unique, so the (large) copy can be skipped when the
+  // map hasn't changed since the last synchronization.
+  if (mMap.revision() != other.mMap.revision())
+  {
+    mMap = other.mMap;
+  }
+
   mRandomGenerator = other.mRandomGenerator;
   mCamera.synchronizeTo(other.mCamera);
   mParticles.synchronizeTo(other.mParticles);
   mMapRenderer.synchronizeTo(other.mMapRenderer);
+  mSpriteRenderingSystem.invalidate();
 
   if (other.mEarthQuakeEffect)
   {
@@ -343,6 +359,7 @@ void WorldState::synchronizeTo(
     mEarthQuakeEffect.reset();
   }
 
+  mLifeTimeSystem.synchronizeTo(other.mLifeTimeSystem);
   mEntities.reset();
 
   entityx::Entity playerEntity;
@@ -356,7 +373,8 @@ void WorldState::synchronizeTo(
   {
     auto clone = mEntities.create();
 
-    copyAllComponents(entity, clone);
+    assert(WorldStateComponents::coversAllComponentsOf(entity));
+    WorldStateComponents::copyAll(entity, clone);
 
     if (entity == other.mPlayer.entity())
     {
@@ -383,6 +401,9 @@ void WorldState::synchronizeTo(
       &mRandomGenerator};
     mPlayer.synchronizeTo(other.mPlayer, mEntities);
   }
+
+  // The index refers to the entities we just replaced
+  mSpatialIndex.build(mEntities);
 }
 
 } // namespace rigel::game_logic
@@ -28,6 +28,7 @@
 #include "engine/particle_system.hpp"
 #include "engine/physics_system.hpp"
 #include "engine/random_number_generator.hpp"
+#include "engine/spatial_index.hpp"
 #include "engine/sprite_rendering_system.hpp"
 #include "game_logic/behavior_controller_system.hpp"
 #include "game_logic/camera.hpp"
@@ -44,6 +45,7 @@
 #include "game_logic/player/damage_system.hpp"
 #include "game_logic/player/interaction_system.hpp"
 #include "game_logic/player/projectile_system.hpp"
+#include "game_logic/radar_dot_list.hpp"
 
 RIGEL_DISABLE_WARNINGS
 #include <entityx/entityx.h>
@@ -153,6 +155,9 @@ struct WorldState
   EntityFactory mEntityFactory;
   RadarDishCounter mRadarDishCounter;
   engine::CollisionChecker mCollisionChecker;
+  engine::SpatialIndex mSpatialIndex;
+  engine::ActiveEntityView mActiveEntities;
+  RadarDotList mRadarDots;
   const data::GameOptions* mpOptions;
 
   Player mPlayer;
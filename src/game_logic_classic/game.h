@@ -340,6 +340,22 @@ typedef struct
 } MovingMapPartState;
 
 
+// Bounding box of a sprite as used by AreSpritesTouching(), along with
+// the sprite that it was computed for
+typedef struct
+{
+  word id;
+  word frame;
+  word posX;
+  word posY;
+
+  word x;
+  word y;
+  word width;
+  word height;
+} SpriteHitbox;
+
+
 struct Context_;
 
 
@@ -644,6 +660,18 @@ bool AreSpritesTouching(
   word frame2,
   word x2,
   word y2);
+void ComputeSpriteHitbox(
+  Context* ctx,
+  word id,
+  word frame,
+  word x,
+  word y,
+  bool isSecondSprite,
+  SpriteHitbox* result);
+bool AreHitboxesTouching(
+  Context* ctx,
+  const SpriteHitbox* box1,
+  const SpriteHitbox* box2);
 
 int16_t ApplyWorldCollision(Context* ctx, word handle, word direction);
 bool FindPlayerShotInRect(
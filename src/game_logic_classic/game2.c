@@ -14,6 +14,7 @@
  *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include "base/tick_profiler.hpp"
 #include "base/warnings.hpp"
 
 #include "actors.h"
@@ -144,14 +145,14 @@ void UpdateAndDrawGame(Context* ctx)
     ctx->gfxFlashScreen = false;
   }
 
-  UpdatePlayer(ctx);
-  UpdateBackdrop(ctx);
-  UpdateMovingMapParts(ctx);
-  UpdateAndDrawActors(ctx);
-  UpdateAndDrawParticles(ctx);
-  UpdateAndDrawPlayerShots(ctx);
-  UpdateAndDrawEffects(ctx);
-  UpdateAndDrawTileDebris(ctx);
+  RIGEL_PROFILE_CALL("Player", UpdatePlayer(ctx));
+  RIGEL_PROFILE_CALL("Backdrop", UpdateBackdrop(ctx));
+  RIGEL_PROFILE_CALL("Moving map parts", UpdateMovingMapParts(ctx));
+  RIGEL_PROFILE_CALL("Actors", UpdateAndDrawActors(ctx));
+  RIGEL_PROFILE_CALL("Particles", UpdateAndDrawParticles(ctx));
+  RIGEL_PROFILE_CALL("Player shots", UpdateAndDrawPlayerShots(ctx));
+  RIGEL_PROFILE_CALL("Effects", UpdateAndDrawEffects(ctx));
+  RIGEL_PROFILE_CALL("Tile debris", UpdateAndDrawTileDebris(ctx));
 
   ctx->gfxCurrentDisplayPage = !ctx->gfxCurrentDisplayPage;
 }
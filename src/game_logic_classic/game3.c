@@ -191,12 +191,14 @@ byte TestShotCollision(Context* ctx, word handle)
   // Test fire bomb fires
   for (i = 0; i < MAX_NUM_EFFECTS; i++)
   {
-    // [PERF] This is inefficient due to the intersection test being the
-    // first condition. This loop is always doing intersection tests for
-    // 18 effects, no matter how many effects are actually present.
-    // Swapping the conditions to put the intersection test last would
-    // make this much more efficient due to short-circuiting.
+    // The original code does the intersection test first, which means it
+    // always tests all 18 effect slots, no matter how many of them are
+    // actually in use. AreSpritesTouching() has no side effects, so doing
+    // it last gives the same result while skipping most of the tests.
     if (
+      ctx->gmEffectStates[i].active &&
+      ctx->gmEffectStates[i].id == ACT_FIRE_BOMB_FIRE &&
+      ctx->gmEffectStates[i].spawnDelay <= 1 &&
       AreSpritesTouching(
         ctx,
         actor->id,
@@ -206,10 +208,7 @@ byte TestShotCollision(Context* ctx, word handle)
         ACT_FIRE_BOMB_FIRE,
         ctx->gmEffectStates[i].active - 1,
         ctx->gmEffectStates[i].x,
-        ctx->gmEffectStates[i].y) &&
-      ctx->gmEffectStates[i].active &&
-      ctx->gmEffectStates[i].id == ACT_FIRE_BOMB_FIRE &&
-      ctx->gmEffectStates[i].spawnDelay <= 1)
+        ctx->gmEffectStates[i].y))
     {
       return 1;
     }
@@ -429,13 +428,21 @@ bool Boss3_IsTouchingPlayer(Context* ctx, word handle)
  * that actor touches the player. It also performs the collision detection,
  * by testing if the given actor's sprite intersects the player's.
  *
+ * The player's hitbox is the same for most actors, so it is cached in
+ * playerHitbox by the caller. It's refreshed here whenever an actor's update
+ * has changed the player's position or animation frame.
+ *
  * [NOTE] A lot of the code here could've been avoided if the actor system had
  * been extended to feature a "damages player" flag that actors could set on
  * themselves, which would then be handled in UpdateAndDrawActors().
  */
-static void UpdateActorPlayerCollision(Context* ctx, word handle)
+static void UpdateActorPlayerCollision(
+  Context* ctx,
+  word handle,
+  SpriteHitbox* playerHitbox)
 {
   ActorState* state = ctx->gmActorStates + handle;
+  SpriteHitbox actorHitbox;
 
   if (ctx->plState == PS_DYING)
   {
@@ -446,16 +453,25 @@ static void UpdateActorPlayerCollision(Context* ctx, word handle)
     return;
   }
 
-  if (AreSpritesTouching(
-        ctx,
-        state->id,
-        state->frame,
-        state->x,
-        state->y,
-        ctx->plActorId,
-        ctx->plAnimationFrame,
-        ctx->plPosX,
-        ctx->plPosY))
+  if (
+    playerHitbox->id != ctx->plActorId ||
+    playerHitbox->frame != ctx->plAnimationFrame ||
+    playerHitbox->posX != ctx->plPosX || playerHitbox->posY != ctx->plPosY)
+  {
+    ComputeSpriteHitbox(
+      ctx,
+      ctx->plActorId,
+      ctx->plAnimationFrame,
+      ctx->plPosX,
+      ctx->plPosY,
+      true,
+      playerHitbox);
+  }
+
+  ComputeSpriteHitbox(
+    ctx, state->id, state->frame, state->x, state->y, false, &actorHitbox);
+
+  if (AreHitboxesTouching(ctx, &actorHitbox, playerHitbox))
   {
     switch (state->id)
     {
@@ -2353,6 +2369,16 @@ void UpdateAndDrawActors(Context* ctx)
   register word numActors = ctx->gmNumActors;
   ActorState* actor;
   byte savedDrawStyle;
+  SpriteHitbox playerHitbox;
+
+  ComputeSpriteHitbox(
+    ctx,
+    ctx->plActorId,
+    ctx->plAnimationFrame,
+    ctx->plPosX,
+    ctx->plPosY,
+    true,
+    &playerHitbox);
 
   for (handle = 0; handle < numActors; handle++)
   {
@@ -2488,7 +2514,7 @@ void UpdateAndDrawActors(Context* ctx)
 
       if (!actor->deleted) // If the actor wasn't killed by a shot
       {
-        UpdateActorPlayerCollision(ctx, handle);
+        UpdateActorPlayerCollision(ctx, handle, &playerHitbox);
 
         if (IsActorOnScreen(ctx, handle))
         {
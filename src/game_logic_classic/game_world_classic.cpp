@@ -18,6 +18,7 @@
 
 #include "assets/file_utils.hpp"
 #include "assets/resource_loader.hpp"
+#include "base/container_utils.hpp"
 #include "base/spatial_types_printing.hpp"
 #include "base/string_utils.hpp"
 #include "base/warnings.hpp"
@@ -35,6 +36,12 @@
 
 #include <loguru.hpp>
 
+#include <algorithm>
+#include <cstdint>
+#include <ostream>
+#include <stdexcept>
+#include <type_traits>
+
 
 using namespace rigel;
 using rigel::game_logic::detail::Bridge;
@@ -44,6 +51,11 @@ using rigel::game_logic::detail::State;
 namespace
 {
 
+// How far ahead to extrapolate camera movement when deciding which changed
+// map blocks need to be rebuilt right away
+constexpr auto CAMERA_LOOK_AHEAD_UPDATES = 16;
+
+
 word* allocateWordBuffer(
   Context* ctx,
   const size_t size,
@@ -135,6 +147,11 @@ void SetScreenShift(Context* ctx, byte amount)
 
 void HUD_ShowOnRadar(Context* ctx, word x, word y)
 {
+  if (!getBridge(ctx).mDrawCommandsWanted)
+  {
+    return;
+  }
+
   int16_t x1 = ctx->plPosX - 17;
   int16_t y1 = ctx->plPosY - 17;
 
@@ -152,6 +169,11 @@ void HUD_ShowOnRadar(Context* ctx, word x, word y)
 
 void SetPixel(Context* ctx, word x, word y, byte color)
 {
+  if (!getBridge(ctx).mDrawCommandsWanted)
+  {
+    return;
+  }
+
   getBridge(ctx).mPixelsToDraw.push_back(
     game_logic::detail::PixelDrawCmd{x, y, color});
 }
@@ -159,6 +181,11 @@ void SetPixel(Context* ctx, word x, word y, byte color)
 
 void DrawTileDebris(Context* ctx, word tileIndex, word x, word y)
 {
+  if (!getBridge(ctx).mDrawCommandsWanted)
+  {
+    return;
+  }
+
   getBridge(ctx).mTileDebrisToDraw.push_back(
     game_logic::detail::TileDrawCmd{tileIndex, x, y});
 }
@@ -197,6 +224,7 @@ void Map_SetTile(Context* ctx, word tileIndex, word x, word y)
     }
 
     getBridge(ctx).mpMapRenderer->markAsChanged({x, y});
+    getBridge(ctx).markTileAsTouched(x, y);
   }
 }
 
@@ -291,6 +319,11 @@ void DrawActor(
   word y,
   word drawStyle)
 {
+  if (!getBridge(ctx).mDrawCommandsWanted)
+  {
+    return;
+  }
+
   getBridge(ctx).mSpritesToDraw.push_back(
     game_logic::detail::SpriteDrawCmd{id, frame, x, y, drawStyle});
 }
@@ -298,6 +331,11 @@ void DrawActor(
 
 void DrawWaterArea(Context* ctx, word left, word top, word animStep)
 {
+  if (!getBridge(ctx).mDrawCommandsWanted)
+  {
+    return;
+  }
+
   getBridge(ctx).mWaterAreasToDraw.push_back(
     game_logic::detail::WaterAreaDrawCmd{left, top, animStep});
 }
@@ -377,6 +415,57 @@ std::unique_ptr<State> createState(
   return pState;
 }
 
+
+/** Invoke func for all pointers into the state's memory pool
+ *
+ * These need to be adjusted when copying the state, since each copy has its
+ * own pool.
+ */
+template <typename Func>
+void forEachMemoryPoolPointer(State& state, Func&& func)
+{
+  func(state.gfxTilesetAttributes);
+  func(state.mapData);
+  func(state.gfxActorInfoData);
+
+  for (auto& pParticleData : state.psParticleData)
+  {
+    func(pParticleData);
+  }
+
+  for (auto& actor : state.gmActorStates)
+  {
+    func(actor.tileBuffer);
+  }
+}
+
+
+// The complete state, including the memory pool holding map data, actor
+// info etc., lives in a single object. Snapshots are therefore plain
+// copies, only the pointers into the pool need adjusting, see copyState().
+static_assert(std::is_trivially_copyable_v<State>);
+
+
+/** Copy the complete state, pointing pool pointers at target's own pool
+ *
+ * Unlike a plain assignment, this makes target independent of source, so
+ * it stays valid even if source is modified or destroyed.
+ */
+void copyState(State& target, const State& source)
+{
+  target = source;
+
+  forEachMemoryPoolPointer(target, [&](word*& pointer) {
+    if (pointer)
+    {
+      const auto offset =
+        reinterpret_cast<const byte*>(pointer) - source.mmRawMem;
+      pointer = reinterpret_cast<word*>(target.mmRawMem + offset);
+    }
+  });
+}
+
+
 } // namespace
 
 
@@ -392,6 +481,12 @@ Bridge::Bridge(
   , mpMessageDisplay(pMessageDisplay)
   , mpPersistentPlayerState(pPersistentPlayerState)
 {
+  // The game logic has hard limits on how many particles and debris pieces
+  // can exist at the same time. Reserving enough space for these upfront
+  // means that draw command submission never needs to allocate.
+  mPixelsToDraw.reserve(NUM_PARTICLE_GROUPS * PARTICLES_PER_GROUP);
+  mTileDebrisToDraw.reserve(MAX_NUM_TILE_DEBRIS);
+  mSpritesToDraw.reserve(MAX_NUM_ACTORS + MAX_NUM_EFFECTS);
 }
 
 
@@ -405,20 +500,83 @@ void Bridge::resetForNewFrame()
 }
 
 
+void Bridge::resetTouchedTiles(const int mapWidth, const int mapHeight)
+{
+  mTouchedTiles.clear();
+  mTileTouchedFlags.assign(mapWidth * mapHeight, false);
+  mMapWidth = mapWidth;
+}
+
+
+void Bridge::markTileAsTouched(const int x, const int y)
+{
+  const auto index = x + y * mMapWidth;
+  if (!mTileTouchedFlags[index])
+  {
+    mTileTouchedFlags[index] = true;
+    mTouchedTiles.push_back({x, y});
+  }
+}
+
+
+namespace
+{
+
+struct ChangedTile
+{
+  int mLayer;
+  int mX;
+  int mY;
+  data::map::TileIndex mIndex;
+};
+
+
+void collectChangedTiles(
+  const data::map::Map& map,
+  const data::map::Map& pristineMap,
+  const std::vector<base::Vec2>& touchedTiles,
+  std::vector<ChangedTile>& changedTiles)
+{
+  changedTiles.clear();
+
+  if (map.revision() == pristineMap.revision())
+  {
+    return;
+  }
+
+  // Tiles which were never touched by the game logic are guaranteed to be
+  // in their original state, so there's no need to look at the whole map.
+  for (const auto& position : touchedTiles)
+  {
+    for (auto layer = 0; layer < 2; ++layer)
+    {
+      const auto index = map.tileAt(layer, position.x, position.y);
+      if (index != pristineMap.tileAt(layer, position.x, position.y))
+      {
+        changedTiles.push_back({layer, position.x, position.y, index});
+      }
+    }
+  }
+}
+
+} // namespace
+
+
 struct GameWorld_Classic::QuickSaveData
 {
   QuickSaveData(
     const data::PersistentPlayerState& persistentPlayerState,
-    const data::map::Map& map,
     const State& state)
     : mPersistentPlayerState(persistentPlayerState)
-    , mMap(map)
-    , mState(state)
   {
+    copyState(mState, state);
   }
 
   data::PersistentPlayerState mPersistentPlayerState;
-  data::map::Map mMap;
+
+  // Most of the map stays unchanged during a level, so only tiles which
+  // differ from the map as it was loaded are stored.
+  std::vector<ChangedTile> mChangedTiles;
   State mState;
 };
 
@@ -429,7 +587,8 @@ GameWorld_Classic::GameWorld_Classic(
   GameMode::Context context,
   std::optional<base::Vec2> playerPositionOverride,
   bool showWelcomeMessage,
-  const PlayerInput& initialInput)
+  const PlayerInput& initialInput,
+  std::optional<data::map::LevelData> preloadedLevel)
   : mpRenderer(context.mpRenderer)
   , mpServiceProvider(context.mpServiceProvider)
   , mUiSpriteSheet(
@@ -463,8 +622,6 @@ GameWorld_Classic::GameWorld_Classic(
       mpRenderer,
       data::GameTraits::viewportWidthPx,
       data::GameTraits::viewportHeightPx)
-  , mPreviousWindowSize(mpRenderer->windowSize())
-  , mPerElementUpscalingWasEnabled(mpOptions->mPerElementUpscalingEnabled)
   , mBridge(
       *context.mpResources,
       &mMap,
@@ -479,7 +636,8 @@ GameWorld_Classic::GameWorld_Classic(
 {
   LOG_SCOPE_FUNCTION(INFO);
 
-  loadLevel(sessionId);
+  decodeActorFrameInfo();
+  loadLevel(sessionId, std::move(preloadedLevel));
 
   if (playerPositionOverride)
   {
@@ -625,7 +783,15 @@ void GameWorld_Classic::updateGameLogic(const PlayerInput& input)
     mpServiceProvider->playMusic(mMusicFile);
   }
 
-  mMapRenderer->rebuildChangedBlocks(mMap);
+  const auto cameraPosition =
+    base::Vec2{mpState->gmCameraPosX, mpState->gmCameraPosY};
+  mMapRenderer->rebuildChangedBlocks(
+    mMap,
+    engine::predictedViewRegion(
+      {cameraPosition, data::GameTraits::mapViewportSize},
+      cameraPosition - mPreviousCameraPosition,
+      CAMERA_LOOK_AHEAD_UPDATES));
+  mPreviousCameraPosition = cameraPosition;
 }
 
 
@@ -648,12 +814,7 @@ void GameWorld_Classic::render(float)
   };
 
 
-  if (
-    mpOptions->mPerElementUpscalingEnabled != mPerElementUpscalingWasEnabled ||
-    mPreviousWindowSize != mpRenderer->windowSize())
-  {
-    mSpecialEffects.rebuildBackgroundBuffer(*mpOptions);
-  }
+  mSpecialEffects.updateBackgroundBuffer(*mpOptions);
 
   {
     auto saved = setupIngameViewport(mpRenderer, mBridge.mScreenShift);
@@ -667,9 +828,6 @@ void GameWorld_Classic::render(float)
     mpRenderer,
     {mBridge.mScreenShift + data::GameTraits::inGameViewportOffset.x, 0});
   drawTopRow();
-
-  mPerElementUpscalingWasEnabled = mpOptions->mPerElementUpscalingEnabled;
-  mPreviousWindowSize = mpRenderer->windowSize();
 }
 
 
@@ -686,17 +844,31 @@ void GameWorld_Classic::drawWorld()
     data::GameTraits::mapViewportSize};
 
 
+  // Each particle group has a single color, so pixels arrive in runs of the
+  // same color. Submitting each run with a single drawPoints() call keeps the
+  // original draw order while avoiding the per-pixel call overhead. The
+  // renderer combines all runs into a single point batch.
   auto drawParticles = [&]() {
-    for (const auto& request : mBridge.mPixelsToDraw)
+    const auto& pixels = mBridge.mPixelsToDraw;
+
+    for (auto it = pixels.begin(); it != pixels.end();)
     {
-      mpRenderer->drawPoint(
-        {request.x, request.y},
-        data::GameTraits::INGAME_PALETTE[request.color]);
+      const auto color = it->color;
+
+      mPixelPositions.clear();
+      for (; it != pixels.end() && it->color == color; ++it)
+      {
+        mPixelPositions.push_back({it->x, it->y});
+      }
+
+      mpRenderer->drawPoints(
+        mPixelPositions, data::GameTraits::INGAME_PALETTE[color]);
     }
   };
 
 
-  if (mpOptions->mPerElementUpscalingEnabled)
+  // See GameWorld::render()
+  if (mpOptions->mPerElementUpscalingEnabled && !mBridge.mPixelsToDraw.empty())
   {
     drawMapAndSprites(region);
 
@@ -721,44 +893,74 @@ void GameWorld_Classic::drawMapAndSprites(const base::Rect<int>& region)
   using namespace detail;
 
   auto destRect = [&](const SpriteDrawCmd& request) {
-    RIGEL_DISABLE_WARNINGS
-
-    // For C macros used below
-    auto ctx = mpState.get();
-
-    const auto offset =
-      mpState->gfxActorInfoData[request.id] + request.frame * 8;
+    const auto info = actorFrameInfo(request.id, request.frame);
     const auto topLeft = base::Vec2{request.x, request.y} -
       base::Vec2{mpState->gmCameraPosX, mpState->gmCameraPosY} -
-      base::Vec2{0, AINFO_HEIGHT(offset) - 1} +
-      base::Vec2{AINFO_X_OFFSET(offset), AINFO_Y_OFFSET(offset)};
+      base::Vec2{0, info.mHeight - 1} +
+      base::Vec2{info.mXOffset, info.mYOffset};
     return base::Rect<int>{
       data::tilesToPixels(topLeft),
-      data::tilesToPixels(
-        base::Size{AINFO_WIDTH(offset), AINFO_HEIGHT(offset)})};
-
-    RIGEL_RESTORE_WARNINGS
+      data::tilesToPixels(base::Size{info.mWidth, info.mHeight})};
   };
 
 
-  auto drawSprite = [&](const SpriteDrawCmd& request) {
-    const auto imageId = mImageIdTable[request.id] + request.frame;
-
-    if (request.drawStyle == DS_WHITEFLASH)
-    {
-      const auto innerGuard = renderer::saveState(mpRenderer);
-      mpRenderer->setOverlayColor(data::GameTraits::INGAME_PALETTE[15]);
-      mpSpriteFactory->textureAtlas().draw(imageId, destRect(request));
-    }
-    else if (request.drawStyle == DS_TRANSLUCENT)
+  // Sprites with the same texture and draw style are grouped together so
+  // that each group can be drawn in a single batch, see
+  // assignSpriteBatchGroups().
+  auto drawSprites = [&](auto&& shouldDraw) {
+    mBatchedSprites.clear();
+    for (const auto& request : mBridge.mSpritesToDraw)
     {
-      const auto [textureId, texCoords] =
-        mpSpriteFactory->textureAtlas().drawData(imageId);
-      mSpecialEffects.drawCloakEffect(textureId, texCoords, destRect(request));
+      if (shouldDraw(request))
+      {
+        const auto imageId = mImageIdTable[request.id] + request.frame;
+        mpSpriteFactory->requireImage(imageId);
+        mBatchedSprites.push_back(BatchedSprite{
+          destRect(request),
+          imageId,
+          mpSpriteFactory->textureAtlas().textureId(imageId),
+          request.drawStyle,
+          0});
+      }
     }
-    else
+
+    assignSpriteBatchGroups();
+
+    const auto& atlas = mpSpriteFactory->textureAtlas();
+    for (auto it = mBatchedSprites.begin(); it != mBatchedSprites.end();)
     {
-      mpSpriteFactory->textureAtlas().draw(imageId, destRect(request));
+      const auto group = it->mBatchGroup;
+      const auto iGroupEnd = std::find_if(
+        it, mBatchedSprites.end(), [group](const BatchedSprite& sprite) {
+          return sprite.mBatchGroup != group;
+        });
+
+      if (it->mDrawStyle == DS_WHITEFLASH)
+      {
+        const auto innerGuard = renderer::saveState(mpRenderer);
+        mpRenderer->setOverlayColor(data::GameTraits::INGAME_PALETTE[15]);
+        for (; it != iGroupEnd; ++it)
+        {
+          atlas.draw(it->mImageId, it->mDestRect);
+        }
+      }
+      else if (it->mDrawStyle == DS_TRANSLUCENT)
+      {
+        for (; it != iGroupEnd; ++it)
+        {
+          const auto [textureId, texCoords] = atlas.drawData(it->mImageId);
+          mSpecialEffects.drawCloakEffect(textureId, texCoords, it->mDestRect);
+        }
+
+        mSpecialEffects.flushCloakEffects();
+      }
+      else
+      {
+        for (; it != iGroupEnd; ++it)
+        {
+          atlas.draw(it->mImageId, it->mDestRect);
+        }
+      }
     }
   };
 
@@ -784,26 +986,19 @@ void GameWorld_Classic::drawMapAndSprites(const base::Rect<int>& region)
   auto drawBackgroundLayers = [&]() {
     mMapRenderer->renderBackground(region.topLeft, region.size);
 
-    for (const auto& request : mBridge.mSpritesToDraw)
-    {
-      if (request.drawStyle != DS_INVISIBLE && request.drawStyle != DS_IN_FRONT)
-      {
-        drawSprite(request);
-      }
-    }
+    drawSprites([](const SpriteDrawCmd& request) {
+      return request.drawStyle != DS_INVISIBLE &&
+        request.drawStyle != DS_IN_FRONT;
+    });
   };
 
 
   auto drawForegroundLayers = [&]() {
     mMapRenderer->renderForeground(region.topLeft, region.size);
 
-    for (const auto& request : mBridge.mSpritesToDraw)
-    {
-      if (request.drawStyle != DS_INVISIBLE && request.drawStyle == DS_IN_FRONT)
-      {
-        drawSprite(request);
-      }
-    }
+    drawSprites([](const SpriteDrawCmd& request) {
+      return request.drawStyle == DS_IN_FRONT;
+    });
 
     for (const auto& request : mBridge.mTileDebrisToDraw)
     {
@@ -838,28 +1033,157 @@ void GameWorld_Classic::drawMapAndSprites(const base::Rect<int>& region)
 
     mSpecialEffects.drawBackgroundBuffer();
 
-    if (!mVisibleWaterAreas.empty())
+    // In the original game logic, each water area actor has its own
+    // animation step. But all actors start out with the same step value, and
+    // they are all updated each frame. Consequently, the animation step is
+    // effectively a single global value, even if not represented as such.
+    // Here, we look for the first water area with an animation step, and use
+    // that as the global value for all water areas.
+    const auto iFirstAnimatedArea = std::find_if(
+      mBridge.mWaterAreasToDraw.begin(),
+      mBridge.mWaterAreasToDraw.end(),
+      [](const WaterAreaDrawCmd& cmd) { return cmd.animStep != 0; });
+
+    const auto waterAnimStep =
+      iFirstAnimatedArea != mBridge.mWaterAreasToDraw.end()
+      ? iFirstAnimatedArea->animStep - 1
+      : 0;
+    mSpecialEffects.drawEffects(mVisibleWaterAreas, waterAnimStep);
+
+    drawForegroundLayers();
+  }
+}
+
+
+void GameWorld_Classic::decodeActorFrameInfo()
+{
+  RIGEL_DISABLE_WARNINGS
+
+  // For C macros used below
+  auto ctx = mpState.get();
+
+  // The actor info data starts with a table of offsets, one per actor ID.
+  // The first offset therefore also tells us the number of entries.
+  // Offsets and frame counts are clamped to the memory pool, in case the
+  // file is corrupt.
+  constexpr auto POOL_SIZE_IN_WORDS = MM_TOTAL_SIZE / sizeof(word);
+  const auto numEntries = std::min<std::size_t>(
+    ctx->gfxActorInfoData[0], POOL_SIZE_IN_WORDS);
+
+  mActorFrameInfo.clear();
+  mActorFrameInfoStart.clear();
+
+  for (auto id = std::size_t{0}; id < numEntries; ++id)
+  {
+    mActorFrameInfoStart.push_back(std::uint32_t(mActorFrameInfo.size()));
+
+    const auto firstOffset = std::size_t{ctx->gfxActorInfoData[id]};
+    if (firstOffset >= POOL_SIZE_IN_WORDS)
     {
-      // In the original game logic, each water area actor has its own
-      // animation step. But all actors start out with the same step value, and
-      // they are all updated each frame. Consequently, the animation step is
-      // effectively a single global value, even if not represented as such.
-      // Here, we look for the first water area with an animation step, and use
-      // that as the global value for all water areas.
-      const auto iFirstAnimatedArea = std::find_if(
-        mBridge.mWaterAreasToDraw.begin(),
-        mBridge.mWaterAreasToDraw.end(),
-        [](const WaterAreaDrawCmd& cmd) { return cmd.animStep != 0; });
-
-      const auto waterAnimStep =
-        iFirstAnimatedArea != mBridge.mWaterAreasToDraw.end()
-        ? iFirstAnimatedArea->animStep - 1
-        : 0;
-      mSpecialEffects.drawWaterEffect(mVisibleWaterAreas, waterAnimStep);
+      continue;
     }
 
-    drawForegroundLayers();
+    const auto numFrames = std::size_t{AINFO_NUM_FRAMES(firstOffset)};
+    for (auto frame = std::size_t{0}; frame < numFrames; ++frame)
+    {
+      const auto offset = firstOffset + frame * 8;
+      if (offset + 8 > POOL_SIZE_IN_WORDS)
+      {
+        break;
+      }
+
+      mActorFrameInfo.push_back(ActorFrameInfo{
+        AINFO_X_OFFSET(offset),
+        AINFO_Y_OFFSET(offset),
+        AINFO_WIDTH(offset),
+        AINFO_HEIGHT(offset)});
+    }
   }
+
+  mActorFrameInfoStart.push_back(std::uint32_t(mActorFrameInfo.size()));
+
+  RIGEL_RESTORE_WARNINGS
+}
+
+
+auto GameWorld_Classic::actorFrameInfo(const int id, const int frame) const
+  -> ActorFrameInfo
+{
+  if (std::size_t(id) + 1 < mActorFrameInfoStart.size())
+  {
+    const auto index = mActorFrameInfoStart[id] + std::uint32_t(frame);
+    if (index < mActorFrameInfoStart[id + 1])
+    {
+      return mActorFrameInfo[index];
+    }
+  }
+
+  // Out of range requests are decoded directly, to give the same results
+  // as the original code would.
+  RIGEL_DISABLE_WARNINGS
+
+  // For C macros used below
+  auto ctx = mpState.get();
+
+  const auto offset = ctx->gfxActorInfoData[id] + frame * 8;
+  return ActorFrameInfo{
+    AINFO_X_OFFSET(offset),
+    AINFO_Y_OFFSET(offset),
+    AINFO_WIDTH(offset),
+    AINFO_HEIGHT(offset)};
+
+  RIGEL_RESTORE_WARNINGS
+}
+
+
+void GameWorld_Classic::assignSpriteBatchGroups()
+{
+  // Same approach as in SpriteRenderingSystem::assignBatchGroups(): Groups
+  // are formed greedily in draw order. A sprite can join an earlier group
+  // with matching texture & draw style, but only if it doesn't overlap any
+  // group that comes after that one - otherwise, moving it forward in the
+  // draw order would change the visible result.
+  mSpriteBatchGroups.clear();
+
+  for (auto& sprite : mBatchedSprites)
+  {
+    auto iGroup = mSpriteBatchGroups.rbegin();
+    for (; iGroup != mSpriteBatchGroups.rend(); ++iGroup)
+    {
+      if (
+        iGroup->mTexture == sprite.mTexture &&
+        iGroup->mDrawStyle == sprite.mDrawStyle)
+      {
+        break;
+      }
+
+      if (iGroup->mBounds.intersects(sprite.mDestRect))
+      {
+        iGroup = mSpriteBatchGroups.rend();
+        break;
+      }
+    }
+
+    if (iGroup != mSpriteBatchGroups.rend())
+    {
+      iGroup->mBounds = base::unite(iGroup->mBounds, sprite.mDestRect);
+      sprite.mBatchGroup =
+        int(std::distance(iGroup, mSpriteBatchGroups.rend())) - 1;
+    }
+    else
+    {
+      sprite.mBatchGroup = int(mSpriteBatchGroups.size());
+      mSpriteBatchGroups.push_back(
+        SpriteBatchGroup{sprite.mDestRect, sprite.mTexture, sprite.mDrawStyle});
+    }
+  }
+
+  std::stable_sort(
+    mBatchedSprites.begin(),
+    mBatchedSprites.end(),
+    [](const BatchedSprite& lhs, const BatchedSprite& rhs) {
+      return lhs.mBatchGroup < rhs.mBatchGroup;
+    });
 }
 
 
@@ -1081,8 +1405,19 @@ void GameWorld_Classic::quickSave()
 
   LOG_F(INFO, "Creating quick save");
 
-  mpQuickSave =
-    std::make_unique<QuickSaveData>(*mpPersistentPlayerState, mMap, *mpState);
+  if (mpQuickSave)
+  {
+    mpQuickSave->mPersistentPlayerState = *mpPersistentPlayerState;
+    copyState(mpQuickSave->mState, *mpState);
+  }
+  else
+  {
+    mpQuickSave =
+      std::make_unique<QuickSaveData>(*mpPersistentPlayerState, *mpState);
+  }
+
+  collectChangedTiles(
+    mMap, mPristineMap, mBridge.mTouchedTiles, mpQuickSave->mChangedTiles);
 
   mMessageDisplay.setMessage(
     data::Messages::QuickSaved, ui::MessagePriority::Menu);
@@ -1101,10 +1436,32 @@ void GameWorld_Classic::quickLoad()
   LOG_F(INFO, "Loading quick save");
 
   *mpPersistentPlayerState = mpQuickSave->mPersistentPlayerState;
-  mMap = mpQuickSave->mMap;
-  *mpState = mpQuickSave->mState;
 
-  mMapRenderer->rebuildAllBlocks(mMap);
+  // Only touched tiles can differ from the pristine map, both now and at
+  // the time of saving, so resetting those is enough to restore the map.
+  // The list of touched tiles remains valid, since it only ever grows.
+  for (const auto& position : mBridge.mTouchedTiles)
+  {
+    for (auto layer = 0; layer < 2; ++layer)
+    {
+      mMap.setTileAt(
+        layer,
+        position.x,
+        position.y,
+        mPristineMap.tileAt(layer, position.x, position.y));
+    }
+
+    mMapRenderer->markAsChanged(position);
+  }
+
+  for (const auto& tile : mpQuickSave->mChangedTiles)
+  {
+    mMap.setTileAt(tile.mLayer, tile.mX, tile.mY, tile.mIndex);
+  }
+
+  copyState(*mpState, mpQuickSave->mState);
+
+  mMapRenderer->rebuildChangedBlocks(mMap);
 
   syncBackdrop();
 
@@ -1121,6 +1478,57 @@ bool GameWorld_Classic::canQuickLoad() const
 }
 
 
+StateHash GameWorld_Classic::stateHash() const
+{
+  const auto& s = *mpState;
+
+  StateHasher playerHasher;
+  playerHasher.add(s.plPosX)
+    .add(s.plPosY)
+    .add(s.plState)
+    .add(s.plAnimationFrame)
+    .add(s.plHealth)
+    .add(s.plScore)
+    .add(s.plAmmo)
+    .add(s.plWeapon);
+
+  StateHasher actorHasher;
+  for (auto i = 0; i < s.gmNumActors; ++i)
+  {
+    const auto& actor = s.gmActorStates[i];
+    actorHasher.add(actor.deleted);
+    if (actor.deleted)
+    {
+      continue;
+    }
+
+    actorHasher.add(actor.id)
+      .add(actor.frame)
+      .add(actor.x)
+      .add(actor.y)
+      .add(actor.health)
+      .add(actor.var1)
+      .add(actor.var2)
+      .add(actor.var3)
+      .add(actor.var4)
+      .add(actor.var5);
+  }
+
+  StateHasher globalsHasher;
+  globalsHasher.add(s.gmRngIndex)
+    .add(s.gmCameraPosX)
+    .add(s.gmCameraPosY)
+    .add(s.gmGameState)
+    .add(s.gmNumActors);
+
+  return StateHash{
+    playerHasher.value(),
+    actorHasher.value(),
+    mMap.contentHash(),
+    globalsHasher.value()};
+}
+
+
 void GameWorld_Classic::printDebugText(std::ostream& stream) const
 {
   const auto cameraPos =
@@ -1175,6 +1583,10 @@ void GameWorld_Classic::printDebugText(std::ostream& stream) const
   printNumberAligned("Particle groups: ", numParticleGroups);
   printNumberAligned("Tile debris:     ", numTileDebris);
 
+  const auto blockStats = mMapRenderer->blockStatistics();
+  printNumberAligned("Blocks drawn:    ", blockStats.mDrawnBlocks);
+  printNumberAligned("Blocks skipped:  ", blockStats.mSkippedBlocks);
+
   if (mpOptions->mPerElementUpscalingEnabled)
   {
     stream << "Hi-res mode ON\n";
@@ -1182,7 +1594,9 @@ void GameWorld_Classic::printDebugText(std::ostream& stream) const
 }
 
 
-void GameWorld_Classic::loadLevel(const data::GameSessionId& sessionId)
+void GameWorld_Classic::loadLevel(
+  const data::GameSessionId& sessionId,
+  std::optional<data::map::LevelData> preloadedLevel)
 {
   {
     const auto levelDataRaw = mpResources->file(
@@ -1246,11 +1660,17 @@ void GameWorld_Classic::loadLevel(const data::GameSessionId& sessionId)
 
   // Now load the level file again using Rigel's functions, in order to get the
   // map data in the right format as needed by the MapRenderer. This also makes
-  // it easier for us to parse the level flags.
-  const auto levelData = assets::loadLevel(
-    assets::levelFileName(sessionId.mEpisode, sessionId.mLevel),
-    *mpResources,
-    sessionId.mDifficulty);
+  // it easier for us to parse the level flags. If the level was already
+  // decoded in the background, we can skip this step.
+  if (!preloadedLevel)
+  {
+    preloadedLevel = assets::loadLevel(
+      assets::levelFileName(sessionId.mEpisode, sessionId.mLevel),
+      *mpResources,
+      sessionId.mDifficulty);
+  }
+
+  auto& levelData = *preloadedLevel;
 
   // SetMapSize() in the original code
   mpState->mapWidth = word(levelData.mMap.width());
@@ -1271,6 +1691,8 @@ void GameWorld_Classic::loadLevel(const data::GameSessionId& sessionId)
     levelData.mBackdropSwitchCondition == BSC::OnTeleportation;
 
   mMap = std::move(levelData.mMap);
+  mPristineMap = mMap;
+  mBridge.resetTouchedTiles(mMap.width(), mMap.height());
 
   mMapRenderer.emplace(
     mpRenderer,
@@ -1285,6 +1707,11 @@ void GameWorld_Classic::loadLevel(const data::GameSessionId& sessionId)
 
   mMusicFile = levelData.mMusicFile;
 
+  const auto actorIds = utils::transformed(
+    levelData.mActors,
+    [](const data::map::LevelData::Actor& actor) { return actor.mID; });
+  mpSpriteFactory->prefetchActors(actorIds);
+
   SpawnLevelActors(mpState.get());
 
   if (data::isBossLevel(mSessionId.mLevel))
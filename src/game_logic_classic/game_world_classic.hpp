@@ -96,6 +96,10 @@ struct Bridge
 
   void resetForNewFrame();
 
+  void resetTouchedTiles(int mapWidth, int mapHeight);
+  void markTileAsTouched(int x, int y);
+
+
   std::vector<SpriteDrawCmd> mSpritesToDraw;
   std::vector<PixelDrawCmd> mPixelsToDraw;
   std::vector<TileDrawCmd> mTileDebrisToDraw;
@@ -103,6 +107,17 @@ struct Bridge
   std::vector<base::Vec2> mRadarDots;
   std::uint8_t mScreenShift = 0;
 
+  // When false, the draw command hooks discard their input. See
+  // IGameWorld::setDrawOutputWanted().
+  bool mDrawCommandsWanted = true;
+
+  // All tiles which have been modified by the game logic since the level
+  // was loaded, without duplicates. This is a superset of the tiles that
+  // differ from the map as it was loaded.
+  std::vector<base::Vec2> mTouchedTiles;
+  std::vector<bool> mTileTouchedFlags;
+  int mMapWidth = 0;
+
   const char* mpErrorMessage = nullptr;
 
   data::LevelHints mLevelHints;
@@ -126,7 +141,8 @@ public:
     GameMode::Context context,
     std::optional<base::Vec2> playerPositionOverride = std::nullopt,
     bool showWelcomeMessage = false,
-    const PlayerInput& initialInput = PlayerInput{});
+    const PlayerInput& initialInput = PlayerInput{},
+    std::optional<data::map::LevelData> preloadedLevel = std::nullopt);
   ~GameWorld_Classic() override;
 
   GameWorld_Classic(const GameWorld_Classic&) = delete;
@@ -138,6 +154,16 @@ public:
   bool needsPerElementUpscaling() const override;
 
   void updateGameLogic(const PlayerInput& input) override;
+  // Updating rebuilds changed map blocks and switches backdrops, both of
+  // which need the renderer.
+  bool supportsPipelinedUpdates() const override { return false; }
+  void setDrawOutputWanted(const bool wanted) override
+  {
+    mBridge.mDrawCommandsWanted = wanted;
+  }
+  // Rendering is driven by draw commands from the original game logic,
+  // which doesn't leave any effects to thin out.
+  void setEffectsDetail(EffectsDetail) override { }
   void render(float interpolationFactor = 0.0f) override;
   void processEndOfFrameActions() override;
   void updateBackdropAutoScrolling(engine::TimeDelta dt) override;
@@ -157,17 +183,49 @@ public:
   void debugToggleWorldCollisionDataDisplay() override { }
   void debugToggleGridDisplay() override { }
   void printDebugText(std::ostream& stream) const override;
+  StateHash stateHash() const override;
 
 private:
   void drawWorld();
   void drawMapAndSprites(const base::Rect<int>& region);
   void updateVisibleWaterAreas();
-  void loadLevel(const data::GameSessionId& sessionId);
+  void loadLevel(
+    const data::GameSessionId& sessionId,
+    std::optional<data::map::LevelData> preloadedLevel = std::nullopt);
   void syncBackdrop();
   void syncPlayerModel();
 
   struct QuickSaveData;
 
+  // Decoded form of the per-frame data found in gfxActorInfoData
+  struct ActorFrameInfo
+  {
+    std::int16_t mXOffset;
+    std::int16_t mYOffset;
+    std::uint16_t mWidth;
+    std::uint16_t mHeight;
+  };
+
+  struct BatchedSprite
+  {
+    base::Rect<int> mDestRect;
+    int mImageId;
+    renderer::TextureId mTexture;
+    std::uint16_t mDrawStyle;
+    int mBatchGroup;
+  };
+
+  struct SpriteBatchGroup
+  {
+    base::Rect<int> mBounds;
+    renderer::TextureId mTexture;
+    std::uint16_t mDrawStyle;
+  };
+
+  void assignSpriteBatchGroups();
+  void decodeActorFrameInfo();
+  ActorFrameInfo actorFrameInfo(int id, int frame) const;
+
   renderer::Renderer* mpRenderer;
   IGameServiceProvider* mpServiceProvider;
   engine::TiledTexture mUiSpriteSheet;
@@ -177,12 +235,15 @@ private:
   const assets::ResourceLoader* mpResources;
   engine::SpriteFactory* mpSpriteFactory;
   std::vector<int> mImageIdTable;
+  std::vector<ActorFrameInfo> mActorFrameInfo;
+  std::vector<std::uint32_t> mActorFrameInfoStart;
 
   data::GameSessionId mSessionId;
   std::string mMusicFile;
   bool mIsUsingSecondaryBackdrop = false;
 
   data::map::Map mMap;
+  data::map::Map mPristineMap;
   std::optional<engine::MapRenderer> mMapRenderer;
   data::PersistentPlayerState mPlayerModelAtLevelStart;
   ui::HudRenderer mHudRenderer;
@@ -190,8 +251,10 @@ private:
   engine::SpecialEffectsRenderer mSpecialEffects;
   renderer::RenderTargetTexture mLowResLayer;
   std::vector<engine::WaterEffectArea> mVisibleWaterAreas;
-  base::Size mPreviousWindowSize;
-  bool mPerElementUpscalingWasEnabled;
+  std::vector<BatchedSprite> mBatchedSprites;
+  std::vector<SpriteBatchGroup> mSpriteBatchGroups;
+  std::vector<base::Vec2> mPixelPositions;
+  base::Vec2 mPreviousCameraPosition;
 
   detail::Bridge mBridge;
   std::unique_ptr<detail::State> mpState;
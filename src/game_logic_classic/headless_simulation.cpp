@@ -0,0 +1,369 @@
+/* Copyright (C) 2022, Nikolai Wuttke. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "headless_simulation.h"
+
+#include "assets/file_utils.hpp"
+#include "engine/random_number_generator.hpp"
+
+#include "game.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+
+
+struct RigelHeadlessSim
+{
+  Context mState;
+
+  // Actor IDs of the items currently in the player's inventory
+  std::array<word, NUM_INVENTORY_SLOTS> mInventory;
+  std::size_t mNumInventoryItems = 0;
+
+  const char* mpErrorMessage = nullptr;
+  std::uint32_t mTicksElapsed = 0;
+};
+
+
+using namespace rigel;
+
+
+namespace
+{
+
+// data::GameTraits isn't used here since it depends on SDL
+constexpr auto MAP_DATA_SIZE = 65500u;
+constexpr auto MAP_DATA_WORDS = 32750u;
+constexpr auto TILESET_ATTRIBUTES_SIZE = 3600u;
+
+
+RigelHeadlessSim& getSim(Context* ctx)
+{
+  return *static_cast<RigelHeadlessSim*>(ctx->pRigelBridge);
+}
+
+
+word* allocateWordBuffer(
+  Context* ctx,
+  const size_t size,
+  const ChunkType chunkType)
+{
+  return static_cast<word*>(MM_PushChunk(ctx, word(size), chunkType));
+}
+
+
+// Mirrors the level loading done by GameWorld_Classic, minus everything
+// that's only needed for presentation.
+void loadLevel(Context* ctx, const RigelHeadlessLevelData& levelData)
+{
+  const auto levelDataRaw = base::ArrayView<std::uint8_t>(
+    levelData.levelFileData,
+    base::ArrayView<std::uint8_t>::size_type(levelData.levelFileSize));
+  assets::LeStreamReader reader(levelDataRaw);
+
+  const dword headerSize = reader.readU16();
+
+  if (headerSize >= sizeof(ctx->levelHeaderData))
+  {
+    throw std::runtime_error("Level has too much data for Classic mode");
+  }
+
+  if (levelData.levelFileSize < headerSize + sizeof(word) + MAP_DATA_SIZE)
+  {
+    throw std::runtime_error("Invalid or corrupt level file");
+  }
+
+  if (levelData.czoneFileSize < TILESET_ATTRIBUTES_SIZE)
+  {
+    throw std::runtime_error("Invalid or corrupt CZone file");
+  }
+
+  std::memcpy(
+    ctx->levelHeaderData, levelDataRaw.data() + sizeof(word), headerSize);
+
+  // Skip over the CZone, backdrop and music file names
+  reader.skipBytes(3 * 13);
+  const auto flags = reader.readU8();
+  reader.skipBytes(3);
+
+  ctx->levelActorListSize = reader.readU16();
+
+  // See GameWorld_Classic::loadLevel() for an explanation
+  if (45 + ctx->levelActorListSize * sizeof(word) > headerSize - sizeof(word))
+  {
+    throw std::runtime_error("Invalid or corrupt level file");
+  }
+
+  reader.skipBytes(ctx->levelActorListSize * sizeof(word));
+  const auto width = reader.readU16();
+
+  if (width == 0 || (width & (width - 1)) != 0)
+  {
+    throw std::runtime_error("Level file has invalid width");
+  }
+
+  ctx->mapData = allocateWordBuffer(ctx, MAP_DATA_SIZE, CT_MAP_DATA);
+  std::memcpy(
+    ctx->mapData,
+    levelDataRaw.data() + headerSize + sizeof(word),
+    MAP_DATA_SIZE);
+
+  ctx->gfxTilesetAttributes =
+    allocateWordBuffer(ctx, TILESET_ATTRIBUTES_SIZE, CT_CZONE);
+  std::memcpy(
+    ctx->gfxTilesetAttributes,
+    levelData.czoneFileData,
+    TILESET_ATTRIBUTES_SIZE);
+
+  // SetMapSize() in the original code
+  ctx->mapWidth = width;
+  ctx->mapWidthShift = word(std::log2(width));
+  ctx->mapBottom = word(MAP_DATA_WORDS / width - 1);
+  ctx->mapViewportHeight = VIEWPORT_HEIGHT;
+
+  // ParseLevelFlags() in the original code. This follows the same
+  // precedence rules as assets::loadLevel().
+  auto flagBitSet = [flags](const std::uint8_t bitMask) {
+    return (flags & bitMask) != 0;
+  };
+
+  const auto isParallax = flagBitSet(0x1) || flagBitSet(0x2);
+  const auto isAutoScrolling =
+    !isParallax && (flagBitSet(0x8) || flagBitSet(0x10));
+
+  ctx->mapParallaxHorizontal = !flagBitSet(0x1) && flagBitSet(0x2);
+  ctx->mapHasEarthquake = flagBitSet(0x20);
+  ctx->mapHasReactorDestructionEvent = !isAutoScrolling && flagBitSet(0x40);
+  ctx->mapSwitchBackdropOnTeleport =
+    !isAutoScrolling && !flagBitSet(0x40) && flagBitSet(0x80);
+}
+
+
+void initializeState(RigelHeadlessSim& sim, const RigelHeadlessLevelData& data)
+{
+  auto ctx = &sim.mState;
+
+  ctx->pRigelBridge = &sim;
+
+  MM_Init(ctx);
+  InitParticleSystem(ctx);
+
+  ctx->gfxActorInfoData =
+    allocateWordBuffer(ctx, data.actorInfoSize, CT_COMMON);
+  std::memcpy(ctx->gfxActorInfoData, data.actorInfoData, data.actorInfoSize);
+
+  ctx->gmBeaconActivated = false;
+  ResetGameState(ctx);
+
+  ctx->gmCurrentLevel = data.level;
+  ctx->gmCurrentEpisode = data.episode;
+  ctx->gmDifficulty = byte(data.difficulty + 1);
+
+  ctx->plWeapon = WPN_REGULAR;
+  ctx->plScore = 0;
+  ctx->plAmmo = MAX_AMMO;
+  ctx->plHealth = PLAYER_MAX_HEALTH;
+
+  loadLevel(ctx, data);
+
+  SpawnLevelActors(ctx);
+  CenterViewOnPlayer(ctx);
+}
+
+} // namespace
+
+
+//
+// Hook functions - null implementations
+//
+
+byte RandomNumber(Context* ctx)
+{
+  ctx->gmRngIndex++;
+  return byte(engine::RANDOM_NUMBER_TABLE[ctx->gmRngIndex]);
+}
+
+
+word Map_GetTile(Context* ctx, word x, word y)
+{
+  if (int16_t(y) < 0)
+  {
+    return 0;
+  }
+
+  return *(ctx->mapData + x + (y << ctx->mapWidthShift));
+}
+
+
+void Map_SetTile(Context* ctx, word tileIndex, word x, word y)
+{
+  *(ctx->mapData + x + (y << ctx->mapWidthShift)) = tileIndex;
+}
+
+
+void AddInventoryItem(Context* ctx, word item)
+{
+  auto& sim = getSim(ctx);
+
+  if (sim.mNumInventoryItems < sim.mInventory.size())
+  {
+    sim.mInventory[sim.mNumInventoryItems++] = item;
+  }
+}
+
+
+bool RemoveFromInventory(Context* ctx, word item)
+{
+  auto& sim = getSim(ctx);
+
+  const auto iEnd = sim.mInventory.begin() + sim.mNumInventoryItems;
+  const auto iItem = std::find(sim.mInventory.begin(), iEnd, item);
+  if (iItem == iEnd)
+  {
+    return false;
+  }
+
+  std::copy(std::next(iItem), iEnd, iItem);
+  --sim.mNumInventoryItems;
+  return true;
+}
+
+
+void RaiseError(Context* ctx, const char* msg)
+{
+  getSim(ctx).mpErrorMessage = msg;
+}
+
+
+void ShowInGameMessage(Context*, MessageId) { }
+void ShowLevelSpecificHint(Context*) { }
+void ShowTutorial(Context*, TutorialId) { }
+void DrawActor(Context*, word, word, word, word, word) { }
+void DrawWaterArea(Context*, word, word, word) { }
+void DrawTileDebris(Context*, word, word, word) { }
+void SetPixel(Context*, word, word, byte) { }
+void HUD_ShowOnRadar(Context*, word, word) { }
+void SetScreenShift(Context*, byte) { }
+void PlaySound(Context*, int16_t) { }
+void StopMusic(Context*) { }
+
+
+//
+// Public API
+//
+
+RigelHeadlessSim* RigelHeadlessSim_Create(
+  const RigelHeadlessLevelData* pLevelData,
+  const char** pErrorMessage)
+{
+  auto fail = [&](const char* message) -> RigelHeadlessSim* {
+    if (pErrorMessage)
+    {
+      *pErrorMessage = message;
+    }
+
+    return nullptr;
+  };
+
+  if (
+    !pLevelData || !pLevelData->actorInfoData || !pLevelData->levelFileData ||
+    !pLevelData->czoneFileData)
+  {
+    return fail("Missing game data");
+  }
+
+  // The state is quite large, so we allocate it on the heap
+  auto pSim = std::make_unique<RigelHeadlessSim>();
+
+  try
+  {
+    initializeState(*pSim, *pLevelData);
+  }
+  catch (const std::exception&)
+  {
+    return fail("Invalid or corrupt level data");
+  }
+
+  // Same as in the GameWorld_Classic constructor
+  const auto noInput = RigelHeadlessInput{};
+  if (!RigelHeadlessSim_Step(pSim.get(), &noInput))
+  {
+    return fail(pSim->mpErrorMessage);
+  }
+
+  return pSim.release();
+}
+
+
+void RigelHeadlessSim_Destroy(RigelHeadlessSim* pSim)
+{
+  delete pSim;
+}
+
+
+bool RigelHeadlessSim_Step(
+  RigelHeadlessSim* pSim,
+  const RigelHeadlessInput* pInput)
+{
+  auto ctx = &pSim->mState;
+
+  ctx->inputMoveUp = pInput->moveUp;
+  ctx->inputMoveDown = pInput->moveDown;
+  ctx->inputMoveLeft = pInput->moveLeft;
+  ctx->inputMoveRight = pInput->moveRight;
+  ctx->inputFire = pInput->fire;
+  ctx->inputJump = pInput->jump;
+
+  UpdateAndDrawGame(ctx);
+  ++pSim->mTicksElapsed;
+
+  return pSim->mpErrorMessage == nullptr;
+}
+
+
+const char* RigelHeadlessSim_ErrorMessage(const RigelHeadlessSim* pSim)
+{
+  return pSim->mpErrorMessage;
+}
+
+
+void RigelHeadlessSim_GetInfo(
+  const RigelHeadlessSim* pSim,
+  RigelHeadlessSimInfo* pInfo)
+{
+  const auto& state = pSim->mState;
+
+  pInfo->playerPosX = state.plPosX;
+  pInfo->playerPosY = state.plPosY;
+  pInfo->cameraPosX = state.gmCameraPosX;
+  pInfo->cameraPosY = state.gmCameraPosY;
+  pInfo->score = state.plScore;
+  pInfo->health = state.plHealth;
+  pInfo->ammo = state.plAmmo;
+  pInfo->weapon = state.plWeapon;
+  pInfo->gameState = state.gmGameState;
+  pInfo->ticksElapsed = pSim->mTicksElapsed;
+}
+
+
+const Context* RigelHeadlessSim_State(const RigelHeadlessSim* pSim)
+{
+  return &pSim->mState;
+}
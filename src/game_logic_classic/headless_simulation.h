@@ -0,0 +1,130 @@
+/* Copyright (C) 2022, Nikolai Wuttke. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+/* C API for running the classic mode game logic without an engine
+ *
+ * This is built as a separate library (rigel_classic_headless), which
+ * links the original game code against a null implementation of the hook
+ * functions declared in game.h. Nothing is rendered, no sounds are played
+ * and no messages are shown, only the state which affects the simulation
+ * itself is maintained. This makes it possible to run many simulations in
+ * parallel at well above real-time speed, for example to verify demo
+ * recordings or to train AI agents.
+ *
+ * The library doesn't depend on SDL or OpenGL. It also doesn't know how to
+ * locate game files, so the required data must be given by the caller.
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct Context_;
+
+typedef struct RigelHeadlessSim RigelHeadlessSim;
+
+
+typedef struct
+{
+  // Contents of ACTRINFO.MNI
+  const uint8_t* actorInfoData;
+  size_t actorInfoSize;
+
+  // Contents of the level file, e.g. L1.MNI
+  const uint8_t* levelFileData;
+  size_t levelFileSize;
+
+  // Contents of the CZone file referenced by the level
+  const uint8_t* czoneFileData;
+  size_t czoneFileSize;
+
+  uint8_t episode;
+  uint8_t level;
+
+  // 0 = easy, 1 = medium, 2 = hard
+  uint8_t difficulty;
+} RigelHeadlessLevelData;
+
+
+typedef struct
+{
+  bool moveUp;
+  bool moveDown;
+  bool moveLeft;
+  bool moveRight;
+  bool jump;
+  bool fire;
+} RigelHeadlessInput;
+
+
+typedef struct
+{
+  uint16_t playerPosX;
+  uint16_t playerPosY;
+  uint16_t cameraPosX;
+  uint16_t cameraPosY;
+  uint32_t score;
+  uint8_t health;
+  uint8_t ammo;
+  uint8_t weapon;
+
+  // One of the GS_ values from game.h. Once it's no longer GS_RUNNING,
+  // it's up to the caller to decide what to do (e.g. restart the level).
+  uint8_t gameState;
+  uint32_t ticksElapsed;
+} RigelHeadlessSimInfo;
+
+
+/** Create a simulation for the given level
+ *
+ * The given data is copied, it doesn't need to outlive the call. Like in
+ * the in-game classic mode, the first tick is run as part of creation. On
+ * failure, NULL is returned and pErrorMessage (if not NULL) is set to a
+ * statically allocated description of the problem.
+ */
+RigelHeadlessSim* RigelHeadlessSim_Create(
+  const RigelHeadlessLevelData* pLevelData,
+  const char** pErrorMessage);
+
+void RigelHeadlessSim_Destroy(RigelHeadlessSim* pSim);
+
+/** Advance the simulation by one tick
+ *
+ * Returns false if the game logic raised an error. The simulation must not
+ * be stepped any further in that case, see RigelHeadlessSim_ErrorMessage().
+ */
+bool RigelHeadlessSim_Step(
+  RigelHeadlessSim* pSim,
+  const RigelHeadlessInput* pInput);
+
+const char* RigelHeadlessSim_ErrorMessage(const RigelHeadlessSim* pSim);
+
+void RigelHeadlessSim_GetInfo(
+  const RigelHeadlessSim* pSim,
+  RigelHeadlessSimInfo* pInfo);
+
+/** Full game logic state, as defined in game.h */
+const struct Context_* RigelHeadlessSim_State(const RigelHeadlessSim* pSim);
+
+#ifdef __cplusplus
+}
+#endif
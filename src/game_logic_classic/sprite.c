@@ -29,90 +29,105 @@ collision detection (sprite against sprite) is also in here.
 *******************************************************************************/
 
 
-/** Test if two sprites are touching (intersecting)
+/** Compute a sprite's bounding box, as used for sprite collision tests
  *
- * Returns true if the bounding box for the 1st sprite intersects the 2nd
- * sprite's bounding box, false otherwise.
- * The bounding box is defined by the dimensions of each sprite's graphical
+ * The bounding box is defined by the dimensions of the sprite's graphical
  * data. The only exception to this is the player, which is handled specially
  * in this function to make the hitbox a little smaller for certain animation
  * frames. This is mainly to make it so that the weapon which protrudes from
  * Duke's body doesn't cause him to take damage when touching an enemy/hazard.
- * This special logic only applies if the *2nd* sprite's actor id is Duke's.
+ * This special logic only applies if the sprite is the *2nd* one in the
+ * collision test, i.e. isSecondSprite is true.
  */
-bool AreSpritesTouching(
+void ComputeSpriteHitbox(
   Context* ctx,
-  word id1,
-  word frame1,
-  word x1,
-  word y1,
-  word id2,
-  word frame2,
-  word x2,
-  word y2)
+  word id,
+  word frame,
+  word x,
+  word y,
+  bool isSecondSprite,
+  SpriteHitbox* result)
 {
-  register word height1;
-  word width1;
-  word offset1;
-  register word height2;
-  word width2;
-  word offset2;
-
-  // Load the relevant meta data for both sprites
-  offset1 = (word)(ctx->gfxActorInfoData[id1] + (frame1 << 3));
-  x1 += AINFO_X_OFFSET(offset1);
-  y1 += AINFO_Y_OFFSET(offset1);
-  height1 = AINFO_HEIGHT(offset1);
-  width1 = AINFO_WIDTH(offset1);
-
-  offset2 = (word)(ctx->gfxActorInfoData[id2] + (frame2 << 3));
-  x2 += AINFO_X_OFFSET(offset2);
-  y2 += AINFO_Y_OFFSET(offset2);
-  height2 = AINFO_HEIGHT(offset2);
-  width2 = AINFO_WIDTH(offset2);
+  word offset = (word)(ctx->gfxActorInfoData[id] + (frame << 3));
+
+  result->id = id;
+  result->frame = frame;
+  result->posX = x;
+  result->posY = y;
+
+  result->x = x + AINFO_X_OFFSET(offset);
+  result->y = y + AINFO_Y_OFFSET(offset);
+  result->height = AINFO_HEIGHT(offset);
+  result->width = AINFO_WIDTH(offset);
+
+  if (!isSecondSprite)
+  {
+    return;
+  }
 
   // If the 2nd sprite is the player, do some hitbox adjustment. For everything
   // else in the game, the hitbox is always identical to the physical dimensions
   // of the sprite graphic. But the player is treated specially.
-  if (id2 == ACT_DUKE_L)
+  if (id == ACT_DUKE_L)
   {
     // When looking up (frame 17), we don't want Duke's protruding weapon to
     // participate in collision detection. When crouching (frame 34), Duke's
     // head is also excluded from collision detection. I'm not sure if that's
     // intentional or not, as it looks a bit odd for enemy shots etc. to fly
     // through Duke's head without causing any harm..
-    if (frame2 == 17 || frame2 == 34)
+    if (frame == 17 || frame == 34)
     {
-      height2--;
+      result->height--;
     }
 
     // For animation frames where Duke's weapon protrudes to the left, we want
     // to exclude it from collision detection.
     if (
-      frame2 < 9 || frame2 == 17 || frame2 == 18 || frame2 == 20 ||
-      frame2 == 27 || frame2 == 28 || frame2 == 34)
+      frame < 9 || frame == 17 || frame == 18 || frame == 20 || frame == 27 ||
+      frame == 28 || frame == 34)
     {
-      width2--;
-      x2++;
+      result->width--;
+      result->x++;
     }
   }
-  else if (id2 == ACT_DUKE_R)
+  else if (id == ACT_DUKE_R)
   {
     // Same as above
-    if (frame2 == 17 || frame2 == 34)
+    if (frame == 17 || frame == 34)
     {
-      height2--;
+      result->height--;
     }
 
     // Same as above, except that we don't need to adjust X for the right-facing
     // version
     if (
-      frame2 < 9 || frame2 == 17 || frame2 == 18 || frame2 == 20 ||
-      frame2 == 27 || frame2 == 28 || frame2 == 34)
+      frame < 9 || frame == 17 || frame == 18 || frame == 20 || frame == 27 ||
+      frame == 28 || frame == 34)
     {
-      width2--;
+      result->width--;
     }
   }
+}
+
+
+/** Test if two sprite hitboxes are intersecting
+ *
+ * box1 must have been computed with isSecondSprite set to false, box2 with
+ * isSecondSprite set to true. See ComputeSpriteHitbox().
+ */
+bool AreHitboxesTouching(
+  Context* ctx,
+  const SpriteHitbox* box1,
+  const SpriteHitbox* box2)
+{
+  word x1 = box1->x;
+  word width1 = box1->width;
+  register word height1 = box1->height;
+  word y1 = box1->y;
+  word x2 = box2->x;
+  word width2 = box2->width;
+  register word height2 = box2->height;
+  word y2 = box2->y;
 
   // I'm not quite sure what this is meant to accomplish.. It makes it so that
   // a sprite which is outside of the map (horizontally) will have a hitbox
@@ -136,6 +151,33 @@ bool AreSpritesTouching(
 }
 
 
+/** Test if two sprites are touching (intersecting)
+ *
+ * Returns true if the bounding box for the 1st sprite intersects the 2nd
+ * sprite's bounding box, false otherwise. See ComputeSpriteHitbox() for how
+ * the bounding boxes are determined.
+ */
+bool AreSpritesTouching(
+  Context* ctx,
+  word id1,
+  word frame1,
+  word x1,
+  word y1,
+  word id2,
+  word frame2,
+  word x2,
+  word y2)
+{
+  SpriteHitbox box1;
+  SpriteHitbox box2;
+
+  ComputeSpriteHitbox(ctx, id1, frame1, x1, y1, false, &box1);
+  ComputeSpriteHitbox(ctx, id2, frame2, x2, y2, true, &box2);
+
+  return AreHitboxesTouching(ctx, &box1, &box2);
+}
+
+
 /** Test if a sprite is partially/fully visible (inside the viewport) */
 bool IsSpriteOnScreen(Context* ctx, word id, word frame, word x, word y)
 {
@@ -20,6 +20,8 @@
 #include "data/bonus.hpp"
 #include "engine/timing.hpp"
 #include "game_logic_common/input.hpp"
+#include "game_logic_common/state_hash.hpp"
+#include "game_logic_common/tick_budget.hpp"
 
 #include <iosfwd>
 #include <set>
@@ -49,6 +51,29 @@ struct IGameWorld
   virtual std::set<data::Bonus> achievedBonuses() const = 0;
   virtual bool needsPerElementUpscaling() const = 0;
   virtual void updateGameLogic(const PlayerInput& input) = 0;
+
+  /** Whether updateGameLogic() may run on a thread other than the main one
+   *
+   * Only possible if updating doesn't touch the renderer. Worlds returning
+   * false always have their updates run on the main thread, even when
+   * pipelined game logic is requested.
+   */
+  virtual bool supportsPipelinedUpdates() const = 0;
+
+  /** Tell the world whether the next updates' results will be displayed
+   *
+   * When several updates run back to back within one frame, only the last
+   * one is followed by a call to render(). Worlds which produce draw
+   * commands as part of updating can skip that work for the others.
+   */
+  virtual void setDrawOutputWanted(bool wanted) = 0;
+
+  /** Set how much purely cosmetic work render() may do
+   *
+   * Lowered while logic updates take longer than their budget, see
+   * TickBudgetController. Must not affect gameplay in any way.
+   */
+  virtual void setEffectsDetail(EffectsDetail detail) = 0;
   virtual void render(float interpolationFactor = 0.0f) = 0;
   virtual void processEndOfFrameActions() = 0;
   virtual void updateBackdropAutoScrolling(engine::TimeDelta dt) = 0;
@@ -64,6 +89,13 @@ struct IGameWorld
   virtual void debugToggleWorldCollisionDataDisplay() = 0;
   virtual void debugToggleGridDisplay() = 0;
   virtual void printDebugText(std::ostream& stream) const = 0;
+
+  /** Checksums of the current gameplay state
+   *
+   * Meant for verifying that replaying recorded input produces the same
+   * results. Cheap enough to be computed after every update.
+   */
+  virtual StateHash stateHash() const = 0;
 };
 
 } // namespace rigel::game_logic
@@ -0,0 +1,52 @@
+/* Copyright (C) 2022, Nikolai Wuttke. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "state_hash.hpp"
+
+#include <iomanip>
+#include <sstream>
+
+
+namespace rigel::game_logic
+{
+
+std::string describeStateHashDifferences(
+  const StateHash& expected,
+  const StateHash& actual)
+{
+  std::stringstream stream;
+  stream << std::hex << std::setfill('0');
+
+  auto compare = [&](
+                   const char* category,
+                   const std::uint32_t expectedHash,
+                   const std::uint32_t actualHash) {
+    if (expectedHash != actualHash)
+    {
+      stream << category << " state differs: expected " << std::setw(8)
+             << expectedHash << ", got " << std::setw(8) << actualHash << '\n';
+    }
+  };
+
+  compare("Player", expected.mPlayer, actual.mPlayer);
+  compare("Actor", expected.mActors, actual.mActors);
+  compare("Map", expected.mMap, actual.mMap);
+  compare("Global", expected.mGlobals, actual.mGlobals);
+
+  return stream.str();
+}
+
+} // namespace rigel::game_logic
@@ -0,0 +1,89 @@
+/* Copyright (C) 2022, Nikolai Wuttke. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <type_traits>
+
+
+namespace rigel::game_logic
+{
+
+/** Checksums of the simulation state after a game logic update
+ *
+ * The state is split into a few categories, so that a mismatch can be
+ * narrowed down somewhat. Only state that influences gameplay is covered,
+ * i.e. purely visual things like particles are left out.
+ */
+struct StateHash
+{
+  std::uint32_t mPlayer = 0;
+  std::uint32_t mActors = 0;
+  std::uint32_t mMap = 0;
+  std::uint32_t mGlobals = 0;
+
+  friend bool operator==(const StateHash& lhs, const StateHash& rhs)
+  {
+    return lhs.mPlayer == rhs.mPlayer && lhs.mActors == rhs.mActors &&
+      lhs.mMap == rhs.mMap && lhs.mGlobals == rhs.mGlobals;
+  }
+
+  friend bool operator!=(const StateHash& lhs, const StateHash& rhs)
+  {
+    return !(lhs == rhs);
+  }
+};
+
+
+/** Incremental 32-bit FNV-1a hash over a sequence of values
+ *
+ * Only integral and enum values are accepted, since hashing the bytes of
+ * structs would include padding.
+ */
+class StateHasher
+{
+public:
+  template <typename T>
+  StateHasher& add(const T value)
+  {
+    static_assert(std::is_integral_v<T> || std::is_enum_v<T>);
+
+    auto bits = static_cast<std::uint64_t>(value);
+    for (auto i = 0u; i < sizeof(T); ++i)
+    {
+      mHash ^= std::uint32_t(bits & 0xFF);
+      mHash *= 16777619u;
+      bits >>= 8;
+    }
+
+    return *this;
+  }
+
+  std::uint32_t value() const { return mHash; }
+
+private:
+  std::uint32_t mHash = 2166136261u;
+};
+
+
+/** List the categories in which the two hashes differ, one per line */
+std::string describeStateHashDifferences(
+  const StateHash& expected,
+  const StateHash& actual);
+
+} // namespace rigel::game_logic
@@ -0,0 +1,58 @@
+/* Copyright (C) 2022, Nikolai Wuttke. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "tick_budget.hpp"
+
+
+namespace rigel::game_logic
+{
+
+namespace
+{
+
+// Logic updates run at 15 Hz, so reducing/restoring takes roughly 1/3 s and
+// 4 s respectively
+constexpr auto CONTROLLER_CONFIG = base::BudgetController::Config{
+  0.2f, // smoothing factor
+  1.0f, // reduce threshold
+  0.6f, // restore threshold
+  5, // updates before reduce
+  60, // updates before restore
+  int(EffectsDetail::Minimal)};
+
+} // namespace
+
+
+TickBudgetController::TickBudgetController()
+  : mController(CONTROLLER_CONFIG)
+{
+}
+
+
+bool TickBudgetController::update(
+  const float updateTimeMs,
+  const float budgetMs)
+{
+  return mController.update(updateTimeMs, budgetMs);
+}
+
+
+void TickBudgetController::reset()
+{
+  mController.reset();
+}
+
+} // namespace rigel::game_logic
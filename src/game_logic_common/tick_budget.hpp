@@ -0,0 +1,95 @@
+/* Copyright (C) 2022, Nikolai Wuttke. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "base/budget_controller.hpp"
+
+#include <cstdint>
+
+
+namespace rigel::game_logic
+{
+
+/** How much purely cosmetic work a game world may do
+ *
+ * Lower levels only thin out what's displayed, e.g. particles and tile
+ * debris. Gameplay is the same at all levels.
+ */
+enum class EffectsDetail : std::uint8_t
+{
+  Full,
+  Reduced,
+  Minimal
+};
+
+
+/** Only every n-th cosmetic element is displayed at the given level */
+constexpr int effectsDetailStride(const EffectsDetail detail)
+{
+  switch (detail)
+  {
+    case EffectsDetail::Reduced:
+      return 2;
+
+    case EffectsDetail::Minimal:
+      return 4;
+
+    default:
+      return 1;
+  }
+}
+
+
+/** Picks a level of effects detail that keeps logic updates within budget
+ *
+ * Meant to be fed the duration of each game logic update. If the smoothed
+ * update time stays above the budget for a few updates, the detail is
+ * lowered by one level (see base::BudgetController).
+ * It's raised again once the time has been well below the budget for a
+ * considerably longer period.
+ *
+ * Only the total update time is taken into account. None of the systems
+ * that make up an update can be skipped without affecting gameplay, so
+ * lowering the detail reduces the cosmetic work that follows from them,
+ * i.e. the amount of effects that need to be drawn.
+ */
+class TickBudgetController
+{
+public:
+  // Rendering runs in between two logic updates, or in parallel to them.
+  // Leaving it half of a 60 FPS frame keeps either case from dropping
+  // below 60 FPS.
+  static constexpr auto DEFAULT_BUDGET_MS = 8.0f;
+
+  TickBudgetController();
+
+  /** Returns true if the detail level has changed */
+  bool update(float updateTimeMs, float budgetMs);
+
+  /** Go back to full detail, and forget all previous measurements */
+  void reset();
+
+  EffectsDetail detail() const
+  {
+    return static_cast<EffectsDetail>(mController.level());
+  }
+
+private:
+  base::BudgetController mController;
+};
+
+} // namespace rigel::game_logic
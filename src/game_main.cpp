@@ -19,8 +19,12 @@
 #include "version_info.hpp"
 
 #include "base/defer.hpp"
+#include "base/job_system.hpp"
+#include "base/startup_timings.hpp"
+#include "base/tracing.hpp"
 #include "frontend/game.hpp"
 #include "renderer/opengl.hpp"
+#include "renderer/shader.hpp"
 #include "sdl_utils/error.hpp"
 #include "ui/game_path_browser.hpp"
 #include "ui/imgui_integration.hpp"
@@ -33,10 +37,13 @@ RIGEL_DISABLE_WARNINGS
 #include <SDL_mixer.h>
 #include <imgui.h>
 #include <loguru.hpp>
+#include <nlohmann/json.hpp>
 RIGEL_RESTORE_WARNINGS
 
 #include <filesystem>
 #include <fstream>
+#include <iomanip>
+#include <sstream>
 
 
 namespace rigel
@@ -192,6 +199,88 @@ Stop by the 'modding' channel on the RigelEngine Discord: https://discord.gg/dtJ
 }
 
 
+void reportStartupTimings(const CommandLineOptions& options)
+{
+  const auto report = base::startup_timings::finish();
+
+  std::stringstream table;
+  base::startup_timings::printReport(table, report);
+  LOG_F(INFO, "Startup timings:\n%s", table.str().c_str());
+
+  if (!options.mStartupTimingsFile)
+  {
+    return;
+  }
+
+  auto phases = nlohmann::json::array();
+  for (const auto& phase : report.mPhases)
+  {
+    phases.push_back(
+      {{"name", phase.mName},
+       {"depth", phase.mDepth},
+       {"async", phase.mOnWorkerThread},
+       {"startMs", phase.mStartMs},
+       {"durationMs", phase.mDurationMs}});
+  }
+
+  const auto& path = *options.mStartupTimingsFile;
+  auto file = std::ofstream(std::filesystem::u8path(path));
+  if (!file.is_open())
+  {
+    LOG_F(ERROR, "Failed to open %s for writing", path.c_str());
+    return;
+  }
+
+  file << std::setw(4)
+       << nlohmann::json{{"totalMs", report.mTotalMs}, {"phases", phases}};
+}
+
+
+void importOrExportUserProfile(
+  UserProfile& userProfile,
+  const CommandLineOptions& options)
+{
+  if (options.mProfileImportFile)
+  {
+    const auto& path = *options.mProfileImportFile;
+
+    try
+    {
+      importUserProfileFromJson(userProfile, std::filesystem::u8path(path));
+      userProfile.saveToDisk();
+      LOG_F(INFO, "Imported user profile from '%s'", path.c_str());
+    }
+    catch (const std::exception& ex)
+    {
+      LOG_F(
+        ERROR,
+        "Failed to import user profile '%s': %s",
+        path.c_str(),
+        ex.what());
+    }
+  }
+
+  if (options.mProfileExportFile)
+  {
+    const auto& path = *options.mProfileExportFile;
+
+    try
+    {
+      exportUserProfileAsJson(userProfile, std::filesystem::u8path(path));
+      LOG_F(INFO, "Exported user profile to '%s'", path.c_str());
+    }
+    catch (const std::exception& ex)
+    {
+      LOG_F(
+        ERROR,
+        "Failed to export user profile '%s': %s",
+        path.c_str(),
+        ex.what());
+    }
+  }
+}
+
+
 void initAndRunGame(
   SDL_Window* pWindow,
   UserProfile& userProfile,
@@ -205,10 +294,12 @@ void initAndRunGame(
     createModsDirIfNoneFound(gamePath);
 
     // Set up mod library with effective game path. This will automatically do
-    // a rescan, which is important in case available mods have changed since
-    // the last run.
+    // a rescan if the mods directory has changed since the last run. Otherwise,
+    // the directory index stored in the user profile is reused.
     LOG_F(INFO, "Setting up mod library");
-    userProfile.mModLibrary.updateGamePath(gamePath);
+    base::startup_timings::measure("Mod library scan", [&]() {
+      userProfile.mModLibrary.updateGamePath(gamePath);
+    });
 
     // The mod library might now have the changed flag set, but we don't want
     // the game to see the flag since that would cause the game to immediately
@@ -220,11 +311,24 @@ void initAndRunGame(
 
     // Now initialize and run the game until it tells us that it's done
     LOG_F(INFO, "Starting game");
-    Game game(options, &userProfile, pWindow, isFirstLaunch);
+    auto game = base::startup_timings::measure("Game initialization", [&]() {
+      return Game(options, &userProfile, pWindow, isFirstLaunch);
+    });
 
     for (;;)
     {
-      auto maybeStopReason = game.runOneFrame();
+      // Startup is considered done once the first frame has been shown
+      const auto isFirstFrame = base::startup_timings::isRecording();
+      auto maybeStopReason = isFirstFrame
+        ? base::startup_timings::measure(
+            "First frame", [&]() { return game.runOneFrame(); })
+        : game.runOneFrame();
+
+      if (isFirstFrame)
+      {
+        reportStartupTimings(commandLineOptions);
+      }
+
       if (maybeStopReason)
       {
         return *maybeStopReason;
@@ -255,6 +359,14 @@ void initAndRunGame(
     optionsForRestartedGame.mDebugModeEnabled =
       commandLineOptions.mDebugModeEnabled;
     optionsForRestartedGame.mDisableAudio = commandLineOptions.mDisableAudio;
+    optionsForRestartedGame.mPipelinedGameLogic =
+      commandLineOptions.mPipelinedGameLogic;
+    optionsForRestartedGame.mLowLatencyInput =
+      commandLineOptions.mLowLatencyInput;
+    optionsForRestartedGame.mReduceVsyncLatency =
+      commandLineOptions.mReduceVsyncLatency;
+    optionsForRestartedGame.mWatchReplacementFiles =
+      commandLineOptions.mWatchReplacementFiles;
 
     while (result == Game::StopReason::RestartNeeded)
     {
@@ -265,6 +377,7 @@ void initAndRunGame(
   // We're exiting, save the user profile
   LOG_F(INFO, "Game ended");
   userProfile.saveToDisk();
+  userProfile.waitForPendingSaves();
 }
 
 
@@ -304,15 +417,40 @@ int gameMain(const CommandLineOptions& options)
 
   logVersionAndSystemInfo();
 
+  // Makes this the main thread, for JobSystem::submitOnMainThread()
+  base::JobSystem::instance();
+
+  if (options.mTraceFile)
+  {
+    base::tracing::enable(std::filesystem::u8path(*options.mTraceFile));
+    base::tracing::setCurrentThreadName("Main");
+  }
+
+  // Does nothing unless tracing was enabled above
+  auto traceGuard = defer([]() {
+    try
+    {
+      base::tracing::writeTrace();
+    }
+    catch (const std::exception& ex)
+    {
+      LOG_F(ERROR, "Failed to save timeline trace: %s", ex.what());
+    }
+  });
+
   loadGameControllerDbForOldSdl();
 
   LOG_F(INFO, "Initializing SDL");
-  sdl_utils::check(
-    SDL_Init(SDL_INIT_VIDEO | SDL_INIT_AUDIO | SDL_INIT_GAMECONTROLLER));
+  base::startup_timings::measure("SDL init", []() {
+    sdl_utils::check(
+      SDL_Init(SDL_INIT_VIDEO | SDL_INIT_AUDIO | SDL_INIT_GAMECONTROLLER));
+  });
   auto sdlGuard = defer([]() { SDL_Quit(); });
 
   LOG_F(INFO, "Initializing SDL_mixer");
-  Mix_Init(MIX_INIT_FLAC | MIX_INIT_OGG | MIX_INIT_MP3 | MIX_INIT_MOD);
+  base::startup_timings::measure("SDL_mixer init", []() {
+    Mix_Init(MIX_INIT_FLAC | MIX_INIT_OGG | MIX_INIT_MP3 | MIX_INIT_MOD);
+  });
   auto sdlMixerGuard = defer([]() { Mix_Quit(); });
 
   LOG_F(
@@ -325,18 +463,31 @@ int gameMain(const CommandLineOptions& options)
   platform::setGLAttributes();
 
   LOG_F(INFO, "Loading user profile");
-  auto userProfile = loadOrCreateUserProfile();
+  auto userProfile = base::startup_timings::measure(
+    "User profile", []() { return loadOrCreateUserProfile(); });
+  importOrExportUserProfile(userProfile, options);
 
   LOG_F(INFO, "Creating window");
-  auto pWindow = platform::createWindow(userProfile.mOptions);
+  auto pWindow = base::startup_timings::measure("Window creation", [&]() {
+    return platform::createWindow(userProfile.mOptions);
+  });
 
   LOG_F(INFO, "Initializing OpenGL context");
   SDL_GLContext pGlContext =
-    sdl_utils::check(SDL_GL_CreateContext(pWindow.get()));
+    base::startup_timings::measure("OpenGL context", [&]() {
+      return sdl_utils::check(SDL_GL_CreateContext(pWindow.get()));
+    });
   auto glGuard = defer([pGlContext]() { SDL_GL_DeleteContext(pGlContext); });
 
   LOG_F(INFO, "Loading OpenGL function pointers");
-  renderer::loadGlFunctions();
+  base::startup_timings::measure(
+    "OpenGL function loading", []() { renderer::loadGlFunctions(); });
+
+  if (const auto maybePrefsDir = createOrGetPreferencesPath())
+  {
+    constexpr auto SHADER_CACHE_SUBDIR = "shader_cache";
+    renderer::enableProgramBinaryCache(*maybePrefsDir / SHADER_CACHE_SUBDIR);
+  }
 
   // On some platforms, an initial swap is necessary in order for the next
   // frame (in our case, the loading screen) to show up on screen.
@@ -347,8 +498,10 @@ int gameMain(const CommandLineOptions& options)
   SDL_ShowCursor(SDL_DISABLE);
 
   LOG_F(INFO, "Initializing Dear ImGui");
-  ui::imgui_integration::init(
-    pWindow.get(), pGlContext, createOrGetPreferencesPath());
+  base::startup_timings::measure("Dear ImGui init", [&]() {
+    ui::imgui_integration::init(
+      pWindow.get(), pGlContext, createOrGetPreferencesPath());
+  });
   auto imGuiGuard = defer([]() { ui::imgui_integration::shutdown(); });
 
   try
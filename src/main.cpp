@@ -23,16 +23,20 @@
 // you might want to hop over to game_main.cpp instead of looking at this file
 // here.
 
+#include "base/async_log_sink.hpp"
 #include "base/defer.hpp"
 #include "base/match.hpp"
+#include "base/startup_timings.hpp"
 #include "base/string_utils.hpp"
 #include "base/warnings.hpp"
 #include "frontend/user_profile.hpp"
 
 #include "game_main.hpp"
 
+#include <algorithm>
+#include <cstdio>
 #include <filesystem>
-
+#include <fstream>
 #include <iostream>
 #include <regex>
 #include <stdexcept>
@@ -177,8 +181,62 @@ std::variant<CommandLineOptions, int> parseArgs(int argc, char** argv)
       .help("Enable debugging features")
     | lyra::opt(config.mDisableAudio)["--no-audio"]
       .help("Disable all audio output")
+    | lyra::opt(config.mPipelinedGameLogic)["--pipelined-logic"]
+      .help(
+        "Run game logic on a separate thread, in parallel to presenting the "
+        "previous frame. Adds one frame of latency")
+    | lyra::opt(config.mLowLatencyInput)["--low-latency-input"]
+      .help(
+        "Apply input arriving during a frame to the next game logic update "
+        "right away. No effect with --pipelined-logic")
+    | lyra::opt(config.mReduceVsyncLatency)["--reduce-vsync-latency"]
+      .help(
+        "With V-Sync on, delay the start of each frame until shortly before "
+        "the next display refresh, to reduce input latency")
+    | lyra::opt(config.mWatchReplacementFiles)["--watch-replacements"]
+      .help(
+        "Reload modified replacement sprites and sounds while the game is "
+        "running. Other changes to mods restart the game")
     | lyra::opt(config.mPlayDemo)["--play-demo"]
       .help("Play pre-recorded demo")
+    | lyra::opt(config.mBenchmarkDemo)["--benchmark-demo"]
+      .help("Play pre-recorded demo as fast as possible, then print timings")
+    | lyra::opt(config.mBenchmarkRenderInterval, "N")
+        ["--benchmark-render-interval"]
+      .help("When benchmarking, render every Nth frame (0: don't render)")
+    | lyra::opt([&](const std::string& directory) {
+        config.mInputRecordingDirectory = directory;
+      }, "directory")
+      ["--record-inputs"]
+      .help("Record player input of each level into the given directory")
+    | lyra::opt([&](const std::string& file) {
+        config.mTraceFile = file;
+      }, "file")
+      ["--trace"]
+      .help(
+        "Record a timeline trace, written to the given file in Chrome's "
+        "trace event format on exit (or via F12 in debug mode)")
+    | lyra::opt([&](const std::string& file) {
+        config.mStartupTimingsFile = file;
+      }, "file")
+      ["--startup-timings"]
+      .help(
+        "Write the duration of each startup phase to the given JSON file. "
+        "The timings are always written to the log.")
+    | lyra::opt([&](const std::string& file) {
+        config.mProfileImportFile = file;
+      }, "file")
+      ["--import-profile"]
+      .help(
+        "Replace saved games, high scores and options with those from the "
+        "given JSON file, as written by --export-profile")
+    | lyra::opt([&](const std::string& file) {
+        config.mProfileExportFile = file;
+      }, "file")
+      ["--export-profile"]
+      .help(
+        "Write saved games, high scores and options to the given JSON file "
+        "at startup")
     | lyra::group([&](const lyra::group&){})
       .add_argument(lyra::opt([&](const std::string& levelSpec){
           config.mLevelToJumpTo = data::GameSessionId{
@@ -250,6 +308,47 @@ std::variant<CommandLineOptions, int> parseArgs(int argc, char** argv)
 }
 
 
+// Log file output, written on a background thread so that logging doesn't
+// stall the main loop or the audio thread.
+struct AsyncLogFile
+{
+  explicit AsyncLogFile(const std::filesystem::path& path)
+    : mFile(path, std::ios::app | std::ios::binary)
+    , mSink([this](const std::string_view text) {
+      mFile.write(text.data(), text.size());
+      mFile.flush();
+    })
+  {
+  }
+
+  std::ofstream mFile;
+  base::AsyncLogSink mSink;
+};
+
+
+void writeToLogFile(void* pUserData, const loguru::Message& message)
+{
+  // Loguru has already formatted the message at this point, we only need to
+  // assemble the line. This avoids allocating on every log statement.
+  char line[base::AsyncLogSink::MAX_MESSAGE_LENGTH + 1];
+  const auto length = std::snprintf(
+    line,
+    sizeof(line),
+    "%s%s%s%s",
+    message.preamble,
+    message.indentation,
+    message.prefix,
+    message.message);
+
+  if (length > 0)
+  {
+    const auto size =
+      std::min(static_cast<std::size_t>(length), sizeof(line) - 1);
+    static_cast<AsyncLogFile*>(pUserData)->mSink.push({line, size});
+  }
+}
+
+
 void initializeLogging(int argc, char** argv)
 {
   loguru::g_stderr_verbosity = loguru::Verbosity_WARNING;
@@ -257,9 +356,25 @@ void initializeLogging(int argc, char** argv)
 
   if (const auto oPreferencesPath = createOrGetPreferencesPath())
   {
-    const auto logFilePath = *oPreferencesPath / "Log.txt";
-    loguru::add_file(
-      logFilePath.u8string().c_str(), loguru::Append, loguru::Verbosity_MAX);
+    auto pLogFile = new AsyncLogFile{*oPreferencesPath / "Log.txt"};
+    if (!pLogFile->mFile)
+    {
+      delete pLogFile;
+      LOG_F(ERROR, "Failed to open log file");
+      return;
+    }
+
+    // Loguru takes care of closing all callbacks at shutdown, and also
+    // flushes them when a crash is detected.
+    loguru::add_callback(
+      "log_file",
+      writeToLogFile,
+      pLogFile,
+      loguru::Verbosity_MAX,
+      [](void* pUserData) { delete static_cast<AsyncLogFile*>(pUserData); },
+      [](void* pUserData) {
+        static_cast<AsyncLogFile*>(pUserData)->mSink.flush();
+      });
   }
 }
 
@@ -297,6 +412,8 @@ int runGame(CommandLineOptions config)
 
 int main(int argc, char** argv)
 {
+  base::startup_timings::begin();
+
   // On Windows, RigelEngine is a GUI application (subsystem win32), which
   // means that it can't be used as a command-line application - stdout and
   // stdin are not connected to the terminal that launches the executable in
@@ -16,6 +16,7 @@
 
 #include "platform.hpp"
 
+#include "renderer/opengl.hpp"
 #include "sdl_utils/error.hpp"
 
 #include <loguru.hpp>
@@ -103,4 +104,48 @@ int flagsForWindowMode(const data::WindowMode mode)
   return 0;
 }
 
+
+OffscreenGlContext::OffscreenGlContext(const base::Size& size)
+{
+  sdl_utils::check(SDL_InitSubSystem(SDL_INIT_VIDEO));
+
+  try
+  {
+    sdl_utils::check(SDL_GL_LoadLibrary(nullptr));
+    setGLAttributes();
+
+    mpWindow = sdl_utils::wrap(sdl_utils::check(SDL_CreateWindow(
+      "Rigel Engine",
+      SDL_WINDOWPOS_UNDEFINED,
+      SDL_WINDOWPOS_UNDEFINED,
+      size.width,
+      size.height,
+      SDL_WINDOW_OPENGL | SDL_WINDOW_HIDDEN)));
+    mpContext = sdl_utils::check(SDL_GL_CreateContext(mpWindow.get()));
+
+    // Nothing is shown, so there's no point in waiting for v-sync
+    SDL_GL_SetSwapInterval(0);
+    renderer::loadGlFunctions();
+  }
+  catch (...)
+  {
+    if (mpContext)
+    {
+      SDL_GL_DeleteContext(mpContext);
+    }
+
+    mpWindow.reset();
+    SDL_QuitSubSystem(SDL_INIT_VIDEO);
+    throw;
+  }
+}
+
+
+OffscreenGlContext::~OffscreenGlContext()
+{
+  SDL_GL_DeleteContext(mpContext);
+  mpWindow.reset();
+  SDL_QuitSubSystem(SDL_INIT_VIDEO);
+}
+
 } // namespace rigel::platform
@@ -16,6 +16,7 @@
 
 #pragma once
 
+#include "base/spatial_types.hpp"
 #include "base/warnings.hpp"
 #include "data/game_options.hpp"
 #include "sdl_utils/ptr.hpp"
@@ -32,4 +33,29 @@ void setGLAttributes();
 sdl_utils::Ptr<SDL_Window> createWindow(const data::GameOptions& options);
 int flagsForWindowMode(const data::WindowMode mode);
 
+
+/** Hidden window with an OpenGL context, for rendering without any
+ * visible output
+ *
+ * Initializes SDL's video subsystem, and loads the OpenGL function
+ * pointers once the context is current. To run without a display server,
+ * set the SDL_VIDEODRIVER environment variable to "offscreen". This makes
+ * SDL create the context via EGL (requires SDL 2.0.22 or newer).
+ */
+class OffscreenGlContext
+{
+public:
+  explicit OffscreenGlContext(const base::Size& size);
+  ~OffscreenGlContext();
+
+  OffscreenGlContext(const OffscreenGlContext&) = delete;
+  OffscreenGlContext& operator=(const OffscreenGlContext&) = delete;
+
+  SDL_Window* window() const { return mpWindow.get(); }
+
+private:
+  sdl_utils::Ptr<SDL_Window> mpWindow;
+  SDL_GLContext mpContext = nullptr;
+};
+
 } // namespace rigel::platform
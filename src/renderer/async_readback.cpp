@@ -0,0 +1,195 @@
+/* Copyright (C) 2022, Nikolai Wuttke. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "async_readback.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <utility>
+
+
+namespace rigel::renderer
+{
+
+namespace
+{
+
+#ifndef RIGEL_USE_GL_ES
+// Without fences, we don't know exactly when the copy is done. Waiting a
+// couple of frames is enough in practice, and even if not, mapping the
+// buffer just stalls for the remaining time.
+constexpr auto FRAMES_TO_WAIT_WITHOUT_FENCE = 2;
+
+static_assert(sizeof(data::Pixel) == 4);
+#else
+data::Image readPixelsSynchronously(const base::Size& size)
+{
+  auto pixels = data::PixelBuffer(std::size_t(size.width * size.height));
+  glReadPixels(
+    0, 0, size.width, size.height, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+
+  return data::Image{
+    std::move(pixels), std::size_t(size.width), std::size_t(size.height)}
+    .flipped();
+}
+#endif
+
+} // namespace
+
+
+AsyncReadbackQueue::~AsyncReadbackQueue()
+{
+#ifndef RIGEL_USE_GL_ES
+  for (const auto& read : mPendingReads)
+  {
+    if (read.mFence)
+    {
+      ext::glDeleteSync(read.mFence);
+    }
+
+    mFreePbos.push_back(read.mPbo);
+  }
+
+  if (!mFreePbos.empty())
+  {
+    glDeleteBuffers(GLsizei(mFreePbos.size()), mFreePbos.data());
+  }
+#endif
+}
+
+
+void AsyncReadbackQueue::start(const base::Size& size, Callback callback)
+{
+#ifdef RIGEL_USE_GL_ES
+  callback(readPixelsSynchronously(size));
+#else
+  GLuint pbo = 0;
+  if (!mFreePbos.empty())
+  {
+    pbo = mFreePbos.back();
+    mFreePbos.pop_back();
+  }
+  else
+  {
+    glGenBuffers(1, &pbo);
+  }
+
+  const auto numBytes = GLsizeiptr(size.width * size.height * 4);
+
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, pbo);
+  glBufferData(GL_PIXEL_PACK_BUFFER, numBytes, nullptr, GL_STREAM_READ);
+  glReadPixels(
+    0, 0, size.width, size.height, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+  auto fence = GLsync{};
+  if (optionalGlFeatures().mHasSync)
+  {
+    fence = ext::glFenceSync(ext::GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+  }
+
+  mPendingReads.push_back(
+    PendingRead{std::move(callback), size, pbo, fence, 0});
+#endif
+}
+
+
+void AsyncReadbackQueue::poll()
+{
+#ifndef RIGEL_USE_GL_ES
+  // Reads complete in order, so we only need to look at the front of the
+  // queue. Callbacks are invoked after updating the queue, since they
+  // might start new reads.
+  std::vector<std::pair<Callback, data::Image>> completedReads;
+
+  while (!mPendingReads.empty() && isComplete(mPendingReads.front()))
+  {
+    auto& read = mPendingReads.front();
+    completedReads.emplace_back(std::move(read.mCallback), fetchImage(read));
+
+    if (read.mFence)
+    {
+      ext::glDeleteSync(read.mFence);
+    }
+
+    mFreePbos.push_back(read.mPbo);
+    mPendingReads.erase(mPendingReads.begin());
+  }
+
+  for (auto& read : mPendingReads)
+  {
+    ++read.mFramesWaited;
+  }
+
+  for (auto& [callback, image] : completedReads)
+  {
+    callback(std::move(image));
+  }
+#endif
+}
+
+
+#ifndef RIGEL_USE_GL_ES
+bool AsyncReadbackQueue::isComplete(const PendingRead& read) const
+{
+  if (read.mFence)
+  {
+    const auto result = ext::glClientWaitSync(read.mFence, 0, 0);
+    return result != ext::GL_TIMEOUT_EXPIRED;
+  }
+
+  return read.mFramesWaited >= FRAMES_TO_WAIT_WITHOUT_FENCE;
+}
+
+
+data::Image AsyncReadbackQueue::fetchImage(const PendingRead& read)
+{
+  const auto width = std::size_t(read.mSize.width);
+  const auto height = std::size_t(read.mSize.height);
+  const auto bytesPerRow = width * sizeof(data::Pixel);
+
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, read.mPbo);
+  const auto pMapped = static_cast<const std::uint8_t*>(glMapBufferRange(
+    GL_PIXEL_PACK_BUFFER,
+    0,
+    GLsizeiptr(bytesPerRow * height),
+    GL_MAP_READ_BIT));
+
+  if (!pMapped)
+  {
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    return data::Image{width, height};
+  }
+
+  // OpenGL gives us the image bottom-up, so we flip it while copying
+  auto pixels = data::PixelBuffer(width * height);
+  for (auto row = std::size_t{0}; row < height; ++row)
+  {
+    std::memcpy(
+      pixels.data() + (height - row - 1) * width,
+      pMapped + row * bytesPerRow,
+      bytesPerRow);
+  }
+
+  glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+  return data::Image{std::move(pixels), width, height};
+}
+#endif
+
+} // namespace rigel::renderer
@@ -0,0 +1,86 @@
+/* Copyright (C) 2022, Nikolai Wuttke. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#pragma once
+
+#include "base/image.hpp"
+#include "base/spatial_types.hpp"
+#include "renderer/opengl.hpp"
+
+#include <functional>
+#include <vector>
+
+
+namespace rigel::renderer
+{
+
+/** Reads back framebuffer contents without stalling the pipeline
+ *
+ * A plain glReadPixels into client memory has to wait until the GPU has
+ * finished rendering everything up to that point. This class instead
+ * reads into a pixel buffer object, which lets the GPU perform the copy
+ * asynchronously. The data is then fetched from the buffer a few frames
+ * later, once the copy is done (checked via fence syncs where available).
+ *
+ * GL ES 2.0 doesn't have pixel buffer objects, so there, reads are done
+ * synchronously.
+ */
+class AsyncReadbackQueue
+{
+public:
+  using Callback = std::function<void(data::Image)>;
+
+  AsyncReadbackQueue() = default;
+  ~AsyncReadbackQueue();
+
+  AsyncReadbackQueue(const AsyncReadbackQueue&) = delete;
+  AsyncReadbackQueue& operator=(const AsyncReadbackQueue&) = delete;
+
+  /** Start reading the currently bound framebuffer
+   *
+   * The callback will be invoked from a later call to poll(), once the
+   * data is available. Pending reads are discarded on destruction, without
+   * invoking their callback.
+   */
+  void start(const base::Size& size, Callback callback);
+
+  /** Finish any reads whose data has become available
+   *
+   * Meant to be called once per frame.
+   */
+  void poll();
+
+private:
+#ifndef RIGEL_USE_GL_ES
+  struct PendingRead
+  {
+    Callback mCallback;
+    base::Size mSize;
+    GLuint mPbo;
+    GLsync mFence;
+    int mFramesWaited;
+  };
+
+  bool isComplete(const PendingRead& read) const;
+  data::Image fetchImage(const PendingRead& read);
+
+  std::vector<PendingRead> mPendingReads;
+  std::vector<GLuint> mFreePbos;
+#endif
+};
+
+} // namespace rigel::renderer
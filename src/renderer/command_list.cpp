@@ -0,0 +1,151 @@
+/* Copyright (C) 2022, Nikolai Wuttke. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "command_list.hpp"
+
+#include <algorithm>
+
+
+namespace rigel::renderer
+{
+
+void CommandList::drawTexture(
+  const TextureId texture,
+  const TexCoords& texCoords,
+  const base::Rect<int>& destRect)
+{
+  add(
+    {Type::DrawTexture,
+     0,
+     mCurrentLayer,
+     texture,
+     texCoords,
+     destRect,
+     {},
+     mOverlayColor});
+}
+
+
+void CommandList::drawFilledRectangle(
+  const base::Rect<int>& rect,
+  const base::Color& color)
+{
+  add({Type::DrawFilledRectangle, 0, mCurrentLayer, 0, {}, rect, color, {}});
+}
+
+
+void CommandList::drawRectangle(
+  const base::Rect<int>& rect,
+  const base::Color& color)
+{
+  add({Type::DrawRectangle, 0, mCurrentLayer, 0, {}, rect, color, {}});
+}
+
+
+void CommandList::drawLine(
+  const base::Vec2& start,
+  const base::Vec2& end,
+  const base::Color& color)
+{
+  // The line is stored as a rect from start to end, which can have a
+  // negative size
+  const auto rect = base::Rect<int>{start, {end.x - start.x, end.y - start.y}};
+  add({Type::DrawLine, 0, mCurrentLayer, 0, {}, rect, color, {}});
+}
+
+
+void CommandList::drawCustom(
+  const std::uint16_t tag,
+  const TextureId texture,
+  const TexCoords& texCoords,
+  const base::Rect<int>& destRect)
+{
+  add(
+    {Type::Custom,
+     tag,
+     mCurrentLayer,
+     texture,
+     texCoords,
+     destRect,
+     {},
+     mOverlayColor});
+}
+
+
+void CommandList::sort()
+{
+  if (!mHasMultipleLayers)
+  {
+    return;
+  }
+
+  std::stable_sort(
+    mCommands.begin(), mCommands.end(), [](const auto& lhs, const auto& rhs) {
+      return lhs.mLayer < rhs.mLayer;
+    });
+}
+
+
+void CommandList::clear()
+{
+  mCommands.clear();
+  mHasMultipleLayers = false;
+  mCurrentLayer = 0;
+  mOverlayColor = {0, 0, 0, 0};
+}
+
+
+void CommandList::add(const Command& command)
+{
+  if (!mCommands.empty() && mCommands.back().mLayer != command.mLayer)
+  {
+    mHasMultipleLayers = true;
+  }
+
+  mCommands.push_back(command);
+}
+
+
+void CommandList::executeBuiltIn(Renderer& renderer, const Command& command)
+{
+  switch (command.mType)
+  {
+    case Type::DrawTexture:
+      renderer.drawTexture(command.mTexture, command.mTexCoords, command.mRect);
+      break;
+
+    case Type::DrawFilledRectangle:
+      renderer.drawFilledRectangle(command.mRect, command.mColor);
+      break;
+
+    case Type::DrawRectangle:
+      renderer.drawRectangle(command.mRect, command.mColor);
+      break;
+
+    case Type::DrawLine:
+      renderer.drawLine(
+        command.mRect.topLeft,
+        command.mRect.topLeft +
+          base::Vec2{command.mRect.size.width, command.mRect.size.height},
+        command.mColor);
+      break;
+
+    case Type::Custom:
+      break;
+  }
+}
+
+} // namespace rigel::renderer
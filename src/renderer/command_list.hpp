@@ -0,0 +1,206 @@
+/* Copyright (C) 2022, Nikolai Wuttke. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "base/color.hpp"
+#include "base/spatial_types.hpp"
+#include "renderer/renderer.hpp"
+
+#include <cstdint>
+#include <optional>
+#include <utility>
+#include <vector>
+
+
+namespace rigel::renderer
+{
+
+/** A list of drawing commands, recorded now and executed later
+ *
+ * Recording doesn't need a Renderer or GL context, so a command list can be
+ * built on another thread, or ahead of time, and then executed on the main
+ * thread. It can also be copied, e.g. to capture a frame's drawing commands
+ * for later playback in a benchmark.
+ *
+ * Each texture or custom command carries its own overlay color. When
+ * executing, the renderer's overlay color is only changed when it differs
+ * from the previous command's, and the renderer's state is restored
+ * afterwards.
+ * Other renderer state (e.g. translation, clip rect) is used as is.
+ *
+ * Commands are assigned to layers. sort() orders commands by layer, while
+ * keeping the recording order within each layer. This way, a producer can
+ * record things in a different order than they need to be drawn in.
+ *
+ * Commands which the list can't represent directly, like sprites using a
+ * custom shader, are recorded as custom commands. These are identified by a
+ * producer-defined tag, and are passed to a handler function during
+ * execution.
+ *
+ * Clearing the list keeps its memory, so after the first few frames,
+ * recording doesn't allocate anymore.
+ */
+class CommandList
+{
+public:
+  enum class Type : std::uint8_t
+  {
+    DrawTexture,
+    DrawFilledRectangle,
+    DrawRectangle,
+    DrawLine,
+    Custom
+  };
+
+  struct Command
+  {
+    Type mType;
+    std::uint16_t mCustomTag;
+    std::int16_t mLayer;
+    TextureId mTexture;
+    TexCoords mTexCoords;
+    base::Rect<int> mRect;
+    base::Color mColor;
+    base::Color mOverlayColor;
+  };
+
+  /** Layer assigned to commands recorded from now on */
+  void setLayer(const int layer) { mCurrentLayer = std::int16_t(layer); }
+
+  /** Overlay color for textures recorded from now on */
+  void setOverlayColor(const base::Color& color) { mOverlayColor = color; }
+
+  void drawTexture(
+    TextureId texture,
+    const TexCoords& texCoords,
+    const base::Rect<int>& destRect);
+  void
+    drawFilledRectangle(const base::Rect<int>& rect, const base::Color& color);
+  void drawRectangle(const base::Rect<int>& rect, const base::Color& color);
+  void drawLine(
+    const base::Vec2& start,
+    const base::Vec2& end,
+    const base::Color& color);
+  void drawCustom(
+    std::uint16_t tag,
+    TextureId texture,
+    const TexCoords& texCoords,
+    const base::Rect<int>& destRect);
+
+  /** Order commands by layer, keeping recording order within a layer */
+  void sort();
+
+  /** Execute all commands on the given renderer
+   *
+   * customHandler is invoked for each custom command, with the command as
+   * argument. customRunEndHandler is invoked at the end of each run of
+   * consecutive custom commands, before anything else is drawn. Handlers
+   * which batch custom commands use this to draw them in the right order.
+   */
+  template <typename CustomHandler, typename CustomRunEndHandler>
+  void execute(
+    Renderer& renderer,
+    CustomHandler&& customHandler,
+    CustomRunEndHandler&& customRunEndHandler) const;
+
+  template <typename CustomHandler>
+  void execute(Renderer& renderer, CustomHandler&& customHandler) const
+  {
+    execute(renderer, std::forward<CustomHandler>(customHandler), []() {});
+  }
+
+  /** Execute all commands, ignoring custom commands */
+  void execute(Renderer& renderer) const
+  {
+    execute(renderer, [](const Command&) {});
+  }
+
+  /** Remove all commands, and reset layer and overlay color */
+  void clear();
+
+  const std::vector<Command>& commands() const { return mCommands; }
+  bool empty() const { return mCommands.empty(); }
+
+private:
+  void add(const Command& command);
+
+  /** Execute a single built-in command, i.e. anything but a custom one */
+  static void executeBuiltIn(Renderer& renderer, const Command& command);
+
+  std::vector<Command> mCommands;
+  bool mHasMultipleLayers = false;
+  std::int16_t mCurrentLayer = 0;
+  base::Color mOverlayColor{0, 0, 0, 0};
+};
+
+
+template <typename CustomHandler, typename CustomRunEndHandler>
+void CommandList::execute(
+  Renderer& renderer,
+  CustomHandler&& customHandler,
+  CustomRunEndHandler&& customRunEndHandler) const
+{
+  auto currentOverlayColor = std::optional<base::Color>{};
+  auto isInCustomRun = false;
+
+  for (const auto& command : mCommands)
+  {
+    const auto usesOverlayColor =
+      command.mType == Type::DrawTexture || command.mType == Type::Custom;
+    const auto overlayColorChanges =
+      usesOverlayColor && currentOverlayColor != command.mOverlayColor;
+
+    if (isInCustomRun && (command.mType != Type::Custom || overlayColorChanges))
+    {
+      customRunEndHandler();
+      isInCustomRun = false;
+    }
+
+    if (overlayColorChanges)
+    {
+      if (!currentOverlayColor)
+      {
+        renderer.pushState();
+      }
+
+      renderer.setOverlayColor(command.mOverlayColor);
+      currentOverlayColor = command.mOverlayColor;
+    }
+
+    if (command.mType == Type::Custom)
+    {
+      customHandler(command);
+      isInCustomRun = true;
+    }
+    else
+    {
+      executeBuiltIn(renderer, command);
+    }
+  }
+
+  if (isInCustomRun)
+  {
+    customRunEndHandler();
+  }
+
+  if (currentOverlayColor)
+  {
+    renderer.popState();
+  }
+}
+
+} // namespace rigel::renderer
@@ -0,0 +1,59 @@
+/* Copyright (C) 2022, Nikolai Wuttke. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "dynamic_resolution.hpp"
+
+
+namespace rigel::renderer
+{
+
+namespace
+{
+
+// When going up a step, the number of pixels rendered grows by up to ~30%,
+// so the restore threshold must leave enough headroom for that.
+constexpr auto CONTROLLER_CONFIG = base::BudgetController::Config{
+  0.1f, // smoothing factor
+  0.9f, // reduce threshold
+  0.6f, // restore threshold
+  15, // frames before reduce
+  120, // frames before restore
+  int((1.0f - DynamicResolutionController::MIN_SCALE) /
+      DynamicResolutionController::SCALE_STEP)};
+
+} // namespace
+
+
+DynamicResolutionController::DynamicResolutionController()
+  : mController(CONTROLLER_CONFIG)
+{
+}
+
+
+bool DynamicResolutionController::update(
+  const std::optional<float> gpuTimeMs,
+  const float budgetMs)
+{
+  return gpuTimeMs && mController.update(*gpuTimeMs, budgetMs);
+}
+
+
+void DynamicResolutionController::reset()
+{
+  mController.reset();
+}
+
+} // namespace rigel::renderer
@@ -0,0 +1,57 @@
+/* Copyright (C) 2022, Nikolai Wuttke. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "base/budget_controller.hpp"
+
+#include <optional>
+
+
+namespace rigel::renderer
+{
+
+/** Picks a resolution scale that keeps GPU time within a frame budget
+ *
+ * Meant to be fed the GPU time of each frame, as reported by
+ * FrameStatistics::mGpuTimeMs. If the smoothed GPU time stays above the
+ * budget for a number of frames, the scale is lowered by one step. It's
+ * raised again once the time has been well below the budget for a
+ * considerably longer period (see base::BudgetController).
+ *
+ * Without GPU timing information, the scale is left as is.
+ */
+class DynamicResolutionController
+{
+public:
+  static constexpr auto MIN_SCALE = 0.5f;
+  static constexpr auto SCALE_STEP = 0.125f;
+
+  DynamicResolutionController();
+
+  /** Returns true if the scale has changed */
+  bool update(std::optional<float> gpuTimeMs, float budgetMs);
+
+  /** Go back to full resolution, and forget all previous measurements */
+  void reset();
+
+  float scale() const { return 1.0f - mController.level() * SCALE_STEP; }
+
+private:
+  base::BudgetController mController;
+};
+
+} // namespace rigel::renderer
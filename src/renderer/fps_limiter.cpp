@@ -18,13 +18,94 @@
 
 #include <SDL_timer.h>
 
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <thread>
+
 
 namespace rigel::renderer
 {
 
-FpsLimiter::FpsLimiter(const int targetFps)
+namespace
+{
+
+// SDL_Delay can overshoot by a millisecond or more depending on the OS
+// scheduler, so we stop sleeping this long before the deadline and spin for
+// the remainder.
+constexpr auto SPIN_WAIT_MARGIN = std::chrono::microseconds{2000};
+
+// When more than this many frames behind schedule (e.g. after a loading
+// pause), we drop the missed deadlines instead of rushing to catch up.
+constexpr auto MAX_FRAMES_BEHIND = 2;
+
+// A target frame rate within this fraction of the refresh rate (or an integer
+// fraction of it) is snapped to the refresh period.
+constexpr auto REFRESH_ALIGNMENT_TOLERANCE = 0.05;
+constexpr auto MAX_REFRESH_DIVISOR = 4;
+
+
+double alignedFrameRate(const int targetFps, const int displayRefreshRate)
+{
+  if (displayRefreshRate <= 0)
+  {
+    return targetFps;
+  }
+
+  for (auto divisor = 1; divisor <= MAX_REFRESH_DIVISOR; ++divisor)
+  {
+    const auto candidate = double(displayRefreshRate) / divisor;
+    if (
+      std::abs(targetFps - candidate) / candidate <=
+      REFRESH_ALIGNMENT_TOLERANCE)
+    {
+      return candidate;
+    }
+  }
+
+  return targetFps;
+}
+
+
+base::Clock::duration frameTimeFor(const double frameRate)
+{
+  return std::chrono::duration_cast<base::Clock::duration>(
+    std::chrono::duration<double>(1.0 / frameRate));
+}
+
+} // namespace
+
+
+base::Clock::time_point waitUntil(const base::Clock::time_point deadline)
+{
+  using namespace std::chrono;
+
+  auto now = base::Clock::now();
+  if (deadline - now > SPIN_WAIT_MARGIN)
+  {
+    // We use SDL_Delay instead of std::this_thread::sleep_for, because the
+    // former is more accurate on some platforms.
+    const auto timeToSleepFor =
+      duration_cast<milliseconds>(deadline - now - SPIN_WAIT_MARGIN);
+    SDL_Delay(static_cast<Uint32>(timeToSleepFor.count()));
+  }
+
+  now = base::Clock::now();
+  while (now < deadline)
+  {
+    std::this_thread::yield();
+    now = base::Clock::now();
+  }
+
+  return now;
+}
+
+
+FpsLimiter::FpsLimiter(const int targetFps, const int displayRefreshRate)
   : mLastTime(base::Clock::now())
-  , mTargetFrameTime(1.0 / targetFps)
+  , mNextDeadline(mLastTime)
+  , mTargetFrameTime(
+      frameTimeFor(alignedFrameRate(targetFps, displayRefreshRate)))
 {
 }
 
@@ -33,19 +114,53 @@ void FpsLimiter::updateAndWait()
 {
   using namespace std::chrono;
 
+  mNextDeadline += mTargetFrameTime;
+
   const auto now = base::Clock::now();
-  const auto delta = duration<double>(now - mLastTime).count();
-  mLastTime = now;
+  if (now - mNextDeadline > mTargetFrameTime * MAX_FRAMES_BEHIND)
+  {
+    mNextDeadline = now;
+  }
+
+  const auto endOfWait = waitUntil(mNextDeadline);
 
-  mError += mTargetFrameTime - delta;
+  recordFrameTime(duration<double>(endOfWait - mLastTime).count());
+  mLastTime = endOfWait;
+}
 
-  const auto timeToWaitFor = mTargetFrameTime + mError;
-  if (timeToWaitFor > 0.0)
+
+FramePacingStats FpsLimiter::pacingStats() const
+{
+  FramePacingStats stats;
+  stats.mTargetFrameTime =
+    std::chrono::duration<double>(mTargetFrameTime).count();
+
+  if (mNumSamples == 0)
   {
-    // We use SDL_Delay instead of std::this_thread::sleep_for, because the
-    // former is more accurate on some platforms.
-    SDL_Delay(static_cast<Uint32>(timeToWaitFor * 1000.0));
+    return stats;
   }
+
+  const auto first = std::begin(mFrameTimeSamples);
+  const auto last = first + mNumSamples;
+
+  stats.mMeanFrameTime = std::accumulate(first, last, 0.0) / mNumSamples;
+
+  auto sumOfSquaredDeviations = 0.0;
+  std::for_each(first, last, [&](const double sample) {
+    const auto deviation = sample - stats.mMeanFrameTime;
+    sumOfSquaredDeviations += deviation * deviation;
+  });
+  stats.mFrameTimeVariance = sumOfSquaredDeviations / mNumSamples;
+
+  return stats;
+}
+
+
+void FpsLimiter::recordFrameTime(const double frameTime)
+{
+  mFrameTimeSamples[mNextSampleIndex] = frameTime;
+  mNextSampleIndex = (mNextSampleIndex + 1) % SAMPLE_COUNT;
+  mNumSamples = std::min(mNumSamples + 1, SAMPLE_COUNT);
 }
 
 } // namespace rigel::renderer
@@ -18,21 +18,67 @@
 
 #include "base/clock.hpp"
 
+#include <array>
+#include <cstddef>
+
 
 namespace rigel::renderer
 {
 
+/** Statistics about the frame times produced by an FpsLimiter
+ *
+ * Frame times are measured between consecutive calls to
+ * FpsLimiter::updateAndWait(), i.e. after waiting, and are given in seconds.
+ * The numbers cover the most recent frames only (see SAMPLE_COUNT).
+ */
+struct FramePacingStats
+{
+  double mTargetFrameTime = 0.0;
+  double mMeanFrameTime = 0.0;
+  double mFrameTimeVariance = 0.0;
+};
+
+
+/** Wait precisely until the given point in time
+ *
+ * Waiting is done in two phases: A coarse sleep, which gives the CPU back
+ * to the OS but has limited accuracy, followed by a short busy-wait which
+ * ends precisely at the deadline. Returns the time at which waiting ended.
+ */
+base::Clock::time_point waitUntil(base::Clock::time_point deadline);
+
+
+/** Limits the frame rate by waiting until the next frame is due
+ *
+ * Waiting is done using waitUntil(). Deadlines are scheduled at fixed
+ * intervals, so that short frames don't accumulate drift.
+ *
+ * If a display refresh rate is given and the target frame rate is close to
+ * the refresh rate or an integer fraction of it, the frame interval is
+ * aligned to the refresh period. This avoids a slow beat between the
+ * game's frames and the display's scan-out when V-Sync is off.
+ */
 class FpsLimiter
 {
 public:
-  explicit FpsLimiter(int targetFps);
+  static constexpr std::size_t SAMPLE_COUNT = 120;
+
+  explicit FpsLimiter(int targetFps, int displayRefreshRate = 0);
 
   void updateAndWait();
 
+  FramePacingStats pacingStats() const;
+
 private:
+  void recordFrameTime(double frameTime);
+
   base::Clock::time_point mLastTime = {};
-  double mTargetFrameTime;
-  double mError = 0.0;
+  base::Clock::time_point mNextDeadline = {};
+  base::Clock::duration mTargetFrameTime;
+
+  std::array<double, SAMPLE_COUNT> mFrameTimeSamples = {};
+  std::size_t mNextSampleIndex = 0;
+  std::size_t mNumSamples = 0;
 };
 
 } // namespace rigel::renderer
@@ -0,0 +1,115 @@
+/* Copyright (C) 2022, Nikolai Wuttke. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "frame_delay_scheduler.hpp"
+
+#include "base/math_utils.hpp"
+#include "renderer/fps_limiter.hpp"
+
+#include <algorithm>
+
+
+namespace rigel::renderer
+{
+
+namespace
+{
+
+constexpr auto MIN_SAFETY_MARGIN = std::chrono::microseconds{1500};
+
+// Added to the safety margin when a refresh was missed
+constexpr auto MISSED_REFRESH_PENALTY = std::chrono::microseconds{1000};
+
+// Removed from the safety margin for each frame shown in time
+constexpr auto SAFETY_MARGIN_DECAY = std::chrono::microseconds{10};
+
+constexpr auto LATENCY_FILTER_WEIGHT = 0.95;
+
+
+template <typename Duration>
+double toSeconds(const Duration& duration)
+{
+  return std::chrono::duration<double>(duration).count();
+}
+
+} // namespace
+
+
+FrameDelayScheduler::FrameDelayScheduler(const int displayRefreshRate)
+  : mRefreshPeriod(std::chrono::duration_cast<base::Clock::duration>(
+      std::chrono::duration<double>(1.0 / displayRefreshRate)))
+  , mSafetyMargin(MIN_SAFETY_MARGIN)
+  , mFrameStart(base::Clock::now())
+  , mLastSwapDone(mFrameStart)
+{
+}
+
+
+void FrameDelayScheduler::frameWorkDone()
+{
+  mWorkTimeSamples[mNextSampleIndex] = base::Clock::now() - mFrameStart;
+  mNextSampleIndex = (mNextSampleIndex + 1) % SAMPLE_COUNT;
+  mNumSamples = std::min(mNumSamples + 1, SAMPLE_COUNT);
+}
+
+
+void FrameDelayScheduler::waitForNextFrame()
+{
+  const auto swapDone = base::Clock::now();
+
+  // When swapping returns more than half a period later than expected, we
+  // most likely started the frame too late.
+  const auto missedRefresh =
+    swapDone - mLastSwapDone > mRefreshPeriod + mRefreshPeriod / 2;
+  mLastSwapDone = swapDone;
+
+  mSafetyMargin = missedRefresh
+    ? std::min<base::Clock::duration>(
+        mSafetyMargin + MISSED_REFRESH_PENALTY, mRefreshPeriod / 2)
+    : std::max<base::Clock::duration>(
+        mSafetyMargin - SAFETY_MARGIN_DECAY, MIN_SAFETY_MARGIN);
+
+  const auto inputLatency =
+    toSeconds(swapDone - mFrameStart) + toSeconds(mRefreshPeriod) / 2.0;
+  mStats.mInputLatency = mStats.mInputLatency == 0.0
+    ? inputLatency
+    : base::lerp(inputLatency, mStats.mInputLatency, LATENCY_FILTER_WEIGHT);
+
+  if (mNumSamples < SAMPLE_COUNT)
+  {
+    mFrameStart = swapDone;
+    mStats.mFrameDelay = 0.0;
+    return;
+  }
+
+  // Swapping returns right after a refresh, so the next one is due about
+  // one refresh period from now
+  const auto nextRefresh = swapDone + mRefreshPeriod;
+  const auto nextFrameStart =
+    std::max(swapDone, nextRefresh - predictedWorkTime() - mSafetyMargin);
+
+  mFrameStart = waitUntil(nextFrameStart);
+  mStats.mFrameDelay = toSeconds(mFrameStart - swapDone);
+}
+
+
+base::Clock::duration FrameDelayScheduler::predictedWorkTime() const
+{
+  return *std::max_element(
+    std::begin(mWorkTimeSamples), std::end(mWorkTimeSamples));
+}
+
+} // namespace rigel::renderer
@@ -0,0 +1,90 @@
+/* Copyright (C) 2022, Nikolai Wuttke. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "base/clock.hpp"
+
+#include <array>
+#include <cstddef>
+
+
+namespace rigel::renderer
+{
+
+/** Latency numbers produced by a FrameDelayScheduler, in seconds */
+struct FrameDelayStats
+{
+  /** How long the start of the most recent frame was delayed */
+  double mFrameDelay = 0.0;
+
+  /** Estimated time from sampling input until the frame is on screen
+   *
+   * Measured from the start of a frame until swapping buffers has returned,
+   * plus half a refresh period for scan-out to reach the middle of the
+   * screen. Smoothed over recent frames.
+   */
+  double mInputLatency = 0.0;
+};
+
+
+/** Delays the start of frames to reduce input latency with V-Sync on
+ *
+ * With V-Sync, swapping buffers blocks until the display's next refresh.
+ * When the next frame starts right after that, its input is sampled almost
+ * a whole refresh period before the frame can be shown. This scheduler
+ * instead waits after swapping, so that the next frame starts just early
+ * enough to be ready in time for the following refresh.
+ *
+ * The wait is based on the longest frame work time (everything up to
+ * swapping buffers) among the recent frames, plus a safety margin. The
+ * margin grows whenever a refresh was missed, and slowly shrinks again
+ * otherwise. Frames aren't delayed until enough work times have been
+ * recorded for a prediction. If the driver doesn't block when swapping
+ * buffers but later on, the measured work time includes that wait, which
+ * causes the delay to drop to zero - i.e., the scheduler has no effect.
+ */
+class FrameDelayScheduler
+{
+public:
+  static constexpr std::size_t SAMPLE_COUNT = 60;
+
+  explicit FrameDelayScheduler(int displayRefreshRate);
+
+  /** Call right before swapping buffers */
+  void frameWorkDone();
+
+  /** Call right after swapping buffers, waits until the next frame is due */
+  void waitForNextFrame();
+
+  FrameDelayStats stats() const { return mStats; }
+
+private:
+  base::Clock::duration predictedWorkTime() const;
+
+  base::Clock::duration mRefreshPeriod;
+  base::Clock::duration mSafetyMargin;
+  base::Clock::time_point mFrameStart;
+  base::Clock::time_point mLastSwapDone;
+
+  std::array<base::Clock::duration, SAMPLE_COUNT> mWorkTimeSamples = {};
+  std::size_t mNextSampleIndex = 0;
+  std::size_t mNumSamples = 0;
+
+  FrameDelayStats mStats;
+};
+
+} // namespace rigel::renderer
@@ -0,0 +1,141 @@
+/* Copyright (C) 2022, Nikolai Wuttke. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "gl_state_cache.hpp"
+
+#include <algorithm>
+#include <utility>
+
+
+namespace rigel::renderer
+{
+
+bool GlStateCache::useProgram(const GLuint program)
+{
+  if (mProgram == program)
+  {
+    return skip();
+  }
+
+  glUseProgram(program);
+  mProgram = program;
+  return true;
+}
+
+
+bool GlStateCache::bindTexture(const int unit, const GLuint texture)
+{
+  if (mTextures[unit] == texture && (unit != 0 || mActiveTextureUnit == 0))
+  {
+    return skip();
+  }
+
+  if (mActiveTextureUnit != unit)
+  {
+    glActiveTexture(GLenum(GL_TEXTURE0 + unit));
+    mActiveTextureUnit = unit;
+  }
+
+  if (mTextures[unit] != texture)
+  {
+    glBindTexture(GL_TEXTURE_2D, texture);
+    mTextures[unit] = texture;
+  }
+
+  return true;
+}
+
+
+bool GlStateCache::bindFramebuffer(const GLuint framebuffer)
+{
+  if (mFramebuffer == framebuffer)
+  {
+    return skip();
+  }
+
+  glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+  mFramebuffer = framebuffer;
+  return true;
+}
+
+
+bool GlStateCache::setViewport(const base::Rect<int>& box)
+{
+  if (mViewport == box)
+  {
+    return skip();
+  }
+
+  glViewport(box.topLeft.x, box.topLeft.y, box.size.width, box.size.height);
+  mViewport = box;
+  return true;
+}
+
+
+bool GlStateCache::setScissorTestEnabled(const bool enabled)
+{
+  if (mScissorTestEnabled == enabled)
+  {
+    return skip();
+  }
+
+  if (enabled)
+  {
+    glEnable(GL_SCISSOR_TEST);
+  }
+  else
+  {
+    glDisable(GL_SCISSOR_TEST);
+  }
+
+  mScissorTestEnabled = enabled;
+  return true;
+}
+
+
+bool GlStateCache::setScissorBox(const base::Rect<int>& box)
+{
+  if (mScissorBox == box)
+  {
+    return skip();
+  }
+
+  glScissor(box.topLeft.x, box.topLeft.y, box.size.width, box.size.height);
+  mScissorBox = box;
+  return true;
+}
+
+
+void GlStateCache::forgetTexture(const GLuint texture)
+{
+  std::replace(mTextures.begin(), mTextures.end(), texture, 0u);
+}
+
+
+int GlStateCache::takeNumAvoidedCalls()
+{
+  return std::exchange(mNumAvoidedCalls, 0);
+}
+
+
+bool GlStateCache::skip()
+{
+  ++mNumAvoidedCalls;
+  return false;
+}
+
+} // namespace rigel::renderer
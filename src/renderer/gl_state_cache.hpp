@@ -0,0 +1,89 @@
+/* Copyright (C) 2022, Nikolai Wuttke. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#pragma once
+
+#include "base/spatial_types.hpp"
+#include "renderer/opengl.hpp"
+#include "renderer/renderer_support.hpp"
+
+#include <array>
+#include <optional>
+
+
+namespace rigel::renderer
+{
+
+/** Shadow copy of OpenGL state, to avoid redundant GL calls
+ *
+ * Keeps track of the values most recently set for a few pieces of GL
+ * state that the renderer changes frequently. Each setter only issues a
+ * GL call if the new value differs from the known current value.
+ *
+ * This only works if all modifications of the respective state go
+ * through this class. Code that changes state behind the cache's back
+ * (e.g. by calling Shader::use()) must call the matching invalidate
+ * function afterwards.
+ *
+ * All setters return true if they actually made a GL call.
+ */
+class GlStateCache
+{
+public:
+  bool useProgram(GLuint program);
+
+  /** Bind texture to the given texture unit
+   *
+   * Might change the active texture unit. Use bindTexture(0, ...) for
+   * texture operations like uploading data, which makes sure that unit 0
+   * is active.
+   */
+  bool bindTexture(int unit, GLuint texture);
+
+  bool bindFramebuffer(GLuint framebuffer);
+  bool setViewport(const base::Rect<int>& box);
+  bool setScissorTestEnabled(bool enabled);
+  bool setScissorBox(const base::Rect<int>& box);
+
+  GLuint boundTexture(int unit) const { return mTextures[unit]; }
+
+  /** Forget about a texture that's about to be deleted
+   *
+   * Deleting a texture unbinds it from all units, and the GL might hand
+   * out the same name again for a new texture.
+   */
+  void forgetTexture(GLuint texture);
+
+  void invalidateProgram() { mProgram = std::nullopt; }
+
+  /** Number of GL calls skipped since the last call */
+  int takeNumAvoidedCalls();
+
+private:
+  bool skip();
+
+  std::array<GLuint, MAX_MULTI_TEXTURES> mTextures{};
+  std::optional<GLuint> mProgram;
+  GLuint mFramebuffer = 0;
+  std::optional<base::Rect<int>> mViewport;
+  std::optional<base::Rect<int>> mScissorBox;
+  std::optional<bool> mScissorTestEnabled;
+  int mActiveTextureUnit = 0;
+  int mNumAvoidedCalls = 0;
+};
+
+} // namespace rigel::renderer
@@ -0,0 +1,120 @@
+/* Copyright (C) 2022, Nikolai Wuttke. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "gpu_frame_timer.hpp"
+
+
+namespace rigel::renderer
+{
+
+GpuFrameTimer::GpuFrameTimer()
+#ifdef RIGEL_USE_GL_ES
+  : mIsSupported(false)
+#else
+  : mIsSupported(optionalGlFeatures().mHasTimerQuery)
+#endif
+{
+#ifndef RIGEL_USE_GL_ES
+  if (mIsSupported)
+  {
+    glGenQueries(GLsizei(NUM_QUERIES), mQueries.data());
+  }
+#endif
+}
+
+
+GpuFrameTimer::~GpuFrameTimer()
+{
+#ifndef RIGEL_USE_GL_ES
+  if (mIsSupported)
+  {
+    glDeleteQueries(GLsizei(NUM_QUERIES), mQueries.data());
+  }
+#endif
+}
+
+
+void GpuFrameTimer::beginFrame()
+{
+#ifndef RIGEL_USE_GL_ES
+  // If the GPU is lagging behind so much that all queries are still in
+  // flight, we skip measuring this frame instead of waiting.
+  if (!mIsSupported || mQueryActive || mQueryPending[mCurrentQuery])
+  {
+    return;
+  }
+
+  glBeginQuery(ext::GL_TIME_ELAPSED, mQueries[mCurrentQuery]);
+  mQueryActive = true;
+#endif
+}
+
+
+void GpuFrameTimer::endFrame()
+{
+#ifndef RIGEL_USE_GL_ES
+  if (!mIsSupported)
+  {
+    return;
+  }
+
+  if (mQueryActive)
+  {
+    glEndQuery(ext::GL_TIME_ELAPSED);
+    mQueryPending[mCurrentQuery] = true;
+    mQueryActive = false;
+    mCurrentQuery = (mCurrentQuery + 1) % NUM_QUERIES;
+  }
+
+  collectResults();
+#endif
+}
+
+
+void GpuFrameTimer::collectResults()
+{
+#ifndef RIGEL_USE_GL_ES
+  // Go from oldest to newest query, so that we end up with the result of
+  // the most recent frame.
+  for (auto i = std::size_t{0}; i < NUM_QUERIES; ++i)
+  {
+    const auto index = (mCurrentQuery + i) % NUM_QUERIES;
+    if (!mQueryPending[index])
+    {
+      continue;
+    }
+
+    GLuint available = GL_FALSE;
+    glGetQueryObjectuiv(
+      mQueries[index], GL_QUERY_RESULT_AVAILABLE, &available);
+    if (!available)
+    {
+      // Queries complete in order, so none of the later ones can be
+      // available either.
+      break;
+    }
+
+    // A 32-bit result is enough for up to 4 seconds of GPU time
+    GLuint elapsedNs = 0;
+    glGetQueryObjectuiv(mQueries[index], GL_QUERY_RESULT, &elapsedNs);
+    mQueryPending[index] = false;
+    mLastFrameTimeMs = float(elapsedNs) / 1'000'000.0f;
+  }
+#endif
+}
+
+} // namespace rigel::renderer
@@ -0,0 +1,69 @@
+/* Copyright (C) 2022, Nikolai Wuttke. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#pragma once
+
+#include "renderer/opengl.hpp"
+
+#include <array>
+#include <cstddef>
+#include <optional>
+
+
+namespace rigel::renderer
+{
+
+/** Measures GPU time spent per frame, using GL_TIME_ELAPSED queries
+ *
+ * Query results only become available once the GPU has finished the
+ * corresponding frame, which is usually a frame or two after issuing it.
+ * To avoid stalling the pipeline, the timer rotates through a few queries
+ * and only reads results that are already available. The reported time
+ * therefore lags behind the current frame slightly.
+ *
+ * If timer queries aren't supported, all functions are no-ops and
+ * lastFrameTimeMs() always returns std::nullopt.
+ */
+class GpuFrameTimer
+{
+public:
+  GpuFrameTimer();
+  ~GpuFrameTimer();
+
+  GpuFrameTimer(const GpuFrameTimer&) = delete;
+  GpuFrameTimer& operator=(const GpuFrameTimer&) = delete;
+
+  void beginFrame();
+  void endFrame();
+
+  /** GPU time of the most recently measured frame, in milliseconds */
+  std::optional<float> lastFrameTimeMs() const { return mLastFrameTimeMs; }
+
+private:
+  void collectResults();
+
+  static constexpr auto NUM_QUERIES = std::size_t{4};
+
+  std::array<GLuint, NUM_QUERIES> mQueries{};
+  std::array<bool, NUM_QUERIES> mQueryPending{};
+  std::optional<float> mLastFrameTimeMs;
+  std::size_t mCurrentQuery = 0;
+  bool mIsSupported;
+  bool mQueryActive = false;
+};
+
+} // namespace rigel::renderer
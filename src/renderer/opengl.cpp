@@ -22,10 +22,192 @@ RIGEL_DISABLE_WARNINGS
 #include <SDL_video.h>
 RIGEL_RESTORE_WARNINGS
 
+#include <cstring>
 #include <stdexcept>
+#include <string_view>
 
 
-void rigel::renderer::loadGlFunctions()
+namespace rigel::renderer
+{
+
+namespace
+{
+
+OptionalGlFeatures gOptionalFeatures;
+
+
+#ifdef RIGEL_USE_GL_ES
+bool hasExtension(const char* name)
+{
+  // GL ES 2.0 only offers a single, space-separated list of extensions
+  const auto pExtensions =
+    reinterpret_cast<const char*>(glGetString(GL_EXTENSIONS));
+  if (!pExtensions)
+  {
+    return false;
+  }
+
+  const auto extensions = std::string_view{pExtensions};
+  const auto nameLength = std::strlen(name);
+
+  for (auto pos = extensions.find(name); pos != std::string_view::npos;
+       pos = extensions.find(name, pos + 1))
+  {
+    const auto end = pos + nameLength;
+    const auto isWholeWord = (pos == 0 || extensions[pos - 1] == ' ') &&
+      (end == extensions.size() || extensions[end] == ' ');
+    if (isWholeWord)
+    {
+      return true;
+    }
+  }
+
+  return false;
+}
+#else
+bool hasExtension(const char* name)
+{
+  GLint numExtensions = 0;
+  glGetIntegerv(GL_NUM_EXTENSIONS, &numExtensions);
+
+  for (auto i = 0; i < numExtensions; ++i)
+  {
+    const auto pExtension =
+      reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, GLuint(i)));
+    if (pExtension && std::strcmp(pExtension, name) == 0)
+    {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+
+bool glVersionAtLeast(const int major, const int minor)
+{
+  GLint actualMajor = 0;
+  GLint actualMinor = 0;
+  glGetIntegerv(GL_MAJOR_VERSION, &actualMajor);
+  glGetIntegerv(GL_MINOR_VERSION, &actualMinor);
+
+  return actualMajor > major || (actualMajor == major && actualMinor >= minor);
+}
+#endif
+
+
+template <typename FuncT>
+bool loadOptionalFunction(FuncT& func, const char* name)
+{
+  // Not using sdl_utils::check() here, since it's not an error if the
+  // function isn't available.
+  func = reinterpret_cast<FuncT>(SDL_GL_GetProcAddress(name));
+  return func != nullptr;
+}
+
+
+void loadOptionalFunctions()
+{
+#ifdef RIGEL_USE_GL_ES
+  if (hasExtension("GL_EXT_instanced_arrays"))
+  {
+    gOptionalFeatures.mHasInstancing =
+      loadOptionalFunction(
+        ext::glDrawArraysInstanced, "glDrawArraysInstancedEXT") &&
+      loadOptionalFunction(
+        ext::glVertexAttribDivisor, "glVertexAttribDivisorEXT");
+  }
+  else if (hasExtension("GL_ANGLE_instanced_arrays"))
+  {
+    gOptionalFeatures.mHasInstancing =
+      loadOptionalFunction(
+        ext::glDrawArraysInstanced, "glDrawArraysInstancedANGLE") &&
+      loadOptionalFunction(
+        ext::glVertexAttribDivisor, "glVertexAttribDivisorANGLE");
+  }
+
+  if (hasExtension("GL_OES_get_program_binary"))
+  {
+    gOptionalFeatures.mHasProgramBinary =
+      loadOptionalFunction(ext::glGetProgramBinary, "glGetProgramBinaryOES") &&
+      loadOptionalFunction(ext::glProgramBinary, "glProgramBinaryOES");
+  }
+#else
+  if (glVersionAtLeast(3, 2) || hasExtension("GL_ARB_sync"))
+  {
+    gOptionalFeatures.mHasSync =
+      loadOptionalFunction(ext::glFenceSync, "glFenceSync") &&
+      loadOptionalFunction(ext::glDeleteSync, "glDeleteSync") &&
+      loadOptionalFunction(ext::glClientWaitSync, "glClientWaitSync");
+  }
+
+  if (glVersionAtLeast(4, 4) || hasExtension("GL_ARB_buffer_storage"))
+  {
+    gOptionalFeatures.mHasBufferStorage =
+      loadOptionalFunction(ext::glBufferStorage, "glBufferStorage");
+  }
+
+  gOptionalFeatures.mHasTimerQuery =
+    glVersionAtLeast(3, 3) || hasExtension("GL_ARB_timer_query");
+
+  if (glVersionAtLeast(3, 3))
+  {
+    gOptionalFeatures.mHasInstancing =
+      loadOptionalFunction(
+        ext::glDrawArraysInstanced, "glDrawArraysInstanced") &&
+      loadOptionalFunction(ext::glVertexAttribDivisor, "glVertexAttribDivisor");
+  }
+  else if (hasExtension("GL_ARB_instanced_arrays"))
+  {
+    gOptionalFeatures.mHasInstancing =
+      loadOptionalFunction(
+        ext::glDrawArraysInstanced, "glDrawArraysInstancedARB") &&
+      loadOptionalFunction(
+        ext::glVertexAttribDivisor, "glVertexAttribDivisorARB");
+  }
+
+  if (glVersionAtLeast(4, 1) || hasExtension("GL_ARB_get_program_binary"))
+  {
+    gOptionalFeatures.mHasProgramBinary =
+      loadOptionalFunction(ext::glGetProgramBinary, "glGetProgramBinary") &&
+      loadOptionalFunction(ext::glProgramBinary, "glProgramBinary");
+    loadOptionalFunction(ext::glProgramParameteri, "glProgramParameteri");
+  }
+#endif
+
+  // Drivers may support the extension, but not a single binary format
+  if (gOptionalFeatures.mHasProgramBinary)
+  {
+    GLint numFormats = 0;
+    glGetIntegerv(ext::GL_NUM_PROGRAM_BINARY_FORMATS, &numFormats);
+    gOptionalFeatures.mHasProgramBinary = numFormats > 0;
+  }
+}
+
+} // namespace
+
+
+namespace ext
+{
+
+DrawArraysInstancedFunc glDrawArraysInstanced = nullptr;
+VertexAttribDivisorFunc glVertexAttribDivisor = nullptr;
+GetProgramBinaryFunc glGetProgramBinary = nullptr;
+ProgramBinaryFunc glProgramBinary = nullptr;
+
+#ifndef RIGEL_USE_GL_ES
+
+FenceSyncFunc glFenceSync = nullptr;
+DeleteSyncFunc glDeleteSync = nullptr;
+ClientWaitSyncFunc glClientWaitSync = nullptr;
+BufferStorageFunc glBufferStorage = nullptr;
+ProgramParameteriFunc glProgramParameteri = nullptr;
+#endif
+
+} // namespace ext
+
+
+void loadGlFunctions()
 {
   int result = 0;
 
@@ -45,4 +227,14 @@ void rigel::renderer::loadGlFunctions()
   {
     throw std::runtime_error("Failed to load OpenGL function pointers");
   }
+
+  loadOptionalFunctions();
 }
+
+
+const OptionalGlFeatures& optionalGlFeatures()
+{
+  return gOptionalFeatures;
+}
+
+} // namespace rigel::renderer
@@ -38,4 +38,102 @@ constexpr auto OPENGL_VARIANT_NAME = "OpenGL";
 
 void loadGlFunctions();
 
+
+/** Availability of optional OpenGL functionality
+ *
+ * The renderer only requires OpenGL 3.0 or OpenGL ES 2.0, which is what the
+ * glad loader is generated for. Some functionality from later versions is
+ * beneficial for performance, though, and widely available via extensions.
+ * loadGlFunctions() detects these and loads the corresponding entry points
+ * (see the ext namespace below). Client code must check the flags here
+ * before using any of them.
+ */
+struct OptionalGlFeatures
+{
+  /** glFenceSync & co. (GL 3.2 or ARB_sync) */
+  bool mHasSync = false;
+
+  /** glBufferStorage (GL 4.4 or ARB_buffer_storage) */
+  bool mHasBufferStorage = false;
+
+  /** GL_TIME_ELAPSED queries (GL 3.3 or ARB_timer_query)
+   *
+   * The query functions themselves are part of GL 3.0, only the query
+   * target is new.
+   */
+  bool mHasTimerQuery = false;
+
+  /** glDrawArraysInstanced & glVertexAttribDivisor
+   *
+   * GL 3.3 or ARB_instanced_arrays, EXT_instanced_arrays or
+   * ANGLE_instanced_arrays on GL ES.
+   */
+  bool mHasInstancing = false;
+
+  /** glGetProgramBinary & glProgramBinary
+   *
+   * GL 4.1 or ARB_get_program_binary, OES_get_program_binary on GL ES.
+   * Only set if the driver also supports at least one binary format.
+   */
+  bool mHasProgramBinary = false;
+};
+
+const OptionalGlFeatures& optionalGlFeatures();
+
+
+namespace ext
+{
+
+using DrawArraysInstancedFunc =
+  void(KHRONOS_APIENTRY*)(GLenum, GLint, GLsizei, GLsizei);
+using VertexAttribDivisorFunc = void(KHRONOS_APIENTRY*)(GLuint, GLuint);
+
+extern DrawArraysInstancedFunc glDrawArraysInstanced;
+extern VertexAttribDivisorFunc glVertexAttribDivisor;
+
+using GetProgramBinaryFunc =
+  void(KHRONOS_APIENTRY*)(GLuint, GLsizei, GLsizei*, GLenum*, void*);
+using ProgramBinaryFunc =
+  void(KHRONOS_APIENTRY*)(GLuint, GLenum, const void*, GLsizei);
+
+extern GetProgramBinaryFunc glGetProgramBinary;
+extern ProgramBinaryFunc glProgramBinary;
+
+// Same values for the ARB and OES variants of the extension
+constexpr GLenum GL_PROGRAM_BINARY_LENGTH = 0x8741;
+constexpr GLenum GL_NUM_PROGRAM_BINARY_FORMATS = 0x87FE;
+
+#ifndef RIGEL_USE_GL_ES
+using FenceSyncFunc = GLsync(KHRONOS_APIENTRY*)(GLenum, GLbitfield);
+using DeleteSyncFunc = void(KHRONOS_APIENTRY*)(GLsync);
+using ClientWaitSyncFunc =
+  GLenum(KHRONOS_APIENTRY*)(GLsync, GLbitfield, GLuint64);
+using BufferStorageFunc =
+  void(KHRONOS_APIENTRY*)(GLenum, GLsizeiptr, const void*, GLbitfield);
+
+extern FenceSyncFunc glFenceSync;
+extern DeleteSyncFunc glDeleteSync;
+extern ClientWaitSyncFunc glClientWaitSync;
+extern BufferStorageFunc glBufferStorage;
+
+using ProgramParameteriFunc = void(KHRONOS_APIENTRY*)(GLuint, GLenum, GLint);
+
+// Optional, only needed for hinting that we want to retrieve the binary
+extern ProgramParameteriFunc glProgramParameteri;
+
+// Enum values from the respective extension specs, not part of GL 3.0
+constexpr GLenum GL_SYNC_GPU_COMMANDS_COMPLETE = 0x9117;
+constexpr GLbitfield GL_SYNC_FLUSH_COMMANDS_BIT = 0x00000001;
+constexpr GLenum GL_ALREADY_SIGNALED = 0x911A;
+constexpr GLenum GL_TIMEOUT_EXPIRED = 0x911B;
+constexpr GLenum GL_CONDITION_SATISFIED = 0x911C;
+constexpr GLenum GL_WAIT_FAILED = 0x911D;
+constexpr GLbitfield GL_MAP_PERSISTENT_BIT = 0x0040;
+constexpr GLbitfield GL_MAP_COHERENT_BIT = 0x0080;
+constexpr GLenum GL_TIME_ELAPSED = 0x88BF;
+constexpr GLenum GL_PROGRAM_BINARY_RETRIEVABLE_HINT = 0x8257;
+#endif
+
+} // namespace ext
+
 } // namespace rigel::renderer
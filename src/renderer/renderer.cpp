@@ -17,22 +17,35 @@
 #include "renderer.hpp"
 
 #include "assets/palette.hpp"
+#include "base/clock.hpp"
+#include "base/static_vector.hpp"
 #include "data/game_options.hpp"
 #include "data/game_traits.hpp"
+#include "renderer/async_readback.hpp"
+#include "renderer/gl_state_cache.hpp"
+#include "renderer/gpu_frame_timer.hpp"
 #include "renderer/opengl.hpp"
 #include "renderer/shader.hpp"
 #include "renderer/shader_code.hpp"
+#include "renderer/streaming_buffer.hpp"
+#include "renderer/texture_upload_queue.hpp"
 #include "renderer/vertex_buffer_utils.hpp"
 #include "sdl_utils/error.hpp"
 
 RIGEL_DISABLE_WARNINGS
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/mat4x4.hpp>
+#include <loguru.hpp>
 RIGEL_RESTORE_WARNINGS
 
 #include <algorithm>
 #include <array>
+#include <cassert>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
 #include <iterator>
+#include <vector>
 
 
 namespace rigel::renderer
@@ -43,19 +56,40 @@ namespace
 
 const GLushort QUAD_INDICES[] = {0, 2, 1, 2, 3, 1};
 
-constexpr std::array<GLenum, MAX_MULTI_TEXTURES> TEXTURE_UNIT_IDS{
-  GL_TEXTURE0,
-  GL_TEXTURE1,
-  GL_TEXTURE2,
-  GL_TEXTURE3,
-  GL_TEXTURE4,
-  GL_TEXTURE5,
-  GL_TEXTURE6,
-  GL_TEXTURE7};
-
 constexpr auto MAX_QUADS_PER_BATCH = 1280u;
 constexpr auto MAX_BATCH_SIZE = MAX_QUADS_PER_BATCH * std::size(QUAD_INDICES);
 
+// Keeps point and line batches within the size limit of a single upload to
+// the streaming vertex buffer
+constexpr auto MAX_SOLID_COLOR_VERTICES_PER_BATCH = MAX_QUADS_PER_BATCH * 4u;
+constexpr auto FLOATS_PER_SOLID_COLOR_VERTEX = 6u;
+constexpr auto FLOATS_PER_PARAMETERIZED_VERTEX = 9u;
+
+constexpr auto FLOATS_PER_QUAD_INSTANCE = std::tuple_size_v<QuadInstance>;
+
+// Destroyed render targets are kept around for reuse, since render targets
+// of the same few sizes tend to be recreated repeatedly, e.g. when toggling
+// fullscreen or switching between game modes.
+constexpr auto MAX_POOLED_RENDER_TARGETS = 4u;
+
+// The window counts as being resized until its size has been stable for
+// this long.
+constexpr auto WINDOW_RESIZE_SETTLE_TIME = std::chrono::milliseconds{200};
+
+// Corners of a quad in normalized coordinates, in triangle strip order.
+// Matches the winding of QUAD_INDICES.
+// clang-format off
+const GLfloat INSTANCED_QUAD_CORNERS[] = {
+  0.0f, 1.0f,
+  1.0f, 1.0f,
+  0.0f, 0.0f,
+  1.0f, 0.0f};
+// clang-format on
+
+constexpr auto UNIFORM_TRANSFORM = UniformId{"transform"};
+constexpr auto UNIFORM_COLOR_MODULATION = UniformId{"colorModulation"};
+constexpr auto UNIFORM_OVERLAY_COLOR = UniformId{"overlayColor"};
+
 
 #ifdef RIGEL_USE_GL_ES
 constexpr GLint MONO_TEXTURE_INTERNAL_FORMAT = GL_LUMINANCE;
@@ -108,10 +142,19 @@ struct RenderTarget
 };
 
 
+struct PooledRenderTarget
+{
+  TextureId mTexture;
+  RenderTarget mRenderTarget;
+};
+
+
 enum class RenderMode : std::uint8_t
 {
   SpriteBatch,
-  NonTexturedRender,
+  MultiTextureSpriteBatch,
+  FilledRectangles,
+  Lines,
   Points,
   CustomDrawing
 };
@@ -129,46 +172,246 @@ void* toAttribOffset(std::uintptr_t offset)
 }
 
 
-void setScissorBox(
+base::Rect<int> toGlScissorBox(
   const base::Rect<int>& clipRect,
   const base::Size& frameBufferSize)
 {
   const auto offsetAtBottom = frameBufferSize.height - clipRect.bottom();
-  glScissor(
-    clipRect.topLeft.x,
-    offsetAtBottom - 1,
-    clipRect.size.width,
-    clipRect.size.height);
+  return {{clipRect.topLeft.x, offsetAtBottom - 1}, clipRect.size};
+}
+
+
+/** Map a box in GL framebuffer coordinates to the scaled render region
+ *
+ * The rendered region is at the top of the framebuffer, so that it ends
+ * up at the top-left when drawing the render target as a texture.
+ */
+base::Rect<int> scaleGlBox(
+  const base::Rect<int>& box,
+  const base::Size& framebufferSize,
+  const float resolutionScale)
+{
+  if (resolutionScale == 1.0f)
+  {
+    return box;
+  }
+
+  const auto usedSize = scaledRenderSize(framebufferSize, resolutionScale);
+  const auto scaleX = float(usedSize.width) / framebufferSize.width;
+  const auto scaleY = float(usedSize.height) / framebufferSize.height;
+  const auto offsetY = framebufferSize.height - usedSize.height;
+
+  const auto left = int(std::floor(box.topLeft.x * scaleX));
+  const auto bottom = int(std::floor(box.topLeft.y * scaleY));
+  const auto right =
+    int(std::ceil((box.topLeft.x + box.size.width) * scaleX));
+  const auto top = int(std::ceil((box.topLeft.y + box.size.height) * scaleY));
+  return {{left, offsetY + bottom}, {right - left, top - bottom}};
 }
 
 
-void setVertexLayout(const VertexLayout layout)
+void setVertexLayout(
+  const VertexLayout layout,
+  const std::uintptr_t baseOffset = 0)
 {
   switch (layout)
   {
     case VertexLayout::PositionAndTexCoords:
       glVertexAttribPointer(
-        0, 2, GL_FLOAT, GL_FALSE, sizeof(float) * 4, toAttribOffset(0));
+        0,
+        2,
+        GL_FLOAT,
+        GL_FALSE,
+        sizeof(float) * 4,
+        toAttribOffset(baseOffset));
       glVertexAttribPointer(
         1,
         2,
         GL_FLOAT,
         GL_FALSE,
         sizeof(float) * 4,
-        toAttribOffset(sizeof(float) * 2));
+        toAttribOffset(baseOffset + sizeof(float) * 2));
       break;
 
     case VertexLayout::PositionAndColor:
       glVertexAttribPointer(
-        0, 2, GL_FLOAT, GL_FALSE, sizeof(float) * 6, toAttribOffset(0));
+        0,
+        2,
+        GL_FLOAT,
+        GL_FALSE,
+        sizeof(float) * 6,
+        toAttribOffset(baseOffset));
       glVertexAttribPointer(
         1,
         4,
         GL_FLOAT,
         GL_FALSE,
         sizeof(float) * 6,
-        toAttribOffset(sizeof(float) * 2));
+        toAttribOffset(baseOffset + sizeof(float) * 2));
+      break;
+
+    case VertexLayout::PositionTexCoordsAndTextureIndex:
+    case VertexLayout::PositionTexCoordsAndAnimation:
+    case VertexLayout::PositionTexCoordsAndEffect:
+      glVertexAttribPointer(
+        0,
+        2,
+        GL_FLOAT,
+        GL_FALSE,
+        sizeof(float) * 5,
+        toAttribOffset(baseOffset));
+      glVertexAttribPointer(
+        1,
+        2,
+        GL_FLOAT,
+        GL_FALSE,
+        sizeof(float) * 5,
+        toAttribOffset(baseOffset + sizeof(float) * 2));
+      glVertexAttribPointer(
+        2,
+        1,
+        GL_FLOAT,
+        GL_FALSE,
+        sizeof(float) * 5,
+        toAttribOffset(baseOffset + sizeof(float) * 4));
+      break;
+
+    case VertexLayout::PositionColorAndParameters:
+      glVertexAttribPointer(
+        0,
+        2,
+        GL_FLOAT,
+        GL_FALSE,
+        sizeof(float) * 9,
+        toAttribOffset(baseOffset));
+      glVertexAttribPointer(
+        1,
+        4,
+        GL_FLOAT,
+        GL_FALSE,
+        sizeof(float) * 9,
+        toAttribOffset(baseOffset + sizeof(float) * 2));
+      glVertexAttribPointer(
+        2,
+        3,
+        GL_FLOAT,
+        GL_FALSE,
+        sizeof(float) * 9,
+        toAttribOffset(baseOffset + sizeof(float) * 6));
+      break;
+
+    case VertexLayout::CompactPositionTexCoordsAndAnimation:
+      glVertexAttribPointer(
+        0,
+        2,
+        GL_SHORT,
+        GL_FALSE,
+        sizeof(CompactVertex),
+        toAttribOffset(baseOffset + offsetof(CompactVertex, x)));
+      glVertexAttribPointer(
+        1,
+        2,
+        GL_UNSIGNED_SHORT,
+        GL_TRUE,
+        sizeof(CompactVertex),
+        toAttribOffset(baseOffset + offsetof(CompactVertex, u)));
+      glVertexAttribPointer(
+        2,
+        1,
+        GL_UNSIGNED_SHORT,
+        GL_FALSE,
+        sizeof(CompactVertex),
+        toAttribOffset(baseOffset + offsetof(CompactVertex, parameter)));
+      break;
+
+    case VertexLayout::InstancedQuad:
+      // Needs a second buffer, see setInstancedQuadLayout()
+      assert(false);
+      break;
+  }
+
+  // Only these layouts make use of a 3rd attribute
+  if (
+    layout == VertexLayout::PositionTexCoordsAndTextureIndex ||
+    layout == VertexLayout::PositionTexCoordsAndAnimation ||
+    layout == VertexLayout::CompactPositionTexCoordsAndAnimation ||
+    layout == VertexLayout::PositionTexCoordsAndEffect ||
+    layout == VertexLayout::PositionColorAndParameters)
+  {
+    glEnableVertexAttribArray(2);
+  }
+  else
+  {
+    glDisableVertexAttribArray(2);
+  }
+}
+
+
+std::size_t floatsPerQuad(const VertexLayout layout)
+{
+  switch (layout)
+  {
+    case VertexLayout::PositionAndColor:
+      return 4 * FLOATS_PER_SOLID_COLOR_VERTEX;
+
+    case VertexLayout::PositionTexCoordsAndTextureIndex:
+    case VertexLayout::PositionTexCoordsAndAnimation:
+    case VertexLayout::PositionTexCoordsAndEffect:
+      return std::tuple_size<MultiTexturedQuadVertices>::value;
+
+    case VertexLayout::PositionAndTexCoords:
+    case VertexLayout::InstancedQuad:
+    case VertexLayout::PositionColorAndParameters:
+    case VertexLayout::CompactPositionTexCoordsAndAnimation:
+      break;
   }
+
+  return std::tuple_size<QuadVertices>::value;
+}
+
+
+void setInstancedQuadLayout(
+  const GLuint cornerVbo,
+  const GLuint instanceVbo,
+  const std::uintptr_t baseOffset)
+{
+  constexpr auto STRIDE = GLsizei(sizeof(float) * FLOATS_PER_QUAD_INSTANCE);
+
+  glBindBuffer(GL_ARRAY_BUFFER, cornerVbo);
+  glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 0, nullptr);
+
+  glBindBuffer(GL_ARRAY_BUFFER, instanceVbo);
+  glVertexAttribPointer(
+    1, 4, GL_FLOAT, GL_FALSE, STRIDE, toAttribOffset(baseOffset));
+  glVertexAttribPointer(
+    2,
+    4,
+    GL_FLOAT,
+    GL_FALSE,
+    STRIDE,
+    toAttribOffset(baseOffset + sizeof(float) * 4));
+  glVertexAttribPointer(
+    3,
+    1,
+    GL_FLOAT,
+    GL_FALSE,
+    STRIDE,
+    toAttribOffset(baseOffset + sizeof(float) * 8));
+
+  glEnableVertexAttribArray(2);
+  glEnableVertexAttribArray(3);
+  ext::glVertexAttribDivisor(1, 1);
+  ext::glVertexAttribDivisor(2, 1);
+  ext::glVertexAttribDivisor(3, 1);
+}
+
+
+void resetInstancedQuadLayout()
+{
+  ext::glVertexAttribDivisor(1, 0);
+  ext::glVertexAttribDivisor(2, 0);
+  ext::glVertexAttribDivisor(3, 0);
+  glDisableVertexAttribArray(3);
 }
 
 
@@ -181,7 +424,17 @@ auto getSize(SDL_Window* pWindow)
 }
 
 
+void setDefaultTextureParameters()
+{
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+}
+
+
 GLuint createGlTexture(
+  GlStateCache& stateCache,
   const GLsizei width,
   const GLsizei height,
   const GLvoid* const pData,
@@ -191,11 +444,8 @@ GLuint createGlTexture(
   GLuint handle = 0;
   glGenTextures(1, &handle);
 
-  glBindTexture(GL_TEXTURE_2D, handle);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+  stateCache.bindTexture(0, handle);
+  setDefaultTextureParameters();
 
   glTexImage2D(
     GL_TEXTURE_2D,
@@ -223,6 +473,7 @@ struct Renderer::Impl
     glm::vec2 mGlobalTranslation{0.0f, 0.0f};
     glm::vec2 mGlobalScale{1.0f, 1.0f};
     TextureId mRenderTargetTexture = 0;
+    float mResolutionScale = 1.0f;
     bool mTextureRepeatEnabled = false;
 
     friend bool operator==(const State& lhs, const State& rhs)
@@ -236,6 +487,7 @@ struct Renderer::Impl
           lhs.mGlobalTranslation,
           lhs.mGlobalScale,
           lhs.mRenderTargetTexture,
+          lhs.mResolutionScale,
           lhs.mTextureRepeatEnabled) ==
         std::tie(
           rhs.mClipRect,
@@ -244,6 +496,7 @@ struct Renderer::Impl
           rhs.mGlobalTranslation,
           rhs.mGlobalScale,
           rhs.mRenderTargetTexture,
+          rhs.mResolutionScale,
           rhs.mTextureRepeatEnabled);
       // clang-format on
     }
@@ -268,7 +521,8 @@ struct Renderer::Impl
   // needed for batching/rendering
   std::vector<GLfloat> mBatchData;
   std::vector<State> mStateStack{State{}};
-  GLuint mLastUsedTexture = 0;
+  base::static_vector<TextureId, MAX_MULTI_TEXTURES> mBatchTextures;
+  GlStateCache mStateCache;
   GLuint mQuadIndicesEbo = 0;
   std::uint16_t mBatchSize = 0;
   RenderMode mRenderMode = RenderMode::SpriteBatch;
@@ -277,27 +531,44 @@ struct Renderer::Impl
   // warm - needed for committing state changes
   State mLastCommittedState;
   std::unordered_map<TextureId, RenderTarget> mRenderTargetDict;
+  std::vector<PooledRenderTarget> mRenderTargetPool;
   Shader mTexturedQuadShader;
+  Shader mTexturedQuadRepeatShader;
   Shader mSimpleTexturedQuadShader;
+  Shader mMultiTexturedQuadShader;
+  Shader mInstancedQuadShader;
   Shader mSolidColorShader;
   base::Size mWindowSize;
   base::Size mLastKnownWindowSize;
+  base::Clock::time_point mLastWindowResizeTime = {};
   SDL_Window* mpWindow;
   RenderMode mLastKnownRenderMode = RenderMode::SpriteBatch;
+  GLuint mInstancedQuadCornersVbo = 0;
+  bool mUseInstancing;
+  bool mInstancedLayoutActive = false;
 
   // cold
   int mNumTextures = 0;
   int mNumVbos = 0;
   DummyVao mDummyVao;
-  GLuint mStreamVbo = 0;
+  StreamingVertexBuffer mStreamBuffer;
+  GpuFrameTimer mGpuFrameTimer;
+  AsyncReadbackQueue mReadbackQueue;
+  TextureUploadQueue mUploadQueue;
+  FrameStatistics mFrameStatistics;
+  FrameStatistics mLastFrameStatistics;
 
 
   explicit Impl(SDL_Window* pWindow)
     : mTexturedQuadShader(TEXTURED_QUAD_SHADER)
+    , mTexturedQuadRepeatShader(TEXTURED_QUAD_REPEAT_SHADER)
     , mSimpleTexturedQuadShader(SIMPLE_TEXTURED_QUAD_SHADER)
+    , mMultiTexturedQuadShader(MULTI_TEXTURED_QUAD_SHADER)
+    , mInstancedQuadShader(INSTANCED_QUAD_SHADER)
     , mSolidColorShader(SOLID_COLOR_SHADER)
     , mWindowSize(getSize(pWindow))
     , mpWindow(pWindow)
+    , mUseInstancing(optionalGlFeatures().mHasInstancing)
   {
     // General configuration
     glDisable(GL_DEPTH_TEST);
@@ -305,9 +576,7 @@ struct Renderer::Impl
     glEnable(GL_BLEND);
     glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
-    // Set up a VBO for streaming data to the GPU, stays bound all the time
-    glGenBuffers(1, &mStreamVbo);
-    glBindBuffer(GL_ARRAY_BUFFER, mStreamVbo);
+    // The streaming VBO (see mStreamBuffer) stays bound all the time
 
     // Set up an index buffer with enough indices to handle the largest
     // possible batch size. This is only sent to the GPU once, reducing the
@@ -335,26 +604,57 @@ struct Renderer::Impl
       glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
     }
 
-    // All shaders have exactly two vertex attributes
+    // The instanced sprite batch needs a static buffer with the corners of a
+    // quad, in addition to the per-instance data in the streaming buffer
+    if (mUseInstancing)
+    {
+      glGenBuffers(1, &mInstancedQuadCornersVbo);
+      glBindBuffer(GL_ARRAY_BUFFER, mInstancedQuadCornersVbo);
+      glBufferData(
+        GL_ARRAY_BUFFER,
+        sizeof(INSTANCED_QUAD_CORNERS),
+        INSTANCED_QUAD_CORNERS,
+        GL_STATIC_DRAW);
+      glBindBuffer(GL_ARRAY_BUFFER, mStreamBuffer.handle());
+    }
+
+    LOG_F(
+      INFO,
+      "Instanced sprite rendering %s",
+      mUseInstancing ? "enabled" : "not available");
+
+    // All shaders use at least two vertex attributes. The 3rd one is
+    // enabled on demand by applyVertexLayout().
     glEnableVertexAttribArray(0);
     glEnableVertexAttribArray(1);
 
-    glViewport(0, 0, mWindowSize.width, mWindowSize.height);
+    mStateCache.setViewport({{}, mWindowSize});
     commitShaderSelection(mStateStack.back());
     commitTransformationMatrix(mStateStack.back(), mWindowSize);
+
+    mGpuFrameTimer.beginFrame();
   }
 
 
   ~Impl()
   {
+    for (const auto& pooled : mRenderTargetPool)
+    {
+      deleteRenderTarget(pooled.mTexture, pooled.mRenderTarget);
+    }
+
     // Make sure all textures and render targets have been destroyed
     // before the renderer is destroyed.
     assert(mRenderTargetDict.empty());
     assert(mNumTextures == 0);
     assert(mNumVbos == 0);
 
-    glDeleteBuffers(1, &mStreamVbo);
     glDeleteBuffers(1, &mQuadIndicesEbo);
+
+    if (mInstancedQuadCornersVbo)
+    {
+      glDeleteBuffers(1, &mInstancedQuadCornersVbo);
+    }
   }
 
 
@@ -363,14 +663,81 @@ struct Renderer::Impl
     const TexCoords& sourceRect,
     const base::Rect<int>& destRect)
   {
-    updateState(mRenderMode, RenderMode::SpriteBatch);
+    // Multi-texture batching is only implemented for the simple shader.
+    // Color effects and texture repeat are used sparingly enough that
+    // it's not worth it to support them as well.
+    if (mStateStack.back().needsExtendedShader())
+    {
+      drawTextureSingleUnit(texture, sourceRect, destRect);
+    }
+    else
+    {
+      drawTextureMultiUnit(texture, sourceRect, destRect);
+    }
+  }
+
+
+  void drawTextureMultiUnit(
+    const TextureId texture,
+    const TexCoords& sourceRect,
+    const base::Rect<int>& destRect)
+  {
+    updateState(mRenderMode, RenderMode::MultiTextureSpriteBatch);
 
-    if (texture != mLastUsedTexture)
+    if (mBatchSize >= MAX_BATCH_SIZE)
     {
       submitBatch();
+    }
+
+    // Sprites from different textures can be combined into a single batch
+    // by binding each texture to a different texture unit, as long as
+    // we don't need more units than are available.
+    auto iTexture =
+      std::find(mBatchTextures.begin(), mBatchTextures.end(), texture);
+    if (iTexture == mBatchTextures.end())
+    {
+      if (mBatchTextures.size() == MAX_MULTI_TEXTURES)
+      {
+        submitBatch();
+      }
+
+      mBatchTextures.push_back(texture);
+      iTexture = std::prev(mBatchTextures.end());
+    }
+
+    const auto textureIndex =
+      int(std::distance(mBatchTextures.begin(), iTexture));
+
+    if (mUseInstancing)
+    {
+      const auto instance =
+        createQuadInstance(sourceRect, destRect, textureIndex);
+      mBatchData.insert(
+        mBatchData.end(), std::begin(instance), std::end(instance));
+    }
+    else
+    {
+      const auto vertices =
+        createMultiTexturedQuadVertices(sourceRect, destRect, textureIndex);
+      mBatchData.insert(
+        mBatchData.end(), std::begin(vertices), std::end(vertices));
+    }
+
+    mBatchSize += std::uint16_t(std::size(QUAD_INDICES));
+  }
+
+
+  void drawTextureSingleUnit(
+    const TextureId texture,
+    const TexCoords& sourceRect,
+    const base::Rect<int>& destRect)
+  {
+    updateState(mRenderMode, RenderMode::SpriteBatch);
 
-      glBindTexture(GL_TEXTURE_2D, texture);
-      mLastUsedTexture = texture;
+    if (texture != mStateCache.boundTexture(0))
+    {
+      submitBatch();
+      bindTexture(0, texture);
     }
 
     if (mBatchSize >= MAX_BATCH_SIZE)
@@ -394,33 +761,60 @@ struct Renderer::Impl
       return;
     }
 
+    ++mFrameStatistics.mBatches;
+
     switch (mRenderMode)
     {
       case RenderMode::SpriteBatch:
-        glBufferData(
-          GL_ARRAY_BUFFER,
-          sizeof(float) * mBatchData.size(),
-          mBatchData.data(),
-          GL_STREAM_DRAW);
+        uploadStreamingVertices(mBatchData, currentVertexLayout());
 
         glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mQuadIndicesEbo);
-        glDrawElements(GL_TRIANGLES, mBatchSize, GL_UNSIGNED_SHORT, nullptr);
+        drawElements(GL_TRIANGLES, mBatchSize);
         glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
         break;
 
+      case RenderMode::MultiTextureSpriteBatch:
+        bindBatchTextures();
+        uploadStreamingVertices(mBatchData, currentVertexLayout());
+
+        if (mUseInstancing)
+        {
+          drawQuadInstances(
+            GLsizei(mBatchData.size() / FLOATS_PER_QUAD_INSTANCE));
+        }
+        else
+        {
+          glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mQuadIndicesEbo);
+          drawElements(GL_TRIANGLES, mBatchSize);
+          glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+        }
+
+        mBatchTextures.clear();
+        break;
+
       case RenderMode::Points:
-        glBufferData(
-          GL_ARRAY_BUFFER,
-          sizeof(float) * mBatchData.size(),
-          mBatchData.data(),
-          GL_STREAM_DRAW);
-        glDrawArrays(GL_POINTS, 0, GLsizei(mBatchData.size() / 6));
+        uploadStreamingVertices(mBatchData, currentVertexLayout());
+        drawArrays(
+          GL_POINTS,
+          GLsizei(mBatchData.size() / FLOATS_PER_SOLID_COLOR_VERTEX));
+        break;
+
+      case RenderMode::FilledRectangles:
+        uploadStreamingVertices(mBatchData, currentVertexLayout());
+
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mQuadIndicesEbo);
+        drawElements(GL_TRIANGLES, mBatchSize);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+        break;
+
+      case RenderMode::Lines:
+        uploadStreamingVertices(mBatchData, currentVertexLayout());
+        drawArrays(
+          GL_LINES, GLsizei(mBatchData.size() / FLOATS_PER_SOLID_COLOR_VERTEX));
         break;
 
       case RenderMode::CustomDrawing:
-      case RenderMode::NonTexturedRender:
-        // No batching yet for NonTexturedRender, and we aren't meant to ever
-        // see mRenderMode set to CustomDrawing.
+        // We aren't meant to ever see mRenderMode set to CustomDrawing.
         assert(false);
         break;
     }
@@ -430,37 +824,59 @@ struct Renderer::Impl
   }
 
 
+  void bindBatchTextures()
+  {
+    for (auto i = 0u; i < mBatchTextures.size(); ++i)
+    {
+      bindTexture(int(i), mBatchTextures[i]);
+    }
+  }
+
+
+  void bindTexture(const int unit, const TextureId texture)
+  {
+    if (mStateCache.bindTexture(unit, texture))
+    {
+      ++mFrameStatistics.mTextureBinds;
+    }
+  }
+
+
   void
     drawFilledRectangle(const base::Rect<int>& rect, const base::Color& color)
   {
-    // Note: No batching for now
-    updateState(mRenderMode, RenderMode::NonTexturedRender);
-    commitChangedState();
+    updateState(mRenderMode, RenderMode::FilledRectangles);
+
+    if (mBatchSize >= MAX_BATCH_SIZE)
+    {
+      submitBatch();
+    }
 
     const auto left = float(rect.left());
     const auto right = float(rect.right()) + 1.0f;
     const auto top = float(rect.top());
     const auto bottom = float(rect.bottom()) + 1.0f;
 
+    // Vertex order needs to match QUAD_INDICES
     const auto colorVec = toGlColor(color);
-    float vertices[] = {
-      left,  bottom, colorVec.r, colorVec.g, colorVec.b, colorVec.a,
-      right, bottom, colorVec.r, colorVec.g, colorVec.b, colorVec.a,
-      left,  top,    colorVec.r, colorVec.g, colorVec.b, colorVec.a,
-      right, top,    colorVec.r, colorVec.g, colorVec.b, colorVec.a,
-    };
-
-    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STREAM_DRAW);
-    glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+    addSolidColorVertex(left, bottom, colorVec);
+    addSolidColorVertex(left, top, colorVec);
+    addSolidColorVertex(right, bottom, colorVec);
+    addSolidColorVertex(right, top, colorVec);
+    mBatchSize += std::uint16_t(std::size(QUAD_INDICES));
   }
 
 
   void drawRectangle(const base::Rect<int>& rect, const base::Color& color)
   {
-    // Note: No batching for now, drawRectangle is only used for debugging at
-    // the moment
-    updateState(mRenderMode, RenderMode::NonTexturedRender);
-    commitChangedState();
+    updateState(mRenderMode, RenderMode::Lines);
+
+    if (
+      mBatchData.size() + 8 * FLOATS_PER_SOLID_COLOR_VERTEX >
+      MAX_SOLID_COLOR_VERTICES_PER_BATCH * FLOATS_PER_SOLID_COLOR_VERTEX)
+    {
+      submitBatch();
+    }
 
     const auto left = float(rect.left());
     const auto right = float(rect.right());
@@ -468,15 +884,14 @@ struct Renderer::Impl
     const auto bottom = float(rect.bottom());
 
     const auto colorVec = toGlColor(color);
-    float vertices[] = {
-      left,  top,    colorVec.r, colorVec.g, colorVec.b, colorVec.a,
-      left,  bottom, colorVec.r, colorVec.g, colorVec.b, colorVec.a,
-      right, bottom, colorVec.r, colorVec.g, colorVec.b, colorVec.a,
-      right, top,    colorVec.r, colorVec.g, colorVec.b, colorVec.a,
-      left,  top,    colorVec.r, colorVec.g, colorVec.b, colorVec.a};
-
-    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STREAM_DRAW);
-    glDrawArrays(GL_LINE_STRIP, 0, 5);
+    addSolidColorVertex(left, top, colorVec);
+    addSolidColorVertex(left, bottom, colorVec);
+    addSolidColorVertex(left, bottom, colorVec);
+    addSolidColorVertex(right, bottom, colorVec);
+    addSolidColorVertex(right, bottom, colorVec);
+    addSolidColorVertex(right, top, colorVec);
+    addSolidColorVertex(right, top, colorVec);
+    addSolidColorVertex(left, top, colorVec);
   }
 
 
@@ -487,102 +902,168 @@ struct Renderer::Impl
     const int y2,
     const base::Color& color)
   {
-    // Note: No batching for now, drawLine is only used for debugging at the
-    // moment
-    updateState(mRenderMode, RenderMode::NonTexturedRender);
-    commitChangedState();
+    updateState(mRenderMode, RenderMode::Lines);
+
+    if (
+      mBatchData.size() + 2 * FLOATS_PER_SOLID_COLOR_VERTEX >
+      MAX_SOLID_COLOR_VERTICES_PER_BATCH * FLOATS_PER_SOLID_COLOR_VERTEX)
+    {
+      submitBatch();
+    }
 
     const auto colorVec = toGlColor(color);
+    addSolidColorVertex(float(x1), float(y1), colorVec);
+    addSolidColorVertex(float(x2), float(y2), colorVec);
+  }
+
 
-    // clang-format off
-    float vertices[] = {
-      float(x1), float(y1), colorVec.r, colorVec.g, colorVec.b, colorVec.a,
-      float(x2), float(y2), colorVec.r, colorVec.g, colorVec.b, colorVec.a
-    };
-    // clang-format on
+  void drawPoint(const base::Vec2& position, const base::Color& color)
+  {
+    updateState(mRenderMode, RenderMode::Points);
+
+    if (
+      mBatchData.size() >=
+      MAX_SOLID_COLOR_VERTICES_PER_BATCH * FLOATS_PER_SOLID_COLOR_VERTEX)
+    {
+      submitBatch();
+    }
 
-    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STREAM_DRAW);
-    glDrawArrays(GL_LINE_STRIP, 0, 2);
+    addSolidColorVertex(
+      float(position.x), float(position.y), toGlColor(color));
   }
 
 
-  void drawPoint(const base::Vec2& position, const base::Color& color)
+  void drawPoints(
+    const base::ArrayView<base::Vec2> positions,
+    const base::Color& color)
   {
     updateState(mRenderMode, RenderMode::Points);
 
-    float vertices[] = {
-      float(position.x),
-      float(position.y),
-      color.r / 255.0f,
-      color.g / 255.0f,
-      color.b / 255.0f,
-      color.a / 255.0f};
+    const auto colorVec = toGlColor(color);
+    for (const auto& position : positions)
+    {
+      if (
+        mBatchData.size() >=
+        MAX_SOLID_COLOR_VERTICES_PER_BATCH * FLOATS_PER_SOLID_COLOR_VERTEX)
+      {
+        submitBatch();
+      }
+
+      addSolidColorVertex(float(position.x), float(position.y), colorVec);
+    }
+  }
+
+
+  void addSolidColorVertex(const float x, const float y, const glm::vec4& color)
+  {
+    const float vertex[] = {x, y, color.r, color.g, color.b, color.a};
     mBatchData.insert(
-      std::end(mBatchData), std::begin(vertices), std::end(vertices));
+      std::end(mBatchData), std::begin(vertex), std::end(vertex));
   }
 
 
   void drawCustomQuadBatch(const CustomQuadBatchData& batch)
   {
+    // The caller activated the custom shader behind our back in order to
+    // set its uniforms.
+    mStateCache.invalidateProgram();
+
+    if (!mBatchData.empty())
+    {
+      mStateCache.useProgram(shaderToUse(mStateStack.back()).handle());
+    }
+
     submitBatch();
 
     // Trigger committing render state again with the next regular
     // drawing command
     mLastKnownRenderMode = RenderMode::CustomDrawing;
-    mLastUsedTexture = 0;
     mStateChanged = true;
 
-    // Bind textures
+    mStateCache.useProgram(batch.mpShader->handle());
 
-    // We do it in reverse, because that way we end up with unit 0 as
-    // the active texture again after the loop, which is the state we want
-    // after returning from this function.
-    // We could just do another glActiveTexture(GL_TEXTURE0) after the loop
-    // but by doing it this way, we save one GL call.
-    for (auto i = batch.mTextures.size(); i > 0; --i)
+    // Bind textures
+    for (auto i = 0u; i < batch.mTextures.size(); ++i)
     {
-      glActiveTexture(TEXTURE_UNIT_IDS[i - 1]);
-      glBindTexture(GL_TEXTURE_2D, batch.mTextures[i - 1]);
+      bindTexture(int(i), batch.mTextures[i]);
     }
 
 
     // Submit vertex buffer
-    setVertexLayout(batch.mpShader->vertexLayout());
-
-    const auto numQuads =
-      batch.mVertexBuffer.size() / std::tuple_size<QuadVertices>::value;
+    const auto numQuads = batch.mVertexBuffer.size() /
+      floatsPerQuad(batch.mpShader->vertexLayout());
     const auto numIndices = GLsizei(numQuads * std::size(QUAD_INDICES));
     assert(numIndices < GLsizei(MAX_BATCH_SIZE));
 
-    glBufferData(
-      GL_ARRAY_BUFFER,
-      sizeof(float) * batch.mVertexBuffer.size(),
-      batch.mVertexBuffer.data(),
-      GL_STREAM_DRAW);
+    uploadStreamingVertices(
+      batch.mVertexBuffer, batch.mpShader->vertexLayout());
 
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mQuadIndicesEbo);
-    glDrawElements(GL_TRIANGLES, numIndices, GL_UNSIGNED_SHORT, nullptr);
+    drawElements(GL_TRIANGLES, numIndices);
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+
+    ++mFrameStatistics.mBatches;
   }
 
 
-  void submitVertexBuffers(
-    const base::ArrayView<VertexBufferId> buffers,
-    const TextureId texture)
+  void drawCustomPoints(
+    const base::ArrayView<float> vertices,
+    const Shader& shader)
   {
-    updateState(mRenderMode, RenderMode::SpriteBatch);
+    assert(shader.vertexLayout() == VertexLayout::PositionColorAndParameters);
 
-    if (texture != mLastUsedTexture)
-    {
-      submitBatch();
+    // Same as in drawCustomQuadBatch()
+    mStateCache.invalidateProgram();
 
-      glBindTexture(GL_TEXTURE_2D, texture);
-      mLastUsedTexture = texture;
+    if (!mBatchData.empty())
+    {
+      mStateCache.useProgram(shaderToUse(mStateStack.back()).handle());
     }
 
-    commitChangedState();
-
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mQuadIndicesEbo);
+    submitBatch();
+
+    mLastKnownRenderMode = RenderMode::CustomDrawing;
+    mStateChanged = true;
+
+    mStateCache.useProgram(shader.handle());
+
+    // A single upload must fit into the streaming buffer, so very large
+    // point sets are split up into multiple draw calls
+    constexpr auto MAX_FLOATS_PER_DRAW =
+      MAX_SOLID_COLOR_VERTICES_PER_BATCH * FLOATS_PER_PARAMETERIZED_VERTEX;
+
+    for (auto offset = 0u; offset < vertices.size();
+         offset += MAX_FLOATS_PER_DRAW)
+    {
+      const auto count =
+        std::min(vertices.size() - offset, MAX_FLOATS_PER_DRAW);
+
+      uploadStreamingVertices(
+        base::ArrayView<float>{vertices.data() + offset, count},
+        shader.vertexLayout());
+      drawArrays(
+        GL_POINTS, GLsizei(count / FLOATS_PER_PARAMETERIZED_VERTEX));
+    }
+
+    ++mFrameStatistics.mBatches;
+  }
+
+
+  void submitVertexBuffers(
+    const base::ArrayView<VertexBufferId> buffers,
+    const TextureId texture)
+  {
+    updateState(mRenderMode, RenderMode::SpriteBatch);
+
+    if (texture != mStateCache.boundTexture(0))
+    {
+      submitBatch();
+      bindTexture(0, texture);
+    }
+
+    commitChangedState();
+
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mQuadIndicesEbo);
 
     const auto layout = shaderToUse(mStateStack.back()).vertexLayout();
 
@@ -591,14 +1072,114 @@ struct Renderer::Impl
       const auto [vbo, size] = unpackVertexBuffer(buffer);
 
       glBindBuffer(GL_ARRAY_BUFFER, vbo);
-      setVertexLayout(layout);
-      glDrawElements(GL_TRIANGLES, size, GL_UNSIGNED_SHORT, nullptr);
+      applyVertexLayout(layout);
+      drawElements(GL_TRIANGLES, GLsizei(size));
     }
 
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
 
-    glBindBuffer(GL_ARRAY_BUFFER, mStreamVbo);
-    setVertexLayout(layout);
+    glBindBuffer(GL_ARRAY_BUFFER, mStreamBuffer.handle());
+    applyVertexLayout(layout);
+  }
+
+
+  void submitVertexBuffers(
+    const base::ArrayView<VertexBufferId> buffers,
+    const TextureId texture,
+    const Shader& shader)
+  {
+    // Same as in drawCustomQuadBatch()
+    mStateCache.invalidateProgram();
+
+    if (!mBatchData.empty())
+    {
+      mStateCache.useProgram(shaderToUse(mStateStack.back()).handle());
+    }
+
+    submitBatch();
+
+    mLastKnownRenderMode = RenderMode::CustomDrawing;
+    mStateChanged = true;
+
+    mStateCache.useProgram(shader.handle());
+    bindTexture(0, texture);
+
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mQuadIndicesEbo);
+
+    for (const auto buffer : buffers)
+    {
+      const auto [vbo, size] = unpackVertexBuffer(buffer);
+
+      glBindBuffer(GL_ARRAY_BUFFER, vbo);
+      applyVertexLayout(shader.vertexLayout());
+      drawElements(GL_TRIANGLES, GLsizei(size));
+    }
+
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    glBindBuffer(GL_ARRAY_BUFFER, mStreamBuffer.handle());
+
+    ++mFrameStatistics.mBatches;
+  }
+
+
+  void drawElements(const GLenum primitive, const GLsizei numIndices)
+  {
+    glDrawElements(primitive, numIndices, GL_UNSIGNED_SHORT, nullptr);
+    ++mFrameStatistics.mDrawCalls;
+    mFrameStatistics.mVertices += numIndices;
+  }
+
+
+  void drawArrays(const GLenum primitive, const GLsizei numVertices)
+  {
+    glDrawArrays(primitive, 0, numVertices);
+    ++mFrameStatistics.mDrawCalls;
+    mFrameStatistics.mVertices += numVertices;
+  }
+
+
+  void drawQuadInstances(const GLsizei numInstances)
+  {
+    ext::glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, numInstances);
+    ++mFrameStatistics.mDrawCalls;
+    mFrameStatistics.mVertices += numInstances * 4;
+  }
+
+
+  void applyVertexLayout(
+    const VertexLayout layout,
+    const std::uintptr_t baseOffset = 0)
+  {
+    if (layout == VertexLayout::InstancedQuad)
+    {
+      setInstancedQuadLayout(
+        mInstancedQuadCornersVbo, mStreamBuffer.handle(), baseOffset);
+      mInstancedLayoutActive = true;
+      return;
+    }
+
+    if (mInstancedLayoutActive)
+    {
+      resetInstancedQuadLayout();
+      mInstancedLayoutActive = false;
+    }
+
+    setVertexLayout(layout, baseOffset);
+  }
+
+
+  void uploadStreamingVertices(
+    const base::ArrayView<float> vertices,
+    const VertexLayout layout)
+  {
+    const auto offset = mStreamBuffer.upload(vertices);
+    applyVertexLayout(layout, offset);
+  }
+
+
+  VertexLayout currentVertexLayout()
+  {
+    return shaderToUse(mStateStack.back()).vertexLayout();
   }
 
 
@@ -671,6 +1252,14 @@ struct Renderer::Impl
   void setRenderTarget(const TextureId target)
   {
     updateState(mStateStack.back().mRenderTargetTexture, target);
+    updateState(mStateStack.back().mResolutionScale, 1.0f);
+  }
+
+
+  void setResolutionScale(const float scale)
+  {
+    updateState(
+      mStateStack.back().mResolutionScale, std::clamp(scale, 0.0f, 1.0f));
   }
 
   data::Image grabCurrentFramebuffer()
@@ -688,6 +1277,25 @@ struct Renderer::Impl
   }
 
 
+  void grabCurrentFramebufferAsync(AsyncReadbackQueue::Callback callback)
+  {
+    submitBatch();
+
+    mReadbackQueue.start(currentRenderTargetSize(), std::move(callback));
+  }
+
+
+  void copyCurrentFramebufferToTexture(const TextureId texture)
+  {
+    submitBatch();
+
+    const auto size = currentRenderTargetSize();
+    mStateCache.bindTexture(0, texture);
+    glCopyTexSubImage2D(
+      GL_TEXTURE_2D, 0, 0, 0, 0, 0, size.width, size.height);
+  }
+
+
   template <typename StateT>
   void updateState(StateT& state, const StateT& newValue)
   {
@@ -706,12 +1314,35 @@ struct Renderer::Impl
     assert(mStateStack.back().mRenderTargetTexture == 0);
 
     submitBatch();
+    mStreamBuffer.endFrame();
+    mGpuFrameTimer.endFrame();
     SDL_GL_SwapWindow(mpWindow);
 
+    mFrameStatistics.mUploadedVertexBytes +=
+      mStreamBuffer.bytesUploadedLastFrame();
+    mFrameStatistics.mGpuTimeMs = mGpuFrameTimer.lastFrameTimeMs();
+    mFrameStatistics.mAvoidedGlCalls = mStateCache.takeNumAvoidedCalls() +
+      mTexturedQuadShader.takeNumSkippedUpdates() +
+      mTexturedQuadRepeatShader.takeNumSkippedUpdates() +
+      mSimpleTexturedQuadShader.takeNumSkippedUpdates() +
+      mMultiTexturedQuadShader.takeNumSkippedUpdates() +
+      mInstancedQuadShader.takeNumSkippedUpdates() +
+      mSolidColorShader.takeNumSkippedUpdates();
+    mLastFrameStatistics = mFrameStatistics;
+    mFrameStatistics = {};
+
+    mGpuFrameTimer.beginFrame();
+
+    mReadbackQueue.poll();
+
+    mFrameStatistics.mUploadedTextureBytes += mUploadQueue.process(
+      [this](const TextureUploadQueue::Strip& strip) { uploadStrip(strip); });
+
     const auto actualWindowSize = getSize(mpWindow);
     if (mWindowSize != actualWindowSize)
     {
       mWindowSize = actualWindowSize;
+      mLastWindowResizeTime = base::Clock::now();
       mStateChanged = true;
     }
   }
@@ -734,6 +1365,8 @@ struct Renderer::Impl
       return;
     }
 
+    ++mFrameStatistics.mStateChanges;
+
     const auto& state = mStateStack.back();
 
     auto transformNeedsUpdate =
@@ -742,18 +1375,22 @@ struct Renderer::Impl
 
     if (
       mRenderMode != mLastKnownRenderMode ||
-      state.needsExtendedShader() != mLastCommittedState.needsExtendedShader())
+      state.needsExtendedShader() !=
+        mLastCommittedState.needsExtendedShader() ||
+      state.mTextureRepeatEnabled != mLastCommittedState.mTextureRepeatEnabled)
     {
       commitShaderSelection(state);
       transformNeedsUpdate = true;
     }
 
-    if (state.mRenderTargetTexture != mLastCommittedState.mRenderTargetTexture)
+    if (
+      state.mRenderTargetTexture != mLastCommittedState.mRenderTargetTexture ||
+      state.mResolutionScale != mLastCommittedState.mResolutionScale)
     {
       const auto framebufferSize = currentRenderTargetSize();
 
       commitRenderTarget(state);
-      glViewport(0, 0, framebufferSize.width, framebufferSize.height);
+      commitViewport(state, framebufferSize);
       commitClipRect(state, framebufferSize);
       commitVertexAttributeFormat(state);
 
@@ -764,7 +1401,7 @@ struct Renderer::Impl
       if (
         mWindowSize != mLastKnownWindowSize && state.mRenderTargetTexture == 0)
       {
-        glViewport(0, 0, mWindowSize.width, mWindowSize.height);
+        commitViewport(state, mWindowSize);
         commitClipRect(state, mWindowSize);
         transformNeedsUpdate = true;
       }
@@ -776,24 +1413,18 @@ struct Renderer::Impl
 
     if (mRenderMode == RenderMode::SpriteBatch && state.needsExtendedShader())
     {
+      auto& shader = shaderToUse(state);
+
       if (state.mColorModulation != mLastCommittedState.mColorModulation)
       {
-        mTexturedQuadShader.setUniform(
-          "colorModulation", toGlColor(state.mColorModulation));
+        shader.setUniform(
+          UNIFORM_COLOR_MODULATION, toGlColor(state.mColorModulation));
       }
 
       if (state.mOverlayColor != mLastCommittedState.mOverlayColor)
       {
-        mTexturedQuadShader.setUniform(
-          "overlayColor", toGlColor(state.mOverlayColor));
-      }
-
-      if (
-        state.mTextureRepeatEnabled !=
-        mLastCommittedState.mTextureRepeatEnabled)
-      {
-        mTexturedQuadShader.setUniform(
-          "enableRepeat", state.mTextureRepeatEnabled);
+        shader.setUniform(
+          UNIFORM_OVERLAY_COLOR, toGlColor(state.mOverlayColor));
       }
     }
 
@@ -811,29 +1442,42 @@ struct Renderer::Impl
 
   void commitRenderTarget(const State& state)
   {
+    auto framebuffer = GLuint{0};
+
     if (state.mRenderTargetTexture != 0)
     {
       const auto iData = mRenderTargetDict.find(state.mRenderTargetTexture);
       assert(iData != mRenderTargetDict.end());
-      glBindFramebuffer(GL_FRAMEBUFFER, iData->second.mFbo);
+      framebuffer = iData->second.mFbo;
     }
-    else
+
+    if (mStateCache.bindFramebuffer(framebuffer))
     {
-      glBindFramebuffer(GL_FRAMEBUFFER, 0);
+      ++mFrameStatistics.mRenderTargetSwitches;
     }
   }
 
 
+  void commitViewport(const State& state, const base::Size& framebufferSize)
+  {
+    mStateCache.setViewport(scaleGlBox(
+      {{}, framebufferSize}, framebufferSize, state.mResolutionScale));
+  }
+
+
   void commitClipRect(const State& state, const base::Size& framebufferSize)
   {
     if (state.mClipRect)
     {
-      glEnable(GL_SCISSOR_TEST);
-      setScissorBox(*state.mClipRect, framebufferSize);
+      mStateCache.setScissorTestEnabled(true);
+      mStateCache.setScissorBox(scaleGlBox(
+        toGlScissorBox(*state.mClipRect, framebufferSize),
+        framebufferSize,
+        state.mResolutionScale));
     }
     else
     {
-      glDisable(GL_SCISSOR_TEST);
+      mStateCache.setScissorTestEnabled(false);
     }
   }
 
@@ -845,13 +1489,19 @@ struct Renderer::Impl
       case RenderMode::SpriteBatch:
         if (state.needsExtendedShader())
         {
-          return mTexturedQuadShader;
+          return state.mTextureRepeatEnabled ? mTexturedQuadRepeatShader
+                                             : mTexturedQuadShader;
         }
 
         return mSimpleTexturedQuadShader;
 
+      case RenderMode::MultiTextureSpriteBatch:
+        return mUseInstancing ? mInstancedQuadShader
+                              : mMultiTexturedQuadShader;
+
       case RenderMode::Points:
-      case RenderMode::NonTexturedRender:
+      case RenderMode::FilledRectangles:
+      case RenderMode::Lines:
         return mSolidColorShader;
 
       default:
@@ -865,24 +1515,22 @@ struct Renderer::Impl
 
   void commitVertexAttributeFormat(const State& state)
   {
-    setVertexLayout(shaderToUse(state).vertexLayout());
+    applyVertexLayout(shaderToUse(state).vertexLayout());
   }
 
 
   void commitShaderSelection(const State& state)
   {
     auto& shader = shaderToUse(state);
-    shader.use();
-    setVertexLayout(shader.vertexLayout());
+    mStateCache.useProgram(shader.handle());
+    applyVertexLayout(shader.vertexLayout());
 
-    if (shader.handle() == mTexturedQuadShader.handle())
+    if (
+      &shader == &mTexturedQuadShader || &shader == &mTexturedQuadRepeatShader)
     {
-      mTexturedQuadShader.setUniform(
-        "enableRepeat", state.mTextureRepeatEnabled);
-      mTexturedQuadShader.setUniform(
-        "colorModulation", toGlColor(state.mColorModulation));
-      mTexturedQuadShader.setUniform(
-        "overlayColor", toGlColor(state.mOverlayColor));
+      shader.setUniform(
+        UNIFORM_COLOR_MODULATION, toGlColor(state.mColorModulation));
+      shader.setUniform(UNIFORM_OVERLAY_COLOR, toGlColor(state.mOverlayColor));
     }
   }
 
@@ -893,26 +1541,44 @@ struct Renderer::Impl
   {
     const auto projectionMatrix = computeTransformationMatrix(
       state.mGlobalTranslation, state.mGlobalScale, framebufferSize);
-    shaderToUse(state).setUniform("transform", projectionMatrix);
+    shaderToUse(state).setUniform(UNIFORM_TRANSFORM, projectionMatrix);
   }
 
 
-  VertexBufferId createVertexBuffer(const base::ArrayView<float> vertices)
+  VertexBufferId createVertexBuffer(
+    const base::ArrayView<float> vertices,
+    const std::size_t floatsPerQuad)
+  {
+    return createVertexBuffer(
+      vertices.data(),
+      sizeof(float) * vertices.size(),
+      vertices.size() / floatsPerQuad);
+  }
+
+
+  VertexBufferId
+    createCompactVertexBuffer(const base::ArrayView<CompactVertex> vertices)
+  {
+    return createVertexBuffer(
+      vertices.data(),
+      sizeof(CompactVertex) * vertices.size(),
+      vertices.size() / std::tuple_size<CompactQuadVertices>::value);
+  }
+
+
+  VertexBufferId createVertexBuffer(
+    const void* pData,
+    const std::size_t sizeInBytes,
+    const std::size_t numQuads)
   {
     GLuint vbo = 0;
     glGenBuffers(1, &vbo);
 
     glBindBuffer(GL_ARRAY_BUFFER, vbo);
-    glBufferData(
-      GL_ARRAY_BUFFER,
-      sizeof(float) * vertices.size(),
-      vertices.data(),
-      GL_STATIC_DRAW);
-    glBindBuffer(GL_ARRAY_BUFFER, mStreamVbo);
+    glBufferData(GL_ARRAY_BUFFER, sizeInBytes, pData, GL_STATIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, mStreamBuffer.handle());
 
-    const auto size = uint16_t(
-      vertices.size() / std::tuple_size<renderer::QuadVertices>::value *
-      std::size(QUAD_INDICES));
+    const auto size = uint16_t(numQuads * std::size(QUAD_INDICES));
 
     ++mNumVbos;
 
@@ -920,6 +1586,24 @@ struct Renderer::Impl
   }
 
 
+  void updateVertexBuffer(
+    const VertexBufferId buffer,
+    const std::size_t offsetInBytes,
+    const void* pData,
+    const std::size_t sizeInBytes)
+  {
+    assert(buffer != INVALID_VERTEX_BUFFER_ID);
+
+    const auto [vbo, _] = unpackVertexBuffer(buffer);
+
+    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+    glBufferSubData(GL_ARRAY_BUFFER, offsetInBytes, sizeInBytes, pData);
+    glBindBuffer(GL_ARRAY_BUFFER, mStreamBuffer.handle());
+
+    mFrameStatistics.mUploadedVertexBytes += sizeInBytes;
+  }
+
+
   void destroyVertexBuffer(const VertexBufferId buffer)
   {
     assert(buffer != INVALID_VERTEX_BUFFER_ID);
@@ -935,16 +1619,35 @@ struct Renderer::Impl
   {
     submitBatch();
 
+    const auto iPooled = std::find_if(
+      mRenderTargetPool.begin(),
+      mRenderTargetPool.end(),
+      [&](const PooledRenderTarget& pooled) {
+        return pooled.mRenderTarget.mSize == base::Size{width, height};
+      });
+
+    if (iPooled != mRenderTargetPool.end())
+    {
+      const auto pooled = *iPooled;
+      mRenderTargetPool.erase(iPooled);
+
+      // Filtering and repeat might have been changed by the previous owner
+      mStateCache.bindTexture(0, pooled.mTexture);
+      setDefaultTextureParameters();
+
+      mRenderTargetDict.insert({pooled.mTexture, pooled.mRenderTarget});
+      return pooled.mTexture;
+    }
+
     const auto textureHandle =
-      createGlTexture(GLsizei(width), GLsizei(height), nullptr);
+      createGlTexture(mStateCache, GLsizei(width), GLsizei(height), nullptr);
 
     GLuint fboHandle;
     glGenFramebuffers(1, &fboHandle);
-    glBindFramebuffer(GL_FRAMEBUFFER, fboHandle);
+    mStateCache.bindFramebuffer(fboHandle);
     glFramebufferTexture2D(
       GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, textureHandle, 0);
 
-    glBindTexture(GL_TEXTURE_2D, mLastUsedTexture);
     commitRenderTarget(mLastCommittedState);
 
     mRenderTargetDict.insert({textureHandle, {{width, height}, fboHandle}});
@@ -955,41 +1658,131 @@ struct Renderer::Impl
 
   TextureId createTexture(const data::Image& image)
   {
-    submitBatch();
-
     // OpenGL wants pixel data in bottom-up format, so we need to flip the
     // image
-    const auto flippedImage = image.flipped();
+    return createTextureFromFlippedImage(image.flipped());
+  }
+
+
+  TextureId createTexture(data::Image&& image)
+  {
+    auto ownedImage = std::move(image);
+    ownedImage.flipVertically();
+    return createTextureFromFlippedImage(ownedImage);
+  }
+
+
+  TextureId createTextureFromFlippedImage(const data::Image& flippedImage)
+  {
+    submitBatch();
 
     const auto handle = createGlTexture(
+      mStateCache,
       GLsizei(flippedImage.width()),
       GLsizei(flippedImage.height()),
       flippedImage.pixelData().data());
-    glBindTexture(GL_TEXTURE_2D, mLastUsedTexture);
 
     ++mNumTextures;
     return handle;
   }
 
 
+  TextureId createTextureDeferred(
+    data::Image&& image,
+    TextureUploadQueue::ReadyCallback onReady)
+  {
+    submitBatch();
+
+    auto ownedImage = std::move(image);
+    ownedImage.flipVertically();
+
+    const auto handle = createGlTexture(
+      mStateCache,
+      GLsizei(ownedImage.width()),
+      GLsizei(ownedImage.height()),
+      nullptr);
+    ++mNumTextures;
+
+    mUploadQueue.enqueue(handle, std::move(ownedImage), std::move(onReady));
+    return handle;
+  }
+
+
+  void finishTextureUpload(const TextureId texture)
+  {
+    if (!mUploadQueue.isPending(texture))
+    {
+      return;
+    }
+
+    submitBatch();
+
+    mFrameStatistics.mUploadedTextureBytes += mUploadQueue.finish(
+      texture,
+      [this](const TextureUploadQueue::Strip& strip) { uploadStrip(strip); });
+  }
+
+
+  void uploadStrip(const TextureUploadQueue::Strip& strip)
+  {
+    mStateCache.bindTexture(0, strip.mTexture);
+    glTexSubImage2D(
+      GL_TEXTURE_2D,
+      0,
+      0,
+      strip.mFirstRow,
+      strip.mWidth,
+      strip.mNumRows,
+      GL_RGBA,
+      GL_UNSIGNED_BYTE,
+      strip.mpPixels);
+  }
+
+
   TextureId
     createMonoTexture(int width, int height, base::ArrayView<std::uint8_t> data)
   {
     submitBatch();
 
     const auto handle = createGlTexture(
+      mStateCache,
       GLsizei(width),
       GLsizei(height),
       data.data(),
       MONO_TEXTURE_INTERNAL_FORMAT,
       MONO_TEXTURE_FORMAT);
-    glBindTexture(GL_TEXTURE_2D, mLastUsedTexture);
 
     ++mNumTextures;
     return handle;
   }
 
 
+  void updateTexture(
+    const TextureId texture,
+    const int textureHeight,
+    const base::Vec2& position,
+    const data::Image& image)
+  {
+    submitBatch();
+
+    const auto flippedImage = image.flipped();
+    const auto width = GLsizei(flippedImage.width());
+    const auto height = GLsizei(flippedImage.height());
+
+    mStateCache.bindTexture(0, texture);
+    glTexSubImage2D(
+      GL_TEXTURE_2D,
+      0,
+      position.x,
+      textureHeight - position.y - height,
+      width,
+      height,
+      GL_RGBA,
+      GL_UNSIGNED_BYTE,
+      flippedImage.pixelData().data());
+  }
+
+
   void destroyTexture(TextureId texture)
   {
     submitBatch();
@@ -997,15 +1790,38 @@ struct Renderer::Impl
     const auto iRenderTarget = mRenderTargetDict.find(texture);
     if (iRenderTarget != mRenderTargetDict.end())
     {
-      glDeleteFramebuffers(1, &iRenderTarget->second.mFbo);
+      if (mRenderTargetPool.size() == MAX_POOLED_RENDER_TARGETS)
+      {
+        const auto& oldest = mRenderTargetPool.front();
+        deleteRenderTarget(oldest.mTexture, oldest.mRenderTarget);
+        mRenderTargetPool.erase(mRenderTargetPool.begin());
+      }
+
+      mRenderTargetPool.push_back({texture, iRenderTarget->second});
       mRenderTargetDict.erase(iRenderTarget);
+      return;
     }
-    else
-    {
-      --mNumTextures;
-    }
 
+    --mNumTextures;
+
+    mUploadQueue.cancel(texture);
+    glDeleteTextures(1, &texture);
+    mStateCache.forgetTexture(texture);
+  }
+
+
+  void deleteRenderTarget(TextureId texture, const RenderTarget& renderTarget)
+  {
+    glDeleteFramebuffers(1, &renderTarget.mFbo);
     glDeleteTextures(1, &texture);
+    mStateCache.forgetTexture(texture);
+  }
+
+
+  bool isWindowResizing() const
+  {
+    return base::Clock::now() - mLastWindowResizeTime <
+      WINDOW_RESIZE_SETTLE_TIME;
   }
 
 
@@ -1013,7 +1829,7 @@ struct Renderer::Impl
   {
     submitBatch();
 
-    glBindTexture(GL_TEXTURE_2D, texture);
+    mStateCache.bindTexture(0, texture);
 
     if (enabled)
     {
@@ -1025,15 +1841,13 @@ struct Renderer::Impl
       glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
       glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
     }
-
-    glBindTexture(GL_TEXTURE_2D, mLastUsedTexture);
   }
 
   void setNativeRepeatEnabled(TextureId texture, bool enabled)
   {
     submitBatch();
 
-    glBindTexture(GL_TEXTURE_2D, texture);
+    mStateCache.bindTexture(0, texture);
 
     if (enabled)
     {
@@ -1045,8 +1859,6 @@ struct Renderer::Impl
       glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
       glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
     }
-
-    glBindTexture(GL_TEXTURE_2D, mLastUsedTexture);
   }
 
   base::Size currentRenderTargetSize() const
@@ -1070,24 +1882,51 @@ Renderer::Renderer(SDL_Window* pWindow)
 }
 
 
+Renderer::Renderer(const base::Size& headlessWindowSize)
+  : mHeadlessWindowSize(headlessWindowSize)
+{
+}
+
+
 Renderer::~Renderer() = default;
 
 
+void Renderer::assertOnContextThread() const
+{
+  assert(!mpImpl || std::this_thread::get_id() == mContextThread);
+}
+
+
 void Renderer::setOverlayColor(const base::Color& color)
 {
-  mpImpl->setOverlayColor(color);
+  assertOnContextThread();
+
+  if (mpImpl)
+  {
+    mpImpl->setOverlayColor(color);
+  }
 }
 
 
 void Renderer::setColorModulation(const base::Color& colorModulation)
 {
-  mpImpl->setColorModulation(colorModulation);
+  assertOnContextThread();
+
+  if (mpImpl)
+  {
+    mpImpl->setColorModulation(colorModulation);
+  }
 }
 
 
 void Renderer::setTextureRepeatEnabled(const bool enable)
 {
-  mpImpl->setTextureRepeatEnabled(enable);
+  assertOnContextThread();
+
+  if (mpImpl)
+  {
+    mpImpl->setTextureRepeatEnabled(enable);
+  }
 }
 
 
@@ -1096,13 +1935,23 @@ void Renderer::drawTexture(
   const TexCoords& sourceRect,
   const base::Rect<int>& destRect)
 {
-  mpImpl->drawTexture(texture, sourceRect, destRect);
+  assertOnContextThread();
+
+  if (mpImpl)
+  {
+    mpImpl->drawTexture(texture, sourceRect, destRect);
+  }
 }
 
 
 void Renderer::submitBatch()
 {
-  mpImpl->submitBatch();
+  assertOnContextThread();
+
+  if (mpImpl)
+  {
+    mpImpl->submitBatch();
+  }
 }
 
 
@@ -1110,7 +1959,12 @@ void Renderer::drawFilledRectangle(
   const base::Rect<int>& rect,
   const base::Color& color)
 {
-  mpImpl->drawFilledRectangle(rect, color);
+  assertOnContextThread();
+
+  if (mpImpl)
+  {
+    mpImpl->drawFilledRectangle(rect, color);
+  }
 }
 
 
@@ -1118,7 +1972,12 @@ void Renderer::drawRectangle(
   const base::Rect<int>& rect,
   const base::Color& color)
 {
-  mpImpl->drawRectangle(rect, color);
+  assertOnContextThread();
+
+  if (mpImpl)
+  {
+    mpImpl->drawRectangle(rect, color);
+  }
 }
 
 
@@ -1129,19 +1988,60 @@ void Renderer::drawLine(
   const int y2,
   const base::Color& color)
 {
-  mpImpl->drawLine(x1, y1, x2, y2, color);
+  assertOnContextThread();
+
+  if (mpImpl)
+  {
+    mpImpl->drawLine(x1, y1, x2, y2, color);
+  }
 }
 
 
 void Renderer::drawPoint(const base::Vec2& position, const base::Color& color)
 {
-  mpImpl->drawPoint(position, color);
+  assertOnContextThread();
+
+  if (mpImpl)
+  {
+    mpImpl->drawPoint(position, color);
+  }
+}
+
+
+void Renderer::drawPoints(
+  const base::ArrayView<base::Vec2> positions,
+  const base::Color& color)
+{
+  assertOnContextThread();
+
+  if (mpImpl)
+  {
+    mpImpl->drawPoints(positions, color);
+  }
 }
 
 
 void Renderer::drawCustomQuadBatch(const CustomQuadBatchData& batch)
 {
-  mpImpl->drawCustomQuadBatch(batch);
+  assertOnContextThread();
+
+  if (mpImpl)
+  {
+    mpImpl->drawCustomQuadBatch(batch);
+  }
+}
+
+
+void Renderer::drawCustomPoints(
+  const base::ArrayView<float> vertices,
+  const Shader& shader)
+{
+  assertOnContextThread();
+
+  if (mpImpl)
+  {
+    mpImpl->drawCustomPoints(vertices, shader);
+  }
 }
 
 
@@ -1149,36 +2049,80 @@ void Renderer::submitVertexBuffers(
   const base::ArrayView<VertexBufferId> buffers,
   const TextureId texture)
 {
-  mpImpl->submitVertexBuffers(buffers, texture);
+  assertOnContextThread();
+
+  if (mpImpl)
+  {
+    mpImpl->submitVertexBuffers(buffers, texture);
+  }
+}
+
+
+void Renderer::submitVertexBuffers(
+  const base::ArrayView<VertexBufferId> buffers,
+  const TextureId texture,
+  const Shader& shader)
+{
+  assertOnContextThread();
+
+  if (mpImpl)
+  {
+    mpImpl->submitVertexBuffers(buffers, texture, shader);
+  }
 }
 
 
 void Renderer::pushState()
 {
-  mpImpl->pushState();
+  assertOnContextThread();
+
+  if (mpImpl)
+  {
+    mpImpl->pushState();
+  }
 }
 
 
 void Renderer::popState()
 {
-  mpImpl->popState();
+  assertOnContextThread();
+
+  if (mpImpl)
+  {
+    mpImpl->popState();
+  }
 }
 
 
 void Renderer::resetState()
 {
-  mpImpl->resetState();
+  assertOnContextThread();
+
+  if (mpImpl)
+  {
+    mpImpl->resetState();
+  }
 }
 
 
 void Renderer::setGlobalTranslation(const base::Vec2& translation)
 {
-  mpImpl->setGlobalTranslation(translation);
+  assertOnContextThread();
+
+  if (mpImpl)
+  {
+    mpImpl->setGlobalTranslation(translation);
+  }
 }
 
 
 base::Vec2 Renderer::globalTranslation() const
 {
+  if (!mpImpl)
+  {
+    return {};
+  }
+
   return base::Vec2{
     static_cast<int>(mpImpl->mStateStack.back().mGlobalTranslation.x),
     static_cast<int>(mpImpl->mStateStack.back().mGlobalTranslation.y)};
@@ -1187,12 +2131,22 @@ base::Vec2 Renderer::globalTranslation() const
 
 void Renderer::setGlobalScale(const base::Vec2f& scale)
 {
-  mpImpl->setGlobalScale(scale);
+  assertOnContextThread();
+
+  if (mpImpl)
+  {
+    mpImpl->setGlobalScale(scale);
+  }
 }
 
 
 base::Vec2f Renderer::globalScale() const
 {
+  if (!mpImpl)
+  {
+    return {1.0f, 1.0f};
+  }
+
   return {
     mpImpl->mStateStack.back().mGlobalScale.x,
     mpImpl->mStateStack.back().mGlobalScale.y};
@@ -1201,102 +2155,391 @@ base::Vec2f Renderer::globalScale() const
 
 void Renderer::setClipRect(const std::optional<base::Rect<int>>& clipRect)
 {
-  mpImpl->setClipRect(clipRect);
+  assertOnContextThread();
+
+  if (mpImpl)
+  {
+    mpImpl->setClipRect(clipRect);
+  }
 }
 
 
 std::optional<base::Rect<int>> Renderer::clipRect() const
 {
+  if (!mpImpl)
+  {
+    return std::nullopt;
+  }
+
   return mpImpl->mStateStack.back().mClipRect;
 }
 
 
 base::Size Renderer::currentRenderTargetSize() const
 {
+  if (!mpImpl)
+  {
+    return mHeadlessWindowSize;
+  }
+
   return mpImpl->currentRenderTargetSize();
 }
 
 
 base::Size Renderer::windowSize() const
 {
+  if (!mpImpl)
+  {
+    return mHeadlessWindowSize;
+  }
+
   return mpImpl->mWindowSize;
 }
 
 
+bool Renderer::isWindowResizing() const
+{
+  return mpImpl && mpImpl->isWindowResizing();
+}
+
+
+const FrameStatistics& Renderer::lastFrameStatistics() const
+{
+  if (!mpImpl)
+  {
+    static const auto EMPTY_STATISTICS = FrameStatistics{};
+    return EMPTY_STATISTICS;
+  }
+
+  return mpImpl->mLastFrameStatistics;
+}
+
+
 void Renderer::setRenderTarget(const TextureId target)
 {
-  mpImpl->setRenderTarget(target);
+  assertOnContextThread();
+
+  if (mpImpl)
+  {
+    mpImpl->setRenderTarget(target);
+  }
+}
+
+
+void Renderer::setResolutionScale(const float scale)
+{
+  assertOnContextThread();
+
+  if (mpImpl)
+  {
+    mpImpl->setResolutionScale(scale);
+  }
+}
+
+
+float Renderer::resolutionScale() const
+{
+  if (!mpImpl)
+  {
+    return 1.0f;
+  }
+
+  return mpImpl->mStateStack.back().mResolutionScale;
 }
 
 
 data::Image Renderer::grabCurrentFramebuffer()
 {
+  assertOnContextThread();
+
+  if (!mpImpl)
+  {
+    return data::Image{
+      std::size_t(mHeadlessWindowSize.width),
+      std::size_t(mHeadlessWindowSize.height)};
+  }
+
   return mpImpl->grabCurrentFramebuffer();
 }
 
 
+void Renderer::grabCurrentFramebufferAsync(
+  std::function<void(data::Image)> callback)
+{
+  assertOnContextThread();
+
+  if (!mpImpl)
+  {
+    callback(grabCurrentFramebuffer());
+    return;
+  }
+
+  mpImpl->grabCurrentFramebufferAsync(std::move(callback));
+}
+
+
+void Renderer::copyCurrentFramebufferToTexture(const TextureId texture)
+{
+  assertOnContextThread();
+
+  if (mpImpl)
+  {
+    mpImpl->copyCurrentFramebufferToTexture(texture);
+  }
+}
+
+
 void Renderer::swapBuffers()
 {
-  mpImpl->swapBuffers();
+  assertOnContextThread();
+
+  if (mpImpl)
+  {
+    mpImpl->swapBuffers();
+  }
 }
 
 
 void Renderer::clear(const base::Color& clearColor)
 {
-  mpImpl->clear(clearColor);
+  assertOnContextThread();
+
+  if (mpImpl)
+  {
+    mpImpl->clear(clearColor);
+  }
 }
 
 
-VertexBufferId
-  Renderer::createVertexBuffer(const base::ArrayView<float> vertices)
+VertexBufferId Renderer::createVertexBuffer(
+  const base::ArrayView<float> vertices,
+  const std::size_t floatsPerQuad)
 {
-  return mpImpl->createVertexBuffer(vertices);
+  assertOnContextThread();
+
+  if (!mpImpl)
+  {
+    return ++mNextHeadlessHandle;
+  }
+
+  return mpImpl->createVertexBuffer(vertices, floatsPerQuad);
 }
 
 
 void Renderer::destroyVertexBuffer(const VertexBufferId buffer)
 {
-  mpImpl->destroyVertexBuffer(buffer);
+  assertOnContextThread();
+
+  if (mpImpl)
+  {
+    mpImpl->destroyVertexBuffer(buffer);
+  }
+}
+
+
+void Renderer::updateVertexBuffer(
+  const VertexBufferId buffer,
+  const std::size_t offset,
+  const base::ArrayView<float> vertices)
+{
+  assertOnContextThread();
+
+  if (mpImpl)
+  {
+    mpImpl->updateVertexBuffer(
+      buffer,
+      sizeof(float) * offset,
+      vertices.data(),
+      sizeof(float) * vertices.size());
+  }
+}
+
+
+VertexBufferId
+  Renderer::createCompactVertexBuffer(base::ArrayView<CompactVertex> vertices)
+{
+  assertOnContextThread();
+
+  if (!mpImpl)
+  {
+    return ++mNextHeadlessHandle;
+  }
+
+  return mpImpl->createCompactVertexBuffer(vertices);
+}
+
+
+void Renderer::updateCompactVertexBuffer(
+  const VertexBufferId buffer,
+  const std::size_t offset,
+  const base::ArrayView<CompactVertex> vertices)
+{
+  assertOnContextThread();
+
+  if (mpImpl)
+  {
+    mpImpl->updateVertexBuffer(
+      buffer,
+      sizeof(CompactVertex) * offset,
+      vertices.data(),
+      sizeof(CompactVertex) * vertices.size());
+  }
 }
 
 
 TextureId Renderer::createRenderTargetTexture(const int width, const int height)
 {
+  assertOnContextThread();
+
+  if (!mpImpl)
+  {
+    return TextureId(++mNextHeadlessHandle);
+  }
+
   return mpImpl->createRenderTargetTexture(width, height);
 }
 
 
 TextureId Renderer::createTexture(const data::Image& image)
 {
+  assertOnContextThread();
+
+  if (!mpImpl)
+  {
+    return TextureId(++mNextHeadlessHandle);
+  }
+
   return mpImpl->createTexture(image);
 }
 
 
+TextureId Renderer::createTexture(data::Image&& image)
+{
+  assertOnContextThread();
+
+  if (!mpImpl)
+  {
+    [[maybe_unused]] const auto discarded = std::move(image);
+    return TextureId(++mNextHeadlessHandle);
+  }
+
+  return mpImpl->createTexture(std::move(image));
+}
+
+
+TextureId Renderer::createTextureDeferred(
+  data::Image&& image,
+  std::function<void(TextureId)> onReady)
+{
+  assertOnContextThread();
+
+  if (!mpImpl)
+  {
+    [[maybe_unused]] const auto discarded = std::move(image);
+    const auto handle = TextureId(++mNextHeadlessHandle);
+
+    if (onReady)
+    {
+      onReady(handle);
+    }
+
+    return handle;
+  }
+
+  return mpImpl->createTextureDeferred(std::move(image), std::move(onReady));
+}
+
+
+void Renderer::finishTextureUpload(const TextureId texture)
+{
+  assertOnContextThread();
+
+  if (mpImpl)
+  {
+    mpImpl->finishTextureUpload(texture);
+  }
+}
+
+
+bool Renderer::isTextureUploadPending(const TextureId texture) const
+{
+  return mpImpl && mpImpl->mUploadQueue.isPending(texture);
+}
+
+
+void Renderer::setTextureUploadBudget(const std::size_t bytesPerFrame)
+{
+  assertOnContextThread();
+
+  if (mpImpl)
+  {
+    mpImpl->mUploadQueue.setBytesPerFrame(bytesPerFrame);
+  }
+}
+
+
 TextureId Renderer::createMonoTexture(
   int width,
   int height,
   base::ArrayView<std::uint8_t> data)
 {
+  assertOnContextThread();
+
+  if (!mpImpl)
+  {
+    return TextureId(++mNextHeadlessHandle);
+  }
+
   return mpImpl->createMonoTexture(width, height, data);
 }
 
 
+void Renderer::updateTexture(
+  const TextureId texture,
+  const int textureHeight,
+  const base::Vec2& position,
+  const data::Image& image)
+{
+  assertOnContextThread();
+
+  if (mpImpl)
+  {
+    mpImpl->updateTexture(texture, textureHeight, position, image);
+  }
+}
+
+
 void Renderer::destroyTexture(TextureId texture)
 {
-  mpImpl->destroyTexture(texture);
+  assertOnContextThread();
+
+  if (mpImpl)
+  {
+    mpImpl->destroyTexture(texture);
+  }
 }
 
 
 void Renderer::setFilteringEnabled(const TextureId texture, const bool enabled)
 {
-  mpImpl->setFilteringEnabled(texture, enabled);
+  assertOnContextThread();
+
+  if (mpImpl)
+  {
+    mpImpl->setFilteringEnabled(texture, enabled);
+  }
 }
 
 void Renderer::setNativeRepeatEnabled(
   const TextureId texture,
   const bool enabled)
 {
-  mpImpl->setNativeRepeatEnabled(texture, enabled);
+  assertOnContextThread();
+
+  if (mpImpl)
+  {
+    mpImpl->setNativeRepeatEnabled(texture, enabled);
+  }
 }
 
 } // namespace rigel::renderer
@@ -27,9 +27,12 @@ RIGEL_DISABLE_WARNINGS
 #include <SDL_video.h>
 RIGEL_RESTORE_WARNINGS
 
+#include <cstddef>
 #include <cstdint>
+#include <functional>
 #include <memory>
 #include <optional>
+#include <thread>
 
 
 namespace rigel::renderer
@@ -40,6 +43,59 @@ using VertexBufferId = std::uint64_t;
 constexpr auto INVALID_VERTEX_BUFFER_ID = VertexBufferId(0);
 
 
+/** Per-frame counters describing the work done by the renderer
+ *
+ * All values cover the time between two calls to Renderer::swapBuffers().
+ */
+struct FrameStatistics
+{
+  /** Number of glDraw* calls issued */
+  int mDrawCalls = 0;
+
+  /** Number of (implicit or custom) batches submitted */
+  int mBatches = 0;
+
+  /** How often changed render state had to be applied to the GL */
+  int mStateChanges = 0;
+
+  /** Vertices submitted for drawing (indices, for indexed draw calls) */
+  int mVertices = 0;
+
+  /** Texture bindings done for drawing */
+  int mTextureBinds = 0;
+
+  /** How often the framebuffer binding changed */
+  int mRenderTargetSwitches = 0;
+
+  /** GL calls skipped because the state already had the requested value
+   *
+   * Includes uniform updates for the renderer's built-in shaders.
+   */
+  int mAvoidedGlCalls = 0;
+
+  /** Vertex data streamed to the GPU
+   *
+   * Static vertex buffers created via createVertexBuffer() are not
+   * included, but updates done via updateVertexBuffer() are.
+   */
+  std::size_t mUploadedVertexBytes = 0;
+
+  /** Pixel data uploaded by the time-sliced texture upload queue
+   *
+   * Only covers textures created via createTextureDeferred().
+   */
+  std::size_t mUploadedTextureBytes = 0;
+
+  /** GPU time spent on the frame, in milliseconds
+   *
+   * Only available if the OpenGL implementation supports timer queries.
+   * The value lags behind by a frame or two, since the renderer doesn't
+   * wait for query results to become available.
+   */
+  std::optional<float> mGpuTimeMs;
+};
+
+
 /** OpenGL-based 2D rendering API
  *
  * This class provides hardware-accelerated 2D rendering capabilities
@@ -50,14 +106,26 @@ constexpr auto INVALID_VERTEX_BUFFER_ID = VertexBufferId(0);
  * (scaling, translation), and a few color effects are also available.
  *
  * A valid OpenGL context must be created before instantiating this
- * class.
+ * class, unless it's created in headless mode.
  */
 class Renderer
 {
 public:
   explicit Renderer(SDL_Window* pWindow);
+
+  /** Create a renderer that doesn't require a window or GL context
+   *
+   * All drawing operations are ignored, and resource creation hands out
+   * placeholder IDs. State queries return default values, and
+   * framebuffer grabs return a blank image. This allows running
+   * code which depends on a Renderer, e.g. the game logic, in automated
+   * tests or simulations without a display.
+   */
+  explicit Renderer(const base::Size& headlessWindowSize);
   ~Renderer();
 
+  bool isHeadless() const { return mpImpl == nullptr; }
+
   // Drawing API
   ////////////////////////////////////////////////////////////////////////
 
@@ -100,16 +168,45 @@ public:
    */
   void drawPoint(const base::Vec2& position, const base::Color& color);
 
+  /** Draw many points of the same color
+   *
+   * Equivalent to calling drawPoint() for each position, but avoids the
+   * per-point overhead.
+   */
+  void drawPoints(
+    base::ArrayView<base::Vec2> positions,
+    const base::Color& color);
+
   void drawCustomQuadBatch(const CustomQuadBatchData& batch);
 
+  /** Draw points using a custom shader
+   *
+   * The shader must use VertexLayout::PositionColorAndParameters. Like
+   * with drawCustomQuadBatch(), the caller is responsible for setting the
+   * shader's uniforms, including the transformation matrix.
+   */
+  void drawCustomPoints(base::ArrayView<float> vertices, const Shader& shader);
+
   void submitVertexBuffers(
     base::ArrayView<VertexBufferId> buffers,
     TextureId texture);
 
+  /** Draw static vertex buffers using a custom shader
+   *
+   * The buffers' vertex data must match the shader's vertex layout. Like
+   * with drawCustomQuadBatch(), the caller is responsible for setting the
+   * shader's uniforms, including the transformation matrix.
+   */
+  void submitVertexBuffers(
+    base::ArrayView<VertexBufferId> buffers,
+    TextureId texture,
+    const Shader& shader);
+
   /** Draw rectangle outline, 1 pixel wide
    *
-   * _Warning_: Does not support batching, use sparingly or only for
-   * debugging.
+   * Supports batching: Consecutive calls to this function or drawLine()
+   * are combined into a single OpenGL draw call.
+   * Changing any state will interrupt the current batch.
    *
    * Rectangle coordinates are modified by the current global scale
    * and translation.
@@ -119,8 +216,9 @@ public:
 
   /** Draw filled rectangle
    *
-   * _Warning_: Does not support batching, use sparingly or only for
-   * debugging.
+   * Supports batching: Consecutive calls to this function are combined
+   * into a single OpenGL draw call.
+   * Changing any state will interrupt the current batch.
    *
    * Rectangle coordinates are modified by the current global scale
    * and translation.
@@ -131,8 +229,9 @@ public:
 
   /** Draw line, 1 pixel wide
    *
-   * _Warning_: Does not support batching, use sparingly or only for
-   * debugging.
+   * Supports batching: Consecutive calls to this function or
+   * drawRectangle() are combined into a single OpenGL draw call.
+   * Changing any state will interrupt the current batch.
    *
    * Coordinates are modified by the current global scale and
    * translation.
@@ -176,9 +275,42 @@ public:
   // Resource management API
   ////////////////////////////////////////////////////////////////////////
 
-  VertexBufferId createVertexBuffer(base::ArrayView<float> vertices);
+  /** Create a static vertex buffer holding quads
+   *
+   * By default, the vertex data is expected to be in the format produced by
+   * createTexturedQuadVertices(). Buffers meant for use with a custom shader
+   * can have a different format, as long as the number of floats per quad
+   * is given.
+   */
+  VertexBufferId createVertexBuffer(
+    base::ArrayView<float> vertices,
+    std::size_t floatsPerQuad = std::tuple_size<QuadVertices>::value);
   void destroyVertexBuffer(const VertexBufferId buffer);
 
+  /** Overwrite part of an existing vertex buffer
+   *
+   * The offset is given in number of floats. The range to update must lie
+   * within the buffer's original size, buffers can't grow.
+   */
+  void updateVertexBuffer(
+    VertexBufferId buffer,
+    std::size_t offset,
+    base::ArrayView<float> vertices);
+
+  /** Like createVertexBuffer(), but for vertices in the compact format
+   *
+   * Meant for use with a shader using
+   * VertexLayout::CompactPositionTexCoordsAndAnimation. Buffers created this
+   * way need to be updated via updateCompactVertexBuffer(), where the offset
+   * is given in number of vertices.
+   */
+  VertexBufferId createCompactVertexBuffer(
+    base::ArrayView<CompactVertex> vertices);
+  void updateCompactVertexBuffer(
+    VertexBufferId buffer,
+    std::size_t offset,
+    base::ArrayView<CompactVertex> vertices);
+
   /** Create a texture
    *
    * This is a low-level API. Using the renderer::Texture class instead
@@ -193,6 +325,43 @@ public:
    */
   TextureId createTexture(const data::Image& image);
 
+  /** Like createTexture(const data::Image&), but consumes the image
+   *
+   * Avoids making a temporary copy of the pixel data for the upload, and
+   * frees the image's memory right after uploading.
+   */
+  TextureId createTexture(data::Image&& image);
+
+  /** Like createTexture(data::Image&&), but uploads over multiple frames
+   *
+   * The texture's storage is allocated right away, but the pixel data is
+   * uploaded in strips from within subsequent calls to swapBuffers(),
+   * limited by the budget set via setTextureUploadBudget(). The callback
+   * is invoked once the upload is complete. Until then, the texture's
+   * contents are partially undefined, so it shouldn't be drawn yet - use
+   * finishTextureUpload() in case it's needed earlier than expected.
+   *
+   * Destroying the texture while the upload is still pending cancels the
+   * upload, without invoking the callback. In headless mode, the callback
+   * is invoked immediately.
+   */
+  TextureId createTextureDeferred(
+    data::Image&& image,
+    std::function<void(TextureId)> onReady = {});
+
+  /** Upload any remaining data for a deferred texture right away
+   *
+   * Does nothing if the texture isn't pending, so it's cheap to call
+   * this defensively before drawing a texture created via
+   * createTextureDeferred().
+   */
+  void finishTextureUpload(TextureId texture);
+
+  bool isTextureUploadPending(TextureId texture) const;
+
+  /** Set how many bytes of deferred texture data to upload per frame */
+  void setTextureUploadBudget(std::size_t bytesPerFrame);
+
   /** Create a render target texture
    *
    * This is a low-level API. Using the renderer::RenderTarget class
@@ -200,6 +369,10 @@ public:
    *
    * Like createTexture, but the resulting texture can be bound as a
    * render target using setRenderTarget().
+   *
+   * Destroyed render targets are kept in a small pool, and handed out again
+   * when a render target of the same size is requested. The initial
+   * contents of a render target are therefore undefined.
    */
   TextureId createRenderTargetTexture(int width, int height);
 
@@ -208,6 +381,21 @@ public:
     int height,
     base::ArrayView<std::uint8_t> data);
 
+  /** Replace part of a texture's contents
+   *
+   * This is a low-level API. Using Texture::updatePixels() instead is
+   * recommended for most use cases.
+   *
+   * Uploads the given image into the texture created via createTexture(),
+   * with its top-left corner at the given position. Since textures are
+   * stored bottom-up, the texture's height must be provided as well.
+   */
+  void updateTexture(
+    TextureId texture,
+    int textureHeight,
+    const base::Vec2& position,
+    const data::Image& image);
+
   /** Destroy a previously created texture or render target
    *
    * This is a low-level API. Using the Texture and RenderTarget classes
@@ -363,18 +551,81 @@ public:
    */
   void setRenderTarget(TextureId target);
 
+  /** Render at a fraction of the current render target's resolution
+   *
+   * Part of the renderer state, reset to 1.0 by setRenderTarget().
+   * Coordinates, clip rects etc. keep referring to the render target's
+   * full size, but only the top-left region given by scaledRenderSize() is
+   * actually rasterized to. The result can then be stretched back to full
+   * size when drawing the render target. Lowering the scale thus reduces
+   * GPU load proportionally, without any changes to the drawing code.
+   */
+  void setResolutionScale(float scale);
+  float resolutionScale() const;
+
+  /** Read back the contents of the current render target
+   *
+   * _Warning_: This waits for the GPU to finish all pending rendering,
+   * prefer grabCurrentFramebufferAsync() where possible.
+   */
   data::Image grabCurrentFramebuffer();
 
+  /** Read back the contents of the current render target asynchronously
+   *
+   * Captures the render target's current contents without waiting for the
+   * GPU. The callback is invoked from within a later call to swapBuffers(),
+   * usually one or two frames later, once the data is available. On
+   * OpenGL ES, it's invoked immediately.
+   * If the renderer is destroyed before that, the callback is never
+   * invoked.
+   */
+  void grabCurrentFramebufferAsync(std::function<void(data::Image)> callback);
+
+  /** Copy the contents of the current render target into a texture
+   *
+   * The copy happens on the GPU, without any readback. The texture must be
+   * at least as large as the current render target.
+   */
+  void copyCurrentFramebufferToTexture(TextureId texture);
+
   base::Size currentRenderTargetSize() const;
   base::Size windowSize() const;
 
+  /** True if the window size has changed very recently
+   *
+   * Stays true for a short while after each size change, so that code which
+   * needs to recreate resources for a new window size can wait until the
+   * user has finished resizing the window.
+   */
+  bool isWindowResizing() const;
+
   base::Vec2 globalTranslation() const;
   base::Vec2f globalScale() const;
   std::optional<base::Rect<int>> clipRect() const;
 
+  // Statistics
+  ////////////////////////////////////////////////////////////////////////
+
+  /** Counters for the last completed frame
+   *
+   * Updated on each call to swapBuffers().
+   */
+  const FrameStatistics& lastFrameStatistics() const;
+
 private:
+  /** Debug check: All GL work must happen on the thread owning the context
+   *
+   * A headless renderer doesn't do any GL work, so it can be used from any
+   * thread.
+   */
+  void assertOnContextThread() const;
+
   struct Impl;
   std::unique_ptr<Impl> mpImpl;
+
+  base::Size mHeadlessWindowSize;
+  std::uint32_t mNextHeadlessHandle = 0;
+  std::thread::id mContextThread = std::this_thread::get_id();
 };
 
 /** RAII helper for temporarily saving state
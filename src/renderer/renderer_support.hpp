@@ -19,6 +19,8 @@
 #include "base/array_view.hpp"
 #include "base/spatial_types.hpp"
 
+#include <algorithm>
+#include <array>
 #include <cstdint>
 
 
@@ -56,6 +58,19 @@ struct TexCoords
  * coordinates, like e.g. "from 8,8 to 32,64". This helper function
  * converts from the latter to the former.
  */
+/** Size of the region rendered to at the given resolution scale
+ *
+ * See Renderer::setResolutionScale().
+ */
+inline base::Size
+  scaledRenderSize(const base::Size& fullSize, const float resolutionScale)
+{
+  return {
+    std::max(1, int(fullSize.width * resolutionScale + 0.5f)),
+    std::max(1, int(fullSize.height * resolutionScale + 0.5f))};
+}
+
+
 inline TexCoords toTexCoords(
   const base::Rect<int>& sourceRect,
   const int texWidth,
@@ -75,6 +90,36 @@ inline TexCoords toTexCoords(
 // 4 * (x, y, u, v)
 using QuadVertices = std::array<float, 4 * (2 + 2)>;
 
+// 4 * (x, y, u, v, texture index)
+using MultiTexturedQuadVertices = std::array<float, 4 * (2 + 2 + 1)>;
+
+// x, y, width, height, left, top, right, bottom, texture index
+using QuadInstance = std::array<float, 4 + 4 + 1>;
+
+
+/** Vertex format for static buffers with pixel-aligned quads
+ *
+ * Takes up 12 bytes instead of the 20 needed for MultiTexturedQuadVertices.
+ * Positions are integers, texture coordinates are normalized to the full
+ * range of 16 bits, and the parameter is passed to the shader as is.
+ */
+struct CompactVertex
+{
+  std::int16_t x;
+  std::int16_t y;
+  std::uint16_t u;
+  std::uint16_t v;
+  std::uint16_t parameter;
+
+  // Keeps each vertex 4-byte aligned, which some GPUs need for good
+  // performance
+  std::uint16_t padding;
+};
+
+static_assert(sizeof(CompactVertex) == 12);
+
+using CompactQuadVertices = std::array<CompactVertex, 4>;
+
 
 struct CustomQuadBatchData
 {
@@ -16,7 +16,17 @@
 
 #include "shader.hpp"
 
+#include "assets/asset_cache.hpp"
+#include "assets/file_utils.hpp"
+
+RIGEL_DISABLE_WARNINGS
+#include <loguru.hpp>
+RIGEL_RESTORE_WARNINGS
+
+#include <algorithm>
+#include <cstdio>
 #include <memory>
+#include <optional>
 #include <stdexcept>
 #include <string>
 
@@ -27,6 +37,10 @@ namespace rigel::renderer
 namespace
 {
 
+// Only set if enableProgramBinaryCache() was called, and the driver supports
+// program binaries
+std::optional<assets::AssetCache> gProgramBinaryCache;
+
 #ifdef RIGEL_USE_GL_ES
 
 const auto SHADER_PREAMBLE = R"shd(
@@ -127,6 +141,180 @@ auto useTemporarily(const GLuint shaderHandle)
   return base::defer([currentProgram]() { glUseProgram(currentProgram); });
 }
 
+
+void compileAndLink(
+  const GLuint program,
+  const std::string& vertexSource,
+  const std::string& fragmentSource,
+  const VertexLayout vertexLayout)
+{
+  auto vertexShader = compileShader(vertexSource, GL_VERTEX_SHADER);
+  auto fragmentShader = compileShader(fragmentSource, GL_FRAGMENT_SHADER);
+
+  glAttachShader(program, vertexShader.mHandle);
+  glAttachShader(program, fragmentShader.mHandle);
+
+  switch (vertexLayout)
+  {
+    case VertexLayout::PositionAndTexCoords:
+      glBindAttribLocation(program, 0, "position");
+      glBindAttribLocation(program, 1, "texCoord");
+      break;
+
+    case VertexLayout::PositionAndColor:
+      glBindAttribLocation(program, 0, "position");
+      glBindAttribLocation(program, 1, "color");
+      break;
+
+    case VertexLayout::PositionTexCoordsAndTextureIndex:
+      glBindAttribLocation(program, 0, "position");
+      glBindAttribLocation(program, 1, "texCoord");
+      glBindAttribLocation(program, 2, "textureIndex");
+      break;
+
+    case VertexLayout::PositionTexCoordsAndAnimation:
+    case VertexLayout::CompactPositionTexCoordsAndAnimation:
+      glBindAttribLocation(program, 0, "position");
+      glBindAttribLocation(program, 1, "texCoord");
+      glBindAttribLocation(program, 2, "animation");
+      break;
+
+    case VertexLayout::PositionTexCoordsAndEffect:
+      glBindAttribLocation(program, 0, "position");
+      glBindAttribLocation(program, 1, "texCoord");
+      glBindAttribLocation(program, 2, "effect");
+      break;
+
+    case VertexLayout::PositionColorAndParameters:
+      glBindAttribLocation(program, 0, "position");
+      glBindAttribLocation(program, 1, "color");
+      glBindAttribLocation(program, 2, "parameters");
+      break;
+
+    case VertexLayout::InstancedQuad:
+      glBindAttribLocation(program, 0, "corner");
+      glBindAttribLocation(program, 1, "destRect");
+      glBindAttribLocation(program, 2, "texRect");
+      glBindAttribLocation(program, 3, "textureIndex");
+      break;
+  }
+
+#ifndef RIGEL_USE_GL_ES
+  if (gProgramBinaryCache && ext::glProgramParameteri)
+  {
+    ext::glProgramParameteri(
+      program, ext::GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+  }
+#endif
+
+  glLinkProgram(program);
+
+  GLint linkStatus = 0;
+  glGetProgramiv(program, GL_LINK_STATUS, &linkStatus);
+  if (!linkStatus)
+  {
+    GLint infoLogSize = 0;
+    glGetProgramiv(program, GL_INFO_LOG_LENGTH, &infoLogSize);
+
+    if (infoLogSize > 0)
+    {
+      std::unique_ptr<char[]> infoLogBuffer(new char[infoLogSize]);
+      glGetProgramInfoLog(program, infoLogSize, nullptr, infoLogBuffer.get());
+
+      throw std::runtime_error(
+        std::string{"Shader program linking failed:\n\n"} +
+        infoLogBuffer.get());
+    }
+    else
+    {
+      throw std::runtime_error(
+        "Shader program linking failed, but could not get info log");
+    }
+  }
+}
+
+
+std::string programCacheEntryName(
+  const std::string& vertexSource,
+  const std::string& fragmentSource,
+  const VertexLayout vertexLayout)
+{
+  // Attribute locations are part of the program binary, and these are
+  // determined by the vertex layout
+  const auto hash = assets::CacheKeyHasher{}
+                      .add(vertexSource)
+                      .add(fragmentSource)
+                      .add(std::uint64_t(vertexLayout))
+                      .value();
+
+  std::array<char, 17> name{};
+  std::snprintf(
+    name.data(), name.size(), "%016llx", static_cast<unsigned long long>(hash));
+  return std::string{"program_"} + name.data();
+}
+
+
+bool loadCachedProgram(const GLuint program, const std::string& entryName)
+{
+  if (!gProgramBinaryCache)
+  {
+    return false;
+  }
+
+  const auto maybeEntry = gProgramBinaryCache->load(entryName);
+  if (!maybeEntry || maybeEntry->data().size() <= sizeof(std::uint32_t))
+  {
+    return false;
+  }
+
+  auto reader = assets::LeStreamReader{maybeEntry->data()};
+  const auto format = GLenum(reader.readU32());
+  const auto binary = maybeEntry->data().subView(sizeof(std::uint32_t));
+
+  ext::glProgramBinary(program, format, binary.data(), GLsizei(binary.size()));
+
+  // Drivers are allowed to reject binaries at any time, e.g. after an
+  // update. The program can then still be linked from source as usual.
+  GLint linkStatus = 0;
+  glGetProgramiv(program, GL_LINK_STATUS, &linkStatus);
+  if (!linkStatus)
+  {
+    LOG_F(INFO, "Cached shader program '%s' rejected", entryName.c_str());
+  }
+
+  return linkStatus != 0;
+}
+
+
+void storeCachedProgram(const GLuint program, const std::string& entryName)
+{
+  if (!gProgramBinaryCache)
+  {
+    return;
+  }
+
+  GLint length = 0;
+  glGetProgramiv(program, ext::GL_PROGRAM_BINARY_LENGTH, &length);
+  if (length <= 0)
+  {
+    return;
+  }
+
+  auto binary = assets::ByteBuffer(std::size_t(length));
+  auto actualLength = GLsizei{0};
+  auto format = GLenum{0};
+  ext::glGetProgramBinary(
+    program, length, &actualLength, &format, binary.data());
+  binary.resize(std::size_t(std::max(actualLength, 0)));
+
+  assets::LeStreamWriter writer;
+  writer.writeU32(std::uint32_t(format));
+
+  auto payload = writer.buffer();
+  payload.insert(payload.end(), binary.begin(), binary.end());
+  gProgramBinaryCache->store(entryName, payload);
+}
+
 } // namespace
 
 
@@ -144,55 +332,85 @@ glm::mat4 computeTransformationMatrix(
 }
 
 
+void enableProgramBinaryCache(const std::filesystem::path& directory)
+{
+  if (!optionalGlFeatures().mHasProgramBinary)
+  {
+    LOG_F(INFO, "Program binaries not supported, not caching shaders");
+    return;
+  }
+
+  auto glString = [](const GLenum name) {
+    const auto pString = reinterpret_cast<const char*>(glGetString(name));
+    return std::string_view{pString ? pString : ""};
+  };
+
+  const auto driverKey = assets::CacheKeyHasher{}
+                           .add(glString(GL_VENDOR))
+                           .add(glString(GL_RENDERER))
+                           .add(glString(GL_VERSION))
+                           .value();
+  gProgramBinaryCache.emplace(directory, driverKey);
+}
+
+
 Shader::Shader(const ShaderSpec& spec)
   : mProgram(glCreateProgram(), glDeleteProgram)
   , mVertexLayout(spec.mVertexLayout)
 {
-  auto vertexShader = compileShader(
-    std::string{SHADER_PREAMBLE} + spec.mVertexSource, GL_VERTEX_SHADER);
-  auto fragmentShader = compileShader(
-    std::string{SHADER_PREAMBLE} + spec.mFragmentSource, GL_FRAGMENT_SHADER);
-
-  glAttachShader(mProgram.mHandle, vertexShader.mHandle);
-  glAttachShader(mProgram.mHandle, fragmentShader.mHandle);
+  const auto preamble = std::string{SHADER_PREAMBLE} + spec.mDefines + '\n';
+  const auto vertexSource = preamble + spec.mVertexSource;
+  const auto fragmentSource = preamble + spec.mFragmentSource;
 
-  switch (spec.mVertexLayout)
+  const auto cacheEntryName =
+    programCacheEntryName(vertexSource, fragmentSource, spec.mVertexLayout);
+  if (!loadCachedProgram(mProgram.mHandle, cacheEntryName))
   {
-    case VertexLayout::PositionAndTexCoords:
-      glBindAttribLocation(mProgram.mHandle, 0, "position");
-      glBindAttribLocation(mProgram.mHandle, 1, "texCoord");
-      break;
-
-    case VertexLayout::PositionAndColor:
-      glBindAttribLocation(mProgram.mHandle, 0, "position");
-      glBindAttribLocation(mProgram.mHandle, 1, "color");
-      break;
+    compileAndLink(
+      mProgram.mHandle, vertexSource, fragmentSource, spec.mVertexLayout);
+    storeCachedProgram(mProgram.mHandle, cacheEntryName);
   }
 
-  glLinkProgram(mProgram.mHandle);
+  // Resolve all uniform locations up front, so that setting uniforms later
+  // doesn't require any string handling
+  GLint numUniforms = 0;
+  glGetProgramiv(mProgram.mHandle, GL_ACTIVE_UNIFORMS, &numUniforms);
+  mUniforms.reserve(std::size_t(numUniforms));
 
-  GLint linkStatus = 0;
-  glGetProgramiv(mProgram.mHandle, GL_LINK_STATUS, &linkStatus);
-  if (!linkStatus)
+  for (auto i = 0; i < numUniforms; ++i)
   {
-    GLint infoLogSize = 0;
-    glGetProgramiv(mProgram.mHandle, GL_INFO_LOG_LENGTH, &infoLogSize);
-
-    if (infoLogSize > 0)
+    std::array<char, 256> nameBuffer{};
+    GLsizei nameLength = 0;
+    GLint size = 0;
+    GLenum type = 0;
+    glGetActiveUniform(
+      mProgram.mHandle,
+      GLuint(i),
+      GLsizei(nameBuffer.size()),
+      &nameLength,
+      &size,
+      &type,
+      nameBuffer.data());
+
+    auto name = std::string_view{nameBuffer.data(), std::size_t(nameLength)};
+
+    // Array uniforms are reported as "name[0]", but we want to address
+    // them using just their name
+    if (name.size() > 3 && name.substr(name.size() - 3) == "[0]")
     {
-      std::unique_ptr<char[]> infoLogBuffer(new char[infoLogSize]);
-      glGetProgramInfoLog(
-        mProgram.mHandle, infoLogSize, nullptr, infoLogBuffer.get());
-
-      throw std::runtime_error(
-        std::string{"Shader program linking failed:\n\n"} +
-        infoLogBuffer.get());
+      name.remove_suffix(3);
     }
-    else
+
+    const auto id = UniformId{name};
+    if (findSlot(id))
     {
       throw std::runtime_error(
-        "Shader program linking failed, but could not get info log");
+        "Shader uniform name hash collision: " + std::string{name});
     }
+
+    const auto location =
+      glGetUniformLocation(mProgram.mHandle, std::string{name}.c_str());
+    mUniforms.push_back(UniformSlot{{}, id, location});
   }
 
   // Bind texture sampler names to texture units
@@ -205,27 +423,47 @@ Shader::Shader(const ShaderSpec& spec)
 }
 
 
-void Shader::use() const
+Shader::Shader(const VertexLayout vertexLayout)
+  : mVertexLayout(vertexLayout)
 {
-  glUseProgram(mProgram.mHandle);
 }
 
 
-GLint Shader::location(const std::string& name) const
+Shader Shader::createInert(const ShaderSpec& spec)
 {
-  auto it = mLocationCache.find(name);
-  if (it == mLocationCache.end())
+  return Shader{spec.mVertexLayout};
+}
+
+
+void Shader::use() const
+{
+  if (mProgram.mHandle)
   {
-    const auto location = glGetUniformLocation(mProgram.mHandle, name.c_str());
-    std::tie(it, std::ignore) = mLocationCache.emplace(name, location);
+    glUseProgram(mProgram.mHandle);
   }
+}
 
-  return it->second;
+
+Shader::UniformSlot* Shader::findSlot(const UniformId id) const
+{
+  // There are only a handful of uniforms per shader, so a linear search
+  // is faster than any kind of map
+  const auto it = std::find_if(
+    mUniforms.begin(), mUniforms.end(), [&](const UniformSlot& slot) {
+      return slot.mId == id;
+    });
+
+  return it != mUniforms.end() ? &*it : nullptr;
 }
 
 
 base::ScopeGuard useTemporarily(const Shader& shader)
 {
+  if (!shader.handle())
+  {
+    return base::defer([]() {});
+  }
+
   return useTemporarily(shader.handle());
 }
 
@@ -27,10 +27,15 @@ RIGEL_DISABLE_WARNINGS
 #include <glm/mat4x4.hpp>
 RIGEL_RESTORE_WARNINGS
 
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
 #include <functional>
 #include <initializer_list>
-#include <string>
-#include <unordered_map>
+#include <string_view>
+#include <utility>
+#include <vector>
 
 
 namespace rigel::renderer
@@ -58,7 +63,13 @@ public:
     other.mHandle = 0;
   }
 
-  ~GlHandleWrapper() { mDeleteFunc(mHandle); }
+  ~GlHandleWrapper()
+  {
+    if (mDeleteFunc)
+    {
+      mDeleteFunc(mHandle);
+    }
+  }
 
   GlHandleWrapper& operator=(const GlHandleWrapper&) = delete;
 
@@ -72,7 +83,23 @@ private:
 enum class VertexLayout
 {
   PositionAndTexCoords,
-  PositionAndColor
+  PositionAndColor,
+  PositionTexCoordsAndTextureIndex,
+  InstancedQuad,
+
+  // Same memory layout as PositionTexCoordsAndTextureIndex, the 3rd
+  // attribute is called "animation" or "effect" instead
+  PositionTexCoordsAndAnimation,
+  PositionTexCoordsAndEffect,
+
+  // Position, color and a 3rd vec3 attribute called "parameters", whose
+  // meaning is up to the shader. Used for drawing points.
+  PositionColorAndParameters,
+
+  // Same attributes as PositionTexCoordsAndAnimation, but stored as
+  // CompactVertex. Only for static vertex buffers created via
+  // Renderer::createCompactVertexBuffer().
+  CompactPositionTexCoordsAndAnimation
 };
 
 
@@ -82,9 +109,29 @@ struct ShaderSpec
   base::ArrayView<const char*> mTextureUnitNames;
   const char* mVertexSource;
   const char* mFragmentSource;
+
+  // Preprocessor definitions inserted in front of both sources. This allows
+  // compiling specialized variants from the same source code, instead of
+  // branching on uniforms at runtime.
+  const char* mDefines = "";
 };
 
 
+/** Keep linked shader programs on disk, to skip compiling them on startup
+ *
+ * Once enabled, Shader stores the binary of each program it links in the
+ * given directory, and loads it from there on the next run instead of
+ * compiling the sources again. Binaries are specific to the GL driver that
+ * produced them, so the cache is keyed by the driver's vendor, renderer and
+ * version strings. If the driver rejects a cached binary anyway, the program
+ * is compiled from source and the cache entry replaced.
+ *
+ * Does nothing if the driver doesn't support program binaries (see
+ * OptionalGlFeatures::mHasProgramBinary). Requires a current GL context.
+ */
+void enableProgramBinaryCache(const std::filesystem::path& directory);
+
+
 glm::mat4 computeTransformationMatrix(
   const glm::vec2& translation,
   const glm::vec2& scale,
@@ -115,77 +162,209 @@ inline glm::mat4 computeTransformationMatrix(
 }
 
 
+/** Compile-time identifier for a shader uniform
+ *
+ * Wraps a hash of the uniform's name. When constructed from a string
+ * literal in a constexpr context, no hashing happens at runtime, which
+ * makes setting uniforms via UniformId as cheap as using a raw location.
+ * Shader checks for hash collisions among its uniforms on construction.
+ */
+class UniformId
+{
+public:
+  constexpr UniformId(const char* name)
+    : UniformId(std::string_view{name})
+  {
+  }
+
+  constexpr explicit UniformId(const std::string_view name)
+    : mHash(hashName(name))
+  {
+  }
+
+  constexpr std::uint32_t hash() const { return mHash; }
+
+  constexpr bool operator==(const UniformId& other) const
+  {
+    return mHash == other.mHash;
+  }
+
+  constexpr bool operator!=(const UniformId& other) const
+  {
+    return !(*this == other);
+  }
+
+private:
+  // 32-bit FNV-1a
+  static constexpr std::uint32_t hashName(const std::string_view name)
+  {
+    auto hash = std::uint32_t{2166136261u};
+    for (const auto c : name)
+    {
+      hash ^= std::uint32_t(static_cast<unsigned char>(c));
+      hash *= std::uint32_t{16777619u};
+    }
+
+    return hash;
+  }
+
+  std::uint32_t mHash;
+};
+
+
 class Shader
 {
 public:
   Shader(const ShaderSpec& spec);
 
+  /** Create a shader without an underlying GL program
+   *
+   * All operations on the resulting shader do nothing. This is meant for
+   * use with a headless Renderer, where no GL context is available.
+   */
+  static Shader createInert(const ShaderSpec& spec);
+
   void use() const;
 
-  void setUniform(const std::string& name, const glm::mat4& matrix) const
+  // All setUniform() variants skip the GL call if the uniform already has
+  // the given value. This requires that uniforms are only ever modified
+  // via this class. Setting a uniform that doesn't exist in the shader (or
+  // was optimized out by the driver) does nothing.
+
+  void setUniform(const UniformId id, const glm::mat4& matrix) const
+  {
+    setIfChanged(id, matrix, [&](const GLint location) {
+      glUniformMatrix4fv(location, 1, GL_FALSE, glm::value_ptr(matrix));
+    });
+  }
+
+  void setUniform(const UniformId id, const glm::vec2& vec2) const
   {
-    glUniformMatrix4fv(location(name), 1, GL_FALSE, glm::value_ptr(matrix));
+    setIfChanged(id, vec2, [&](const GLint location) {
+      glUniform2fv(location, 1, glm::value_ptr(vec2));
+    });
   }
 
-  void setUniform(const std::string& name, const glm::vec2& vec2) const
+  void setUniform(const UniformId id, const glm::vec3& vec3) const
   {
-    glUniform2fv(location(name), 1, glm::value_ptr(vec2));
+    setIfChanged(id, vec3, [&](const GLint location) {
+      glUniform3fv(location, 1, glm::value_ptr(vec3));
+    });
   }
 
-  void setUniform(const std::string& name, const glm::vec3& vec3) const
+  void setUniform(const UniformId id, const glm::vec4& vec4) const
   {
-    glUniform3fv(location(name), 1, glm::value_ptr(vec3));
+    setIfChanged(id, vec4, [&](const GLint location) {
+      glUniform4fv(location, 1, glm::value_ptr(vec4));
+    });
   }
 
-  void setUniform(const std::string& name, const glm::vec4& vec4) const
+  template <std::size_t N>
+  void setUniform(const UniformId id, const std::array<float, N>& values) const
   {
-    glUniform4fv(location(name), 1, glm::value_ptr(vec4));
+    setIfChanged(id, values, [&](const GLint location) {
+      glUniform1fv(location, N, values.data());
+    });
   }
 
   template <std::size_t N>
   void setUniform(
-    const std::string& name,
+    const UniformId id,
     const std::array<glm::vec2, N>& values) const
   {
-    glUniform3fv(location(name), N, glm::value_ptr(values.front()));
+    setIfChanged(id, values, [&](const GLint location) {
+      glUniform2fv(location, N, glm::value_ptr(values.front()));
+    });
   }
 
   template <std::size_t N>
   void setUniform(
-    const std::string& name,
+    const UniformId id,
     const std::array<glm::vec3, N>& values) const
   {
-    glUniform3fv(location(name), N, glm::value_ptr(values.front()));
+    setIfChanged(id, values, [&](const GLint location) {
+      glUniform3fv(location, N, glm::value_ptr(values.front()));
+    });
   }
 
   template <std::size_t N>
   void setUniform(
-    const std::string& name,
+    const UniformId id,
     const std::array<glm::vec4, N>& values) const
   {
-    glUniform3fv(location(name), N, glm::value_ptr(values.front()));
+    setIfChanged(id, values, [&](const GLint location) {
+      glUniform4fv(location, N, glm::value_ptr(values.front()));
+    });
   }
 
-  void setUniform(const std::string& name, const int value) const
+  void setUniform(const UniformId id, const int value) const
   {
-    glUniform1i(location(name), value);
+    setIfChanged(
+      id, value, [&](const GLint location) { glUniform1i(location, value); });
   }
 
-  void setUniform(const std::string& name, const float value) const
+  void setUniform(const UniformId id, const float value) const
   {
-    glUniform1f(location(name), value);
+    setIfChanged(
+      id, value, [&](const GLint location) { glUniform1f(location, value); });
   }
 
   GLuint handle() const { return mProgram.mHandle; }
   VertexLayout vertexLayout() const { return mVertexLayout; }
 
+  /** Number of setUniform() calls skipped since the last call */
+  int takeNumSkippedUpdates() const
+  {
+    return std::exchange(mNumSkippedUpdates, 0);
+  }
+
 private:
-  GLint location(const std::string& name) const;
+  struct UniformSlot
+  {
+    static constexpr auto CACHE_SIZE = sizeof(glm::mat4);
+
+    std::array<std::uint8_t, CACHE_SIZE> mCachedValue;
+    UniformId mId;
+    GLint mLocation;
+    bool mHasCachedValue = false;
+  };
+
+  explicit Shader(VertexLayout vertexLayout);
+
+  UniformSlot* findSlot(UniformId id) const;
+
+  template <typename T, typename SetFunc>
+  void setIfChanged(const UniformId id, const T& value, SetFunc&& set) const
+  {
+    const auto pSlot = findSlot(id);
+    if (!pSlot)
+    {
+      return;
+    }
+
+    // Values too large for the cache are always sent
+    if constexpr (sizeof(T) <= UniformSlot::CACHE_SIZE)
+    {
+      if (
+        pSlot->mHasCachedValue &&
+        std::memcmp(pSlot->mCachedValue.data(), &value, sizeof(T)) == 0)
+      {
+        ++mNumSkippedUpdates;
+        return;
+      }
+
+      std::memcpy(pSlot->mCachedValue.data(), &value, sizeof(T));
+      pSlot->mHasCachedValue = true;
+    }
+
+    set(pSlot->mLocation);
+  }
 
 private:
   GlHandleWrapper mProgram;
   VertexLayout mVertexLayout;
-  mutable std::unordered_map<std::string, GLint> mLocationCache;
+  mutable std::vector<UniformSlot> mUniforms;
+  mutable int mNumSkippedUpdates = 0;
 };
 
 
@@ -16,6 +16,8 @@
 
 #include "shader_code.hpp"
 
+#include "renderer/renderer_support.hpp"
+
 #include <array>
 
 
@@ -39,6 +41,7 @@ void main() {
 )shd";
 
 
+// Compiled with and without ENABLE_REPEAT, see TEXTURED_QUAD_REPEAT_SHADER
 const char* FRAGMENT_SOURCE = R"shd(
 DEFAULT_PRECISION_DECLARATION
 OUTPUT_COLOR_DECLARATION
@@ -49,14 +52,13 @@ uniform sampler2D textureData;
 uniform vec4 overlayColor;
 
 uniform vec4 colorModulation;
-uniform bool enableRepeat;
 
 void main() {
+#ifdef ENABLE_REPEAT
+  HIGHP vec2 texCoords = fract(texCoordFrag);
+#else
   HIGHP vec2 texCoords = texCoordFrag;
-  if (enableRepeat) {
-    texCoords.x = fract(texCoords.x);
-    texCoords.y = fract(texCoords.y);
-  }
+#endif
 
   vec4 baseColor = TEXTURE_LOOKUP(textureData, texCoords);
   vec4 modulated = baseColor * colorModulation;
@@ -67,6 +69,86 @@ void main() {
 }
 )shd";
 
+const char* VERTEX_SOURCE_MULTI_TEXTURE = R"shd(
+ATTRIBUTE HIGHP vec2 position;
+ATTRIBUTE HIGHP vec2 texCoord;
+ATTRIBUTE HIGHP float textureIndex;
+
+OUT HIGHP vec2 texCoordFrag;
+OUT HIGHP float textureIndexFrag;
+
+uniform mat4 transform;
+
+void main() {
+  gl_Position = transform * vec4(position, 0.0, 1.0);
+  texCoordFrag = vec2(texCoord.x, 1.0 - texCoord.y);
+  textureIndexFrag = textureIndex;
+}
+)shd";
+
+// Each instance is one quad. The corner attribute comes from a static
+// buffer holding the quad's 4 corners in normalized coordinates, all other
+// attributes are per-instance.
+const char* VERTEX_SOURCE_INSTANCED_QUAD = R"shd(
+ATTRIBUTE HIGHP vec2 corner;
+ATTRIBUTE HIGHP vec4 destRect;
+ATTRIBUTE HIGHP vec4 texRect;
+ATTRIBUTE HIGHP float textureIndex;
+
+OUT HIGHP vec2 texCoordFrag;
+OUT HIGHP float textureIndexFrag;
+
+uniform mat4 transform;
+
+void main() {
+  HIGHP vec2 position = destRect.xy + corner * destRect.zw;
+  HIGHP vec2 texCoord = mix(texRect.xy, texRect.zw, corner);
+
+  gl_Position = transform * vec4(position, 0.0, 1.0);
+  texCoordFrag = vec2(texCoord.x, 1.0 - texCoord.y);
+  textureIndexFrag = textureIndex;
+}
+)shd";
+
+// GLSL ES 1.0 doesn't allow indexing sampler arrays with a dynamic value,
+// hence the if-chain.
+const char* FRAGMENT_SOURCE_MULTI_TEXTURE = R"shd(
+DEFAULT_PRECISION_DECLARATION
+OUTPUT_COLOR_DECLARATION
+
+IN HIGHP vec2 texCoordFrag;
+IN HIGHP float textureIndexFrag;
+
+uniform sampler2D textureData0;
+uniform sampler2D textureData1;
+uniform sampler2D textureData2;
+uniform sampler2D textureData3;
+uniform sampler2D textureData4;
+uniform sampler2D textureData5;
+uniform sampler2D textureData6;
+uniform sampler2D textureData7;
+
+void main() {
+  if (textureIndexFrag < 0.5) {
+    OUTPUT_COLOR = TEXTURE_LOOKUP(textureData0, texCoordFrag);
+  } else if (textureIndexFrag < 1.5) {
+    OUTPUT_COLOR = TEXTURE_LOOKUP(textureData1, texCoordFrag);
+  } else if (textureIndexFrag < 2.5) {
+    OUTPUT_COLOR = TEXTURE_LOOKUP(textureData2, texCoordFrag);
+  } else if (textureIndexFrag < 3.5) {
+    OUTPUT_COLOR = TEXTURE_LOOKUP(textureData3, texCoordFrag);
+  } else if (textureIndexFrag < 4.5) {
+    OUTPUT_COLOR = TEXTURE_LOOKUP(textureData4, texCoordFrag);
+  } else if (textureIndexFrag < 5.5) {
+    OUTPUT_COLOR = TEXTURE_LOOKUP(textureData5, texCoordFrag);
+  } else if (textureIndexFrag < 6.5) {
+    OUTPUT_COLOR = TEXTURE_LOOKUP(textureData6, texCoordFrag);
+  } else {
+    OUTPUT_COLOR = TEXTURE_LOOKUP(textureData7, texCoordFrag);
+  }
+}
+)shd";
+
 const char* VERTEX_SOURCE_SOLID = R"shd(
 ATTRIBUTE vec2 position;
 ATTRIBUTE vec4 color;
@@ -96,6 +178,19 @@ void main() {
 
 constexpr auto TEXTURED_QUAD_TEXTURE_UNIT_NAMES = std::array{"textureData"};
 
+constexpr auto MULTI_TEXTURED_QUAD_TEXTURE_UNIT_NAMES = std::array{
+  "textureData0",
+  "textureData1",
+  "textureData2",
+  "textureData3",
+  "textureData4",
+  "textureData5",
+  "textureData6",
+  "textureData7"};
+
+static_assert(
+  MULTI_TEXTURED_QUAD_TEXTURE_UNIT_NAMES.size() == MAX_MULTI_TEXTURES);
+
 } // namespace
 
 
@@ -121,6 +216,14 @@ const ShaderSpec TEXTURED_QUAD_SHADER{
   FRAGMENT_SOURCE};
 
 
+const ShaderSpec TEXTURED_QUAD_REPEAT_SHADER{
+  VertexLayout::PositionAndTexCoords,
+  TEXTURED_QUAD_TEXTURE_UNIT_NAMES,
+  STANDARD_VERTEX_SOURCE,
+  FRAGMENT_SOURCE,
+  "#define ENABLE_REPEAT"};
+
+
 const ShaderSpec SIMPLE_TEXTURED_QUAD_SHADER{
   VertexLayout::PositionAndTexCoords,
   TEXTURED_QUAD_TEXTURE_UNIT_NAMES,
@@ -128,6 +231,20 @@ const ShaderSpec SIMPLE_TEXTURED_QUAD_SHADER{
   FRAGMENT_SOURCE_SIMPLE};
 
 
+const ShaderSpec MULTI_TEXTURED_QUAD_SHADER{
+  VertexLayout::PositionTexCoordsAndTextureIndex,
+  MULTI_TEXTURED_QUAD_TEXTURE_UNIT_NAMES,
+  VERTEX_SOURCE_MULTI_TEXTURE,
+  FRAGMENT_SOURCE_MULTI_TEXTURE};
+
+
+const ShaderSpec INSTANCED_QUAD_SHADER{
+  VertexLayout::InstancedQuad,
+  MULTI_TEXTURED_QUAD_TEXTURE_UNIT_NAMES,
+  VERTEX_SOURCE_INSTANCED_QUAD,
+  FRAGMENT_SOURCE_MULTI_TEXTURE};
+
+
 const ShaderSpec SOLID_COLOR_SHADER{
   VertexLayout::PositionAndColor,
   {},
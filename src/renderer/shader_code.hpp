@@ -25,7 +25,10 @@ namespace rigel::renderer
 extern const char* STANDARD_VERTEX_SOURCE;
 
 extern const ShaderSpec TEXTURED_QUAD_SHADER;
+extern const ShaderSpec TEXTURED_QUAD_REPEAT_SHADER;
 extern const ShaderSpec SIMPLE_TEXTURED_QUAD_SHADER;
+extern const ShaderSpec MULTI_TEXTURED_QUAD_SHADER;
+extern const ShaderSpec INSTANCED_QUAD_SHADER;
 extern const ShaderSpec SOLID_COLOR_SHADER;
 
 } // namespace rigel::renderer
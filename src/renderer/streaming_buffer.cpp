@@ -0,0 +1,271 @@
+/* Copyright (C) 2022, Nikolai Wuttke. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "streaming_buffer.hpp"
+
+#include <loguru.hpp>
+
+#include <cassert>
+#include <cstring>
+
+
+namespace rigel::renderer
+{
+
+namespace
+{
+
+#ifndef RIGEL_USE_GL_ES
+constexpr auto FENCE_WAIT_TIMEOUT_NS = GLuint64{1'000'000'000};
+
+constexpr GLbitfield PERSISTENT_MAPPING_FLAGS =
+  GL_MAP_WRITE_BIT | ext::GL_MAP_PERSISTENT_BIT | ext::GL_MAP_COHERENT_BIT;
+#endif
+
+
+StreamingVertexBuffer::Mode determineMode()
+{
+#ifdef RIGEL_USE_GL_ES
+  return StreamingVertexBuffer::Mode::Orphaning;
+#else
+  const auto& features = optionalGlFeatures();
+
+  if (features.mHasBufferStorage && features.mHasSync)
+  {
+    return StreamingVertexBuffer::Mode::PersistentMapped;
+  }
+
+  return StreamingVertexBuffer::Mode::MappedRange;
+#endif
+}
+
+
+const char* modeName(const StreamingVertexBuffer::Mode mode)
+{
+  switch (mode)
+  {
+    case StreamingVertexBuffer::Mode::PersistentMapped:
+      return "persistent mapping";
+
+    case StreamingVertexBuffer::Mode::MappedRange:
+      return "mapped ranges";
+
+    case StreamingVertexBuffer::Mode::Orphaning:
+      return "buffer orphaning";
+  }
+
+  return "unknown";
+}
+
+} // namespace
+
+
+StreamingVertexBuffer::StreamingVertexBuffer()
+  : mMode(determineMode())
+{
+  glGenBuffers(1, &mVbo);
+  glBindBuffer(GL_ARRAY_BUFFER, mVbo);
+
+#ifndef RIGEL_USE_GL_ES
+  const auto totalSize = GLsizeiptr(NUM_SEGMENTS * SEGMENT_SIZE);
+
+  if (mMode == Mode::PersistentMapped)
+  {
+    ext::glBufferStorage(
+      GL_ARRAY_BUFFER, totalSize, nullptr, PERSISTENT_MAPPING_FLAGS);
+    mpMappedMemory = static_cast<std::uint8_t*>(glMapBufferRange(
+      GL_ARRAY_BUFFER, 0, totalSize, PERSISTENT_MAPPING_FLAGS));
+
+    if (!mpMappedMemory)
+    {
+      fallBackToOrphaning();
+    }
+  }
+  else if (mMode == Mode::MappedRange)
+  {
+    glBufferData(GL_ARRAY_BUFFER, totalSize, nullptr, GL_STREAM_DRAW);
+  }
+#endif
+
+  LOG_F(INFO, "Streaming vertex data using %s", modeName(mMode));
+}
+
+
+StreamingVertexBuffer::~StreamingVertexBuffer()
+{
+#ifndef RIGEL_USE_GL_ES
+  for (auto& fence : mSegmentFences)
+  {
+    if (fence)
+    {
+      ext::glDeleteSync(fence);
+    }
+  }
+#endif
+
+  // Deleting the buffer also unmaps it, if it's persistently mapped
+  glDeleteBuffers(1, &mVbo);
+}
+
+
+std::uintptr_t
+  StreamingVertexBuffer::upload(const base::ArrayView<float> vertices)
+{
+  const auto size = vertices.size() * sizeof(float);
+  mBytesUploadedThisFrame += size;
+
+  if (mMode == Mode::Orphaning)
+  {
+    glBufferData(
+      GL_ARRAY_BUFFER, GLsizeiptr(size), vertices.data(), GL_STREAM_DRAW);
+    return 0;
+  }
+
+#ifndef RIGEL_USE_GL_ES
+  assert(size <= SEGMENT_SIZE);
+
+  if (mWriteOffset + size > SEGMENT_SIZE)
+  {
+    advanceSegment();
+  }
+
+  const auto offset = segmentStart() + mWriteOffset;
+
+  if (mMode == Mode::PersistentMapped)
+  {
+    std::memcpy(mpMappedMemory + offset, vertices.data(), size);
+  }
+  else
+  {
+    auto flags = GLbitfield{GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT};
+
+    // Without fences, we can't know whether the GPU is done with the range
+    // we're about to write to, so we need to let the driver synchronize.
+    if (optionalGlFeatures().mHasSync)
+    {
+      flags |= GL_MAP_UNSYNCHRONIZED_BIT;
+    }
+
+    auto pTarget = glMapBufferRange(
+      GL_ARRAY_BUFFER, GLintptr(offset), GLsizeiptr(size), flags);
+
+    if (pTarget)
+    {
+      std::memcpy(pTarget, vertices.data(), size);
+    }
+
+    // glUnmapBuffer can fail if the buffer contents were lost while mapped,
+    // e.g. due to a display mode change.
+    if (!pTarget || !glUnmapBuffer(GL_ARRAY_BUFFER))
+    {
+      fallBackToOrphaning();
+
+      mBytesUploadedThisFrame -= size;
+      return upload(vertices);
+    }
+  }
+
+  mWriteOffset += size;
+  return offset;
+#else
+  return 0;
+#endif
+}
+
+
+void StreamingVertexBuffer::endFrame()
+{
+  mBytesUploadedLastFrame = mBytesUploadedThisFrame;
+  mBytesUploadedThisFrame = 0;
+
+  if (mMode != Mode::Orphaning && mWriteOffset > 0)
+  {
+    advanceSegment();
+  }
+}
+
+
+void StreamingVertexBuffer::advanceSegment()
+{
+  fenceCurrentSegment();
+
+  mCurrentSegment = (mCurrentSegment + 1) % NUM_SEGMENTS;
+  mWriteOffset = 0;
+
+  waitForCurrentSegment();
+}
+
+
+void StreamingVertexBuffer::fenceCurrentSegment()
+{
+#ifndef RIGEL_USE_GL_ES
+  if (!optionalGlFeatures().mHasSync)
+  {
+    return;
+  }
+
+  auto& fence = mSegmentFences[mCurrentSegment];
+  if (fence)
+  {
+    ext::glDeleteSync(fence);
+  }
+
+  fence = ext::glFenceSync(ext::GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+#endif
+}
+
+
+void StreamingVertexBuffer::waitForCurrentSegment()
+{
+#ifndef RIGEL_USE_GL_ES
+  auto& fence = mSegmentFences[mCurrentSegment];
+  if (!fence)
+  {
+    return;
+  }
+
+  auto result = ext::GL_TIMEOUT_EXPIRED;
+  do
+  {
+    result = ext::glClientWaitSync(
+      fence, ext::GL_SYNC_FLUSH_COMMANDS_BIT, FENCE_WAIT_TIMEOUT_NS);
+  } while (result == ext::GL_TIMEOUT_EXPIRED);
+
+  ext::glDeleteSync(fence);
+  fence = nullptr;
+#endif
+}
+
+
+void StreamingVertexBuffer::fallBackToOrphaning()
+{
+  LOG_F(
+    WARNING,
+    "Mapping streaming vertex buffer failed, falling back to orphaning");
+
+  // Buffers created via glBufferStorage are immutable, so we can't simply
+  // keep using the existing buffer with glBufferData. Recreating it is the
+  // easiest way to handle all cases.
+  glDeleteBuffers(1, &mVbo);
+  glGenBuffers(1, &mVbo);
+  glBindBuffer(GL_ARRAY_BUFFER, mVbo);
+
+  mpMappedMemory = nullptr;
+  mWriteOffset = 0;
+  mMode = Mode::Orphaning;
+}
+
+} // namespace rigel::renderer
@@ -0,0 +1,119 @@
+/* Copyright (C) 2022, Nikolai Wuttke. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "base/array_view.hpp"
+#include "renderer/opengl.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+
+namespace rigel::renderer
+{
+
+/** Ring buffer for streaming vertex data to the GPU
+ *
+ * The renderer produces a lot of small vertex uploads per frame (one per
+ * batch). Re-specifying a single buffer via glBufferData for each of these
+ * forces the driver to orphan the buffer every time, which can cause stalls
+ * on some drivers. This class instead splits one large buffer into
+ * NUM_SEGMENTS segments (one per frame in flight), and sub-allocates from
+ * the current segment for each upload.
+ *
+ * Depending on what the OpenGL implementation offers, one of the following
+ * strategies is used:
+ *
+ *  - PersistentMapped: The buffer is created via glBufferStorage and mapped
+ *    once for its entire life time. Uploads are a plain memcpy. Requires
+ *    fence syncs to make sure the GPU isn't still reading from a segment
+ *    that we are about to overwrite.
+ *  - MappedRange: Each upload maps the target range via glMapBufferRange,
+ *    using the unsynchronized flag when fences are available.
+ *  - Orphaning: The original approach, glBufferData for each upload. Used
+ *    on GL ES 2.0, and if mapping fails for some reason.
+ *
+ * The buffer is bound to GL_ARRAY_BUFFER on construction. Since uploads
+ * are placed at varying offsets, vertex attribute pointers need to be
+ * set up using the offset returned by upload() before drawing.
+ */
+class StreamingVertexBuffer
+{
+public:
+  enum class Mode
+  {
+    PersistentMapped,
+    MappedRange,
+    Orphaning
+  };
+
+  StreamingVertexBuffer();
+  ~StreamingVertexBuffer();
+
+  StreamingVertexBuffer(const StreamingVertexBuffer&) = delete;
+  StreamingVertexBuffer& operator=(const StreamingVertexBuffer&) = delete;
+
+  /** Copy given vertices into the buffer
+   *
+   * Returns the byte offset at which the data was placed. The buffer
+   * must be bound to GL_ARRAY_BUFFER when calling this function.
+   */
+  std::uintptr_t upload(base::ArrayView<float> vertices);
+
+  /** Mark the end of a frame
+   *
+   * Moves on to the next segment. To be called once per frame, after
+   * all draw calls for the frame have been issued.
+   */
+  void endFrame();
+
+  GLuint handle() const { return mVbo; }
+  Mode mode() const { return mMode; }
+
+  std::size_t bytesUploadedLastFrame() const
+  {
+    return mBytesUploadedLastFrame;
+  }
+
+private:
+  void advanceSegment();
+  void fenceCurrentSegment();
+  void waitForCurrentSegment();
+  void fallBackToOrphaning();
+
+  std::uintptr_t segmentStart() const
+  {
+    return mCurrentSegment * SEGMENT_SIZE;
+  }
+
+  static constexpr auto NUM_SEGMENTS = std::size_t{3};
+  static constexpr auto SEGMENT_SIZE = std::size_t{1024 * 1024};
+
+#ifndef RIGEL_USE_GL_ES
+  std::array<GLsync, NUM_SEGMENTS> mSegmentFences{};
+#endif
+  std::uint8_t* mpMappedMemory = nullptr;
+  std::size_t mCurrentSegment = 0;
+  std::size_t mWriteOffset = 0;
+  std::size_t mBytesUploadedThisFrame = 0;
+  std::size_t mBytesUploadedLastFrame = 0;
+  GLuint mVbo = 0;
+  Mode mMode;
+};
+
+} // namespace rigel::renderer
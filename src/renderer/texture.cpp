@@ -68,6 +68,12 @@ void Texture::render(
 }
 
 
+void Texture::updatePixels(const base::Vec2& position, const Image& image)
+{
+  mpRenderer->updateTexture(mId, mHeight, position, image);
+}
+
+
 Texture::Texture(renderer::Renderer* pRenderer, const Image& image)
   : Texture(
       pRenderer,
@@ -78,6 +84,28 @@ Texture::Texture(renderer::Renderer* pRenderer, const Image& image)
 }
 
 
+Texture::Texture(renderer::Renderer* pRenderer, Image&& image)
+  : mpRenderer(pRenderer)
+  , mWidth(static_cast<int>(image.width()))
+  , mHeight(static_cast<int>(image.height()))
+{
+  mId = pRenderer->createTexture(std::move(image));
+}
+
+
+Texture Texture::createDeferred(
+  renderer::Renderer* pRenderer,
+  Image&& image,
+  std::function<void(TextureId)> onReady)
+{
+  const auto width = static_cast<int>(image.width());
+  const auto height = static_cast<int>(image.height());
+  const auto id =
+    pRenderer->createTextureDeferred(std::move(image), std::move(onReady));
+  return Texture(pRenderer, id, width, height);
+}
+
+
 Texture::~Texture()
 {
   if (mpRenderer)
@@ -22,6 +22,8 @@
 #include "base/spatial_types.hpp"
 #include "renderer/renderer.hpp"
 
+#include <functional>
+
 
 namespace rigel::renderer
 {
@@ -40,8 +42,23 @@ class Texture
 public:
   Texture() = default;
   Texture(Renderer* renderer, const data::Image& image);
+
+  /** Create a texture from an image that's not needed anymore afterwards
+   *
+   * The image's pixel data is freed as soon as it has been uploaded.
+   */
+  Texture(Renderer* renderer, data::Image&& image);
   ~Texture();
 
+  /** Create a texture whose pixel data is uploaded over multiple frames
+   *
+   * See Renderer::createTextureDeferred().
+   */
+  static Texture createDeferred(
+    Renderer* pRenderer,
+    data::Image&& image,
+    std::function<void(TextureId)> onReady = {});
+
   Texture(Texture&& other) noexcept
     : Texture(
         std::exchange(other.mpRenderer, nullptr),
@@ -87,6 +104,13 @@ public:
     const base::Rect<int>& sourceRect,
     const base::Rect<int>& destRect) const;
 
+  /** Replace part of the texture's contents with the given image
+   *
+   * Position refers to the top-left corner of the area to replace. Only
+   * valid for textures created from an image.
+   */
+  void updatePixels(const base::Vec2& position, const data::Image& image);
+
   int width() const { return mWidth; }
 
   int height() const { return mHeight; }
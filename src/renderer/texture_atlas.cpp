@@ -24,6 +24,7 @@ RIGEL_DISABLE_WARNINGS
 RIGEL_RESTORE_WARNINGS
 
 #include <algorithm>
+#include <numeric>
 #include <stdexcept>
 
 
@@ -36,27 +37,109 @@ namespace
 constexpr auto ATLAS_WIDTH = 2048;
 constexpr auto ATLAS_HEIGHT = 1024;
 constexpr auto PADDING = 1;
+constexpr auto NO_TEXTURE = -1;
+
+
+template <typename ImageT, typename CreatePageFunc>
+TextureAtlas::BasicPackedImages<ImageT> packImages(
+  const std::vector<ImageT>& images,
+  const TextureAtlas::Layout& layout,
+  CreatePageFunc createPage)
+{
+  if (layout.mLocations.size() != images.size())
+  {
+    throw std::invalid_argument{"Atlas layout doesn't match images"};
+  }
+
+  auto packed = TextureAtlas::BasicPackedImages<ImageT>{};
+  packed.mLocations = layout.mLocations;
+
+  packed.mTextureImages.reserve(layout.mTextureSizes.size());
+  for (const auto& size : layout.mTextureSizes)
+  {
+    packed.mTextureImages.push_back(
+      createPage(size_t(size.width), size_t(size.height)));
+  }
+
+  for (auto i = 0u; i < images.size(); ++i)
+  {
+    const auto& location = layout.mLocations[i];
+    const auto& image = images[i];
+    if (
+      location.mRect.size.width != int(image.width()) ||
+      location.mRect.size.height != int(image.height()))
+    {
+      throw std::invalid_argument{"Atlas layout doesn't match images"};
+    }
+
+    packed.mTextureImages[location.mTextureIndex].insertImage(
+      location.mRect.topLeft.x, location.mRect.topLeft.y, image);
+  }
+
+  return packed;
+}
+
+
+template <typename ImageT>
+std::vector<base::Size> imageSizes(const std::vector<ImageT>& images)
+{
+  std::vector<base::Size> result;
+  result.reserve(images.size());
+
+  for (const auto& image : images)
+  {
+    result.push_back({int(image.width()), int(image.height())});
+  }
+
+  return result;
+}
 
 } // namespace
 
 
-TextureAtlas::TextureAtlas(
-  Renderer* pRenderer,
-  const std::vector<data::Image>& images)
-  : mpRenderer(pRenderer)
+float TextureAtlas::Layout::occupancy() const
 {
-  mAtlasMap.resize(images.size());
+  const auto usedArea = std::accumulate(
+    mLocations.begin(),
+    mLocations.end(),
+    0.0,
+    [](const double sum, const ImageLocation& location) {
+      const auto& size = location.mRect.size;
+      return sum + double(size.width) * size.height;
+    });
+  const auto totalArea = std::accumulate(
+    mTextureSizes.begin(),
+    mTextureSizes.end(),
+    0.0,
+    [](const double sum, const base::Size& size) {
+      return sum + double(size.width) * size.height;
+    });
+
+  return totalArea > 0.0 ? float(usedArea / totalArea) : 0.0f;
+}
+
+
+auto TextureAtlas::computeLayout(const std::vector<base::Size>& imageSizes)
+  -> Layout
+{
+  auto layout = Layout{};
+  if (imageSizes.empty())
+  {
+    return layout;
+  }
+
+  layout.mLocations.resize(imageSizes.size());
 
   std::vector<stbrp_rect> rects;
-  rects.reserve(images.size());
+  rects.reserve(imageSizes.size());
 
   auto index = 0;
-  for (const auto& image : images)
+  for (const auto& size : imageSizes)
   {
     rects.push_back(stbrp_rect{
       index,
-      static_cast<stbrp_coord>(image.width() + 2 * PADDING),
-      static_cast<stbrp_coord>(image.height() + 2 * PADDING),
+      static_cast<stbrp_coord>(size.width + 2 * PADDING),
+      static_cast<stbrp_coord>(size.height + 2 * PADDING),
       0,
       0,
       0});
@@ -76,6 +159,11 @@ TextureAtlas::TextureAtlas(
       nodes.data(),
       static_cast<int>(nodes.size()));
 
+    // The skyline packer sorts by height. Choosing the position that leaves
+    // the least wasted space below each rect (best fit) results in fewer
+    // textures than always going for the lowest position.
+    stbrp_setup_heuristic(&context, STBRP_HEURISTIC_Skyline_BF_sortHeight);
+
     const auto result =
       stbrp_pack_rects(&context, rects.data(), static_cast<int>(rects.size()));
 
@@ -97,28 +185,160 @@ TextureAtlas::TextureAtlas(
       throw std::runtime_error{"Failed to build texture atlas"};
     }
 
-    data::Image atlas{
-      static_cast<size_t>(ATLAS_WIDTH), static_cast<size_t>(ATLAS_HEIGHT)};
+    // Only allocate as much height as the packed images need. This makes
+    // a big difference for the last texture, and for atlases built from
+    // just a few images.
+    const auto usedHeight = std::accumulate(
+      iFirstPacked, rects.end(), 0, [](const int height, const auto& rect) {
+        return std::max(height, rect.y + rect.h);
+      });
 
-    const auto textureIndex = static_cast<int>(mAtlasTextures.size());
+    const auto textureIndex = static_cast<int>(layout.mTextureSizes.size());
     std::for_each(iFirstPacked, rects.end(), [&](const stbrp_rect& packedRect) {
-      atlas.insertImage(
-        packedRect.x + PADDING, packedRect.y + PADDING, images[packedRect.id]);
-      mAtlasMap[packedRect.id] = TextureInfo{
+      layout.mLocations[packedRect.id] = ImageLocation{
         {{packedRect.x + PADDING, packedRect.y + PADDING},
          {packedRect.w - 2 * PADDING, packedRect.h - 2 * PADDING}},
         textureIndex};
     });
 
-    mAtlasTextures.emplace_back(mpRenderer, std::move(atlas));
+    layout.mTextureSizes.push_back({ATLAS_WIDTH, usedHeight});
 
     rects.erase(iFirstPacked, rects.end());
   } while (!rects.empty());
+
+  return layout;
+}
+
+
+auto TextureAtlas::pack(const std::vector<data::Image>& images) -> PackedImages
+{
+  return pack(images, computeLayout(imageSizes(images)));
+}
+
+
+auto TextureAtlas::pack(
+  const std::vector<data::Image>& images,
+  const Layout& layout) -> PackedImages
+{
+  return packImages(
+    images, layout, [](const size_t width, const size_t height) {
+      return data::Image{width, height};
+    });
+}
+
+
+auto TextureAtlas::pack(const std::vector<data::IndexedImage>& images)
+  -> PackedIndexedImages
+{
+  return pack(images, computeLayout(imageSizes(images)));
+}
+
+
+auto TextureAtlas::pack(
+  const std::vector<data::IndexedImage>& images,
+  const Layout& layout) -> PackedIndexedImages
+{
+  if (images.empty())
+  {
+    return {};
+  }
+
+  return packImages(
+    images, layout, [&](const size_t width, const size_t height) {
+      return data::IndexedImage{width, height, images.front().palette()};
+    });
+}
+
+
+TextureAtlas::TextureAtlas(
+  Renderer* pRenderer,
+  const std::vector<data::Image>& images)
+  : TextureAtlas(pRenderer, pack(images))
+{
+}
+
+
+TextureAtlas::TextureAtlas(
+  Renderer* pRenderer,
+  const PackedImages& packedImages)
+  : mAtlasMap(packedImages.mLocations)
+  , mpRenderer(pRenderer)
+{
+  mAtlasTextures.reserve(packedImages.mTextureImages.size());
+  for (const auto& image : packedImages.mTextureImages)
+  {
+    mAtlasTextures.emplace_back(mpRenderer, image);
+  }
+
+  updateMemoryUsage();
+}
+
+
+TextureAtlas::TextureAtlas(
+  Renderer* pRenderer,
+  const PackedIndexedImages& packedImages)
+  : mAtlasMap(packedImages.mLocations)
+  , mpRenderer(pRenderer)
+{
+  mAtlasTextures.reserve(packedImages.mTextureImages.size());
+  for (const auto& image : packedImages.mTextureImages)
+  {
+    mAtlasTextures.emplace_back(mpRenderer, image.toImage());
+  }
+
+  updateMemoryUsage();
+}
+
+
+void TextureAtlas::addImages(
+  const std::vector<int>& indices,
+  const PackedImages& packedImages)
+{
+  const auto firstTextureIndex = static_cast<int>(mAtlasTextures.size());
+
+  for (const auto& image : packedImages.mTextureImages)
+  {
+    mAtlasTextures.emplace_back(mpRenderer, image);
+  }
+
+  for (auto i = 0u; i < indices.size(); ++i)
+  {
+    const auto index = static_cast<size_t>(indices[i]);
+    if (index >= mAtlasMap.size())
+    {
+      mAtlasMap.resize(index + 1, ImageLocation{{}, NO_TEXTURE});
+    }
+
+    mAtlasMap[index] = packedImages.mLocations[i];
+    mAtlasMap[index].mTextureIndex += firstTextureIndex;
+  }
+
+  updateMemoryUsage();
+}
+
+
+void TextureAtlas::clear()
+{
+  mAtlasMap.clear();
+  mAtlasTextures.clear();
+  updateMemoryUsage();
+}
+
+
+bool TextureAtlas::contains(const int index) const
+{
+  return index >= 0 && static_cast<size_t>(index) < mAtlasMap.size() &&
+    mAtlasMap[index].mTextureIndex != NO_TEXTURE;
 }
 
 
 void TextureAtlas::draw(int index, const base::Rect<int>& destRect) const
 {
+  if (!contains(index))
+  {
+    return;
+  }
+
   const auto& info = mAtlasMap[index];
   mAtlasTextures[info.mTextureIndex].render(info.mRect, destRect);
 }
@@ -129,6 +349,11 @@ void TextureAtlas::draw(
   const base::Rect<int>& srcRect,
   const base::Rect<int>& destRect) const
 {
+  if (!contains(index))
+  {
+    return;
+  }
+
   const auto& info = mAtlasMap[index];
   auto actualSrcRect = srcRect;
   actualSrcRect.topLeft += info.mRect.topLeft;
@@ -139,6 +364,11 @@ void TextureAtlas::draw(
 
 auto TextureAtlas::drawData(int index) const -> DrawData
 {
+  if (!contains(index))
+  {
+    return {};
+  }
+
   const auto& info = mAtlasMap[index];
   const auto& texture = mAtlasTextures[info.mTextureIndex];
 
@@ -147,4 +377,28 @@ auto TextureAtlas::drawData(int index) const -> DrawData
     renderer::toTexCoords(info.mRect, texture.width(), texture.height())};
 }
 
+
+renderer::TextureId TextureAtlas::textureId(const int index) const
+{
+  if (!contains(index))
+  {
+    return {};
+  }
+
+  return mAtlasTextures[mAtlasMap[index].mTextureIndex].data();
+}
+
+
+void TextureAtlas::updateMemoryUsage()
+{
+  // Textures are uploaded as 8-bit RGBA
+  auto bytes = std::size_t{0};
+  for (const auto& texture : mAtlasTextures)
+  {
+    bytes += std::size_t(texture.width()) * texture.height() * 4;
+  }
+
+  mGpuMemory.set(bytes);
+}
+
 } // namespace rigel::renderer
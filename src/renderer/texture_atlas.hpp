@@ -17,6 +17,7 @@
 #pragma once
 
 #include "base/image.hpp"
+#include "base/memory_accounting.hpp"
 #include "renderer/renderer.hpp"
 #include "renderer/texture.hpp"
 
@@ -41,6 +42,72 @@ public:
     renderer::TexCoords mTexCoords;
   };
 
+  struct ImageLocation
+  {
+    base::Rect<int> mRect;
+    int mTextureIndex;
+  };
+
+  /** Images arranged into atlas textures, not yet uploaded to the GPU */
+  template <typename ImageT>
+  struct BasicPackedImages
+  {
+    /** Location of each input image, in input order */
+    std::vector<ImageLocation> mLocations;
+    std::vector<ImageT> mTextureImages;
+  };
+
+  using PackedImages = BasicPackedImages<data::Image>;
+
+  /** Packed palette-indexed images
+   *
+   * These are only expanded to RGBA while creating the atlas textures,
+   * one texture at a time.
+   */
+  using PackedIndexedImages = BasicPackedImages<data::IndexedImage>;
+
+  /** Placement of images into atlas textures
+   *
+   * Only depends on the sizes of the images, so a layout can be stored and
+   * reused for any list of images with the same sizes.
+   */
+  struct Layout
+  {
+    /** Location of each image, in input order */
+    std::vector<ImageLocation> mLocations;
+    std::vector<base::Size> mTextureSizes;
+
+    /** Fraction of the textures' area covered by images, from 0 to 1 */
+    float occupancy() const;
+  };
+
+  /** Arrange images of the given sizes into as few textures as possible */
+  static Layout computeLayout(const std::vector<base::Size>& imageSizes);
+
+  /** Arrange images into as few atlas textures as possible
+   *
+   * Doesn't need a renderer, so it can run on a worker thread, and the
+   * result can be cached.
+   */
+  static PackedImages pack(const std::vector<data::Image>& images);
+
+  /** Arrange images according to a previously computed layout
+   *
+   * The layout must have been computed for the sizes of the given images.
+   */
+  static PackedImages
+    pack(const std::vector<data::Image>& images, const Layout& layout);
+
+  /** Like the other overload of pack(), for indexed images
+   *
+   * All images must use the same palette.
+   */
+  static PackedIndexedImages
+    pack(const std::vector<data::IndexedImage>& images);
+  static PackedIndexedImages pack(
+    const std::vector<data::IndexedImage>& images,
+    const Layout& layout);
+
   /** Build a texture atlas
    *
    * Create an atlas using the provided list of images. Might use more than
@@ -52,6 +119,29 @@ public:
    */
   TextureAtlas(Renderer* pRenderer, const std::vector<data::Image>& images);
 
+  /** Build a texture atlas from previously packed images */
+  TextureAtlas(Renderer* pRenderer, const PackedImages& packedImages);
+  TextureAtlas(Renderer* pRenderer, const PackedIndexedImages& packedImages);
+
+  /** Add more images to an existing atlas
+   *
+   * The packed images are uploaded as additional textures. Afterwards, the
+   * i-th packed image can be drawn using indices[i]. This allows filling
+   * an atlas on demand, starting from an empty one.
+   */
+  void addImages(
+    const std::vector<int>& indices,
+    const PackedImages& packedImages);
+
+  /** Remove all images and release their textures */
+  void clear();
+
+  /** Returns true if the atlas has an image for the given index
+   *
+   * Drawing an image which isn't present does nothing.
+   */
+  bool contains(int index) const;
+
   /** Draw image from atlas at given location
    *
    * The index parameter corresponds to the index in the list given on
@@ -71,16 +161,16 @@ public:
 
   DrawData drawData(int index) const;
 
+  /** Returns the texture that contains the image at the given index */
+  renderer::TextureId textureId(int index) const;
+
 private:
-  struct TextureInfo
-  {
-    base::Rect<int> mRect;
-    int mTextureIndex;
-  };
+  void updateMemoryUsage();
 
-  std::vector<TextureInfo> mAtlasMap;
+  std::vector<ImageLocation> mAtlasMap;
   std::vector<Texture> mAtlasTextures;
   Renderer* mpRenderer;
+  base::TrackedMemory mGpuMemory{base::MemoryCategory::AtlasTextures};
 };
 
 } // namespace rigel::renderer
@@ -0,0 +1,203 @@
+/* Copyright (C) 2022, Nikolai Wuttke. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "texture_upload_queue.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <utility>
+
+
+namespace rigel::renderer
+{
+
+namespace
+{
+
+std::size_t bytesPerRow(const data::Image& image)
+{
+  return image.width() * sizeof(data::Pixel);
+}
+
+
+std::size_t uploadRows(
+  const TextureId texture,
+  const data::Image& image,
+  const int firstRow,
+  const int numRows,
+  const TextureUploadQueue::UploadFunction& upload)
+{
+  const auto width = int(image.width());
+  upload(TextureUploadQueue::Strip{
+    texture,
+    firstRow,
+    numRows,
+    width,
+    image.pixelData().data() + std::size_t(firstRow) * std::size_t(width)});
+  return std::size_t(numRows) * bytesPerRow(image);
+}
+
+} // namespace
+
+
+TextureUploadQueue::TextureUploadQueue(const std::size_t bytesPerFrame)
+  : mBytesPerFrame(bytesPerFrame)
+{
+}
+
+
+void TextureUploadQueue::enqueue(
+  const TextureId texture,
+  data::Image&& flippedImage,
+  ReadyCallback callback)
+{
+  assert(!isPending(texture));
+
+  mPendingUploads.push_back(
+    PendingUpload{texture, std::move(flippedImage), std::move(callback), 0});
+}
+
+
+std::size_t TextureUploadQueue::process(const UploadFunction& upload)
+{
+  // Callbacks are invoked after updating the queue, since they might
+  // queue up new uploads or cancel existing ones.
+  std::vector<std::pair<ReadyCallback, TextureId>> completedUploads;
+
+  auto bytesUploaded = std::size_t{0};
+  auto iUpload = mPendingUploads.begin();
+
+  while (iUpload != mPendingUploads.end())
+  {
+    const auto rowSize = bytesPerRow(iUpload->mImage);
+    const auto remainingRows =
+      int(iUpload->mImage.height()) - iUpload->mRowsUploaded;
+
+    if (remainingRows > 0 && rowSize > 0)
+    {
+      const auto remainingBudget =
+        mBytesPerFrame - std::min(bytesUploaded, mBytesPerFrame);
+      const auto rowsInBudget = remainingBudget / rowSize;
+
+      if (rowsInBudget == 0 && bytesUploaded != 0)
+      {
+        break;
+      }
+
+      const auto numRows = std::min(
+        remainingRows, int(std::max(rowsInBudget, std::size_t{1})));
+
+      bytesUploaded += uploadRows(
+        iUpload->mTexture,
+        iUpload->mImage,
+        iUpload->mRowsUploaded,
+        numRows,
+        upload);
+      iUpload->mRowsUploaded += numRows;
+
+      if (numRows < remainingRows)
+      {
+        break;
+      }
+    }
+
+    completedUploads.emplace_back(
+      std::move(iUpload->mCallback), iUpload->mTexture);
+    ++iUpload;
+  }
+
+  mPendingUploads.erase(mPendingUploads.begin(), iUpload);
+
+  for (auto& [callback, texture] : completedUploads)
+  {
+    if (callback)
+    {
+      callback(texture);
+    }
+  }
+
+  return bytesUploaded;
+}
+
+
+std::size_t TextureUploadQueue::finish(
+  const TextureId texture,
+  const UploadFunction& upload)
+{
+  const auto iUpload = find(texture);
+  if (iUpload == mPendingUploads.end())
+  {
+    return 0;
+  }
+
+  auto completed = std::move(*iUpload);
+  mPendingUploads.erase(iUpload);
+
+  const auto remainingRows =
+    int(completed.mImage.height()) - completed.mRowsUploaded;
+  const auto bytesUploaded = remainingRows > 0
+    ? uploadRows(
+        texture,
+        completed.mImage,
+        completed.mRowsUploaded,
+        remainingRows,
+        upload)
+    : std::size_t{0};
+
+  if (completed.mCallback)
+  {
+    completed.mCallback(texture);
+  }
+
+  return bytesUploaded;
+}
+
+
+void TextureUploadQueue::cancel(const TextureId texture)
+{
+  const auto iUpload = find(texture);
+  if (iUpload != mPendingUploads.end())
+  {
+    mPendingUploads.erase(iUpload);
+  }
+}
+
+
+bool TextureUploadQueue::isPending(const TextureId texture) const
+{
+  return std::any_of(
+    mPendingUploads.begin(),
+    mPendingUploads.end(),
+    [&](const PendingUpload& upload) { return upload.mTexture == texture; });
+}
+
+
+void TextureUploadQueue::setBytesPerFrame(const std::size_t bytesPerFrame)
+{
+  mBytesPerFrame = bytesPerFrame;
+}
+
+
+auto TextureUploadQueue::find(const TextureId texture)
+  -> std::vector<PendingUpload>::iterator
+{
+  return std::find_if(
+    mPendingUploads.begin(),
+    mPendingUploads.end(),
+    [&](const PendingUpload& upload) { return upload.mTexture == texture; });
+}
+
+} // namespace rigel::renderer
@@ -0,0 +1,126 @@
+/* Copyright (C) 2022, Nikolai Wuttke. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "base/image.hpp"
+#include "renderer/renderer_support.hpp"
+
+#include <cstddef>
+#include <functional>
+#include <vector>
+
+
+namespace rigel::renderer
+{
+
+/** Default amount of pixel data uploaded per frame by TextureUploadQueue
+ *
+ * Enough to upload an entire 320x200 backdrop plus a 1080p one spread over
+ * a handful of frames, while keeping the per-frame cost well below a
+ * millisecond on typical hardware.
+ */
+constexpr auto DEFAULT_TEXTURE_UPLOAD_BYTES_PER_FRAME =
+  std::size_t{2 * 1024 * 1024};
+
+
+/** Spreads texture uploads over multiple frames
+ *
+ * Uploading a large image in one go can take long enough to cause a
+ * visible hitch. This class keeps track of textures whose storage has
+ * already been allocated, but whose pixel data still needs to be
+ * uploaded. Each call to process() uploads a horizontal strip of rows,
+ * limited by a per-frame byte budget. Once a texture is fully uploaded,
+ * its ready callback is invoked.
+ *
+ * The queue doesn't talk to OpenGL itself, the actual upload is done by
+ * the function given to process(). Images are expected to be in bottom-up
+ * row order already, so row indices can be used as y offsets directly.
+ */
+class TextureUploadQueue
+{
+public:
+  using ReadyCallback = std::function<void(TextureId)>;
+
+  struct Strip
+  {
+    TextureId mTexture;
+    int mFirstRow;
+    int mNumRows;
+    int mWidth;
+    const data::Pixel* mpPixels;
+  };
+
+  using UploadFunction = std::function<void(const Strip&)>;
+
+  explicit TextureUploadQueue(
+    std::size_t bytesPerFrame = DEFAULT_TEXTURE_UPLOAD_BYTES_PER_FRAME);
+
+  /** Queue an upload of the given (bottom-up) image into texture
+   *
+   * The callback is invoked from within a later call to process() or
+   * finish(), after the last strip has been uploaded.
+   */
+  void enqueue(
+    TextureId texture,
+    data::Image&& flippedImage,
+    ReadyCallback callback = {});
+
+  /** Upload as much pending data as the budget allows
+   *
+   * Meant to be called once per frame. At least one row is uploaded per
+   * call if anything is pending, so that progress is made even with a
+   * budget smaller than a single row. Returns the number of bytes
+   * uploaded.
+   */
+  std::size_t process(const UploadFunction& upload);
+
+  /** Upload the remainder of the given texture right away
+   *
+   * Does nothing if there's no pending upload for the texture. Returns the
+   * number of bytes uploaded.
+   */
+  std::size_t finish(TextureId texture, const UploadFunction& upload);
+
+  /** Drop a pending upload without invoking its callback
+   *
+   * Must be called before destroying a texture that might still be
+   * pending.
+   */
+  void cancel(TextureId texture);
+
+  bool isPending(TextureId texture) const;
+  bool empty() const { return mPendingUploads.empty(); }
+
+  void setBytesPerFrame(std::size_t bytesPerFrame);
+  std::size_t bytesPerFrame() const { return mBytesPerFrame; }
+
+private:
+  struct PendingUpload
+  {
+    TextureId mTexture;
+    data::Image mImage;
+    ReadyCallback mCallback;
+    int mRowsUploaded;
+  };
+
+  std::vector<PendingUpload>::iterator find(TextureId texture);
+
+  std::vector<PendingUpload> mPendingUploads;
+  std::size_t mBytesPerFrame;
+};
+
+} // namespace rigel::renderer
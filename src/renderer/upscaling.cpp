@@ -17,12 +17,14 @@
 #include "upscaling.hpp"
 
 #include "base/math_utils.hpp"
+#include "base/tracing.hpp"
 #include "data/game_traits.hpp"
 #include "renderer/renderer.hpp"
 #include "renderer/shader_code.hpp"
 #include "renderer/viewport_utils.hpp"
 
 #include <algorithm>
+#include <cmath>
 
 
 namespace rigel::renderer
@@ -117,6 +119,19 @@ void setupRenderingViewport(
   }
 }
 
+
+[[nodiscard]] base::ScopeGuard useConstantAlphaBlending(
+  const std::uint8_t alpha)
+{
+  // We use OpenGL's blending here instead of the renderer's color modulation,
+  // because we don't need to implement the modulation feature in our custom
+  // sharp bilinear shader if we do it that way.
+  glBlendFunc(GL_CONSTANT_ALPHA, GL_ONE_MINUS_CONSTANT_ALPHA);
+  glBlendColor(0.0f, 0.0f, 0.0f, std::clamp(alpha / 255.0f, 0.0f, 1.0f));
+  return base::defer(
+    []() { glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA); });
+}
+
 } // namespace
 
 
@@ -140,6 +155,17 @@ ViewportInfo determineViewport(const Renderer* pRenderer)
 }
 
 
+int determineMaxVisibleScale(const base::Size& outputSize)
+{
+  // The viewport never gets taller than the output, and in widescreen mode,
+  // it covers the full output height. Aspect ratio correction only makes the
+  // effective scale smaller.
+  const auto scale =
+    float(outputSize.height) / data::GameTraits::viewportHeightPx;
+  return std::max(int(std::ceil(scale)), 1);
+}
+
+
 bool canUseWidescreenMode(const Renderer* pRenderer)
 {
   const auto windowWidth = float(pRenderer->windowSize().width);
@@ -197,25 +223,51 @@ int determineLowResBufferWidth(
 }
 
 
-RenderTargetTexture createFullscreenRenderTarget(
-  Renderer* pRenderer,
+base::Size fullscreenRenderTargetSize(
+  const Renderer* pRenderer,
   const data::GameOptions& options)
 {
   if (options.mPerElementUpscalingEnabled)
   {
-    return RenderTargetTexture{
-      pRenderer, pRenderer->windowSize().width, pRenderer->windowSize().height};
+    return pRenderer->windowSize();
   }
   else
   {
-    return RenderTargetTexture{
-      pRenderer,
+    return {
       determineLowResBufferWidth(pRenderer, options.widescreenModeActive()),
       data::GameTraits::viewportHeightPx};
   }
 }
 
 
+RenderTargetTexture createFullscreenRenderTarget(
+  Renderer* pRenderer,
+  const data::GameOptions& options)
+{
+  const auto size = fullscreenRenderTargetSize(pRenderer, options);
+  return RenderTargetTexture{pRenderer, size.width, size.height};
+}
+
+
+bool updateRenderTargetSize(
+  RenderTargetTexture& target,
+  Renderer* pRenderer,
+  const base::Size& wantedSize)
+{
+  const auto targetExists = target.data() != 0;
+  const auto hasWantedSize =
+    target.width() == wantedSize.width && target.height() == wantedSize.height;
+
+  if (hasWantedSize || (targetExists && pRenderer->isWindowResizing()))
+  {
+    return false;
+  }
+
+  target = RenderTargetTexture{pRenderer, wantedSize.width, wantedSize.height};
+  return true;
+}
+
+
 base::Vec2 offsetTo4by3WithinWidescreen(
   Renderer* pRenderer,
   const data::GameOptions& options)
@@ -239,13 +291,43 @@ UpscalingBuffer::UpscalingBuffer(
   , mSharpBilinearShader(SHARP_BILINEAR_SHADER)
   , mpRenderer(pRenderer)
   , mFilter(options.mUpscalingFilter)
+  , mDynamicResolutionEnabled(options.mDynamicResolutionEnabled)
 {
 }
 
 [[nodiscard]] base::ScopeGuard
   UpscalingBuffer::bindAndClear(const bool perElementUpscaling)
 {
+  mDirectFrameCopied = false;
+
+  const auto resolutionScale =
+    perElementUpscaling ? mDynamicResolution.scale() : 1.0f;
+  if (resolutionScale != mActiveResolutionScale)
+  {
+    mActiveResolutionScale = resolutionScale;
+    applyFilteringMode();
+  }
+
+  // At reduced resolution, the frame needs to be stretched to the window
+  // size when presenting, so it can't be rendered straight into the window.
+  mRenderingDirectly = perElementUpscaling && mActiveResolutionScale == 1.0f;
+
+  if (mRenderingDirectly)
+  {
+    // With per-element upscaling, the render target is as large as the
+    // window and presented without any scaling. Drawing straight into the
+    // back buffer gives the same result, but saves a full-screen copy and a
+    // render target switch per frame.
+    mpRenderer->pushState();
+    mpRenderer->setRenderTarget(0);
+    mpRenderer->clear();
+
+    setupRenderingViewport(mpRenderer, perElementUpscaling);
+    return base::defer([this]() { mpRenderer->popState(); });
+  }
+
   auto saved = mRenderTarget.bind();
+  mpRenderer->setResolutionScale(mActiveResolutionScale);
   mpRenderer->clear();
 
   setupRenderingViewport(mpRenderer, perElementUpscaling);
@@ -255,6 +337,15 @@ UpscalingBuffer::UpscalingBuffer(
 
 void UpscalingBuffer::clear()
 {
+  if (mRenderingDirectly)
+  {
+    const auto saved = renderer::saveState(mpRenderer);
+    mpRenderer->resetState();
+    mpRenderer->clear();
+    mDirectFrameCopied = false;
+    return;
+  }
+
   const auto saved = mRenderTarget.bindAndReset();
   mpRenderer->clear();
 }
@@ -264,44 +355,112 @@ void UpscalingBuffer::present(
   const bool isWidescreenFrame,
   const bool perElementUpscaling)
 {
+  RIGEL_TRACE_ZONE("UpscalingBuffer::present");
+
   using UF = data::UpscalingFilter;
 
-  // We use OpenGL's blending here instead of the renderer's color modulation,
-  // because we don't need to implement the modulation feature in our custom
-  // sharp bilinear shader if we do it that way.
-  glBlendFunc(GL_CONSTANT_ALPHA, GL_ONE_MINUS_CONSTANT_ALPHA);
-  glBlendColor(0.0f, 0.0f, 0.0f, std::clamp(mAlphaMod / 255.0f, 0.0f, 1.0f));
-  auto blendFuncGuard =
-    base::defer([]() { glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA); });
+  if (mRenderingDirectly && !mDirectFrameCopied)
+  {
+    // The frame is already in the back buffer. Drawing it with an alpha
+    // modulation needs a copy of it, though.
+    if (mAlphaMod == 255)
+    {
+      return;
+    }
+
+    copyDirectlyRenderedFrame();
+  }
+
+  auto blendFuncGuard = useConstantAlphaBlending(mAlphaMod);
 
   if (perElementUpscaling)
   {
+    const auto fullSize = mRenderTarget.extents();
+    const auto renderedSize =
+      scaledRenderSize(fullSize, mActiveResolutionScale);
+
     mpRenderer->clear();
-    mRenderTarget.render(0, 0);
+    mRenderTarget.render({{}, renderedSize}, {{}, fullSize});
     mpRenderer->submitBatch();
     return;
   }
 
-  const auto windowWidth = float(mpRenderer->windowSize().width);
-  const auto windowHeight = float(mpRenderer->windowSize().height);
+  const auto& plan = presentPlan(isWidescreenFrame);
 
-  auto setUpViewport = [&](
-                         const int textureWidth,
-                         const int textureHeight,
-                         const base::Vec2f& scale) {
-    const auto usableWidth = textureWidth * scale.x;
-    const auto usableHeight = textureHeight * scale.y;
-    const auto offsetX = (windowWidth - usableWidth) / 2.0f;
-    const auto offsetY = (windowHeight - usableHeight) / 2.0f;
+  mpRenderer->clear();
 
-    mpRenderer->setGlobalTranslation({int(offsetX), int(offsetY)});
-    mpRenderer->setGlobalScale(scale);
-  };
+  auto saved = renderer::saveState(mpRenderer);
+  mpRenderer->setGlobalTranslation(plan.mTranslation);
+  mpRenderer->setGlobalScale(plan.mScale);
 
+  if (mFilter == UF::SharpBilinear)
+  {
+    drawWithCustomShader(
+      mpRenderer, mRenderTarget, {0, 0}, mSharpBilinearShader);
+  }
+  else
+  {
+    mRenderTarget.render(0, 0);
+  }
 
-  mpRenderer->clear();
+  mpRenderer->submitBatch();
+}
+
+
+void UpscalingBuffer::holdFrame()
+{
+  if (mRenderingDirectly && !mDirectFrameCopied)
+  {
+    copyDirectlyRenderedFrame();
+  }
+}
+
+
+void UpscalingBuffer::restoreFrame()
+{
+  if (!mRenderingDirectly || !mDirectFrameCopied)
+  {
+    return;
+  }
 
   auto saved = renderer::saveState(mpRenderer);
+  mpRenderer->resetState();
+
+  auto blendFuncGuard = useConstantAlphaBlending(255);
+  mpRenderer->clear();
+  mRenderTarget.render(0, 0);
+  mpRenderer->submitBatch();
+
+  mDirectFrameCopied = false;
+}
+
+
+auto UpscalingBuffer::presentPlan(const bool isWidescreenFrame)
+  -> const PresentPlan&
+{
+  if (mpRenderer->windowSize() != mPlannedWindowSize)
+  {
+    invalidatePresentPlans();
+    mPlannedWindowSize = mpRenderer->windowSize();
+  }
+
+  auto& maybePlan = mPresentPlans[isWidescreenFrame ? 1 : 0];
+  if (!maybePlan)
+  {
+    maybePlan = computePresentPlan(isWidescreenFrame);
+  }
+
+  return *maybePlan;
+}
+
+
+auto UpscalingBuffer::computePresentPlan(const bool isWidescreenFrame) const
+  -> PresentPlan
+{
+  using UF = data::UpscalingFilter;
+
+  const auto windowWidth = float(mpRenderer->windowSize().width);
+  const auto windowHeight = float(mpRenderer->windowSize().height);
 
   if (mFilter == UF::PixelPerfect)
   {
@@ -315,37 +474,54 @@ void UpscalingBuffer::present(
     const auto scale = mAspectRatioCorrection
       ? base::Vec2f{PIXEL_PERFECT_SCALE_X, PIXEL_PERFECT_SCALE_Y}
       : base::Vec2f{maxIntegerScaleFactor, maxIntegerScaleFactor};
-    setUpViewport(usedWidth, mRenderTarget.height(), scale);
-    mRenderTarget.render(0, 0);
+
+    const auto usableWidth = usedWidth * scale.x;
+    const auto usableHeight = mRenderTarget.height() * scale.y;
+    const auto offsetX = (windowWidth - usableWidth) / 2.0f;
+    const auto offsetY = (windowHeight - usableHeight) / 2.0f;
+
+    return {{int(offsetX), int(offsetY)}, scale};
   }
-  else
+
+  const auto info = renderer::determineViewport(mpRenderer);
+
+  if (isWidescreenFrame)
   {
-    const auto info = renderer::determineViewport(mpRenderer);
-    mpRenderer->setGlobalScale(info.mScale);
+    const auto offset =
+      renderer::determineWidescreenViewport(mpRenderer).mLeftPaddingPx;
+    return {{offset, 0}, info.mScale};
+  }
 
-    if (isWidescreenFrame)
-    {
-      const auto offset =
-        renderer::determineWidescreenViewport(mpRenderer).mLeftPaddingPx;
-      mpRenderer->setGlobalTranslation({offset, 0});
-    }
-    else
-    {
-      mpRenderer->setGlobalTranslation(info.mOffset);
-    }
+  return {info.mOffset, info.mScale};
+}
 
-    if (mFilter == UF::SharpBilinear)
-    {
-      drawWithCustomShader(
-        mpRenderer, mRenderTarget, {0, 0}, mSharpBilinearShader);
-    }
-    else
-    {
-      mRenderTarget.render(0, 0);
-    }
+
+void UpscalingBuffer::invalidatePresentPlans()
+{
+  for (auto& maybePlan : mPresentPlans)
+  {
+    maybePlan.reset();
   }
+}
 
-  mpRenderer->submitBatch();
+
+void UpscalingBuffer::copyDirectlyRenderedFrame()
+{
+  auto saved = renderer::saveState(mpRenderer);
+  mpRenderer->setRenderTarget(0);
+  mpRenderer->copyCurrentFramebufferToTexture(mRenderTarget.data());
+
+  mDirectFrameCopied = true;
+}
+
+
+void UpscalingBuffer::grabContentsAsync(
+  std::function<void(data::Image)> callback)
+{
+  holdFrame();
+
+  const auto saved = mRenderTarget.bind();
+  mpRenderer->grabCurrentFramebufferAsync(std::move(callback));
 }
 
 
@@ -357,9 +533,21 @@ void UpscalingBuffer::setAlphaMod(const std::uint8_t alphaMod)
 
 void UpscalingBuffer::updateConfiguration(const data::GameOptions& options)
 {
+  invalidatePresentPlans();
+  mDirectFrameCopied = false;
+
   mAspectRatioCorrection = options.mAspectRatioCorrectionEnabled;
+  mDynamicResolutionEnabled = options.mDynamicResolutionEnabled;
+
+  if (!mDynamicResolutionEnabled)
+  {
+    mDynamicResolution.reset();
+  }
 
-  mRenderTarget = createFullscreenRenderTarget(mpRenderer, options);
+  updateRenderTargetSize(
+    mRenderTarget,
+    mpRenderer,
+    fullscreenRenderTargetSize(mpRenderer, options));
 
   if (options.mPerElementUpscalingEnabled)
   {
@@ -385,10 +573,7 @@ void UpscalingBuffer::updateConfiguration(const data::GameOptions& options)
     }
   }
 
-  mpRenderer->setFilteringEnabled(
-    mRenderTarget.data(),
-    mFilter == data::UpscalingFilter::Bilinear ||
-      mFilter == data::UpscalingFilter::SharpBilinear);
+  applyFilteringMode();
 
   if (mFilter == data::UpscalingFilter::SharpBilinear)
   {
@@ -403,4 +588,33 @@ void UpscalingBuffer::updateConfiguration(const data::GameOptions& options)
   }
 }
 
+
+void UpscalingBuffer::updateDynamicResolution(
+  const std::optional<float> gpuTimeMs,
+  const float frameBudgetMs)
+{
+  if (mDynamicResolutionEnabled)
+  {
+    mDynamicResolution.update(gpuTimeMs, frameBudgetMs);
+  }
+}
+
+
+void UpscalingBuffer::resetDynamicResolution()
+{
+  mDynamicResolution.reset();
+}
+
+
+void UpscalingBuffer::applyFilteringMode()
+{
+  // A frame rendered at reduced resolution is always stretched bilinearly,
+  // independently of the configured filter.
+  mpRenderer->setFilteringEnabled(
+    mRenderTarget.data(),
+    mFilter == data::UpscalingFilter::Bilinear ||
+      mFilter == data::UpscalingFilter::SharpBilinear ||
+      mActiveResolutionScale < 1.0f);
+}
+
 } // namespace rigel::renderer
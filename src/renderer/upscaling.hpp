@@ -18,10 +18,14 @@
 
 #include "base/defer.hpp"
 #include "base/spatial_types.hpp"
+#include "base/image.hpp"
 #include "data/game_options.hpp"
+#include "renderer/dynamic_resolution.hpp"
 #include "renderer/shader.hpp"
 #include "renderer/texture.hpp"
 
+#include <array>
+#include <functional>
 #include <optional>
 
 namespace rigel::data
@@ -53,6 +57,14 @@ struct WidescreenViewportInfo
 
 ViewportInfo determineViewport(const Renderer* pRenderer);
 
+/** Smallest integer scale factor at which the original game resolution
+ * covers the viewport for the given output size
+ *
+ * Replacement images with a higher resolution than this can't show any
+ * additional detail, since they are scaled down when drawing.
+ */
+int determineMaxVisibleScale(const base::Size& outputSize);
+
 /** Returns true if wide-screen mode is feasible for the current window size.
  *
  * If the current window size has an aspect ratio that is less than 4:3, there
@@ -70,10 +82,28 @@ int determineLowResBufferWidth(
   const Renderer* pRenderer,
   const bool widescreenModeWanted);
 
+base::Size fullscreenRenderTargetSize(
+  const Renderer* pRenderer,
+  const data::GameOptions& options);
+
 RenderTargetTexture createFullscreenRenderTarget(
   Renderer* pRenderer,
   const data::GameOptions& options);
 
+/** Recreate the given render target if it doesn't have the wanted size
+ *
+ * While the window is being resized (see Renderer::isWindowResizing()),
+ * an existing render target is kept as is, so that dragging the window
+ * border doesn't recreate it on every frame. Callers are expected to call
+ * this again once resizing has stopped, e.g. by calling it every frame.
+ *
+ * Returns true if the render target was recreated.
+ */
+bool updateRenderTargetSize(
+  RenderTargetTexture& target,
+  Renderer* pRenderer,
+  const base::Size& wantedSize);
+
 base::Vec2 offsetTo4by3WithinWidescreen(
   Renderer* pRenderer,
   const data::GameOptions& options);
@@ -88,18 +118,77 @@ public:
   void clear();
   void present(bool currentFrameIsWidescreen, bool perElementUpscaling);
 
+  /** Keep a copy of the current frame for presenting it repeatedly
+   *
+   * With per-element upscaling, frames are drawn straight into the window's
+   * back buffer, since the buffer would otherwise hold a window-sized copy
+   * of it. Swapping buffers discards the back buffer's contents, though.
+   * Call this before a sequence of present() and swap calls showing the
+   * same frame, like a screen fade, and restoreFrame() afterwards to
+   * continue rendering on top of the frame.
+   */
+  void holdFrame();
+  void restoreFrame();
+
+  /** Read back the buffer's contents, without upscaling
+   *
+   * See Renderer::grabCurrentFramebufferAsync().
+   */
+  void grabContentsAsync(std::function<void(data::Image)> callback);
+
   std::uint8_t alphaMod() const { return mAlphaMod; }
 
   void setAlphaMod(std::uint8_t alphaMod);
   void updateConfiguration(const data::GameOptions& options);
 
+  /** Adapt the render resolution to the GPU load
+   *
+   * Only has an effect with per-element upscaling and dynamic resolution
+   * enabled in the options. Based on the given GPU time of the previous
+   * frame, the resolution used by subsequent calls to bindAndClear() is
+   * lowered or raised, see DynamicResolutionController. Passing
+   * std::nullopt keeps the current resolution.
+   */
+  void updateDynamicResolution(
+    std::optional<float> gpuTimeMs,
+    float frameBudgetMs);
+
+  /** Go back to rendering at full resolution */
+  void resetDynamicResolution();
+
+  float resolutionScale() const { return mDynamicResolution.scale(); }
+
 private:
+  // Everything needed to present a frame that only depends on the
+  // configuration and window size. Computed on first use, and recomputed
+  // after the window size changes or updateConfiguration() is called.
+  struct PresentPlan
+  {
+    base::Vec2 mTranslation;
+    base::Vec2f mScale;
+  };
+
+  const PresentPlan& presentPlan(bool isWidescreenFrame);
+  PresentPlan computePresentPlan(bool isWidescreenFrame) const;
+  void invalidatePresentPlans();
+  void copyDirectlyRenderedFrame();
+  void applyFilteringMode();
+
   RenderTargetTexture mRenderTarget;
   Shader mSharpBilinearShader;
   Renderer* mpRenderer;
   data::UpscalingFilter mFilter;
   bool mAspectRatioCorrection;
+  bool mDynamicResolutionEnabled;
   std::uint8_t mAlphaMod = 0;
+  bool mRenderingDirectly = false;
+  bool mDirectFrameCopied = false;
+  float mActiveResolutionScale = 1.0f;
+  DynamicResolutionController mDynamicResolution;
+
+  // Indexed by whether the frame is wide-screen
+  std::array<std::optional<PresentPlan>, 2> mPresentPlans;
+  base::Size mPlannedWindowSize;
 };
 
 } // namespace rigel::renderer
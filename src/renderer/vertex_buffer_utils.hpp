@@ -23,6 +23,9 @@ RIGEL_DISABLE_WARNINGS
 #include <glm/vec2.hpp>
 RIGEL_RESTORE_WARNINGS
 
+#include <algorithm>
+#include <cmath>
+
 
 namespace rigel::renderer
 {
@@ -49,4 +52,76 @@ inline QuadVertices createTexturedQuadVertices(
   // clang-format on
 }
 
+
+inline MultiTexturedQuadVertices createMultiTexturedQuadVertices(
+  const TexCoords& sourceRect,
+  const base::Rect<int>& destRect,
+  const int textureIndex)
+{
+  const auto left = float(destRect.topLeft.x);
+  const auto right = float(destRect.topLeft.x + destRect.size.width);
+  const auto top = float(destRect.topLeft.y);
+  const auto bottom = float(destRect.topLeft.y + destRect.size.height);
+  const auto index = float(textureIndex);
+
+  // clang-format off
+  return MultiTexturedQuadVertices{{
+    left,  bottom, sourceRect.left,  sourceRect.bottom, index,
+    left,  top,    sourceRect.left,  sourceRect.top,    index,
+    right, bottom, sourceRect.right, sourceRect.bottom, index,
+    right, top,    sourceRect.right, sourceRect.top,    index
+  }};
+  // clang-format on
+}
+
+
+inline std::uint16_t toNormalizedUint16(const float value)
+{
+  return std::uint16_t(std::lround(std::clamp(value, 0.0f, 1.0f) * 65535.0f));
+}
+
+
+inline CompactQuadVertices createCompactQuadVertices(
+  const TexCoords& sourceRect,
+  const base::Rect<int>& destRect,
+  const int parameter)
+{
+  const auto left = std::int16_t(destRect.topLeft.x);
+  const auto right = std::int16_t(destRect.topLeft.x + destRect.size.width);
+  const auto top = std::int16_t(destRect.topLeft.y);
+  const auto bottom = std::int16_t(destRect.topLeft.y + destRect.size.height);
+  const auto texLeft = toNormalizedUint16(sourceRect.left);
+  const auto texRight = toNormalizedUint16(sourceRect.right);
+  const auto texTop = toNormalizedUint16(sourceRect.top);
+  const auto texBottom = toNormalizedUint16(sourceRect.bottom);
+  const auto param = std::uint16_t(parameter);
+
+  // clang-format off
+  return CompactQuadVertices{{
+    {left,  bottom, texLeft,  texBottom, param, 0},
+    {left,  top,    texLeft,  texTop,    param, 0},
+    {right, bottom, texRight, texBottom, param, 0},
+    {right, top,    texRight, texTop,    param, 0}
+  }};
+  // clang-format on
+}
+
+
+inline QuadInstance createQuadInstance(
+  const TexCoords& sourceRect,
+  const base::Rect<int>& destRect,
+  const int textureIndex)
+{
+  return QuadInstance{
+    {float(destRect.topLeft.x),
+     float(destRect.topLeft.y),
+     float(destRect.size.width),
+     float(destRect.size.height),
+     sourceRect.left,
+     sourceRect.top,
+     sourceRect.right,
+     sourceRect.bottom,
+     float(textureIndex)}};
+}
+
 } // namespace rigel::renderer
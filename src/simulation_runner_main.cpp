@@ -0,0 +1,801 @@
+/* Copyright (C) 2022, Nikolai Wuttke. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Entry point of RigelSimulationRunner, a development tool which replays
+// many input recordings (see frontend/input_recording.hpp) concurrently
+// without any graphics or audio output. It reports the achieved tick rate,
+// peak memory usage and final state hash for each recording, which makes it
+// useful for performance measurements as well as regression testing of the
+// game logic.
+//
+// With --capture-dir, selected frames of each replay are additionally
+// rendered into a hidden window via an offscreen OpenGL context, and written
+// out as PNG images. With --reference-dir, they are compared against the
+// images from an earlier run instead, which allows checking rendering
+// changes for pixel equivalence. Set SDL_VIDEODRIVER=offscreen to render
+// without a display server.
+//
+// On POSIX systems, each recording is replayed in a forked child process.
+// This gives every job its own copy of all mutable state, so nothing needs to
+// be thread-safe, and it allows measuring the peak memory usage of each job
+// separately. The game's resources are loaded only once, before forking.
+// On other systems, the recordings are replayed one after another.
+
+#include "assets/png_image.hpp"
+#include "assets/resource_loader.hpp"
+#include "base/job_system.hpp"
+#include "base/warnings.hpp"
+#include "base/worker_thread.hpp"
+#include "data/game_traits.hpp"
+#include "frontend/headless_simulation.hpp"
+#include "frontend/input_recording.hpp"
+#include "game_logic_common/igame_world.hpp"
+#include "renderer/renderer.hpp"
+#include "renderer/upscaling.hpp"
+
+#include "platform.hpp"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <optional>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <SDL_main.h>
+
+RIGEL_DISABLE_WARNINGS
+#include <lyra/lyra.hpp>
+RIGEL_RESTORE_WARNINGS
+
+#if defined(__unix__) || defined(__APPLE__)
+  #define RIGEL_SIMULATION_RUNNER_USE_FORK 1
+
+  #include <sys/resource.h>
+  #include <sys/types.h>
+  #include <sys/wait.h>
+  #include <unistd.h>
+#endif
+
+
+using namespace rigel;
+
+
+namespace
+{
+
+// Keeps the result small enough to always fit into a pipe's buffer, so that
+// a child process can never block on writing it.
+constexpr auto MAX_MESSAGE_LENGTH = 2048u;
+
+// Reading back a frame takes a few frames' worth of buffer swaps to
+// complete, see renderer::AsyncReadbackQueue
+constexpr auto MAX_SWAPS_FOR_PENDING_READBACKS = 100;
+
+
+struct Job
+{
+  std::filesystem::path mRecordingPath;
+  InputRecording mRecording;
+};
+
+
+struct CaptureSettings
+{
+  std::filesystem::path mOutputPath;
+  std::filesystem::path mReferencePath;
+  int mInterval = 0;
+
+  /** Sorted */
+  std::vector<int> mUpdates;
+
+  bool enabled() const
+  {
+    return !mOutputPath.empty() || !mReferencePath.empty();
+  }
+
+  bool isCaptured(const int updateIndex) const
+  {
+    return (mInterval > 0 && (updateIndex + 1) % mInterval == 0) ||
+      std::binary_search(mUpdates.begin(), mUpdates.end(), updateIndex);
+  }
+};
+
+
+struct JobResult
+{
+  int mUpdatesRun = 0;
+  double mSeconds = 0.0;
+  std::optional<int> mFirstMismatchingUpdate;
+  game_logic::StateHash mFinalStateHash;
+  std::optional<long> mPeakMemoryKb;
+  int mFramesCaptured = 0;
+  int mFramesMismatched = 0;
+  bool mFailed = false;
+
+  /** Error or state mismatch description */
+  std::string mMessage;
+};
+
+
+std::string frameFileName(const int updateIndex)
+{
+  std::array<char, 32> nameBuffer;
+  std::snprintf(
+    nameBuffer.data(), nameBuffer.size(), "update_%06d.png", updateIndex);
+  return nameBuffer.data();
+}
+
+
+/** Renders selected updates of a replay, and writes or compares them
+ *
+ * Frames are rendered the same way as in the game with per-element
+ * upscaling disabled, i.e. into a low-resolution buffer of the original
+ * game's size. Reading back and writing/comparing images happens
+ * asynchronously, so that rendering doesn't stall. Unlike FrameRecorder,
+ * frames are never dropped.
+ */
+class FrameCapture
+{
+public:
+  FrameCapture(const CaptureSettings& settings, const std::string& jobName)
+    : mContext(data::GameTraits::viewportSize)
+    , mRenderer(mContext.window())
+    , mUpscalingBuffer(&mRenderer, data::GameOptions{})
+    , mpSettings(&settings)
+    , mOutputPath(
+        settings.mOutputPath.empty() ? settings.mOutputPath
+                                     : settings.mOutputPath / jobName)
+    , mReferencePath(
+        settings.mReferencePath.empty() ? settings.mReferencePath
+                                        : settings.mReferencePath / jobName)
+  {
+    if (!mOutputPath.empty())
+    {
+      std::filesystem::create_directories(mOutputPath);
+    }
+  }
+
+  renderer::Renderer* renderer() { return &mRenderer; }
+
+  void afterUpdate(game_logic::IGameWorld& world, const int updateIndex)
+  {
+    if (!mpSettings->isCaptured(updateIndex))
+    {
+      return;
+    }
+
+    {
+      const auto saved = mUpscalingBuffer.bindAndClear(false);
+      world.render();
+    }
+
+    ++mNumPendingReadbacks;
+    mUpscalingBuffer.grabContentsAsync(
+      [this, updateIndex](data::Image image) {
+        --mNumPendingReadbacks;
+        mWorker.submit([this, updateIndex, image = std::move(image)]() {
+          processImage(image, frameFileName(updateIndex));
+        });
+      });
+
+    mRenderer.swapBuffers();
+    ++mNumFramesCaptured;
+  }
+
+  /** Wait until all captured frames have been processed */
+  void finish(JobResult& result)
+  {
+    for (auto i = 0;
+         mNumPendingReadbacks > 0 && i < MAX_SWAPS_FOR_PENDING_READBACKS;
+         ++i)
+    {
+      mRenderer.swapBuffers();
+    }
+
+    mWorker.waitUntilIdle();
+
+    result.mFramesCaptured = mNumFramesCaptured - mNumPendingReadbacks;
+    result.mFramesMismatched = mNumFramesMismatched;
+
+    if (mNumPendingReadbacks > 0 || mNumFailedWrites > 0)
+    {
+      result.mFailed = true;
+      result.mMessage += "Failed to capture or write " +
+        std::to_string(mNumPendingReadbacks + mNumFailedWrites) + " frames\n";
+    }
+
+    if (!mFirstMismatch.empty())
+    {
+      result.mMessage += "Frames differ from reference, first: " +
+        mFirstMismatch + '\n';
+    }
+  }
+
+private:
+  // Runs on the worker thread
+  void processImage(const data::Image& image, const std::string& fileName)
+  {
+    if (!mOutputPath.empty() && !assets::savePng(mOutputPath / fileName, image))
+    {
+      ++mNumFailedWrites;
+    }
+
+    if (mReferencePath.empty())
+    {
+      return;
+    }
+
+    const auto oReference = assets::loadPng(mReferencePath / fileName);
+    const auto matches = oReference &&
+      oReference->width() == image.width() &&
+      oReference->height() == image.height() &&
+      oReference->pixelData() == image.pixelData();
+    if (!matches)
+    {
+      if (mNumFramesMismatched++ == 0)
+      {
+        mFirstMismatch = fileName;
+      }
+    }
+  }
+
+  platform::OffscreenGlContext mContext;
+  renderer::Renderer mRenderer;
+  renderer::UpscalingBuffer mUpscalingBuffer;
+  const CaptureSettings* mpSettings;
+  std::filesystem::path mOutputPath;
+  std::filesystem::path mReferencePath;
+  int mNumPendingReadbacks = 0;
+  int mNumFramesCaptured = 0;
+
+  // Written by the worker thread, read after waitUntilIdle()
+  std::atomic<int> mNumFailedWrites = 0;
+  int mNumFramesMismatched = 0;
+  std::string mFirstMismatch;
+
+  // Must come last, so that all outstanding tasks are finished before the
+  // state they use is destroyed
+  base::WorkerThread mWorker;
+};
+
+
+void runReplay(
+  const assets::ResourceLoader& resources,
+  const Job& job,
+  const CaptureSettings& capture,
+  JobResult& result)
+{
+  // The simulation must be destroyed before the renderer it uses, so the
+  // capture is created first.
+  auto oCapture = std::optional<FrameCapture>{};
+  if (capture.enabled())
+  {
+    oCapture.emplace(capture, job.mRecordingPath.stem().u8string());
+  }
+
+  auto simulation = HeadlessSimulation{
+    &resources, job.mRecording, oCapture ? oCapture->renderer() : nullptr};
+
+  auto afterUpdate = std::function<void(int)>{};
+  if (oCapture)
+  {
+    afterUpdate = [&](const int updateIndex) {
+      oCapture->afterUpdate(simulation.world(), updateIndex);
+    };
+  }
+
+  const auto startTime = std::chrono::steady_clock::now();
+  const auto replayResult =
+    replayInputs(job.mRecording, simulation.world(), false, afterUpdate);
+  const auto elapsed = std::chrono::steady_clock::now() - startTime;
+
+  result.mUpdatesRun = replayResult.mUpdatesRun;
+  result.mSeconds = std::chrono::duration<double>(elapsed).count();
+  result.mFirstMismatchingUpdate = replayResult.mFirstMismatchingUpdate;
+  result.mFinalStateHash = simulation.world().stateHash();
+  result.mMessage = replayResult.mMismatchReport;
+
+  if (oCapture)
+  {
+    oCapture->finish(result);
+  }
+}
+
+
+JobResult runJob(
+  const assets::ResourceLoader& resources,
+  const Job& job,
+  const CaptureSettings& capture)
+{
+  auto result = JobResult{};
+
+  try
+  {
+    runReplay(resources, job, capture, result);
+  }
+  catch (const std::exception& error)
+  {
+    result.mFailed = true;
+    result.mMessage = error.what();
+  }
+
+  return result;
+}
+
+
+#ifdef RIGEL_SIMULATION_RUNNER_USE_FORK
+
+std::string serialize(const JobResult& result)
+{
+  std::ostringstream stream;
+  stream << result.mUpdatesRun << ' ' << std::hexfloat << result.mSeconds
+         << std::dec << ' ' << result.mFirstMismatchingUpdate.value_or(-1)
+         << ' ' << result.mFinalStateHash.mPlayer << ' '
+         << result.mFinalStateHash.mActors << ' '
+         << result.mFinalStateHash.mMap << ' '
+         << result.mFinalStateHash.mGlobals << ' ' << result.mFramesCaptured
+         << ' ' << result.mFramesMismatched << ' ' << result.mFailed << '\n'
+         << result.mMessage.substr(0, MAX_MESSAGE_LENGTH);
+  return stream.str();
+}
+
+
+JobResult deserialize(const std::string& data)
+{
+  std::istringstream stream{data};
+
+  auto result = JobResult{};
+  auto firstMismatchingUpdate = -1;
+  stream >> result.mUpdatesRun;
+
+  // Reading hexfloat via operator>> isn't supported by all standard
+  // libraries, so use strtod instead.
+  auto secondsText = std::string{};
+  stream >> secondsText;
+  result.mSeconds = std::strtod(secondsText.c_str(), nullptr);
+
+  stream >> firstMismatchingUpdate >> result.mFinalStateHash.mPlayer >>
+    result.mFinalStateHash.mActors >> result.mFinalStateHash.mMap >>
+    result.mFinalStateHash.mGlobals >> result.mFramesCaptured >>
+    result.mFramesMismatched >> result.mFailed;
+
+  if (!stream)
+  {
+    throw std::runtime_error("Invalid result data from child process");
+  }
+
+  if (firstMismatchingUpdate >= 0)
+  {
+    result.mFirstMismatchingUpdate = firstMismatchingUpdate;
+  }
+
+  stream.ignore(1);
+  result.mMessage.assign(
+    std::istreambuf_iterator<char>{stream}, std::istreambuf_iterator<char>{});
+  return result;
+}
+
+
+void writeAll(const int fd, const std::string& data)
+{
+  auto pData = data.data();
+  auto remaining = data.size();
+
+  while (remaining > 0)
+  {
+    const auto bytesWritten = write(fd, pData, remaining);
+    if (bytesWritten <= 0)
+    {
+      return;
+    }
+
+    pData += bytesWritten;
+    remaining -= size_t(bytesWritten);
+  }
+}
+
+
+std::string readAll(const int fd)
+{
+  auto data = std::string{};
+  char buffer[512];
+
+  for (;;)
+  {
+    const auto bytesRead = read(fd, buffer, sizeof(buffer));
+    if (bytesRead <= 0)
+    {
+      return data;
+    }
+
+    data.append(buffer, size_t(bytesRead));
+  }
+}
+
+
+long peakMemoryKb(const rusage& usage)
+{
+  #ifdef __APPLE__
+  // macOS reports bytes, Linux kilobytes
+  return long(usage.ru_maxrss / 1024);
+  #else
+  return long(usage.ru_maxrss);
+  #endif
+}
+
+
+std::vector<JobResult> runJobs(
+  const assets::ResourceLoader& resources,
+  const std::vector<Job>& jobs,
+  const CaptureSettings& capture,
+  const int maxConcurrentJobs)
+{
+  struct RunningJob
+  {
+    pid_t mPid;
+    int mResultFd;
+    size_t mJobIndex;
+  };
+
+  auto results = std::vector<JobResult>(jobs.size());
+  auto runningJobs = std::vector<RunningJob>{};
+  auto nextJobIndex = size_t(0);
+
+  // Don't let children inherit unflushed output
+  std::cout.flush();
+  std::cerr.flush();
+
+  while (nextJobIndex < jobs.size() || !runningJobs.empty())
+  {
+    while (
+      nextJobIndex < jobs.size() &&
+      int(runningJobs.size()) < maxConcurrentJobs)
+    {
+      int fds[2];
+      if (pipe(fds) != 0)
+      {
+        throw std::runtime_error("Failed to create pipe");
+      }
+
+      const auto pid = fork();
+      if (pid < 0)
+      {
+        throw std::runtime_error("Failed to create child process");
+      }
+
+      if (pid == 0)
+      {
+        close(fds[0]);
+        writeAll(
+          fds[1], serialize(runJob(resources, jobs[nextJobIndex], capture)));
+        close(fds[1]);
+
+        // Skip static destructors and stream flushing, the parent process
+        // owns those.
+        _exit(0);
+      }
+
+      close(fds[1]);
+      runningJobs.push_back(RunningJob{pid, fds[0], nextJobIndex});
+      ++nextJobIndex;
+    }
+
+    int status = 0;
+    rusage usage{};
+    const auto pid = wait4(-1, &status, 0, &usage);
+    if (pid < 0)
+    {
+      throw std::runtime_error("Failed to wait for child process");
+    }
+
+    const auto iJob = std::find_if(
+      runningJobs.begin(), runningJobs.end(), [pid](const RunningJob& job) {
+        return job.mPid == pid;
+      });
+    if (iJob == runningJobs.end())
+    {
+      continue;
+    }
+
+    const auto data = readAll(iJob->mResultFd);
+    close(iJob->mResultFd);
+
+    auto& result = results[iJob->mJobIndex];
+    if (WIFEXITED(status) && WEXITSTATUS(status) == 0 && !data.empty())
+    {
+      result = deserialize(data);
+    }
+    else
+    {
+      result.mFailed = true;
+      result.mMessage = "Child process terminated abnormally";
+    }
+
+    result.mPeakMemoryKb = peakMemoryKb(usage);
+    runningJobs.erase(iJob);
+  }
+
+  return results;
+}
+
+#else
+
+std::vector<JobResult> runJobs(
+  const assets::ResourceLoader& resources,
+  const std::vector<Job>& jobs,
+  const CaptureSettings& capture,
+  int)
+{
+  auto results = std::vector<JobResult>{};
+  results.reserve(jobs.size());
+
+  for (const auto& job : jobs)
+  {
+    results.push_back(runJob(resources, job, capture));
+  }
+
+  return results;
+}
+
+#endif
+
+
+std::vector<int> parseUpdateList(const std::string& list)
+{
+  auto result = std::vector<int>{};
+  auto stream = std::istringstream{list};
+  auto entry = std::string{};
+
+  while (std::getline(stream, entry, ','))
+  {
+    std::size_t charsParsed = 0;
+    const auto value = std::stoi(entry, &charsParsed);
+    if (charsParsed != entry.size() || value < 0)
+    {
+      throw std::invalid_argument("Invalid update index: " + entry);
+    }
+
+    result.push_back(value);
+  }
+
+  std::sort(result.begin(), result.end());
+  return result;
+}
+
+
+std::string levelName(const data::GameSessionId& sessionId)
+{
+  return std::string{char('L' + sessionId.mEpisode)} +
+    std::to_string(sessionId.mLevel + 1);
+}
+
+
+std::string formatHash(const game_logic::StateHash& hash)
+{
+  std::ostringstream stream;
+  stream << std::hex << std::setfill('0') << std::setw(8) << hash.mPlayer
+         << std::setw(8) << hash.mActors << std::setw(8) << hash.mMap
+         << std::setw(8) << hash.mGlobals;
+  return stream.str();
+}
+
+
+std::string formatStatus(const JobResult& result)
+{
+  if (result.mFailed)
+  {
+    return "FAILED";
+  }
+
+  if (result.mFirstMismatchingUpdate)
+  {
+    return "DIVERGED@" + std::to_string(*result.mFirstMismatchingUpdate);
+  }
+
+  if (result.mFramesMismatched > 0)
+  {
+    return "FRAMES DIFFER (" + std::to_string(result.mFramesMismatched) + ")";
+  }
+
+  return "OK";
+}
+
+
+void printResults(
+  std::ostream& stream,
+  const std::vector<Job>& jobs,
+  const std::vector<JobResult>& results,
+  const double totalSeconds)
+{
+  // clang-format off
+  stream
+    << std::left
+    << std::setw(28) << "Recording"
+    << std::setw(7) << "Level"
+    << std::right
+    << std::setw(9) << "Ticks"
+    << std::setw(12) << "Ticks/s"
+    << std::setw(12) << "Peak MB"
+    << "  " << std::left
+    << std::setw(34) << "Final state hash"
+    << "Status\n";
+  // clang-format on
+
+  auto totalUpdates = 0ll;
+  auto totalFramesCaptured = 0;
+
+  for (auto i = 0u; i < jobs.size(); ++i)
+  {
+    const auto& job = jobs[i];
+    const auto& result = results[i];
+
+    const auto ticksPerSecond =
+      result.mSeconds > 0.0 ? result.mUpdatesRun / result.mSeconds : 0.0;
+    const auto peakMemory = result.mPeakMemoryKb
+      ? std::to_string(*result.mPeakMemoryKb / 1024)
+      : std::string{"n/a"};
+
+    // clang-format off
+    stream
+      << std::left
+      << std::setw(28) << job.mRecordingPath.filename().u8string()
+      << std::setw(7) << levelName(job.mRecording.mSessionId)
+      << std::right
+      << std::setw(9) << result.mUpdatesRun
+      << std::setw(12) << std::fixed << std::setprecision(0) << ticksPerSecond
+      << std::setw(12) << peakMemory
+      << "  " << std::left
+      << std::setw(34) << formatHash(result.mFinalStateHash)
+      << formatStatus(result) << '\n';
+    // clang-format on
+
+    if (!result.mMessage.empty())
+    {
+      stream << "  " << result.mMessage << '\n';
+    }
+
+    totalUpdates += result.mUpdatesRun;
+    totalFramesCaptured += result.mFramesCaptured;
+  }
+
+  stream << '\n'
+         << jobs.size() << " recordings, " << totalUpdates << " ticks in "
+         << std::setprecision(2) << totalSeconds << " s ("
+         << std::setprecision(0)
+         << (totalSeconds > 0.0 ? totalUpdates / totalSeconds : 0.0)
+         << " ticks/s overall)\n";
+
+  if (totalFramesCaptured > 0)
+  {
+    stream << totalFramesCaptured << " frames captured\n";
+  }
+}
+
+} // namespace
+
+
+int main(int argc, char** argv)
+{
+  auto showHelp = false;
+  auto gamePath = std::string{};
+  auto recordingPaths = std::vector<std::string>{};
+  auto captureDir = std::string{};
+  auto referenceDir = std::string{};
+  auto captureInterval = 0;
+  auto captureUpdates = std::string{};
+  auto maxConcurrentJobs =
+    std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+
+  // clang-format off
+  auto optionsParser = lyra::help(showHelp)
+    | lyra::opt(maxConcurrentJobs, "N")["-j"]["--jobs"]
+      .help("Number of recordings to replay concurrently")
+    | lyra::opt(captureDir, "directory")["--capture-dir"]
+      .help("Render selected frames, and write them to the given directory")
+    | lyra::opt(referenceDir, "directory")["--reference-dir"]
+      .help("Render selected frames, and compare them to images from an "
+        "earlier run with --capture-dir")
+    | lyra::opt(captureInterval, "N")["--capture-interval"]
+      .help("Capture the frame after every N-th update")
+    | lyra::opt(captureUpdates, "list")["--capture-updates"]
+      .help("Comma-separated list of update indices to capture frames for")
+    | lyra::arg(gamePath, "game path")
+      .help("Path to original game's installation")
+      .required()
+    | lyra::arg(recordingPaths, "recordings")
+      .help("Input recording files to replay")
+      .cardinality(1, 0)
+  ;
+  // clang-format on
+
+  const auto parseResult = optionsParser.parse({argc, argv});
+
+  if (showHelp)
+  {
+    std::cout << optionsParser << '\n';
+    return 0;
+  }
+
+  if (!parseResult || maxConcurrentJobs < 1)
+  {
+    std::cerr << "ERROR: " << parseResult.message() << "\n\n";
+    std::cerr << optionsParser << '\n';
+    return -1;
+  }
+
+  // Recordings are replayed in forked child processes, which only inherit
+  // the forking thread. Running jobs inline means that they never wait for
+  // worker threads, and also keeps the replays independent of scheduling.
+  base::JobSystem::instance().setDeterministic(true);
+
+  try
+  {
+    auto capture = CaptureSettings{};
+    capture.mOutputPath = std::filesystem::u8path(captureDir);
+    capture.mReferencePath = std::filesystem::u8path(referenceDir);
+    capture.mInterval = captureInterval;
+    capture.mUpdates = parseUpdateList(captureUpdates);
+
+    if (capture.enabled() && capture.mInterval <= 0 && capture.mUpdates.empty())
+    {
+      throw std::invalid_argument(
+        "--capture-interval or --capture-updates must be given when "
+        "capturing frames");
+    }
+
+    auto jobs = std::vector<Job>{};
+    for (const auto& path : recordingPaths)
+    {
+      const auto recordingPath = std::filesystem::u8path(path);
+      jobs.push_back(Job{recordingPath, loadInputRecording(recordingPath)});
+    }
+
+    const auto resources =
+      assets::ResourceLoader{std::filesystem::u8path(gamePath), false, {}};
+
+    const auto startTime = std::chrono::steady_clock::now();
+    const auto results = runJobs(resources, jobs, capture, maxConcurrentJobs);
+    const auto totalSeconds = std::chrono::duration<double>(
+                                std::chrono::steady_clock::now() - startTime)
+                                .count();
+
+    printResults(std::cout, jobs, results, totalSeconds);
+
+    const auto allSucceeded =
+      std::all_of(results.begin(), results.end(), [](const JobResult& r) {
+        return !r.mFailed && !r.mFirstMismatchingUpdate &&
+          r.mFramesMismatched == 0;
+      });
+    return allSucceeded ? 0 : 1;
+  }
+  catch (const std::exception& error)
+  {
+    std::cerr << "ERROR: " << error.what() << '\n';
+    return -2;
+  }
+}
@@ -0,0 +1,65 @@
+/* Copyright (C) 2022, Nikolai Wuttke. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "audio_stats_display.hpp"
+
+#include "base/math_utils.hpp"
+
+#include "utils.hpp"
+
+#include <imgui.h>
+
+#include <iomanip>
+#include <sstream>
+#include <string>
+
+
+namespace rigel::ui
+{
+
+void drawAudioStats(const audio::AudioStats& stats, const float y)
+{
+  const auto bufferDuration = stats.mSampleRate > 0
+    ? double(stats.mBufferSize) / stats.mSampleRate
+    : 0.0;
+
+  std::stringstream bufferReport;
+  // clang-format off
+  bufferReport
+    << "Audio: " << stats.mBufferSize << " frames @ " << stats.mSampleRate
+    << " Hz (" << std::fixed << std::setprecision(2)
+    << bufferDuration * 1000.0 << " ms), "
+    << stats.mNumUnderruns << " underruns in "
+    << stats.mNumCallbacks << " callbacks";
+  // clang-format on
+
+  std::stringstream timingReport;
+  // clang-format off
+  timingReport
+    << std::fixed << std::setprecision(3)
+    << "Callback " << stats.mLastCallbackDuration * 1000.0
+    << " ms (worst " << stats.mWorstCallbackDuration * 1000.0
+    << " ms), worst music " << stats.mWorstMusicRenderTime * 1000.0
+    << " ms, worst mixer " << stats.mWorstMixerTime * 1000.0 << " ms";
+  // clang-format on
+
+  const auto lineHeight = base::round(ImGui::GetTextLineHeight());
+  const auto top = base::round(y);
+  drawText(bufferReport.str(), 0, top, {255, 255, 255, 255});
+  drawText(timingReport.str(), 0, top + lineHeight, {255, 255, 255, 255});
+}
+
+} // namespace rigel::ui
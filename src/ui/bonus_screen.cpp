@@ -20,7 +20,7 @@
 #include "engine/timing.hpp"
 #include "frontend/game_service_provider.hpp"
 #include "ui/menu_navigation.hpp"
-#include "ui/utils.hpp"
+#include "ui/ui_texture_cache.hpp"
 
 
 namespace rigel::ui
@@ -84,10 +84,7 @@ BonusScreen::BonusScreen(
   const std::set<data::Bonus>& achievedBonuses,
   int scoreBeforeAddingBonuses)
   : mState(scoreBeforeAddingBonuses)
-  , mBackgroundTexture(ui::fullScreenImageAsTexture(
-      context.mpRenderer,
-      *context.mpResources,
-      "BONUSSCN.MNI"))
+  , mpBackgroundTexture(&context.mpUiTextures->fullScreenImage("BONUSSCN.MNI"))
   , mpTextRenderer(context.mpUiRenderer)
 {
   engine::TimeDelta time = 0.0;
@@ -121,7 +118,7 @@ void BonusScreen::updateAndRender(engine::TimeDelta dt)
 {
   updateSequence(dt);
 
-  mBackgroundTexture.render(0, 0);
+  mpBackgroundTexture->render(0, 0);
   mpTextRenderer->drawBonusScreenText(6, 8, "SCORE");
   mpTextRenderer->drawBonusScreenText(6, 17, mState.mRunningText);
 
@@ -74,7 +74,7 @@ private:
   std::vector<Event> mEvents;
   std::size_t mNextEvent = 0;
 
-  renderer::Texture mBackgroundTexture;
+  const renderer::Texture* mpBackgroundTexture;
   ui::MenuElementRenderer* mpTextRenderer;
 };
 
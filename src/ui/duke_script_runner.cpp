@@ -26,8 +26,10 @@
 #include "engine/tiled_texture.hpp"
 #include "engine/timing.hpp"
 #include "frontend/game_service_provider.hpp"
+#include "ui/ui_texture_cache.hpp"
 #include "ui/utils.hpp"
 
+#include <algorithm>
 #include <cassert>
 
 
@@ -61,17 +63,21 @@ const auto INITIAL_GAME_SPEED = 3;
 
 constexpr auto START_DEMO_TIMEOUT = 30.0; // seconds
 
+constexpr auto MAX_CACHED_UI_SPRITE_SHEETS = 4u;
+
 } // namespace
 
 
 DukeScriptRunner::DukeScriptRunner(
   assets::ResourceLoader* pResourceLoader,
   renderer::Renderer* pRenderer,
+  UiTextureCache* pUiTextures,
   const data::SaveSlotArray* pSaveSlots,
   IGameServiceProvider* pServiceProvider)
   : mpResourceBundle(pResourceLoader)
   , mCurrentPalette(data::GameTraits::INGAME_PALETTE)
   , mpRenderer(pRenderer)
+  , mpUiTextures(pUiTextures)
   , mpSaveSlots(pSaveSlots)
   , mpServices(pServiceProvider)
   , mUiSpriteSheetRenderer(
@@ -443,9 +449,7 @@ void DukeScriptRunner::interpretNextAction()
       updatePalette(
         mpResourceBundle->loadPaletteFromFullScreenImage(showImage.image));
 
-      const auto imageTexture = fullScreenImageAsTexture(
-        mpRenderer, *mpResourceBundle, showImage.image);
-      imageTexture.render(0, 0);
+      mpUiTextures->fullScreenImage(showImage.image).render(0, 0);
     },
 
     [this](const Delay& delay) {
@@ -757,14 +761,38 @@ void DukeScriptRunner::drawCurrentKeyBindings()
 
 void DukeScriptRunner::updatePalette(const data::Palette16& palette)
 {
-  // TODO think about optimizing this maybe, to only update if actually
-  // changed, e.g. if (palette != mCurrentPalette) or maybe have a
-  // 'paletteSource' string (name of palette file or fullscreen image file),
-  // which can be compared to determine if update needed.
+  if (palette == mCurrentPalette)
+  {
+    return;
+  }
+
+  // The menu element renderer holds a pointer to mUiSpriteSheetRenderer,
+  // so we swap sprite sheets in and out of the cache instead of replacing
+  // the member object.
+  const auto iCached = std::find_if(
+    mCachedUiSpriteSheets.begin(),
+    mCachedUiSpriteSheets.end(),
+    [&](const auto& entry) { return entry.first == palette; });
+
+  if (iCached != mCachedUiSpriteSheets.end())
+  {
+    std::swap(iCached->second, mUiSpriteSheetRenderer);
+    iCached->first = mCurrentPalette;
+  }
+  else
+  {
+    if (mCachedUiSpriteSheets.size() == MAX_CACHED_UI_SPRITE_SHEETS)
+    {
+      mCachedUiSpriteSheets.erase(mCachedUiSpriteSheets.begin());
+    }
+
+    mCachedUiSpriteSheets.emplace_back(
+      mCurrentPalette, std::move(mUiSpriteSheetRenderer));
+    mUiSpriteSheetRenderer =
+      makeUiSpriteSheet(mpRenderer, *mpResourceBundle, palette);
+  }
 
   mCurrentPalette = palette;
-  mUiSpriteSheetRenderer =
-    makeUiSpriteSheet(mpRenderer, *mpResourceBundle, mCurrentPalette);
 }
 
 
@@ -29,6 +29,8 @@
 
 #include <cstddef>
 #include <optional>
+#include <utility>
+#include <vector>
 
 
 namespace rigel::ui
@@ -54,6 +56,7 @@ public:
   DukeScriptRunner(
     assets::ResourceLoader* pResourceLoader,
     renderer::Renderer* pRenderer,
+    UiTextureCache* pUiTextures,
     const data::SaveSlotArray* pSaveSlots,
     IGameServiceProvider* pServiceProvider);
 
@@ -212,9 +215,15 @@ private:
   const assets::ResourceLoader* mpResourceBundle;
   data::Palette16 mCurrentPalette;
   renderer::Renderer* mpRenderer;
+  UiTextureCache* mpUiTextures;
   const data::SaveSlotArray* mpSaveSlots;
   IGameServiceProvider* mpServices;
   engine::TiledTexture mUiSpriteSheetRenderer;
+
+  // Sprite sheets for recently used palettes, so that switching back and
+  // forth between palettes doesn't need to recreate the texture each time
+  std::vector<std::pair<data::Palette16, engine::TiledTexture>>
+    mCachedUiSpriteSheets;
   MenuElementRenderer mMenuElementRenderer;
 
   renderer::RenderTargetTexture mCanvas;
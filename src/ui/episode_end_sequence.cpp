@@ -21,7 +21,7 @@
 #include "engine/timing.hpp"
 #include "frontend/game_service_provider.hpp"
 #include "ui/menu_navigation.hpp"
-#include "ui/utils.hpp"
+#include "ui/ui_texture_cache.hpp"
 
 
 namespace rigel::ui
@@ -52,13 +52,12 @@ constexpr const char* EPISODE_4_END_IMAGES[] = {
 };
 
 
-std::vector<renderer::Texture>
+std::vector<const renderer::Texture*>
   loadImagesForEpisode(GameMode::Context context, const int episode)
 {
   auto createTextures = [&context](const auto& imageFilenames) {
     return utils::transformed(imageFilenames, [&](const char* imageFilename) {
-      return ui::fullScreenImageAsTexture(
-        context.mpRenderer, *context.mpResources, imageFilename);
+      return &context.mpUiTextures->fullScreenImage(imageFilename);
     });
   };
 
@@ -86,7 +85,7 @@ EpisodeEndScreen::EpisodeEndScreen(GameMode::Context context, const int episode)
 void EpisodeEndScreen::updateAndRender(engine::TimeDelta dt)
 {
   const auto index = std::min(mCurrentImage, mScreenImages.size());
-  mScreenImages[index].render(0, 0);
+  mScreenImages[index]->render(0, 0);
 }
 
 
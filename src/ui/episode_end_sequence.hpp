@@ -39,7 +39,7 @@ public:
   bool finished() const;
 
 private:
-  std::vector<renderer::Texture> mScreenImages;
+  std::vector<const renderer::Texture*> mScreenImages;
   std::size_t mCurrentImage = 0;
   IGameServiceProvider* mpServiceProvider;
 };
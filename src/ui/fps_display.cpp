@@ -17,10 +17,18 @@
 #include "fps_display.hpp"
 
 #include "base/math_utils.hpp"
+#include "base/warnings.hpp"
 
 #include "utils.hpp"
 
+RIGEL_DISABLE_WARNINGS
+#include <imgui.h>
+RIGEL_RESTORE_WARNINGS
+
+#include <algorithm>
+#include <cmath>
 #include <iomanip>
+#include <ostream>
 #include <sstream>
 #include <string>
 
@@ -34,10 +42,106 @@ namespace
 const auto PRE_FILTER_WEIGHT = 0.7f;
 const auto FILTER_WEIGHT = 0.9f;
 
+// Frame time shown at the top of the graph. Longer frames are cut off.
+constexpr auto GRAPH_RANGE = 1.0 / 30.0;
+constexpr auto GRAPH_BAR_WIDTH = 2.0f;
+constexpr auto GRAPH_HEIGHT_IN_LINES = 4.0f;
+
+const auto TEXT_COLOR = base::Color{255, 255, 255, 255};
+const auto GRAPH_BACKGROUND_COLOR = base::Color{0, 0, 0, 160};
+const auto TARGET_LINE_COLOR = base::Color{255, 255, 0, 200};
+
+// Colors for the parts of a frame in the graph, in the order they are
+// stacked. The remaining time of the frame is shown in gray.
+const auto LOGIC_COLOR = base::Color{80, 220, 80, 255};
+const auto RENDER_COLOR = base::Color{80, 140, 255, 255};
+const auto PRESENT_COLOR = base::Color{255, 160, 40, 255};
+const auto OTHER_COLOR = base::Color{140, 140, 140, 255};
+
+constexpr const char* PART_NAMES[] = {"Frame", "Logic", "Render", "Present"};
+
+
+void printMilliseconds(std::ostream& stream, const engine::TimeDelta time)
+{
+  stream << std::setw(6) << std::fixed << std::setprecision(2)
+         << time * 1000.0;
+}
+
 } // namespace
 
 
-void FpsDisplay::updateAndRender(const engine::TimeDelta totalElapsed)
+void FrameTimeHistogram::add(const engine::TimeDelta time)
+{
+  const auto bucket =
+    std::min(static_cast<int>(time / BUCKET_SIZE), NUM_BUCKETS);
+  ++mBuckets[std::max(bucket, 0)];
+  ++mCount;
+  mMax = std::max(mMax, time);
+}
+
+
+engine::TimeDelta FrameTimeHistogram::percentile(const double fraction) const
+{
+  if (mCount == 0)
+  {
+    return 0;
+  }
+
+  const auto targetCount =
+    std::max(1.0, std::ceil(static_cast<double>(mCount) * fraction));
+
+  auto countSoFar = 0.0;
+  for (auto i = 0; i < NUM_BUCKETS; ++i)
+  {
+    countSoFar += mBuckets[i];
+    if (countSoFar >= targetCount)
+    {
+      return std::min((i + 1) * BUCKET_SIZE, mMax);
+    }
+  }
+
+  return mMax;
+}
+
+
+void FrameTimeHistogram::write(std::ostream& stream) const
+{
+  stream << "{\"count\": " << mCount << ", \"p50\": " << percentile(0.5)
+         << ", \"p95\": " << percentile(0.95)
+         << ", \"p99\": " << percentile(0.99) << ", \"max\": " << mMax
+         << ", \"bucketSize\": " << BUCKET_SIZE << ", \"buckets\": [";
+
+  for (auto i = 0u; i < mBuckets.size(); ++i)
+  {
+    if (i != 0)
+    {
+      stream << ", ";
+    }
+
+    stream << mBuckets[i];
+  }
+
+  stream << "]}";
+}
+
+
+void FpsDisplay::addFrame(const FrameTimes& times)
+{
+  mHistograms[Total].add(times.mTotal);
+  mHistograms[Logic].add(times.mLogic);
+  mHistograms[Render].add(times.mRender);
+  mHistograms[Present].add(times.mPresent);
+
+  mRecentFrames[mNextFrameIndex] = times;
+  mNextFrameIndex = (mNextFrameIndex + 1) % NUM_GRAPH_FRAMES;
+  mNumRecentFrames = std::min(mNumRecentFrames + 1, NUM_GRAPH_FRAMES);
+}
+
+
+float FpsDisplay::updateAndRender(
+  const engine::TimeDelta totalElapsed,
+  const std::optional<renderer::FramePacingStats>& pacingStats,
+  const std::optional<renderer::FrameDelayStats>& frameDelayStats)
 {
   mPreFilteredFrameTime = base::lerp(
     static_cast<float>(totalElapsed), mPreFilteredFrameTime, PRE_FILTER_WEIGHT);
@@ -54,8 +158,128 @@ void FpsDisplay::updateAndRender(const engine::TimeDelta totalElapsed)
     << totalElapsed * 1000.0 << " ms";
   // clang-format on
 
-  const auto reportString = statsReport.str();
-  drawText(reportString, 0, 0, {255, 255, 255, 255});
+  if (pacingStats)
+  {
+    // clang-format off
+    statsReport
+      << " (target " << pacingStats->mTargetFrameTime * 1000.0
+      << " ms, avg " << pacingStats->mMeanFrameTime * 1000.0
+      << " ms, sd " << std::sqrt(pacingStats->mFrameTimeVariance) * 1000.0
+      << " ms)";
+    // clang-format on
+  }
+
+  const auto lineHeight = base::round(ImGui::GetTextLineHeight());
+  auto y = 0;
+
+  drawText(statsReport.str(), 0, y, TEXT_COLOR);
+  y += lineHeight;
+
+  if (frameDelayStats)
+  {
+    std::stringstream latencyReport;
+    latencyReport << "Frame delay";
+    printMilliseconds(latencyReport, frameDelayStats->mFrameDelay);
+    latencyReport << " ms, input latency ~";
+    printMilliseconds(latencyReport, frameDelayStats->mInputLatency);
+    latencyReport << " ms";
+
+    drawText(latencyReport.str(), 0, y, TEXT_COLOR);
+    y += lineHeight;
+  }
+
+  for (auto part = 0; part < NumParts; ++part)
+  {
+    const auto& histogram = mHistograms[part];
+
+    std::stringstream partReport;
+    partReport << std::left << std::setw(8) << PART_NAMES[part] << std::right
+               << "p50";
+    printMilliseconds(partReport, histogram.percentile(0.5));
+    partReport << "  p95";
+    printMilliseconds(partReport, histogram.percentile(0.95));
+    partReport << "  p99";
+    printMilliseconds(partReport, histogram.percentile(0.99));
+    partReport << "  max";
+    printMilliseconds(partReport, histogram.max());
+    partReport << " ms";
+
+    drawText(partReport.str(), 0, y, TEXT_COLOR);
+    y += lineHeight;
+  }
+
+  // Graph of recent frames, oldest on the left
+  const auto graphTop = static_cast<float>(y);
+  const auto graphHeight = GRAPH_HEIGHT_IN_LINES * lineHeight;
+  const auto graphBottom = graphTop + graphHeight;
+  const auto graphWidth = NUM_GRAPH_FRAMES * GRAPH_BAR_WIDTH;
+
+  auto toHeight = [&](const engine::TimeDelta time) {
+    return static_cast<float>(std::min(time / GRAPH_RANGE, 1.0)) *
+      graphHeight;
+  };
+
+  auto pDrawList = ImGui::GetForegroundDrawList();
+  pDrawList->AddRectFilled(
+    {0.0f, graphTop},
+    {graphWidth, graphBottom},
+    toImgui(GRAPH_BACKGROUND_COLOR));
+
+  const auto firstFrameIndex =
+    (mNextFrameIndex + NUM_GRAPH_FRAMES - mNumRecentFrames) %
+    NUM_GRAPH_FRAMES;
+  for (auto i = 0u; i < mNumRecentFrames; ++i)
+  {
+    const auto& frame =
+      mRecentFrames[(firstFrameIndex + i) % NUM_GRAPH_FRAMES];
+    const auto left =
+      (NUM_GRAPH_FRAMES - mNumRecentFrames + i) * GRAPH_BAR_WIDTH;
+
+    auto drawSegment = [&](
+                         const engine::TimeDelta start,
+                         const engine::TimeDelta end,
+                         const base::Color& color) {
+      if (end > start)
+      {
+        pDrawList->AddRectFilled(
+          {left, graphBottom - toHeight(end)},
+          {left + GRAPH_BAR_WIDTH, graphBottom - toHeight(start)},
+          toImgui(color));
+      }
+    };
+
+    const auto logicEnd = frame.mLogic;
+    const auto renderEnd = logicEnd + frame.mRender;
+    const auto presentEnd = renderEnd + frame.mPresent;
+    drawSegment(0, logicEnd, LOGIC_COLOR);
+    drawSegment(logicEnd, renderEnd, RENDER_COLOR);
+    drawSegment(renderEnd, presentEnd, PRESENT_COLOR);
+    drawSegment(presentEnd, frame.mTotal, OTHER_COLOR);
+  }
+
+  if (pacingStats)
+  {
+    const auto targetY = graphBottom - toHeight(pacingStats->mTargetFrameTime);
+    pDrawList->AddLine(
+      {0.0f, targetY}, {graphWidth, targetY}, toImgui(TARGET_LINE_COLOR));
+  }
+
+  return graphBottom;
+}
+
+
+void FpsDisplay::writeStatistics(std::ostream& stream) const
+{
+  stream << "{\n";
+
+  for (auto part = 0; part < NumParts; ++part)
+  {
+    stream << "  \"" << PART_NAMES[part] << "\": ";
+    mHistograms[part].write(stream);
+    stream << (part + 1 < NumParts ? ",\n" : "\n");
+  }
+
+  stream << "}\n";
 }
 
 } // namespace rigel::ui
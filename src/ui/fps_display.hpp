@@ -17,18 +17,104 @@
 #pragma once
 
 #include "engine/timing.hpp"
+#include "renderer/fps_limiter.hpp"
+#include "renderer/frame_delay_scheduler.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <optional>
 
 
 namespace rigel::ui
 {
 
+/** Where the time went during a single frame, in seconds
+ *
+ * The total also includes time not covered by the other parts, like event
+ * handling and waiting for the next frame.
+ */
+struct FrameTimes
+{
+  engine::TimeDelta mTotal = 0;
+  engine::TimeDelta mLogic = 0;
+  engine::TimeDelta mRender = 0;
+  engine::TimeDelta mPresent = 0;
+};
+
+
+/** Distribution of frame times using fixed-size buckets
+ *
+ * Memory use and cost of adding a value are constant, so this can record
+ * any number of frames. Percentiles are accurate to the bucket size.
+ */
+class FrameTimeHistogram
+{
+public:
+  static constexpr auto BUCKET_SIZE = 0.00025;
+  static constexpr auto NUM_BUCKETS = 400;
+
+  void add(engine::TimeDelta time);
+
+  /** Approximate value below which the given fraction of times lie
+   *
+   * Returns the upper edge of the bucket containing the percentile. Times
+   * longer than the last bucket count towards the maximum.
+   */
+  engine::TimeDelta percentile(double fraction) const;
+
+  engine::TimeDelta max() const { return mMax; }
+  std::uint32_t count() const { return mCount; }
+
+  /** Write the histogram as a JSON object */
+  void write(std::ostream& stream) const;
+
+private:
+  std::array<std::uint32_t, NUM_BUCKETS + 1> mBuckets{};
+  std::uint32_t mCount = 0;
+  engine::TimeDelta mMax = 0;
+};
+
+
+/** Shows frame rate and frame time statistics
+ *
+ * Besides the current frame rate, this shows percentiles of the frame time
+ * and its parts, and a graph of the most recent frames. Averages hide
+ * occasional long frames, which is what's perceived as stutter.
+ */
 class FpsDisplay
 {
 public:
-  void updateAndRender(engine::TimeDelta elapsed);
+  /** Record the times of a frame which has been completed */
+  void addFrame(const FrameTimes& times);
+
+  /** Draw the display, returns the height it takes up in pixels */
+  float updateAndRender(
+    engine::TimeDelta elapsed,
+    const std::optional<renderer::FramePacingStats>& pacingStats = {},
+    const std::optional<renderer::FrameDelayStats>& frameDelayStats = {});
 
+  /** Write histograms of all frames recorded so far as JSON */
+  void writeStatistics(std::ostream& stream) const;
 
 private:
+  static constexpr auto NUM_GRAPH_FRAMES = std::size_t{240};
+
+  enum Part
+  {
+    Total,
+    Logic,
+    Render,
+    Present,
+    NumParts
+  };
+
+  std::array<FrameTimeHistogram, NumParts> mHistograms;
+  std::array<FrameTimes, NUM_GRAPH_FRAMES> mRecentFrames;
+  std::size_t mNextFrameIndex = 0;
+  std::size_t mNumRecentFrames = 0;
+
   float mPreFilteredFrameTime = 0.0f;
   float mFilteredFrameTime = 0.0f;
 };
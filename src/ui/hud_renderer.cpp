@@ -92,6 +92,11 @@ constexpr auto RADAR_BLINK_START_COLOR_INDEX = 3;
 const auto RADAR_DOT_COLOR = data::GameTraits::INGAME_PALETTE[15];
 
 
+// Extra space around the cached HUD, so that parts which end up slightly
+// outside of the screen (e.g. due to screen shake) are still captured.
+constexpr auto HUD_CACHE_MARGIN = data::GameTraits::tileSize;
+
+
 constexpr auto OVERLAY_BACKGROUND_COLOR = []() {
   auto color = data::GameTraits::INGAME_PALETTE[1];
   color.a = 240;
@@ -284,6 +289,21 @@ void HudRenderer::updateAnimation()
 void HudRenderer::renderClassicHud(
   const data::PersistentPlayerState& persistentPlayerState,
   const base::ArrayView<base::Vec2> radarPositions)
+{
+  drawStaticParts(
+    data::WidescreenHudStyle::Classic,
+    GameTraits::viewportWidthPx,
+    persistentPlayerState,
+    [&]() { drawClassicHudStaticParts(persistentPlayerState); });
+
+  drawAnimatedHealthBar(
+    persistentPlayerState, {24, GameTraits::mapViewportSize.height + 1});
+  drawRadar(radarPositions, {RADAR_POS_X, RADAR_POS_Y});
+}
+
+
+void HudRenderer::drawClassicHudStaticParts(
+  const data::PersistentPlayerState& persistentPlayerState)
 {
   // We group drawing into what texture is used to minimize the amount of
   // OpenGL state switches needed.
@@ -330,8 +350,6 @@ void HudRenderer::renderClassicHud(
       {GameTraits::mapViewportSize.width + 2,
        GameTraits::mapViewportSize.height});
   }
-
-  drawRadar(radarPositions, {RADAR_POS_X, RADAR_POS_Y});
 }
 
 
@@ -373,6 +391,85 @@ void HudRenderer::renderWidescreenHud(
 }
 
 
+template <typename DrawFunc>
+void HudRenderer::drawStaticParts(
+  const data::WidescreenHudStyle style,
+  const int screenWidth,
+  const data::PersistentPlayerState& persistentPlayerState,
+  DrawFunc&& draw)
+{
+  // With per-element upscaling, the HUD is drawn at full window resolution,
+  // and possibly using high-resolution replacement sprites. A low-res cache
+  // would lose that detail, so we draw directly in that case.
+  if (mpOptions->mPerElementUpscalingEnabled)
+  {
+    draw();
+    return;
+  }
+
+  if (!isCacheUpToDate(style, screenWidth, persistentPlayerState))
+  {
+    const auto cacheWidth = screenWidth + HUD_CACHE_MARGIN * 2;
+    if (mHudCache.width() != cacheWidth)
+    {
+      mHudCache = renderer::RenderTargetTexture{
+        mpRenderer,
+        cacheWidth,
+        GameTraits::viewportHeightPx + HUD_CACHE_MARGIN * 2};
+    }
+
+    {
+      const auto saved = mHudCache.bindAndReset();
+      mpRenderer->clear({0, 0, 0, 0});
+      renderer::setLocalTranslation(
+        mpRenderer, {HUD_CACHE_MARGIN, HUD_CACHE_MARGIN});
+
+      draw();
+    }
+
+    mCachedHudState = CachedHudState{
+      style,
+      screenWidth,
+      persistentPlayerState.score(),
+      persistentPlayerState.weapon(),
+      persistentPlayerState.ammo(),
+      persistentPlayerState.currentMaxAmmo(),
+      persistentPlayerState.health(),
+      persistentPlayerState.inventory(),
+      persistentPlayerState.collectedLetters()};
+  }
+
+  mHudCache.render(-HUD_CACHE_MARGIN, -HUD_CACHE_MARGIN);
+}
+
+
+bool HudRenderer::isCacheUpToDate(
+  const data::WidescreenHudStyle style,
+  const int screenWidth,
+  const data::PersistentPlayerState& persistentPlayerState) const
+{
+  if (!mCachedHudState)
+  {
+    return false;
+  }
+
+  const auto& cached = *mCachedHudState;
+
+  // clang-format off
+  return
+    cached.mStyle == style &&
+    cached.mScreenWidth == screenWidth &&
+    cached.mScore == persistentPlayerState.score() &&
+    cached.mWeapon == persistentPlayerState.weapon() &&
+    cached.mAmmo == persistentPlayerState.ammo() &&
+    cached.mMaxAmmo == persistentPlayerState.currentMaxAmmo() &&
+    cached.mHealth == persistentPlayerState.health() &&
+    cached.mInventory == persistentPlayerState.inventory() &&
+    cached.mCollectedLetters == persistentPlayerState.collectedLetters();
+  // clang-format on
+}
+
+
 void HudRenderer::drawModernHud(
   int viewportWidth,
   const data::PersistentPlayerState& persistentPlayerState,
@@ -403,46 +500,61 @@ void HudRenderer::drawModernHud(
     drawRadar(radarPositions, {radarPosX, 20});
   }
 
-  // HUD frame
-  const auto hudStartY =
-    data::tilesToPixels(data::GameTraits::mapViewportHeightTiles);
-
-  mWideHudFrameTexture.render(
-    paddingForCentering, data::tilesToPixels(HUD_START_BOTTOM_LEFT.y));
-  drawWideHudFrameExtensions(mWideHudFrameTexture, screenWidth, hudStartY);
+  // The floating parts above use a translucent background, so they can't be
+  // cached - blending them into the cache would apply their alpha twice.
+  drawStaticParts(
+    data::WidescreenHudStyle::Modern,
+    screenWidth,
+    persistentPlayerState,
+    [&]() {
+      // HUD frame
+      const auto hudStartY =
+        data::tilesToPixels(data::GameTraits::mapViewportHeightTiles);
+
+      mWideHudFrameTexture.render(
+        paddingForCentering, data::tilesToPixels(HUD_START_BOTTOM_LEFT.y));
+      drawWideHudFrameExtensions(
+        mWideHudFrameTexture, screenWidth, hudStartY);
+
+      // Contents of HUD frame
+      // These all use the UI sprite sheet texture.
+      auto guard = renderer::saveState(mpRenderer);
+      renderer::setLocalTranslation(
+        mpRenderer, {paddingForCentering + 29, 0});
+
+      drawCollectedLetters(persistentPlayerState, {33, -23});
+
+      drawScore(
+        persistentPlayerState.score(),
+        *mpStatusSpriteSheetRenderer,
+        {2, GameTraits::mapViewportSize.height + 1});
+      drawWeaponIcon(
+        persistentPlayerState.weapon(),
+        *mpStatusSpriteSheetRenderer,
+        {17, GameTraits::mapViewportSize.height + 1});
+      drawAmmoBar(
+        persistentPlayerState.ammo(),
+        persistentPlayerState.currentMaxAmmo(),
+        *mpStatusSpriteSheetRenderer,
+        {22, GameTraits::mapViewportSize.height + 1});
+      drawHealthBar(
+        persistentPlayerState, {24, GameTraits::mapViewportSize.height + 1});
+
+      if (mLevelNumber)
+      {
+        renderer::setLocalTranslation(mpRenderer, {4, 2});
+        drawLevelNumber(
+          *mLevelNumber,
+          *mpStatusSpriteSheetRenderer,
+          {GameTraits::mapViewportSize.width + 2,
+           GameTraits::mapViewportSize.height + 1});
+      }
+    });
 
-  // Contents of HUD frame
-  // These all use the UI sprite sheet texture.
   auto guard = renderer::saveState(mpRenderer);
   renderer::setLocalTranslation(mpRenderer, {paddingForCentering + 29, 0});
-
-  drawCollectedLetters(persistentPlayerState, {33, -23});
-
-  drawScore(
-    persistentPlayerState.score(),
-    *mpStatusSpriteSheetRenderer,
-    {2, GameTraits::mapViewportSize.height + 1});
-  drawWeaponIcon(
-    persistentPlayerState.weapon(),
-    *mpStatusSpriteSheetRenderer,
-    {17, GameTraits::mapViewportSize.height + 1});
-  drawAmmoBar(
-    persistentPlayerState.ammo(),
-    persistentPlayerState.currentMaxAmmo(),
-    *mpStatusSpriteSheetRenderer,
-    {22, GameTraits::mapViewportSize.height + 1});
-  drawHealthBar(
+  drawAnimatedHealthBar(
     persistentPlayerState, {24, GameTraits::mapViewportSize.height + 1});
-
-  if (mLevelNumber)
-  {
-    renderer::setLocalTranslation(mpRenderer, {4, 2});
-    drawLevelNumber(
-      *mLevelNumber,
-      *mpStatusSpriteSheetRenderer,
-      {GameTraits::mapViewportSize.width + 2,
-       GameTraits::mapViewportSize.height + 1});
-  }
 }
 
 
@@ -459,44 +571,60 @@ void HudRenderer::drawUltrawideHud(
   constexpr auto yPos = data::GameTraits::viewportHeightPx -
     data::GameTraits::inGameViewportOffset.y - assets::ULTRAWIDE_HUD_HEIGHT;
 
-  // HUD frame
-  mUltrawideHudFrameTexture.render(
-    paddingForCentering -
-      (assets::ULTRAWIDE_HUD_WIDTH - assets::ULTRAWIDE_HUD_INNER_WIDTH) / 2,
-    yPos);
-  drawWideHudFrameExtensions(mUltrawideHudFrameTexture, screenWidth, yPos);
-
-  // Contents of HUD frame
+  drawStaticParts(
+    data::WidescreenHudStyle::Ultrawide,
+    screenWidth,
+    persistentPlayerState,
+    [&]() {
+      // HUD frame
+      mUltrawideHudFrameTexture.render(
+        paddingForCentering -
+          (assets::ULTRAWIDE_HUD_WIDTH - assets::ULTRAWIDE_HUD_INNER_WIDTH) /
+            2,
+        yPos);
+      drawWideHudFrameExtensions(
+        mUltrawideHudFrameTexture, screenWidth, yPos);
+
+      // Contents of HUD frame
+
+      // These use the actor sprite sheet texture.
+      {
+        auto guard = renderer::saveState(mpRenderer);
+        renderer::setLocalTranslation(
+          mpRenderer, {paddingForCentering, yPos});
 
-  // These use the actor sprite sheet texture.
-  {
-    auto guard = renderer::saveState(mpRenderer);
-    renderer::setLocalTranslation(mpRenderer, {paddingForCentering, yPos});
+        drawInventory(persistentPlayerState.inventory(), {6, 15});
+        drawCollectedLetters(persistentPlayerState, {64, -138});
+      }
 
-    drawInventory(persistentPlayerState.inventory(), {6, 15});
-    drawCollectedLetters(persistentPlayerState, {64, -138});
-  }
+      auto guard = renderer::saveState(mpRenderer);
+      renderer::setLocalTranslation(
+        mpRenderer, {paddingForCentering, yPos - 2});
+
+      // These use the UI sprite sheet texture.
+      drawScore(
+        persistentPlayerState.score(), *mpStatusSpriteSheetRenderer, {12, 6});
+      drawWeaponIcon(
+        persistentPlayerState.weapon(),
+        *mpStatusSpriteSheetRenderer,
+        {27, 6});
+      drawAmmoBar(
+        persistentPlayerState.ammo(),
+        persistentPlayerState.currentMaxAmmo(),
+        *mpStatusSpriteSheetRenderer,
+        {32, 6});
+      drawHealthBar(persistentPlayerState, {34, 6});
+
+      if (mLevelNumber)
+      {
+        drawLevelNumber(*mLevelNumber, *mpStatusSpriteSheetRenderer, {44, 5});
+      }
+    });
 
   auto guard = renderer::saveState(mpRenderer);
   renderer::setLocalTranslation(mpRenderer, {paddingForCentering, yPos - 2});
 
-  // These use the UI sprite sheet texture.
-  drawScore(
-    persistentPlayerState.score(), *mpStatusSpriteSheetRenderer, {12, 6});
-  drawWeaponIcon(
-    persistentPlayerState.weapon(), *mpStatusSpriteSheetRenderer, {27, 6});
-  drawAmmoBar(
-    persistentPlayerState.ammo(),
-    persistentPlayerState.currentMaxAmmo(),
-    *mpStatusSpriteSheetRenderer,
-    {32, 6});
-  drawHealthBar(persistentPlayerState, {34, 6});
-
-  if (mLevelNumber)
-  {
-    drawLevelNumber(*mLevelNumber, *mpStatusSpriteSheetRenderer, {44, 5});
-  }
-
+  drawAnimatedHealthBar(persistentPlayerState, {34, 6});
   drawRadar(radarPositions, {385, 36});
 }
 
@@ -615,7 +743,8 @@ void HudRenderer::drawHealthBar(
   // animation
 
   // The model has a range of 1-9 for health, but the HUD shows only 8
-  // slices, with a special animation for having 1 point of health.
+  // slices, with a special animation for having 1 point of health. The
+  // animation is drawn by drawAnimatedHealthBar().
   const auto numFullSlices = persistentPlayerState.health() - 1;
   if (numFullSlices > 0)
   {
@@ -626,7 +755,15 @@ void HudRenderer::drawHealthBar(
         sliceIndex + 20 + 4 * 40, position + base::Vec2{i, 0});
     }
   }
-  else
+}
+
+
+void HudRenderer::drawAnimatedHealthBar(
+  const data::PersistentPlayerState& persistentPlayerState,
+  const base::Vec2& position) const
+{
+  const auto numFullSlices = persistentPlayerState.health() - 1;
+  if (numFullSlices <= 0)
   {
     const auto animationOffset = mElapsedFrames;
 
@@ -692,12 +829,14 @@ void HudRenderer::drawRadar(
   const base::Vec2& drawPosition) const
 {
   auto drawDots = [&]() {
+    mRadarDotPositions.clear();
     for (const auto& position : positions)
     {
-      const auto dotPosition = position + RADAR_CENTER_OFFSET_RELATIVE;
-      mpRenderer->drawPoint(dotPosition, RADAR_DOT_COLOR);
+      mRadarDotPositions.push_back(position + RADAR_CENTER_OFFSET_RELATIVE);
     }
 
+    mpRenderer->drawPoints(mRadarDotPositions, RADAR_DOT_COLOR);
+
     const auto blinkColorIndex =
       mElapsedFrames % NUM_RADAR_BLINK_STEPS + RADAR_BLINK_START_COLOR_INDEX;
     const auto blinkColor = data::GameTraits::INGAME_PALETTE[blinkColorIndex];
@@ -26,6 +26,7 @@
 #include <cstdint>
 #include <optional>
 #include <unordered_map>
+#include <vector>
 
 
 namespace rigel
@@ -106,6 +107,40 @@ public:
     base::ArrayView<base::Vec2> radarPositions);
 
 private:
+  /** Snapshot of everything that the cached (static) HUD parts depend on
+   *
+   * The HUD frame, score, weapon, ammo, health, inventory and collected
+   * letters only change on rare occasions, e.g. when picking up an item.
+   * Instead of redrawing them every frame, we render them into mHudCache
+   * and only rebuild that when any of the inputs captured here change.
+   * Radar dots and the health bar's "low health" animation change every
+   * frame, these are always drawn on top of the cache.
+   */
+  struct CachedHudState
+  {
+    data::WidescreenHudStyle mStyle;
+    int mScreenWidth;
+    int mScore;
+    data::WeaponType mWeapon;
+    int mAmmo;
+    int mMaxAmmo;
+    int mHealth;
+    std::vector<data::InventoryItemType> mInventory;
+    std::vector<data::CollectableLetterType> mCollectedLetters;
+  };
+
+  template <typename DrawFunc>
+  void drawStaticParts(
+    data::WidescreenHudStyle style,
+    int screenWidth,
+    const data::PersistentPlayerState& persistentPlayerState,
+    DrawFunc&& draw);
+  bool isCacheUpToDate(
+    data::WidescreenHudStyle style,
+    int screenWidth,
+    const data::PersistentPlayerState& persistentPlayerState) const;
+  void drawClassicHudStaticParts(
+    const data::PersistentPlayerState& persistentPlayerState);
   void drawModernHud(
     int viewportWidth,
     const data::PersistentPlayerState& persistentPlayerState,
@@ -124,6 +159,9 @@ private:
   void drawHealthBar(
     const data::PersistentPlayerState& persistentPlayerState,
     const base::Vec2& position) const;
+  void drawAnimatedHealthBar(
+    const data::PersistentPlayerState& persistentPlayerState,
+    const base::Vec2& position) const;
   void drawCollectedLetters(
     const data::PersistentPlayerState& persistentPlayerState,
     const base::Vec2& position) const;
@@ -143,6 +181,9 @@ private:
   engine::TiledTexture* mpStatusSpriteSheetRenderer;
   const engine::SpriteFactory* mpSpriteFactory;
   mutable renderer::RenderTargetTexture mRadarSurface;
+  renderer::RenderTargetTexture mHudCache;
+  std::optional<CachedHudState> mCachedHudState;
+  mutable std::vector<base::Vec2> mRadarDotPositions;
 };
 
 } // namespace ui
@@ -24,6 +24,7 @@
 #include "game_logic_common/igame_world.hpp"
 #include "renderer/upscaling.hpp"
 #include "renderer/viewport_utils.hpp"
+#include "ui/ui_texture_cache.hpp"
 #include "ui/utils.hpp"
 
 #include <sstream>
@@ -141,16 +142,11 @@ IngameMenu::TopLevelMenu::TopLevelMenu(
   const bool canQuickLoad)
   : mContext(context)
   , mPalette(context.mpResources->loadPaletteFromFullScreenImage("MESSAGE.MNI"))
-  , mUiSpriteSheet(
-      makeUiSpriteSheet(context.mpRenderer, *context.mpResources, mPalette))
   , mMenuElementRenderer(
-      &mUiSpriteSheet,
+      &context.mpUiTextures->uiSpriteSheet(mPalette),
       context.mpRenderer,
       *context.mpResources)
-  , mMenuBackground(fullScreenImageAsTexture(
-      context.mpRenderer,
-      *context.mpResources,
-      "MESSAGE.MNI"))
+  , mpMenuBackground(&context.mpUiTextures->fullScreenImage("MESSAGE.MNI"))
   , mTitleText(sessionIdString(sessionId, SessionIdStringType::Long))
   , mItems{
       itemIndex("Save Game"),
@@ -226,7 +222,7 @@ void IngameMenu::TopLevelMenu::handleEvent(const SDL_Event& event)
 void IngameMenu::TopLevelMenu::updateAndRender(const engine::TimeDelta dt)
 {
   mContext.mpRenderer->clear();
-  mMenuBackground.render(0, 0);
+  mpMenuBackground->render(0, 0);
 
   mMenuElementRenderer.drawBigText(
     MENU_TITLE_POS_X + (MENU_TITLE_MAX_LENGTH - int(mTitleText.size())) / 2,
@@ -102,9 +102,8 @@ private:
 
     GameMode::Context mContext;
     data::Palette16 mPalette;
-    engine::TiledTexture mUiSpriteSheet;
     MenuElementRenderer mMenuElementRenderer;
-    renderer::Texture mMenuBackground;
+    const renderer::Texture* mpMenuBackground;
     MenuNavigationHelper mNavigationHelper;
     std::string mTitleText;
     std::vector<int> mItems;
@@ -118,7 +118,7 @@ void IngameMessageDisplay::render()
 {
   if (!mPrintedMessage.empty())
   {
-    mpTextRenderer->drawSmallWhiteText(0, 0, mPrintedMessage);
+    mpTextRenderer->drawSmallWhiteText(0, 0, mPrintedMessage, mCachedText);
   }
 }
 
@@ -16,6 +16,8 @@
 
 #pragma once
 
+#include "ui/menu_element_renderer.hpp"
+
 #include <string>
 #include <variant>
 
@@ -23,10 +25,6 @@ namespace rigel
 {
 struct IGameServiceProvider;
 }
-namespace rigel::ui
-{
-class MenuElementRenderer;
-}
 
 
 namespace rigel::ui
@@ -101,6 +99,7 @@ private:
 
   MenuElementRenderer* mpTextRenderer;
   IGameServiceProvider* mpServiceProvider;
+  CachedText mCachedText;
 };
 
 } // namespace rigel::ui
@@ -26,7 +26,9 @@
 #include "renderer/viewport_utils.hpp"
 
 #include <cassert>
+#include <optional>
 #include <stdexcept>
+#include <utility>
 
 
 /* FONT FINDINGS
@@ -166,6 +168,68 @@ renderer::Texture
   return renderer::Texture{pRenderer, combinedBitmaps};
 }
 
+std::optional<int> menuFontIndex(const std::uint8_t ch)
+{
+  // clang-format off
+  if (ch < 62) {
+    return 21*40 + (ch - 22);
+  } else if (ch <= 90) {
+    return 22*40 + (ch - 62);
+  } else if (ch >= 97 && ch < 108) {
+    return 22*40 + (ch - 68);
+  } else if (ch >= 108 && ch <= 122) {
+    return 23*40 + 17 + (ch - 108);
+  }
+  // clang-format on
+
+  return std::nullopt;
+}
+
+
+std::optional<int> smallWhiteFontIndex(const std::uint8_t ch)
+{
+  // clang-format off
+  if (ch == 44) {
+    return 24*40 + 17 + 6;
+  } else if (ch == 46) {
+    return 24*40 + 17 + 7;
+  } else if (ch == 33) {
+    return 24*40 + 17 + 8;
+  } else if (ch == 63) {
+    return 24*40 + 17 + 9;
+  } else if (ch >= 65 && ch <= 84) {
+    return 6*40 + 20 + (ch - 65);
+  } else if (ch >= 85 && ch <= 90) {
+    return 24*40 + 17 + (ch - 85);
+  }
+  // clang-format on
+
+  return std::nullopt;
+}
+
+
+/** Invoke func(tileIndex, x, y) for each renderable character in text
+ *
+ * Characters that the font can't render are skipped, but still advance the
+ * position.
+ */
+template <typename FontIndexFunc, typename Func>
+void forEachGlyph(
+  const int x,
+  const int y,
+  std::string_view text,
+  FontIndexFunc fontIndex,
+  Func&& func)
+{
+  for (auto i = 0; i < int(text.size()); ++i)
+  {
+    if (const auto index = fontIndex(static_cast<std::uint8_t>(text[i])))
+    {
+      func(*index, x + i, y);
+    }
+  }
+}
+
 } // namespace
 
 
@@ -173,75 +237,104 @@ MenuElementRenderer::MenuElementRenderer(
   engine::TiledTexture* pSpriteSheet,
   renderer::Renderer* pRenderer,
   const assets::ResourceLoader& resources)
+  : MenuElementRenderer(pSpriteSheet, pRenderer, resources.loadFont())
+{
+}
+
+
+MenuElementRenderer::MenuElementRenderer(
+  engine::TiledTexture* pSpriteSheet,
+  renderer::Renderer* pRenderer,
+  const assets::FontData& font)
   : mpRenderer(pRenderer)
   , mpSpriteSheet(pSpriteSheet)
-  , mBigTextTexture(
-      createFontTexture(resources.loadFont(), pRenderer),
-      pRenderer)
+  , mBigTextTexture(createFontTexture(font, pRenderer), pRenderer)
 {
 }
 
 
-void MenuElementRenderer::drawText(int x, int y, std::string_view text) const
+CachedText::~CachedText()
 {
-  for (auto i = 0u; i < text.size(); ++i)
+  destroyBuffer();
+}
+
+
+CachedText::CachedText(CachedText&& other) noexcept
+  : mpRenderer(other.mpRenderer)
+  , mBuffer(std::exchange(other.mBuffer, renderer::INVALID_VERTEX_BUFFER_ID))
+  , mText(std::move(other.mText))
+  , mPosition(other.mPosition)
+  , mFont(other.mFont)
+  , mIsMultiLine(other.mIsMultiLine)
+  , mIsValid(std::exchange(other.mIsValid, false))
+{
+}
+
+
+CachedText& CachedText::operator=(CachedText&& other) noexcept
+{
+  if (this != &other)
   {
-    const auto ch = static_cast<uint8_t>(text[i]);
+    destroyBuffer();
+
+    mpRenderer = other.mpRenderer;
+    mBuffer = std::exchange(other.mBuffer, renderer::INVALID_VERTEX_BUFFER_ID);
+    mText = std::move(other.mText);
+    mPosition = other.mPosition;
+    mFont = other.mFont;
+    mIsMultiLine = other.mIsMultiLine;
+    mIsValid = std::exchange(other.mIsValid, false);
+  }
 
-    int spriteSheetIndex = 0;
+  return *this;
+}
 
-    // clang-format off
-    if (ch < 62) {
-      spriteSheetIndex = 21*40 + (ch - 22);
-    } else if (ch <= 90) {
-      spriteSheetIndex = 22*40 + (ch - 62);
-    } else if (ch >= 97 && ch < 108) {
-      spriteSheetIndex = 22*40 + (ch - 68);
-    } else if (ch >= 108 && ch <= 122) {
-      spriteSheetIndex = 23*40 + 17 + (ch - 108);
-    } else {
-      // Skip non-renderable chars
-      continue;
-    }
-    // clang-format on
 
-    mpSpriteSheet->renderTile(spriteSheetIndex, x + i, y);
+void CachedText::destroyBuffer()
+{
+  if (mBuffer != renderer::INVALID_VERTEX_BUFFER_ID)
+  {
+    mpRenderer->destroyVertexBuffer(mBuffer);
+    mBuffer = renderer::INVALID_VERTEX_BUFFER_ID;
   }
 }
 
 
+void MenuElementRenderer::drawText(int x, int y, std::string_view text) const
+{
+  forEachGlyph(
+    x,
+    y,
+    text,
+    menuFontIndex,
+    [&](const int index, const int gx, const int gy) {
+      mGlyphScratch.push_back({index, {gx, gy}});
+    });
+  flushGlyphs();
+}
+
+
+void MenuElementRenderer::flushGlyphs() const
+{
+  mpSpriteSheet->renderTiles(mGlyphScratch);
+  mGlyphScratch.clear();
+}
+
+
 void MenuElementRenderer::drawSmallWhiteText(
   int x,
   int y,
   std::string_view text) const
 {
-  for (auto i = 0u; i < text.size(); ++i)
-  {
-    const auto ch = static_cast<uint8_t>(text[i]);
-
-    int spriteSheetIndex = 0;
-
-    // clang-format off
-    if (ch == 44) {
-      spriteSheetIndex = 24*40 + 17 + 6;
-    } else if (ch == 46) {
-      spriteSheetIndex = 24*40 + 17 + 7;
-    } else if (ch == 33) {
-      spriteSheetIndex = 24*40 + 17 + 8;
-    } else if (ch == 63) {
-      spriteSheetIndex = 24*40 + 17 + 9;
-    } else if (ch >= 65 && ch <= 84) {
-      spriteSheetIndex = 6*40 + 20 + (ch - 65);
-    } else if (ch >= 85 && ch <= 90) {
-      spriteSheetIndex = 24*40 + 17 + (ch - 85);
-    } else {
-      // Skip non-renderable chars
-      continue;
-    }
-    // clang-format on
-
-    mpSpriteSheet->renderTile(spriteSheetIndex, x + i, y);
-  }
+  forEachGlyph(
+    x,
+    y,
+    text,
+    smallWhiteFontIndex,
+    [&](const int index, const int gx, const int gy) {
+      mGlyphScratch.push_back({index, {gx, gy}});
+    });
+  flushGlyphs();
 }
 
 
@@ -258,6 +351,101 @@ void MenuElementRenderer::drawMultiLineText(
 }
 
 
+void MenuElementRenderer::drawText(
+  const int x,
+  const int y,
+  std::string_view text,
+  CachedText& cache) const
+{
+  drawCached(x, y, text, CachedText::Font::Menu, false, cache);
+}
+
+
+void MenuElementRenderer::drawSmallWhiteText(
+  const int x,
+  const int y,
+  std::string_view text,
+  CachedText& cache) const
+{
+  drawCached(x, y, text, CachedText::Font::SmallWhite, false, cache);
+}
+
+
+void MenuElementRenderer::drawMultiLineText(
+  const int x,
+  const int y,
+  std::string_view text,
+  CachedText& cache) const
+{
+  drawCached(x, y, text, CachedText::Font::Menu, true, cache);
+}
+
+
+void MenuElementRenderer::drawCached(
+  const int x,
+  const int y,
+  std::string_view text,
+  const CachedText::Font font,
+  const bool isMultiLine,
+  CachedText& cache) const
+{
+  const auto position = base::Vec2{x, y};
+
+  if (
+    !cache.mIsValid || cache.mText != text || cache.mPosition != position ||
+    cache.mFont != font || cache.mIsMultiLine != isMultiLine)
+  {
+    cache.destroyBuffer();
+
+    std::vector<float> vertices;
+    auto addLine = [&](const int lineY, std::string_view line) {
+      forEachGlyph(
+        x,
+        lineY,
+        line,
+        font == CachedText::Font::Menu ? menuFontIndex : smallWhiteFontIndex,
+        [&](const int index, const int glyphX, const int glyphY) {
+          const auto quad =
+            mpSpriteSheet->generateVertices(index, glyphX, glyphY);
+          vertices.insert(vertices.end(), quad.begin(), quad.end());
+        });
+    };
+
+    if (isMultiLine)
+    {
+      const auto lines = strings::split(text, '\n');
+      for (int i = 0; i < int(lines.size()); ++i)
+      {
+        addLine(y + i, lines[i]);
+      }
+    }
+    else
+    {
+      addLine(y, text);
+    }
+
+    cache.mpRenderer = mpRenderer;
+    if (!vertices.empty())
+    {
+      cache.mBuffer = mpRenderer->createVertexBuffer(vertices);
+    }
+
+    cache.mText = text;
+    cache.mPosition = position;
+    cache.mFont = font;
+    cache.mIsMultiLine = isMultiLine;
+    cache.mIsValid = true;
+  }
+
+  if (cache.mBuffer != renderer::INVALID_VERTEX_BUFFER_ID)
+  {
+    mpRenderer->submitVertexBuffers(
+      base::ArrayView<renderer::VertexBufferId>{&cache.mBuffer, 1},
+      mpSpriteSheet->textureId());
+  }
+}
+
+
 void MenuElementRenderer::drawBigText(
   int x,
   int y,
@@ -16,6 +16,7 @@
 
 #pragma once
 
+#include "assets/actor_image_package.hpp"
 #include "assets/palette.hpp"
 #include "base/color.hpp"
 #include "base/warnings.hpp"
@@ -29,6 +30,7 @@ RIGEL_RESTORE_WARNINGS
 
 #include <optional>
 #include <string>
+#include <vector>
 
 
 namespace rigel::assets
@@ -40,6 +42,45 @@ class ResourceLoader;
 namespace rigel::ui
 {
 
+/** Retained vertex data for text drawn by MenuElementRenderer
+ *
+ * Passing a CachedText to one of MenuElementRenderer's text drawing
+ * functions lays out the text into a vertex buffer on first use, and then
+ * re-submits that buffer on subsequent calls. The buffer is only rebuilt if
+ * the text or position changes. Meant for text that stays the same for many
+ * frames, like menu labels or in-game messages.
+ */
+class CachedText
+{
+public:
+  CachedText() = default;
+  ~CachedText();
+
+  CachedText(CachedText&& other) noexcept;
+  CachedText& operator=(CachedText&& other) noexcept;
+  CachedText(const CachedText&) = delete;
+  CachedText& operator=(const CachedText&) = delete;
+
+private:
+  friend class MenuElementRenderer;
+
+  enum class Font
+  {
+    Menu,
+    SmallWhite
+  };
+
+  void destroyBuffer();
+
+  renderer::Renderer* mpRenderer = nullptr;
+  renderer::VertexBufferId mBuffer = renderer::INVALID_VERTEX_BUFFER_ID;
+  std::string mText;
+  base::Vec2 mPosition;
+  Font mFont = Font::Menu;
+  bool mIsMultiLine = false;
+  bool mIsValid = false;
+};
+
 
 class MenuElementRenderer
 {
@@ -48,6 +89,10 @@ public:
     engine::TiledTexture* pSpriteSheet,
     renderer::Renderer* pRenderer,
     const assets::ResourceLoader& resources);
+  MenuElementRenderer(
+    engine::TiledTexture* pSpriteSheet,
+    renderer::Renderer* pRenderer,
+    const assets::FontData& font);
 
   void drawText(int x, int y, std::string_view text) const;
   void drawSmallWhiteText(int x, int y, std::string_view text) const;
@@ -56,6 +101,20 @@ public:
     drawBigText(int x, int y, std::string_view text, const base::Color& color)
       const;
 
+  // Retained versions of the functions above, see CachedText
+  void
+    drawText(int x, int y, std::string_view text, CachedText& cache) const;
+  void drawSmallWhiteText(
+    int x,
+    int y,
+    std::string_view text,
+    CachedText& cache) const;
+  void drawMultiLineText(
+    int x,
+    int y,
+    std::string_view text,
+    CachedText& cache) const;
+
   void drawCheckBox(int x, int y, bool isChecked) const;
 
   void drawBonusScreenText(int x, int y, std::string_view text) const;
@@ -92,10 +151,19 @@ public:
 private:
   void drawTextEntryCursor(int x, int y, int state) const;
   void drawSelectionIndicator(int x, int y, int state) const;
+  void drawCached(
+    int x,
+    int y,
+    std::string_view text,
+    CachedText::Font font,
+    bool isMultiLine,
+    CachedText& cache) const;
+  void flushGlyphs() const;
 
   renderer::Renderer* mpRenderer;
   engine::TiledTexture* mpSpriteSheet;
   engine::TiledTexture mBigTextTexture;
+  mutable std::vector<engine::TilePlacement> mGlyphScratch;
 };
 
 } // namespace rigel::ui
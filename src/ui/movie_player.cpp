@@ -16,7 +16,6 @@
 
 #include "movie_player.hpp"
 
-#include "base/container_utils.hpp"
 #include "data/game_traits.hpp"
 #include "engine/timing.hpp"
 #include "utility"
@@ -32,8 +31,7 @@ using engine::fastTicksToTime;
 
 MoviePlayer::MoviePlayer(renderer::Renderer* pRenderer)
   : mpRenderer(pRenderer)
-  , mCanvas(
-      pRenderer,
+  , mCanvasPixels(
       data::GameTraits::viewportWidthPx,
       data::GameTraits::viewportHeightPx)
 {
@@ -48,18 +46,10 @@ void MoviePlayer::playMovie(
 {
   assert(frameDelayInFastTicks >= 1);
 
-  {
-    const auto saved = mCanvas.bindAndReset();
-
-    auto baseImage = renderer::Texture(mpRenderer, movie.mBaseImage);
-    baseImage.render(0, 0);
-  }
-
-  mAnimationFrames =
-    utils::transformed(movie.mFrames, [this](const auto& frame) {
-      auto texture = renderer::Texture(mpRenderer, frame.mReplacementImage);
-      return FrameData{std::move(texture), frame.mStartRow};
-    });
+  mpMovie = &movie;
+  mCanvasPixels = movie.mBaseImage;
+  mCanvas = renderer::Texture(mpRenderer, mCanvasPixels);
+  mLastAppliedFrame = -1;
 
   mFrameCallback = std::move(frameCallback);
   mCurrentFrame = 0;
@@ -88,7 +78,7 @@ void MoviePlayer::updateAndRender(const engine::TimeDelta timeDelta)
 
   auto invokeCallback = [&]() {
     const int frameNrIncludingFirstImage =
-      (mCurrentFrame + 1) % mAnimationFrames.size();
+      (mCurrentFrame + 1) % numFrames();
     invokeFrameCallbackIfPresent(frameNrIncludingFirstImage);
   };
 
@@ -107,7 +97,7 @@ void MoviePlayer::updateAndRender(const engine::TimeDelta timeDelta)
       // We render one frame less during the last repetition, since the first
       // (full) image is to be counted as if it was the first frame.
       const auto framesToRenderThisRepetition =
-        static_cast<int>(mAnimationFrames.size()) - (isLastRepetition ? 1 : 0);
+        numFrames() - (isLastRepetition ? 1 : 0);
       const auto isLastFrame =
         mCurrentFrame + 1 >= framesToRenderThisRepetition;
 
@@ -136,15 +126,15 @@ void MoviePlayer::updateAndRender(const engine::TimeDelta timeDelta)
     {
       // Repeat forever
       ++mCurrentFrame;
-      mCurrentFrame %= mAnimationFrames.size();
+      mCurrentFrame %= numFrames();
       invokeCallback();
     }
   }
 
+  if (mCurrentFrame != mLastAppliedFrame)
   {
-    const auto saved = mCanvas.bindAndReset();
-    const auto& frameData = mAnimationFrames[mCurrentFrame];
-    frameData.mImage.render(0, frameData.mStartRow);
+    applyFrame(mCurrentFrame);
+    mLastAppliedFrame = mCurrentFrame;
   }
 
   mCanvas.render(0, 0);
@@ -157,6 +147,50 @@ bool MoviePlayer::hasCompletedPlayback() const
 }
 
 
+int MoviePlayer::numFrames() const
+{
+  return static_cast<int>(mpMovie->mFrames.size());
+}
+
+
+void MoviePlayer::applyFrame(const int frameIndex)
+{
+  const auto& frame = mpMovie->mFrames[frameIndex];
+  const auto& image = frame.mReplacementImage;
+  if (image.width() == 0)
+  {
+    return;
+  }
+
+  // Compose the frame with the current canvas contents, and upload only the
+  // resulting area.
+  const auto canvasWidth = mCanvasPixels.width();
+  const auto& canvasPixels = mCanvasPixels.pixelData();
+  const auto& framePixels = image.pixelData();
+
+  data::PixelBuffer composedPixels;
+  composedPixels.reserve(framePixels.size());
+
+  for (auto row = 0u; row < image.height(); ++row)
+  {
+    for (auto col = 0u; col < image.width(); ++col)
+    {
+      const auto& framePixel = framePixels[col + row * image.width()];
+      const auto canvasOffset =
+        (frame.mPosition.x + col) + (frame.mPosition.y + row) * canvasWidth;
+      composedPixels.push_back(
+        framePixel.a != 0 ? framePixel : canvasPixels[canvasOffset]);
+    }
+  }
+
+  const auto composedImage =
+    data::Image(std::move(composedPixels), image.width(), image.height());
+  mCanvasPixels.insertImage(
+    frame.mPosition.x, frame.mPosition.y, composedImage);
+  mCanvas.updatePixels(frame.mPosition, composedImage);
+}
+
+
 void MoviePlayer::invokeFrameCallbackIfPresent(const int frameNumber)
 {
   if (mFrameCallback)
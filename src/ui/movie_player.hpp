@@ -39,6 +39,12 @@ public:
 
   explicit MoviePlayer(renderer::Renderer* pRenderer);
 
+  /** Start playing the given movie
+   *
+   * Each frame's changed area is uploaded to the canvas texture when the
+   * frame is shown. The movie is therefore referenced, not copied, and must
+   * stay alive until playback has completed or another movie is started.
+   */
   void playMovie(
     const data::Movie& movie,
     int frameDelayInFastTicks,
@@ -49,18 +55,19 @@ public:
   bool hasCompletedPlayback() const;
 
 private:
-  struct FrameData
-  {
-    renderer::Texture mImage;
-    int mStartRow;
-  };
-
+  int numFrames() const;
+  void applyFrame(int frameIndex);
   void invokeFrameCallbackIfPresent(int whichFrame);
 
 private:
   renderer::Renderer* mpRenderer;
-  renderer::RenderTargetTexture mCanvas;
-  std::vector<FrameData> mAnimationFrames;
+  const data::Movie* mpMovie = nullptr;
+
+  // CPU-side copy of the canvas texture's contents. Needed for composing
+  // frames, since their transparent pixels keep what's already there.
+  data::Image mCanvasPixels;
+  renderer::Texture mCanvas;
+  int mLastAppliedFrame = -1;
   FrameCallbackFunc mFrameCallback = nullptr;
 
   bool mHasShownFirstFrame = false;
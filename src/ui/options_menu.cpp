@@ -42,9 +42,11 @@ RIGEL_DISABLE_WARNINGS
 #include <imgui_internal.h>
 RIGEL_RESTORE_WARNINGS
 
+#include <algorithm>
 #include <array>
 #include <cassert>
 #include <filesystem>
+#include <iterator>
 
 
 namespace rigel::ui
@@ -62,6 +64,9 @@ constexpr auto MAX_OPTIONS_MENU_ASPECT_RATIO = 16.0f / 9.0f;
 constexpr auto STANDARD_FPS_LIMITS =
   std::array{30, 60, 70, 72, 75, 90, 120, 144, 240};
 
+constexpr auto REPLACEMENT_SCALE_LIMITS =
+  std::array{0, data::MATCH_DISPLAY_REPLACEMENT_SCALE, 2, 4, 8};
+
 
 struct SoundIdWithDescription
 {
@@ -240,6 +245,7 @@ OptionsMenu::OptionsMenu(
   , mpServiceProvider(pServiceProvider)
   , mpRenderer(pRenderer)
   , mEnableTopLevelMods(mpOptions->mEnableTopLevelMods)
+  , mMaxReplacementScale(mpOptions->mMaxReplacementScale)
   , mType(type)
   , mIsRunningInDesktopEnvironment(sdl_utils::isRunningInDesktopEnvironment())
 {
@@ -322,6 +328,7 @@ void OptionsMenu::updateAndRender(engine::TimeDelta dt)
     if (moLocalModLibrary && mType == Type::Main)
     {
       mpOptions->mEnableTopLevelMods = mEnableTopLevelMods;
+      mpOptions->mMaxReplacementScale = mMaxReplacementScale;
       moLocalModLibrary->replaceSelection(std::move(mModSelection));
       mpUserProfile->mModLibrary = std::move(*moLocalModLibrary);
     }
@@ -381,6 +388,8 @@ void OptionsMenu::updateAndRender(engine::TimeDelta dt)
       ImGui::NewLine();
 
       ImGui::Checkbox("Show FPS", &mpOptions->mShowFpsCounter);
+      ImGui::Checkbox(
+        "Lower frame rate in idle menus", &mpOptions->mIdlePowerSaving);
       ImGui::Checkbox(
         "Enable screen flashing", &mpOptions->mEnableScreenFlashes);
 
@@ -409,6 +418,13 @@ void OptionsMenu::updateAndRender(engine::TimeDelta dt)
           static_cast<data::UpscalingFilter>(upscalingFilterIndex);
       });
 
+      ImGui::Checkbox(
+        "Dynamic resolution (high-res mods only)",
+        &mpOptions->mDynamicResolutionEnabled);
+      ImGui::Checkbox(
+        "Reduce effects under heavy load",
+        &mpOptions->mReduceEffectsUnderLoad);
+
       if (mpOptions->mPerElementUpscalingEnabled)
       {
         ImGui::Spacing();
@@ -457,6 +473,11 @@ void OptionsMenu::updateAndRender(engine::TimeDelta dt)
         newAdlibPlaybackType != mpOptions->mAdlibPlaybackType;
       mpOptions->mAdlibPlaybackType = newAdlibPlaybackType;
 
+      ImGui::Checkbox("Low latency audio", &mpOptions->mLowLatencyAudio);
+      ImGui::SameLine();
+      ImGui::Checkbox("Show audio stats", &mpOptions->mShowAudioStats);
+      ImGui::Checkbox("Pre-render music", &mpOptions->mPrerenderMusic);
+
       const auto sliderWidth =
         std::min(sizeToUse.x / 2.0f, ImGui::GetFontSize() * 24);
 
@@ -639,7 +660,7 @@ void OptionsMenu::updateAndRender(engine::TimeDelta dt)
 
         if (mType == Type::Main)
         {
-          moLocalModLibrary->rescan();
+          moLocalModLibrary->rescanIfChanged();
         }
 
         mModSelection = moLocalModLibrary->currentSelection();
@@ -667,6 +688,21 @@ void OptionsMenu::updateAndRender(engine::TimeDelta dt)
           mModSelection = moLocalModLibrary->currentSelection();
         }
 
+        const auto it = std::find(
+          REPLACEMENT_SCALE_LIMITS.begin(),
+          REPLACEMENT_SCALE_LIMITS.end(),
+          mMaxReplacementScale);
+        auto scaleIndex = it != REPLACEMENT_SCALE_LIMITS.end()
+          ? int(std::distance(REPLACEMENT_SCALE_LIMITS.begin(), it))
+          : 0;
+
+        ImGui::SetNextItemWidth(ImGui::GetFontSize() * 10.0f);
+        ImGui::Combo(
+          "Max. replacement resolution",
+          &scaleIndex,
+          "Unlimited\0" "Match display\0" "2x\0" "4x\0" "8x\0");
+        mMaxReplacementScale = REPLACEMENT_SCALE_LIMITS[scaleIndex];
+
         ImGui::NewLine();
       });
 
@@ -87,6 +87,7 @@ private:
   std::optional<data::ModLibrary> moLocalModLibrary;
   std::vector<data::ModStatus> mModSelection;
   bool mEnableTopLevelMods;
+  int mMaxReplacementScale;
 
   SDL_Keycode* mpCurrentlyEditedBinding = nullptr;
   engine::TimeDelta mElapsedTimeEditingBinding = 0;
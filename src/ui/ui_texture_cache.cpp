@@ -0,0 +1,74 @@
+/* Copyright (C) 2022, Nikolai Wuttke. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "ui_texture_cache.hpp"
+
+#include "assets/resource_loader.hpp"
+#include "ui/utils.hpp"
+
+#include <algorithm>
+
+
+namespace rigel::ui
+{
+
+UiTextureCache::UiTextureCache(
+  renderer::Renderer* pRenderer,
+  const assets::ResourceLoader* pResources)
+  : mpRenderer(pRenderer)
+  , mpResources(pResources)
+{
+}
+
+
+const renderer::Texture&
+  UiTextureCache::fullScreenImage(const std::string_view imageName)
+{
+  const auto key = std::string{imageName};
+
+  auto iImage = mFullScreenImages.find(key);
+  if (iImage == mFullScreenImages.end())
+  {
+    iImage =
+      mFullScreenImages
+        .emplace(
+          key, fullScreenImageAsTexture(mpRenderer, *mpResources, imageName))
+        .first;
+  }
+
+  return iImage->second;
+}
+
+
+engine::TiledTexture&
+  UiTextureCache::uiSpriteSheet(const data::Palette16& palette)
+{
+  const auto iSheet = std::find_if(
+    mUiSpriteSheets.begin(), mUiSpriteSheets.end(), [&](const auto& entry) {
+      return entry.first == palette;
+    });
+
+  if (iSheet != mUiSpriteSheets.end())
+  {
+    return iSheet->second;
+  }
+
+  mUiSpriteSheets.emplace_back(
+    palette, makeUiSpriteSheet(mpRenderer, *mpResources, palette));
+  return mUiSpriteSheets.back().second;
+}
+
+} // namespace rigel::ui
@@ -0,0 +1,70 @@
+/* Copyright (C) 2022, Nikolai Wuttke. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "base/image.hpp"
+#include "engine/tiled_texture.hpp"
+#include "renderer/texture.hpp"
+
+#include <deque>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+
+
+namespace rigel::assets
+{
+class ResourceLoader;
+}
+
+
+namespace rigel::ui
+{
+
+/** Textures for UI elements, shared across game modes
+ *
+ * Menus and other screens are recreated each time they are entered, but the
+ * images they show are always the same. This cache holds on to the
+ * corresponding textures, so that each image is only decoded and uploaded
+ * once. Entries are never evicted, the game only has a limited number of
+ * full screen images. References returned by this class stay valid for the
+ * cache's lifetime.
+ */
+class UiTextureCache
+{
+public:
+  UiTextureCache(
+    renderer::Renderer* pRenderer,
+    const assets::ResourceLoader* pResources);
+
+  /** Full screen image with the given name, using its embedded palette */
+  const renderer::Texture& fullScreenImage(std::string_view imageName);
+
+  /** UI sprite sheet, using the given palette */
+  engine::TiledTexture& uiSpriteSheet(const data::Palette16& palette);
+
+private:
+  renderer::Renderer* mpRenderer;
+  const assets::ResourceLoader* mpResources;
+
+  std::unordered_map<std::string, renderer::Texture> mFullScreenImages;
+  std::deque<std::pair<data::Palette16, engine::TiledTexture>>
+    mUiSpriteSheets;
+};
+
+} // namespace rigel::ui
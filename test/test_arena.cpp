@@ -0,0 +1,78 @@
+/* Copyright (C) 2022, Nikolai Wuttke. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <base/arena.hpp>
+#include <base/warnings.hpp>
+
+RIGEL_DISABLE_WARNINGS
+#include <catch2/catch_test_macros.hpp>
+RIGEL_RESTORE_WARNINGS
+
+#include <cstdint>
+
+
+using namespace rigel;
+
+
+TEST_CASE("Arena hands out aligned, non-overlapping memory")
+{
+  base::Arena arena{256};
+
+  auto pFirst = static_cast<std::uint8_t*>(arena.allocate(3, 1));
+  auto pSecond = static_cast<std::uint8_t*>(arena.allocate(16, 8));
+
+  CHECK(reinterpret_cast<std::uintptr_t>(pSecond) % 8 == 0);
+  CHECK(pSecond >= pFirst + 3);
+
+  SECTION("Allocations larger than the block size get their own block")
+  {
+    auto pLarge = arena.allocate(1000, 16);
+    CHECK(reinterpret_cast<std::uintptr_t>(pLarge) % 16 == 0);
+    CHECK(arena.capacity() >= 256 + 1000);
+  }
+
+  SECTION("Reset merges all blocks into one")
+  {
+    arena.allocate(300, 1);
+    arena.allocate(300, 1);
+    const auto capacityBefore = arena.capacity();
+
+    arena.reset();
+
+    CHECK(arena.capacity() == capacityBefore);
+
+    auto pAfterReset = arena.allocate(capacityBefore, 1);
+    CHECK(pAfterReset != nullptr);
+    CHECK(arena.capacity() == capacityBefore);
+  }
+}
+
+
+TEST_CASE("Arena allocator works with standard containers")
+{
+  base::Arena arena;
+
+  base::ArenaVector<int> numbers{base::ArenaAllocator<int>{&arena}};
+  for (auto i = 0; i < 1000; ++i)
+  {
+    numbers.push_back(i);
+  }
+
+  REQUIRE(numbers.size() == 1000);
+  CHECK(numbers.front() == 0);
+  CHECK(numbers.back() == 999);
+  CHECK(numbers.get_allocator().arena() == &arena);
+}
@@ -113,4 +113,17 @@ TEST_CASE("Array view core functionality")
   SECTION("front") { CHECK(view.front() == 10); }
 
   SECTION("back") { CHECK(view.back() == 50); }
+
+  SECTION("sub view")
+  {
+    const auto subView = view.subView(1, 3);
+    CHECK(subView.size() == 3);
+    CHECK(subView.front() == 20);
+    CHECK(subView.back() == 40);
+
+    CHECK(view.subView(3).size() == 2);
+    CHECK(view.subView(5).empty());
+    CHECK_THROWS(view.subView(2, 4));
+    CHECK_THROWS(view.subView(6));
+  }
 }
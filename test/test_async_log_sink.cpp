@@ -0,0 +1,193 @@
+/* Copyright (C) 2022, Nikolai Wuttke. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <base/async_log_sink.hpp>
+#include <base/warnings.hpp>
+
+RIGEL_DISABLE_WARNINGS
+#include <catch2/catch_test_macros.hpp>
+RIGEL_RESTORE_WARNINGS
+
+#include <future>
+#include <string>
+#include <thread>
+#include <vector>
+
+
+using namespace rigel;
+
+
+TEST_CASE("Async log sink writes messages in order")
+{
+  std::string output;
+
+  {
+    base::AsyncLogSink sink{
+      [&output](const std::string_view text) { output += text; }};
+
+    for (auto i = 0; i < 100; ++i)
+    {
+      REQUIRE(sink.push(std::to_string(i)));
+    }
+  }
+
+  std::string expected;
+  for (auto i = 0; i < 100; ++i)
+  {
+    expected += std::to_string(i) + '\n';
+  }
+
+  CHECK(output == expected);
+}
+
+
+TEST_CASE("Async log sink writes out pending messages on flush")
+{
+  std::string output;
+  base::AsyncLogSink sink{
+    [&output](const std::string_view text) { output += text; }};
+
+  sink.push("first");
+  sink.push("second");
+  sink.flush();
+
+  CHECK(output == "first\nsecond\n");
+}
+
+
+TEST_CASE("Async log sink truncates long messages")
+{
+  std::string output;
+
+  {
+    base::AsyncLogSink sink{
+      [&output](const std::string_view text) { output += text; }};
+    sink.push(std::string(base::AsyncLogSink::MAX_MESSAGE_LENGTH + 20, 'a'));
+  }
+
+  CHECK(
+    output == std::string(base::AsyncLogSink::MAX_MESSAGE_LENGTH, 'a') + '\n');
+}
+
+
+TEST_CASE("Async log sink drops messages when full")
+{
+  std::string output;
+  std::promise<void> writeStarted;
+  std::promise<void> continueWriting;
+  auto continueSignal = continueWriting.get_future().share();
+  auto isFirstWrite = true;
+
+  {
+    // Block the background thread inside the first write, so that it can't
+    // make room in the buffer while we fill it up.
+    base::AsyncLogSink sink{[&](const std::string_view text) {
+      if (isFirstWrite)
+      {
+        isFirstWrite = false;
+        writeStarted.set_value();
+        continueSignal.wait();
+      }
+
+      output += text;
+    }};
+
+    sink.push("x");
+    writeStarted.get_future().wait();
+
+    for (auto i = std::size_t{0}; i < base::AsyncLogSink::NUM_SLOTS; ++i)
+    {
+      REQUIRE(sink.push("x"));
+    }
+
+    CHECK(!sink.push("dropped"));
+    CHECK(!sink.push("dropped"));
+
+    continueWriting.set_value();
+  }
+
+  std::string expected;
+  for (auto i = std::size_t{0}; i <= base::AsyncLogSink::NUM_SLOTS; ++i)
+  {
+    expected += "x\n";
+  }
+
+  expected += "[2 log messages dropped]\n";
+
+  CHECK(output == expected);
+}
+
+
+TEST_CASE("Async log sink accepts messages from multiple threads")
+{
+  constexpr auto NUM_THREADS = 4;
+  constexpr auto NUM_MESSAGES_PER_THREAD = 200;
+
+  std::vector<std::string> lines;
+
+  {
+    std::string output;
+    base::AsyncLogSink sink{
+      [&output](const std::string_view text) { output += text; }};
+
+    std::vector<std::thread> threads;
+    for (auto t = 0; t < NUM_THREADS; ++t)
+    {
+      threads.emplace_back([&sink, t]() {
+        for (auto i = 0; i < NUM_MESSAGES_PER_THREAD; ++i)
+        {
+          // The buffer might fill up temporarily, retry until accepted
+          const auto message = std::to_string(t) + ":" + std::to_string(i);
+          while (!sink.push(message))
+          {
+            std::this_thread::yield();
+          }
+        }
+      });
+    }
+
+    for (auto& thread : threads)
+    {
+      thread.join();
+    }
+
+    sink.flush();
+
+    auto start = std::size_t{0};
+    while (start < output.size())
+    {
+      const auto end = output.find('\n', start);
+      lines.push_back(output.substr(start, end - start));
+      start = end + 1;
+    }
+  }
+
+  // Drop notes may appear between messages, but each thread's messages must
+  // arrive complete and in order
+  for (auto t = 0; t < NUM_THREADS; ++t)
+  {
+    auto next = 0;
+    for (const auto& line : lines)
+    {
+      if (line == std::to_string(t) + ":" + std::to_string(next))
+      {
+        ++next;
+      }
+    }
+
+    CHECK(next == NUM_MESSAGES_PER_THREAD);
+  }
+}
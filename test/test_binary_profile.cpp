@@ -0,0 +1,100 @@
+/* Copyright (C) 2022, Nikolai Wuttke. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <base/warnings.hpp>
+#include <frontend/binary_profile.hpp>
+
+RIGEL_DISABLE_WARNINGS
+#include <catch2/catch_test_macros.hpp>
+RIGEL_RESTORE_WARNINGS
+
+
+using namespace rigel;
+
+
+TEST_CASE("Binary profile encoding")
+{
+  BinaryProfileContents contents;
+
+  auto savedGame = data::SavedGame{};
+  savedGame.mSessionId = data::GameSessionId{2, 5, data::Difficulty::Hard};
+  savedGame.mTutorialMessagesAlreadySeen.markAsShown(
+    data::TutorialMessageId::FoundRapidFire);
+  savedGame.mName = "Test save";
+  savedGame.mWeapon = data::WeaponType::Laser;
+  savedGame.mAmmo = 20;
+  savedGame.mScore = 123450;
+  contents.mSaveSlots[3] = savedGame;
+
+  contents.mHighScoreLists[1][0] = data::HighScoreEntry{"Duke", 50000};
+  contents.mHighScoreLists[1][1] = data::HighScoreEntry{"Nukem", 1000};
+
+  contents.mGamePath = std::filesystem::u8path("/games/duke2");
+
+  SECTION("Contents survive a round trip")
+  {
+    const auto decoded = decodeBinaryProfile(encodeBinaryProfile(contents));
+
+    REQUIRE(!decoded.mSaveSlots[0]);
+    REQUIRE(decoded.mSaveSlots[3]);
+
+    const auto& slot = *decoded.mSaveSlots[3];
+    CHECK(slot.mSessionId.mEpisode == 2);
+    CHECK(slot.mSessionId.mLevel == 5);
+    CHECK(slot.mSessionId.mDifficulty == data::Difficulty::Hard);
+    CHECK(slot.mTutorialMessagesAlreadySeen.hasBeenShown(
+      data::TutorialMessageId::FoundRapidFire));
+    CHECK(!slot.mTutorialMessagesAlreadySeen.hasBeenShown(
+      data::TutorialMessageId::FoundForceField));
+    CHECK(slot.mName == "Test save");
+    CHECK(slot.mWeapon == data::WeaponType::Laser);
+    CHECK(slot.mAmmo == 20);
+    CHECK(slot.mScore == 123450);
+
+    CHECK(decoded.mHighScoreLists == contents.mHighScoreLists);
+    CHECK(decoded.mGamePath == contents.mGamePath);
+    CHECK(decoded.mUnknownRecords.empty());
+  }
+
+  SECTION("Unknown records are preserved")
+  {
+    auto encoded = encodeBinaryProfile(contents);
+    const auto unknownRecord =
+      assets::ByteBuffer{0xFF, 0x00, 0x01, 0x00, 0x02, 0x00, 0x00, 0x00, 7, 8};
+    encoded.insert(encoded.end(), unknownRecord.begin(), unknownRecord.end());
+
+    const auto decoded = decodeBinaryProfile(encoded);
+    CHECK(decoded.mUnknownRecords == unknownRecord);
+    CHECK(encodeBinaryProfile(decoded) == encoded);
+  }
+
+  SECTION("Invalid data is rejected")
+  {
+    auto encoded = encodeBinaryProfile(contents);
+
+    SECTION("Wrong magic number")
+    {
+      encoded[0] = 'X';
+      REQUIRE_THROWS(decodeBinaryProfile(encoded));
+    }
+
+    SECTION("Truncated data")
+    {
+      encoded.pop_back();
+      REQUIRE_THROWS(decodeBinaryProfile(encoded));
+    }
+  }
+}
@@ -0,0 +1,129 @@
+/* Copyright (C) 2022, Nikolai Wuttke. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <base/budget_controller.hpp>
+#include <base/warnings.hpp>
+
+RIGEL_DISABLE_WARNINGS
+#include <catch2/catch_test_macros.hpp>
+RIGEL_RESTORE_WARNINGS
+
+
+using namespace rigel;
+using base::BudgetController;
+
+
+namespace
+{
+
+constexpr auto BUDGET = 16.0f;
+constexpr auto MAX_LEVEL = 3;
+
+constexpr auto CONFIG =
+  BudgetController::Config{0.1f, 0.9f, 0.6f, 15, 120, MAX_LEVEL};
+
+
+int updatesUntilLevelChange(BudgetController& controller, const float cost)
+{
+  for (auto update = 1; update <= 1000; ++update)
+  {
+    if (controller.update(cost, BUDGET))
+    {
+      return update;
+    }
+  }
+
+  return 0;
+}
+
+} // namespace
+
+
+TEST_CASE("Budget controller starts out at level 0")
+{
+  BudgetController controller{CONFIG};
+  CHECK(controller.level() == 0);
+
+  SECTION("Level stays at 0 when within budget")
+  {
+    CHECK(updatesUntilLevelChange(controller, 5.0f) == 0);
+    CHECK(controller.level() == 0);
+  }
+
+  SECTION("Level is kept without a budget")
+  {
+    for (auto i = 0; i < 100; ++i)
+    {
+      CHECK(!controller.update(50.0f, 0.0f));
+    }
+
+    CHECK(controller.level() == 0);
+  }
+}
+
+
+TEST_CASE("Budget controller raises level when over budget")
+{
+  BudgetController controller{CONFIG};
+
+  CHECK(updatesUntilLevelChange(controller, 20.0f) > 1);
+  CHECK(controller.level() == 1);
+
+  SECTION("Level doesn't go above the maximum")
+  {
+    while (updatesUntilLevelChange(controller, 40.0f) != 0)
+    {
+    }
+
+    CHECK(controller.level() == MAX_LEVEL);
+  }
+
+  SECTION("Level is lowered again after a longer period below budget")
+  {
+    const auto updatesToLower = updatesUntilLevelChange(controller, 4.0f);
+    CHECK(controller.level() == 0);
+
+    controller.reset();
+    const auto updatesToRaise = updatesUntilLevelChange(controller, 20.0f);
+    CHECK(updatesToLower > updatesToRaise);
+  }
+
+  SECTION("Cost slightly below budget doesn't lower the level")
+  {
+    CHECK(updatesUntilLevelChange(controller, 13.0f) == 0);
+    CHECK(controller.level() == 1);
+  }
+
+  SECTION("Reset returns to level 0")
+  {
+    controller.reset();
+    CHECK(controller.level() == 0);
+  }
+}
+
+
+TEST_CASE("Budget controller ignores short spikes")
+{
+  BudgetController controller{CONFIG};
+
+  for (auto i = 0; i < 200; ++i)
+  {
+    const auto cost = i % 20 == 19 ? 40.0f : 8.0f;
+    CHECK(!controller.update(cost, BUDGET));
+  }
+
+  CHECK(controller.level() == 0);
+}
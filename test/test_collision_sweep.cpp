@@ -0,0 +1,200 @@
+/* Copyright (C) 2022, Nikolai Wuttke. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <base/math_utils.hpp>
+#include <base/warnings.hpp>
+#include <data/map.hpp>
+#include <engine/collision_checker.hpp>
+#include <engine/physical_components.hpp>
+
+RIGEL_DISABLE_WARNINGS
+#include <catch2/catch_test_macros.hpp>
+RIGEL_RESTORE_WARNINGS
+
+#include <cstdlib>
+#include <random>
+
+
+using namespace rigel;
+using namespace engine;
+using namespace engine::components;
+
+
+namespace ex = entityx;
+
+
+namespace
+{
+
+enum class Direction
+{
+  Left,
+  Right,
+  Up,
+  Down
+};
+
+
+// Reference for the sweep queries: Moves one unit at a time until the
+// corresponding touch test reports a collision.
+int distanceByStepping(
+  const CollisionChecker& checker,
+  BoundingBox bbox,
+  const Direction direction,
+  const int maxDistance)
+{
+  for (auto distance = 0; distance < maxDistance; ++distance)
+  {
+    switch (direction)
+    {
+      case Direction::Left:
+        if (checker.isTouchingLeftWall(bbox))
+        {
+          return distance;
+        }
+        --bbox.topLeft.x;
+        break;
+
+      case Direction::Right:
+        if (checker.isTouchingRightWall(bbox))
+        {
+          return distance;
+        }
+        ++bbox.topLeft.x;
+        break;
+
+      case Direction::Up:
+        if (checker.isTouchingCeiling(bbox))
+        {
+          return distance;
+        }
+        --bbox.topLeft.y;
+        break;
+
+      case Direction::Down:
+        if (checker.isOnSolidGround(bbox))
+        {
+          return distance;
+        }
+        ++bbox.topLeft.y;
+        break;
+    }
+  }
+
+  return maxDistance;
+}
+
+
+int distanceBySweep(
+  const CollisionChecker& checker,
+  const BoundingBox& bbox,
+  const Direction direction,
+  const int maxDistance)
+{
+  switch (direction)
+  {
+    case Direction::Left:
+      return checker.distanceToLeftWall(bbox, maxDistance);
+
+    case Direction::Right:
+      return checker.distanceToRightWall(bbox, maxDistance);
+
+    case Direction::Up:
+      return checker.distanceToCeiling(bbox, maxDistance);
+
+    default:
+      return checker.distanceToGround(bbox, maxDistance);
+  }
+}
+
+} // namespace
+
+
+TEST_CASE("Sweep queries match stepping one unit at a time")
+{
+  ex::EntityX entityx;
+  auto& entities = entityx.entities;
+
+  // Tile index i has collision flags i, so that all combinations of solid
+  // edges occur
+  auto attributes = data::map::TileAttributeDict::AttributeArray{};
+  for (auto i = 0; i < 16; ++i)
+  {
+    attributes.push_back(std::uint16_t(i));
+  }
+
+  // Wider than a single bitmap word, to cover scans across word boundaries
+  data::map::Map map{150, 90, data::map::TileAttributeDict{attributes}};
+
+  auto rng = std::mt19937{1234};
+  auto randomInt = [&rng](const int min, const int max) {
+    return std::uniform_int_distribution<int>{min, max}(rng);
+  };
+
+  for (auto y = 0; y < map.height(); ++y)
+  {
+    for (auto x = 0; x < map.width(); ++x)
+    {
+      if (randomInt(0, 9) == 0)
+      {
+        map.setTileAt(0, x, y, data::map::TileIndex(randomInt(1, 15)));
+      }
+    }
+  }
+
+  CollisionChecker checker{&map, entities, entityx.events};
+
+  auto solidBodies = std::vector<ex::Entity>{};
+  for (auto i = 0; i < 12; ++i)
+  {
+    auto body = entities.create();
+    body.assign<BoundingBox>(
+      BoundingBox{{0, 0}, {randomInt(1, 6), randomInt(1, 6)}});
+    body.assign<WorldPosition>(
+      WorldPosition{randomInt(-10, 160), randomInt(-10, 100)});
+    body.assign<SolidBody>();
+    solidBodies.push_back(body);
+  }
+
+  // Move some bodies further than the spatial index margin without updating
+  // the index, which makes them visible only to some tests. Sweeps must
+  // behave the same way in that case.
+  for (auto i = 0; i < 4; ++i)
+  {
+    auto& position = *solidBodies[i].component<WorldPosition>();
+    position.x += randomInt(-30, 30);
+    position.y += randomInt(-30, 30);
+  }
+
+  for (auto i = 0; i < 20000; ++i)
+  {
+    const auto bbox = BoundingBox{
+      {randomInt(-12, 162), randomInt(-12, 102)},
+      {randomInt(1, 8), randomInt(1, 8)}};
+    const auto direction = static_cast<Direction>(randomInt(0, 3));
+    const auto maxDistance = randomInt(0, 80);
+
+    const auto expected =
+      distanceByStepping(checker, bbox, direction, maxDistance);
+    const auto actual = distanceBySweep(checker, bbox, direction, maxDistance);
+
+    INFO(
+      "bbox " << bbox.left() << "," << bbox.top() << " " << bbox.size.width
+              << "x" << bbox.size.height << ", direction " << int(direction)
+              << ", max distance " << maxDistance);
+    CHECK(actual == expected);
+  }
+}
@@ -0,0 +1,112 @@
+/* Copyright (C) 2022, Nikolai Wuttke. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <base/warnings.hpp>
+#include <renderer/command_list.hpp>
+
+RIGEL_DISABLE_WARNINGS
+#include <catch2/catch_test_macros.hpp>
+RIGEL_RESTORE_WARNINGS
+
+#include <vector>
+
+
+using namespace rigel;
+using renderer::CommandList;
+
+
+namespace
+{
+
+std::vector<int> textureIds(const CommandList& list)
+{
+  std::vector<int> result;
+  for (const auto& command : list.commands())
+  {
+    result.push_back(int(command.mTexture));
+  }
+
+  return result;
+}
+
+} // namespace
+
+
+TEST_CASE("Command list records commands in order")
+{
+  CommandList list;
+  list.drawTexture(1, {}, {{0, 0}, {8, 8}});
+  list.drawFilledRectangle({{1, 2}, {3, 4}}, {255, 0, 0, 255});
+  list.drawCustom(7, 2, {}, {{0, 0}, {8, 8}});
+
+  REQUIRE(list.commands().size() == 3);
+  CHECK(list.commands()[0].mType == CommandList::Type::DrawTexture);
+  CHECK(
+    list.commands()[1].mType == CommandList::Type::DrawFilledRectangle);
+  CHECK(list.commands()[1].mRect == base::Rect<int>{{1, 2}, {3, 4}});
+  CHECK(list.commands()[2].mType == CommandList::Type::Custom);
+  CHECK(list.commands()[2].mCustomTag == 7);
+}
+
+
+TEST_CASE("Command list applies overlay color to subsequent textures")
+{
+  CommandList list;
+  list.drawTexture(1, {}, {});
+  list.setOverlayColor({255, 255, 255, 255});
+  list.drawTexture(2, {}, {});
+  list.setOverlayColor({0, 0, 0, 0});
+  list.drawTexture(3, {}, {});
+
+  const auto& commands = list.commands();
+  CHECK(commands[0].mOverlayColor == base::Color{0, 0, 0, 0});
+  CHECK(commands[1].mOverlayColor == base::Color{255, 255, 255, 255});
+  CHECK(commands[2].mOverlayColor == base::Color{0, 0, 0, 0});
+}
+
+
+TEST_CASE("Command list sorting is stable within layers")
+{
+  CommandList list;
+  list.setLayer(1);
+  list.drawTexture(1, {}, {});
+  list.setLayer(0);
+  list.drawTexture(2, {}, {});
+  list.setLayer(1);
+  list.drawTexture(3, {}, {});
+  list.setLayer(0);
+  list.drawTexture(4, {}, {});
+
+  list.sort();
+
+  CHECK(textureIds(list) == std::vector<int>{2, 4, 1, 3});
+}
+
+
+TEST_CASE("Clearing a command list resets its state")
+{
+  CommandList list;
+  list.setLayer(3);
+  list.setOverlayColor({255, 255, 255, 255});
+  list.drawTexture(1, {}, {});
+
+  list.clear();
+  CHECK(list.empty());
+
+  list.drawTexture(2, {}, {});
+  CHECK(list.commands()[0].mLayer == 0);
+  CHECK(list.commands()[0].mOverlayColor == base::Color{0, 0, 0, 0});
+}
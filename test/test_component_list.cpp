@@ -0,0 +1,106 @@
+/* Copyright (C) 2022, Nikolai Wuttke. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <base/warnings.hpp>
+#include <engine/component_list.hpp>
+
+RIGEL_DISABLE_WARNINGS
+#include <catch2/catch_test_macros.hpp>
+RIGEL_RESTORE_WARNINGS
+
+#include <string>
+#include <type_traits>
+
+
+using namespace rigel;
+
+
+namespace
+{
+
+struct Position
+{
+  int x = 0;
+  int y = 0;
+};
+
+
+struct Name
+{
+  std::string mValue;
+};
+
+
+struct Unlisted
+{
+};
+
+
+using TestComponents = engine::ComponentList<Position, Name>;
+
+} // namespace
+
+
+TEST_CASE("Component list copies listed components")
+{
+  entityx::EntityX source;
+  entityx::EntityX target;
+
+  auto original = source.entities.create();
+  original.assign<Position>(Position{3, 4});
+
+  SECTION("Only present components are copied")
+  {
+    auto copy = target.entities.create();
+    TestComponents::copyAll(original, copy);
+
+    REQUIRE(copy.has_component<Position>());
+    CHECK(copy.component<Position>()->x == 3);
+    CHECK(copy.component<Position>()->y == 4);
+    CHECK(!copy.has_component<Name>());
+  }
+
+  SECTION("Non-trivial components are copied")
+  {
+    original.assign<Name>(Name{"Duke"});
+
+    auto copy = target.entities.create();
+    TestComponents::copyAll(original, copy);
+
+    REQUIRE(copy.has_component<Name>());
+    CHECK(copy.component<Name>()->mValue == "Duke");
+  }
+
+  SECTION("Unlisted components are detected")
+  {
+    CHECK(TestComponents::coversAllComponentsOf(original));
+
+    original.assign<Unlisted>();
+    CHECK(!TestComponents::coversAllComponentsOf(original));
+  }
+}
+
+
+TEST_CASE("Component list visits each type in order")
+{
+  auto visited = std::string{};
+  TestComponents::forEach([&](auto tag) {
+    using T = typename decltype(tag)::Type;
+    visited += std::is_same_v<T, Position> ? "P" : "N";
+  });
+
+  CHECK(visited == "PN");
+}
@@ -0,0 +1,141 @@
+/* Copyright (C) 2022, Nikolai Wuttke. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <assets/decoded_image_cache.hpp>
+#include <assets/png_image.hpp>
+#include <base/warnings.hpp>
+
+RIGEL_DISABLE_WARNINGS
+#include <catch2/catch_test_macros.hpp>
+RIGEL_RESTORE_WARNINGS
+
+#include <chrono>
+#include <filesystem>
+
+
+using namespace rigel;
+
+namespace fs = std::filesystem;
+
+
+namespace
+{
+
+data::Image solidImage(const data::Pixel& color)
+{
+  return data::Image{data::PixelBuffer(4 * 4, color), 4, 4};
+}
+
+
+constexpr auto IMAGE_SIZE = 4 * 4 * sizeof(data::Pixel);
+
+} // namespace
+
+
+TEST_CASE("Decoded image cache")
+{
+  using namespace std::chrono_literals;
+
+  const auto red = data::Pixel{255, 0, 0, 255};
+  const auto green = data::Pixel{0, 255, 0, 255};
+
+  const auto directory =
+    fs::temp_directory_path() / "rigel_test_decoded_image_cache";
+  fs::remove_all(directory);
+  fs::create_directories(directory);
+
+  const auto pathA = directory / "a.png";
+  const auto pathB = directory / "b.png";
+  REQUIRE(assets::savePng(pathA, solidImage(red)));
+  REQUIRE(assets::savePng(pathB, solidImage(green)));
+
+  auto cache = assets::DecodedImageCache{2 * IMAGE_SIZE};
+
+  SECTION("Decoded images are kept")
+  {
+    const auto oImage = cache.load(pathA);
+    REQUIRE(oImage);
+    CHECK(oImage->pixelData() == solidImage(red).pixelData());
+    CHECK(cache.sizeInBytes() == IMAGE_SIZE);
+
+    // Served from the cache even though the file is gone
+    const auto time = fs::last_write_time(pathA);
+    fs::remove(pathA);
+    REQUIRE(assets::savePng(pathA, solidImage(green)));
+    fs::last_write_time(pathA, time);
+
+    const auto oCached = cache.load(pathA);
+    REQUIRE(oCached);
+    CHECK(oCached->pixelData() == solidImage(red).pixelData());
+  }
+
+  SECTION("Modified files are decoded again")
+  {
+    cache.load(pathA);
+
+    REQUIRE(assets::savePng(pathA, solidImage(green)));
+    fs::last_write_time(pathA, fs::last_write_time(pathA) + 1h);
+
+    const auto oImage = cache.load(pathA);
+    REQUIRE(oImage);
+    CHECK(oImage->pixelData() == solidImage(green).pixelData());
+    CHECK(cache.sizeInBytes() == IMAGE_SIZE);
+  }
+
+  SECTION("Missing files are reported as empty")
+  {
+    CHECK(!cache.load(directory / "missing.png"));
+    CHECK(cache.sizeInBytes() == 0);
+  }
+
+  SECTION("Least recently used images are evicted")
+  {
+    const auto pathC = directory / "c.png";
+    REQUIRE(assets::savePng(pathC, solidImage(red)));
+
+    cache.load(pathA);
+    cache.load(pathB);
+    cache.load(pathA);
+    cache.load(pathC);
+    CHECK(cache.sizeInBytes() == 2 * IMAGE_SIZE);
+
+    // b should be gone, so changing it on disk without bumping the
+    // timestamp is picked up
+    const auto time = fs::last_write_time(pathB);
+    REQUIRE(assets::savePng(pathB, solidImage(red)));
+    fs::last_write_time(pathB, time);
+
+    const auto oImage = cache.load(pathB);
+    REQUIRE(oImage);
+    CHECK(oImage->pixelData() == solidImage(red).pixelData());
+  }
+
+  SECTION("Batch loading")
+  {
+    const auto images =
+      cache.load(std::vector{pathA, directory / "missing.png", pathB});
+
+    REQUIRE(images.size() == 3);
+    REQUIRE(images[0]);
+    CHECK(images[0]->pixelData() == solidImage(red).pixelData());
+    CHECK(!images[1]);
+    REQUIRE(images[2]);
+    CHECK(images[2]->pixelData() == solidImage(green).pixelData());
+    CHECK(cache.sizeInBytes() == 2 * IMAGE_SIZE);
+  }
+
+  fs::remove_all(directory);
+}
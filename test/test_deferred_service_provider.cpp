@@ -0,0 +1,54 @@
+/* Copyright (C) 2022, Nikolai Wuttke. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "utils.hpp"
+
+#include <base/warnings.hpp>
+#include <frontend/deferred_service_provider.hpp>
+
+RIGEL_DISABLE_WARNINGS
+#include <catch2/catch_test_macros.hpp>
+RIGEL_RESTORE_WARNINGS
+
+
+using namespace rigel;
+
+
+TEST_CASE("Deferred service provider")
+{
+  MockServiceProvider target;
+  DeferredServiceProvider serviceProvider{&target};
+
+  SECTION("Requests are forwarded directly when not deferring")
+  {
+    serviceProvider.playSound(data::SoundId::DukePain);
+    CHECK(target.mLastTriggeredSoundId == data::SoundId::DukePain);
+  }
+
+  SECTION("Requests are held back while deferring")
+  {
+    serviceProvider.beginDeferring();
+    serviceProvider.playSound(data::SoundId::BigExplosion);
+    serviceProvider.playSound(data::SoundId::DukePain);
+    CHECK(!target.mLastTriggeredSoundId);
+
+    serviceProvider.endDeferring();
+    CHECK(target.mLastTriggeredSoundId == data::SoundId::DukePain);
+
+    serviceProvider.playSound(data::SoundId::BigExplosion);
+    CHECK(target.mLastTriggeredSoundId == data::SoundId::BigExplosion);
+  }
+}
@@ -0,0 +1,108 @@
+/* Copyright (C) 2022, Nikolai Wuttke. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <base/delta_ring_buffer.hpp>
+#include <base/warnings.hpp>
+
+RIGEL_DISABLE_WARNINGS
+#include <catch2/catch_test_macros.hpp>
+RIGEL_RESTORE_WARNINGS
+
+#include <cstdint>
+#include <vector>
+
+
+using namespace rigel;
+
+
+namespace
+{
+
+base::DeltaRingBuffer::Frame makeFrame(const int frameNumber)
+{
+  // Mostly static contents, with a few bytes changing on each frame, and
+  // the size changing every now and then
+  auto frame = base::DeltaRingBuffer::Frame(1000 + (frameNumber / 7) * 3);
+  for (auto i = 0u; i < frame.size(); ++i)
+  {
+    frame[i] = static_cast<std::uint8_t>(i * 31);
+  }
+
+  frame[frameNumber % frame.size()] = static_cast<std::uint8_t>(frameNumber);
+  frame[(frameNumber * 17) % frame.size()] = 0xFF;
+  return frame;
+}
+
+} // namespace
+
+
+TEST_CASE("Delta ring buffer reconstructs stored frames")
+{
+  base::DeltaRingBuffer buffer{1024 * 1024, 10};
+
+  for (auto i = 0; i < 35; ++i)
+  {
+    buffer.push(makeFrame(i));
+  }
+
+  REQUIRE(buffer.size() == 35);
+
+  for (auto stepsBack = 0u; stepsBack < buffer.size(); ++stepsBack)
+  {
+    CHECK(buffer.frame(stepsBack) == makeFrame(34 - int(stepsBack)));
+  }
+
+  SECTION("Deltas are smaller than full frames")
+  {
+    CHECK(buffer.memoryUsage() < 35 * 1000 / 2);
+  }
+
+  SECTION("Discarding newest frames continues from older frame")
+  {
+    buffer.discardNewest(12);
+    REQUIRE(buffer.size() == 23);
+    CHECK(buffer.frame(0) == makeFrame(22));
+
+    buffer.push(makeFrame(100));
+    buffer.push(makeFrame(101));
+
+    CHECK(buffer.frame(0) == makeFrame(101));
+    CHECK(buffer.frame(1) == makeFrame(100));
+    CHECK(buffer.frame(2) == makeFrame(22));
+    CHECK(buffer.frame(24) == makeFrame(0));
+  }
+}
+
+
+TEST_CASE("Delta ring buffer stays within memory budget")
+{
+  base::DeltaRingBuffer buffer{8 * 1024, 5};
+
+  for (auto i = 0; i < 200; ++i)
+  {
+    buffer.push(makeFrame(i));
+    CHECK(buffer.memoryUsage() <= buffer.memoryBudget());
+  }
+
+  REQUIRE(buffer.size() > 0);
+  REQUIRE(buffer.size() < 200);
+
+  // Remaining frames are the most recent ones
+  for (auto stepsBack = 0u; stepsBack < buffer.size(); ++stepsBack)
+  {
+    CHECK(buffer.frame(stepsBack) == makeFrame(199 - int(stepsBack)));
+  }
+}
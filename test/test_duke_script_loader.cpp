@@ -399,3 +399,43 @@ TEST_CASE("Level hints are parsed correctly")
   CHECK(parsedHints.mHints[1].mEpisode == 1);
   CHECK(parsedHints.mHints[1].mLevel == 1);
 }
+
+
+TEST_CASE("Compiled scripts can be loaded back")
+{
+  const auto testData = "//FADEIN\r\n"
+                        "//LOADRAW MESSAGE.MNI\r\n"
+                        "//XYTEXT 2 4 Hello World\r\n"
+                        "//SETCURRENTPAGE\r\n"
+                        "//PAGESSTART\r\n"
+                        "//DELAY 500\r\n"
+                        "//BABBLEON 30\r\n"
+                        "//APAGE\r\n"
+                        "//LOADRAW MESSAGE.MNI\r\n"
+                        "//WAIT\r\n"
+                        "//PAGESEND\r\n"
+                        "//END\r\n";
+  const auto bundle = ScriptBundle{{"Test", loadSingleScript(testData)}};
+
+  const auto compiled = compileScripts(bundle);
+  const auto loadedBundle = loadCompiledScripts(compiled);
+
+  REQUIRE(loadedBundle.size() == 1);
+  REQUIRE(loadedBundle.count("Test") == 1);
+
+  const auto& script = loadedBundle.at("Test");
+  REQUIRE(script.size() == bundle.at("Test").size());
+  CHECK(asType<ShowFullScreenImage>(script[1]).image == "MESSAGE.MNI");
+  CHECK(asType<DrawText>(script[2]).text == "Hello World");
+
+  // Compiling the loaded scripts again gives back the same data
+  CHECK(compileScripts(loadedBundle) == compiled);
+
+  SECTION("Invalid data is rejected")
+  {
+    auto truncated = compiled;
+    truncated.pop_back();
+
+    CHECK_THROWS(loadCompiledScripts(truncated));
+  }
+}
@@ -0,0 +1,63 @@
+/* Copyright (C) 2022, Nikolai Wuttke. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <base/warnings.hpp>
+#include <renderer/dynamic_resolution.hpp>
+
+RIGEL_DISABLE_WARNINGS
+#include <catch2/catch_test_macros.hpp>
+RIGEL_RESTORE_WARNINGS
+
+
+using namespace rigel;
+using renderer::DynamicResolutionController;
+
+
+TEST_CASE("Dynamic resolution lowers scale in steps when over budget")
+{
+  DynamicResolutionController controller;
+  CHECK(controller.scale() == 1.0f);
+
+  auto previousScale = controller.scale();
+  for (auto i = 0; i < 1000; ++i)
+  {
+    if (controller.update(40.0f, 16.0f))
+    {
+      CHECK(
+        controller.scale() ==
+        previousScale - DynamicResolutionController::SCALE_STEP);
+      previousScale = controller.scale();
+    }
+  }
+
+  CHECK(controller.scale() == DynamicResolutionController::MIN_SCALE);
+
+  controller.reset();
+  CHECK(controller.scale() == 1.0f);
+}
+
+
+TEST_CASE("Dynamic resolution keeps scale without timing information")
+{
+  DynamicResolutionController controller;
+
+  for (auto i = 0; i < 100; ++i)
+  {
+    CHECK(!controller.update(std::nullopt, 16.0f));
+  }
+
+  CHECK(controller.scale() == 1.0f);
+}
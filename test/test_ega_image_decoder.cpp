@@ -0,0 +1,219 @@
+/* Copyright (C) 2022, Nikolai Wuttke. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <assets/ega_image_decoder.hpp>
+#include <base/warnings.hpp>
+
+RIGEL_DISABLE_WARNINGS
+#include <catch2/catch_test_macros.hpp>
+RIGEL_RESTORE_WARNINGS
+
+#include <cstdint>
+#include <vector>
+
+
+using namespace rigel;
+using namespace assets;
+
+
+namespace
+{
+
+data::Palette16 makeTestPalette()
+{
+  data::Palette16 palette;
+  for (auto i = 0; i < 16; ++i)
+  {
+    palette[i] = data::Pixel{
+      std::uint8_t(i * 16), std::uint8_t(255 - i), std::uint8_t(i), 255};
+  }
+
+  return palette;
+}
+
+
+// Straightforward bit-by-bit decoding, as a reference for the optimized
+// decoder
+data::Pixel referencePixel(
+  const ByteBuffer& data,
+  const std::size_t widthInTiles,
+  const std::size_t x,
+  const std::size_t y,
+  const bool isMasked,
+  const data::Palette16& palette)
+{
+  const auto bytesPerRow = isMasked ? 5u : 4u;
+  const auto tileIndex = (y / 8) * widthInTiles + x / 8;
+  const auto rowStart = (tileIndex * 8 + y % 8) * bytesPerRow;
+  const auto bitIndex = 7 - x % 8;
+  const auto firstPlane = rowStart + (isMasked ? 1 : 0);
+
+  auto colorIndex = 0;
+  for (auto plane = 0u; plane < 4u; ++plane)
+  {
+    colorIndex |= ((data[firstPlane + plane] >> bitIndex) & 1) << plane;
+  }
+
+  auto pixel = palette[colorIndex];
+  if (isMasked && ((data[rowStart] >> bitIndex) & 1))
+  {
+    pixel.a = 0;
+  }
+
+  return pixel;
+}
+
+
+void checkAgainstReference(
+  const ByteBuffer& data,
+  const std::size_t widthInTiles,
+  const data::TileImageType type)
+{
+  const auto palette = makeTestPalette();
+  const auto isMasked = type == data::TileImageType::Masked;
+  const auto image = loadTiledImage(data, widthInTiles, palette, type);
+
+  const auto numTiles = data.size() / data::GameTraits::bytesPerTile(type);
+  REQUIRE(image.width() == widthInTiles * 8);
+  REQUIRE(image.height() >= numTiles / widthInTiles * 8);
+
+  for (auto y = 0u; y < image.height(); ++y)
+  {
+    for (auto x = 0u; x < image.width(); ++x)
+    {
+      if ((y / 8) * widthInTiles + x / 8 >= numTiles)
+      {
+        continue;
+      }
+
+      const auto expected =
+        referencePixel(data, widthInTiles, x, y, isMasked, palette);
+      const auto actual = image.pixelData()[y * image.width() + x];
+      CHECK(actual == expected);
+    }
+  }
+}
+
+
+ByteBuffer makeTestData(const std::size_t size)
+{
+  ByteBuffer data(size);
+
+  auto state = std::uint32_t{12345};
+  for (auto& byte : data)
+  {
+    state = state * 1103515245u + 12345u;
+    byte = std::uint8_t(state >> 16);
+  }
+
+  return data;
+}
+
+} // namespace
+
+
+TEST_CASE("EGA tile decoding")
+{
+  SECTION("Planes are combined into color indices")
+  {
+    // First row: pixel 0 uses all planes, pixel 7 only plane 2
+    // Remaining rows: all pixels use planes 0 and 3
+    ByteBuffer data(32, 0);
+    data[0] = 0b1000'0000;
+    data[1] = 0b1000'0000;
+    data[2] = 0b1000'0001;
+    data[3] = 0b1000'0000;
+    for (auto row = 1u; row < 8u; ++row)
+    {
+      data[row * 4] = 0xFF;
+      data[row * 4 + 3] = 0xFF;
+    }
+
+    const auto palette = makeTestPalette();
+    const auto image = loadTiledImage(data, 1, palette);
+
+    REQUIRE(image.width() == 8);
+    REQUIRE(image.height() == 8);
+    CHECK(image.pixelData()[0] == palette[15]);
+    CHECK(image.pixelData()[1] == palette[0]);
+    CHECK(image.pixelData()[7] == palette[4]);
+    CHECK(image.pixelData()[8] == palette[9]);
+    CHECK(image.pixelData()[63] == palette[9]);
+  }
+
+  SECTION("Mask plane makes pixels transparent")
+  {
+    ByteBuffer data(40, 0);
+    data[0] = 0b0100'0000;
+    data[1] = 0xFF;
+
+    const auto image =
+      loadTiledImage(data, 1, makeTestPalette(), data::TileImageType::Masked);
+
+    CHECK(image.pixelData()[0].a == 255);
+    CHECK(image.pixelData()[1].a == 0);
+    CHECK(image.pixelData()[1].r == makeTestPalette()[1].r);
+  }
+
+  SECTION("Unmasked tiles match reference decoder")
+  {
+    checkAgainstReference(
+      makeTestData(32 * 37), 5, data::TileImageType::Unmasked);
+  }
+
+  SECTION("Masked tiles match reference decoder")
+  {
+    checkAgainstReference(
+      makeTestData(40 * 37), 5, data::TileImageType::Masked);
+  }
+}
+
+
+TEST_CASE("Indexed images")
+{
+  const auto palette = makeTestPalette();
+  const auto data = makeTestData(40);
+  const auto tile = loadTiledIndexedImage(
+    data.begin(), data.end(), 1, palette, data::TileImageType::Masked);
+
+  SECTION("Expanding to RGBA matches direct decoding")
+  {
+    const auto expected =
+      loadTiledImage(data, 1, palette, data::TileImageType::Masked);
+    CHECK(tile.toImage().pixelData() == expected.pixelData());
+  }
+
+  SECTION("Inserted images keep their indices and mask")
+  {
+    auto combined = data::IndexedImage{16, 16, palette};
+    combined.insertImage(8, 8, tile);
+
+    const auto pixels = combined.toImage().pixelData();
+    const auto tilePixels = tile.toImage().pixelData();
+    CHECK(pixels[0].a == 0);
+    CHECK(pixels[8 * 16 + 8] == tilePixels[0]);
+    CHECK(pixels[15 * 16 + 15] == tilePixels[63]);
+  }
+
+  SECTION("Inserting an image with a different palette fails")
+  {
+    auto otherPalette = palette;
+    otherPalette[3] = data::Pixel{1, 2, 3, 255};
+    auto combined = data::IndexedImage{16, 16, otherPalette};
+
+    CHECK_THROWS(combined.insertImage(0, 0, tile));
+  }
+}
@@ -0,0 +1,96 @@
+/* Copyright (C) 2022, Nikolai Wuttke. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <base/grid.hpp>
+#include <base/warnings.hpp>
+
+RIGEL_DISABLE_WARNINGS
+#include <catch2/catch_test_macros.hpp>
+RIGEL_RESTORE_WARNINGS
+
+#include <tuple>
+#include <vector>
+
+
+using namespace rigel;
+
+
+namespace
+{
+
+std::vector<int> rowValues(const base::Grid<int>& grid, const std::size_t y)
+{
+  const auto row = grid.row(y);
+  return std::vector<int>(row.begin(), row.end());
+}
+
+} // namespace
+
+
+TEST_CASE("Grid bulk operations")
+{
+  base::Grid<int> grid{4, 3};
+
+  SECTION("Rows are contiguous")
+  {
+    grid.setValueAt(1, 2, 5);
+    grid.rowData(1)[3] = 7;
+
+    const auto row = grid.row(2);
+    REQUIRE(row.size() == 4);
+    CHECK(row[1] == 5);
+    CHECK(grid.valueAt(3, 1) == 7);
+  }
+
+  SECTION("Filling")
+  {
+    grid.fill(1);
+    grid.fillRect(1, 1, 2, 2, 3);
+
+    CHECK(rowValues(grid, 0) == std::vector<int>{1, 1, 1, 1});
+    CHECK(rowValues(grid, 1) == std::vector<int>{1, 3, 3, 1});
+    CHECK(rowValues(grid, 2) == std::vector<int>{1, 3, 3, 1});
+  }
+
+  SECTION("Copying rectangles")
+  {
+    base::Grid<int> source{2, 2};
+    source.fill(9);
+    source.setValueAt(0, 1, 8);
+
+    grid.copyRect(source, 0, 0, 2, 2, 2, 1);
+
+    CHECK(rowValues(grid, 0) == std::vector<int>{0, 0, 0, 0});
+    CHECK(rowValues(grid, 1) == std::vector<int>{0, 0, 9, 9});
+    CHECK(rowValues(grid, 2) == std::vector<int>{0, 0, 8, 9});
+  }
+
+  SECTION("Iterating non-default cells")
+  {
+    grid.setValueAt(3, 0, 2);
+    grid.setValueAt(0, 2, 4);
+
+    std::vector<std::tuple<std::size_t, std::size_t, int>> visited;
+    grid.forEachNonDefault([&](const auto x, const auto y, const int value) {
+      visited.emplace_back(x, y, value);
+    });
+
+    CHECK(
+      visited ==
+      std::vector<std::tuple<std::size_t, std::size_t, int>>{
+        {3, 0, 2}, {0, 2, 4}});
+  }
+}
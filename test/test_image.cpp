@@ -0,0 +1,103 @@
+/* Copyright (C) 2022, Nikolai Wuttke. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <base/image.hpp>
+#include <base/warnings.hpp>
+
+RIGEL_DISABLE_WARNINGS
+#include <catch2/catch_test_macros.hpp>
+RIGEL_RESTORE_WARNINGS
+
+#include <stdexcept>
+
+
+using namespace rigel;
+using data::Image;
+using data::Pixel;
+
+
+TEST_CASE("Image downscaling")
+{
+  const auto opaqueRed = Pixel{200, 0, 0, 255};
+  const auto opaqueBlue = Pixel{0, 0, 100, 255};
+  const auto transparent = Pixel{0, 0, 0, 0};
+
+  SECTION("Size is divided by factor, partial blocks are dropped")
+  {
+    const auto scaled = Image{5, 4}.downscaled(2);
+
+    CHECK(scaled.width() == 2);
+    CHECK(scaled.height() == 2);
+    CHECK(scaled.pixelData().size() == 4);
+  }
+
+  SECTION("Factor 1 returns identical image")
+  {
+    // clang-format off
+    const auto image = Image{
+      {opaqueRed, opaqueBlue,
+       transparent, opaqueRed},
+      2, 2};
+    // clang-format on
+
+    CHECK(image.downscaled(1).pixelData() == image.pixelData());
+  }
+
+  SECTION("Pixels in a block are averaged")
+  {
+    // clang-format off
+    const auto image = Image{
+      {opaqueRed, opaqueBlue,
+       opaqueBlue, opaqueRed},
+      2, 2};
+    // clang-format on
+
+    const auto scaled = image.downscaled(2);
+
+    REQUIRE(scaled.pixelData().size() == 1);
+    CHECK(scaled.pixelData()[0] == Pixel{100, 0, 50, 255});
+  }
+
+  SECTION("Transparent pixels don't affect color")
+  {
+    // clang-format off
+    const auto image = Image{
+      {opaqueRed, transparent,
+       transparent, transparent},
+      2, 2};
+    // clang-format on
+
+    const auto scaled = image.downscaled(2);
+
+    REQUIRE(scaled.pixelData().size() == 1);
+    CHECK(scaled.pixelData()[0] == Pixel{200, 0, 0, 63});
+  }
+
+  SECTION("Fully transparent block stays transparent")
+  {
+    const auto scaled = Image{
+      {transparent, transparent, transparent, transparent},
+      2,
+      2}.downscaled(2);
+
+    CHECK(scaled.pixelData()[0] == transparent);
+  }
+
+  SECTION("Zero factor is rejected")
+  {
+    CHECK_THROWS_AS((Image{2, 2}.downscaled(0)), std::invalid_argument);
+  }
+}
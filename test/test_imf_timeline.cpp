@@ -0,0 +1,176 @@
+/* Copyright (C) 2022, Nikolai Wuttke. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <audio/software_imf_player.hpp>
+#include <base/warnings.hpp>
+#include <data/game_traits.hpp>
+
+RIGEL_DISABLE_WARNINGS
+#include <catch2/catch_test_macros.hpp>
+RIGEL_RESTORE_WARNINGS
+
+#include <cstdint>
+#include <vector>
+
+
+using namespace rigel;
+
+
+namespace
+{
+
+// Makes each IMF tick exactly 10 samples long
+constexpr auto SAMPLE_RATE = data::GameTraits::musicPlaybackRate * 10;
+
+
+data::Song makeSong(const std::size_t numCommands)
+{
+  const std::uint16_t delays[] = {0, 1, 0, 0, 3, 2};
+
+  data::Song song;
+  for (auto i = std::size_t{0}; i < numCommands; ++i)
+  {
+    song.push_back(
+      {std::uint8_t(0x20 + i % 37),
+       std::uint8_t(i * 7),
+       delays[i % std::size(delays)]});
+  }
+
+  return song;
+}
+
+
+// Reference implementation: Replay all commands from the beginning
+audio::ImfTimeline::Position
+  stepTo(const data::Song& song, const std::size_t samplePosition)
+{
+  auto result = audio::ImfTimeline::Position{audio::initialAdlibRegisters()};
+
+  auto time = std::size_t{0};
+  auto i = std::size_t{0};
+  while (time <= samplePosition)
+  {
+    result.mRegisters[song[i].reg] = song[i].value;
+    time += song[i].delay * 10;
+    i = (i + 1) % song.size();
+  }
+
+  result.mNextCommand = i;
+  result.mSamplesUntilNextCommand = time - samplePosition;
+  return result;
+}
+
+} // namespace
+
+
+TEST_CASE("IMF timeline")
+{
+  const auto song = makeSong(1000);
+  const auto timeline = audio::ImfTimeline{song, SAMPLE_RATE};
+
+  // 166 repetitions of the delay pattern, followed by 4 commands with a
+  // total delay of 1 tick
+  const auto expectedLength = std::size_t{166 * 60 + 10};
+
+  SECTION("Command times are absolute")
+  {
+    CHECK(timeline.commandTime(0) == 0);
+    CHECK(timeline.commandTime(1) == 0);
+    CHECK(timeline.commandTime(2) == 10);
+    CHECK(timeline.commandTime(5) == 40);
+    CHECK(timeline.commandTime(6) == 60);
+    CHECK(timeline.lengthInSamples() == expectedLength);
+    CHECK(timeline.commandTime(song.size()) == expectedLength);
+  }
+
+  SECTION("Seeking matches replaying from the start")
+  {
+    for (const auto position :
+         {std::size_t{0},
+          std::size_t{5},
+          std::size_t{10},
+          std::size_t{2559},
+          std::size_t{2560},
+          std::size_t{5000},
+          expectedLength - 1})
+    {
+      const auto expected = stepTo(song, position);
+      const auto actual = timeline.seek(position);
+
+      CHECK(actual.mRegisters == expected.mRegisters);
+      CHECK(actual.mNextCommand == expected.mNextCommand);
+      CHECK(
+        actual.mSamplesUntilNextCommand ==
+        expected.mSamplesUntilNextCommand);
+    }
+  }
+
+  SECTION("Positions past the end wrap around")
+  {
+    const auto wrapped = timeline.seek(expectedLength + 25);
+    const auto expected = timeline.seek(25);
+
+    CHECK(wrapped.mRegisters == expected.mRegisters);
+    CHECK(wrapped.mNextCommand == expected.mNextCommand);
+    CHECK(
+      wrapped.mSamplesUntilNextCommand == expected.mSamplesUntilNextCommand);
+  }
+
+  SECTION("Empty song")
+  {
+    const auto empty = audio::ImfTimeline{{}, SAMPLE_RATE};
+
+    CHECK(empty.empty());
+    CHECK(empty.lengthInSamples() == 0);
+    CHECK(empty.seek(100).mNextCommand == 0);
+  }
+}
+
+
+TEST_CASE("IMF player reports playback position")
+{
+  audio::SoftwareImfPlayer player{SAMPLE_RATE};
+  auto buffer = std::vector<std::int16_t>(512);
+
+  const auto song = makeSong(60);
+  const auto length = audio::ImfTimeline{song, SAMPLE_RATE}.lengthInSamples();
+
+  SECTION("From the start")
+  {
+    player.playSong(data::Song{song});
+    player.render(buffer.data(), 100);
+    CHECK(player.playbackPosition() == 100);
+
+    player.render(buffer.data(), 512);
+    player.render(buffer.data(), 512);
+    CHECK(player.playbackPosition() == (100 + 2 * 512) % length);
+  }
+
+  SECTION("From a given position")
+  {
+    player.playSong(data::Song{song}, 250);
+    player.render(buffer.data(), 20);
+    CHECK(player.playbackPosition() == 270);
+  }
+
+  SECTION("Pre-rendered")
+  {
+    player.playRenderedSong(
+      std::make_shared<const audio::RenderedSong>(1000), 900);
+    player.render(buffer.data(), 200);
+    CHECK(player.playbackPosition() == 100);
+  }
+}
@@ -0,0 +1,87 @@
+/* Copyright (C) 2022, Nikolai Wuttke. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <base/warnings.hpp>
+#include <frontend/input_recording.hpp>
+
+RIGEL_DISABLE_WARNINGS
+#include <catch2/catch_test_macros.hpp>
+RIGEL_RESTORE_WARNINGS
+
+#include <filesystem>
+
+
+using namespace rigel;
+
+TEST_CASE("Input recordings survive a save/load round trip")
+{
+  auto recording = InputRecording{};
+  recording.mSessionId = data::GameSessionId{2, 5, data::Difficulty::Hard};
+  recording.mGameplayStyle = data::GameplayStyle::Classic;
+  recording.mPlayerState.mWeapon = data::WeaponType::Laser;
+  recording.mPlayerState.mAmmo = 17;
+  recording.mPlayerState.mScore = 123456;
+  recording.mPlayerState.mTutorialMessagesAlreadySeen.markAsShown(
+    data::TutorialMessageId::FoundRapidFire);
+  recording.mPlayerPositionOverride = base::Vec2{30, 400};
+  recording.mShowWelcomeMessage = true;
+
+  game_logic::PlayerInput walkingRight;
+  walkingRight.mRight = true;
+
+  game_logic::PlayerInput jumping = walkingRight;
+  jumping.mJump.mIsPressed = true;
+  jumping.mJump.mWasTriggered = true;
+
+  // Long enough to require splitting into several runs
+  recording.mInputs.insert(recording.mInputs.end(), 70000, walkingRight);
+  recording.mInputs.push_back(jumping);
+  recording.mInputs.push_back({});
+
+  for (auto i = 0u; i < recording.mInputs.size(); ++i)
+  {
+    recording.mStateHashes.push_back({i, i * 2, 7, 0xFFFFFFFF - i});
+  }
+
+  const auto path =
+    std::filesystem::temp_directory_path() / "rigel_test_recording.inputs";
+  saveInputRecording(recording, path);
+  const auto loaded = loadInputRecording(path);
+  std::filesystem::remove(path);
+
+  CHECK(loaded.mSessionId.mEpisode == 2);
+  CHECK(loaded.mSessionId.mLevel == 5);
+  CHECK(loaded.mSessionId.mDifficulty == data::Difficulty::Hard);
+  CHECK(loaded.mGameplayStyle == data::GameplayStyle::Classic);
+  CHECK(loaded.mPlayerState.mWeapon == data::WeaponType::Laser);
+  CHECK(loaded.mPlayerState.mAmmo == 17);
+  CHECK(loaded.mPlayerState.mScore == 123456);
+  CHECK(loaded.mPlayerState.mTutorialMessagesAlreadySeen.hasBeenShown(
+    data::TutorialMessageId::FoundRapidFire));
+  CHECK(!loaded.mPlayerState.mTutorialMessagesAlreadySeen.hasBeenShown(
+    data::TutorialMessageId::FoundLaser));
+  CHECK(loaded.mPlayerPositionOverride == base::Vec2{30, 400});
+  CHECK(loaded.mShowWelcomeMessage);
+
+  REQUIRE(loaded.mInputs.size() == recording.mInputs.size());
+  CHECK(loaded.mInputs[69999].mRight);
+  CHECK(!loaded.mInputs[69999].mJump.mIsPressed);
+  CHECK(loaded.mInputs[70000].mJump.mIsPressed);
+  CHECK(loaded.mInputs[70000].mJump.mWasTriggered);
+  CHECK(!loaded.mInputs[70001].mRight);
+
+  CHECK(loaded.mStateHashes == recording.mStateHashes);
+}
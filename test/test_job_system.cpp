@@ -0,0 +1,229 @@
+/* Copyright (C) 2022, Nikolai Wuttke. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <base/job_system.hpp>
+#include <base/warnings.hpp>
+
+RIGEL_DISABLE_WARNINGS
+#include <catch2/catch_test_macros.hpp>
+RIGEL_RESTORE_WARNINGS
+
+#include <atomic>
+#include <chrono>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+
+using namespace rigel;
+
+
+TEST_CASE("Job system runs jobs")
+{
+  base::JobSystem jobSystem{4};
+
+  SECTION("Each job runs exactly once")
+  {
+    std::atomic<int> counter{0};
+    std::vector<base::JobHandle> jobs;
+
+    for (auto i = 0; i < 1000; ++i)
+    {
+      jobs.push_back(jobSystem.submit([&counter]() { ++counter; }));
+    }
+
+    for (const auto& job : jobs)
+    {
+      jobSystem.wait(job);
+      CHECK(job.isDone());
+    }
+
+    CHECK(counter == 1000);
+  }
+
+  SECTION("Waiting until idle completes all jobs")
+  {
+    std::atomic<int> counter{0};
+    for (auto i = 0; i < 100; ++i)
+    {
+      jobSystem.submit([&]() {
+        jobSystem.submit([&counter]() { ++counter; });
+      });
+    }
+
+    jobSystem.waitUntilIdle();
+    CHECK(counter == 100);
+  }
+
+  SECTION("Jobs start only after their dependencies")
+  {
+    std::atomic<int> stage{0};
+    auto stageOk = std::vector<std::atomic<bool>>(3);
+
+    const auto first = jobSystem.submit([&]() { stage = 1; });
+    const auto second = jobSystem.submit(
+      [&]() {
+        stageOk[0] = stage == 1;
+        stage = 2;
+      },
+      {first});
+    const auto third = jobSystem.submit(
+      [&]() {
+        stageOk[1] = stage == 2;
+        stage = 3;
+      },
+      {first, second});
+
+    jobSystem.wait(third);
+    CHECK(stage == 3);
+    CHECK(stageOk[0]);
+    CHECK(stageOk[1]);
+  }
+
+  SECTION("Exceptions are rethrown when waiting")
+  {
+    const auto job =
+      jobSystem.submit([]() { throw std::runtime_error("failed"); });
+    CHECK_THROWS_AS(jobSystem.wait(job), std::runtime_error);
+  }
+
+  SECTION("Main thread jobs run on the main thread")
+  {
+    std::atomic<bool> ranOnMainThread{false};
+
+    const auto background = jobSystem.submit([]() {});
+    const auto upload = jobSystem.submitOnMainThread(
+      [&]() { ranOnMainThread = jobSystem.isMainThread(); }, {background});
+
+    jobSystem.wait(background);
+    while (!upload.isDone())
+    {
+      jobSystem.runMainThreadTasks();
+    }
+
+    CHECK(ranOnMainThread);
+  }
+}
+
+
+TEST_CASE("Job system workers survive losing jobs to a waiting thread")
+{
+  constexpr auto NUM_WORKERS = 4;
+  base::JobSystem jobSystem{NUM_WORKERS};
+
+  // Waiting runs queued jobs on the main thread, so it frequently takes the
+  // job that a worker has just been woken up for.
+  for (auto i = 0; i < 20000; ++i)
+  {
+    jobSystem.wait(jobSystem.submit([]() {}));
+  }
+
+  // These jobs can only complete if enough of them run at the same time,
+  // i.e. if the workers are all still there. The timeout keeps a broken job
+  // system from hanging the test.
+  std::atomic<int> numStarted{0};
+  std::atomic<int> numCompleted{0};
+  std::vector<base::JobHandle> jobs;
+  for (auto i = 0; i < NUM_WORKERS; ++i)
+  {
+    jobs.push_back(jobSystem.submit([&]() {
+      ++numStarted;
+
+      const auto deadline =
+        std::chrono::steady_clock::now() + std::chrono::seconds{5};
+      while (numStarted < NUM_WORKERS &&
+             std::chrono::steady_clock::now() < deadline)
+      {
+        std::this_thread::yield();
+      }
+
+      if (numStarted >= NUM_WORKERS)
+      {
+        ++numCompleted;
+      }
+    }));
+  }
+
+  for (const auto& job : jobs)
+  {
+    jobSystem.wait(job);
+  }
+
+  CHECK(numCompleted == NUM_WORKERS);
+}
+
+
+TEST_CASE("Job system parallel for")
+{
+  base::JobSystem jobSystem{3};
+
+  SECTION("Visits every index once")
+  {
+    auto visits = std::vector<std::atomic<int>>(500);
+    jobSystem.parallelFor(visits.size(), [&](const std::size_t i) {
+      ++visits[i];
+    });
+
+    for (const auto& count : visits)
+    {
+      CHECK(count == 1);
+    }
+  }
+
+  SECTION("Can be nested")
+  {
+    std::atomic<int> counter{0};
+    jobSystem.parallelFor(8, [&](std::size_t) {
+      jobSystem.parallelFor(8, [&](std::size_t) { ++counter; });
+    });
+
+    CHECK(counter == 64);
+  }
+
+  SECTION("Exceptions are rethrown")
+  {
+    CHECK_THROWS_AS(
+      jobSystem.parallelFor(
+        100,
+        [](const std::size_t i) {
+          if (i == 42)
+          {
+            throw std::runtime_error("failed");
+          }
+        }),
+      std::runtime_error);
+  }
+
+  SECTION("Deterministic mode runs in order on the calling thread")
+  {
+    jobSystem.setDeterministic(true);
+
+    std::vector<std::size_t> order;
+    jobSystem.parallelFor(
+      100, [&](const std::size_t i) { order.push_back(i); });
+
+    REQUIRE(order.size() == 100);
+    for (auto i = std::size_t{0}; i < order.size(); ++i)
+    {
+      CHECK(order[i] == i);
+    }
+
+    auto ranInline = false;
+    const auto job = jobSystem.submit([&]() { ranInline = true; });
+    CHECK(ranInline);
+    CHECK(job.isDone());
+  }
+}
@@ -0,0 +1,70 @@
+/* Copyright (C) 2022, Nikolai Wuttke. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <assets/file_utils.hpp>
+#include <base/warnings.hpp>
+
+RIGEL_DISABLE_WARNINGS
+#include <catch2/catch_test_macros.hpp>
+RIGEL_RESTORE_WARNINGS
+
+#include <stdexcept>
+#include <vector>
+
+
+using namespace rigel;
+using namespace assets;
+
+
+TEST_CASE("Little-endian stream reader")
+{
+  const std::vector<std::uint8_t> data{
+    0x01, 0x34, 0x12, 0xFE, 0xFF, 0xFF, 0x78, 0x56, 0x34, 0x12, 'a', 'b', 0};
+
+  LeStreamReader reader(data);
+
+  SECTION("Reading single values")
+  {
+    CHECK(reader.readU8() == 0x01);
+    CHECK(reader.peekU16() == 0x1234);
+    CHECK(reader.readU16() == 0x1234);
+    CHECK(reader.readS24() == -2);
+    CHECK(reader.readU32() == 0x12345678);
+    CHECK(readFixedSizeString(reader, 3) == "ab");
+    CHECK(!reader.hasData());
+    CHECK_THROWS_AS(reader.readU8(), std::runtime_error);
+  }
+
+  SECTION("Reading arrays")
+  {
+    reader.skipBytes(1);
+
+    const auto words = reader.readU16Array(2);
+    CHECK(words == std::vector<std::uint16_t>{0x1234, 0xFFFE});
+
+    const auto bytes = reader.readBytes(1);
+    REQUIRE(bytes.size() == 1);
+    CHECK(bytes.data() == data.data() + 5);
+    CHECK(reader.readU8() == 0x78);
+  }
+
+  SECTION("Reading past the end")
+  {
+    CHECK_THROWS_AS(reader.readU16Array(7), std::runtime_error);
+    CHECK_THROWS_AS(reader.readBytes(14), std::runtime_error);
+    CHECK(reader.readU8() == 0x01);
+  }
+}
@@ -0,0 +1,132 @@
+/* Copyright (C) 2022, Nikolai Wuttke. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <base/warnings.hpp>
+#include <engine/entity_tools.hpp>
+#include <engine/life_time_components.hpp>
+#include <engine/life_time_system.hpp>
+#include <engine/physical_components.hpp>
+
+RIGEL_DISABLE_WARNINGS
+#include <catch2/catch_test_macros.hpp>
+RIGEL_RESTORE_WARNINGS
+
+
+using namespace rigel;
+using namespace engine;
+using namespace engine::components;
+
+
+namespace ex = entityx;
+
+
+TEST_CASE("Life time system destroys entities when their time is up")
+{
+  ex::EntityX entityx;
+  auto& entities = entityx.entities;
+
+  LifeTimeSystem lifeTimeSystem{entityx.events};
+
+  const auto cameraPosition = base::Vec2{0, 0};
+  const auto viewportSize = base::Size{32, 20};
+
+  const auto runUpdates = [&](const int count) {
+    for (int i = 0; i < count; ++i)
+    {
+      lifeTimeSystem.update(entities, cameraPosition, viewportSize);
+    }
+  };
+
+
+  SECTION("Timeout elapses after the given number of updates")
+  {
+    auto entity = entities.create();
+    entity.assign<AutoDestroy>(AutoDestroy::afterTimeout(3));
+
+    runUpdates(3);
+    CHECK(entity.valid());
+
+    runUpdates(1);
+    CHECK(!entity.valid());
+  }
+
+  SECTION("Timeouts longer than one wheel revolution")
+  {
+    auto entity = entities.create();
+    entity.assign<AutoDestroy>(AutoDestroy::afterTimeout(300));
+
+    runUpdates(300);
+    CHECK(entity.valid());
+
+    runUpdates(1);
+    CHECK(!entity.valid());
+  }
+
+  SECTION("Reassigning restarts the timeout")
+  {
+    auto entity = entities.create();
+    entity.assign<AutoDestroy>(AutoDestroy::afterTimeout(2));
+
+    runUpdates(2);
+    reassign<AutoDestroy>(entity, AutoDestroy::afterTimeout(2));
+
+    runUpdates(2);
+    CHECK(entity.valid());
+
+    runUpdates(1);
+    CHECK(!entity.valid());
+  }
+
+  SECTION("Removing the component cancels the timeout")
+  {
+    auto entity = entities.create();
+    entity.assign<AutoDestroy>(AutoDestroy::afterTimeout(1));
+    entity.remove<AutoDestroy>();
+
+    runUpdates(5);
+    CHECK(entity.valid());
+  }
+
+  SECTION("Entities are destroyed on world collision")
+  {
+    auto entity = entities.create();
+    entity.assign<AutoDestroy>(
+      AutoDestroy{AutoDestroy::Condition::OnWorldCollision});
+
+    runUpdates(2);
+    CHECK(entity.valid());
+
+    entity.assign<CollidedWithWorld>();
+    runUpdates(1);
+    CHECK(!entity.valid());
+  }
+
+  SECTION("Entities are destroyed when leaving the screen")
+  {
+    auto entity = entities.create();
+    entity.assign<AutoDestroy>(
+      AutoDestroy{AutoDestroy::Condition::OnLeavingActiveRegion});
+    entity.assign<WorldPosition>(10, 10);
+    entity.assign<BoundingBox>(BoundingBox{{0, 0}, {2, 2}});
+
+    runUpdates(1);
+    CHECK(entity.valid());
+
+    *entity.component<WorldPosition>() = WorldPosition{100, 10};
+    runUpdates(1);
+    CHECK(!entity.valid());
+  }
+}
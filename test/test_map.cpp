@@ -0,0 +1,385 @@
+/* Copyright (C) 2022, Nikolai Wuttke. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <base/warnings.hpp>
+#include <data/map.hpp>
+
+RIGEL_DISABLE_WARNINGS
+#include <catch2/catch_test_macros.hpp>
+RIGEL_RESTORE_WARNINGS
+
+#include <array>
+#include <random>
+
+
+using namespace rigel;
+using namespace data::map;
+
+
+namespace
+{
+
+const std::array<SolidEdge, 4> ALL_EDGES{
+  SolidEdge::top(),
+  SolidEdge::bottom(),
+  SolidEdge::left(),
+  SolidEdge::right()};
+
+
+// Computes a tile's collision data from its tiles, the way the map did
+// before it started caching collision data
+CollisionData referenceCollisionData(const Map& map, const int x, const int y)
+{
+  const auto tile1 = map.tileAt(0, x, y);
+  const auto tile2 = map.tileAt(1, x, y);
+
+  if (tile1 != 0 && tile2 != 0)
+  {
+    return CollisionData{};
+  }
+
+  return CollisionData{
+    map.attributeDict().collisionData(tile1),
+    map.attributeDict().collisionData(tile2)};
+}
+
+
+bool matchesReference(const Map& map)
+{
+  for (auto y = 0; y < map.height(); ++y)
+  {
+    for (auto x = 0; x < map.width(); ++x)
+    {
+      const auto expected = referenceCollisionData(map, x, y);
+      const auto actual = map.collisionData(x, y);
+
+      for (const auto& edge : ALL_EDGES)
+      {
+        if (expected.isSolidOn(edge) != actual.isSolidOn(edge))
+        {
+          return false;
+        }
+      }
+    }
+  }
+
+  return true;
+}
+
+
+// A 40x30 map filled with random tiles. Tile index i has collision flags i,
+// so that all combinations of solid edges occur.
+Map makeRandomMap()
+{
+  auto attributes = TileAttributeDict::AttributeArray{};
+  for (auto i = 0; i < 16; ++i)
+  {
+    attributes.push_back(std::uint16_t(i));
+  }
+
+  Map map{40, 30, TileAttributeDict{attributes}};
+
+  auto rng = std::mt19937{4321};
+  auto randomInt = [&rng](const int min, const int max) {
+    return std::uniform_int_distribution<int>{min, max}(rng);
+  };
+
+  for (auto y = 0; y < map.height(); ++y)
+  {
+    for (auto x = 0; x < map.width(); ++x)
+    {
+      // Leaves some tiles empty, and creates some composite tiles
+      map.setTileAt(randomInt(0, 1), x, y, TileIndex(randomInt(0, 15)));
+      if (randomInt(0, 4) == 0)
+      {
+        map.setTileAt(randomInt(0, 1), x, y, TileIndex(randomInt(1, 15)));
+      }
+    }
+  }
+
+  return map;
+}
+
+
+// Tile by tile versions of clearSection() and moveSection(), the way the map
+// did it before it started processing whole sections at once
+void referenceClearSection(Map& map, const base::Rect<int>& section)
+{
+  for (auto y = section.top(); y <= section.bottom(); ++y)
+  {
+    for (auto x = section.left(); x <= section.right(); ++x)
+    {
+      map.setTileAt(0, x, y, 0);
+      map.setTileAt(1, x, y, 0);
+    }
+  }
+}
+
+
+void referenceMoveSection(
+  Map& map,
+  const base::Rect<int>& section,
+  const base::Vec2& destination)
+{
+  const auto source = map;
+  const auto offset = destination - section.topLeft;
+
+  for (auto y = section.top(); y <= section.bottom(); ++y)
+  {
+    for (auto x = section.left(); x <= section.right(); ++x)
+    {
+      for (auto layer = 0; layer < 2; ++layer)
+      {
+        map.setTileAt(
+          layer, x + offset.x, y + offset.y, source.tileAt(layer, x, y));
+      }
+    }
+  }
+}
+
+
+bool hasSameTiles(const Map& lhs, const Map& rhs)
+{
+  for (auto y = 0; y < lhs.height(); ++y)
+  {
+    for (auto x = 0; x < lhs.width(); ++x)
+    {
+      if (
+        lhs.tileAt(0, x, y) != rhs.tileAt(0, x, y) ||
+        lhs.tileAt(1, x, y) != rhs.tileAt(1, x, y))
+      {
+        return false;
+      }
+    }
+  }
+
+  return true;
+}
+
+} // namespace
+
+
+TEST_CASE("Map keeps collision data up to date")
+{
+  auto map = makeRandomMap();
+
+  CHECK(matchesReference(map));
+
+  SECTION("After clearing a section")
+  {
+    map.clearSection(5, 3, 12, 7);
+    CHECK(matchesReference(map));
+  }
+
+  SECTION("After moving a section")
+  {
+    map.moveSection({{2, 2}, {10, 8}}, {6, 5});
+    CHECK(matchesReference(map));
+
+    map.moveSection({{20, 10}, {8, 8}}, {18, 6});
+    CHECK(matchesReference(map));
+  }
+
+  SECTION("Outside of the map")
+  {
+    CHECK(map.collisionData(-1, 5).isSolidOn(SolidEdge::left()));
+    CHECK(map.collisionData(map.width(), 5).isSolidOn(SolidEdge::top()));
+    CHECK(!map.collisionData(5, -1).isSolidOn(SolidEdge::top()));
+    CHECK(!map.collisionData(5, map.height()).isSolidOn(SolidEdge::bottom()));
+  }
+}
+
+
+TEST_CASE("Section updates match tile by tile updates")
+{
+  auto map = makeRandomMap();
+  auto reference = map;
+  const auto previousRevision = map.revision();
+
+  SECTION("Clearing a section")
+  {
+    map.clearSection(5, 3, 12, 7);
+    referenceClearSection(reference, {{5, 3}, {12, 7}});
+
+    CHECK(hasSameTiles(map, reference));
+    CHECK(matchesReference(map));
+    CHECK(map.contentHash() == reference.contentHash());
+    CHECK(map.revision() != previousRevision);
+  }
+
+  SECTION("Moving a section down, overlapping itself")
+  {
+    map.moveSection({{2, 2}, {10, 8}}, {6, 5});
+    referenceMoveSection(reference, {{2, 2}, {10, 8}}, {6, 5});
+
+    CHECK(hasSameTiles(map, reference));
+    CHECK(matchesReference(map));
+    CHECK(map.contentHash() == reference.contentHash());
+    CHECK(map.revision() != previousRevision);
+  }
+
+  SECTION("Moving a section up, overlapping itself")
+  {
+    map.moveSection({{20, 10}, {8, 8}}, {18, 6});
+    referenceMoveSection(reference, {{20, 10}, {8, 8}}, {18, 6});
+
+    CHECK(hasSameTiles(map, reference));
+    CHECK(matchesReference(map));
+    CHECK(map.contentHash() == reference.contentHash());
+    CHECK(map.revision() != previousRevision);
+  }
+
+  SECTION("Moving a falling section by one row, then clearing its top row")
+  {
+    map.moveSection({{10, 12}, {6, 4}}, {10, 13});
+    map.clearSection(10, 12, 6, 1);
+    referenceMoveSection(reference, {{10, 12}, {6, 4}}, {10, 13});
+    referenceClearSection(reference, {{10, 12}, {6, 1}});
+
+    CHECK(hasSameTiles(map, reference));
+    CHECK(matchesReference(map));
+    CHECK(map.contentHash() == reference.contentHash());
+  }
+
+  SECTION("Empty sections don't change anything")
+  {
+    const auto previousHash = map.contentHash();
+
+    map.clearSection(5, 3, 0, 7);
+    map.moveSection({{2, 2}, {10, 0}}, {6, 5});
+
+    CHECK(map.contentHash() == previousHash);
+    CHECK(map.revision() == previousRevision);
+  }
+}
+
+
+TEST_CASE("Map keeps track of conveyor belts")
+{
+  // Tile 1 moves left, tile 2 right, tile 3 both ways, tile 4 is solid
+  const auto attributes =
+    TileAttributeDict{{0x0, 0x100, 0x200, 0x300, 0x0F}};
+
+  Map map{100, 4, attributes};
+  map.setTileAt(0, 10, 1, 2);
+  map.setTileAt(0, 11, 1, 2);
+  map.setTileAt(0, 12, 1, 1);
+  map.setTileAt(1, 70, 1, 2);
+  map.setTileAt(0, 80, 2, 3);
+
+  CHECK(map.conveyorBeltDirectionInRow(0, 9, 1) == 0);
+  CHECK(map.conveyorBeltDirectionInRow(8, 11, 1) == 1);
+  CHECK(map.conveyorBeltDirectionInRow(8, 20, 1) == -1);
+  CHECK(map.conveyorBeltDirectionInRow(13, 69, 1) == 0);
+  CHECK(map.conveyorBeltDirectionInRow(60, 80, 1) == 1);
+  CHECK(map.conveyorBeltDirectionInRow(80, 80, 2) == -1);
+
+  SECTION("Spans partially outside of the map")
+  {
+    CHECK(map.conveyorBeltDirectionInRow(-5, 10, 1) == 1);
+    CHECK(map.conveyorBeltDirectionInRow(70, 200, 1) == 1);
+    CHECK(map.conveyorBeltDirectionInRow(0, 99, -1) == 0);
+    CHECK(map.conveyorBeltDirectionInRow(0, 99, 4) == 0);
+  }
+
+  SECTION("Composite tiles are ignored")
+  {
+    map.setTileAt(1, 10, 1, 4);
+    CHECK(map.conveyorBeltDirectionInRow(10, 10, 1) == 0);
+  }
+
+  SECTION("After changing tiles")
+  {
+    map.setTileAt(0, 12, 1, 0);
+    CHECK(map.conveyorBeltDirectionInRow(8, 20, 1) == 1);
+
+    map.clearSection(10, 1, 2, 1);
+    CHECK(map.conveyorBeltDirectionInRow(8, 20, 1) == 0);
+
+    map.moveSection({{70, 1}, {1, 1}}, {71, 2});
+    CHECK(map.conveyorBeltDirectionInRow(71, 71, 2) == 1);
+  }
+}
+
+
+TEST_CASE("Map keeps track of composite tiles")
+{
+  const auto attributes = TileAttributeDict{{0x0, 0x0F, 0x0}};
+
+  Map map{100, 80, attributes};
+  map.setTileAt(0, 10, 5, 1);
+  map.setTileAt(0, 70, 5, 1);
+  map.setTileAt(1, 70, 5, 2);
+  map.setTileAt(0, 3, 75, 2);
+  map.setTileAt(1, 3, 75, 1);
+
+  CHECK(!map.hasCompositeTileInRow(0, 69, 5));
+  CHECK(map.hasCompositeTileInRow(0, 70, 5));
+  CHECK(map.hasCompositeTileInRow(70, 70, 5));
+  CHECK(!map.hasCompositeTileInRow(0, 99, 6));
+  CHECK(!map.hasCompositeTileInColumn(0, 79, 10));
+  CHECK(map.hasCompositeTileInColumn(0, 79, 70));
+  CHECK(map.hasCompositeTileInColumn(70, 79, 3));
+  CHECK(!map.hasCompositeTileInColumn(0, 74, 3));
+
+  SECTION("Spans partially outside of the map")
+  {
+    CHECK(map.hasCompositeTileInRow(-10, 200, 5));
+    CHECK(!map.hasCompositeTileInRow(0, 99, -1));
+    CHECK(!map.hasCompositeTileInRow(0, 99, 80));
+    CHECK(map.hasCompositeTileInColumn(-5, 100, 3));
+    CHECK(!map.hasCompositeTileInColumn(0, 79, 100));
+  }
+
+  SECTION("After changing tiles")
+  {
+    map.setTileAt(1, 70, 5, 0);
+    CHECK(!map.hasCompositeTileInRow(0, 99, 5));
+
+    map.setTileAt(1, 10, 5, 2);
+    CHECK(map.hasCompositeTileInColumn(0, 79, 10));
+
+    map.clearSection(3, 75, 1, 1);
+    CHECK(!map.hasCompositeTileInColumn(0, 79, 3));
+  }
+}
+
+
+TEST_CASE("Tile attribute dict decodes attribute bit packs")
+{
+  const auto dict = TileAttributeDict{{0x0, 0x0F, 0x30, 0x410, 0x4080, 0x300}};
+
+  CHECK(dict.collisionData(1).isSolidOn(SolidEdge::any()));
+  CHECK(!dict.collisionData(2).isSolidOn(SolidEdge::any()));
+
+  CHECK(dict.animationType(0) == TileAnimationType::None);
+  CHECK(dict.animationType(2) == TileAnimationType::Fast);
+  CHECK(dict.animationType(3) == TileAnimationType::Slow);
+
+  CHECK(!dict.isForeGround(0));
+  CHECK(dict.isForeGround(2));
+
+  CHECK(dict.attributes(4).isLadder());
+  CHECK(dict.attributes(4).isClimbable());
+  CHECK(!dict.attributes(4).isFlammable());
+
+  CHECK(dict.attributes(5).isConveyorBeltLeft());
+  CHECK(dict.attributes(5).isConveyorBeltRight());
+  CHECK(!dict.attributes(1).isConveyorBeltLeft());
+
+  CHECK(dict == TileAttributeDict{{0x0, 0x0F, 0x30, 0x410, 0x4080, 0x300}});
+  CHECK(dict != TileAttributeDict{{0x0, 0x0F, 0x30, 0x010, 0x4080, 0x300}});
+}
@@ -0,0 +1,88 @@
+/* Copyright (C) 2022, Nikolai Wuttke. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <base/memory_accounting.hpp>
+#include <base/warnings.hpp>
+
+RIGEL_DISABLE_WARNINGS
+#include <catch2/catch_test_macros.hpp>
+RIGEL_RESTORE_WARNINGS
+
+#include <utility>
+#include <vector>
+
+
+using namespace rigel;
+using base::MemoryCategory;
+
+
+TEST_CASE("Tracked memory is accounted while alive")
+{
+  const auto baseline = base::trackedBytes(MemoryCategory::QuickSaves);
+
+  {
+    base::TrackedMemory memory{MemoryCategory::QuickSaves, 100};
+    CHECK(base::trackedBytes(MemoryCategory::QuickSaves) == baseline + 100);
+
+    memory.set(40);
+    CHECK(base::trackedBytes(MemoryCategory::QuickSaves) == baseline + 40);
+    CHECK(base::peakTrackedBytes(MemoryCategory::QuickSaves) >= baseline + 100);
+  }
+
+  CHECK(base::trackedBytes(MemoryCategory::QuickSaves) == baseline);
+}
+
+
+TEST_CASE("Copying and moving tracked memory")
+{
+  const auto baseline = base::trackedBytes(MemoryCategory::WorldState);
+
+  base::TrackedMemory original{MemoryCategory::WorldState, 10};
+
+  SECTION("Copies are accounted separately")
+  {
+    const auto copy = original;
+    CHECK(copy.bytes() == 10);
+    CHECK(base::trackedBytes(MemoryCategory::WorldState) == baseline + 20);
+  }
+
+  SECTION("Moving transfers the bytes")
+  {
+    auto moved = std::move(original);
+    CHECK(moved.bytes() == 10);
+    CHECK(original.bytes() == 0);
+    CHECK(base::trackedBytes(MemoryCategory::WorldState) == baseline + 10);
+  }
+
+  SECTION("Move assignment releases the previous bytes")
+  {
+    base::TrackedMemory other{MemoryCategory::WorldState, 5};
+    other = std::move(original);
+    CHECK(other.bytes() == 10);
+    CHECK(base::trackedBytes(MemoryCategory::WorldState) == baseline + 10);
+  }
+
+  SECTION("Works inside containers")
+  {
+    std::vector<base::TrackedMemory> items;
+    for (auto i = 0; i < 10; ++i)
+    {
+      items.emplace_back(MemoryCategory::WorldState, 1);
+    }
+
+    CHECK(base::trackedBytes(MemoryCategory::WorldState) == baseline + 20);
+  }
+}
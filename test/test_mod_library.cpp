@@ -0,0 +1,108 @@
+/* Copyright (C) 2022, Nikolai Wuttke. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <base/warnings.hpp>
+#include <data/mod_library.hpp>
+
+RIGEL_DISABLE_WARNINGS
+#include <catch2/catch_test_macros.hpp>
+RIGEL_RESTORE_WARNINGS
+
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+
+
+using namespace rigel;
+
+namespace fs = std::filesystem;
+
+
+namespace
+{
+
+void addMod(const fs::path& modsPath, const char* name)
+{
+  fs::create_directories(modsPath / name);
+  std::ofstream{modsPath / name / "NUKEM2.F1"} << "x";
+}
+
+
+void touch(const fs::path& path)
+{
+  using namespace std::chrono_literals;
+
+  // Bump the timestamp explicitly, since the file system's timestamp
+  // resolution might be too coarse to register a change otherwise.
+  fs::last_write_time(path, fs::last_write_time(path) + 1h);
+}
+
+} // namespace
+
+
+TEST_CASE("Mod library only rescans when the mods directory changed")
+{
+  const auto gamePath = fs::temp_directory_path() / "rigel_test_mod_library";
+  const auto modsPath = gamePath / data::MODS_PATH;
+  fs::remove_all(gamePath);
+  addMod(modsPath, "first");
+  fs::create_directories(modsPath / "empty");
+
+  auto library = data::ModLibrary{};
+  library.updateGamePath(gamePath);
+
+  REQUIRE(library.currentlyAvailableMods().size() == 1);
+  REQUIRE(library.directoryIndex());
+  CHECK(library.directoryIndex()->mEntries.size() == 2);
+
+  SECTION("Unchanged directory is not scanned again")
+  {
+    CHECK(!library.rescanIfChanged());
+  }
+
+  SECTION("Adding a mod triggers a rescan")
+  {
+    addMod(modsPath, "second");
+    touch(modsPath);
+
+    CHECK(library.rescanIfChanged());
+    CHECK(library.currentlyAvailableMods().size() == 2);
+  }
+
+  SECTION("Populating an empty directory triggers a rescan")
+  {
+    std::ofstream{modsPath / "empty" / "NUKEM2.F2"} << "x";
+    touch(modsPath / "empty");
+
+    CHECK(library.rescanIfChanged());
+    CHECK(library.currentlyAvailableMods().size() == 2);
+  }
+
+  SECTION("Index is reused by a library restored from a profile")
+  {
+    auto restored = data::ModLibrary{
+      {},
+      library.currentlyAvailableMods(),
+      library.currentSelection(),
+      library.directoryIndex()};
+    restored.updateGamePath(gamePath);
+
+    CHECK(!restored.rescanIfChanged());
+    CHECK(restored.enabledModPaths() == library.enabledModPaths());
+  }
+
+  fs::remove_all(gamePath);
+}
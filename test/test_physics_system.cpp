@@ -427,3 +427,188 @@ TEST_CASE("Physics system works as expected")
     }
   }
 }
+
+
+TEST_CASE("Solid bodies are found in all grid cells they cover")
+{
+  ex::EntityX entityx;
+  data::map::Map map{100, 100, data::map::TileAttributeDict{{0x0, 0xF}}};
+  CollisionChecker collisionChecker{&map, entityx.entities, entityx.events};
+  PhysicsSystem physicsSystem{&collisionChecker, &map, &entityx.events};
+
+  // Spans several grid cells horizontally, occupying rows 49 and 50
+  auto solidBody = entityx.entities.create();
+  solidBody.assign<BoundingBox>(BoundingBox{{0, 0}, {40, 2}});
+  solidBody.assign<WorldPosition>(WorldPosition{10, 50});
+  solidBody.assign<SolidBody>();
+
+  const auto runFrames = [&](const int numFrames) {
+    for (auto i = 0; i < numFrames; ++i)
+    {
+      physicsSystem.update(entityx.entities);
+    }
+  };
+
+  const auto spawnFallingObject = [&](const int x) {
+    auto object = entityx.entities.create();
+    object.assign<BoundingBox>(BoundingBox{{0, 0}, {2, 2}});
+    object.assign<MovingBody>(MovingBody{{0.0f, 1.0f}, false});
+    object.assign<WorldPosition>(WorldPosition{x, 40});
+    object.assign<Active>();
+    return object;
+  };
+
+  const auto yPositionOf = [](ex::Entity object) {
+    return object.component<WorldPosition>()->y;
+  };
+
+  SECTION("Body spanning multiple cells")
+  {
+    auto objects = std::vector<ex::Entity>{
+      spawnFallingObject(10),
+      spawnFallingObject(30),
+      spawnFallingObject(46),
+      spawnFallingObject(48)};
+    auto objectBesideBody = spawnFallingObject(60);
+
+    runFrames(20);
+
+    for (auto object : objects)
+    {
+      CHECK(yPositionOf(object) == 48);
+    }
+
+    CHECK(yPositionOf(objectBesideBody) == 60);
+  }
+
+  SECTION("Body moved to different cells in between updates")
+  {
+    runFrames(1);
+    *solidBody.component<WorldPosition>() = WorldPosition{55, 50};
+
+    auto objectAtOldPosition = spawnFallingObject(12);
+    auto objectAtNewPosition = spawnFallingObject(90);
+
+    runFrames(20);
+
+    CHECK(yPositionOf(objectAtOldPosition) == 60);
+    CHECK(yPositionOf(objectAtNewPosition) == 48);
+  }
+
+  SECTION("Body moving across cells on its own")
+  {
+    solidBody.component<BoundingBox>()->size.width = 10;
+    solidBody.assign<MovingBody>(MovingBody{{3.0f, 0.0f}, false});
+    solidBody.assign<Active>();
+
+    runFrames(20);
+    REQUIRE(solidBody.component<WorldPosition>()->x == 70);
+
+    auto objectAtOldPosition = spawnFallingObject(12);
+    auto objectAtNewPosition = spawnFallingObject(74);
+    solidBody.component<MovingBody>()->mVelocity.x = 0.0f;
+
+    runFrames(20);
+
+    CHECK(yPositionOf(objectAtOldPosition) == 60);
+    CHECK(yPositionOf(objectAtNewPosition) == 48);
+  }
+
+  SECTION("Body removed")
+  {
+    runFrames(1);
+    solidBody.remove<SolidBody>();
+
+    auto object = spawnFallingObject(30);
+    runFrames(20);
+
+    CHECK(yPositionOf(object) == 60);
+  }
+}
+
+
+namespace
+{
+
+struct PhysicsTestWorld
+{
+  explicit PhysicsTestWorld(const bool parallelUpdate)
+  {
+    physicsSystem.setParallelUpdateEnabled(parallelUpdate);
+
+    for (int x = 0; x < map.width(); ++x)
+    {
+      map.setTileAt(0, x, 60, 1);
+    }
+
+    for (int y = 40; y < 60; ++y)
+    {
+      map.setTileAt(0, 30, y, 1);
+      map.setTileAt(0, 70, y, 1);
+    }
+
+    auto solidBody = entityx.entities.create();
+    solidBody.assign<BoundingBox>(BoundingBox{{0, 0}, {6, 2}});
+    solidBody.assign<MovingBody>(MovingBody{{1.0f, 0.0f}, false});
+    solidBody.assign<WorldPosition>(WorldPosition{1, 55});
+    solidBody.assign<SolidBody>();
+    solidBody.assign<Active>();
+    bodies.push_back(solidBody);
+
+    // Simple LCG, to get the same "random" layout in both worlds
+    auto seed = 12345u;
+    auto next = [&seed](const int range) {
+      seed = seed * 1103515245u + 12345u;
+      return static_cast<int>((seed >> 16) % range);
+    };
+
+    for (int i = 0; i < 300; ++i)
+    {
+      auto body = entityx.entities.create();
+      body.assign<BoundingBox>(BoundingBox{{0, 0}, {1 + next(3), 1 + next(3)}});
+      body.assign<MovingBody>(MovingBody{
+        {static_cast<float>(next(5) - 2), static_cast<float>(next(3) - 1)},
+        next(4) != 0});
+      body.assign<WorldPosition>(WorldPosition{next(96) + 2, next(58) + 2});
+      body.assign<Active>();
+      bodies.push_back(body);
+    }
+  }
+
+  ex::EntityX entityx;
+  data::map::Map map{100, 100, data::map::TileAttributeDict{{0x0, 0xF}}};
+  CollisionChecker collisionChecker{&map, entityx.entities, entityx.events};
+  PhysicsSystem physicsSystem{&collisionChecker, &map, &entityx.events};
+  std::vector<ex::Entity> bodies;
+};
+
+} // namespace
+
+
+TEST_CASE("Parallel physics update gives same results as serial update")
+{
+  PhysicsTestWorld serialWorld{false};
+  PhysicsTestWorld parallelWorld{true};
+
+  for (int frame = 0; frame < 40; ++frame)
+  {
+    serialWorld.physicsSystem.update(serialWorld.entityx.entities);
+    parallelWorld.physicsSystem.update(parallelWorld.entityx.entities);
+
+    for (auto i = 0u; i < serialWorld.bodies.size(); ++i)
+    {
+      auto serialBody = serialWorld.bodies[i];
+      auto parallelBody = parallelWorld.bodies[i];
+
+      REQUIRE(
+        *serialBody.component<WorldPosition>() ==
+        *parallelBody.component<WorldPosition>());
+      REQUIRE(
+        serialBody.component<MovingBody>()->mVelocity ==
+        parallelBody.component<MovingBody>()->mVelocity);
+      REQUIRE(
+        serialBody.has_component<CollidedWithWorld>() ==
+        parallelBody.has_component<CollidedWithWorld>());
+    }
+  }
+}
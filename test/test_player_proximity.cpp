@@ -0,0 +1,83 @@
+/* Copyright (C) 2022, Nikolai Wuttke. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <base/warnings.hpp>
+#include <game_logic/player_proximity.hpp>
+
+RIGEL_DISABLE_WARNINGS
+#include <catch2/catch_test_macros.hpp>
+RIGEL_RESTORE_WARNINGS
+
+
+using namespace rigel;
+
+using engine::components::BoundingBox;
+using game_logic::PlayerProximity;
+using game_logic::ProximityBand;
+
+
+TEST_CASE("Player proximity bands")
+{
+  // Player hit box covers x 10..12, y 16..20
+  const auto proximity =
+    PlayerProximity{base::Vec2{10, 20}, BoundingBox{{10, 16}, {3, 5}}};
+
+  SECTION("Overlapping boxes are touching")
+  {
+    const auto box = BoundingBox{{12, 20}, {2, 2}};
+    CHECK(proximity.distanceTo(box) == 0);
+    CHECK(proximity.bandFor(box) == ProximityBand::Touching);
+  }
+
+  SECTION("Adjacent boxes have a distance of 0 without touching")
+  {
+    const auto box = BoundingBox{{13, 16}, {2, 2}};
+    CHECK(proximity.distanceTo(box) == 0);
+    CHECK(proximity.bandFor(box) == ProximityBand::Near);
+  }
+
+  SECTION("Distance is the larger of both gaps")
+  {
+    // 3 tiles in between horizontally, 5 vertically
+    const auto box = BoundingBox{{4, 8}, {3, 3}};
+    CHECK(proximity.distanceTo(box) == 5);
+    CHECK(proximity.bandFor(box) == ProximityBand::Near);
+  }
+
+  SECTION("Band boundaries")
+  {
+    auto boxAtHorizontalDistance = [](const int distance) {
+      return BoundingBox{{13 + distance, 18}, {1, 1}};
+    };
+
+    CHECK(
+      proximity.bandFor(
+        boxAtHorizontalDistance(PlayerProximity::NEAR_DISTANCE)) ==
+      ProximityBand::Near);
+    CHECK(
+      proximity.bandFor(
+        boxAtHorizontalDistance(PlayerProximity::NEAR_DISTANCE + 1)) ==
+      ProximityBand::Medium);
+    CHECK(
+      proximity.bandFor(
+        boxAtHorizontalDistance(PlayerProximity::MEDIUM_DISTANCE)) ==
+      ProximityBand::Medium);
+    CHECK(
+      proximity.bandFor(
+        boxAtHorizontalDistance(PlayerProximity::MEDIUM_DISTANCE + 1)) ==
+      ProximityBand::Far);
+  }
+}
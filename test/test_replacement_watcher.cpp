@@ -0,0 +1,103 @@
+/* Copyright (C) 2022, Nikolai Wuttke. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <assets/replacement_watcher.hpp>
+#include <assets/resource_loader.hpp>
+#include <base/warnings.hpp>
+
+RIGEL_DISABLE_WARNINGS
+#include <catch2/catch_test_macros.hpp>
+RIGEL_RESTORE_WARNINGS
+
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+
+
+using namespace rigel;
+
+namespace fs = std::filesystem;
+
+
+TEST_CASE("Replacement watcher reports changed files")
+{
+  using namespace std::chrono_literals;
+
+  const auto directory =
+    fs::temp_directory_path() / "rigel_test_replacement_watcher";
+  fs::remove_all(directory);
+  fs::create_directories(directory);
+  std::ofstream{directory / "sound3.wav"} << "a";
+  std::ofstream{directory / "actor5_frame0.png"} << "a";
+
+  auto watcher = assets::ReplacementWatcher{{directory}};
+
+  SECTION("Nothing reported when unchanged")
+  {
+    CHECK(watcher.poll().empty());
+  }
+
+  SECTION("Modified file")
+  {
+    // The timestamp is bumped explicitly, since the file system's resolution
+    // might be too coarse to register a change otherwise.
+    const auto path = directory / "sound3.wav";
+    std::ofstream{path} << "b";
+    fs::last_write_time(path, fs::last_write_time(path) + 1h);
+
+    const auto changes = watcher.poll();
+    CHECK(!changes.mFileSetChanged);
+    CHECK(changes.mModifiedFiles == std::vector<std::string>{"sound3.wav"});
+    CHECK(watcher.poll().empty());
+  }
+
+  SECTION("Added file")
+  {
+    std::ofstream{directory / "sound4.wav"} << "a";
+    CHECK(watcher.poll().mFileSetChanged);
+  }
+
+  SECTION("Removed file")
+  {
+    fs::remove(directory / "actor5_frame0.png");
+    CHECK(watcher.poll().mFileSetChanged);
+  }
+
+  fs::remove_all(directory);
+}
+
+
+TEST_CASE("Replacement file names are mapped to the assets they replace")
+{
+  using assets::actorForReplacementFile;
+  using assets::isLevelImageReplacementFile;
+  using assets::soundForReplacementFile;
+
+  CHECK(actorForReplacementFile("actor159_frame3.png") == data::ActorID(159));
+  CHECK(actorForReplacementFile("ACTOR7_FRAME0.PNG") == data::ActorID(7));
+  CHECK(
+    actorForReplacementFile("actor159_frame3@2x.png") == data::ActorID(159));
+  CHECK(!actorForReplacementFile("actor159.png"));
+
+  CHECK(soundForReplacementFile("sound1.wav") == data::SoundId(0));
+  CHECK(!soundForReplacementFile("sound0.wav"));
+  CHECK(!soundForReplacementFile("sound999.wav"));
+
+  CHECK(isLevelImageReplacementFile("tileset1.png"));
+  CHECK(isLevelImageReplacementFile("backdrop12.png"));
+  CHECK(isLevelImageReplacementFile("tileset1@4x.png"));
+  CHECK(!isLevelImageReplacementFile("status.png"));
+}
@@ -0,0 +1,78 @@
+/* Copyright (C) 2022, Nikolai Wuttke. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <base/small_vector.hpp>
+#include <base/warnings.hpp>
+
+RIGEL_DISABLE_WARNINGS
+#include <catch2/catch_test_macros.hpp>
+RIGEL_RESTORE_WARNINGS
+
+#include <string>
+
+
+using namespace rigel;
+
+
+TEST_CASE("small_vector stores few elements inline")
+{
+  base::small_vector<std::string, 2> strings;
+
+  CHECK(strings.empty());
+  CHECK(strings.isInline());
+
+  strings.push_back("one");
+  strings.emplace_back("two");
+
+  CHECK(strings.size() == 2);
+  CHECK(strings.isInline());
+  CHECK(strings[0] == "one");
+  CHECK(strings.back() == "two");
+
+  SECTION("Growing beyond the inline capacity moves elements to the heap")
+  {
+    strings.push_back(strings.front());
+
+    CHECK(!strings.isInline());
+    REQUIRE(strings.size() == 3);
+    CHECK(strings[0] == "one");
+    CHECK(strings[1] == "two");
+    CHECK(strings[2] == "one");
+
+    strings.pop_back();
+    strings.push_back("three");
+    CHECK(strings.back() == "three");
+  }
+
+  SECTION("Copies are independent of the original")
+  {
+    auto copy = strings;
+    copy[0] = "changed";
+
+    CHECK(strings[0] == "one");
+    CHECK(copy != strings);
+
+    copy[0] = "one";
+    CHECK(copy == strings);
+  }
+
+  SECTION("Clearing")
+  {
+    strings.clear();
+    CHECK(strings.empty());
+    CHECK(strings.begin() == strings.end());
+  }
+}
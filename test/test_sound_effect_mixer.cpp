@@ -0,0 +1,134 @@
+/* Copyright (C) 2022, Nikolai Wuttke. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <audio/sound_effect_mixer.hpp>
+#include <base/warnings.hpp>
+
+RIGEL_DISABLE_WARNINGS
+#include <catch2/catch_test_macros.hpp>
+RIGEL_RESTORE_WARNINGS
+
+#include <cstdint>
+#include <vector>
+
+
+using namespace rigel;
+
+
+namespace
+{
+
+// Each voice plays a constant value, so the mixed output tells us which
+// voices are audible
+const auto A = std::int16_t{1000};
+const auto B = std::int16_t{100};
+const auto C = std::int16_t{10};
+
+
+// Full volume is slightly below 1.0 in the mixer's fixed point format
+int audible(const std::int16_t value)
+{
+  return (value * 32767) >> 15;
+}
+
+
+std::vector<std::int16_t> mixOnce(audio::SoundEffectMixer& mixer)
+{
+  std::vector<std::int16_t> buffer(4, 0);
+  mixer.mix(buffer.data(), buffer.size());
+  return buffer;
+}
+
+} // namespace
+
+
+TEST_CASE("Sound effect mixer voice management")
+{
+  const auto samplesA = std::vector<std::int16_t>(64, A);
+  const auto samplesB = std::vector<std::int16_t>(64, B);
+  const auto samplesC = std::vector<std::int16_t>(64, C);
+
+  audio::SoundEffectMixer mixer{3, 2};
+
+  SECTION("Voices below the limit are mixed together")
+  {
+    mixer.play(0, samplesA);
+    mixer.play(1, samplesB);
+    CHECK(mixOnce(mixer)[0] == audible(A) + audible(B));
+  }
+
+  SECTION("Lowest priority voice is stolen when at the limit")
+  {
+    mixer.play(0, samplesA, 0);
+    mixer.play(1, samplesB, 2);
+    mixOnce(mixer);
+
+    mixer.play(2, samplesC, 1);
+    CHECK(mixOnce(mixer)[0] == audible(B) + audible(C));
+  }
+
+  SECTION("Oldest voice is stolen among equal priorities")
+  {
+    mixer.play(0, samplesA, 1);
+    mixOnce(mixer);
+    mixer.play(1, samplesB, 1);
+    mixOnce(mixer);
+
+    mixer.play(2, samplesC, 1);
+    CHECK(mixOnce(mixer)[0] == audible(B) + audible(C));
+  }
+
+  SECTION("Sound is dropped if all active voices have higher priority")
+  {
+    mixer.play(0, samplesA, 2);
+    mixer.play(1, samplesB, 2);
+    mixer.play(2, samplesC, 1);
+    CHECK(mixOnce(mixer)[0] == audible(A) + audible(B));
+  }
+
+  SECTION("Restarting a playing voice doesn't steal another one")
+  {
+    mixer.play(0, samplesA);
+    mixer.play(1, samplesB);
+    mixOnce(mixer);
+
+    mixer.play(1, samplesB);
+    CHECK(mixOnce(mixer)[0] == audible(A) + audible(B));
+  }
+
+  SECTION("Repeated play commands before mixing result in a single restart")
+  {
+    mixer.play(0, samplesA);
+    mixOnce(mixer);
+
+    for (auto i = 0; i < 1000; ++i)
+    {
+      mixer.play(1, samplesB);
+    }
+
+    // 1000 commands would overflow the queue, making the stop get dropped
+    mixer.stop(0);
+    CHECK(mixOnce(mixer)[0] == audible(B));
+  }
+
+  SECTION("Playing again after a stop is not de-duplicated")
+  {
+    mixer.play(0, samplesA);
+    mixer.stop(0);
+    mixer.play(0, samplesA);
+    CHECK(mixOnce(mixer)[0] == audible(A));
+  }
+}
@@ -0,0 +1,152 @@
+/* Copyright (C) 2022, Nikolai Wuttke. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <base/warnings.hpp>
+#include <renderer/texture_upload_queue.hpp>
+
+RIGEL_DISABLE_WARNINGS
+#include <catch2/catch_test_macros.hpp>
+RIGEL_RESTORE_WARNINGS
+
+#include <vector>
+
+
+using namespace rigel;
+using renderer::TextureUploadQueue;
+
+
+namespace
+{
+
+data::Image makeImage(const std::size_t width, const std::size_t height)
+{
+  auto pixels = data::PixelBuffer{};
+  for (auto i = std::size_t{0}; i < width * height; ++i)
+  {
+    pixels.push_back(data::Pixel{std::uint8_t(i), 0, 0, 255});
+  }
+
+  return data::Image{std::move(pixels), width, height};
+}
+
+
+constexpr auto BYTES_PER_ROW = std::size_t{4 * 4};
+
+} // namespace
+
+
+TEST_CASE("Texture upload queue splits uploads into strips")
+{
+  TextureUploadQueue queue{BYTES_PER_ROW * 3};
+
+  std::vector<TextureUploadQueue::Strip> strips;
+  const auto record = [&](const TextureUploadQueue::Strip& strip) {
+    strips.push_back(strip);
+  };
+
+  auto readyTextures = std::vector<renderer::TextureId>{};
+  queue.enqueue(1, makeImage(4, 8), [&](const renderer::TextureId texture) {
+    readyTextures.push_back(texture);
+  });
+
+  SECTION("Each frame stays within the budget")
+  {
+    CHECK(queue.process(record) == BYTES_PER_ROW * 3);
+    CHECK(queue.process(record) == BYTES_PER_ROW * 3);
+    CHECK(readyTextures.empty());
+    CHECK(queue.isPending(1));
+
+    CHECK(queue.process(record) == BYTES_PER_ROW * 2);
+    CHECK(readyTextures == std::vector<renderer::TextureId>{1});
+    CHECK(!queue.isPending(1));
+    CHECK(queue.empty());
+
+    REQUIRE(strips.size() == 3);
+    CHECK(strips[0].mFirstRow == 0);
+    CHECK(strips[0].mNumRows == 3);
+    CHECK(strips[1].mFirstRow == 3);
+    CHECK(strips[2].mFirstRow == 6);
+    CHECK(strips[2].mNumRows == 2);
+    CHECK(strips[2].mWidth == 4);
+    CHECK(strips[1].mpPixels->r == 12);
+  }
+
+  SECTION("Leftover budget is used for the next texture")
+  {
+    queue.enqueue(2, makeImage(4, 2));
+
+    queue.process(record);
+    queue.process(record);
+    queue.process(record);
+
+    REQUIRE(strips.size() == 4);
+    CHECK(strips[3].mTexture == 2);
+    CHECK(strips[3].mNumRows == 1);
+    CHECK(readyTextures == std::vector<renderer::TextureId>{1});
+    CHECK(queue.isPending(2));
+
+    queue.process(record);
+    CHECK(queue.empty());
+  }
+
+  SECTION("At least one row is uploaded even with a tiny budget")
+  {
+    queue.setBytesPerFrame(1);
+
+    CHECK(queue.process(record) == BYTES_PER_ROW);
+    REQUIRE(strips.size() == 1);
+    CHECK(strips[0].mNumRows == 1);
+  }
+
+  SECTION("Finishing uploads the remainder immediately")
+  {
+    queue.process(record);
+
+    CHECK(queue.finish(1, record) == BYTES_PER_ROW * 5);
+    CHECK(readyTextures == std::vector<renderer::TextureId>{1});
+    CHECK(queue.empty());
+
+    REQUIRE(strips.size() == 2);
+    CHECK(strips[1].mFirstRow == 3);
+    CHECK(strips[1].mNumRows == 5);
+
+    CHECK(queue.finish(1, record) == 0);
+  }
+
+  SECTION("Cancelled uploads don't invoke their callback")
+  {
+    queue.process(record);
+    queue.cancel(1);
+
+    CHECK(queue.empty());
+    CHECK(queue.process(record) == 0);
+    CHECK(readyTextures.empty());
+  }
+}
+
+
+TEST_CASE("Empty images in texture upload queue complete right away")
+{
+  TextureUploadQueue queue;
+
+  auto ready = false;
+  queue.enqueue(
+    3, data::Image{0, 0}, [&](renderer::TextureId) { ready = true; });
+
+  CHECK(queue.process([](const TextureUploadQueue::Strip&) {}) == 0);
+  CHECK(ready);
+  CHECK(queue.empty());
+}
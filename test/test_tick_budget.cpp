@@ -0,0 +1,51 @@
+/* Copyright (C) 2022, Nikolai Wuttke. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <base/warnings.hpp>
+#include <game_logic_common/tick_budget.hpp>
+
+RIGEL_DISABLE_WARNINGS
+#include <catch2/catch_test_macros.hpp>
+RIGEL_RESTORE_WARNINGS
+
+
+using namespace rigel;
+using game_logic::EffectsDetail;
+using game_logic::TickBudgetController;
+
+
+TEST_CASE("Effects detail stride grows when logic updates are over budget")
+{
+  TickBudgetController controller;
+  CHECK(game_logic::effectsDetailStride(controller.detail()) == 1);
+
+  auto previousStride = 1;
+  for (auto i = 0; i < 1000; ++i)
+  {
+    if (controller.update(30.0f, TickBudgetController::DEFAULT_BUDGET_MS))
+    {
+      const auto stride = game_logic::effectsDetailStride(controller.detail());
+      CHECK(stride > previousStride);
+      previousStride = stride;
+    }
+  }
+
+  CHECK(controller.detail() == EffectsDetail::Minimal);
+  CHECK(game_logic::effectsDetailStride(controller.detail()) == 4);
+
+  controller.reset();
+  CHECK(game_logic::effectsDetailStride(controller.detail()) == 1);
+}
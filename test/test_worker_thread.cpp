@@ -0,0 +1,56 @@
+/* Copyright (C) 2022, Nikolai Wuttke. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <base/warnings.hpp>
+#include <base/worker_thread.hpp>
+
+RIGEL_DISABLE_WARNINGS
+#include <catch2/catch_test_macros.hpp>
+RIGEL_RESTORE_WARNINGS
+
+#include <vector>
+
+
+using namespace rigel;
+
+
+TEST_CASE("Worker thread executes tasks in order")
+{
+  std::vector<int> results;
+
+  {
+    base::WorkerThread worker;
+
+    for (auto i = 0; i < 100; ++i)
+    {
+      worker.submit([&results, i]() { results.push_back(i); });
+    }
+
+    SECTION("Waiting for idle completes all tasks")
+    {
+      worker.waitUntilIdle();
+      CHECK(results.size() == 100);
+    }
+  }
+
+  // Destruction finishes all outstanding tasks
+  REQUIRE(results.size() == 100);
+
+  for (auto i = 0; i < 100; ++i)
+  {
+    CHECK(results[i] == i);
+  }
+}
@@ -0,0 +1,359 @@
+/* Copyright (C) 2022, Nikolai Wuttke. All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Performance regression gate for the game logic. It replays a fixed set of
+// input recordings (see frontend/input_recording.hpp) without graphics or
+// audio, and fails if the average or 99th percentile tick time exceeds the
+// baseline stored for the current platform. Since recordings contain state
+// hashes, it also fails if the game's behavior changed.
+//
+// This needs the original game's data files, which can't be part of the
+// repository. CTest only runs it if RIGEL_TICK_GATE_GAME_PATH and
+// RIGEL_TICK_GATE_RECORDINGS are set when configuring.
+
+#include "assets/resource_loader.hpp"
+#include "base/warnings.hpp"
+#include "frontend/headless_simulation.hpp"
+#include "frontend/input_recording.hpp"
+#include "game_logic_common/igame_world.hpp"
+
+RIGEL_DISABLE_WARNINGS
+#include <lyra/lyra.hpp>
+#include <nlohmann/json.hpp>
+RIGEL_RESTORE_WARNINGS
+
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+
+using namespace rigel;
+
+
+namespace
+{
+
+constexpr auto RECORDING_EXTENSION = ".inputs";
+constexpr auto DEFAULT_TOLERANCE = 1.25;
+
+
+struct TickStatistics
+{
+  double mAverageMs = 0.0;
+  double mP99Ms = 0.0;
+  double mMaxMs = 0.0;
+};
+
+
+std::string platformName()
+{
+#if defined(_WIN32)
+  auto name = std::string{"windows"};
+#elif defined(__APPLE__)
+  auto name = std::string{"macos"};
+#elif defined(__linux__)
+  auto name = std::string{"linux"};
+#else
+  auto name = std::string{"unknown"};
+#endif
+
+#if defined(__x86_64__) || defined(_M_X64)
+  name += "-x86_64";
+#elif defined(__aarch64__) || defined(_M_ARM64)
+  name += "-arm64";
+#else
+  name += "-other";
+#endif
+
+#ifndef NDEBUG
+  // Debug builds are much slower, their numbers can't be compared
+  name += "-debug";
+#endif
+
+  return name;
+}
+
+
+std::vector<std::filesystem::path>
+  findRecordings(const std::filesystem::path& directory)
+{
+  auto paths = std::vector<std::filesystem::path>{};
+  for (const auto& entry : std::filesystem::directory_iterator{directory})
+  {
+    if (
+      entry.is_regular_file() &&
+      entry.path().extension() == RECORDING_EXTENSION)
+    {
+      paths.push_back(entry.path());
+    }
+  }
+
+  std::sort(paths.begin(), paths.end());
+  return paths;
+}
+
+
+TickStatistics computeStatistics(std::vector<double> tickTimesMs)
+{
+  if (tickTimesMs.empty())
+  {
+    return {};
+  }
+
+  const auto p99Index = std::min(
+    tickTimesMs.size() - 1,
+    static_cast<std::size_t>(std::ceil(tickTimesMs.size() * 0.99)) - 1);
+  std::nth_element(
+    tickTimesMs.begin(), tickTimesMs.begin() + p99Index, tickTimesMs.end());
+
+  auto result = TickStatistics{};
+  result.mP99Ms = tickTimesMs[p99Index];
+  result.mMaxMs = *std::max_element(tickTimesMs.begin(), tickTimesMs.end());
+  result.mAverageMs =
+    std::accumulate(tickTimesMs.begin(), tickTimesMs.end(), 0.0) /
+    tickTimesMs.size();
+  return result;
+}
+
+
+nlohmann::json loadBaselines(const std::filesystem::path& path)
+{
+  auto file = std::ifstream(path);
+  if (!file.is_open())
+  {
+    return nlohmann::json::object();
+  }
+
+  return nlohmann::json::parse(file);
+}
+
+
+void saveBaselines(
+  const std::filesystem::path& path,
+  const nlohmann::json& baselines)
+{
+  auto file = std::ofstream(path);
+  if (!file.is_open())
+  {
+    throw std::runtime_error("Cannot open baseline file for writing");
+  }
+
+  file << std::setw(2) << baselines << '\n';
+}
+
+
+/** Replays the recording, and returns the tick times of the fastest run
+ *
+ * Taking the best of several runs filters out noise from other processes,
+ * which would otherwise make the gate flaky. Returns false if the state
+ * diverged from the recording.
+ */
+bool replay(
+  const assets::ResourceLoader& resources,
+  const std::filesystem::path& path,
+  const int numRuns,
+  std::vector<double>& tickTimesMs)
+{
+  const auto recording = loadInputRecording(path);
+
+  if (recording.mStateHashes.empty())
+  {
+    std::cout << "  WARNING: " << path.filename().u8string()
+              << " has no state hashes, behavior is not verified\n";
+  }
+
+  auto bestTimesMs = std::vector<double>{};
+  auto bestTotalMs = 0.0;
+
+  for (auto run = 0; run < numRuns; ++run)
+  {
+    auto simulation = HeadlessSimulation{&resources, recording};
+    auto result = replayInputs(recording, simulation.world(), true);
+
+    if (result.mFirstMismatchingUpdate)
+    {
+      std::cout << "  FAILED: " << path.filename().u8string() << '\n'
+                << result.mMismatchReport << '\n';
+      return false;
+    }
+
+    const auto totalMs = std::accumulate(
+      result.mUpdateTimesMs.begin(), result.mUpdateTimesMs.end(), 0.0);
+    if (run == 0 || totalMs < bestTotalMs)
+    {
+      bestTotalMs = totalMs;
+      bestTimesMs = std::move(result.mUpdateTimesMs);
+    }
+  }
+
+  const auto statistics = computeStatistics(bestTimesMs);
+  std::cout << "  " << std::left << std::setw(28) << path.filename().u8string()
+            << std::right << std::setw(8) << bestTimesMs.size()
+            << " ticks, avg " << statistics.mAverageMs << " ms, p99 "
+            << statistics.mP99Ms << " ms\n";
+
+  tickTimesMs.insert(tickTimesMs.end(), bestTimesMs.begin(), bestTimesMs.end());
+  return true;
+}
+
+
+bool checkAgainstBaseline(
+  const TickStatistics& statistics,
+  const nlohmann::json& baselines,
+  const std::string& platform)
+{
+  const auto& platforms = baselines.value("platforms", nlohmann::json{});
+  if (!platforms.contains(platform))
+  {
+    std::cout << "No baseline for platform " << platform
+              << ", run with --update-baseline to store one\n";
+    return true;
+  }
+
+  const auto& baseline = platforms.at(platform);
+  const auto tolerance = baselines.value("tolerance", DEFAULT_TOLERANCE);
+  const auto maxAverageMs = baseline.at("averageMs").get<double>() * tolerance;
+  const auto maxP99Ms = baseline.at("p99Ms").get<double>() * tolerance;
+
+  std::cout << "Limits for " << platform << ": avg " << maxAverageMs
+            << " ms, p99 " << maxP99Ms << " ms\n";
+
+  auto passed = true;
+  if (statistics.mAverageMs > maxAverageMs)
+  {
+    std::cout << "FAILED: Average tick time above baseline\n";
+    passed = false;
+  }
+
+  if (statistics.mP99Ms > maxP99Ms)
+  {
+    std::cout << "FAILED: 99th percentile tick time above baseline\n";
+    passed = false;
+  }
+
+  return passed;
+}
+
+} // namespace
+
+
+int main(int argc, char** argv)
+{
+  auto showHelp = false;
+  auto updateBaseline = false;
+  auto numRuns = 3;
+  auto gamePath = std::string{};
+  auto recordingsPath = std::string{};
+  auto baselinePath = std::string{};
+
+  // clang-format off
+  auto optionsParser = lyra::help(showHelp)
+    | lyra::opt(baselinePath, "file")["--baseline"]
+      .help("JSON file with per-platform tick time baselines")
+      .required()
+    | lyra::opt(numRuns, "N")["--runs"]
+      .help("Number of times to replay each recording, the best run counts")
+    | lyra::opt(updateBaseline)["--update-baseline"]
+      .help("Store the measured times as baseline for the current platform")
+    | lyra::arg(gamePath, "game path")
+      .help("Path to original game's installation")
+      .required()
+    | lyra::arg(recordingsPath, "recordings")
+      .help("Directory containing the input recordings to replay")
+      .required()
+  ;
+  // clang-format on
+
+  const auto parseResult = optionsParser.parse({argc, argv});
+
+  if (showHelp)
+  {
+    std::cout << optionsParser << '\n';
+    return 0;
+  }
+
+  if (!parseResult || numRuns < 1)
+  {
+    std::cerr << "ERROR: " << parseResult.message() << "\n\n";
+    std::cerr << optionsParser << '\n';
+    return -1;
+  }
+
+  try
+  {
+    const auto recordings =
+      findRecordings(std::filesystem::u8path(recordingsPath));
+    if (recordings.empty())
+    {
+      throw std::runtime_error("No input recordings found");
+    }
+
+    const auto resources =
+      assets::ResourceLoader{std::filesystem::u8path(gamePath), false, {}};
+
+    std::cout << std::fixed << std::setprecision(3);
+    std::cout << "Replaying " << recordings.size() << " recordings\n";
+
+    auto tickTimesMs = std::vector<double>{};
+    auto allMatched = true;
+    for (const auto& path : recordings)
+    {
+      allMatched &= replay(resources, path, numRuns, tickTimesMs);
+    }
+
+    const auto statistics = computeStatistics(tickTimesMs);
+    std::cout << "Overall: " << tickTimesMs.size() << " ticks, avg "
+              << statistics.mAverageMs << " ms, p99 " << statistics.mP99Ms
+              << " ms, max " << statistics.mMaxMs << " ms\n";
+
+    if (!allMatched)
+    {
+      return 1;
+    }
+
+    const auto platform = platformName();
+    const auto baselineFile = std::filesystem::u8path(baselinePath);
+    auto baselines = loadBaselines(baselineFile);
+
+    if (updateBaseline)
+    {
+      baselines["platforms"][platform] = {
+        {"averageMs", statistics.mAverageMs}, {"p99Ms", statistics.mP99Ms}};
+      if (!baselines.contains("tolerance"))
+      {
+        baselines["tolerance"] = DEFAULT_TOLERANCE;
+      }
+
+      saveBaselines(baselineFile, baselines);
+      std::cout << "Stored baseline for " << platform << '\n';
+      return 0;
+    }
+
+    return checkAgainstBaseline(statistics, baselines, platform) ? 0 : 1;
+  }
+  catch (const std::exception& error)
+  {
+    std::cerr << "ERROR: " << error.what() << '\n';
+    return -2;
+  }
+}
@@ -47,10 +47,12 @@ struct MockServiceProvider : public rigel::IGameServiceProvider
   void stopAllSounds() override { }
 
   void playMusic(const std::string&) override { }
+  void prefetchMusic(const std::string&) override { }
   void stopMusic() override { }
   void scheduleGameQuit() override { }
   void switchGamePath(const std::filesystem::path&) override { }
   void markCurrentFrameAsWidescreen() override { }
+  void reportGameLogicTime(rigel::engine::TimeDelta) override { }
   bool isSharewareVersion() const override { return false; }
 
   const CommandLineOptions& commandLineOptions() const override